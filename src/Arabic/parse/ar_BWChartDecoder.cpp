@@ -243,7 +243,7 @@ void BWArabicChartDecoder::transferTheoriesToChart(int start, int end)
 			}
 			
         }else {
-            delete theories[k];
+            theories[k]->release(chartArena);
         }
     }
     chart[start][end - 1][j] = 0;
@@ -252,8 +252,9 @@ void BWArabicChartDecoder::transferTheoriesToChart(int start, int end)
 
 void BWArabicChartDecoder::postProcessChart(){
 	if(DEBUG3) std::cout<<"Postprocess chart !"<<std::endl;
+	int chart_size = static_cast<int>(chart.size());
 	int i;
-    for (i = 0; i < MAX_SENTENCE_LENGTH; i++) {
+    for (i = 0; i < chart_size; i++) {
 		int k = 0;
 		while((k < MAX_TAGS_PER_WORD) && (chart[i][i][k] != 0)){
 			if((chart[i][i][k])&& 
@@ -269,8 +270,8 @@ void BWArabicChartDecoder::postProcessChart(){
 			k++;
 		}
 	}	
-	for(i = 0; i< MAX_SENTENCE_LENGTH; i++){
-		for (int j = i + 1; j < MAX_SENTENCE_LENGTH; j++) {
+	for(i = 0; i< chart_size; i++){
+		for (int j = i + 1; j < chart_size; j++) {
 			int  k =0;
 			while((k < MAX_TAGS_PER_WORD) && (chart[i][j][k] != 0)){
 				if((chart[i][j][k])&& 
@@ -567,7 +568,7 @@ void BWArabicChartDecoder::initChartWord(ArabicParseSeeder::SameSpanParseToken*
 			possiblePunctuationOrConjunction[startIndex] = true;
 		}
 		
-		ChartEntry *entry = _new ChartEntry();
+		ChartEntry *entry = new (chartArena) ChartEntry();
 		entry->nameType = ParserTags::nullSymbol;
 		fillWordEntry(entry, tag, word, originalWord, startIndex, endIndex);
 		//std::cout<<"initChartEntry()- "<<startIndex<<", "<<endIndex<<" "
@@ -582,7 +583,7 @@ void BWArabicChartDecoder::initChartWord(ArabicParseSeeder::SameSpanParseToken*
 			<< originalWord.to_debug_string()
 			<< ", vector -- "
 			<< word.to_debug_string();
-		ChartEntry *entry = _new ChartEntry();
+		ChartEntry *entry = new (chartArena) ChartEntry();
 		entry->nameType = ParserTags::nullSymbol;
 		// don't actually calculate ranking score (that's what the "false" parameter indicates)
 		fillWordEntry(entry, ParserTags::unknownTag, word, 
@@ -634,7 +635,7 @@ void BWArabicChartDecoder::addConstraintEntry(int left, int right,
 			 (!is_unknown_word &&
 			  LanguageSpecificFunctions::isSecondaryNamePOStag(tag, entityType))))
 		{
-			entry = _new ChartEntry();
+			entry = new (chartArena) ChartEntry();
 			entry->nameType = type;
 			fillWordEntry(entry, tag, word, right_text, left, right);
 			//std::cout<<"addConstraintEntry()- "<<left<<", "<<right<<" "
@@ -655,7 +656,7 @@ void BWArabicChartDecoder::addConstraintEntry(int left, int right,
 				(entityType.isIdfDesc() ||
 				 LanguageSpecificFunctions::isPrimaryNamePOStag(tag, entityType)))
 			{
-				entry = _new ChartEntry();
+				entry = new (chartArena) ChartEntry();
 				entry->nameType = type;
 				fillWordEntry(entry, tag, word, right_text, left, right);
 				chart[left][right][index++] = entry;
@@ -666,7 +667,7 @@ void BWArabicChartDecoder::addConstraintEntry(int left, int right,
 	// if no default name word or no primary tags fit the default name word, just add this in,
 	// but be aware that this WILL fragment the parse
 	if (index == 0) {
-		entry = _new ChartEntry();
+		entry = new (chartArena) ChartEntry();
 		entry->nameType = type;
 		fillWordEntry(entry, LanguageSpecificFunctions::getDefaultNamePOStag(entityType), word, 
 			right_text, left, right);
@@ -683,6 +684,14 @@ ParseNode* BWArabicChartDecoder::decode(ArabicParseSeeder::SameSpanParseToken**
 	//TODO: Add too long flat parse!
 	_chartEnd = 0;
 
+	// the chart needs a row for every segment end
+	int n_chart_tokens = 0;
+	for (int m = 0; m < num_seg; m++) {
+		if (init_segments[m]->end >= n_chart_tokens)
+			n_chart_tokens = init_segments[m]->end + 1;
+	}
+	initChartCells(n_chart_tokens);
+
 	bool lastIsPunct = LanguageSpecificFunctions::isSentenceEndingPunctuation(init_segments[num_seg-1]->nvString);
 	Symbol split_sentence[MAX_SENTENCE_LENGTH];
 	//std::cout<<"Decode() num_seg: "<<num_seg<<" num constraints: "<<_numConstraints<<std::endl;
@@ -755,9 +764,9 @@ void BWArabicChartDecoder::cleanupChart(int length)
         for (int j = i; j < length; j++) {
 			int k = 0;
             for (ChartEntry** p = chart[i][j]; *p; p++, k++) {
-				delete *p;
+				(*p)->~ChartEntry();
             }
-			chart[i][j][0] = 0;
         }
     }
+	releaseChart();
 }
@@ -119,6 +119,7 @@ ParseNode* ArabicChartDecoder::decode(SplitTokenSequence* bw_tokens, bool collap
 			"ArabicChartDecoder::Decode()","SplitTokenSequence has too many segments");
 
 	}
+	initChartCells(num_segments);
 	if(bw_tokens ==NULL){
 		std::cerr<<"bw_tokens is NULL"<<std::endl;
 	}
@@ -251,6 +252,7 @@ ParseNode* ArabicChartDecoder::decode(Symbol* sentence, int length,
 		ParseNode* flatParse =  _makeFlatParse(sentence, length, _constraints, _numConstraints);
 		return flatParse;
 	}
+	initChartCells(max_segments);
 	constraints = _constraints;
 	numConstraints = _numConstraints;
 	bool lastIsPunct = LanguageSpecificFunctions::isSentenceEndingPunctuation(sentence[length - 1]);
@@ -515,7 +517,7 @@ int ArabicChartDecoder::initChartWordMultiple(const WordSegment* word,
 					{
 						possiblePunctuationOrConjunction[chart_index+k] = true;
 					}				
-					ChartEntry *entry = _new ChartEntry();
+					ChartEntry *entry = new (chartArena) ChartEntry();
 					entry->nameType = ParserTags::nullSymbol;
 					int start = thisSeg->getStart();
 					int end = thisSeg->getEnd();
@@ -609,7 +611,7 @@ void ArabicChartDecoder::addConstraintEntry(int left_word, int right_word,
 			(!entityType.isRecognized() ||
 			 LanguageSpecificFunctions::isPrimaryNamePOStag(tag, entityType)))
 		{
-			entry = _new ChartEntry();
+			entry = new (chartArena) ChartEntry();
 			entry->nameType = type;
 			fillWordEntry(entry, tag, word, sentence[right_word], left_chart, right_chart);
 			if(DEBUG1){	
@@ -621,7 +623,7 @@ void ArabicChartDecoder::addConstraintEntry(int left_word, int right_word,
 		}
 	}
 	if (index == 0) {
-		ChartEntry *entry = _new ChartEntry();
+		ChartEntry *entry = new (chartArena) ChartEntry();
 		entry->nameType = type;
 		// don't bother calculating real ranking score, as we're making it up
 		fillWordEntry(entry, LanguageSpecificFunctions::getDefaultNamePOStag(entityType), 
@@ -651,7 +653,7 @@ void ArabicChartDecoder::addConstraintEntry(int left_word, int right_word,
 		if (LanguageSpecificFunctions::isSecondaryNamePOStag(tag, entityType) &&
 			index < maxEntriesPerCell)
 		{
-			entry = _new ChartEntry();
+			entry = new (chartArena) ChartEntry();
 			entry->nameType = type;
 			fillWordEntry(entry, tag, word, sentence[right_word], left_chart, right_chart);
 			if(DEBUG1){	
@@ -723,7 +725,7 @@ void ArabicChartDecoder::transferTheoriesToChart(int start, int end)
 			}
 			
         }else {
-            delete theories[k];
+            theories[k]->release(chartArena);
         }
     }
     chart[start][end - 1][j] = 0;
@@ -731,7 +733,8 @@ void ArabicChartDecoder::transferTheoriesToChart(int start, int end)
 
 
 void ArabicChartDecoder::postProcessChart(){
-    for (int i = 0; i < MAX_SENTENCE_LENGTH; i++) {
+	int chart_size = static_cast<int>(chart.size());
+    for (int i = 0; i < chart_size; i++) {
 		int k = 0;
 		while((k < MAX_TAGS_PER_WORD) && (chart[i][i][k] != 0)){
 			if((chart[i][i][k])&& 
@@ -742,8 +745,8 @@ void ArabicChartDecoder::postProcessChart(){
 			k++;
 		}
 	}	
-	for(int i = 0; i< MAX_SENTENCE_LENGTH; i++){
-		for (int j = i + 1; j < MAX_SENTENCE_LENGTH; j++) {
+	for(int i = 0; i< chart_size; i++){
+		for (int j = i + 1; j < chart_size; j++) {
 			int  k =0;
 			while((k < MAX_ENTRIES_PER_CELL) && (chart[i][j][k] != 0)){
 				if((chart[i][j][k])&& 
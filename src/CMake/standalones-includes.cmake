@@ -49,6 +49,7 @@ SET (STANDALONE_PROJECTS
     #PIdFSimulatedActiveLearning
     PIdFTrainer
     PNPChunkTrainer
+    ParserModelCompiler
     PosteriorRegularization
     PPartOfSpeechTrainer
     Preprocessor
@@ -1,12 +1,19 @@
 // Copyright 2009 by BBN Technologies Corp.
 // All Rights Reserved.
 
+#include "Generic/common/leak_detection.h" // This must be the first #include
+
 #include <iostream>
 #include <list>
+#include <map>
 #include <algorithm>
 #include <ctime>
+#include <boost/bind.hpp>
+#include <boost/scoped_ptr.hpp>
 #include "MIClassTable.h"
 #include "NLogN.h"
+#include "Generic/common/UnexpectedInputException.h"
+#include "Generic/common/UTF8InputStream.h"
 
 using namespace std;
 
@@ -15,6 +22,22 @@ int MIClassTable::minClassSize = 100;
 int MIClassTable::maxReclassIters = 20;
 double MIClassTable::minReclassGain = 0;
 
+MIClassTable::MIClassTable() : workers(0) {
+    setNumThreads(1);
+}
+
+MIClassTable::~MIClassTable() {
+    delete workers;
+}
+
+void MIClassTable::setNumThreads(int numThreads) {
+    delete workers;
+    workers = new MIWorkerPool(numThreads);
+    search.score.resize(numThreads);
+    search.best1.resize(numThreads);
+    search.best2.resize(numThreads);
+}
+
 void MIClassTable::clusterMiddleOut(int hN, int fN) {
     sortWords(HISTIDX);
     time_t t;
@@ -137,6 +160,148 @@ void MIClassTable::printBits(int hIdx, const std::string& bitsFile) {
 	out.close();
 }
 
+void MIClassTable::addToExistingBits(int hN,
+                                     const std::string& existingBitsFile,
+                                     const std::string& bitsFile)
+{
+    // Read the existing hierarchy, which has one "word bits" line per
+    // word (the format written by printBits()).
+    vector<pair<wstring, wstring> > entries;
+    map<wstring, wstring> existingBits;
+    boost::scoped_ptr<UTF8InputStream> in_scoped_ptr(
+        UTF8InputStream::build(existingBitsFile.c_str()));
+    UTF8InputStream& in(*in_scoped_ptr);
+    while (!in.eof()) {
+        wstring line;
+        in.getLine(line);
+        if (line.empty()) {
+            continue;
+        }
+        size_t space = line.find_last_of(L' ');
+        if (space == wstring::npos) {
+            throw UnexpectedInputException("MIClassTable::addToExistingBits",
+                "Bad line in bits file: ", existingBitsFile.c_str());
+        }
+        entries.push_back(make_pair(line.substr(0, space),
+                                    line.substr(space + 1)));
+        existingBits[entries.back().first] = entries.back().second;
+    }
+    in.close();
+
+    int numWords = info[HISTIDX].numWords;
+    vector<const wstring*> wordBits(numWords, (const wstring*)0);
+    size_t maxLength = 0;
+    int numNew = 0;
+    for (int w = 0; w < numWords; w++) {
+        map<wstring, wstring>::const_iterator iter =
+            existingBits.find(info[HISTIDX].voc->get(w));
+        if (iter != existingBits.end()) {
+            wordBits[w] = &iter->second;
+            maxLength = max(maxLength, iter->second.length());
+        } else {
+            numNew++;
+        }
+    }
+    if (numNew == numWords) {
+        throw UnexpectedInputException("MIClassTable::addToExistingBits",
+            "No words in the vocabulary appear in ", existingBitsFile.c_str());
+    }
+
+    // The middle classes are the shallowest cut through the existing
+    // hierarchy that has at least hN classes.  Existing words stay in
+    // their class; new words start out in class 0.
+    size_t depth = 0;
+    map<wstring, int> prefixToClass;
+    do {
+        depth++;
+        prefixToClass.clear();
+        for (int w = 0; w < numWords; w++) {
+            if (wordBits[w]) {
+                prefixToClass[wordBits[w]->substr(0, depth)] = 0;
+            }
+        }
+    } while ((static_cast<int>(prefixToClass.size()) < hN) &&
+             (depth < maxLength));
+    int numClasses = 0;
+    vector<const wstring*> classPrefix;
+    for (map<wstring, int>::iterator iter = prefixToClass.begin();
+         iter != prefixToClass.end(); ++iter)
+    {
+        iter->second = numClasses++;
+        classPrefix.push_back(&iter->first);
+    }
+    sortWords(HISTIDX);
+    for (int idx = HISTIDX; idx <= FUTIDX; idx++) {
+        info[idx].maxClass = numClasses;
+        for (int c = 0; c < numClasses; c++) {
+            miClass(idx, c).clear();
+        }
+    }
+    frozenWords.assign(numWords, false);
+    for (int w = 0; w < numWords; w++) {
+        int c = 0;
+        if (wordBits[w]) {
+            c = prefixToClass[wordBits[w]->substr(0, depth)];
+            frozenWords[w] = true;
+        }
+        miClass(HISTIDX, c).addWord(word(HISTIDX, w));
+        miClass(FUTIDX, c).addWord(word(FUTIDX, w));
+    }
+    setupClasses();
+
+    time_t t;
+    time(&t);
+    time(&cur_time);
+    cout << ctime(&t);
+    cout << "Placing " << numNew << " new words in " << numClasses
+         << " classes...";
+    shuffleHFWords(maxReclassIters, minReclassGain);
+    cout << "\b\b\b100%\n";
+
+    // Each new word gets the bits of the existing word in its class that
+    // it would be cheapest to merge with.  If no merge has a usable cost
+    // (e.g., they are all NaN), it gets the prefix shared by its class.
+    UTF8OutputStream out;
+    out.open(bitsFile.c_str());
+    if (out.fail()) {
+        cerr << "can't open out file" << endl;
+        frozenWords.clear();
+        return;
+    }
+    for (size_t i = 0; i < entries.size(); i++) {
+        out << entries[i].first << " " << entries[i].second << "\n";
+    }
+    for (int w = 0; w < numWords; w++) {
+        if (frozenWords[w]) {
+            continue;
+        }
+        int c = info[HISTIDX].wordToClass[w];
+        const list<MIWord*>& wordList = miClass(HISTIDX, c).getWords();
+        double maxChange = -HUGE_VAL;
+        const wstring* bits = 0;
+        for (list<MIWord*>::const_iterator j = wordList.begin();
+             j != wordList.end(); j++)
+        {
+            MIWord& other = **j;
+            if (frozenWords[other.index()]) {
+                double change = other.addMIChange(cWord(HISTIDX, w));
+                if (change > maxChange) {
+                    maxChange = change;
+                    bits = wordBits[other.index()];
+                }
+            }
+        }
+        if (bits == 0) {
+            bits = classPrefix[c];
+        }
+        out << info[HISTIDX].voc->get(w) << " " << *bits << "\n";
+    }
+    out.close();
+    frozenWords.clear();
+    time(&t);
+    cout << ctime(&t);
+}
+
 void MIClassTable::clusterMiddle(int hIdx, int n) {
     int currentWord = 0;
     setupSeedClasses(hIdx, n, currentWord);
@@ -243,18 +408,8 @@ double MIClassTable::reclassMiddle(int hIdx) {
             continue;
         }
         double removeChange = miClass(hIdx, c1).removeMIChange(cWord(hIdx, w));
-        double maxChange = 0;
-        int maxcl = c1;
-        for (int c = 0 ; c < info[hIdx].maxClass; c++) {
-            if (c != c1) {
-                double change = removeChange + 
-                miClass(hIdx, c).addMIChange(cWord(hIdx, w));
-                if (change > maxChange) {
-                    maxChange = change;
-                    maxcl = c;
-                }
-            }
-        }
+        int maxcl;
+        double maxChange = findBestMove(hIdx, w, c1, removeChange, maxcl);
         if (maxcl != c1) {
             gain += maxChange / static_cast<double>(globalTotal);
             miClass(hIdx, c1).removeWord(cWord(hIdx, w));
@@ -274,6 +429,9 @@ double MIClassTable::reclassHFMiddle()
     MICountClass* dClassCount = new MICountClass[numClasses];
     for (int cwi = 0; cwi < numWords; cwi++) {		
         int w = info[HISTIDX].sortedWords[cwi].word;
+        if (!frozenWords.empty() && frozenWords[w]) {
+            continue;
+        }
         int c1 = info[HISTIDX].wordToClass[w];
         if (miClass(HISTIDX, c1).numWords() == 1) {
             continue;	
@@ -299,20 +457,10 @@ double MIClassTable::reclassHFMiddle()
         int wwCount = word(HISTIDX, w).getCount(w);
         double removeChange = computeMIRemoveChange(c1, w, classCount,
                                                     wordAsFutureCount, wwCount);
-        double maxChange = 0;
-        int maxcl = c1;
-        for (int c = 0; c < numClasses; c++) {
-            if (c1 != c) {
-                double moveChange = computeMIMoveChange(c1, c, w, classCount,
-                                                dClassCount, dccLen,
-                                                wordAsFutureCount, wwCount);
-                double change = removeChange + moveChange;
-                if (change > maxChange) {
-                    maxChange = change;
-                    maxcl = c;
-                }
-            }
-        }
+        int maxcl;
+        double maxChange = findBestHFMove(w, c1, classCount, dClassCount,
+                                          dccLen, wordAsFutureCount, wwCount,
+                                          removeChange, maxcl);
         if (maxcl != c1) {
             gain += maxChange / static_cast<double>(globalTotal);
             moveHFWord(w, c1, maxcl);
@@ -646,10 +794,43 @@ void MIClassTable::freeLossCache(int hIdx)
     info[hIdx].lossCacheSize = 0;
 }
 
+// The candidate searches below split the classes between the worker
+// threads, and then combine the threads' results so that the candidate
+// chosen is the one that a single sequential scan would have chosen: the
+// first (lowest-indexed) of the candidates with the best score.  Each
+// candidate's score is computed in exactly the same way whatever the
+// number of threads, so the clustering does not depend on it.
+
 double MIClassTable::selectBestMerge(int hIdx, int& best1, int& best2) {
+    search.hIdx = hIdx;
+    workers->run(boost::bind(&MIClassTable::selectBestMergeInRange, this, _1));
+    double minLoss = HUGE_VAL;
+    for (int t = 0; t < workers->numThreads(); t++) {
+        if (search.best1[t] < 0) {
+            continue;
+        }
+        if ((search.score[t] < minLoss) ||
+            ((search.score[t] == minLoss) &&
+             ((search.best1[t] < best1) ||
+              ((search.best1[t] == best1) && (search.best2[t] < best2)))))
+        {
+            minLoss = search.score[t];
+            best1 = search.best1[t];
+            best2 = search.best2[t];
+        }
+    }
+    return minLoss;
+}
+
+void MIClassTable::selectBestMergeInRange(int t) {
+    // Pairs are divided by their first class, which is interleaved between
+    // the threads since the number of pairs per class is uneven.
+    int hIdx = search.hIdx;
     int maxClass = info[hIdx].maxClass;
     double minLoss = HUGE_VAL;
-    for (int c1 = 0; c1 < maxClass; c1++) {
+    int best1 = -1;
+    int best2 = -1;
+    for (int c1 = t; c1 < maxClass; c1 += workers->numThreads()) {
         if (onFrontier(hIdx, c1)) {
             for (int c2 = c1 + 1 ; c2 < maxClass; c2++) {
                 if (onFrontier(hIdx, c2)) {
@@ -663,14 +844,36 @@ double MIClassTable::selectBestMerge(int hIdx, int& best1, int& best2) {
             }
         }
     }
-    return minLoss;
+    search.score[t] = minLoss;
+    search.best1[t] = best1;
+    search.best2[t] = best2;
 }
 
 double MIClassTable::selectBestSingleMerge(int hIdx, int classToMerge,
                                            int& best) 
 {
+    search.hIdx = hIdx;
+    search.c1 = classToMerge;
+    workers->run(boost::bind(&MIClassTable::selectBestSingleMergeInRange,
+                             this, _1));
+    double minLoss = HUGE_VAL;
+    for (int t = 0; t < workers->numThreads(); t++) {
+        if ((search.best1[t] >= 0) && (search.score[t] < minLoss)) {
+            minLoss = search.score[t];
+            best = search.best1[t];
+        }
+    }
+    return minLoss;
+}
+
+void MIClassTable::selectBestSingleMergeInRange(int t) {
+    int hIdx = search.hIdx;
+    int classToMerge = search.c1;
+    int begin, end;
+    workers->getRange(t, info[hIdx].maxClass, begin, end);
     double minLoss = HUGE_VAL;
-    for (int c1 = 0; c1 < info[hIdx].maxClass; c1++) {
+    int best = -1;
+    for (int c1 = begin; c1 < end; c1++) {
         if (onFrontier(hIdx, c1) && (c1 != classToMerge)) {
             double loss = computeMergeLoss(hIdx, c1, classToMerge);
             if (loss < minLoss)	{
@@ -679,7 +882,96 @@ double MIClassTable::selectBestSingleMerge(int hIdx, int classToMerge,
             }
         }
     }
-    return minLoss;
+    search.score[t] = minLoss;
+    search.best1[t] = best;
+}
+
+double MIClassTable::findBestMove(int hIdx, int w, int c1,
+                                  double removeChange, int& maxcl)
+{
+    search.hIdx = hIdx;
+    search.w = w;
+    search.c1 = c1;
+    search.removeChange = removeChange;
+    workers->run(boost::bind(&MIClassTable::findBestMoveInRange, this, _1));
+    return reduceBestMove(c1, maxcl);
+}
+
+void MIClassTable::findBestMoveInRange(int t) {
+    int hIdx = search.hIdx;
+    int w = search.w;
+    int c1 = search.c1;
+    int begin, end;
+    workers->getRange(t, info[hIdx].maxClass, begin, end);
+    double maxChange = 0;
+    int maxcl = c1;
+    for (int c = begin; c < end; c++) {
+        if (c != c1) {
+            double change = search.removeChange + 
+            miClass(hIdx, c).addMIChange(cWord(hIdx, w));
+            if (change > maxChange) {
+                maxChange = change;
+                maxcl = c;
+            }
+        }
+    }
+    search.score[t] = maxChange;
+    search.best1[t] = maxcl;
+}
+
+double MIClassTable::findBestHFMove(int w, int c1, const int* classCount,
+                                    MICountClass* dClassCount, int dccLen,
+                                    int wordAsFutureCount, int wwCount,
+                                    double removeChange, int& maxcl)
+{
+    search.w = w;
+    search.c1 = c1;
+    search.classCount = classCount;
+    search.dClassCount = dClassCount;
+    search.dccLen = dccLen;
+    search.wordAsFutureCount = wordAsFutureCount;
+    search.wwCount = wwCount;
+    search.removeChange = removeChange;
+    workers->run(boost::bind(&MIClassTable::findBestHFMoveInRange, this, _1));
+    return reduceBestMove(c1, maxcl);
+}
+
+void MIClassTable::findBestHFMoveInRange(int t) {
+    int c1 = search.c1;
+    int begin, end;
+    workers->getRange(t, info[HISTIDX].maxClass, begin, end);
+    double maxChange = 0;
+    int maxcl = c1;
+    for (int c = begin; c < end; c++) {
+        if (c1 != c) {
+            double moveChange = computeMIMoveChange(c1, c, search.w,
+                                            search.classCount,
+                                            search.dClassCount, search.dccLen,
+                                            search.wordAsFutureCount,
+                                            search.wwCount);
+            double change = search.removeChange + moveChange;
+            if (change > maxChange) {
+                maxChange = change;
+                maxcl = c;
+            }
+        }
+    }
+    search.score[t] = maxChange;
+    search.best1[t] = maxcl;
+}
+
+double MIClassTable::reduceBestMove(int c1, int& maxcl) {
+    // The threads' ranges are contiguous and in order, so taking the first
+    // thread with the largest change picks the lowest class index.
+    double maxChange = 0;
+    maxcl = c1;
+    for (int t = 0; t < workers->numThreads(); t++) {
+        if (search.score[t] > maxChange) {
+            maxChange = search.score[t];
+            maxcl = search.best1[t];
+        }
+    }
+    return maxChange;
 }
 
 double MIClassTable::computeMergeLoss(int hIdx, int c1, int c2) {
@@ -10,6 +10,7 @@
 #include "MIWord.h"
 #include "MIClass.h"
 #include "Vocabulary.h"
+#include "MIWorkerPool.h"
 
 struct MICountWord {
     int word;
@@ -44,9 +45,36 @@ private:
     static double minReclassGain;
     int globalTotal;
     MIClassInfo info[2];
+    MIWorkerPool* workers;
+    // Words that reclassHFMiddle() may not move (used when adding words
+    // to an existing hierarchy); empty if every word may move.
+    std::vector<bool> frozenWords;
+    // The arguments and per-thread results of the candidate searches that
+    // are run on the worker pool.  Each thread records the best candidate
+    // in its part of the search in score[t], best1[t] and best2[t].
+    struct CandidateSearch {
+        int hIdx;
+        int w;
+        int c1;
+        const int* classCount;
+        MICountClass* dClassCount;
+        int dccLen;
+        int wordAsFutureCount;
+        int wwCount;
+        double removeChange;
+        std::vector<double> score;
+        std::vector<int> best1;
+        std::vector<int> best2;
+    } search;
 public:
     static const int HISTIDX = 0;
     static const int FUTIDX = 1;
+    MIClassTable();
+    ~MIClassTable();
+    /** Evaluate candidate merges and word moves using numThreads threads.
+      * Ties between candidates are always broken in favor of the lowest
+      * class indices, so the clustering does not depend on numThreads. */
+    void setNumThreads(int numThreads);
     void open(const std::string& vocFile);
 	void open(vector <wstring> elements);
     void loadEvents(const std::string& eventsFile);
@@ -54,6 +82,8 @@ public:
     void clusterMiddleOut(int hN, int fN);
     void clusterHFMiddleOut(int hN, const std::string& bitsFile = "");
     void printBits(int hIdx, const std::string& bitsFile);
+    void addToExistingBits(int hN, const std::string& existingBitsFile,
+                           const std::string& bitsFile);
 private:
     void clusterMiddle(int hIdx, int n);
     void shuffleWords(int maxIterations, double minGain);
@@ -88,6 +118,17 @@ private:
     void freeLossCache(int hIdx);
     double selectBestMerge(int hIdx, int& best1, int& best2);
     double selectBestSingleMerge(int hIdx, int classToMerge, int& best);
+    double findBestMove(int hIdx, int w, int c1, double removeChange,
+                        int& maxcl);
+    double findBestHFMove(int w, int c1, const int* classCount,
+                          MICountClass* dClassCount, int dccLen,
+                          int wordAsFutureCount, int wwCount,
+                          double removeChange, int& maxcl);
+    double reduceBestMove(int c1, int& maxcl);
+    void findBestMoveInRange(int t);
+    void findBestHFMoveInRange(int t);
+    void selectBestMergeInRange(int t);
+    void selectBestSingleMergeInRange(int t);
     double computeMergeLoss(int hIdx, int c1, int c2);
     void mergeInto(int hIdx, int c1, int c2);
     int mergeIntoNew(int hIdx, int c1, int c2);
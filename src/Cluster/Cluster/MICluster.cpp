@@ -25,6 +25,14 @@ void MICluster::doClusters(string bitsFile) {
     t.printBits(MIClassTable::HISTIDX, bitsFile);
 }
 
+void MICluster::addToExistingClusters(string existingBitsFile, string bitsFile) {
+	t.addToExistingBits(NUM_MIDDLE_CLASSES, existingBitsFile, bitsFile);
+}
+
+void MICluster::setNumThreads(int numThreads) {
+	t.setNumThreads(numThreads);
+}
+
 /*
 int main(int argc, char* argv[]) {
     
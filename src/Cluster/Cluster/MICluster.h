@@ -18,6 +18,8 @@ public:
 	
 	void loadVocabulary(vector <wstring> elements);
 	void doClusters(string bitsFile); 
+	void addToExistingClusters(string existingBitsFile, string bitsFile);
+	void setNumThreads(int numThreads);
 	void loadBigram(int hist, int fut, int count);
 
 private:
@@ -0,0 +1,51 @@
+// Copyright (c) 2012 by Raytheon BBN Technologies Corp.
+// All Rights Reserved.
+
+#include "Generic/common/leak_detection.h" // This must be the first #include
+
+#include "MIWorkerPool.h"
+#include <boost/bind.hpp>
+
+MIWorkerPool::MIWorkerPool(int numThreads)
+    : _numThreads(numThreads), _stopping(false),
+      _start(numThreads), _finish(numThreads)
+{
+    for (int t = 1; t < _numThreads; t++) {
+        _threads.create_thread(boost::bind(&MIWorkerPool::work, this, t));
+    }
+}
+
+MIWorkerPool::~MIWorkerPool() {
+    if (_numThreads > 1) {
+        _stopping = true;
+        _start.wait();
+        _threads.join_all();
+    }
+}
+
+void MIWorkerPool::run(const boost::function<void (int)>& task) {
+    if (_numThreads == 1) {
+        task(0);
+        return;
+    }
+    _task = task;
+    _start.wait();
+    _task(0);
+    _finish.wait();
+}
+
+void MIWorkerPool::getRange(int t, int n, int& begin, int& end) const {
+    begin = static_cast<int>((static_cast<long long>(n) * t) / _numThreads);
+    end = static_cast<int>((static_cast<long long>(n) * (t + 1)) / _numThreads);
+}
+
+void MIWorkerPool::work(int t) {
+    while (true) {
+        _start.wait();
+        if (_stopping) {
+            return;
+        }
+        _task(t);
+        _finish.wait();
+    }
+}
@@ -0,0 +1,43 @@
+// Copyright (c) 2012 by Raytheon BBN Technologies Corp.
+// All Rights Reserved.
+
+#ifndef MI_WORKER_POOL_H
+#define MI_WORKER_POOL_H
+
+#include <boost/function.hpp>
+#include <boost/thread.hpp>
+#include <boost/thread/barrier.hpp>
+
+/** A fixed set of threads that MIClassTable uses to evaluate candidate
+  * merges and word moves in parallel.  The threads are started once, and
+  * then wait at a barrier between tasks, so run() is cheap enough to call
+  * once for every word that is reclassified.
+  *
+  * Thread 0 is the calling thread; a pool with one thread simply calls
+  * the task directly. */
+class MIWorkerPool {
+public:
+    MIWorkerPool(int numThreads);
+    ~MIWorkerPool();
+
+    /** Call task(t) for each thread index t in [0, numThreads()), in
+      * parallel, and return once all of the calls have returned. */
+    void run(const boost::function<void (int)>& task);
+
+    inline int numThreads() const {return _numThreads;}
+
+    /** Set [begin, end) to the part of the range [0, n) that thread t
+      * should handle.  The parts are contiguous and in thread order. */
+    void getRange(int t, int n, int& begin, int& end) const;
+
+private:
+    int _numThreads;
+    bool _stopping;
+    boost::function<void (int)> _task;
+    boost::barrier _start;
+    boost::barrier _finish;
+    boost::thread_group _threads;
+    void work(int t);
+};
+
+#endif
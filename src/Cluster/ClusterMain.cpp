@@ -172,6 +172,19 @@ int main(int argc, char **argv) {
 			"Missing Parameter: serif-style-cluster-output");
 		}
 
+		// Number of threads used to evaluate candidate merges and moves.  The
+		// output does not depend on this.
+		int n_threads = ParamReader::getOptionalIntParamWithDefaultValue("cluster_threads", 1);
+		if (n_threads < 1) {
+			throw UnexpectedInputException(
+			"Cluster::Main()",
+			"The cluster-threads parameter must be at least 1.");
+		}
+
+		// If specified, words that already appear in this bits file keep their
+		// bits, and only the new words are clustered.
+		std::string existing_bits_file = ParamReader::getParam("cluster_existing_bits_file");
+
 		boost::scoped_ptr<UTF8InputStream> uis_scoped_ptr(UTF8InputStream::build());
 		UTF8InputStream& uis(*uis_scoped_ptr);
 		char msg[1000];
@@ -332,6 +345,7 @@ int main(int argc, char **argv) {
 		cout << ctime(&cur_time);
 		cout << "Loading bigrams...";
 		MICluster * cluster = _new MICluster();
+		cluster->setNumThreads(n_threads);
 		cluster->loadVocabulary(extractor->getVocabulary());
 		ExtractBigrams::BigramCount * bigramCount = extractor->getBigrams();
 		for (ExtractBigrams::BigramCount::iterator iter = bigramCount->begin(); iter != bigramCount->end(); ++iter)
@@ -345,7 +359,10 @@ int main(int argc, char **argv) {
 		time(&cur_time);
 		cout << ctime(&cur_time);
 		cout << "Clustering...\n";
-		cluster->doClusters(outfile);
+		if (existing_bits_file.empty())
+			cluster->doClusters(outfile);
+		else
+			cluster->addToExistingClusters(existing_bits_file, outfile);
 		delete cluster;
 
 		// delete the tokens file created by the StandaloneTokenizer
@@ -0,0 +1,150 @@
+// Copyright (c) 2012 by Raytheon BBN Technologies Corp.
+// All Rights Reserved.
+//
+// Unit tests for the Brown clustering in Cluster/MICluster.  They check
+// that the bits files do not depend on the number of threads used to
+// evaluate candidate merges and word moves (the cluster-threads parameter).
+// The tests cluster a small synthetic corpus, so they need no parameters.
+
+#include "Generic/common/leak_detection.h" // This must be the first #include
+#include "Generic/common/OutputUtil.h"
+#include "Cluster/MICluster.h"
+
+#include <boost/test/unit_test.hpp>
+#include <boost/filesystem.hpp>
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+	const int N_WORDS = 800;
+	const int N_BIGRAMS = N_WORDS * 60;
+	const int N_THREADS = 4;
+
+	/** Return a pseudo-random number in [0, 1).  This does not use rand(),
+	  * so the corpus is the same on every platform. */
+	double nextRandom(unsigned int &state) {
+		state = state * 1103515245u + 12345u;
+		return ((state >> 8) & 0xFFFFFF) / 16777216.0;
+	}
+
+	/** Load a synthetic corpus of N_WORDS words into the given MICluster.
+	  * Word frequencies are skewed towards the low word numbers, and half
+	  * of the bigrams follow a pattern (by word number modulo 20) so that
+	  * the clustering has some structure to find. */
+	void loadCorpus(MICluster &cluster) {
+		std::vector<std::wstring> vocabulary;
+		for (int i = 0; i < N_WORDS; ++i) {
+			std::wostringstream word;
+			word << L"w" << i;
+			vocabulary.push_back(word.str());
+		}
+		cluster.loadVocabulary(vocabulary);
+
+		unsigned int state = 7;
+		std::map<std::pair<int, int>, int> bigramCounts;
+		for (int i = 0; i < N_BIGRAMS; ++i) {
+			double r = nextRandom(state);
+			int hist = static_cast<int>(N_WORDS * r * r * r);
+			r = nextRandom(state);
+			int fut = static_cast<int>(N_WORDS * r * r * r);
+			if (nextRandom(state) < 0.5)
+				fut = std::min(N_WORDS - 1, (fut / 20) * 20 + (hist + 1) % 20);
+			bigramCounts[std::make_pair(hist, fut)]++;
+		}
+		for (std::map<std::pair<int, int>, int>::const_iterator iter = bigramCounts.begin();
+			 iter != bigramCounts.end(); ++iter)
+		{
+			cluster.loadBigram(iter->first.first, iter->first.second, iter->second);
+		}
+	}
+
+	std::string makeTempFilename() {
+		OutputUtil::NamedTempFile tempFile = OutputUtil::makeNamedTempFile();
+		tempFile.second->close();
+		return tempFile.first;
+	}
+
+	std::string readFile(const std::string &filename) {
+		std::ifstream in(filename.c_str(), std::ios::binary);
+		std::ostringstream contents;
+		contents << in.rdbuf();
+		return contents.str();
+	}
+
+	void removeFiles(const std::string &bitsFile) {
+		boost::filesystem::remove(bitsFile);
+		boost::filesystem::remove(bitsFile + ".middle_classes.txt");
+	}
+
+	/** Cluster the synthetic corpus with the given number of threads, and
+	  * return the name of the bits file.  If existingBitsFile is not empty,
+	  * then add the corpus's words to it instead of clustering from scratch. */
+	std::string runCluster(int n_threads, const std::string &existingBitsFile = "") {
+		std::string bitsFile = makeTempFilename();
+		MICluster cluster;
+		cluster.setNumThreads(n_threads);
+		loadCorpus(cluster);
+		if (existingBitsFile.empty())
+			cluster.doClusters(bitsFile);
+		else
+			cluster.addToExistingClusters(existingBitsFile, bitsFile);
+		return bitsFile;
+	}
+
+	size_t countLines(const std::string &text) {
+		return std::count(text.begin(), text.end(), '\n');
+	}
+}
+
+void cluster_threads_give_identical_bits() {
+	std::string sequentialBits = runCluster(1);
+	std::string parallelBits = runCluster(N_THREADS);
+	std::string sequential = readFile(sequentialBits);
+	BOOST_CHECK_EQUAL(countLines(sequential), static_cast<size_t>(N_WORDS));
+	BOOST_CHECK_MESSAGE(sequential == readFile(parallelBits),
+		"The bits file with " << N_THREADS << " threads differs from the bits file with 1 thread");
+	BOOST_CHECK_MESSAGE(readFile(sequentialBits + ".middle_classes.txt") ==
+		readFile(parallelBits + ".middle_classes.txt"),
+		"The middle classes with " << N_THREADS << " threads differ from the middle classes with 1 thread");
+	removeFiles(sequentialBits);
+	removeFiles(parallelBits);
+}
+
+void cluster_add_to_existing_threads_give_identical_bits() {
+	// Use the bits of the first three quarters of the bits file as the
+	// existing clusters, so the remaining words are new.
+	std::string fullBits = runCluster(1);
+	std::string existingBits = makeTempFilename();
+	{
+		std::ifstream in(fullBits.c_str(), std::ios::binary);
+		std::ofstream out(existingBits.c_str(), std::ios::binary);
+		std::string line;
+		for (int i = 0; i < N_WORDS * 3 / 4 && std::getline(in, line); ++i)
+			out << line << "\n";
+	}
+
+	std::string sequentialBits = runCluster(1, existingBits);
+	std::string parallelBits = runCluster(N_THREADS, existingBits);
+	std::string sequential = readFile(sequentialBits);
+	BOOST_CHECK_EQUAL(countLines(sequential), static_cast<size_t>(N_WORDS));
+	BOOST_CHECK_EQUAL(sequential.compare(0, readFile(existingBits).size(), readFile(existingBits)), 0);
+	BOOST_CHECK_MESSAGE(sequential == readFile(parallelBits),
+		"The bits file with " << N_THREADS << " threads differs from the bits file with 1 thread");
+	removeFiles(fullBits);
+	boost::filesystem::remove(existingBits);
+	boost::filesystem::remove(sequentialBits);
+	boost::filesystem::remove(parallelBits);
+}
+
+boost::unit_test::test_suite* init_unit_test_suite(int argc, char* argv[]) {
+	boost::unit_test::test_suite* ts = BOOST_TEST_SUITE("Brown Clustering");
+	ts->add(BOOST_TEST_CASE(&cluster_threads_give_identical_bits));
+	ts->add(BOOST_TEST_CASE(&cluster_add_to_existing_threads_give_identical_bits));
+	return ts;
+}
@@ -8,6 +8,7 @@
 #include "Generic/common/HeapChecker.h"
 #include "Generic/common/FileSessionLogger.h"
 #include "Generic/edt/discmodel/DTCorefTrainer.h"
+#include "LBFGS-B/MaxEntLBFGSOptimizer.h"
 #include "Generic/common/FeatureModule.h" 
 
 using namespace std;
@@ -23,6 +24,7 @@ int main(int argc, char **argv) {
 
 	try {
 		ParamReader::readParamFile(argv[1]);
+		MaxEntModel::setGradientOptimizer(boost::shared_ptr<MaxEntGradientOptimizer>(_new MaxEntLBFGSOptimizer()));
 		FeatureModule::load();
 
 		std::string log_file = ParamReader::getRequiredParam("trainer_log_file");
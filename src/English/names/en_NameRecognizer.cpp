@@ -307,6 +307,11 @@ void EnglishNameRecognizer::resetForNewDocument(DocTheory *docTheory) {
 	}
 }
 
+void EnglishNameRecognizer::releaseSentenceCaches() {
+	if (_name_finder == PIDF_NAME_FINDER)
+		_pidfDecoder->releaseObservations();
+}
+
 void EnglishNameRecognizer::setAuthorNameList(){
 	std::vector<Zone*> zones=_docTheory->getDocument()->getZoning()->getRoots();
 	for(unsigned int i=0;i<zones.size();i++){
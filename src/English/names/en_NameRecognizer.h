@@ -35,6 +35,7 @@ public:
 
 	virtual void cleanUpAfterDocument();
 	virtual void resetForNewDocument(DocTheory *docTheory = 0);
+	virtual void releaseSentenceCaches();
 
 	// This puts an array of pointers to NameTheorys
 	// where specified by results arg, and returns its size. It returns
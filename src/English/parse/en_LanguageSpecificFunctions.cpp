@@ -13,6 +13,7 @@
 #include "Generic/common/SymbolUtilities.h"
 #include "Generic/WordClustering/WordClusterTable.h"
 */
+#include <boost/thread/once.hpp>
 
 bool EnglishLanguageSpecificFunctions::_standAloneParser = false;
 
@@ -82,21 +83,24 @@ void EnglishLanguageSpecificFunctions::_fixNameCommaNameHeads(SynNode* node, Syn
 	node->setHeadIndex(head_index);
 }
 
-SymbolHash * EnglishLanguageSpecificFunctions::_legalNominalAdjectives;
+SymbolHash * EnglishLanguageSpecificFunctions::_legalNominalAdjectives = 0;
+
+namespace {
+	// The parser may run in several threads at once (see
+	// SentenceDriver::isParallelStage()), so the table is loaded only once.
+	boost::once_flag legalNominalAdjectivesLoaded = BOOST_ONCE_INIT;
+}
+
+void EnglishLanguageSpecificFunctions::_loadLegalNominalAdjectives() {
+	std::string adjectives = ParamReader::getParam("legal_nominal_adjectives");
+	if (!adjectives.empty())
+		_legalNominalAdjectives = _new SymbolHash(adjectives.c_str());
+}
+
 void EnglishLanguageSpecificFunctions::_fixLegalNominalAdjectives(ParseNode* node) {
-	static int init = 0;
-	if (init < 0)
+	boost::call_once(legalNominalAdjectivesLoaded, &_loadLegalNominalAdjectives);
+	if (_legalNominalAdjectives == 0)
 		return;
-	if (init == 0) {
-		std::string adjectives = ParamReader::getParam("legal_nominal_adjectives");
-		if (!adjectives.empty()) {
-			_legalNominalAdjectives = _new SymbolHash(adjectives.c_str());
-			init = 1;
-		} else {
-			_legalNominalAdjectives = _new SymbolHash(5);
-			init = -1;
-		}
-	}
 
 	if (node->label != EnglishSTags::NP &&
 		node->label != EnglishSTags::NPA)
@@ -314,6 +314,7 @@ private:
 	static void _fixNameCommaNameHeads(SynNode* node, SynNode* children[], 
 		int& n_children, int& head_index);
 	static SymbolHash * _legalNominalAdjectives;
+	static void _loadLegalNominalAdjectives();
 	static void _fixLegalNominalAdjectives(ParseNode* node);
 	static void _fixNPPOS(ParseNode* node);
 	static void _fixNPPOS(SynNode* node, CorefItem* coref, SynNode *children[], 
@@ -5,8 +5,11 @@
 
 #include "English/relations/en_ComboRelationFinder.h"
 #include "Generic/theories/PropositionSet.h"
+#include "Generic/theories/Proposition.h"
+#include "Generic/theories/Argument.h"
 #include "Generic/theories/RelMentionSet.h"
 #include "Generic/relations/RelationTypeSet.h"
+#include "Generic/relations/RelationUtilities.h"
 #include "English/relations/en_SpecialRelationCases.h"
 #include "Generic/theories/RelMention.h"
 #include "Generic/theories/MentionSet.h"
@@ -16,6 +19,7 @@
 #include "English/common/en_WordConstants.h"
 #include "Generic/common/SymbolHash.h"
 #include "Generic/common/InternalInconsistencyException.h"
+#include "Generic/common/SessionLogger.h"
 #include "Generic/wordnet/xx_WordNet.h"
 
 #include "Generic/discTagger/P1Decoder.h"
@@ -31,13 +35,17 @@
 
 #include <boost/algorithm/string.hpp>
 #include <boost/scoped_ptr.hpp>
+#include <algorithm>
+#include <cstdlib>
 
 UTF8OutputStream EnglishComboRelationFinder::_debugStream;
 bool EnglishComboRelationFinder::DEBUG = false;
 
 Symbol EnglishComboRelationFinder::NO_RELATION_SYM = Symbol(L"NO_RELATION");
 
-EnglishComboRelationFinder::EnglishComboRelationFinder() : _allow_mention_set_changes(false), _skip_special_case_answer(false) {
+EnglishComboRelationFinder::EnglishComboRelationFinder() : _allow_mention_set_changes(false), _skip_special_case_answer(false),
+	_n_candidate_pairs(0), _n_prop_linked_pairs(0), _n_pruned_by_distance(0), _n_pruned_by_path(0), _n_pruned_by_entity_type(0)
+{
 
 	_use_correct_answers = ParamReader::isParamTrue("use_correct_answers");
 
@@ -128,6 +136,10 @@ EnglishComboRelationFinder::EnglishComboRelationFinder() : _allow_mention_set_ch
 
 	_skip_special_case_answer = ParamReader::getOptionalTrueFalseParamWithDefaultVal("relation_skip_special_case_answer", false);
 
+	_max_pair_token_distance = ParamReader::getOptionalIntParamWithDefaultValue("relation_pair_max_token_distance", 0);
+	_max_pair_path_length = ParamReader::getOptionalIntParamWithDefaultValue("relation_pair_max_path_length", 0);
+	_prune_pairs_by_entity_type = ParamReader::getOptionalTrueFalseParamWithDefaultVal("relation_pair_prune_by_entity_type", false);
+
 }
 
 EnglishComboRelationFinder::~EnglishComboRelationFinder() {
@@ -174,6 +186,115 @@ EnglishComboRelationFinder::~EnglishComboRelationFinder() {
 void EnglishComboRelationFinder::cleanup() {
 	delete _observation;
 	_observation = 0;
+	if (_n_candidate_pairs > 0) {
+		SessionLogger::dbg("relation_pair_pruning") << "Relation candidate pairs: " << _n_candidate_pairs
+			<< "; linked by a proposition (not pruned): " << _n_prop_linked_pairs
+			<< "; pruned by token distance: " << _n_pruned_by_distance
+			<< "; by path length: " << _n_pruned_by_path
+			<< "; by entity type: " << _n_pruned_by_entity_type;
+	}
+	_n_candidate_pairs = _n_prop_linked_pairs = 0;
+	_n_pruned_by_distance = _n_pruned_by_path = _n_pruned_by_entity_type = 0;
+}
+
+void EnglishComboRelationFinder::findCandidateMentions(const MentionSet *mentionSet) {
+	int nmentions = mentionSet->getNMentions();
+	_candidateMentions.resize(nmentions);
+	for (int i = 0; i < nmentions; i++) {
+		const Mention* mention = mentionSet->getMention(i);
+		CandidateMention &candidate = _candidateMentions[i];
+		candidate.candidate = (mention->getMentionType() != Mention::NONE &&
+							   mention->getMentionType() != Mention::APPO &&
+							   mention->getMentionType() != Mention::LIST);
+		candidate.recognized = mention->isOfRecognizedType();
+		candidate.head_token = mention->getNode()->getHeadPreterm()->getEndToken();
+		candidate.path.clear();
+		if (_max_pair_path_length > 0) {
+			for (const SynNode *node = mention->getNode(); node != 0; node = node->getParent())
+				candidate.path.push_back(node);
+			std::reverse(candidate.path.begin(), candidate.path.end());
+		}
+	}
+}
+
+bool EnglishComboRelationFinder::pruningEnabled() const {
+	return (_max_pair_token_distance > 0 || _max_pair_path_length > 0 || _prune_pairs_by_entity_type);
+}
+
+void EnglishComboRelationFinder::findPropLinkedPairs(const PropositionSet *propSet) {
+	// This finds every pair that RelationObservation::findPropLink() could
+	// link (and possibly a few more): the mention arguments of each
+	// proposition, with set arguments expanded to their members.
+	_propLinkedPairs.clear();
+	std::vector<int> args;
+	for (int p = 0; p < propSet->getNPropositions(); p++) {
+		const Proposition *prop = propSet->getProposition(p);
+		args.clear();
+		for (int a = 0; a < prop->getNArgs(); a++) {
+			const Argument *arg = prop->getArg(a);
+			if (arg->getType() != Argument::MENTION_ARG)
+				continue;
+			args.push_back(arg->getMentionIndex());
+			const Proposition *set = propSet->getDefinition(arg->getMentionIndex());
+			if (set != 0 && set != prop && set->getPredType() == Proposition::SET_PRED) {
+				for (int k = 1; k < set->getNArgs(); k++) {
+					if (set->getArg(k)->getType() == Argument::MENTION_ARG)
+						args.push_back(set->getArg(k)->getMentionIndex());
+				}
+			}
+		}
+		for (size_t i = 0; i < args.size(); i++) {
+			for (size_t j = i + 1; j < args.size(); j++) {
+				if (args[i] != args[j])
+					_propLinkedPairs.insert(std::make_pair(std::min(args[i], args[j]), std::max(args[i], args[j])));
+			}
+		}
+	}
+}
+
+bool EnglishComboRelationFinder::prunePair(const Mention *mention1, const Mention *mention2, int i, int j) {
+	const CandidateMention &candidate1 = _candidateMentions[i];
+	const CandidateMention &candidate2 = _candidateMentions[j];
+	if (_max_pair_token_distance > 0 &&
+		abs(candidate1.head_token - candidate2.head_token) > _max_pair_token_distance)
+	{
+		++_n_pruned_by_distance;
+		return true;
+	}
+	if (_max_pair_path_length > 0) {
+		size_t common = 0;
+		while (common < candidate1.path.size() && common < candidate2.path.size() &&
+			   candidate1.path[common] == candidate2.path[common])
+			++common;
+		size_t path_length = (candidate1.path.size() - common) + (candidate2.path.size() - common);
+		if (path_length > static_cast<size_t>(_max_pair_path_length)) {
+			++_n_pruned_by_path;
+			return true;
+		}
+	}
+	if (_prune_pairs_by_entity_type && !entityTypesAreCompatible(mention1, mention2)) {
+		++_n_pruned_by_entity_type;
+		return true;
+	}
+	return false;
+}
+
+bool EnglishComboRelationFinder::entityTypesAreCompatible(const Mention *mention1, const Mention *mention2) {
+	// The validity checks only depend on the mentions' entity types, so we
+	// cache their results.
+	std::pair<Symbol, Symbol> types(mention1->getEntityType().getName(), mention2->getEntityType().getName());
+	std::map<std::pair<Symbol, Symbol>, bool>::const_iterator it = _compatibleEntityTypes.find(types);
+	if (it != _compatibleEntityTypes.end())
+		return it->second;
+	Symbol validation_type = _observation->getValidationType();
+	bool compatible = false;
+	for (int t = 1; t < RelationTypeSet::N_RELATION_TYPES && !compatible; t++) {
+		Symbol relType = RelationTypeSet::getRelationSymbol(t);
+		compatible = (RelationUtilities::get()->isValidRelationEntityTypeCombo(validation_type, mention1, mention2, relType) ||
+					  RelationUtilities::get()->isValidRelationEntityTypeCombo(validation_type, mention2, mention1, relType));
+	}
+	_compatibleEntityTypes[types] = compatible;
+	return compatible;
 }
 
 void EnglishComboRelationFinder::resetForNewSentence() {
@@ -224,33 +345,44 @@ RelMentionSet *EnglishComboRelationFinder::getRelationTheory(EntitySet *entitySe
 	_observation->resetForNewSentence(entitySet, parse, mentionSet, valueMentionSet, propSet, 0, 0, ptLinks);
 
 	int nmentions = mentionSet->getNMentions();
+	findCandidateMentions(mentionSet);
+	bool prune_pairs = pruningEnabled();
+	if (prune_pairs)
+		findPropLinkedPairs(propSet);
 
 	for (int i = 0; i < nmentions; i++) {
 		const Mention* mention1 = mentionSet->getMention(i);
-		if (mention1->getMentionType() == Mention::NONE ||
-			mention1->getMentionType() == Mention::APPO ||
-			mention1->getMentionType() == Mention::LIST)
+		if (!_candidateMentions[i].candidate)
 			continue;
 		for (int j = i + 1; j < nmentions; j++) {
 			const Mention* mention2 = mentionSet->getMention(j);
-			if (mention2->getMentionType() == Mention::NONE ||
-				mention2->getMentionType() == Mention::APPO ||
-				mention2->getMentionType() == Mention::LIST)
+			if (!_candidateMentions[j].candidate)
 				continue;
-			_observation->populate(i, j);
 
 			// this means we're doing sentence-level relation finding
 			// currently the only implemented use of this is to find mention set changes
 			if (_allow_mention_set_changes) {
+				_observation->populate(i, j);
 				findMentionSetChanges(mentionSet);
 				continue;
 			}			
-			if (!mention1->isOfRecognizedType() ||
-				!mention2->isOfRecognizedType())
+			if (!_candidateMentions[i].recognized ||
+				!_candidateMentions[j].recognized)
 			{
 				continue;
 			}
 
+			++_n_candidate_pairs;
+			if (prune_pairs) {
+				// Pairs that findSpecialCaseRelation() might fire on are
+				// never pruned.
+				if (_propLinkedPairs.find(std::make_pair(i, j)) != _propLinkedPairs.end())
+					++_n_prop_linked_pairs;
+				else if (prunePair(mention1, mention2, i, j))
+					continue;
+			}
+			_observation->populate(i, j);
+
 			if (DEBUG) {
 				debugDescribeMention(L"LHS", mention1, sentTheory, _debugStream);
 				debugDescribeMention(L"RHS", mention2, sentTheory, _debugStream);
@@ -7,6 +7,10 @@
 #include "Generic/common/limits.h"
 #include "Generic/common/Symbol.h"
 #include "Generic/common/UTF8OutputStream.h"
+#include <map>
+#include <set>
+#include <utility>
+#include <vector>
 
 class Parse;
 class Mention;
@@ -28,6 +32,7 @@ class PotentialRelationInstance;
 class SymbolHash;
 class PropTreeLinks;
 class SentenceTheory;
+class SynNode;
 #include "Generic/discTagger/DTFeature.h"
 
 class EnglishComboRelationFinder {
@@ -103,6 +108,48 @@ private:
 									Symbol answer, RelationObservation *obs);
 
 	bool _use_correct_answers;
+
+	// Candidate pair pruning.  Before a mention pair is scored, it can be
+	// pruned if the token distance between the mentions' heads or the
+	// length of the parse tree path between them is over a limit, or if
+	// no relation type is valid for their entity types (according to
+	// relation_validation_str).  These are set by the
+	// relation_pair_max_token_distance, relation_pair_max_path_length and
+	// relation_pair_prune_by_entity_type parameters; 0 means no limit.
+	// Pairs whose mentions are both arguments of one proposition (or
+	// members of a set that is its argument) are never pruned, since
+	// findSpecialCaseRelation() may assign them a relation no matter how
+	// the models score them.
+	int _max_pair_token_distance;
+	int _max_pair_path_length;
+	bool _prune_pairs_by_entity_type;
+
+	/** Information about a mention that is used for every pair it is in. */
+	struct CandidateMention {
+		bool candidate; // false for NONE, APPO, and LIST mentions
+		bool recognized;
+		int head_token;
+		std::vector<const SynNode*> path; // from the root down to the mention's node
+	};
+	std::vector<CandidateMention> _candidateMentions;
+	void findCandidateMentions(const MentionSet *mentionSet);
+	bool prunePair(const Mention *mention1, const Mention *mention2, int i, int j);
+	bool pruningEnabled() const;
+
+	std::set<std::pair<int, int> > _propLinkedPairs; // (i, j) with i < j
+	void findPropLinkedPairs(const PropositionSet *propSet);
+
+	std::map<std::pair<Symbol, Symbol>, bool> _compatibleEntityTypes;
+	bool entityTypesAreCompatible(const Mention *mention1, const Mention *mention2);
+
+	// Counts of the pairs that were considered, that were exempt from
+	// pruning because a proposition links them, and that were pruned by
+	// each of the tests above (since the last cleanup()).
+	size_t _n_candidate_pairs;
+	size_t _n_prop_linked_pairs;
+	size_t _n_pruned_by_distance;
+	size_t _n_pruned_by_path;
+	size_t _n_pruned_by_entity_type;
 };
 
 
@@ -214,6 +214,14 @@ void EnglishValueRecognizer::resetForNewDocument(DocTheory *docTheory) {
 	_docTheory = docTheory;
 }
 
+void EnglishValueRecognizer::releaseSentenceCaches() {
+	if (!DO_VALUES || _value_finder == IDF_VALUE_FINDER) return;
+	for (int i = 0; i < N_DECODERS; i++) {
+		if (_valuesDecoders[i])
+			_valuesDecoders[i]->releaseObservations();
+	}
+}
+
 int EnglishValueRecognizer::getValueTheories(ValueMentionSet **results, int max_theories, 
 									  TokenSequence *tokenSequence)
 {
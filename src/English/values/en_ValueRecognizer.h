@@ -25,6 +25,7 @@ public:
 	~EnglishValueRecognizer();
 	virtual void resetForNewSentence() {}
 	virtual void resetForNewDocument(DocTheory *docTheory = 0);
+	virtual void releaseSentenceCaches();
 
 	// This puts an array of pointers to ValueMentionSets
 	// where specified by results arg, and returns its size. It returns
@@ -0,0 +1,166 @@
+#include "Generic/actors/ActorNameIndex.h"
+#include "Generic/actors/ActorPattern.h"
+#include "Generic/common/GenericTimer.h"
+#include "Generic/xdoc/EditDistance.h"
+
+#pragma warning(push)
+#pragma warning(disable : 4266)
+#include <boost/test/unit_test.hpp>
+#pragma warning(pop)
+
+#include <cstdlib>
+#include <map>
+#include <string>
+#include <vector>
+
+/** Tests for ActorNameIndex, which ActorEditDistance uses to find the actor
+  * patterns that are close to a name.
+  *
+  * actor_name_index_matches_linear_scan checks that the actors found by
+  * comparing a name with the index's candidates are exactly the actors
+  * found by comparing it with every pattern, for a range of thresholds.
+  *
+  * actor_name_index_benchmark reports the number of edit-distance
+  * comparisons and the time that each approach takes for a synthetic
+  * database of 200,000 patterns. */
+struct ActorNameIndexFixture {
+	typedef std::map<int, float> ScoreMap;
+
+	std::vector<ActorPattern *> patterns;
+	EditDistance editDistance;
+
+	~ActorNameIndexFixture() {
+		for (size_t i = 0; i < patterns.size(); ++i)
+			delete patterns[i];
+	}
+
+	static std::wstring makeName() {
+		static const wchar_t *syllables[] = {L"al", L"ba", L"ch", L"de", L"el", L"fa", L"gi",
+			L"ha", L"in", L"jo", L"ka", L"li", L"mo", L"na", L"or", L"pa", L"qu", L"ra",
+			L"si", L"ta", L"um", L"vi", L"wa", L"xe", L"ya", L"zo"};
+		std::wstring name;
+		int n_words = 1 + rand() % 3;
+		for (int w = 0; w < n_words; ++w) {
+			if (w > 0)
+				name += L" ";
+			int n_syllables = 1 + rand() % 4;
+			for (int s = 0; s < n_syllables; ++s)
+				name += syllables[rand() % (sizeof(syllables)/sizeof(syllables[0]))];
+		}
+		return name;
+	}
+
+	/** Return a copy of name with a few random edits. */
+	static std::wstring perturb(const std::wstring &name) {
+		std::wstring result = name;
+		int n_edits = rand() % 3;
+		for (int e = 0; e < n_edits && !result.empty(); ++e) {
+			size_t pos = rand() % result.size();
+			switch (rand() % 3) {
+				case 0: result[pos] = static_cast<wchar_t>(L'a' + rand() % 26); break;
+				case 1: result.insert(pos, 1, static_cast<wchar_t>(L'a' + rand() % 26)); break;
+				default: result.erase(pos, 1); break;
+			}
+		}
+		return result;
+	}
+
+	void makePatterns(size_t n_patterns, unsigned seed) {
+		srand(seed);
+		for (size_t i = 0; i < n_patterns; ++i) {
+			ActorPattern *ap = _new ActorPattern();
+			ap->actor_id = ActorId(static_cast<int>(i / 2));
+			ap->lcString = makeName();
+			ap->acronym = false;
+			ap->requires_context = false;
+			ap->confidence = 1.0;
+			patterns.push_back(ap);
+		}
+	}
+
+	/** Add the actors among the given patterns whose similarity to name
+	  * meets the threshold to scores, using the same tests as
+	  * ActorEditDistance::findCloseActors(). */
+	size_t scorePatterns(const std::wstring &name, double threshold, const std::vector<ActorPattern *> &toScore, ScoreMap &scores) {
+		size_t name_len = name.length();
+		size_t n_comparisons = 0;
+		for (size_t i = 0; i < toScore.size(); ++i) {
+			size_t pat_len = toScore[i]->lcString.length();
+			if ((float)name_len / pat_len < threshold || (float)pat_len / name_len < threshold)
+				continue;
+			++n_comparisons;
+			float similarity = editDistance.similarity(name, toScore[i]->lcString);
+			if (similarity < threshold)
+				continue;
+			int actor_id = toScore[i]->actor_id.getId();
+			if (scores.find(actor_id) == scores.end() || similarity > scores[actor_id])
+				scores[actor_id] = similarity;
+		}
+		return n_comparisons;
+	}
+};
+
+void actor_name_index_matches_linear_scan() {
+	ActorNameIndexFixture f;
+	f.makePatterns(5000, 0);
+	ActorNameIndex index;
+	index.build(f.patterns);
+	BOOST_CHECK_EQUAL(index.size(), f.patterns.size());
+
+	const double thresholds[] = {0.0, 0.3, 0.5, 0.7, 0.75, 0.8, 0.85, 0.9, 1.0};
+	std::vector<ActorPattern *> candidates;
+	for (int q = 0; q < 300; ++q) {
+		std::wstring name = (q % 2) ? f.makeName() : f.perturb(f.patterns[rand() % f.patterns.size()]->lcString);
+		for (size_t t = 0; t < sizeof(thresholds)/sizeof(thresholds[0]); ++t) {
+			ActorNameIndexFixture::ScoreMap linear, indexed;
+			f.scorePatterns(name, thresholds[t], f.patterns, linear);
+			index.getCandidates(name, thresholds[t], candidates);
+			f.scorePatterns(name, thresholds[t], candidates, indexed);
+			BOOST_CHECK_MESSAGE(linear == indexed, "ActorNameIndex missed a close actor (query "
+				<< q << ", threshold " << thresholds[t] << ")");
+		}
+		candidates.clear();
+		index.getExactMatches(name, candidates);
+		for (size_t i = 0; i < candidates.size(); ++i)
+			BOOST_CHECK(candidates[i]->lcString == name);
+	}
+}
+
+void actor_name_index_benchmark() {
+	ActorNameIndexFixture f;
+	f.makePatterns(200000, 1);
+	ActorNameIndex index;
+	index.build(f.patterns);
+
+	std::vector<std::wstring> names;
+	for (int q = 0; q < 200; ++q)
+		names.push_back(f.perturb(f.patterns[rand() % f.patterns.size()]->lcString));
+	const double threshold = 0.8;
+
+	GenericTimer linearTimer;
+	size_t linear_comparisons = 0;
+	std::vector<ActorNameIndexFixture::ScoreMap> linearScores(names.size());
+	linearTimer.startTimer();
+	for (size_t q = 0; q < names.size(); ++q)
+		linear_comparisons += f.scorePatterns(names[q], threshold, f.patterns, linearScores[q]);
+	linearTimer.stopTimer();
+
+	GenericTimer indexTimer;
+	size_t n_candidates = 0;
+	size_t indexed_comparisons = 0;
+	std::vector<ActorPattern *> candidates;
+	std::vector<ActorNameIndexFixture::ScoreMap> indexedScores(names.size());
+	indexTimer.startTimer();
+	for (size_t q = 0; q < names.size(); ++q) {
+		index.getCandidates(names[q], threshold, candidates);
+		n_candidates += candidates.size();
+		indexed_comparisons += f.scorePatterns(names[q], threshold, candidates, indexedScores[q]);
+	}
+	indexTimer.stopTimer();
+
+	BOOST_CHECK(linearScores == indexedScores);
+	BOOST_TEST_MESSAGE("Linear scan: " << linear_comparisons << " edit distance comparisons, "
+		<< linearTimer.getTime() << " msec for " << names.size() << " names");
+	BOOST_TEST_MESSAGE("ActorNameIndex: " << n_candidates << " candidates, " << indexed_comparisons
+		<< " edit distance comparisons, " << indexTimer.getTime() << " msec for " << names.size() << " names");
+}
@@ -0,0 +1,121 @@
+#include "Generic/common/GenericTimer.h"
+#include "Generic/common/LocatedString.h"
+
+#pragma warning(push)
+#pragma warning(disable : 4266)
+#include <boost/test/unit_test.hpp>
+#pragma warning(pop)
+
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+/** Tests for LocatedString's batched edits (LocatedString::applyEdits(),
+  * which is used by replace(find, repl) and by
+  * replaceNonstandardUnicodeWhitespace()).
+  *
+  * located_string_batched_replace_matches_sequential checks that replacing
+  * every occurrence of a string in a single pass gives exactly the same
+  * text and offsets as replacing the occurrences one at a time with
+  * replace(pos, len, repl), on strings whose offset entries have been
+  * fragmented by earlier edits.
+  *
+  * located_string_batched_replace_benchmark reports how long each approach
+  * takes on a synthetic 1MB document. */
+struct LocatedStringEditsFixture {
+
+	/** Replace each occurrence of find with repl, one at a time. */
+	static void replaceSequentially(LocatedString &str, const wchar_t *find, const wchar_t *repl) {
+		int find_len = static_cast<int>(wcslen(find));
+		int repl_len = static_cast<int>(wcslen(repl));
+		int start = 0;
+		while (start < str.length()) {
+			int pos = str.indexOf(find, start);
+			if (pos == -1)
+				return;
+			str.replace(pos, find_len, repl);
+			start = pos + repl_len;
+		}
+	}
+
+	static bool sameOffsets(const OffsetGroup &a, const OffsetGroup &b) {
+		return a.byteOffset == b.byteOffset && a.charOffset == b.charOffset &&
+			a.edtOffset == b.edtOffset && a.asrTime == b.asrTime;
+	}
+
+	static bool sameLocatedString(const LocatedString &a, const LocatedString &b) {
+		if (a.length() != b.length() || a.toWString() != b.toWString())
+			return false;
+		for (int i = 0; i < a.length(); ++i) {
+			if (!sameOffsets(a.startOffsetGroup(i), b.startOffsetGroup(i)) ||
+				!sameOffsets(a.endOffsetGroup(i), b.endOffsetGroup(i)))
+				return false;
+		}
+		return true;
+	}
+
+	/** Return a random string of the given length, which has been edited
+	  * so that its offsets are split into many entries. */
+	static LocatedString *makeFragmentedString(int length, unsigned seed) {
+		srand(seed);
+		std::wstring text;
+		for (int i = 0; i < length; ++i)
+			text += L"abxZ "[rand() % 5];
+		LocatedString *str = _new LocatedString(text.c_str());
+		for (int k = 0; k < 20 && str->length() > 8; ++k) {
+			int pos = rand() % (str->length() - 2);
+			switch (rand() % 4) {
+				case 0: str->replace(pos, 1 + rand() % 2, L"xZ"); break;
+				case 1: str->insert(L"ab", pos); break;
+				case 2: str->setAsrStartTime(pos, ASRTime(static_cast<float>(pos))); break;
+				default: str->remove(pos, pos + 1); break;
+			}
+		}
+		return str;
+	}
+};
+
+void located_string_batched_replace_matches_sequential() {
+	LocatedStringEditsFixture f;
+	const wchar_t *finds[] = {L"a", L"ab", L"x", L"aa", L"Z"};
+	const wchar_t *repls[] = {L"", L"Q", L"QQQ", L"a", L"ab"};
+	for (unsigned seed = 0; seed < 500; ++seed) {
+		int length = 10 + seed % 30;
+		for (size_t i = 0; i < sizeof(finds)/sizeof(finds[0]); ++i) {
+			for (size_t j = 0; j < sizeof(repls)/sizeof(repls[0]); ++j) {
+				LocatedString *sequential = f.makeFragmentedString(length, seed);
+				LocatedString *batched = f.makeFragmentedString(length, seed);
+				f.replaceSequentially(*sequential, finds[i], repls[j]);
+				batched->replace(finds[i], repls[j]);
+				BOOST_CHECK_MESSAGE(f.sameLocatedString(*sequential, *batched),
+					"batched replace differs from sequential replace (seed " << seed
+					<< ", find " << i << ", repl " << j << ")");
+				delete sequential;
+				delete batched;
+			}
+		}
+	}
+}
+
+void located_string_batched_replace_benchmark() {
+	LocatedStringEditsFixture f;
+	std::wstring text;
+	while (text.size() < 1000000)
+		text += L"write to someone (at) example (dot) com for details.\n";
+	LocatedString sequential(text.c_str());
+	LocatedString batched(text.c_str());
+
+	GenericTimer sequentialTimer;
+	sequentialTimer.startTimer();
+	f.replaceSequentially(sequential, L"(at)", L"@");
+	sequentialTimer.stopTimer();
+
+	GenericTimer batchedTimer;
+	batchedTimer.startTimer();
+	batched.replace(L"(at)", L"@");
+	batchedTimer.stopTimer();
+
+	BOOST_CHECK(f.sameLocatedString(sequential, batched));
+	BOOST_TEST_MESSAGE("1MB replace (one at a time): " << sequentialTimer.getTime() << " msec");
+	BOOST_TEST_MESSAGE("1MB replace (batched): " << batchedTimer.getTime() << " msec");
+}
@@ -0,0 +1,376 @@
+#include "Generic/common/Cache.h"
+#include "Generic/common/GenericTimer.h"
+#include "Generic/common/ParamReader.h"
+#include "Generic/common/Symbol.h"
+#include "Generic/driver/DocumentDriver.h"
+#include "Generic/driver/SessionProgram.h"
+#include "Generic/driver/Stage.h"
+#include "Generic/reader/DocumentReader.h"
+#include "Generic/results/SerifXMLResultCollector.h"
+#include "EnglishTest/test/SerifTestUtil.h"
+
+#pragma warning(push)
+#pragma warning(disable : 4266)
+#include <boost/test/unit_test.hpp>
+#pragma warning(pop)
+#include <boost/bind.hpp>
+#include <boost/scoped_ptr.hpp>
+#include <boost/thread.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <list>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+#if defined(_WIN32) || defined(__APPLE_CC__)
+#include "Generic/common/hash_map.h"
+#else
+#include <ext/hash_map>
+#endif
+
+/** Tests for NGramCache, the cache used by the parser's probability
+  * tables (HeadProbs, ModifierProbs, LexicalProbs, and ChartDecoder).
+  *
+  * ngram_cache_matches_map checks the cache's contents against a std::map,
+  * with and without eviction, and checks its counters.
+  *
+  * ngram_cache_concurrent_lookups checks that several threads can share a
+  * sharded cache.
+  *
+  * ngram_cache_benchmark reports the time and hit rate of each kind of
+  * cache for a stream of lookups with a skewed (Zipf-like) distribution,
+  * similar to the parser's.  It compares NGramCache with the caches that
+  * it replaced (see BaselineNGramCache), and repeats each run several
+  * times (ngram_cache_benchmark_runs, default 5) to report the mean and
+  * standard deviation.
+  *
+  * ngram_cache_parse_benchmark runs Serif through the parse stage on a
+  * document (ngram_cache_benchmark_document, or a short built-in document)
+  * with each value of probs_cache_type, and reports the mean and standard
+  * deviation of the parse time over ngram_cache_benchmark_runs runs (after
+  * a warm-up run).  It checks that the cache does not change the parses. */
+struct NGramCacheFixture {
+	static const size_t N = 4;
+	std::vector<Symbol> vocab;
+	std::vector<Symbol> ngrams; // n_ngrams * N symbols
+
+	NGramCacheFixture(size_t vocab_size=500, size_t n_ngrams=20000) {
+		for (size_t i = 0; i < vocab_size; ++i) {
+			wchar_t buffer[20];
+			swprintf(buffer, 20, L"ngram_cache_%d", static_cast<int>(i));
+			vocab.push_back(Symbol(buffer));
+		}
+		srand(0);
+		for (size_t i = 0; i < n_ngrams * N; ++i)
+			ngrams.push_back(vocab[rand() % vocab_size]);
+	}
+
+	size_t size() const { return ngrams.size() / N; }
+	const Symbol* ngram(size_t i) const { return &ngrams[i * N]; }
+	static float valueOf(size_t i) { return static_cast<float>(i) / 7; }
+
+	/** Return a skewed random ngram index: small indices are much more
+	  * common than large ones. */
+	size_t skewedIndex() const {
+		double r = static_cast<double>(rand()) / RAND_MAX;
+		return static_cast<size_t>(r * r * r * (size() - 1));
+	}
+
+	/** Look up n_lookups skewed ngrams, adding each one that is missing;
+	  * increment *n_wrong for each hit whose value is wrong; and return the
+	  * number of hits. */
+	template<typename CacheT>
+	static size_t lookupSkewed(const NGramCacheFixture *f, CacheT *cache, size_t n_lookups, unsigned seed, size_t *n_wrong) {
+		size_t n_hits = 0;
+		unsigned state = seed;
+		for (size_t q = 0; q < n_lookups; ++q) {
+			state = state * 1103515245 + 12345;
+			double r = static_cast<double>((state >> 8) & 0xFFFF) / 0xFFFF;
+			size_t i = static_cast<size_t>(r * r * r * (f->size() - 1));
+			float value;
+			if (cache->find(f->ngram(i), value)) {
+				++n_hits;
+				if (value != valueOf(i))
+					++(*n_wrong);
+			} else {
+				cache->insert(f->ngram(i), valueOf(i));
+			}
+		}
+		return n_hits;
+	}
+
+	/** Return the mean and standard deviation of the given times. */
+	static std::pair<double, double> meanAndStdDev(const std::vector<double> &times) {
+		double sum = 0, sum_sq = 0;
+		for (size_t i = 0; i < times.size(); ++i)
+			sum += times[i];
+		double mean = times.empty() ? 0 : sum / times.size();
+		for (size_t i = 0; i < times.size(); ++i)
+			sum_sq += (times[i] - mean) * (times[i] - mean);
+		double stddev = (times.size() > 1) ? sqrt(sum_sq / (times.size() - 1)) : 0;
+		return std::make_pair(mean, stddev);
+	}
+
+	static int getBenchmarkRuns() {
+		return std::max(1, ParamReader::getOptionalIntParamWithDefaultValue("ngram_cache_benchmark_runs", 5));
+	}
+};
+
+/** An LRU map, as implemented by the lru_cache that NGramCache replaced:
+  * a list of entries in order of use, indexed by a hash_map.  Finding an
+  * entry moves it to the front of the list; adding an entry to a full map
+  * evicts the entry at the back. */
+#if !defined(_WIN32) && !defined(__APPLE_CC__)
+template<typename Key, typename Value, typename Hash, typename Eq>
+class BaselineLruMap {
+	typedef std::list<std::pair<Key, Value> > ListType;
+	typedef __gnu_cxx::hash_map<Key, typename ListType::iterator, Hash, Eq> IndexType;
+public:
+	typedef typename ListType::iterator iterator;
+
+	explicit BaselineLruMap(size_t max_size): _max_size(max_size), _size(0) {}
+
+	iterator find(const Key &key) {
+		typename IndexType::iterator it = _index.find(key);
+		if (it == _index.end())
+			return _list.end();
+		if (it->second != _list.begin())
+			_list.splice(_list.begin(), _list, it->second);
+		return it->second;
+	}
+
+	void insert(const std::pair<Key, Value> &entry) {
+		_list.push_front(entry);
+		if (!_index.insert(std::make_pair(entry.first, _list.begin())).second) {
+			_list.pop_front();
+			return;
+		}
+		if (_size == _max_size) {
+			_index.erase(_list.back().first);
+			_list.pop_back();
+		} else {
+			++_size;
+		}
+	}
+
+	iterator end() { return _list.end(); }
+	size_t size() const { return _size; }
+
+private:
+	size_t _max_size;
+	size_t _size;
+	ListType _list;
+	IndexType _index;
+};
+#endif
+
+/** A reference copy of the caches that NGramCache replaced, used as the
+  * baseline for ngram_cache_benchmark.  The map (a hash_map, or an LRU map
+  * on Linux) holds pointers to private copies of the ngrams, which are
+  * allocated up front; as before, new entries are only added while the
+  * map has fewer than max_size entries. */
+template<size_t N, typename MapClass>
+class BaselineNGramCache {
+public:
+	explicit BaselineNGramCache(size_t max_size)
+		: _max_size(max_size), _map(max_size), _ngrams(max_size * N), _n_ngrams(0) {}
+
+	bool find(const Symbol* ngram, float &value) {
+		typename MapClass::iterator it = _map.find(const_cast<Symbol*>(ngram));
+		if (it == _map.end())
+			return false;
+		value = (*it).second;
+		return true;
+	}
+
+	void insert(const Symbol* ngram, float value) {
+		if (_map.size() < _max_size && _n_ngrams < _max_size) {
+			Symbol *copy = &_ngrams[N * _n_ngrams++];
+			std::copy(ngram, ngram + N, copy);
+			_map.insert(std::make_pair(copy, value));
+		}
+	}
+
+private:
+	size_t _max_size;
+	MapClass _map;
+	std::vector<Symbol> _ngrams;
+	size_t _n_ngrams;
+};
+
+namespace {
+#if defined(_WIN32) || defined(__APPLE_CC__)
+	typedef BaselineNGramCache<NGramCacheFixture::N, serif::hash_map<Symbol*, float,
+		NGramQuickHash<NGramCacheFixture::N>, NGramEquals<NGramCacheFixture::N> > > BaselineSimpleCache;
+#else
+	typedef BaselineNGramCache<NGramCacheFixture::N, __gnu_cxx::hash_map<Symbol*, float,
+		NGramQuickHash<NGramCacheFixture::N>, NGramEquals<NGramCacheFixture::N> > > BaselineSimpleCache;
+	typedef BaselineNGramCache<NGramCacheFixture::N, BaselineLruMap<Symbol*, float,
+		NGramQuickHash<NGramCacheFixture::N>, NGramEquals<NGramCacheFixture::N> > > BaselineLruCache;
+#endif
+}
+
+void ngram_cache_matches_map() {
+	NGramCacheFixture f;
+	const size_t max_size = 1000;
+	for (int evict = 0; evict <= 1; ++evict) {
+		NGramCache<NGramCacheFixture::N> cache(max_size, evict != 0);
+		// The ngram indices that were added, and the first index with each ngram.
+		std::map<std::vector<Symbol>, size_t> added;
+		size_t n_finds = 0, n_hits = 0, n_inserts = 0;
+		for (int q = 0; q < 50000; ++q) {
+			size_t i = f.skewedIndex();
+			std::vector<Symbol> key(f.ngram(i), f.ngram(i) + NGramCacheFixture::N);
+			float value;
+			++n_finds;
+			bool found = cache.find(f.ngram(i), value);
+			std::map<std::vector<Symbol>, size_t>::iterator it = added.find(key);
+			if (found) {
+				++n_hits;
+				BOOST_REQUIRE(it != added.end());
+				BOOST_CHECK_EQUAL(value, NGramCacheFixture::valueOf(it->second));
+			} else {
+				if (!evict) {
+					// Without eviction, everything that was added is still there.
+					BOOST_CHECK(it == added.end() || added.size() >= max_size);
+				}
+				if (evict || added.size() < max_size) {
+					if (it == added.end())
+						added[key] = i;
+					cache.insert(f.ngram(i), NGramCacheFixture::valueOf(added[key]));
+					++n_inserts;
+				}
+			}
+			BOOST_REQUIRE(cache.size() <= max_size);
+		}
+		BOOST_CHECK_EQUAL(cache.getHits(), n_hits);
+		BOOST_CHECK_EQUAL(cache.getMisses(), n_finds - n_hits);
+		BOOST_CHECK_EQUAL(cache.getEvictions(), evict ? n_inserts - cache.size() : 0);
+
+		// Every entry that the iterators visit is found, with the same value.
+		size_t n_entries = 0;
+		for (NGramCache<NGramCacheFixture::N>::const_iterator it = cache.begin(); it != cache.end(); ++it) {
+			float value;
+			BOOST_CHECK(cache.find((*it).first, value) && value == (*it).second);
+			++n_entries;
+		}
+		BOOST_CHECK_EQUAL(n_entries, cache.size());
+
+		cache.clear();
+		BOOST_CHECK_EQUAL(cache.size(), 0u);
+		BOOST_CHECK(cache.begin() == cache.end());
+	}
+}
+
+void ngram_cache_concurrent_lookups() {
+	NGramCacheFixture f;
+	NGramCache<NGramCacheFixture::N> cache(2000, true, 8);
+	const int n_threads = 4;
+	std::vector<size_t> n_wrong(n_threads, 0);
+	boost::thread_group threads;
+	for (int t = 0; t < n_threads; t++) {
+		threads.create_thread(boost::bind(&NGramCacheFixture::lookupSkewed<NGramCache<NGramCacheFixture::N> >,
+			&f, &cache, 200000, t, &n_wrong[t]));
+	}
+	threads.join_all();
+	for (int t = 0; t < n_threads; t++)
+		BOOST_CHECK_EQUAL(n_wrong[t], 0u);
+	BOOST_CHECK_EQUAL(cache.getHits() + cache.getMisses(), static_cast<size_t>(n_threads * 200000));
+	BOOST_CHECK(cache.size() <= 2000);
+}
+
+/** Time n_runs runs of n_lookups skewed lookups, each with a new cache
+  * made by makeCache(), and report the mean and standard deviation. */
+template<typename CacheT, typename MakeCache>
+void runNGramCacheBenchmark(const NGramCacheFixture &f, const char *name, MakeCache makeCache, size_t n_lookups, int n_runs) {
+	std::vector<double> times;
+	size_t n_hits = 0;
+	for (int run = 0; run < n_runs; ++run) {
+		boost::scoped_ptr<CacheT> cache(makeCache());
+		size_t n_wrong = 0;
+		GenericTimer timer;
+		timer.startTimer();
+		n_hits = NGramCacheFixture::lookupSkewed(&f, cache.get(), n_lookups, 1, &n_wrong);
+		timer.stopTimer();
+		times.push_back(timer.getTime());
+		BOOST_CHECK_EQUAL(n_wrong, 0u);
+	}
+	std::pair<double, double> stats = NGramCacheFixture::meanAndStdDev(times);
+	BOOST_TEST_MESSAGE(name << ": " << stats.first << " +/- " << stats.second << " msec for "
+		<< n_lookups << " lookups (" << n_runs << " runs); hit rate "
+		<< static_cast<double>(n_hits) / n_lookups);
+}
+
+namespace {
+	const size_t BENCHMARK_CACHE_SIZE = 50000;
+	NGramCache<NGramCacheFixture::N> *makeSimpleNGramCache() {
+		return _new NGramCache<NGramCacheFixture::N>(BENCHMARK_CACHE_SIZE, false); }
+	NGramCache<NGramCacheFixture::N> *makeEvictingNGramCache() {
+		return _new NGramCache<NGramCacheFixture::N>(BENCHMARK_CACHE_SIZE, true); }
+	NGramCache<NGramCacheFixture::N> *makeShardedNGramCache() {
+		return _new NGramCache<NGramCacheFixture::N>(BENCHMARK_CACHE_SIZE, true, 8); }
+	BaselineSimpleCache *makeBaselineSimpleCache() {
+		return _new BaselineSimpleCache(BENCHMARK_CACHE_SIZE); }
+#if !defined(_WIN32) && !defined(__APPLE_CC__)
+	BaselineLruCache *makeBaselineLruCache() {
+		return _new BaselineLruCache(BENCHMARK_CACHE_SIZE); }
+#endif
+}
+
+void ngram_cache_benchmark() {
+	NGramCacheFixture f(5000, 500000);
+	const size_t n_lookups = 2000000;
+	int n_runs = f.getBenchmarkRuns();
+	typedef NGramCache<NGramCacheFixture::N> NewCache;
+	runNGramCacheBenchmark<BaselineSimpleCache>(f, "Old simple cache (hash_map)", &makeBaselineSimpleCache, n_lookups, n_runs);
+	runNGramCacheBenchmark<NewCache>(f, "NGramCache (simple)", &makeSimpleNGramCache, n_lookups, n_runs);
+#if !defined(_WIN32) && !defined(__APPLE_CC__)
+	runNGramCacheBenchmark<BaselineLruCache>(f, "Old lru cache (list + hash_map)", &makeBaselineLruCache, n_lookups, n_runs);
+#endif
+	runNGramCacheBenchmark<NewCache>(f, "NGramCache (evicting)", &makeEvictingNGramCache, n_lookups, n_runs);
+	runNGramCacheBenchmark<NewCache>(f, "NGramCache (evicting, 8 shards)", &makeShardedNGramCache, n_lookups, n_runs);
+}
+
+void ngram_cache_parse_benchmark() {
+	SerifTestFixture f;
+	std::wstring document = f.getTestDocument("ngram_cache_benchmark_document");
+	int n_runs = NGramCacheFixture::getBenchmarkRuns();
+	const char *cacheTypes[] = {"none", "simple", "lru"};
+	std::wstring uncachedResults;
+	for (int type = 0; type < 3; ++type) {
+		ParamReader::setParam("probs_cache_type", cacheTypes[type]);
+		DocumentDriver documentDriver;
+		documentDriver.giveDocumentReader(DocumentReader::build("sgm"));
+		SerifXMLResultCollector resultCollector;
+		SessionProgram sessionProgram;
+		sessionProgram.setStageRange(Stage::getStartStage(), Stage("parse"));
+		documentDriver.beginBatch(&sessionProgram, &resultCollector);
+		std::vector<double> times;
+		std::wstring results;
+		// The first run is a warm-up, and is not timed.
+		for (int run = 0; run <= n_runs; ++run) {
+			GenericTimer timer;
+			timer.startTimer();
+			documentDriver.runOnString(document.c_str(), &results);
+			timer.stopTimer();
+			if (run > 0)
+				times.push_back(timer.getTime());
+		}
+		documentDriver.endBatch();
+		if (type == 0) {
+			uncachedResults = results;
+			BOOST_CHECK(!uncachedResults.empty());
+		} else {
+			BOOST_CHECK_MESSAGE(results == uncachedResults,
+				"Parse output with probs_cache_type " << cacheTypes[type] << " differs from output without a cache");
+		}
+		std::pair<double, double> stats = NGramCacheFixture::meanAndStdDev(times);
+		BOOST_TEST_MESSAGE("Parse with probs_cache_type " << cacheTypes[type] << ": " << stats.first << " +/- "
+			<< stats.second << " msec per document (" << n_runs << " runs)");
+	}
+}
@@ -0,0 +1,198 @@
+#include "Generic/common/GenericTimer.h"
+#include "Generic/common/OutputUtil.h"
+#include "Generic/common/ParamReader.h"
+#include "Generic/common/Profiler.h"
+#include "EnglishTest/test/SerifTestUtil.h"
+
+#pragma warning(push)
+#pragma warning(disable : 4266)
+#include <boost/test/unit_test.hpp>
+#pragma warning(pop)
+#include <boost/thread.hpp>
+
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <string>
+
+/** Tests for the hierarchical profiler (see Profiler.h).
+  *
+  * profiler_nested_scopes_and_reports times a document with nested scopes,
+  * counters, and a worker thread that uses a ThreadContext, and checks the
+  * recorded counts and the contents of the JSON report and trace files.
+  *
+  * profiler_documents_per_thread times two documents at once, in two
+  * threads that each hand work to a worker thread, and checks that each
+  * document's times include its own worker's scopes but not the other
+  * document's, and that writing the files does not discard the data.
+  *
+  * profiler_disabled_overhead checks that nothing is recorded when
+  * profiling is turned off, and reports the cost of a scope with profiling
+  * turned off and on. */
+struct ProfilerFixture : public SerifTestFixture {
+	std::string reportFile;
+	std::string traceFile;
+
+	ProfilerFixture() {
+		OutputUtil::NamedTempFile report = OutputUtil::makeNamedTempFile();
+		report.second->close();
+		reportFile = report.first;
+		OutputUtil::NamedTempFile trace = OutputUtil::makeNamedTempFile();
+		trace.second->close();
+		traceFile = trace.first;
+		ParamReader::setParam("profiling_report_file", reportFile.c_str());
+		ParamReader::setParam("profiling_trace_file", traceFile.c_str());
+		Profiler::configure();
+		Profiler::reset();
+	}
+
+	~ProfilerFixture() {
+		remove(reportFile.c_str());
+		remove(traceFile.c_str());
+		resetParams();
+		Profiler::configure();
+		Profiler::reset();
+	}
+
+	static void worker(Profiler::Context context) {
+		Profiler::ThreadContext threadContext(context);
+		Profiler::Scope scope("worker");
+		Profiler::count("items");
+	}
+
+	/** Time a document named doc-<n> with a stage named stage-<n>, which
+	  * hands some work to a worker thread.  The barrier is used to keep
+	  * both documents open at once. */
+	static void document(int n, boost::barrier *barrier) {
+		std::wostringstream docid;
+		docid << L"doc-" << n;
+		std::ostringstream stage;
+		stage << "stage-" << n;
+		Profiler::DocumentScope documentScope(docid.str());
+		Profiler::Scope stageScope(stage.str().c_str());
+		barrier->wait();
+		boost::thread thread(&ProfilerFixture::worker, Profiler::getCurrentContext());
+		thread.join();
+		barrier->wait();
+	}
+
+	/** Return the per-document times for the given document in the given
+	  * JSON report. */
+	static std::string getDocumentTimes(const std::string &report, const std::string &docid) {
+		size_t start = report.find("{\"docid\": \"" + docid + "\"");
+		if (start == std::string::npos)
+			return "";
+		return report.substr(start, report.find("}}", start) - start);
+	}
+
+	static std::string readFile(const std::string &filename) {
+		std::ifstream in(filename.c_str());
+		std::ostringstream contents;
+		contents << in.rdbuf();
+		return contents.str();
+	}
+
+	static size_t countOccurrences(const std::string &s, const std::string &sub) {
+		size_t n = 0;
+		for (size_t pos = s.find(sub); pos != std::string::npos; pos = s.find(sub, pos + sub.size()))
+			++n;
+		return n;
+	}
+};
+
+void profiler_nested_scopes_and_reports() {
+	ProfilerFixture f;
+	BOOST_REQUIRE(Profiler::isEnabled());
+	{
+		Profiler::DocumentScope documentScope(L"doc-1");
+		Profiler::Scope stageScope("stage-a");
+		for (int i = 0; i < 3; ++i) {
+			Profiler::Scope innerScope("inner");
+			Profiler::count("items", 2);
+		}
+		BOOST_CHECK_EQUAL(Profiler::getCurrentPath(), "document/stage-a");
+		boost::thread thread(&ProfilerFixture::worker, Profiler::getCurrentContext());
+		thread.join();
+	}
+	BOOST_CHECK_EQUAL(Profiler::getCurrentPath(), "");
+	Profiler::writeFiles();
+
+	BOOST_CHECK_EQUAL(Profiler::getCount("document"), 1u);
+	BOOST_CHECK_EQUAL(Profiler::getCount("document/stage-a"), 1u);
+	BOOST_CHECK_EQUAL(Profiler::getCount("document/stage-a/inner"), 3u);
+	BOOST_CHECK_EQUAL(Profiler::getCount("document/stage-a/worker"), 1u);
+	BOOST_CHECK_EQUAL(Profiler::getCounter("document/stage-a/inner", "items"), 6);
+	BOOST_CHECK_EQUAL(Profiler::getCounter("document/stage-a/worker", "items"), 1);
+	BOOST_CHECK(Profiler::getTotalTime("document") >= Profiler::getTotalTime("document/stage-a"));
+
+	std::string report = ProfilerFixture::readFile(f.reportFile);
+	BOOST_CHECK(report.find("\"path\": \"document/stage-a/inner\"") != std::string::npos);
+	BOOST_CHECK(report.find("\"p99_msec\"") != std::string::npos);
+	BOOST_CHECK(report.find("\"docid\": \"doc-1\"") != std::string::npos);
+
+	std::string trace = ProfilerFixture::readFile(f.traceFile);
+	BOOST_CHECK_EQUAL(ProfilerFixture::countOccurrences(trace, "\"ph\": \"X\""), 6u);
+	// The worker's trace event belongs to the document that started it.
+	BOOST_CHECK_EQUAL(ProfilerFixture::countOccurrences(trace, "\"docid\": \"doc-1\""), 6u);
+}
+
+void profiler_documents_per_thread() {
+	ProfilerFixture f;
+	BOOST_REQUIRE(Profiler::isEnabled());
+	boost::barrier barrier(2);
+	boost::thread thread1(&ProfilerFixture::document, 1, &barrier);
+	boost::thread thread2(&ProfilerFixture::document, 2, &barrier);
+	thread1.join();
+	thread2.join();
+	Profiler::writeFiles();
+
+	std::string report = ProfilerFixture::readFile(f.reportFile);
+	std::string doc1 = ProfilerFixture::getDocumentTimes(report, "doc-1");
+	std::string doc2 = ProfilerFixture::getDocumentTimes(report, "doc-2");
+	BOOST_CHECK(doc1.find("\"document/stage-1/worker\"") != std::string::npos);
+	BOOST_CHECK(doc1.find("stage-2") == std::string::npos);
+	BOOST_CHECK(doc2.find("\"document/stage-2/worker\"") != std::string::npos);
+	BOOST_CHECK(doc2.find("stage-1") == std::string::npos);
+
+	// Writing the files (as DocumentDriver::endBatch() does) keeps the
+	// data, so a later batch adds to it.
+	BOOST_CHECK_EQUAL(Profiler::getCount("document"), 2u);
+	boost::barrier noWait(1);
+	ProfilerFixture::document(1, &noWait);
+	Profiler::writeFiles();
+	BOOST_CHECK_EQUAL(Profiler::getCount("document"), 3u);
+	BOOST_CHECK_EQUAL(Profiler::getCount("document/stage-1/worker"), 2u);
+	BOOST_CHECK_EQUAL(ProfilerFixture::countOccurrences(ProfilerFixture::readFile(f.reportFile), "\"docid\""), 3u);
+}
+
+void profiler_disabled_overhead() {
+	ProfilerFixture f;
+	const int n_scopes = 1000000;
+
+	ParamReader::unsetParam("profiling_report_file");
+	ParamReader::unsetParam("profiling_trace_file");
+	Profiler::configure();
+	BOOST_REQUIRE(!Profiler::isEnabled());
+	GenericTimer disabledTimer;
+	disabledTimer.startTimer();
+	for (int i = 0; i < n_scopes; ++i) {
+		Profiler::Scope scope("disabled");
+		Profiler::count("items");
+	}
+	disabledTimer.stopTimer();
+	BOOST_CHECK_EQUAL(Profiler::getCount("disabled"), 0u);
+
+	ParamReader::setParam("profiling_report_file", f.reportFile.c_str());
+	Profiler::configure();
+	GenericTimer enabledTimer;
+	enabledTimer.startTimer();
+	for (int i = 0; i < n_scopes; ++i) {
+		Profiler::Scope scope("enabled");
+		Profiler::count("items");
+	}
+	enabledTimer.stopTimer();
+	BOOST_CHECK_EQUAL(Profiler::getCount("enabled"), static_cast<size_t>(n_scopes));
+
+	BOOST_TEST_MESSAGE("Profiling off: " << (disabledTimer.getTime() * 1e6 / n_scopes) << " nsec per scope");
+	BOOST_TEST_MESSAGE("Profiling on: " << (enabledTimer.getTime() * 1e6 / n_scopes) << " nsec per scope");
+}
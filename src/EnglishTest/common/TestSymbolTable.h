@@ -0,0 +1,30 @@
+#include "Generic/common/ParamReader.h"
+#include "Generic/common/Symbol.h"
+
+#pragma warning(push)
+#pragma warning(disable : 4266)
+#include <boost/test/unit_test.hpp>
+#pragma warning(pop)
+#include <boost/thread.hpp>
+
+#include <algorithm>
+
+/** Tests for the (sharded) symbol table.
+  *
+  * symbol_table_unit_test runs Symbol::unitTest(), which checks interning,
+  * reference counting, and frozen symbols in a private symbol table.
+  *
+  * symbol_table_benchmark runs Symbol::benchmark(), which reports the
+  * number of symbols interned per second with 1 to N threads, with and
+  * without frozen common words.  N is set by the
+  * symbol_table_benchmark_max_threads parameter (default: the number of
+  * hardware threads, up to 8). */
+void symbol_table_unit_test() {
+	BOOST_CHECK(Symbol::unitTest());
+}
+
+void symbol_table_benchmark() {
+	int default_max_threads = std::max(1, std::min(8, static_cast<int>(boost::thread::hardware_concurrency())));
+	int max_threads = ParamReader::getOptionalIntParamWithDefaultValue("symbol_table_benchmark_max_threads", default_max_threads);
+	Symbol::benchmark(static_cast<size_t>(std::max(1, max_threads)));
+}
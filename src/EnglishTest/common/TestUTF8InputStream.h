@@ -0,0 +1,244 @@
+#include "Generic/common/GenericTimer.h"
+#include "Generic/common/OutputUtil.h"
+#include "Generic/common/ParamReader.h"
+#include "Generic/common/UTF8InputStream.h"
+#include "Generic/common/UTF8Token.h"
+
+#pragma warning(push)
+#pragma warning(disable : 4266)
+#include <boost/test/unit_test.hpp>
+#pragma warning(pop)
+#include <boost/scoped_ptr.hpp>
+
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <vector>
+
+/** Tests for UTF8InputStream's UTF8FileBuffer, which decodes files in
+  * bulk instead of using std::wifstream's file buffer and the utf8
+  * codecvt facet (see UTF8InputStream::setUseFileBuffer()).
+  *
+  * utf8_input_stream_file_buffer_matches_wifstream reads a file with
+  * multi-byte characters, carriage returns, and a line that is longer
+  * than the file buffer, line by line and token by token, with and
+  * without the file buffer, and checks that the results (including the
+  * stream states) are the same.
+  *
+  * utf8_input_stream_line_views reads a file with getLineView(), with and
+  * without the file buffer, and checks each line's exact contents, the
+  * stream state after the last line, and that other reads (getLine() and
+  * UTF8Token) pick up where getLineView() left off.
+  *
+  * utf8_input_stream_model_loading_benchmark does the same for the
+  * model files listed in the utf8_input_stream_test_files parameter
+  * (e.g., the files used by the standard English models), and reports
+  * the time taken with and without the file buffer.  If that parameter
+  * is not specified, then the test is skipped. */
+struct UTF8InputStreamFixture {
+
+	~UTF8InputStreamFixture() {
+		UTF8InputStream::setUseFileBuffer(ParamReader::getOptionalTrueFalseParamWithDefaultVal("use_utf8_file_buffer", true));
+	}
+
+	/** A summary of a file's contents, as read by UTF8InputStream. */
+	struct Contents {
+		size_t n_lines;
+		size_t n_tokens;
+		size_t n_chars;
+		size_t hash;
+		std::ios::iostate line_state;
+		std::ios::iostate token_state;
+		bool line_views_match;
+		Contents(): n_lines(0), n_tokens(0), n_chars(0), hash(0), line_views_match(true) {}
+		bool operator==(const Contents &other) const {
+			return n_lines == other.n_lines && n_tokens == other.n_tokens && n_chars == other.n_chars &&
+				hash == other.hash && line_state == other.line_state && token_state == other.token_state;
+		}
+	};
+
+	static void addToHash(size_t &hash, const wchar_t *chars, size_t length) {
+		for (size_t i = 0; i < length; ++i)
+			hash = hash * 31 + static_cast<size_t>(chars[i]);
+		hash = hash * 31 + 1;
+	}
+
+	/** The time (in msec) spent reading with getLine(), getLineView(),
+	  * and UTF8Token. */
+	struct Timing {
+		double getline_msec;
+		double view_msec;
+		double token_msec;
+		Timing(): getline_msec(0), view_msec(0), token_msec(0) {}
+	};
+
+	/** Read the given file line by line (once using getLine() and once
+	  * using getLineView()) and then token by token (using UTF8Token), and
+	  * return a summary of what was read.  Add the time spent to timing. */
+	static Contents read(const std::string &filename, bool use_file_buffer, Timing &timing) {
+		UTF8InputStream::setUseFileBuffer(use_file_buffer);
+		Contents contents;
+		{
+			GenericTimer timer;
+			timer.startTimer();
+			boost::scoped_ptr<UTF8InputStream> in(UTF8InputStream::build(filename.c_str()));
+			std::wstring line;
+			while (true) {
+				in->getLine(line);
+				if (in->fail())
+					break;
+				++contents.n_lines;
+				contents.n_chars += line.size();
+				addToHash(contents.hash, line.c_str(), line.size());
+				if (in->eof())
+					break;
+			}
+			contents.line_state = in->rdstate();
+			timer.stopTimer();
+			timing.getline_msec += timer.getTime();
+		}
+		{
+			GenericTimer timer;
+			timer.startTimer();
+			boost::scoped_ptr<UTF8InputStream> in(UTF8InputStream::build(filename.c_str()));
+			const wchar_t *view;
+			size_t view_length;
+			size_t n_lines = 0;
+			size_t hash = 0;
+			while (in->getLineView(view, view_length)) {
+				++n_lines;
+				addToHash(hash, view, view_length);
+				if (in->eof())
+					break;
+			}
+			timer.stopTimer();
+			timing.view_msec += timer.getTime();
+			contents.line_views_match = (n_lines == contents.n_lines && hash == contents.hash && 
+				in->rdstate() == contents.line_state);
+		}
+		{
+			GenericTimer timer;
+			timer.startTimer();
+			boost::scoped_ptr<UTF8InputStream> in(UTF8InputStream::build(filename.c_str()));
+			UTF8Token token;
+			while (!in->eof()) {
+				*in >> token;
+				++contents.n_tokens;
+				addToHash(contents.hash, token.chars(), wcslen(token.chars()));
+			}
+			contents.token_state = in->rdstate();
+			timer.stopTimer();
+			timing.token_msec += timer.getTime();
+		}
+		return contents;
+	}
+};
+
+void utf8_input_stream_file_buffer_matches_wifstream() {
+	UTF8InputStreamFixture f;
+	OutputUtil::NamedTempFile tempFile = OutputUtil::makeNamedTempFile();
+	std::ofstream &out = *tempFile.second;
+	out << "first line\r\n";
+	out << "caf\xc3\xa9 (na\xc3\xafve) \xe6\xbc\xa2\xe5\xad\x97\n";
+	out << "\n";
+	out << "  (a (b c))\td\r\n";
+	for (int i = 0; i < 100000; ++i)
+		out << "\xce\xa9";
+	out << " \xce\xa9\n";
+	out << "no newline at the end";
+	out.close();
+
+	UTF8InputStreamFixture::Timing timing;
+	UTF8InputStreamFixture::Contents withBuffer = f.read(tempFile.first, true, timing);
+	UTF8InputStreamFixture::Contents withoutBuffer = f.read(tempFile.first, false, timing);
+	remove(tempFile.first.c_str());
+
+	BOOST_CHECK_EQUAL(withoutBuffer.n_lines, 6u);
+	BOOST_CHECK_EQUAL(withBuffer.n_lines, withoutBuffer.n_lines);
+	BOOST_CHECK_EQUAL(withBuffer.n_tokens, withoutBuffer.n_tokens);
+	BOOST_CHECK_EQUAL(withBuffer.n_chars, withoutBuffer.n_chars);
+	BOOST_CHECK(withBuffer == withoutBuffer);
+	BOOST_CHECK(withBuffer.line_views_match);
+	BOOST_CHECK(withoutBuffer.line_views_match);
+}
+
+void utf8_input_stream_line_views() {
+	UTF8InputStreamFixture f;
+	OutputUtil::NamedTempFile tempFile = OutputUtil::makeNamedTempFile();
+	std::ofstream &out = *tempFile.second;
+	out << "first line\r\n";
+	out << "\n";
+	out << "caf\xc3\xa9 \xe6\xbc\xa2\xe5\xad\x97\r\r\n";
+	for (int i = 0; i < 100000; ++i)
+		out << "\xce\xa9";
+	out << "\n";
+	out << "token (after) views\n";
+	out << "line after tokens\n";
+	out << "no newline at the end";
+	out.close();
+
+	std::vector<std::wstring> expected;
+	expected.push_back(L"first line");
+	expected.push_back(L"");
+	expected.push_back(L"caf\x00e9 \x6f22\x5b57\r");
+	expected.push_back(std::wstring(100000, L'\x03a9'));
+
+	for (int use_file_buffer = 1; use_file_buffer >= 0; --use_file_buffer) {
+		BOOST_TEST_MESSAGE("use_file_buffer = " << use_file_buffer);
+		UTF8InputStream::setUseFileBuffer(use_file_buffer != 0);
+		boost::scoped_ptr<UTF8InputStream> in(UTF8InputStream::build(tempFile.first.c_str()));
+		const wchar_t *line;
+		size_t length;
+		for (size_t i = 0; i < expected.size(); ++i) {
+			BOOST_REQUIRE(in->getLineView(line, length));
+			BOOST_CHECK(std::wstring(line, length) == expected[i]);
+			BOOST_CHECK(in->good());
+		}
+
+		// Token reads and getLine() continue from the start of the next line.
+		UTF8Token token;
+		*in >> token;
+		BOOST_CHECK(wcscmp(token.chars(), L"token") == 0);
+		*in >> token;
+		BOOST_CHECK(wcscmp(token.chars(), L"(") == 0);
+		std::wstring rest;
+		in->getLine(rest);
+		BOOST_CHECK(rest == L"after) views");
+		BOOST_REQUIRE(in->getLineView(line, length));
+		BOOST_CHECK(std::wstring(line, length) == L"line after tokens");
+
+		// The last line has no newline, so reading it sets eofbit (but not
+		// failbit), and reading past it sets failbit.
+		BOOST_REQUIRE(in->getLineView(line, length));
+		BOOST_CHECK(std::wstring(line, length) == L"no newline at the end");
+		BOOST_CHECK(in->eof());
+		BOOST_CHECK(!in->fail());
+		BOOST_CHECK(!in->getLineView(line, length));
+		BOOST_CHECK(in->fail());
+	}
+	remove(tempFile.first.c_str());
+}
+
+void utf8_input_stream_model_loading_benchmark() {
+	std::vector<std::string> filenames = ParamReader::getStringVectorParam("utf8_input_stream_test_files");
+	if (filenames.empty()) {
+		BOOST_TEST_MESSAGE("utf8_input_stream_test_files not specified; skipping");
+		return;
+	}
+	UTF8InputStreamFixture f;
+	UTF8InputStreamFixture::Timing bufferTiming;
+	UTF8InputStreamFixture::Timing wifstreamTiming;
+	size_t n_chars = 0;
+	for (size_t i = 0; i < filenames.size(); ++i) {
+		UTF8InputStreamFixture::Contents withoutBuffer = f.read(filenames[i], false, wifstreamTiming);
+		UTF8InputStreamFixture::Contents withBuffer = f.read(filenames[i], true, bufferTiming);
+		BOOST_CHECK_MESSAGE(withBuffer == withoutBuffer && withBuffer.line_views_match && withoutBuffer.line_views_match,
+			"Reading " << filenames[i] << " with the file buffer gives different results");
+		n_chars += withBuffer.n_chars;
+	}
+	BOOST_TEST_MESSAGE("Read " << filenames.size() << " files (" << n_chars << " characters)");
+	BOOST_TEST_MESSAGE("std::wifstream: getLine " << wifstreamTiming.getline_msec << " msec, getLineView " 
+		<< wifstreamTiming.view_msec << " msec, tokens " << wifstreamTiming.token_msec << " msec");
+	BOOST_TEST_MESSAGE("UTF8FileBuffer: getLine " << bufferTiming.getline_msec << " msec, getLineView " 
+		<< bufferTiming.view_msec << " msec, tokens " << bufferTiming.token_msec << " msec");
+}
@@ -0,0 +1,343 @@
+#include "Generic/common/GenericTimer.h"
+#include "Generic/common/HeapStatus.h"
+#include "Generic/common/InternalInconsistencyException.h"
+#include "Generic/common/OutputUtil.h"
+#include "Generic/common/ParamReader.h"
+#include "Generic/discTagger/BlockFeatureTable.h"
+#include "Generic/discTagger/DTBigramFeature.h"
+#include "Generic/discTagger/DTBigramStringFeature.h"
+#include "Generic/discTagger/DTFeature.h"
+#include "Generic/discTagger/DTFeatureKey.h"
+#include "Generic/discTagger/DTFeatureType.h"
+#include "Generic/discTagger/DTTagSet.h"
+#include "Generic/discTagger/DTTrigramIntFeature.h"
+#include "Generic/names/discmodel/PIdFFeatureType.h"
+#include "Generic/names/discmodel/PIdFFeatureTypes.h"
+#include "EnglishTest/test/SerifTestUtil.h"
+
+#pragma warning(push)
+#pragma warning(disable : 4266)
+#include <boost/test/unit_test.hpp>
+#pragma warning(pop)
+#include <boost/scoped_ptr.hpp>
+
+#include <algorithm>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+/** Tests for BlockFeatureTable, the weight table used by PDecoder.
+  *
+  * block_feature_table_key_lookup_matches_feature_lookup fills a table
+  * with 20,000 random features (of three feature types, one of which can
+  * only be represented by a fallback key), and then checks that 50,000
+  * random features (many of which are not in the table) get the same
+  * weights when they are looked up by DTFeatureKey in the frozen table as
+  * when they are looked up as DTFeatures in an unfrozen copy of the table.
+  * It does not need a model.
+  *
+  * block_feature_table_unknown_tag_keeps_weights checks that inserting a
+  * weight with an unknown tag throws without dropping the weights that
+  * are already in the table for the same feature.
+  *
+  * block_feature_table_benchmark reads a PIdF model (specified by the
+  * block_feature_table_benchmark_model parameter, with the tag set given by
+  * pidf_tag_set_file and pidf_interleave_tags) into two tables: one that is
+  * left unfrozen, with each feature's weights in a linked list, and one
+  * that is frozen into a single contiguous array.  It checks that every
+  * feature in the model gets the same weights from both tables (and by
+  * key, from the frozen table), and reports the resident memory used by
+  * each table and the time to look up every feature
+  * (block_feature_table_benchmark_passes times, default 20).  If the model
+  * is not specified, the benchmark is skipped.
+  *
+  * block_feature_table_decode_benchmark runs Serif through the names stage
+  * on a document (block_feature_table_benchmark_document, or a short
+  * built-in document), once with freeze_block_feature_tables set to false
+  * (so PDecoder looks up DTFeatures in the linked-list tables) and once
+  * with it set to true.  It checks that the names are the same, and
+  * reports the resident memory used by loading the models and the mean
+  * decode time over block_feature_table_benchmark_passes runs. */
+struct BlockFeatureTableFixture {
+
+	/** Copy the given weights into a new BlockFeatureTable, and freeze it if
+	  * freeze is true.  Set memory to the amount by which the process's
+	  * resident memory grew.  The caller takes ownership of the table; the
+	  * features are still owned by weightMap. */
+	static BlockFeatureTable *buildTable(DTTagSet *tagSet, DTFeature::FeatureWeightMap &weightMap, bool freeze, size_t &memory) {
+		HeapStatus::releaseFreeMemory();
+		size_t start_memory = HeapStatus::getResidentMemory();
+		BlockFeatureTable *table = _new BlockFeatureTable(tagSet);
+		for (DTFeature::FeatureWeightMap::iterator iter = weightMap.begin(); iter != weightMap.end(); ++iter)
+			table->insert((*iter).first, *(*iter).second);
+		if (freeze)
+			table->freeze();
+		HeapStatus::releaseFreeMemory();
+		size_t end_memory = HeapStatus::getResidentMemory();
+		memory = (end_memory > start_memory) ? (end_memory - start_memory) : 0;
+		return table;
+	}
+
+	/** Look up each of the given features n_passes times, and return the
+	  * time that it took, in msec. */
+	static double timeFeatureLookups(BlockFeatureTable &table, const std::vector<DTFeature*> &features, int n_tags, int n_passes) {
+		std::vector<double> weights(n_tags, 0);
+		GenericTimer timer;
+		timer.startTimer();
+		for (int pass = 0; pass < n_passes; ++pass) {
+			for (size_t i = 0; i < features.size(); ++i)
+				table.load(features[i], &weights[0]);
+		}
+		timer.stopTimer();
+		return timer.getTime();
+	}
+
+	/** Look up each of the given keys n_passes times, and return the time
+	  * that it took, in msec. */
+	static double timeKeyLookups(BlockFeatureTable &table, const std::vector<DTFeatureKey> &keys, int n_tags, int n_passes) {
+		std::vector<double> weights(n_tags, 0);
+		GenericTimer timer;
+		timer.startTimer();
+		for (int pass = 0; pass < n_passes; ++pass) {
+			for (size_t i = 0; i < keys.size(); ++i)
+				table.load(keys[i], &weights[0]);
+		}
+		timer.stopTimer();
+		return timer.getTime();
+	}
+
+	/** A minimal feature type, used to make features for the tests. */
+	class TestFeatureType : public DTFeatureType {
+	public:
+		TestFeatureType(const wchar_t *name) : DTFeatureType(Symbol(L"BlockFeatureTableTest"), Symbol(name)) {}
+		DTFeature *makeEmptyFeature() const { return 0; }
+		int extractFeatures(const DTState &state, DTFeature **resultArray) const { return 0; }
+	};
+
+	/** Return the test feature type with the given index (0, 1, or 2).  The
+	  * feature types are registered the first time this is called, and are
+	  * never deleted. */
+	static const DTFeatureType *getTestFeatureType(int index) {
+		static const DTFeatureType *featureTypes[] = {
+			_new TestFeatureType(L"bigram"), _new TestFeatureType(L"trigram-int"), _new TestFeatureType(L"bigram-string") };
+		return featureTypes[index];
+	}
+
+	/** Return a random test feature with the given tag: a DTBigramFeature,
+	  * a DTTrigramIntFeature, or a DTBigramStringFeature (which has no packed
+	  * key).  The feature's values are chosen from n_words words and n_values
+	  * other values, using (and updating) the random number state. */
+	static DTFeature *makeRandomFeature(Symbol tag, int n_words, int n_values, unsigned &state) {
+		static std::wstring str(L"str");
+		wchar_t buffer[32];
+		swprintf(buffer, 32, L"w%d", static_cast<int>(nextRandom(state) % n_words));
+		Symbol word(buffer);
+		swprintf(buffer, 32, L"v%d", static_cast<int>(nextRandom(state) % n_values));
+		Symbol value(buffer);
+		switch (nextRandom(state) % 3) {
+			case 0: return _new DTBigramFeature(getTestFeatureType(0), tag, word);
+			case 1: return _new DTTrigramIntFeature(getTestFeatureType(1), tag, word, value, static_cast<int>(nextRandom(state) % 6));
+			default: return _new DTBigramStringFeature(getTestFeatureType(2), tag, word, str);
+		}
+	}
+
+	static unsigned nextRandom(unsigned &state) {
+		state = state * 1103515245 + 12345;
+		return (state >> 8) & 0xFFFFFF;
+	}
+
+	/** Return the key for the given feature.  Features that can't be packed
+	  * into a key get a fallback key, which does not take ownership of the
+	  * feature unless releaseFeature() is called. */
+	static DTFeatureKey getKey(DTFeature *feature) {
+		DTFeatureKey key;
+		if (!feature->getKeyWithoutTag(key))
+			key.setFeature(feature);
+		return key;
+	}
+};
+
+void block_feature_table_key_lookup_matches_feature_lookup() {
+	BlockFeatureTableFixture f;
+	OutputUtil::NamedTempFile tagSetFile = OutputUtil::makeNamedTempFile();
+	*tagSetFile.second << "3\nPER\nORG\nLOC\n";
+	tagSetFile.second->close();
+	DTTagSet tagSet(tagSetFile.first.c_str(), false, false);
+	std::remove(tagSetFile.first.c_str());
+	int n_tags = tagSet.getNTags();
+
+	// Both tables hold pointers to the same features, which we own.
+	std::vector<DTFeature*> features;
+	BlockFeatureTable unfrozenTable(&tagSet);
+	BlockFeatureTable frozenTable(&tagSet);
+	unsigned state = 1;
+	for (int i = 0; i < 20000; ++i) {
+		Symbol tag = tagSet.getTagSymbol(f.nextRandom(state) % n_tags);
+		double weight = static_cast<double>(f.nextRandom(state) % 2000) / 100.0 - 10.0;
+		features.push_back(f.makeRandomFeature(tag, 3000, 50, state));
+		unfrozenTable.insert(features.back(), weight);
+		frozenTable.insert(features.back(), weight);
+	}
+	frozenTable.freeze();
+	BOOST_CHECK(frozenTable.isFrozen());
+	BOOST_CHECK_EQUAL(frozenTable.getNWeights(), unfrozenTable.getNWeights());
+
+	std::vector<double> featureWeights(n_tags), keyWeights(n_tags);
+	size_t n_found = 0, n_mismatches = 0, n_fallback_keys = 0;
+	DTFeatureKey key;
+	for (int i = 0; i < 50000; ++i) {
+		// Slightly larger ranges than above, so that some features are missing.
+		DTFeature *feature = f.makeRandomFeature(tagSet.getNoneTag(), 3500, 55, state);
+		std::fill(featureWeights.begin(), featureWeights.end(), 0.0);
+		std::fill(keyWeights.begin(), keyWeights.end(), 0.0);
+		unfrozenTable.load(feature, &featureWeights[0]);
+		if (feature->getKeyWithoutTag(key)) {
+			frozenTable.load(key, &keyWeights[0]);
+			feature->deallocate();
+		} else {
+			++n_fallback_keys;
+			key.setFeature(feature);
+			frozenTable.load(key, &keyWeights[0]);
+			key.releaseFeature();
+		}
+		if (featureWeights != keyWeights)
+			++n_mismatches;
+		if (std::count(featureWeights.begin(), featureWeights.end(), 0.0) != n_tags)
+			++n_found;
+	}
+	BOOST_CHECK_EQUAL(n_mismatches, 0u);
+	// Make sure that the test exercised both hits and misses, and fallback keys.
+	BOOST_CHECK(n_found > 0 && n_found < 50000);
+	BOOST_CHECK(n_fallback_keys > 0);
+	BOOST_TEST_MESSAGE(n_found << " of 50000 features found; " << n_fallback_keys << " used fallback keys");
+
+	for (size_t i = 0; i < features.size(); ++i)
+		features[i]->deallocate();
+}
+
+void block_feature_table_unknown_tag_keeps_weights() {
+	BlockFeatureTableFixture f;
+	OutputUtil::NamedTempFile tagSetFile = OutputUtil::makeNamedTempFile();
+	*tagSetFile.second << "3\nPER\nORG\nLOC\n";
+	tagSetFile.second->close();
+	DTTagSet tagSet(tagSetFile.first.c_str(), false, false);
+	std::remove(tagSetFile.first.c_str());
+	int n_tags = tagSet.getNTags();
+
+	Symbol word(L"w0");
+	DTFeature *perFeature = _new DTBigramFeature(f.getTestFeatureType(0), tagSet.getTagSymbol(0), word);
+	DTFeature *badFeature = _new DTBigramFeature(f.getTestFeatureType(0), Symbol(L"NOT-A-TAG"), word);
+	BlockFeatureTable table(&tagSet);
+	BOOST_CHECK(table.insert(perFeature, 1.5));
+	BOOST_CHECK_THROW(table.insert(badFeature, 2.5), InternalInconsistencyException);
+	// An unknown tag for a new feature must not leave an entry behind.
+	DTFeature *newBadFeature = _new DTBigramFeature(f.getTestFeatureType(0), Symbol(L"NOT-A-TAG"), Symbol(L"w1"));
+	BOOST_CHECK_THROW(table.insert(newBadFeature, 2.5), InternalInconsistencyException);
+	BOOST_CHECK_EQUAL(table.getNWeights(), 1u);
+	table.freeze();
+
+	std::vector<double> weights(n_tags, 0.0);
+	table.load(perFeature, &weights[0]);
+	BOOST_CHECK_EQUAL(weights[0], 1.5);
+	table.load(f.getKey(perFeature), &weights[0]);
+	BOOST_CHECK_EQUAL(weights[0], 1.5);
+
+	perFeature->deallocate();
+	badFeature->deallocate();
+	newBadFeature->deallocate();
+}
+
+void block_feature_table_benchmark() {
+	std::string model_file = ParamReader::getParam("block_feature_table_benchmark_model");
+	if (model_file.empty()) {
+		BOOST_TEST_MESSAGE("block_feature_table_benchmark_model not specified; skipping BlockFeatureTable benchmark");
+		return;
+	}
+	BlockFeatureTableFixture f;
+	PIdFFeatureTypes::ensureFeatureTypesInstantiated();
+	DTTagSet tagSet(ParamReader::getRequiredParam("pidf_tag_set_file").c_str(), true, true,
+		ParamReader::getRequiredTrueFalseParam("pidf_interleave_tags"));
+	int n_tags = tagSet.getNTags();
+	int n_passes = ParamReader::getOptionalIntParamWithDefaultValue("block_feature_table_benchmark_passes", 20);
+
+	DTFeature::FeatureWeightMap weightMap(500009);
+	DTFeature::readWeights(weightMap, model_file.c_str(), PIdFFeatureType::modeltype);
+	std::vector<DTFeature*> features;
+	std::vector<DTFeatureKey> keys;
+	for (DTFeature::FeatureWeightMap::iterator iter = weightMap.begin(); iter != weightMap.end(); ++iter) {
+		features.push_back((*iter).first);
+		keys.push_back(f.getKey((*iter).first));
+	}
+
+	size_t list_memory = 0, frozen_memory = 0;
+	boost::scoped_ptr<BlockFeatureTable> listTable(f.buildTable(&tagSet, weightMap, false, list_memory));
+	boost::scoped_ptr<BlockFeatureTable> frozenTable(f.buildTable(&tagSet, weightMap, true, frozen_memory));
+	BOOST_CHECK_EQUAL(listTable->getNWeights(), frozenTable->getNWeights());
+
+	// Every feature must get the same weights from each table.
+	std::vector<double> listWeights(n_tags), frozenWeights(n_tags), keyWeights(n_tags);
+	size_t n_mismatches = 0;
+	for (size_t i = 0; i < features.size(); ++i) {
+		std::fill(listWeights.begin(), listWeights.end(), 0.0);
+		std::fill(frozenWeights.begin(), frozenWeights.end(), 0.0);
+		std::fill(keyWeights.begin(), keyWeights.end(), 0.0);
+		listTable->load(features[i], &listWeights[0]);
+		frozenTable->load(features[i], &frozenWeights[0]);
+		frozenTable->load(keys[i], &keyWeights[0]);
+		if (listWeights != frozenWeights || listWeights != keyWeights)
+			++n_mismatches;
+	}
+	BOOST_CHECK_EQUAL(n_mismatches, 0u);
+
+	double list_msec = f.timeFeatureLookups(*listTable, features, n_tags, n_passes);
+	double frozen_msec = f.timeFeatureLookups(*frozenTable, features, n_tags, n_passes);
+	double key_msec = f.timeKeyLookups(*frozenTable, keys, n_tags, n_passes);
+	BOOST_TEST_MESSAGE("BlockFeatureTable: " << features.size() << " features, "
+		<< frozenTable->getNWeights() << " weights; " << n_passes << " lookup passes");
+	BOOST_TEST_MESSAGE("Unfrozen (linked lists): " << list_msec << " msec; "
+		<< list_memory / 1024 << " KB resident");
+	BOOST_TEST_MESSAGE("Frozen (contiguous array): " << frozen_msec << " msec by feature, "
+		<< key_msec << " msec by key; " << frozen_memory / 1024 << " KB resident");
+
+	listTable.reset();
+	frozenTable.reset();
+	for (DTFeature::FeatureWeightMap::iterator iter = weightMap.begin(); iter != weightMap.end(); ++iter)
+		(*iter).first->deallocate();
+}
+
+void block_feature_table_decode_benchmark() {
+	SerifTestFixture f;
+	std::wstring document = f.getTestDocument("block_feature_table_benchmark_document");
+	int n_passes = std::max(1, ParamReader::getOptionalIntParamWithDefaultValue("block_feature_table_benchmark_passes", 20));
+	std::wstring unfrozenResults;
+	for (int freeze = 0; freeze < 2; ++freeze) {
+		ParamReader::setParam("freeze_block_feature_tables", freeze ? "true" : "false");
+		HeapStatus::releaseFreeMemory();
+		size_t start_memory = HeapStatus::getResidentMemory();
+		DocumentDriver documentDriver;
+		documentDriver.giveDocumentReader(DocumentReader::build("sgm"));
+		SerifXMLResultCollector resultCollector;
+		SessionProgram sessionProgram;
+		sessionProgram.setStageRange(Stage::getStartStage(), Stage("names"));
+		documentDriver.beginBatch(&sessionProgram, &resultCollector);
+		// The first run loads the models, and is not timed.
+		std::wstring results;
+		documentDriver.runOnString(document.c_str(), &results);
+		HeapStatus::releaseFreeMemory();
+		size_t end_memory = HeapStatus::getResidentMemory();
+		GenericTimer timer;
+		timer.startTimer();
+		for (int pass = 0; pass < n_passes; ++pass)
+			documentDriver.runOnString(document.c_str(), &results);
+		timer.stopTimer();
+		documentDriver.endBatch();
+		BOOST_TEST_MESSAGE((freeze ? "Frozen" : "Unfrozen") << " BlockFeatureTables: "
+			<< timer.getTime() / n_passes << " msec per run through names; "
+			<< ((end_memory > start_memory) ? (end_memory - start_memory) / 1024 : 0)
+			<< " KB resident after loading");
+		if (freeze)
+			BOOST_CHECK_MESSAGE(results == unfrozenResults, "Freezing the BlockFeatureTables changed the output");
+		else
+			unfrozenResults = results;
+	}
+}
@@ -0,0 +1,134 @@
+#include "Generic/common/ParamReader.h"
+#include "Generic/common/GenericTimer.h"
+#include "Generic/common/OutputUtil.h"
+#include "Generic/common/UTF8InputStream.h"
+#include "Generic/common/UTF8OutputStream.h"
+#include "Generic/discTagger/ViterbiOps.h"
+#include "Generic/names/discmodel/PIdFModel.h"
+#include "Generic/PNPChunking/PNPChunkDecoder.h"
+#include "EnglishTest/test/SerifTestUtil.h"
+
+#pragma warning(push)
+#pragma warning(disable : 4266)
+#include <boost/test/unit_test.hpp>
+#pragma warning(pop)
+#include <boost/scoped_ptr.hpp>
+
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <string>
+
+/** Decode benchmarks for the taggers that use PDecoder.  Each benchmark
+  * decodes a fixed corpus of sentences (in the tagger's sexp format), and
+  * reports how long it took.  The baseline is the reference decoder, which
+  * scores one (tag, previous tag) pair at a time in double precision (see
+  * the pdecoder_use_vector_viterbi parameter); the vectorized double
+  * precision decoders must give exactly the same output.  The corpora and
+  * models are specified in the parameter file:
+  *
+  *   pdecoder_benchmark_pidf_corpus      -- names corpus (uses the pidf_* model params)
+  *   pdecoder_benchmark_pnpchunk_corpus  -- NP chunk corpus (uses the pnpchunk_* model params)
+  *
+  * If a corpus is not specified, the corresponding benchmark is skipped. */
+struct PDecoderBenchmarkFixture : public SerifTestFixture {
+
+	static std::string readFile(const std::string &filename) {
+		std::ifstream in(filename.c_str(), std::ios::binary);
+		std::ostringstream contents;
+		contents << in.rdbuf();
+		return contents.str();
+	}
+
+	/** Set the PDecoder parameters.  They are read when a PDecoder is
+	  * constructed, so this must be called before building the model. */
+	static void setDecoderParams(bool use_vector_viterbi, bool use_avx2, bool use_float_scores) {
+		ParamReader::setParam("pdecoder_use_vector_viterbi", use_vector_viterbi ? "true" : "false");
+		ParamReader::setParam("pdecoder_use_avx2", use_avx2 ? "true" : "false");
+		ParamReader::setParam("pdecoder_use_float_scores", use_float_scores ? "true" : "false");
+	}
+
+	/** Decode the given corpus with the names model, using the given decoder
+	  * settings, and return the decoded output.  The decode time is stored
+	  * in seconds. */
+	static std::string decodeNames(const std::string &corpus, bool use_vector_viterbi, bool use_avx2, 
+	                               bool use_float_scores, double &seconds) 
+	{
+		setDecoderParams(use_vector_viterbi, use_avx2, use_float_scores);
+		PIdFModel model(PIdFModel::DECODE);
+		return decode(model, corpus, seconds);
+	}
+
+	template<typename DecoderT>
+	static std::string decode(DecoderT &decoder, const std::string &corpus, double &seconds) {
+		OutputUtil::NamedTempFile tempFile = OutputUtil::makeNamedTempFile();
+		tempFile.second->close();
+		{
+			boost::scoped_ptr<UTF8InputStream> in(UTF8InputStream::build(corpus.c_str()));
+			UTF8OutputStream out(tempFile.first.c_str());
+			GenericTimer timer;
+			timer.startTimer();
+			decoder.decode(*in, out);
+			timer.stopTimer();
+			seconds = timer.getTime() / 1000;
+			out.close();
+		}
+		std::string result = readFile(tempFile.first);
+		std::remove(tempFile.first.c_str());
+		return result;
+	}
+};
+
+
+void names_decode_benchmark() {
+	std::string corpus = ParamReader::getParam("pdecoder_benchmark_pidf_corpus");
+	if (corpus.empty()) {
+		BOOST_TEST_MESSAGE("pdecoder_benchmark_pidf_corpus not specified; skipping names decode benchmark");
+		return;
+	}
+	PDecoderBenchmarkFixture f;
+
+	double reference_time = 0;
+	std::string reference_output = f.decodeNames(corpus, false, false, false, reference_time);
+	BOOST_CHECK(!reference_output.empty());
+	BOOST_TEST_MESSAGE("names decode (reference, double): " << reference_time << " sec");
+
+	double scalar_time = 0;
+	std::string scalar_output = f.decodeNames(corpus, true, false, false, scalar_time);
+	BOOST_TEST_MESSAGE("names decode (vector, scalar ops, double): " << scalar_time << " sec ("
+		<< reference_time / scalar_time << "x reference)");
+	// The vectorized decoder must give exactly the same tags.
+	BOOST_CHECK(scalar_output == reference_output);
+
+	if (ViterbiOps::avx2Supported()) {
+		double avx2_time = 0;
+		std::string avx2_output = f.decodeNames(corpus, true, true, false, avx2_time);
+		BOOST_TEST_MESSAGE("names decode (vector, AVX2, double): " << avx2_time << " sec ("
+			<< reference_time / avx2_time << "x reference)");
+		BOOST_CHECK(avx2_output == reference_output);
+	} else {
+		BOOST_TEST_MESSAGE("AVX2 not supported on this processor");
+	}
+
+	double float_time = 0;
+	f.decodeNames(corpus, true, true, true, float_time);
+	BOOST_TEST_MESSAGE("names decode (vector, float scores): " << float_time << " sec ("
+		<< reference_time / float_time << "x reference)");
+}
+
+void np_chunk_decode_benchmark() {
+	std::string corpus = ParamReader::getParam("pdecoder_benchmark_pnpchunk_corpus");
+	if (corpus.empty()) {
+		BOOST_TEST_MESSAGE("pdecoder_benchmark_pnpchunk_corpus not specified; skipping NP chunk decode benchmark");
+		return;
+	}
+	PDecoderBenchmarkFixture f;
+
+	// The NP chunker's weights are a FeatureWeightMap, so it always uses
+	// the unbuffered decoder, which has no vectorized version.
+	PNPChunkDecoder decoder;
+	double seconds = 0;
+	std::string output = f.decode(decoder, corpus, seconds);
+	BOOST_CHECK(!output.empty());
+	BOOST_TEST_MESSAGE("NP chunk decode: " << seconds << " sec");
+}
@@ -0,0 +1,149 @@
+#include "Generic/common/ParamReader.h"
+#include "Generic/common/UnrecoverableException.h"
+#include "Generic/driver/DocumentDriver.h"
+#include "Generic/driver/SessionProgram.h"
+#include "Generic/driver/Stage.h"
+#include "Generic/reader/DocumentReader.h"
+#include "Generic/results/SerifXMLResultCollector.h"
+#include "Generic/wordnet/xx_WordNet.h"
+#include "EnglishTest/test/SerifTestUtil.h"
+
+#pragma warning(push)
+#pragma warning(disable : 4266)
+#include <boost/test/unit_test.hpp>
+#pragma warning(pop)
+#include <boost/foreach.hpp>
+#include <boost/lexical_cast.hpp>
+#include <boost/thread.hpp>
+
+#include <string>
+#include <vector>
+
+/** Checks that several DocumentDrivers can process documents at the same
+  * time, as the SerifHTTPServer's worker threads do when the
+  * server_num_worker_threads parameter is greater than one.  Each worker
+  * thread owns its own DocumentDriver (loaded one at a time, as
+  * SerifWorkQueue does); the workers' SerifXML output for every document
+  * must be byte-for-byte identical to the output of a single driver that
+  * processes the documents one at a time.  The input document (in sgm
+  * format) is specified by the concurrent_drivers_test_document parameter;
+  * if it is not specified, then a short built-in document is used.  Each
+  * copy of the document that is submitted gets its own docid. */
+struct ConcurrentDocumentDriversFixture : public SerifTestFixture {
+
+	ConcurrentDocumentDriversFixture() {
+		// More than one worker requires the preloaded WordNet database;
+		// rebuild the WordNet singleton in case it was created without it.
+		ParamReader::setParam("preload_wordnet", "true");
+		WordNet::deleteInstance();
+		DocumentDriver::checkMultithreadedSettings("server_num_worker_threads");
+	}
+
+	~ConcurrentDocumentDriversFixture() {
+		BOOST_FOREACH(DocumentDriver *documentDriver, documentDrivers)
+			delete documentDriver;
+	}
+
+	std::vector<DocumentDriver*> documentDrivers;
+
+	/** Create a document driver and load its models. */
+	DocumentDriver *loadDocumentDriver() {
+		DocumentDriver *documentDriver = _new DocumentDriver();
+		documentDrivers.push_back(documentDriver);
+		documentDriver->giveDocumentReader(DocumentReader::build("sgm"));
+		for (Stage stage = Stage::getStartStage(); stage <= Stage("output"); ++stage)
+			documentDriver->loadModelsForStage(stage);
+		return documentDriver;
+	}
+
+	/** Run the given document driver on the given document (in sgm format)
+	  * through the output stage, and return the SerifXML. */
+	static std::wstring runDocument(DocumentDriver *documentDriver, const std::wstring &document) {
+		SerifXMLResultCollector resultCollector;
+		SessionProgram sessionProgram;
+		sessionProgram.setStageRange(Stage::getStartStage(), Stage("output"));
+		documentDriver->beginBatch(&sessionProgram, &resultCollector);
+		std::wstring results;
+		documentDriver->runOnString(document.c_str(), &results);
+		documentDriver->endBatch();
+		return results;
+	}
+
+	/** Processes every n_workers-th document, starting with document
+	  * worker, and stores each result (or error message) at the document's
+	  * index. */
+	struct Worker {
+		DocumentDriver *documentDriver;
+		const std::vector<std::wstring> *documents;
+		std::vector<std::wstring> *results;
+		std::vector<std::string> *errors;
+		size_t worker, n_workers;
+		void operator()() {
+			for (size_t i = worker; i < documents->size(); i += n_workers) {
+				try {
+					(*results)[i] = runDocument(documentDriver, (*documents)[i]);
+				} catch (UnrecoverableException &e) {
+					(*errors)[i] = e.getMessage();
+				} catch (std::exception &e) {
+					(*errors)[i] = e.what();
+				}
+			}
+		}
+	};
+
+	/** Return n_documents copies of the given document, each with its own
+	  * docid. */
+	static std::vector<std::wstring> makeDocuments(const std::wstring &document, size_t n_documents) {
+		std::vector<std::wstring> documents;
+		size_t docid_start = document.find(L"<DOCID>");
+		size_t docid_end = document.find(L"</DOCID>");
+		for (size_t i = 0; i < n_documents; ++i) {
+			std::wstring copy = document;
+			if (docid_start != std::wstring::npos && docid_end != std::wstring::npos)
+				copy.insert(docid_end, L"-" + boost::lexical_cast<std::wstring>(i));
+			documents.push_back(copy);
+		}
+		return documents;
+	}
+};
+
+
+void concurrent_document_drivers_match_single_driver() {
+	ConcurrentDocumentDriversFixture f;
+	const size_t n_workers = 4;
+	const size_t n_documents = 12;
+	std::vector<std::wstring> documents = f.makeDocuments(
+		f.getTestDocument("concurrent_drivers_test_document"), n_documents);
+
+	// Single-threaded queue: one driver processes the documents in order.
+	DocumentDriver *sequentialDriver = f.loadDocumentDriver();
+	std::vector<std::wstring> expected;
+	BOOST_FOREACH(const std::wstring &document, documents)
+		expected.push_back(f.runDocument(sequentialDriver, document));
+
+	// Multi-worker queue: load the workers' drivers one at a time, and then
+	// submit all the documents at once.
+	std::vector<std::wstring> results(n_documents);
+	std::vector<std::string> errors(n_documents);
+	std::vector<ConcurrentDocumentDriversFixture::Worker> workers(n_workers);
+	for (size_t w = 0; w < n_workers; ++w) {
+		workers[w].documentDriver = f.loadDocumentDriver();
+		workers[w].documents = &documents;
+		workers[w].results = &results;
+		workers[w].errors = &errors;
+		workers[w].worker = w;
+		workers[w].n_workers = n_workers;
+	}
+	boost::thread_group threads;
+	for (size_t w = 0; w < n_workers; ++w)
+		threads.create_thread(workers[w]);
+	threads.join_all();
+
+	for (size_t i = 0; i < n_documents; ++i) {
+		BOOST_CHECK_MESSAGE(errors[i].empty(), "Document " << i << " failed: " << errors[i]);
+		BOOST_CHECK(!expected[i].empty());
+		BOOST_CHECK_MESSAGE(results[i] == expected[i],
+			"SerifXML output for document " << i << " differs between " << n_workers
+			<< " concurrent drivers and a single driver");
+	}
+}
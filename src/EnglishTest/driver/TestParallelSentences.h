@@ -0,0 +1,67 @@
+#include "Generic/common/ParamReader.h"
+#include "Generic/driver/Stage.h"
+#include "Generic/wordnet/xx_WordNet.h"
+#include "EnglishTest/test/SerifTestUtil.h"
+
+#pragma warning(push)
+#pragma warning(disable : 4266)
+#include <boost/test/unit_test.hpp>
+#pragma warning(pop)
+#include <boost/lexical_cast.hpp>
+
+#include <string>
+
+/** Checks that running sentence-level stages in parallel (with the
+  * sentence_level_threads parameter) gives exactly the same SerifXML
+  * output as running them sequentially.  The input document (in sgm
+  * format) is specified by the parallel_sentences_test_document
+  * parameter; if it is not specified, then a short built-in document is
+  * used.
+  *
+  * parallel_sentences_match_sequential runs through the output stage.
+  * parallel_sentences_parse_match_sequential stops after the parse stage,
+  * so that every stage that is run (including parse) is run in parallel. */
+struct ParallelSentencesFixture : public SerifTestFixture {
+
+	ParallelSentencesFixture() {
+		// sentence_level_threads > 1 requires the preloaded WordNet
+		// database; rebuild the WordNet singleton in case it was created
+		// without it.
+		ParamReader::setParam("preload_wordnet", "true");
+		WordNet::deleteInstance();
+	}
+
+	/** Run Serif on the given document through endStage, using the given
+	  * number of sentence-level threads, and return the SerifXML. */
+	static std::wstring runSerif(const std::wstring &document, int n_threads, Stage endStage) {
+		ParamReader::setParam("sentence_level_threads", boost::lexical_cast<std::string>(n_threads).c_str());
+		return SerifTestFixture::runSerif(document, endStage);
+	}
+
+	/** Check that the given number of sentence-level threads gives the
+	  * same output as one thread, when Serif is run through endStage. */
+	static void checkParallelMatchesSequential(const std::wstring &document, Stage endStage) {
+		std::wstring sequential = runSerif(document, 1, endStage);
+		BOOST_CHECK(!sequential.empty());
+		for (int n_threads = 2; n_threads <= 4; n_threads += 2) {
+			std::wstring parallel = runSerif(document, n_threads, endStage);
+			BOOST_CHECK_MESSAGE(parallel == sequential,
+				"SerifXML output through " << endStage.getName() << " with " << n_threads
+				<< " sentence-level threads differs from sequential output");
+		}
+	}
+};
+
+
+void parallel_sentences_match_sequential() {
+	ParallelSentencesFixture f;
+	std::wstring document = f.getTestDocument("parallel_sentences_test_document");
+	f.checkParallelMatchesSequential(document, Stage("output"));
+}
+
+void parallel_sentences_parse_match_sequential() {
+	ParallelSentencesFixture f;
+	std::wstring document = f.getTestDocument("parallel_sentences_test_document");
+	f.checkParallelMatchesSequential(document, Stage("parse"));
+	BOOST_CHECK(f.runSerif(document, 4, Stage("parse")).find(L"<Parse") != std::wstring::npos);
+}
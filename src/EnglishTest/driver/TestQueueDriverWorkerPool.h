@@ -0,0 +1,218 @@
+#include "Generic/common/BoostUtil.h"
+#include "Generic/common/ParamReader.h"
+#include "Generic/driver/DiskQueueDriver.h"
+#include "Generic/driver/Stage.h"
+#include "Generic/linuxPort/serif_port.h"
+#include "Generic/theories/DocTheory.h"
+#include "Generic/theories/Document.h"
+#include "EnglishTest/test/SerifTestUtil.h"
+
+#pragma warning(push)
+#pragma warning(disable : 4266)
+#include <boost/test/unit_test.hpp>
+#pragma warning(pop)
+#include <boost/bind.hpp>
+#include <boost/date_time/posix_time/posix_time_types.hpp>
+#include <boost/filesystem.hpp>
+#include <boost/foreach.hpp>
+#include <boost/thread.hpp>
+
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#ifndef _WIN32
+#include <signal.h>
+#include <unistd.h>
+#endif
+
+/** Tests for QueueDriver's pool of worker processes (queue_driver_workers),
+  * and for how quickly an idle DiskQueueDriver notices new documents.
+  *
+  * queue_driver_worker_pool_recovers_crash runs a DiskQueueDriver with two
+  * workers over a temporary disk queue of short documents (through the
+  * tokens stage).  The first time a worker starts processing one chosen
+  * document, it kills itself (with SIGKILL).  The test checks that the
+  * supervisor restarts the worker, that the document is retried (rather
+  * than given up on), and that every document ends up in the destination
+  * directory.
+  *
+  * disk_queue_driver_wakes_on_new_document runs a single DiskQueueDriver
+  * in a thread, leaves it idle long enough for its polling interval to
+  * grow to several hundred msec, and then adds a document to the source
+  * queue.  On Linux, where the driver watches its queue with inotify, it
+  * checks that processing starts well before the next poll would.
+  * disk_queue_driver_polls_without_inotify does the same with
+  * disk_queue_use_inotify set to false, and checks that the document is
+  * still picked up by polling (within MAX_SLEEP_TIME, 5 seconds). */
+#ifndef _WIN32
+class CrashingDiskQueueDriver: public DiskQueueDriver {
+public:
+	CrashingDiskQueueDriver(const std::string &crashDocId, const std::string &crashedFile, const std::string &startsFile)
+		: _crashDocId(crashDocId), _crashedFile(crashedFile), _startsFile(startsFile) {}
+protected:
+	virtual void setWorkerId(int worker_id) {
+		DiskQueueDriver::setWorkerId(worker_id);
+		std::ofstream out(_startsFile.c_str(), std::ios::app);
+		out << worker_id << "\n";
+	}
+	virtual double process(Element_ptr elt) {
+		if (elt->uid == _crashDocId && !boost::filesystem::exists(_crashedFile)) {
+			std::ofstream(_crashedFile.c_str()).close();
+			kill(getpid(), SIGKILL);
+		}
+		return DiskQueueDriver::process(elt);
+	}
+private:
+	std::string _crashDocId;
+	std::string _crashedFile;
+	std::string _startsFile;
+};
+#endif
+
+struct QueueDriverWorkerPoolFixture : public SerifTestFixture {
+	std::string tempDir;
+	std::string src;
+	std::string dst;
+
+	QueueDriverWorkerPoolFixture() {
+		tempDir = makeTempDir();
+		src = tempDir + SERIF_PATH_SEP + "src";
+		dst = tempDir + SERIF_PATH_SEP + "dst";
+		boost::filesystem::create_directory(src);
+		ParamReader::setParam("disk_queue_src", src.c_str());
+		ParamReader::setParam("disk_queue_dst", dst.c_str());
+		ParamReader::setParam("disk_queue_max_dst_files", "0");
+		ParamReader::setParam("disk_queue_worker_ext", "");
+		ParamReader::setParam("disk_queue_timer_file", "");
+		ParamReader::setParam("disk_queue_quit_file", "");
+		ParamReader::setParam("queue_driver_workers", "2");
+		ParamReader::setParam("source_format", "sgm");
+		ParamReader::setParam("output_format", "serifxml");
+		ParamReader::setParam("start_stage", Stage::getStartStage().getName());
+		ParamReader::setParam("end_stage", "tokens");
+	}
+
+	~QueueDriverWorkerPoolFixture() {
+		boost::filesystem::remove_all(tempDir);
+	}
+
+	/** Add a document to the source queue, and return its document id.
+	  * The document is written under a temporary name and then renamed,
+	  * as a queue writer should. */
+	std::string addDocument(int doc_num) {
+		std::ostringstream docId;
+		docId << "doc" << doc_num << ".sgm";
+		std::string tempFile = tempDir + SERIF_PATH_SEP + docId.str();
+		{
+			std::ofstream out(tempFile.c_str());
+			out << "<DOC>\n<DOCID>" << docId.str() << "</DOCID>\n<TEXT>\n"
+				<< "Document number " << doc_num << " was written by the queue driver test.\n"
+				<< "</TEXT>\n</DOC>\n";
+		}
+		boost::filesystem::rename(tempFile, readyFile(docId.str()));
+		return docId.str();
+	}
+
+	std::string readyFile(const std::string &docId) const {
+		return src + SERIF_PATH_SEP + docId + ".ready";
+	}
+
+	/** Run a single DiskQueueDriver in a thread, let it go idle for
+	  * idle_msec, add a document, and return the time (in msec) until the
+	  * driver takes the document from the source queue, or -1 if it does
+	  * not within timeout_msec. */
+	double timeIdleWakeup(int idle_msec, int timeout_msec) {
+		std::string quitFile = tempDir + SERIF_PATH_SEP + "quit";
+		ParamReader::setParam("queue_driver_workers", "1");
+		ParamReader::setParam("disk_queue_quit_file", quitFile.c_str());
+		DiskQueueDriver queueDriver;
+		boost::thread thread(boost::bind(&DiskQueueDriver::processQueue, &queueDriver));
+		boost::this_thread::sleep(boost::posix_time::milliseconds(idle_msec));
+
+		std::string ready = readyFile(addDocument(0));
+		boost::posix_time::ptime start = boost::posix_time::microsec_clock::universal_time();
+		double msec = -1;
+		while (true) {
+			double elapsed = static_cast<double>(
+				(boost::posix_time::microsec_clock::universal_time() - start).total_microseconds()) / 1000;
+			if (!boost::filesystem::exists(ready)) {
+				msec = elapsed;
+				break;
+			}
+			if (elapsed > timeout_msec)
+				break;
+			boost::this_thread::sleep(boost::posix_time::milliseconds(1));
+		}
+
+		std::ofstream(quitFile.c_str()).close();
+		thread.join();
+		return msec;
+	}
+
+	static size_t countLines(const std::string &filename) {
+		std::ifstream in(filename.c_str());
+		std::string line;
+		size_t n = 0;
+		while (std::getline(in, line))
+			++n;
+		return n;
+	}
+};
+
+void queue_driver_worker_pool_recovers_crash() {
+#ifdef _WIN32
+	BOOST_TEST_MESSAGE("queue_driver_workers is not supported on Windows; skipping");
+#else
+	QueueDriverWorkerPoolFixture f;
+	const int n_documents = 6;
+	std::vector<std::string> docIds;
+	for (int i = 0; i < n_documents; ++i)
+		docIds.push_back(f.addDocument(i));
+	// The workers quit once the queue is empty.
+	std::ofstream((f.src + SERIF_PATH_SEP + "done").c_str()).close();
+
+	std::string crashedFile = f.tempDir + SERIF_PATH_SEP + "crashed";
+	std::string startsFile = f.tempDir + SERIF_PATH_SEP + "starts";
+	{
+		CrashingDiskQueueDriver queueDriver(docIds[2], crashedFile, startsFile);
+		queueDriver.processQueue();
+	}
+
+	BOOST_CHECK_MESSAGE(boost::filesystem::exists(crashedFile), "No worker was killed");
+	BOOST_CHECK_MESSAGE(f.countLines(startsFile) >= 3, "The killed worker was not restarted");
+	BOOST_CHECK(!boost::filesystem::exists(f.src + SERIF_PATH_SEP + docIds[2] + ".failed_twice"));
+	BOOST_FOREACH(const std::string &docId, docIds) {
+		BOOST_CHECK_MESSAGE(boost::filesystem::exists(f.dst + SERIF_PATH_SEP + docId + ".ready"),
+			"No output for " << docId);
+	}
+	// Nothing should be left in the source queue except the done file.
+	boost::filesystem::directory_iterator endItr;
+	for (boost::filesystem::directory_iterator itr(f.src); itr != endItr; ++itr) {
+		std::string filename = BOOST_FILESYSTEM_DIR_ITERATOR_GET_FILENAME(itr);
+		BOOST_CHECK_MESSAGE(filename == "done", "Unexpected file left in the source queue: " << filename);
+	}
+#endif
+}
+
+void disk_queue_driver_wakes_on_new_document() {
+#if !defined(__linux__)
+	BOOST_TEST_MESSAGE("DiskQueueDriver only uses inotify on Linux; skipping");
+#else
+	QueueDriverWorkerPoolFixture f;
+	// After 3 seconds of idling, the driver polls about every 800 msec.
+	double msec = f.timeIdleWakeup(3000, 10000);
+	BOOST_TEST_MESSAGE("Idle DiskQueueDriver (inotify) took " << msec << " msec to start a new document");
+	BOOST_CHECK(msec >= 0);
+	BOOST_CHECK_MESSAGE(msec < 250, "Idle DiskQueueDriver took " << msec << " msec to start a new document");
+#endif
+}
+
+void disk_queue_driver_polls_without_inotify() {
+	QueueDriverWorkerPoolFixture f;
+	ParamReader::setParam("disk_queue_use_inotify", "false");
+	double msec = f.timeIdleWakeup(3000, 10000);
+	BOOST_TEST_MESSAGE("Idle DiskQueueDriver (polling) took " << msec << " msec to start a new document");
+	BOOST_CHECK_MESSAGE(msec >= 0 && msec < 7000, "Polling DiskQueueDriver did not pick up a new document");
+}
@@ -0,0 +1,146 @@
+#include "Generic/common/HeapStatus.h"
+#include "Generic/common/ParamReader.h"
+#include "Generic/common/XMLUtil.h"
+#include "Generic/driver/DocumentDriver.h"
+#include "Generic/driver/SessionProgram.h"
+#include "Generic/driver/Stage.h"
+#include "Generic/reader/DocumentReader.h"
+#include "Generic/results/SerifXMLResultCollector.h"
+#include "Generic/state/XMLSerializedDocTheory.h"
+#include "Generic/theories/DocTheory.h"
+#include "Generic/theories/Document.h"
+#include "Generic/theories/SentenceTheoryBeam.h"
+#include "EnglishTest/test/SerifTestUtil.h"
+
+#pragma warning(push)
+#pragma warning(disable : 4266)
+#include <boost/test/unit_test.hpp>
+#pragma warning(pop)
+#include <boost/scoped_ptr.hpp>
+
+#include <sstream>
+#include <string>
+
+/** Tests for the streaming, memory-bounded mode for long documents
+  * (streaming_doc_theory).
+  *
+  * streaming_doc_theory_matches_best_theories runs a long document (the
+  * document named by the streaming_test_document parameter, or else
+  * several copies of the built-in test document's text) through the
+  * output stage, once with streaming_doc_theory and once without.  It
+  * checks that:
+  *   - Every sentence in the streaming output has at most one theory.
+  *   - The streaming output is the same as the normal output with each
+  *     sentence's beam cut down to its best theory.
+  *   - The peak resident memory used while processing the document is
+  *     no higher with streaming_doc_theory.  Both drivers load their
+  *     models and process a short document before anything is measured;
+  *     the streaming driver is measured first, so any heap memory that it
+  *     leaves behind can only lower the other driver's measurement.  (This
+  *     check is skipped if resident memory can't be measured.) */
+struct StreamingDocTheoryFixture : public SerifTestFixture {
+
+	/** Create a document driver (with the current params), load its
+	  * models, and return it.  The caller takes ownership. */
+	static DocumentDriver *loadDocumentDriver() {
+		DocumentDriver *documentDriver = _new DocumentDriver();
+		documentDriver->giveDocumentReader(DocumentReader::build("sgm"));
+		for (Stage stage = Stage::getStartStage(); stage <= Stage("output"); ++stage)
+			documentDriver->loadModelsForStage(stage);
+		return documentDriver;
+	}
+
+	/** Run the given document driver on the given document (in sgm format)
+	  * through the output stage, and return the SerifXML.  If peakMemory is
+	  * not NULL, then set it to the largest amount by which the process's
+	  * resident memory grew while processing the document. */
+	static std::wstring runDocument(DocumentDriver *documentDriver, const std::wstring &document, size_t *peakMemory=0) {
+		SerifXMLResultCollector resultCollector;
+		SessionProgram sessionProgram;
+		sessionProgram.setStageRange(Stage::getStartStage(), Stage("output"));
+		documentDriver->beginBatch(&sessionProgram, &resultCollector);
+		HeapStatus::releaseFreeMemory();
+		size_t start_memory = HeapStatus::getResidentMemory();
+		HeapStatus::resetPeakResidentMemory();
+		std::wstring results;
+		documentDriver->runOnString(document.c_str(), &results);
+		size_t peak_memory = HeapStatus::getPeakResidentMemory();
+		documentDriver->endBatch();
+		if (peakMemory)
+			*peakMemory = (peak_memory > start_memory) ? (peak_memory - start_memory) : 0;
+		return results;
+	}
+
+	/** Return the document named by the streaming_test_document parameter,
+	  * or else a document with n_copies copies of the built-in test
+	  * document's text. */
+	static std::wstring getLongDocument(int n_copies) {
+		std::wstring document = getTestDocument("streaming_test_document");
+		if (!ParamReader::getParam("streaming_test_document").empty())
+			return document;
+		size_t text_start = document.find(L"<TEXT>\n") + 7;
+		size_t text_end = document.find(L"</TEXT>");
+		std::wstring text = document.substr(text_start, text_end - text_start);
+		for (int i = 1; i < n_copies; ++i)
+			document.insert(text_end, L"\n" + text);
+		return document;
+	}
+
+	/** Load the given SerifXML, cut each sentence's beam down to its best
+	  * theory, and return the result as SerifXML.  If max_theories is not
+	  * NULL, then set it to the largest number of theories in any beam
+	  * before pruning. */
+	static std::string toBestTheorySerifXML(const std::wstring &serifXML, int *max_theories=0) {
+		std::pair<Document*, DocTheory*> docPair = SerifXML::XMLSerializedDocTheory(
+			XMLUtil::loadXercesDOMFromString(serifXML.c_str())).generateDocTheory();
+		if (max_theories)
+			*max_theories = 0;
+		for (int i = 0; i < docPair.second->getNSentences(); ++i) {
+			SentenceTheoryBeam *beam = docPair.second->getSentenceTheoryBeam(i);
+			if (beam == 0)
+				continue;
+			if (max_theories && beam->getNTheories() > *max_theories)
+				*max_theories = beam->getNTheories();
+			beam->pruneToBestTheory();
+		}
+		std::ostringstream out;
+		SerifXML::XMLSerializedDocTheory(docPair.second).save(out);
+		delete docPair.second;
+		delete docPair.first;
+		return out.str();
+	}
+};
+
+void streaming_doc_theory_matches_best_theories() {
+	StreamingDocTheoryFixture f;
+	std::wstring shortDocument = f.getTestDocument("streaming_test_short_document");
+	std::wstring longDocument = f.getLongDocument(20);
+
+	ParamReader::setParam("streaming_doc_theory", "true");
+	boost::scoped_ptr<DocumentDriver> streamingDriver(f.loadDocumentDriver());
+	ParamReader::setParam("streaming_doc_theory", "false");
+	boost::scoped_ptr<DocumentDriver> normalDriver(f.loadDocumentDriver());
+	f.runDocument(streamingDriver.get(), shortDocument);
+	f.runDocument(normalDriver.get(), shortDocument);
+
+	size_t streamingMemory = 0, normalMemory = 0;
+	std::wstring streamingXML = f.runDocument(streamingDriver.get(), longDocument, &streamingMemory);
+	std::wstring normalXML = f.runDocument(normalDriver.get(), longDocument, &normalMemory);
+	BOOST_TEST_MESSAGE("Peak resident memory growth: " << streamingMemory / 1024 << " KB with streaming_doc_theory; "
+		<< normalMemory / 1024 << " KB without");
+
+	int streaming_max_theories = 0, normal_max_theories = 0;
+	std::string streamingBest = f.toBestTheorySerifXML(streamingXML, &streaming_max_theories);
+	std::string normalBest = f.toBestTheorySerifXML(normalXML, &normal_max_theories);
+	BOOST_TEST_MESSAGE("Largest beam: " << streaming_max_theories << " theories with streaming_doc_theory; "
+		<< normal_max_theories << " without");
+	BOOST_CHECK(!normalXML.empty());
+	BOOST_CHECK_LE(streaming_max_theories, 1);
+	BOOST_CHECK_MESSAGE(streamingBest == normalBest,
+		"SerifXML with streaming_doc_theory differs from the best theories of the normal output");
+	if (HeapStatus::getResidentMemory() != 0) {
+		BOOST_CHECK_MESSAGE(streamingMemory <= normalMemory,
+			"Peak resident memory growth with streaming_doc_theory (" << streamingMemory / 1024
+			<< " KB) is higher than without it (" << normalMemory / 1024 << " KB)");
+	}
+}
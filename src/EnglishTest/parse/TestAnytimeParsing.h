@@ -0,0 +1,162 @@
+#include "Generic/common/OutputUtil.h"
+#include "Generic/common/ParamReader.h"
+#include "Generic/common/Profiler.h"
+#include "Generic/common/XMLUtil.h"
+#include "Generic/driver/Stage.h"
+#include "Generic/parse/ParserTags.h"
+#include "Generic/state/XMLSerializedDocTheory.h"
+#include "Generic/theories/Document.h"
+#include "Generic/theories/DocTheory.h"
+#include "Generic/theories/Parse.h"
+#include "Generic/theories/SentenceTheory.h"
+#include "Generic/theories/SynNode.h"
+#include "EnglishTest/test/SerifTestUtil.h"
+
+#pragma warning(push)
+#pragma warning(disable : 4266)
+#include <boost/test/unit_test.hpp>
+#pragma warning(pop)
+#include <boost/algorithm/string/trim.hpp>
+
+#include <cstdio>
+#include <string>
+
+/** Tests for the parser's anytime mode (see the parser_anytime_mode
+  * parameter).  The input document (in sgm format) is specified by the
+  * anytime_parsing_test_document parameter; if it is not specified, then a
+  * short built-in document is used.  The tests turn on profiling, and use
+  * the parser's timeouts and anytime_fallbacks counters to check which
+  * path each sentence took.
+  *
+  * anytime_parsing_timeout_fallbacks runs the parse stage with a time limit
+  * of zero (max_parser_seconds), so that every sentence of more than one
+  * word times out.  Without anytime mode, each of those sentences must get
+  * the default (flat FRAGMENTS) parse; with it, each must get a parse from
+  * the anytime fallback.  Either way, every parse must be a tree that spans
+  * its whole sentence.
+  *
+  * anytime_parsing_off_output_unchanged checks that when no sentence times
+  * out, turning on anytime mode does not change the output, so that
+  * parser_anytime_mode only matters for sentences that hit the limit.  If
+  * the anytime_parsing_reference_output parameter names the SerifXML output
+  * (through the parse stage) of a parser without anytime mode, then it also
+  * checks that the output without anytime mode is identical to it. */
+struct AnytimeParsingFixture : public SerifTestFixture {
+	std::string reportFile;
+
+	AnytimeParsingFixture() {
+		OutputUtil::NamedTempFile tempFile = OutputUtil::makeNamedTempFile();
+		tempFile.second->close();
+		reportFile = tempFile.first;
+	}
+
+	~AnytimeParsingFixture() {
+		remove(reportFile.c_str());
+		resetParams();
+		Profiler::configure();
+	}
+
+	struct Run {
+		std::wstring results;
+		long n_timeouts;
+		long n_anytime_fallbacks;
+	};
+
+	static long getChartFillCounter(const char *counter) {
+		return Profiler::getCounter("document/sentences/parse/chart-fill", counter);
+	}
+
+	/** Run Serif through the parse stage, and return the SerifXML along
+	  * with the number of timeouts and anytime fallbacks. */
+	Run runParser(const std::wstring &document, bool anytime_mode, const char *max_parser_seconds) {
+		ParamReader::setParam("parser_anytime_mode", anytime_mode ? "true" : "false");
+		ParamReader::setParam("max_parser_seconds", max_parser_seconds);
+		ParamReader::setParam("profiling_report_file", reportFile.c_str());
+		long timeouts_before = getChartFillCounter("timeouts");
+		long fallbacks_before = getChartFillCounter("anytime_fallbacks");
+		Run run;
+		run.results = runSerif(document, Stage("parse"));
+		run.n_timeouts = getChartFillCounter("timeouts") - timeouts_before;
+		run.n_anytime_fallbacks = getChartFillCounter("anytime_fallbacks") - fallbacks_before;
+		return run;
+	}
+
+	/** Check that the given node's children are contiguous and together
+	  * span the node, all the way down to the terminals. */
+	static bool isSpanningTree(const SynNode *node) {
+		if (node->isTerminal())
+			return true;
+		int next_token = node->getStartToken();
+		for (int i = 0; i < node->getNChildren(); ++i) {
+			const SynNode *child = node->getChild(i);
+			if (child->getStartToken() != next_token || !isSpanningTree(child))
+				return false;
+			next_token = child->getEndToken() + 1;
+		}
+		return next_token == node->getEndToken() + 1;
+	}
+
+	/** Check every sentence's parse in the given SerifXML, and return the
+	  * number of sentences with more than one word.  If requireFragments is
+	  * true, then also check that each of those has a FRAGMENTS root. */
+	static int checkParses(const std::wstring &serifXML, bool requireFragments) {
+		std::pair<Document*, DocTheory*> docPair =
+			SerifXML::XMLSerializedDocTheory(XMLUtil::loadXercesDOMFromString(serifXML.c_str())).generateDocTheory();
+		int n_multi_word_sentences = 0;
+		for (int i = 0; i < docPair.second->getNSentences(); ++i) {
+			const Parse *parse = docPair.second->getSentenceTheory(i)->getPrimaryParse();
+			BOOST_REQUIRE(parse != 0);
+			const SynNode *root = parse->getRoot();
+			BOOST_CHECK_EQUAL(root->getStartToken(), 0);
+			BOOST_CHECK_EQUAL(root->getEndToken(), parse->getTokenSequence()->getNTokens() - 1);
+			BOOST_CHECK_MESSAGE(isSpanningTree(root), "The parse of sentence " << i << " is not a spanning tree");
+			if (root->getNTerminals() > 1) {
+				++n_multi_word_sentences;
+				if (requireFragments)
+					BOOST_CHECK_MESSAGE(root->getTag() == ParserTags::FRAGMENTS,
+						"The parse of sentence " << i << " is not the default parse");
+			}
+		}
+		delete docPair.second;
+		delete docPair.first;
+		return n_multi_word_sentences;
+	}
+};
+
+void anytime_parsing_timeout_fallbacks() {
+	AnytimeParsingFixture f;
+	std::wstring document = f.getTestDocument("anytime_parsing_test_document");
+
+	AnytimeParsingFixture::Run defaultParses = f.runParser(document, false, "0");
+	int n_multi_word_sentences = f.checkParses(defaultParses.results, true);
+	BOOST_CHECK(defaultParses.n_timeouts > 0);
+	BOOST_CHECK(defaultParses.n_timeouts <= n_multi_word_sentences);
+	BOOST_CHECK_EQUAL(defaultParses.n_anytime_fallbacks, 0);
+
+	AnytimeParsingFixture::Run anytimeParses = f.runParser(document, true, "0");
+	f.checkParses(anytimeParses.results, false);
+	BOOST_CHECK_EQUAL(anytimeParses.n_timeouts, defaultParses.n_timeouts);
+	BOOST_CHECK_EQUAL(anytimeParses.n_anytime_fallbacks, anytimeParses.n_timeouts);
+}
+
+void anytime_parsing_off_output_unchanged() {
+	AnytimeParsingFixture f;
+	std::wstring document = f.getTestDocument("anytime_parsing_test_document");
+
+	// The default time limit (100 minutes), which no sentence should reach.
+	AnytimeParsingFixture::Run normal = f.runParser(document, false, "6000");
+	AnytimeParsingFixture::Run anytime = f.runParser(document, true, "6000");
+	BOOST_REQUIRE_EQUAL(normal.n_timeouts, 0);
+	BOOST_REQUIRE_EQUAL(anytime.n_timeouts, 0);
+	BOOST_CHECK(!normal.results.empty());
+	BOOST_CHECK_MESSAGE(anytime.results == normal.results,
+		"Parser output with parser_anytime_mode differs from the output without it");
+
+	// Optionally compare against the output of a parser built without
+	// anytime mode, on the same document and models.
+	std::string referenceFile = ParamReader::getParam("anytime_parsing_reference_output");
+	if (!referenceFile.empty()) {
+		BOOST_CHECK_MESSAGE(boost::trim_right_copy(normal.results) == boost::trim_right_copy(f.readDocument(referenceFile)),
+			"Parser output differs from the reference output in " << referenceFile);
+	}
+}
@@ -0,0 +1,208 @@
+#include "Generic/common/BoostUtil.h"
+#include "Generic/common/InternalInconsistencyException.h"
+#include "Generic/common/MappedModelImage.h"
+#include "Generic/common/NgramScoreTable.h"
+#include "Generic/common/OutputUtil.h"
+#include "Generic/common/ParamReader.h"
+#include "Generic/common/UnexpectedInputException.h"
+#include "Generic/common/UTF8InputStream.h"
+#include "Generic/common/UTF8Token.h"
+#include "Generic/driver/Stage.h"
+#include "Generic/parse/ChartDecoder.h"
+#include "EnglishTest/test/SerifTestUtil.h"
+
+#pragma warning(push)
+#pragma warning(disable : 4266)
+#include <boost/test/unit_test.hpp>
+#pragma warning(pop)
+#include <boost/filesystem.hpp>
+#include <boost/scoped_ptr.hpp>
+#include <boost/shared_ptr.hpp>
+
+#include <cstdio>
+#include <ctime>
+#include <fstream>
+#include <limits>
+#include <string>
+
+/** Tests for the parser's binary model image (use_parser_model_image),
+  * which is compiled from the text model files named by parser_model.
+  *
+  * The image is always read from <parser_model>.image, so the fixture
+  * makes a temporary model directory that links to (or, if links can not
+  * be made, copies) the text model files, and compiles the image there.
+  * The lowercase and uppercase parser models are turned off, since they
+  * would need images of their own.
+  *
+  * parser_model_image_matches_text_model runs Serif through the parse
+  * stage with the text model files and with the image, and checks that
+  * the output is the same.  It also checks that recompiling the image does
+  * not disturb a mapping of the old image.
+  *
+  * parser_model_image_staleness checks that an image which is older than
+  * its text model files is rejected.
+  *
+  * ngram_table_image_is_read_only checks that an NgramScoreTable that is
+  * read from an image can be used for lookups, but that modifying or
+  * printing it throws.  (It does not need a parser model.)
+  *
+  * ngram_table_reads_text_format reads an NgramScoreTable from text, with
+  * and without UTF8InputStream's file buffer.  The entries are laid out
+  * in several ways that the parser allows (one or several to a line,
+  * split across lines, with CRLF line ends), and one is ill-formed.  (It
+  * does not need a parser model either.) */
+struct ParserModelImageFixture : public SerifTestFixture {
+	boost::filesystem::path modelDir;
+	std::string modelPrefix;
+	std::string imageFile;
+
+	ParserModelImageFixture() {
+		boost::filesystem::path textPrefix(ParamReader::getRequiredParam("parser_model"));
+		std::string textName = BOOST_FILESYSTEM_PATH_GET_FILENAME(textPrefix);
+		boost::filesystem::path textDir = textPrefix.has_parent_path() ? textPrefix.parent_path() : boost::filesystem::path(".");
+		modelDir = makeTempDir();
+		for (boost::filesystem::directory_iterator it(textDir);
+			 it != boost::filesystem::directory_iterator(); ++it)
+		{
+			std::string name = BOOST_FILESYSTEM_DIR_ITERATOR_GET_FILENAME(it);
+			if (name.compare(0, textName.size(), textName) != 0 || name == textName + ".image")
+				continue;
+			try {
+				boost::filesystem::create_symlink(boost::filesystem::system_complete(it->path()), modelDir / name);
+			} catch (boost::filesystem::filesystem_error &) {
+				boost::filesystem::copy_file(it->path(), modelDir / name);
+			}
+		}
+		modelPrefix = BOOST_FILESYSTEM_PATH_AS_STRING((modelDir / textName));
+		imageFile = modelPrefix + ".image";
+		ParamReader::setParam("parser_model", modelPrefix.c_str());
+		ParamReader::unsetParam("lowercase_parser_model");
+		ParamReader::unsetParam("uppercase_parser_model");
+		ChartDecoder::compileModelImage(modelPrefix.c_str(), imageFile.c_str());
+	}
+
+	~ParserModelImageFixture() {
+		boost::filesystem::remove_all(modelDir);
+	}
+
+	/** Return a checksum of the first block of the given image's kernels
+	  * section (which reads every byte of the block). */
+	static size_t checksumKernels(boost::shared_ptr<const MappedModelImage> image) {
+		MappedModelImage::Section kernelSection(image, "kernels");
+		size_t n_bytes = 0;
+		const char *block = kernelSection.nextBlock<char>(n_bytes);
+		size_t checksum = n_bytes;
+		for (size_t i = 0; i < n_bytes; ++i)
+			checksum = checksum * 31 + static_cast<unsigned char>(block[i]);
+		return checksum;
+	}
+
+	std::wstring runParser(const std::wstring &document, bool use_image) {
+		ParamReader::setParam("use_parser_model_image", use_image ? "true" : "false");
+		return runSerif(document, Stage("parse"));
+	}
+};
+
+void parser_model_image_matches_text_model() {
+	ParserModelImageFixture f;
+	std::wstring document = f.getTestDocument("parser_model_image_test_document");
+
+	std::wstring textResults = f.runParser(document, false);
+	std::wstring imageResults = f.runParser(document, true);
+	BOOST_CHECK(!textResults.empty());
+	BOOST_CHECK_MESSAGE(imageResults == textResults,
+		"SerifXML output with the parser model image differs from output with the text model files");
+
+	// Recompile the image while the old one is mapped.  The old mapping
+	// must still be readable, and the new image must give the same output.
+	boost::shared_ptr<const MappedModelImage> oldImage = MappedModelImage::open(f.imageFile);
+	size_t checksum = f.checksumKernels(oldImage);
+	ChartDecoder::compileModelImage(f.modelPrefix.c_str(), f.imageFile.c_str());
+	BOOST_CHECK_EQUAL(f.checksumKernels(oldImage), checksum);
+	oldImage.reset();
+	BOOST_CHECK_MESSAGE(f.runParser(document, true) == textResults,
+		"SerifXML output with the recompiled parser model image differs from output with the text model files");
+}
+
+void parser_model_image_staleness() {
+	ParserModelImageFixture f;
+	BOOST_CHECK_NO_THROW(ChartDecoder::checkModelImageIsCurrent(f.modelPrefix.c_str(), f.imageFile.c_str()));
+
+	// Make the image older than every text model file.
+	boost::filesystem::last_write_time(f.imageFile, static_cast<std::time_t>(0));
+	BOOST_CHECK_THROW(ChartDecoder::checkModelImageIsCurrent(f.modelPrefix.c_str(), f.imageFile.c_str()),
+		UnexpectedInputException);
+
+	boost::filesystem::last_write_time(f.imageFile, std::time(0));
+	BOOST_CHECK_NO_THROW(ChartDecoder::checkModelImageIsCurrent(f.modelPrefix.c_str(), f.imageFile.c_str()));
+}
+
+void ngram_table_image_is_read_only() {
+	Symbol ngram[1] = {Symbol(L"word")};
+	Symbol other[1] = {Symbol(L"other")};
+	NgramScoreTable table(1, 5);
+	table.add(ngram, 3);
+	MappedModelImageWriter writer;
+	writer.beginSection("table");
+	table.writeImage(writer);
+	OutputUtil::NamedTempFile tempFile = OutputUtil::makeNamedTempFile();
+	tempFile.second->close();
+	writer.write(tempFile.first);
+	{
+		MappedModelImage::Section section(MappedModelImage::open(tempFile.first), "table");
+		NgramScoreTable imageTable(1, section);
+		BOOST_CHECK_EQUAL(imageTable.lookup(ngram), 3.0f);
+		BOOST_CHECK_EQUAL(imageTable.lookup(other), 0.0f);
+		BOOST_CHECK_THROW(imageTable.add(other), InternalInconsistencyException);
+		BOOST_CHECK_THROW(imageTable.add(ngram, 1), InternalInconsistencyException);
+		BOOST_CHECK_THROW(imageTable.prune(0), InternalInconsistencyException);
+		BOOST_CHECK_THROW(imageTable.reset(), InternalInconsistencyException);
+		std::string printFile = tempFile.first + ".txt";
+		BOOST_CHECK_THROW(imageTable.print(printFile.c_str()), InternalInconsistencyException);
+		BOOST_CHECK_EQUAL(imageTable.lookup(ngram), 3.0f);
+	}
+	remove(tempFile.first.c_str());
+}
+
+void ngram_table_reads_text_format() {
+	OutputUtil::NamedTempFile tempFile = OutputUtil::makeNamedTempFile();
+	std::ofstream &out = *tempFile.second;
+	out << "5\r\n";
+	out << "((a b) 1.5)\r\n";
+	out << "((c d) inf) ((e f) -2)\n";
+	out << "(\n(g\nh)\n  7e-3 )\n";
+	out << "  ((caf\xc3\xa9 \xe6\xbc\xa2\xe5\xad\x97)\t-0.25)\n";
+	out << "next 1\n";
+	out.close();
+
+	OutputUtil::NamedTempFile badFile = OutputUtil::makeNamedTempFile();
+	*badFile.second << "2\n((a b) 1)\n((c d) 2\n";
+	badFile.second->close();
+
+	for (int i = 0; i < 2; ++i) {
+		UTF8InputStream::setUseFileBuffer(i == 0);
+		boost::scoped_ptr<UTF8InputStream> in(UTF8InputStream::build(tempFile.first.c_str()));
+		NgramScoreTable table(2, *in);
+		BOOST_CHECK_EQUAL(table.get_size(), 5);
+		Symbol ab[2] = {Symbol(L"a"), Symbol(L"b")};
+		Symbol cd[2] = {Symbol(L"c"), Symbol(L"d")};
+		Symbol ef[2] = {Symbol(L"e"), Symbol(L"f")};
+		Symbol gh[2] = {Symbol(L"g"), Symbol(L"h")};
+		Symbol cafe[2] = {Symbol(L"caf\x00e9"), Symbol(L"\x6f22\x5b57")};
+		BOOST_CHECK_EQUAL(table.lookup(ab), 1.5f);
+		BOOST_CHECK_EQUAL(table.lookup(cd), std::numeric_limits<float>::max());
+		BOOST_CHECK_EQUAL(table.lookup(ef), -2.0f);
+		BOOST_CHECK_EQUAL(table.lookup(gh), 7e-3f);
+		BOOST_CHECK_EQUAL(table.lookup(cafe), -0.25f);
+		// The stream is left at the line after the last entry.
+		UTF8Token token;
+		*in >> token;
+		BOOST_CHECK(wcscmp(token.chars(), L"next") == 0);
+
+		boost::scoped_ptr<UTF8InputStream> badIn(UTF8InputStream::build(badFile.first.c_str()));
+		BOOST_CHECK_THROW(NgramScoreTable(2, *badIn), UnexpectedInputException);
+	}
+	UTF8InputStream::setUseFileBuffer(ParamReader::getOptionalTrueFalseParamWithDefaultVal("use_utf8_file_buffer", true));
+	remove(tempFile.first.c_str());
+	remove(badFile.first.c_str());
+}
@@ -0,0 +1,103 @@
+#include "Generic/common/GenericTimer.h"
+#include "Generic/common/OutputUtil.h"
+#include "Generic/common/ParamReader.h"
+#include "Generic/driver/DocumentDriver.h"
+#include "Generic/driver/SessionProgram.h"
+#include "Generic/driver/Stage.h"
+#include "Generic/parse/DefaultParser.h"
+#include "Generic/reader/DocumentReader.h"
+#include "Generic/results/SerifXMLResultCollector.h"
+#include "EnglishTest/test/SerifTestUtil.h"
+
+#pragma warning(push)
+#pragma warning(disable : 4266)
+#include <boost/test/unit_test.hpp>
+#pragma warning(pop)
+
+#include <cstdio>
+#include <string>
+
+/** Tests for the parser's shared cache image (probs_cache_image), which
+  * is compiled from the cache pre-load files in probs_cache_in_path; if
+  * probs_cache_in_path is not specified, then the test is skipped.  The
+  * input document (in sgm format) is specified by the
+  * shared_parser_cache_test_document parameter; if it is not specified,
+  * then a short built-in document is used.
+  *
+  * shared_parser_cache_first_document_latency compiles the pre-load files
+  * into a cache image, and then runs Serif through the parse stage on the
+  * document twice in a row: with no preloaded cache, with the pre-load
+  * files, and with the cache image.  It checks that using the cache image
+  * does not change the output, and reports the startup-to-first-document
+  * latency and the time for the second (warm) document in each case. */
+struct SharedParserCacheFixture : public SerifTestFixture {
+
+	struct Run {
+		double first_document_msec; // including startup
+		double second_document_msec;
+		std::wstring results;
+	};
+
+	/** Run Serif through the parse stage on the given document twice, and
+	  * return the SerifXML for the first run. */
+	static Run runSerifTwice(const std::wstring &document, const std::string &cache_in_path, const std::string &cache_image) {
+		ParamReader::setParam("probs_cache_in_path", cache_in_path.c_str());
+		ParamReader::setParam("probs_cache_image", cache_image.c_str());
+		Run run;
+		GenericTimer firstTimer, secondTimer;
+		std::wstring second_results;
+
+		firstTimer.startTimer();
+		DocumentDriver documentDriver;
+		documentDriver.giveDocumentReader(DocumentReader::build("sgm"));
+		SerifXMLResultCollector resultCollector;
+		SessionProgram sessionProgram;
+		sessionProgram.setStageRange(Stage::getStartStage(), Stage("parse"));
+		documentDriver.beginBatch(&sessionProgram, &resultCollector);
+		documentDriver.runOnString(document.c_str(), &run.results);
+		firstTimer.stopTimer();
+
+		secondTimer.startTimer();
+		documentDriver.runOnString(document.c_str(), &second_results);
+		secondTimer.stopTimer();
+		documentDriver.endBatch();
+
+		run.first_document_msec = firstTimer.getTime();
+		run.second_document_msec = secondTimer.getTime();
+		return run;
+	}
+};
+
+void shared_parser_cache_first_document_latency() {
+	std::string cache_in_path = ParamReader::getParam("probs_cache_in_path");
+	if (cache_in_path.empty()) {
+		BOOST_TEST_MESSAGE("probs_cache_in_path not specified; skipping");
+		return;
+	}
+	SharedParserCacheFixture f;
+	std::wstring document = f.getTestDocument("shared_parser_cache_test_document");
+
+	OutputUtil::NamedTempFile tempFile = OutputUtil::makeNamedTempFile();
+	tempFile.second->close();
+	std::string cache_image = tempFile.first;
+	{
+		ParamReader::setParam("probs_cache_image", "");
+		DefaultParser parser;
+		parser.writeCacheImage(cache_image.c_str());
+	}
+
+	SharedParserCacheFixture::Run cold = f.runSerifTwice(document, "", "");
+	SharedParserCacheFixture::Run preloaded = f.runSerifTwice(document, cache_in_path, "");
+	SharedParserCacheFixture::Run shared = f.runSerifTwice(document, "", cache_image);
+	BOOST_CHECK(!cold.results.empty());
+	BOOST_CHECK_MESSAGE(shared.results == cold.results,
+		"SerifXML output with the shared cache image differs from output without it");
+
+	BOOST_TEST_MESSAGE("No preloaded cache: " << cold.first_document_msec << " msec to first document, "
+		<< cold.second_document_msec << " msec for second document");
+	BOOST_TEST_MESSAGE("Pre-load files: " << preloaded.first_document_msec << " msec to first document, "
+		<< preloaded.second_document_msec << " msec for second document");
+	BOOST_TEST_MESSAGE("Shared cache image: " << shared.first_document_msec << " msec to first document, "
+		<< shared.second_document_msec << " msec for second document");
+	remove(cache_image.c_str());
+}
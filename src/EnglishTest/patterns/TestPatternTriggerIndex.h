@@ -0,0 +1,116 @@
+#include "Generic/common/ParamReader.h"
+#include "Generic/common/Sexp.h"
+#include "Generic/common/XMLUtil.h"
+#include "Generic/driver/Stage.h"
+#include "Generic/patterns/PatternMatcher.h"
+#include "Generic/patterns/PatternSet.h"
+#include "Generic/patterns/features/PatternFeature.h"
+#include "Generic/patterns/features/PatternFeatureSet.h"
+#include "Generic/state/XMLSerializedDocTheory.h"
+#include "Generic/theories/Document.h"
+#include "Generic/theories/DocTheory.h"
+#include "EnglishTest/test/SerifTestUtil.h"
+
+#pragma warning(push)
+#pragma warning(disable : 4266)
+#include <boost/test/unit_test.hpp>
+#pragma warning(pop)
+#include <boost/make_shared.hpp>
+
+#include <sstream>
+#include <string>
+#include <vector>
+
+/** Checks that the PatternTriggerIndex (see the use_pattern_trigger_index
+  * parameter) does not change which sentence-level snippets a PatternSet
+  * finds.  The pattern set is specified by the pattern_trigger_index_test_patterns
+  * parameter; if it is not specified, then a small built-in pattern set
+  * with indexed and unindexed patterns is used.  The input document (in sgm
+  * format) is specified by the pattern_trigger_index_test_document
+  * parameter; if it is not specified, then a short built-in document is
+  * used. */
+struct PatternTriggerIndexFixture : public SerifTestFixture {
+
+	struct Result {
+		std::vector<std::wstring> snippets;
+		size_t n_evaluated;
+		size_t n_skipped;
+	};
+
+	static PatternSet_ptr loadPatternSet(bool use_trigger_index) {
+		ParamReader::setParam("use_pattern_trigger_index", use_trigger_index ? "true" : "false");
+		std::string filename = ParamReader::getParam("pattern_trigger_index_test_patterns");
+		if (!filename.empty())
+			return boost::make_shared<PatternSet>(filename.c_str());
+		std::wistringstream patterns(
+			L"(trigger_index_test\n"
+			L"  (toplevel\n"
+			L"    (vprop (id meet) (predicate met meet))\n"
+			L"    (vprop (id say) (predicate said say))\n"
+			L"    (vprop (id approve) STEM_PREDICATE (predicate approve))\n"
+			L"    (vprop (id bomb) (predicate bombed bomb))\n"
+			L"    (vprop (id hire) (predicate hir*))\n"
+			L"    (mention (id person) (acetype PER))\n"
+			L"    (mention (id weapon) (acetype WEA))\n"
+			L"    (mention (id any_mention))))\n");
+		Sexp sexp(patterns);
+		return boost::make_shared<PatternSet>(&sexp);
+	}
+
+	static std::wstring describe(PatternFeatureSet_ptr snippet) {
+		std::wostringstream out;
+		out << snippet->getStartSentence() << L":" << snippet->getStartToken() << L"-"
+			<< snippet->getEndSentence() << L":" << snippet->getEndToken()
+			<< L" score=" << snippet->getScore();
+		for (size_t i = 0; i < snippet->getNFeatures(); ++i) {
+			PatternFeature_ptr feature = snippet->getFeature(i);
+			out << L" [" << (feature->getPattern() ? feature->getPattern()->getID().to_string() : L"")
+				<< L" " << feature->getSentenceNumber() << L":" << feature->getStartToken()
+				<< L"-" << feature->getEndToken() << L"]";
+		}
+		return out.str();
+	}
+
+	/** Match the pattern set against every sentence of the given document,
+	  * with or without the trigger index. */
+	static Result run(const DocTheory *docTheory, bool use_trigger_index) {
+		PatternMatcher_ptr matcher = PatternMatcher::makePatternMatcher(docTheory, loadPatternSet(use_trigger_index));
+		Result result;
+		for (int i = 0; i < docTheory->getNSentences(); ++i) {
+			std::vector<PatternFeatureSet_ptr> snippets = matcher->getSentenceSnippets(docTheory->getSentenceTheory(i));
+			for (size_t j = 0; j < snippets.size(); ++j)
+				result.snippets.push_back(describe(snippets[j]));
+		}
+		result.n_evaluated = matcher->getNSentencePatternsEvaluated();
+		result.n_skipped = matcher->getNSentencePatternsSkipped();
+		return result;
+	}
+};
+
+void pattern_trigger_index_matches_unindexed() {
+	PatternTriggerIndexFixture f;
+	std::wstring serifXML = f.runSerif(f.getTestDocument("pattern_trigger_index_test_document"), Stage("output"));
+	std::pair<Document*, DocTheory*> docPair =
+		SerifXML::XMLSerializedDocTheory(XMLUtil::loadXercesDOMFromString(serifXML.c_str())).generateDocTheory();
+	const DocTheory *docTheory = docPair.second;
+
+	PatternTriggerIndexFixture::Result unindexed = f.run(docTheory, false);
+	PatternTriggerIndexFixture::Result indexed = f.run(docTheory, true);
+
+	BOOST_CHECK(!unindexed.snippets.empty());
+	BOOST_CHECK_EQUAL(indexed.snippets.size(), unindexed.snippets.size());
+	BOOST_CHECK_MESSAGE(indexed.snippets == unindexed.snippets,
+		"Sentence snippets found with the pattern trigger index differ from those found without it");
+
+	// Without the index, every sentence pattern is evaluated against every
+	// sentence; with it, each one is either evaluated or skipped.
+	BOOST_CHECK_EQUAL(unindexed.n_skipped, static_cast<size_t>(0));
+	BOOST_CHECK_EQUAL(indexed.n_evaluated + indexed.n_skipped, unindexed.n_evaluated);
+	if (ParamReader::getParam("pattern_trigger_index_test_patterns").empty())
+		BOOST_CHECK(indexed.n_skipped > 0);
+	BOOST_TEST_MESSAGE("Sentence patterns evaluated: " << unindexed.n_evaluated << " without the trigger index, "
+		<< indexed.n_evaluated << " with it (" << indexed.n_skipped << " skipped)");
+
+	delete docPair.second;
+	delete docPair.first;
+}
@@ -0,0 +1,293 @@
+#include "Generic/common/GenericTimer.h"
+#include "Generic/common/OutputUtil.h"
+#include "Generic/common/ParamReader.h"
+#include "Generic/common/SymbolConstants.h"
+#include "Generic/discTagger/DTBigramFeature.h"
+#include "Generic/discTagger/DTFeatureType.h"
+#include "Generic/discTagger/DTFeatureTypeSet.h"
+#include "Generic/discTagger/DTObservation.h"
+#include "Generic/discTagger/DTState.h"
+#include "Generic/discTagger/DTTagSet.h"
+#include "Generic/maxent/MaxEntModel.h"
+#include "Generic/relations/MaxEntRelationTrainer.h"
+#include "EnglishTest/test/SerifTestUtil.h"
+
+#pragma warning(push)
+#pragma warning(disable : 4266)
+#include <boost/test/unit_test.hpp>
+#pragma warning(pop)
+#include <boost/lexical_cast.hpp>
+#include <boost/shared_ptr.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <vector>
+
+/** Tests for MaxEntModel training.
+  *
+  * maxent_training_threads_match_single_thread tests multithreaded
+  * training (maxent_trainer_threads).  The training data and settings are
+  * taken from a MaxEntRelationTrainer parameter file, specified by the
+  * maxent_training_test_param_file parameter; if it is not specified, then
+  * the test is skipped.  It trains a relation model with one thread and
+  * with several threads (maxent_trainer_threads from the trainer parameter
+  * file, or 4 if it is not set), checks that the two models are the same up
+  * to rounding, and reports the training time for each.
+  *
+  * maxent_training_lbfgs_gradient_matches_finite_differences checks the
+  * objective that MaxEntModel's LBFGS training mode hands to its gradient
+  * optimizer, on a small synthetic data set.  At several points, it checks
+  * each component of the gradient against a central finite difference of
+  * the objective, with and without a Gaussian prior.  It also checks that
+  * with all weights at zero the objective is the log likelihood of a
+  * uniform model.  It needs no parameters, and it does not need an
+  * optimizer library: it installs an "optimizer" that only checks the
+  * objective and leaves the weights unchanged. */
+struct MaxEntTrainingFixture : public SerifTestFixture {
+
+	/** Train a relation model using the given trainer parameter file and
+	  * number of threads, and return the model file's tokens.  Set msec to
+	  * the time spent (not including loading the training data). */
+	static std::vector<std::string> train(const std::string &param_file, int n_threads, double &msec) {
+		ParamReader::finalize();
+		ParamReader::readParamFile(param_file);
+		OutputUtil::NamedTempFile tempFile = OutputUtil::makeNamedTempFile();
+		tempFile.second->close();
+		ParamReader::setParam("maxent_relation_model_file", tempFile.first.c_str());
+		ParamReader::setParam("maxent_relation_filter_mode", "false");
+		ParamReader::setParam("maxent_trainer_threads", boost::lexical_cast<std::string>(n_threads).c_str());
+
+		MaxEntRelationTrainer trainer;
+		GenericTimer timer;
+		timer.startTimer();
+		trainer.train();
+		timer.stopTimer();
+		msec = timer.getTime();
+
+		std::vector<std::string> tokens;
+		std::ifstream in(tempFile.first.c_str());
+		std::string token;
+		while (in >> token)
+			tokens.push_back(token);
+		in.close();
+		remove(tempFile.first.c_str());
+		return tokens;
+	}
+
+	/** Return true if the two tokens are the same, or are both numbers that
+	  * differ by at most the given (absolute or relative) tolerance. */
+	static bool sameToken(const std::string &a, const std::string &b, double tolerance) {
+		if (a == b)
+			return true;
+		try {
+			double x = boost::lexical_cast<double>(a);
+			double y = boost::lexical_cast<double>(b);
+			return std::fabs(x - y) <= tolerance * std::max(1.0, std::max(std::fabs(x), std::fabs(y)));
+		} catch (boost::bad_lexical_cast &) {
+			return false;
+		}
+	}
+};
+
+void maxent_training_threads_match_single_thread() {
+	std::string param_file = ParamReader::getParam("maxent_training_test_param_file");
+	if (param_file.empty()) {
+		BOOST_TEST_MESSAGE("maxent_training_test_param_file not specified; skipping");
+		return;
+	}
+	MaxEntTrainingFixture f;
+	ParamReader::finalize();
+	ParamReader::readParamFile(param_file);
+	int n_threads = ParamReader::getOptionalIntParamWithDefaultValue("maxent_trainer_threads", 1);
+	if (n_threads < 2)
+		n_threads = 4;
+
+	double single_msec = 0;
+	std::vector<std::string> single = f.train(param_file, 1, single_msec);
+	double threaded_msec = 0;
+	std::vector<std::string> threaded = f.train(param_file, n_threads, threaded_msec);
+
+	BOOST_CHECK(!single.empty());
+	BOOST_REQUIRE_EQUAL(single.size(), threaded.size());
+	size_t n_different = 0;
+	for (size_t i = 0; i < single.size(); i++) {
+		if (!f.sameToken(single[i], threaded[i], 1e-6))
+			n_different++;
+	}
+	BOOST_CHECK_MESSAGE(n_different == 0, n_different
+		<< " values in the model trained with " << n_threads << " threads differ from the single-threaded model");
+	BOOST_TEST_MESSAGE("1 thread: " << single_msec << " msec");
+	BOOST_TEST_MESSAGE(n_threads << " threads: " << threaded_msec << " msec");
+}
+
+/** A small synthetic training set for MaxEntModel, and an optimizer that
+  * checks the gradient of its LBFGS training objective. */
+struct MaxEntLBFGSFixture {
+
+	/** An observation with a few words, each of which is a feature. */
+	class WordsObservation : public DTObservation {
+	public:
+		WordsObservation(const std::vector<Symbol> &words) : DTObservation(Symbol(L"MaxEntTrainingTest")), _words(words) {}
+		DTObservation *makeCopy() { return _new WordsObservation(_words); }
+		const std::vector<Symbol> &getWords() const { return _words; }
+	private:
+		std::vector<Symbol> _words;
+	};
+
+	class WordFeatureType : public DTFeatureType {
+	public:
+		WordFeatureType() : DTFeatureType(Symbol(L"MaxEntTrainingTest"), Symbol(L"word"), InfoSource::OBSERVATION) {}
+		DTFeature *makeEmptyFeature() const {
+			return _new DTBigramFeature(this, SymbolConstants::nullSymbol, SymbolConstants::nullSymbol);
+		}
+		int extractFeatures(const DTState &state, DTFeature **resultArray) const {
+			const std::vector<Symbol> &words = static_cast<WordsObservation*>(state.getObservation(0))->getWords();
+			for (size_t i = 0; i < words.size(); ++i)
+				resultArray[i] = _new DTBigramFeature(this, state.getTag(), words[i]);
+			return static_cast<int>(words.size());
+		}
+	};
+
+	/** A gradient "optimizer" that checks the objective's gradient against
+	  * central finite differences at the starting point and at n_points
+	  * random points, and then leaves the parameters unchanged. */
+	class GradientCheckingOptimizer : public MaxEntGradientOptimizer {
+	public:
+		GradientCheckingOptimizer(int n_points): _n_points(n_points), _max_error(0), _n_checked(0), _objective_at_start(0) {}
+
+		int optimize(Objective &objective, std::vector<double> &x, int max_iterations) {
+			const double h = 1e-5;
+			const size_t n = static_cast<size_t>(objective.nParams());
+			std::vector<double> gradient(n), unused(n);
+			unsigned state = 29;
+			for (int point = 0; point <= _n_points; ++point) {
+				std::vector<double> params(x);
+				if (point > 0) {
+					for (size_t j = 0; j < n; ++j)
+						params[j] = nextRandom(state) / 8388608.0 - 1.0; // in [-1, 1)
+				}
+				double value = objective.evaluate(params, gradient);
+				if (point == 0)
+					_objective_at_start = value;
+				for (size_t j = 0; j < n; ++j) {
+					double saved = params[j];
+					params[j] = saved + h;
+					double above = objective.evaluate(params, unused);
+					params[j] = saved - h;
+					double below = objective.evaluate(params, unused);
+					params[j] = saved;
+					double difference = (above - below) / (2 * h);
+					double error = std::fabs(difference - gradient[j]) / std::max(1.0, std::fabs(difference));
+					_max_error = std::max(_max_error, error);
+					++_n_checked;
+				}
+			}
+			return 0;
+		}
+
+		/** The largest relative difference between a gradient component and
+		  * its finite difference. */
+		double getMaxError() const { return _max_error; }
+		size_t getNChecked() const { return _n_checked; }
+		double getObjectiveAtStart() const { return _objective_at_start; }
+
+	private:
+		int _n_points;
+		double _max_error;
+		size_t _n_checked;
+		double _objective_at_start;
+	};
+
+	static const DTFeatureType *getWordFeatureType() {
+		// Feature types are registered by name, so this is never deleted.
+		static const DTFeatureType *featureType = _new WordFeatureType();
+		return featureType;
+	}
+
+	static unsigned nextRandom(unsigned &state) {
+		state = state * 1103515245 + 12345;
+		return (state >> 8) & 0xFFFFFF;
+	}
+
+	/** Fill observations and answers with n_observations random training
+	  * examples.  Each word prefers one tag, and an example's answer is the
+	  * tag its first word prefers 60% of the time (and a random tag
+	  * otherwise), so the data is not separable. */
+	static void makeTrainingData(int n_observations, int n_tags, std::vector<WordsObservation*> &observations, std::vector<int> &answers) {
+		unsigned state = 17;
+		for (int i = 0; i < n_observations; ++i) {
+			std::vector<Symbol> words;
+			int first_word = 0;
+			for (int j = 0; j < 3; ++j) {
+				int w = static_cast<int>(nextRandom(state) % 40);
+				if (j == 0)
+					first_word = w;
+				words.push_back(Symbol(L"w" + boost::lexical_cast<std::wstring>(w)));
+			}
+			observations.push_back(_new WordsObservation(words));
+			if (nextRandom(state) % 10 < 6)
+				answers.push_back(first_word % n_tags);
+			else
+				answers.push_back(static_cast<int>(nextRandom(state) % n_tags));
+		}
+	}
+
+	/** Train a model in LBFGS mode with the given prior variance (0 for no
+	  * prior), which runs the installed optimizer on its objective. */
+	static void trainLBFGS(DTTagSet &tagSet, DTFeatureTypeSet &featureTypes, double variance,
+		const std::vector<WordsObservation*> &observations, const std::vector<int> &answers)
+	{
+		DTFeature::FeatureWeightMap weights(1024);
+		{
+			MaxEntModel model(&tagSet, &featureTypes, &weights, MaxEntModel::LBFGS, 0, 1000, variance, .0001, 1);
+			for (size_t i = 0; i < observations.size(); ++i)
+				model.addToTraining(observations[i], answers[i]);
+			model.deriveModel(0);
+		}
+		for (DTFeature::FeatureWeightMap::iterator iter = weights.begin(); iter != weights.end(); ++iter)
+			(*iter).first->deallocate();
+	}
+};
+
+void maxent_training_lbfgs_gradient_matches_finite_differences() {
+	MaxEntLBFGSFixture f;
+	boost::shared_ptr<MaxEntGradientOptimizer> previousOptimizer = MaxEntModel::getGradientOptimizer();
+
+	OutputUtil::NamedTempFile tagSetFile = OutputUtil::makeNamedTempFile();
+	*tagSetFile.second << "3\nPER\nORG\nLOC\n";
+	tagSetFile.second->close();
+	DTTagSet tagSet(tagSetFile.first.c_str(), false, false);
+	remove(tagSetFile.first.c_str());
+	f.getWordFeatureType();
+	DTFeatureTypeSet featureTypes(1);
+	featureTypes.addFeatureType(Symbol(L"MaxEntTrainingTest"), Symbol(L"word"));
+
+	std::vector<MaxEntLBFGSFixture::WordsObservation*> observations;
+	std::vector<int> answers;
+	f.makeTrainingData(500, tagSet.getNTags(), observations, answers);
+
+	const double variances[] = {0, 1};
+	for (int v = 0; v < 2; ++v) {
+		boost::shared_ptr<MaxEntLBFGSFixture::GradientCheckingOptimizer> checker(
+			_new MaxEntLBFGSFixture::GradientCheckingOptimizer(2));
+		MaxEntModel::setGradientOptimizer(checker);
+		f.trainLBFGS(tagSet, featureTypes, variances[v], observations, answers);
+
+		BOOST_CHECK(checker->getNChecked() > 0);
+		BOOST_CHECK_MESSAGE(checker->getMaxError() < 1e-4, "With variance " << variances[v]
+			<< ", the LBFGS gradient differs from the finite differences by up to " << checker->getMaxError());
+		// With all weights at zero, every tag is equally likely (and the
+		// prior contributes nothing).
+		double uniform = -(observations.size() * std::log(1.0 / tagSet.getNTags()));
+		BOOST_CHECK_CLOSE(checker->getObjectiveAtStart(), uniform, 1e-6);
+		BOOST_TEST_MESSAGE("Variance " << variances[v] << ": checked " << checker->getNChecked()
+			<< " gradient components; largest relative error " << checker->getMaxError());
+	}
+
+	for (size_t i = 0; i < observations.size(); ++i)
+		delete observations[i];
+	MaxEntModel::setGradientOptimizer(previousOptimizer);
+}
@@ -0,0 +1,49 @@
+#include "Generic/common/ParamReader.h"
+#include "Generic/driver/Stage.h"
+#include "EnglishTest/test/SerifTestUtil.h"
+
+#pragma warning(push)
+#pragma warning(disable : 4266)
+#include <boost/test/unit_test.hpp>
+#pragma warning(pop)
+
+#include <string>
+
+/** Tests for relation candidate pair pruning in the English relation
+  * finder (relation_pair_max_token_distance, relation_pair_max_path_length
+  * and relation_pair_prune_by_entity_type).  The pruning parameters should
+  * be set to match the distribution of relations in the training data; if
+  * none of them are specified, then the test is skipped.  The input
+  * document (in sgm format) is specified by the
+  * relation_pair_pruning_test_document parameter; if it is not specified,
+  * then a short built-in document is used.
+  *
+  * relation_pair_pruning_output_unchanged runs Serif through the
+  * relations stage on the document with and without pruning, checks that
+  * the output is the same, and reports the time for each run. */
+void relation_pair_pruning_output_unchanged() {
+	if (!(ParamReader::getOptionalIntParamWithDefaultValue("relation_pair_max_token_distance", 0) > 0 ||
+		ParamReader::getOptionalIntParamWithDefaultValue("relation_pair_max_path_length", 0) > 0 ||
+		ParamReader::isParamTrue("relation_pair_prune_by_entity_type")))
+	{
+		BOOST_TEST_MESSAGE("Relation pair pruning parameters not specified; skipping");
+		return;
+	}
+	SerifTestFixture f;
+	std::wstring document = f.getTestDocument("relation_pair_pruning_test_document");
+
+	double pruned_msec = 0;
+	std::wstring pruned = f.runSerif(document, Stage("relations"), &pruned_msec);
+
+	ParamReader::setParam("relation_pair_max_token_distance", "0");
+	ParamReader::setParam("relation_pair_max_path_length", "0");
+	ParamReader::setParam("relation_pair_prune_by_entity_type", "false");
+	double unpruned_msec = 0;
+	std::wstring unpruned = f.runSerif(document, Stage("relations"), &unpruned_msec);
+
+	BOOST_CHECK(!unpruned.empty());
+	BOOST_CHECK_MESSAGE(pruned == unpruned,
+		"SerifXML output with relation pair pruning differs from output without it");
+	BOOST_TEST_MESSAGE("Without pruning: " << unpruned_msec << " msec");
+	BOOST_TEST_MESSAGE("With pruning: " << pruned_msec << " msec");
+}
@@ -0,0 +1,260 @@
+#include "Generic/common/ParamReader.h"
+#include "Generic/common/OutputUtil.h"
+#include "Generic/common/XMLUtil.h"
+#include "Generic/driver/Stage.h"
+#include "Generic/linuxPort/serif_port.h"
+#include "Generic/results/SerifXMLResultCollector.h"
+#include "Generic/state/ByteBuffer.h"
+#include "Generic/state/CompactDocTheoryFile.h"
+#include "Generic/state/ObjectIDTable.h"
+#include "Generic/state/StateLoader.h"
+#include "Generic/state/StateSaver.h"
+#include "Generic/state/XMLSerializedDocTheory.h"
+#include "Generic/theories/Document.h"
+#include "Generic/theories/DocTheory.h"
+#include "EnglishTest/test/SerifTestUtil.h"
+
+#pragma warning(push)
+#pragma warning(disable : 4266)
+#include <boost/test/unit_test.hpp>
+#pragma warning(pop)
+#include <boost/filesystem.hpp>
+
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <string>
+
+/** Tests for the compact state-file format (compact_state_files).
+  *
+  * compact_state_values_round_trip checks that every kind of value that
+  * StateSaver writes is read back unchanged: from a file, from a binary
+  * stream, and from a ByteBuffer.  compact_state_stream_detection checks
+  * that a StateLoader reading from a binary stream still reads the older
+  * binary format.
+  *
+  * The remaining tests use a SerifXML test document: the one specified
+  * by the compact_state_test_document parameter, or else Serif's output
+  * (through doc-values) for the built-in test document.  The document
+  * should only contain theories that state files support (i.e., those
+  * produced by the standard stages through doc-values).
+  *
+  * compact_state_matches_serifxml saves the test document's DocTheory as
+  * a compact state file, loads it back, and checks that the reloaded
+  * DocTheory gives exactly the same SerifXML as the original, and as the
+  * same round trip through a text state file.
+  *
+  * compact_serifxml_round_trip writes the test document with the
+  * SerifXML result collector while compact_serifxml is set, reads the
+  * file back with XMLSerializedDocTheory, and checks that the result
+  * gives exactly the same SerifXML as the original. */
+struct CompactStateFixture : public SerifTestFixture {
+
+	/** Load the SerifXML test document (see above).  The caller takes
+	  * ownership of the Document and DocTheory. */
+	static std::pair<Document*, DocTheory*> loadTestDocument() {
+		std::string filename = ParamReader::getParam("compact_state_test_document");
+		if (!filename.empty())
+			return SerifXML::XMLSerializedDocTheory(filename.c_str()).generateDocTheory();
+		std::wstring serifXML = runSerif(getTestDocument("compact_state_test_sgm_document"), Stage("doc-values"));
+		return SerifXML::XMLSerializedDocTheory(XMLUtil::loadXercesDOMFromString(serifXML.c_str())).generateDocTheory();
+	}
+
+	static std::string makeTempFileName() {
+		OutputUtil::NamedTempFile tempFile = OutputUtil::makeNamedTempFile();
+		tempFile.second->close();
+		return tempFile.first;
+	}
+
+	static std::string readFile(const std::string &filename) {
+		std::ifstream in(filename.c_str(), std::ios::binary);
+		std::ostringstream contents;
+		contents << in.rdbuf();
+		return contents.str();
+	}
+
+	static std::string toSerifXML(const DocTheory *docTheory) {
+		std::ostringstream out;
+		SerifXML::XMLSerializedDocTheory(docTheory).save(out);
+		return out.str();
+	}
+
+	/** Save the given DocTheory (and its sentence breaks) to a new state
+	  * file in the given format, and return the file's name. */
+	static std::string saveDocTheory(DocTheory *docTheory, bool compact) {
+		ParamReader::setParam("compact_state_files", compact ? "true" : "false");
+		ParamReader::setParam("binary_state_files", "false");
+		std::string filename = makeTempFileName();
+		StateSaver stateSaver(filename.c_str());
+		docTheory->saveSentenceBreaksToStateFile(&stateSaver);
+		ObjectIDTable::initialize();
+		docTheory->updateObjectIDTable();
+		stateSaver.beginStateTree(DOC_THEORY_TREE);
+		stateSaver.saveInteger(docTheory->getNSentences());
+		docTheory->saveState(&stateSaver);
+		stateSaver.endStateTree();
+		ObjectIDTable::finalize();
+		return filename;
+	}
+
+	/** Load a DocTheory for the given document from a state file that was
+	  * written by saveDocTheory(). */
+	static DocTheory *loadDocTheory(const std::string &filename, Document *document) {
+		StateLoader stateLoader(filename.c_str());
+		DocTheory *docTheory = _new DocTheory(document);
+		docTheory->loadSentenceBreaksFromStateFile(&stateLoader);
+		stateLoader.beginStateTree(DOC_THEORY_TREE);
+		stateLoader.loadInteger();
+		docTheory->loadDocTheory(&stateLoader);
+		stateLoader.endStateTree();
+		docTheory->resolvePointers(&stateLoader);
+		return docTheory;
+	}
+
+	static const wchar_t *DOC_THEORY_TREE;
+};
+
+const wchar_t *CompactStateFixture::DOC_THEORY_TREE = L"DocTheory following stage: doc-values";
+
+
+void compact_state_values_round_trip() {
+	CompactStateFixture f;
+	ParamReader::setParam("compact_state_files", "true");
+	std::string filename = f.makeTempFileName();
+	int objects[2];
+	{
+		StateSaver stateSaver(filename.c_str());
+		for (int tree = 0; tree < 2; ++tree) {
+			ObjectIDTable::initialize();
+			ObjectIDTable::addObject(&objects[0]);
+			ObjectIDTable::addObject(&objects[1]);
+			stateSaver.beginStateTree(L"Compact state test");
+			stateSaver.beginList(L"Values", &objects[1]);
+			stateSaver.saveInteger(-123456);
+			stateSaver.saveInteger(tree);
+			stateSaver.saveUnsigned(4000000000u);
+			stateSaver.saveReal(-2.5f);
+			stateSaver.saveString(L"a \"quoted\" string");
+			stateSaver.saveSymbol(Symbol(L"NP"));
+			stateSaver.saveSymbol(Symbol());
+			stateSaver.saveSymbol(Symbol(L"NP"));
+			stateSaver.beginList();
+			stateSaver.savePointer(&objects[0]);
+			stateSaver.endList();
+			stateSaver.endList();
+			stateSaver.endStateTree();
+			ObjectIDTable::finalize();
+		}
+	}
+
+	// Read the file by name, through a binary stream, and in place from a
+	// buffer.
+	std::string contents = f.readFile(filename);
+	ByteBuffer byteBuffer(reinterpret_cast<unsigned char*>(&contents[0]), contents.size());
+	std::ifstream stream(filename.c_str(), std::ios::binary);
+	for (int pass = 0; pass < 3; ++pass) {
+		StateLoader *stateLoader = (pass == 0) ? _new StateLoader(filename.c_str())
+			: (pass == 1) ? _new StateLoader(stream) : _new StateLoader(&byteBuffer);
+		for (int tree = 0; tree < 2; ++tree) {
+			stateLoader->beginStateTree(L"Compact state test");
+			// Object ids start at 1, since ObjectIDTable gives id 0 to null.
+			BOOST_CHECK_EQUAL(stateLoader->beginList(L"Values"), 2);
+			BOOST_CHECK_EQUAL(stateLoader->loadInteger(), -123456);
+			BOOST_CHECK_EQUAL(stateLoader->loadInteger(), tree);
+			BOOST_CHECK_EQUAL(stateLoader->loadUnsigned(), 4000000000u);
+			BOOST_CHECK_EQUAL(stateLoader->loadReal(), -2.5f);
+			BOOST_CHECK(std::wstring(stateLoader->loadString()) == L"a \"quoted\" string");
+			BOOST_CHECK(stateLoader->loadSymbol() == Symbol(L"NP"));
+			BOOST_CHECK(stateLoader->loadSymbol().is_null());
+			BOOST_CHECK(stateLoader->loadSymbol() == Symbol(L"NP"));
+			stateLoader->beginList();
+			BOOST_CHECK(stateLoader->loadPointer() == reinterpret_cast<void*>(1));
+			stateLoader->endList();
+			stateLoader->endList();
+			stateLoader->endStateTree();
+		}
+		delete stateLoader;
+	}
+	BOOST_CHECK_EQUAL(byteBuffer.getRemaining(), static_cast<size_t>(0));
+	stream.close();
+	std::remove(filename.c_str());
+}
+
+void compact_state_stream_detection() {
+	CompactStateFixture f;
+	std::string filename = f.makeTempFileName();
+	{
+		StateSaver stateSaver(filename.c_str(), true);
+		stateSaver.beginStateTree(L"Binary state test");
+		stateSaver.beginList(L"Values");
+		stateSaver.saveInteger(42);
+		stateSaver.saveSymbol(Symbol(L"NP"));
+		stateSaver.endList();
+		stateSaver.endStateTree();
+	}
+	std::ifstream stream(filename.c_str(), std::ios::binary);
+	{
+		StateLoader stateLoader(stream);
+		stateLoader.beginStateTree(L"Binary state test");
+		stateLoader.beginList(L"Values");
+		BOOST_CHECK_EQUAL(stateLoader.loadInteger(), 42);
+		BOOST_CHECK(stateLoader.loadSymbol() == Symbol(L"NP"));
+		stateLoader.endList();
+		stateLoader.endStateTree();
+	}
+	stream.close();
+	std::remove(filename.c_str());
+}
+
+void compact_state_matches_serifxml() {
+	CompactStateFixture f;
+	std::pair<Document*, DocTheory*> docPair = f.loadTestDocument();
+	std::string original = f.toSerifXML(docPair.second);
+
+	std::string textStateFile = f.saveDocTheory(docPair.second, false);
+	std::string compactStateFile = f.saveDocTheory(docPair.second, true);
+	BOOST_TEST_MESSAGE("text state file: " << f.readFile(textStateFile).size() << " bytes; "
+		<< "compact state file: " << f.readFile(compactStateFile).size() << " bytes");
+
+	DocTheory *fromText = f.loadDocTheory(textStateFile, docPair.first);
+	DocTheory *fromCompact = f.loadDocTheory(compactStateFile, docPair.first);
+	std::string compactXML = f.toSerifXML(fromCompact);
+	BOOST_CHECK_MESSAGE(compactXML == original,
+		"SerifXML for the DocTheory loaded from a compact state file differs from the original");
+	BOOST_CHECK_MESSAGE(compactXML == f.toSerifXML(fromText),
+		"DocTheories loaded from compact and text state files give different SerifXML");
+
+	delete fromText;
+	delete fromCompact;
+	delete docPair.second;
+	delete docPair.first;
+	std::remove(textStateFile.c_str());
+	std::remove(compactStateFile.c_str());
+}
+
+void compact_serifxml_round_trip() {
+	CompactStateFixture f;
+	std::pair<Document*, DocTheory*> docPair = f.loadTestDocument();
+	std::string original = f.toSerifXML(docPair.second);
+
+	std::string outputDir = f.makeTempDir();
+	std::wstring outputDirName(outputDir.begin(), outputDir.end());
+	ParamReader::setParam("compact_serifxml", "true");
+	SerifXMLResultCollector resultCollector;
+	resultCollector.loadDocTheory(docPair.second);
+	resultCollector.produceOutput(outputDirName.c_str(), L"compact");
+	std::string filename = outputDir + SERIF_PATH_SEP + "compact.xml";
+	BOOST_REQUIRE(CompactDocTheoryFile::isCompactFile(filename.c_str()));
+	BOOST_TEST_MESSAGE("SerifXML: " << original.size() << " bytes; "
+		<< "compact DocTheory file: " << f.readFile(filename).size() << " bytes");
+
+	std::pair<Document*, DocTheory*> reloaded = SerifXML::XMLSerializedDocTheory(filename.c_str()).generateDocTheory();
+	BOOST_CHECK_MESSAGE(f.toSerifXML(reloaded.second) == original,
+		"SerifXML for the DocTheory loaded from a compact DocTheory file differs from the original");
+
+	delete reloaded.second;
+	delete reloaded.first;
+	delete docPair.second;
+	delete docPair.first;
+	boost::filesystem::remove_all(outputDir);
+}
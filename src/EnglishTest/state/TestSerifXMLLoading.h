@@ -0,0 +1,88 @@
+#include "Generic/common/GenericTimer.h"
+#include "Generic/common/HeapStatus.h"
+#include "Generic/common/ParamReader.h"
+#include "Generic/common/XMLUtil.h"
+#include "Generic/state/XMLSerializedDocTheory.h"
+#include "Generic/theories/Document.h"
+#include "Generic/theories/DocTheory.h"
+
+#pragma warning(push)
+#pragma warning(disable : 4266)
+#include <boost/test/unit_test.hpp>
+#pragma warning(pop)
+#include <xercesc/dom/DOM.hpp>
+
+#include <sstream>
+#include <string>
+
+/** Tests for loading SerifXML documents with a compact DOM (see
+  * XMLUtil::loadXercesDOMFromFilename), which XMLSerializedDocTheory
+  * uses when it loads a file.  The SerifXML document is specified by the
+  * serifxml_loading_test_document parameter; if it is not specified, then
+  * the test is skipped.
+  *
+  * serifxml_loading_compact_dom_matches_full_dom loads the document with
+  * and without the compact DOM, checks that the two DocTheories are
+  * serialized identically, and reports the number of DOM nodes, the
+  * increase in resident memory, and the loading time for each. */
+struct SerifXMLLoadingFixture {
+
+	struct Load {
+		size_t n_nodes;
+		size_t memory_bytes;
+		double msec;
+		std::string xml;
+	};
+
+	static size_t countNodes(const xercesc::DOMNode *node) {
+		size_t n = 1;
+		for (const xercesc::DOMNode *child = node->getFirstChild(); child != 0; child = child->getNextSibling())
+			n += countNodes(child);
+		return n;
+	}
+
+	/** Load the given SerifXML file and generate its DocTheory, and return
+	  * the DocTheory's SerifXML along with the loading statistics. */
+	static Load load(const std::string &filename, bool compact) {
+		Load result;
+		size_t memory_before = HeapStatus::getResidentMemory();
+		GenericTimer timer;
+		timer.startTimer();
+		xercesc::DOMDocument *domDocument = XMLUtil::loadXercesDOMFromFilename(filename.c_str(), compact);
+		result.n_nodes = countNodes(domDocument);
+		SerifXML::XMLSerializedDocTheory serializedDocTheory(domDocument);
+		std::pair<Document*, DocTheory*> docPair = serializedDocTheory.generateDocTheory();
+		timer.stopTimer();
+		size_t memory_after = HeapStatus::getResidentMemory();
+		result.memory_bytes = (memory_after > memory_before) ? memory_after - memory_before : 0;
+		result.msec = timer.getTime();
+
+		std::ostringstream out;
+		SerifXML::XMLSerializedDocTheory(docPair.second).save(out);
+		result.xml = out.str();
+		delete docPair.first;
+		delete docPair.second;
+		return result;
+	}
+};
+
+void serifxml_loading_compact_dom_matches_full_dom() {
+	std::string filename = ParamReader::getParam("serifxml_loading_test_document");
+	if (filename.empty()) {
+		BOOST_TEST_MESSAGE("serifxml_loading_test_document not specified; skipping");
+		return;
+	}
+	// Load the compact DOM first, so any memory that is allocated once and
+	// then reused is counted against it rather than the full DOM.
+	SerifXMLLoadingFixture::Load compact = SerifXMLLoadingFixture::load(filename, true);
+	SerifXMLLoadingFixture::Load full = SerifXMLLoadingFixture::load(filename, false);
+
+	BOOST_CHECK(!full.xml.empty());
+	BOOST_CHECK_MESSAGE(compact.xml == full.xml,
+		"DocTheory loaded from the compact DOM differs from the one loaded from the full DOM");
+	BOOST_CHECK(compact.n_nodes <= full.n_nodes);
+	BOOST_TEST_MESSAGE("Full DOM: " << full.n_nodes << " nodes, " << (full.memory_bytes / 1024)
+		<< " KB, " << full.msec << " msec");
+	BOOST_TEST_MESSAGE("Compact DOM: " << compact.n_nodes << " nodes, " << (compact.memory_bytes / 1024)
+		<< " KB, " << compact.msec << " msec");
+}
@@ -0,0 +1,104 @@
+#ifndef EN_SERIF_TEST_UTIL_H
+#define EN_SERIF_TEST_UTIL_H
+
+#include "Generic/common/GenericTimer.h"
+#include "Generic/common/OutputUtil.h"
+#include "Generic/common/ParamReader.h"
+#include "Generic/common/UTF8InputStream.h"
+#include "Generic/driver/DocumentDriver.h"
+#include "Generic/driver/SessionProgram.h"
+#include "Generic/driver/Stage.h"
+#include "Generic/reader/DocumentReader.h"
+#include "Generic/results/SerifXMLResultCollector.h"
+
+#pragma warning(push)
+#pragma warning(disable : 4266)
+#include <boost/test/unit_test.hpp>
+#pragma warning(pop)
+#include <boost/filesystem.hpp>
+#include <boost/scoped_ptr.hpp>
+
+#include <string>
+
+/** A base for the fixtures of tests that run Serif on whole documents.
+  * Its destructor resets all params to their original values, so tests
+  * may change params freely. */
+struct SerifTestFixture {
+
+	~SerifTestFixture() {
+		resetParams();
+	}
+
+	static void resetParams() {
+		ParamReader::finalize();
+		ParamReader::readParamFile(boost::unit_test::framework::master_test_suite().argv[1]);
+	}
+
+	/** Create a new, empty temporary directory, and return its name.  The
+	  * caller is responsible for removing it. */
+	static std::string makeTempDir() {
+		OutputUtil::NamedTempFile tempFile = OutputUtil::makeNamedTempFile();
+		tempFile.second->close();
+		std::string dirname = tempFile.first + ".dir";
+		boost::filesystem::create_directory(dirname);
+		boost::filesystem::remove(tempFile.first);
+		return dirname;
+	}
+
+	static std::wstring readDocument(const std::string &filename) {
+		boost::scoped_ptr<UTF8InputStream> in(UTF8InputStream::build(filename.c_str()));
+		std::wstring document, line;
+		while (!in->eof()) {
+			in->getLine(line);
+			document += line + L"\n";
+		}
+		return document;
+	}
+
+	/** Return the document (in sgm format) named by the given parameter, or
+	  * a short built-in document if the parameter is not specified. */
+	static std::wstring getTestDocument(const char *paramName) {
+		std::string filename = ParamReader::getParam(paramName);
+		if (!filename.empty())
+			return readDocument(filename);
+		return
+			L"<DOC>\n"
+			L"<DOCID>SERIF_TEST_DOCUMENT</DOCID>\n"
+			L"<TEXT>\n"
+			L"The mayor of Boston, Thomas Menino, met with state officials on Tuesday "
+			L"to discuss the city's budget for 2013.\n\n"
+			L"He said that the city would hire 200 new teachers if the legislature "
+			L"approved an additional $40 million in school funding.\n\n"
+			L"Officials from the Massachusetts Department of Education did not "
+			L"comment on the proposal, which was first reported by The Boston Globe.\n\n"
+			L"Menino, who has been mayor since 1993, has made education a priority "
+			L"of his administration.\n\n"
+			L"The legislature is expected to vote on the budget in June, after "
+			L"hearings in Boston, Worcester and Springfield.\n"
+			L"</TEXT>\n"
+			L"</DOC>\n";
+	}
+
+	/** Run Serif from the start stage through endStage on the given document
+	  * (in sgm format), and return the SerifXML output.  If msec is not NULL,
+	  * then set it to the time spent (not including model loading). */
+	static std::wstring runSerif(const std::wstring &document, Stage endStage, double *msec=0) {
+		DocumentDriver documentDriver;
+		documentDriver.giveDocumentReader(DocumentReader::build("sgm"));
+		SerifXMLResultCollector resultCollector;
+		SessionProgram sessionProgram;
+		sessionProgram.setStageRange(Stage::getStartStage(), endStage);
+		documentDriver.beginBatch(&sessionProgram, &resultCollector);
+		std::wstring results;
+		GenericTimer timer;
+		timer.startTimer();
+		documentDriver.runOnString(document.c_str(), &results);
+		timer.stopTimer();
+		documentDriver.endBatch();
+		if (msec)
+			*msec = timer.getTime();
+		return results;
+	}
+};
+
+#endif
@@ -1,7 +1,28 @@
 #include "Generic/common/leak_detection.h"
 
+#include "EnglishTest/actors/TestActorNameIndex.h"
+#include "EnglishTest/common/TestLocatedStringEdits.h"
+#include "EnglishTest/common/TestNGramCache.h"
+#include "EnglishTest/common/TestProfiler.h"
+#include "EnglishTest/common/TestSymbolTable.h"
+#include "EnglishTest/common/TestUTF8InputStream.h"
 #include "EnglishTest/tokens/TestEnglishTokenizer.h"
 #include "EnglishTest/tokens/TestIteaEnglishTokenizer.h"
+#include "EnglishTest/decoders/TestBlockFeatureTable.h"
+#include "EnglishTest/decoders/TestPDecoderBenchmark.h"
+#include "EnglishTest/driver/TestConcurrentDocumentDrivers.h"
+#include "EnglishTest/driver/TestParallelSentences.h"
+#include "EnglishTest/driver/TestQueueDriverWorkerPool.h"
+#include "EnglishTest/driver/TestStreamingDocTheory.h"
+#include "EnglishTest/parse/TestAnytimeParsing.h"
+#include "EnglishTest/parse/TestParserModelImage.h"
+#include "EnglishTest/parse/TestSharedParserCache.h"
+#include "EnglishTest/patterns/TestPatternTriggerIndex.h"
+#include "EnglishTest/relations/TestMaxEntTraining.h"
+#include "EnglishTest/relations/TestRelationPairPruning.h"
+#include "EnglishTest/state/TestCompactStateFiles.h"
+#include "EnglishTest/state/TestSerifXMLLoading.h"
+#include "EnglishTest/wordnet/TestWordNetDatabase.h"
 #include "EnglishTest/test/en_UnitTester.h"
 
 EnglishUnitTester::EnglishUnitTester() {}
@@ -28,5 +49,136 @@ boost::unit_test::test_suite* EnglishUnitTester::initUnitTests() {
 	
 	boost::unit_test::framework::master_test_suite().add(ts2);
 
+	boost::unit_test::test_suite* ts3 = BOOST_TEST_SUITE("PDecoder Decode Benchmark");
+	ts3->add( BOOST_TEST_CASE ( &names_decode_benchmark ));
+	ts3->add( BOOST_TEST_CASE ( &np_chunk_decode_benchmark ));
+
+	boost::unit_test::framework::master_test_suite().add(ts3);
+
+	boost::unit_test::test_suite* ts4 = BOOST_TEST_SUITE("Parallel Sentence-Level Stages");
+	ts4->add( BOOST_TEST_CASE ( &parallel_sentences_match_sequential ));
+	ts4->add( BOOST_TEST_CASE ( &parallel_sentences_parse_match_sequential ));
+
+	boost::unit_test::framework::master_test_suite().add(ts4);
+
+	boost::unit_test::test_suite* ts5 = BOOST_TEST_SUITE("Compact State Files");
+	ts5->add( BOOST_TEST_CASE ( &compact_state_values_round_trip ));
+	ts5->add( BOOST_TEST_CASE ( &compact_state_stream_detection ));
+	ts5->add( BOOST_TEST_CASE ( &compact_state_matches_serifxml ));
+	ts5->add( BOOST_TEST_CASE ( &compact_serifxml_round_trip ));
+
+	boost::unit_test::framework::master_test_suite().add(ts5);
+
+	boost::unit_test::test_suite* ts6 = BOOST_TEST_SUITE("LocatedString Edits");
+	ts6->add( BOOST_TEST_CASE ( &located_string_batched_replace_matches_sequential ));
+	ts6->add( BOOST_TEST_CASE ( &located_string_batched_replace_benchmark ));
+
+	boost::unit_test::framework::master_test_suite().add(ts6);
+
+	boost::unit_test::test_suite* ts7 = BOOST_TEST_SUITE("Actor Name Index");
+	ts7->add( BOOST_TEST_CASE ( &actor_name_index_matches_linear_scan ));
+	ts7->add( BOOST_TEST_CASE ( &actor_name_index_benchmark ));
+
+	boost::unit_test::framework::master_test_suite().add(ts7);
+
+	boost::unit_test::test_suite* ts8 = BOOST_TEST_SUITE("WordNet Database");
+	ts8->add( BOOST_TEST_CASE ( &wordnet_database_matches_library ));
+	ts8->add( BOOST_TEST_CASE ( &wordnet_database_concurrent_lookups ));
+
+	boost::unit_test::framework::master_test_suite().add(ts8);
+
+	boost::unit_test::test_suite* ts9 = BOOST_TEST_SUITE("NGram Cache");
+	ts9->add( BOOST_TEST_CASE ( &ngram_cache_matches_map ));
+	ts9->add( BOOST_TEST_CASE ( &ngram_cache_concurrent_lookups ));
+	ts9->add( BOOST_TEST_CASE ( &ngram_cache_benchmark ));
+	ts9->add( BOOST_TEST_CASE ( &ngram_cache_parse_benchmark ));
+
+	boost::unit_test::framework::master_test_suite().add(ts9);
+
+	boost::unit_test::test_suite* ts10 = BOOST_TEST_SUITE("Shared Parser Cache");
+	ts10->add( BOOST_TEST_CASE ( &shared_parser_cache_first_document_latency ));
+
+	boost::unit_test::framework::master_test_suite().add(ts10);
+
+	boost::unit_test::test_suite* ts11 = BOOST_TEST_SUITE("Relation Pair Pruning");
+	ts11->add( BOOST_TEST_CASE ( &relation_pair_pruning_output_unchanged ));
+
+	boost::unit_test::framework::master_test_suite().add(ts11);
+
+	boost::unit_test::test_suite* ts12 = BOOST_TEST_SUITE("MaxEnt Training");
+	ts12->add( BOOST_TEST_CASE ( &maxent_training_threads_match_single_thread ));
+	ts12->add( BOOST_TEST_CASE ( &maxent_training_lbfgs_gradient_matches_finite_differences ));
+
+	boost::unit_test::framework::master_test_suite().add(ts12);
+
+	boost::unit_test::test_suite* ts13 = BOOST_TEST_SUITE("SerifXML Loading");
+	ts13->add( BOOST_TEST_CASE ( &serifxml_loading_compact_dom_matches_full_dom ));
+
+	boost::unit_test::framework::master_test_suite().add(ts13);
+
+	boost::unit_test::test_suite* ts14 = BOOST_TEST_SUITE("UTF8 Input Stream");
+	ts14->add( BOOST_TEST_CASE ( &utf8_input_stream_file_buffer_matches_wifstream ));
+	ts14->add( BOOST_TEST_CASE ( &utf8_input_stream_line_views ));
+	ts14->add( BOOST_TEST_CASE ( &utf8_input_stream_model_loading_benchmark ));
+
+	boost::unit_test::framework::master_test_suite().add(ts14);
+
+	boost::unit_test::test_suite* ts15 = BOOST_TEST_SUITE("Profiler");
+	ts15->add( BOOST_TEST_CASE ( &profiler_nested_scopes_and_reports ));
+	ts15->add( BOOST_TEST_CASE ( &profiler_documents_per_thread ));
+	ts15->add( BOOST_TEST_CASE ( &profiler_disabled_overhead ));
+
+	boost::unit_test::framework::master_test_suite().add(ts15);
+
+	boost::unit_test::test_suite* ts16 = BOOST_TEST_SUITE("Concurrent Document Drivers");
+	ts16->add( BOOST_TEST_CASE ( &concurrent_document_drivers_match_single_driver ));
+
+	boost::unit_test::framework::master_test_suite().add(ts16);
+
+	boost::unit_test::test_suite* ts17 = BOOST_TEST_SUITE("Parser Model Image");
+	ts17->add( BOOST_TEST_CASE ( &parser_model_image_matches_text_model ));
+	ts17->add( BOOST_TEST_CASE ( &parser_model_image_staleness ));
+	ts17->add( BOOST_TEST_CASE ( &ngram_table_image_is_read_only ));
+	ts17->add( BOOST_TEST_CASE ( &ngram_table_reads_text_format ));
+
+	boost::unit_test::framework::master_test_suite().add(ts17);
+
+	boost::unit_test::test_suite* ts18 = BOOST_TEST_SUITE("Queue Driver Worker Pool");
+	ts18->add( BOOST_TEST_CASE ( &queue_driver_worker_pool_recovers_crash ));
+	ts18->add( BOOST_TEST_CASE ( &disk_queue_driver_wakes_on_new_document ));
+	ts18->add( BOOST_TEST_CASE ( &disk_queue_driver_polls_without_inotify ));
+
+	boost::unit_test::framework::master_test_suite().add(ts18);
+
+	boost::unit_test::test_suite* ts19 = BOOST_TEST_SUITE("Streaming Doc Theory");
+	ts19->add( BOOST_TEST_CASE ( &streaming_doc_theory_matches_best_theories ));
+
+	boost::unit_test::framework::master_test_suite().add(ts19);
+
+	boost::unit_test::test_suite* ts20 = BOOST_TEST_SUITE("Symbol Table");
+	ts20->add( BOOST_TEST_CASE ( &symbol_table_unit_test ));
+	ts20->add( BOOST_TEST_CASE ( &symbol_table_benchmark ));
+
+	boost::unit_test::framework::master_test_suite().add(ts20);
+
+	boost::unit_test::test_suite* ts21 = BOOST_TEST_SUITE("Block Feature Table");
+	ts21->add( BOOST_TEST_CASE ( &block_feature_table_key_lookup_matches_feature_lookup ));
+	ts21->add( BOOST_TEST_CASE ( &block_feature_table_unknown_tag_keeps_weights ));
+	ts21->add( BOOST_TEST_CASE ( &block_feature_table_benchmark ));
+	ts21->add( BOOST_TEST_CASE ( &block_feature_table_decode_benchmark ));
+
+	boost::unit_test::framework::master_test_suite().add(ts21);
+
+	boost::unit_test::test_suite* ts22 = BOOST_TEST_SUITE("Pattern Trigger Index");
+	ts22->add( BOOST_TEST_CASE ( &pattern_trigger_index_matches_unindexed ));
+
+	boost::unit_test::framework::master_test_suite().add(ts22);
+
+	boost::unit_test::test_suite* ts23 = BOOST_TEST_SUITE("Anytime Parsing");
+	ts23->add( BOOST_TEST_CASE ( &anytime_parsing_timeout_fallbacks ));
+	ts23->add( BOOST_TEST_CASE ( &anytime_parsing_off_output_unchanged ));
+
+	boost::unit_test::framework::master_test_suite().add(ts23);
+
 	return 0;
 }
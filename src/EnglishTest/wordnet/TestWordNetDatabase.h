@@ -0,0 +1,187 @@
+#include "Generic/common/ParamReader.h"
+#include "Generic/common/GenericTimer.h"
+#include "Generic/wordnet/WordNetDatabase.h"
+
+#pragma warning(push)
+#pragma warning(disable : 4266)
+#include <boost/test/unit_test.hpp>
+#pragma warning(pop)
+#include <boost/bind.hpp>
+#include <boost/thread.hpp>
+
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <vector>
+
+/** Tests for WordNetDatabase, the in-memory copy of the WordNet database
+  * that is used when the preload_wordnet parameter is true.  The database
+  * is loaded from the directory specified by word_net_dictionary_path; if
+  * that parameter is not specified, then the tests are skipped.
+  *
+  * wordnet_database_matches_library checks that stemming, sense counts,
+  * and synset lookups (including the hypernym trees that WordNet::getSynSet
+  * uses) give exactly the same results as the WordNet library, for a
+  * sample of the lemmas in the noun and verb index files and inflected
+  * forms of them.
+  *
+  * wordnet_database_concurrent_lookups checks that several threads can
+  * query the database at once, and reports the time that the database
+  * and the library take for the same lookups. */
+struct WordNetDatabaseFixture {
+	std::string dictionary_path;
+	std::vector<std::string> queries;
+
+	WordNetDatabaseFixture() {
+		dictionary_path = ParamReader::getParam("word_net_dictionary_path");
+		if (dictionary_path.empty())
+			return;
+		const char *suffixes[] = {"", "s", "es", "ed", "ing", "er"};
+		for (int pos = NOUN; pos <= VERB; pos++) {
+			char filename[256];
+			sprintf(filename, INDEXFILE, dictionary_path.c_str(), partnames[pos]);
+			std::ifstream in(filename);
+			std::string line;
+			for (int i = 0; std::getline(in, line); i++) {
+				if (line.empty() || line[0] == ' ' || i % 50 != 0)
+					continue;
+				std::string lemma = line.substr(0, line.find(' '));
+				for (size_t s = 0; s < sizeof(suffixes)/sizeof(suffixes[0]); s++)
+					queries.push_back(lemma + suffixes[s]);
+			}
+		}
+	}
+
+	/** Return true if the two synset lists (as returned by findtheinfo_ds)
+	  * are identical, except for glosses. */
+	static bool sameSynsets(SynsetPtr a, SynsetPtr b, bool compare_senses) {
+		if (a == 0 || b == 0)
+			return a == b;
+		if (a->hereiam != b->hereiam || a->sstype != b->sstype || strcmp(a->pos, b->pos) != 0 ||
+			a->wcount != b->wcount || a->whichword != b->whichword || a->ptrcount != b->ptrcount ||
+			a->fcount != b->fcount || a->searchtype != b->searchtype || (a->headword == 0) != (b->headword == 0))
+			return false;
+		for (int i = 0; i < a->wcount; i++) {
+			if (strcmp(a->words[i], b->words[i]) != 0 || a->lexid[i] != b->lexid[i] ||
+				(compare_senses && a->wnsns[i] != b->wnsns[i]))
+				return false;
+		}
+		for (int i = 0; i < a->ptrcount; i++) {
+			if (a->ptrtyp[i] != b->ptrtyp[i] || a->ptroff[i] != b->ptroff[i] || a->ppos[i] != b->ppos[i])
+				return false;
+		}
+		if (a->headword && strcmp(a->headword, b->headword) != 0)
+			return false;
+		return sameSynsets(a->ptrlist, b->ptrlist, true) &&
+			sameSynsets(a->nextform, b->nextform, compare_senses) &&
+			sameSynsets(a->nextss, b->nextss, compare_senses);
+	}
+
+	/** Look up the hypernyms of each query, and add the number of synsets
+	  * found to n_synsets. */
+	static void lookupHypernyms(const WordNetDatabase *database, const std::vector<std::string> *queries, long *n_synsets) {
+		for (size_t i = 0; i < queries->size(); i++) {
+			std::string stem;
+			if (!database->morphstr((*queries)[i].c_str(), NOUN, stem))
+				stem = (*queries)[i];
+			SynsetPtr syn = database->findtheinfo_ds(stem.c_str(), NOUN, -HYPERPTR, ALLSENSES);
+			for (SynsetPtr s = syn; s != 0; s = s->nextss)
+				for (SynsetPtr hyper = s->ptrlist; hyper != 0; hyper = hyper->ptrlist)
+					++(*n_synsets);
+			free_syns(syn);
+		}
+	}
+};
+
+void wordnet_database_matches_library() {
+	WordNetDatabaseFixture f;
+	if (f.dictionary_path.empty()) {
+		BOOST_TEST_MESSAGE("word_net_dictionary_path not specified; skipping");
+		return;
+	}
+	BOOST_REQUIRE(wninit(f.dictionary_path.c_str()) == 0);
+	WordNetDatabase database(f.dictionary_path.c_str());
+
+	const int ptrtypes[] = {-HYPERPTR, HYPOPTR, ANTPTR, SIMPTR};
+	char buffer[WORDBUF];
+	for (size_t i = 0; i < f.queries.size(); i++) {
+		const std::string &query = f.queries[i];
+		for (int pos = 1; pos <= NUMPARTS; pos++) {
+			strncpy(buffer, query.c_str(), WORDBUF - 1);
+			buffer[WORDBUF - 1] = '\0';
+			char *libraryStem = morphstr(buffer, pos);
+			std::string stem;
+			bool found = database.morphstr(query.c_str(), pos, stem);
+			BOOST_CHECK_MESSAGE(found == (libraryStem != 0) && (!found || stem == libraryStem),
+				"morphstr(\"" << query << "\", " << pos << ") differs from the WordNet library");
+			if (!found)
+				stem = query;
+
+			strncpy(buffer, stem.c_str(), WORDBUF - 1);
+			BOOST_CHECK_EQUAL(database.get_sense_count(stem.c_str(), pos), get_sense_count(buffer, pos));
+
+			for (size_t p = 0; p < sizeof(ptrtypes)/sizeof(ptrtypes[0]); p++) {
+				strncpy(buffer, stem.c_str(), WORDBUF - 1);
+				SynsetPtr librarySyn = findtheinfo_ds(buffer, pos, ptrtypes[p], ALLSENSES);
+				SynsetPtr syn = database.findtheinfo_ds(stem.c_str(), pos, ptrtypes[p], ALLSENSES);
+				BOOST_CHECK_MESSAGE(f.sameSynsets(librarySyn, syn, false), "findtheinfo_ds(\"" << stem << "\", "
+					<< pos << ", " << ptrtypes[p] << ") differs from the WordNet library");
+				free_syns(librarySyn);
+				free_syns(syn);
+			}
+		}
+	}
+}
+
+void wordnet_database_concurrent_lookups() {
+	WordNetDatabaseFixture f;
+	if (f.dictionary_path.empty()) {
+		BOOST_TEST_MESSAGE("word_net_dictionary_path not specified; skipping");
+		return;
+	}
+	BOOST_REQUIRE(wninit(f.dictionary_path.c_str()) == 0);
+
+	GenericTimer loadTimer;
+	loadTimer.startTimer();
+	WordNetDatabase database(f.dictionary_path.c_str());
+	loadTimer.stopTimer();
+
+	GenericTimer libraryTimer;
+	long library_synsets = 0;
+	char buffer[WORDBUF];
+	libraryTimer.startTimer();
+	for (size_t i = 0; i < f.queries.size(); i++) {
+		strncpy(buffer, f.queries[i].c_str(), WORDBUF - 1);
+		buffer[WORDBUF - 1] = '\0';
+		if (char *stem = morphstr(buffer, NOUN))
+			strcpy(buffer, stem);
+		SynsetPtr syn = findtheinfo_ds(buffer, NOUN, -HYPERPTR, ALLSENSES);
+		for (SynsetPtr s = syn; s != 0; s = s->nextss)
+			for (SynsetPtr hyper = s->ptrlist; hyper != 0; hyper = hyper->ptrlist)
+				++library_synsets;
+		free_syns(syn);
+	}
+	libraryTimer.stopTimer();
+
+	GenericTimer databaseTimer;
+	long database_synsets = 0;
+	databaseTimer.startTimer();
+	WordNetDatabaseFixture::lookupHypernyms(&database, &f.queries, &database_synsets);
+	databaseTimer.stopTimer();
+	BOOST_CHECK_EQUAL(database_synsets, library_synsets);
+
+	const int n_threads = 4;
+	std::vector<long> thread_synsets(n_threads, 0);
+	boost::thread_group threads;
+	for (int t = 0; t < n_threads; t++) {
+		threads.create_thread(boost::bind(&WordNetDatabaseFixture::lookupHypernyms,
+			&database, &f.queries, &thread_synsets[t]));
+	}
+	threads.join_all();
+	for (int t = 0; t < n_threads; t++)
+		BOOST_CHECK_EQUAL(thread_synsets[t], database_synsets);
+
+	BOOST_TEST_MESSAGE("Loaded " << database.getNSynsets() << " synsets in " << loadTimer.getTime() << " msec");
+	BOOST_TEST_MESSAGE("WordNet library: " << libraryTimer.getTime() << " msec for " << f.queries.size() << " hypernym lookups");
+	BOOST_TEST_MESSAGE("WordNetDatabase: " << databaseTimer.getTime() << " msec for " << f.queries.size() << " hypernym lookups");
+}
@@ -23,6 +23,9 @@ public:
 
 	/** Return true if the models for the specified stage have been loaded. */
 	virtual bool stageModelsAreLoaded(Stage stage);
+protected:
+	/** Correct-answer serif always processes sentences sequentially. */
+	virtual SentenceDriver *createWorker() { return 0; }
 private:
 
 	CorrectAnswers *_correctAnswers; // we do not own this - it points to a Singleton instance
@@ -14,6 +14,7 @@
 
 #include <iostream>
 #include <boost/foreach.hpp>
+#include <boost/functional/hash.hpp>
 #include <boost/scoped_ptr.hpp>
 
 namespace {
@@ -31,6 +32,7 @@ ActorEditDistance::ActorEditDistance(ActorInfo_ptr actorInfo) {
 	if (ParamReader::isParamTrue("limited_actor_match"))
 		return;
 
+	std::vector<ActorPattern *> gpeActors, perActors, orgActors, locActors, facActors;
 	BOOST_FOREACH(ActorPattern *ap, actorInfo->getPatterns()) {
 
 		// Don't allow edit distance on patterns that require context
@@ -38,17 +40,22 @@ ActorEditDistance::ActorEditDistance(ActorInfo_ptr actorInfo) {
 			continue;
 
 		if (ap->entityTypeSymbol == PER) 
-			_perActors.push_back(ap);
+			perActors.push_back(ap);
 		if (ap->entityTypeSymbol == ORG)
-			_orgActors.push_back(ap);
+			orgActors.push_back(ap);
 		if (ap->entityTypeSymbol == GPE)
-			_gpeActors.push_back(ap);
+			gpeActors.push_back(ap);
 		if (ap->entityTypeSymbol == LOC)
-			_locActors.push_back(ap);
+			locActors.push_back(ap);
 		if (ap->entityTypeSymbol == FAC)
-			_facActors.push_back(ap);
+			facActors.push_back(ap);
 				
 	}
+	_gpeActors.build(gpeActors);
+	_perActors.build(perActors);
+	_orgActors.build(orgActors);
+	_locActors.build(locActors);
+	_facActors.build(facActors);
 
 	// Nicknames
 	boost::scoped_ptr<UTF8InputStream> stream_scoped_ptr(UTF8InputStream::build());
@@ -115,7 +122,6 @@ ActorEditDistance::ActorEditDistanceMap ActorEditDistance::findCloseActors(const
 	std::wstring name = std::wstring(originalName->toWString());
 	delete originalName;
 	std::transform(name.begin(), name.end(), name.begin(), towlower);
-	size_t name_len = name.length();
 
 //	std::cout << "##############################################\n";
 //	std::cout << "Checking " << UnicodeUtil::toUTF8StdString(name) << "\n";
@@ -123,50 +129,60 @@ ActorEditDistance::ActorEditDistanceMap ActorEditDistance::findCloseActors(const
 
 	//_debugStream << L"-------" << name << L"-------\n";
 	
-	std::vector<ActorPattern *> *actorPatterns = 0;
-	if (mention->getEntityType().matchesGPE())
-		actorPatterns = &_gpeActors;
-	else if (mention->getEntityType().matchesPER())
-		actorPatterns = &_perActors;
-	else if (mention->getEntityType().matchesORG())
-		actorPatterns = &_orgActors;
-	else if (mention->getEntityType().matchesLOC())
-		actorPatterns = &_locActors;
-	else if (mention->getEntityType().matchesFAC())
-		actorPatterns = &_facActors;
-	else
+	EntityType et = mention->getEntityType();
+	if (getActorIndex(et) == 0)
 		return closeActors;
 
-	std::wstringstream wss;
-	wss << name << L"_" << mention->getEntityType().getName().to_string() << L"_" << threshold;
-	std::wstring cacheKey = wss.str();
+	CacheKey cacheKey(name, et.getName(), threshold);
+	boost::unordered_map<CacheKey, CacheList::iterator, CacheKeyHash>::iterator cached = _cacheIndex.find(cacheKey);
+	if (cached != _cacheIndex.end()) {
+		// Move the entry to the front of the list.
+		_cache.splice(_cache.begin(), _cache, (*cached).second);
+		return (*cached).second->second;
+	}
 
-	if (_cache.find(cacheKey) != _cache.end())
-		return _cache[cacheKey];
+	closeActors = findCloseActors(name, et, threshold);
+
+	_cache.push_front(std::make_pair(cacheKey, closeActors));
+	_cacheIndex[cacheKey] = _cache.begin();
+	if (_cache.size() > AED_MAX_ENTRIES) {
+		_cacheIndex.erase(_cache.back().first);
+		_cache.pop_back();
+	}
+
+	return closeActors;
+}
+
+ActorEditDistance::ActorEditDistanceMap ActorEditDistance::findCloseActors(const std::wstring &name, EntityType entityType, double threshold) {
+	ActorEditDistanceMap closeActors;
+	ActorNameIndex *actorIndex = getActorIndex(entityType);
+	if (actorIndex == 0)
+		return closeActors;
+	size_t name_len = name.length();
 
-	EntityType et = mention->getEntityType();
 	std::set<std::wstring> equivalentNameSet;
 	equivalentNameSet.insert(name);
-	expandNameToEquivalentSet(name, et, equivalentNameSet);	
-
-	for (size_t i = 0; i < actorPatterns->size(); i++) {
-		
-		std::wstring actorPattern = (*actorPatterns)[i]->lcString;
-		ActorId actor_id = (*actorPatterns)[i]->actor_id;
-
-		// Check for exact match between equivalent name set (including original name) and pattern
-		std::set<std::wstring>::iterator it1;
-		for (it1 = equivalentNameSet.begin(); it1 != equivalentNameSet.end(); ++it1) {
-			std::wstring n = *it1;
-			if (n == actorPattern) {
-				float similarity = (float)0.98;
-				if (closeActors.find(actor_id) == closeActors.end() || similarity > closeActors[actor_id])
-					closeActors[actor_id] = similarity;
-				break;
-			}
+	expandNameToEquivalentSet(name, entityType, equivalentNameSet);	
+
+	// Check for exact match between equivalent name set (including original name) and pattern
+	BOOST_FOREACH(const std::wstring &n, equivalentNameSet) {
+		_candidates.clear();
+		actorIndex->getExactMatches(n, _candidates);
+		BOOST_FOREACH(ActorPattern *ap, _candidates) {
+			ActorId actor_id = ap->actor_id;
+			float similarity = (float)0.98;
+			if (closeActors.find(actor_id) == closeActors.end() || similarity > closeActors[actor_id])
+				closeActors[actor_id] = similarity;
 		}
+	}
+
+	// Edit distance between name and pattern, for the patterns that the
+	// index can't rule out.
+	actorIndex->getCandidates(name, threshold, _candidates);
+	BOOST_FOREACH(ActorPattern *ap, _candidates) {
+		const std::wstring &actorPattern = ap->lcString;
+		ActorId actor_id = ap->actor_id;
 
-		// Edit distance between name and pattern
 		size_t pat_len = actorPattern.length();
 		if ((float)name_len / pat_len < threshold || (float)pat_len / name_len < threshold)
 			continue;
@@ -180,12 +196,29 @@ ActorEditDistance::ActorEditDistanceMap ActorEditDistance::findCloseActors(const
 			closeActors[actor_id] = similarity;
 	}
 
-	if (_cache.size() > AED_MAX_ENTRIES)
-		_cache.clear();
+	return closeActors;
+}
 
-	_cache[cacheKey] = closeActors;
+ActorNameIndex *ActorEditDistance::getActorIndex(EntityType entityType) {
+	if (entityType.matchesGPE())
+		return &_gpeActors;
+	else if (entityType.matchesPER())
+		return &_perActors;
+	else if (entityType.matchesORG())
+		return &_orgActors;
+	else if (entityType.matchesLOC())
+		return &_locActors;
+	else if (entityType.matchesFAC())
+		return &_facActors;
+	else
+		return 0;
+}
 
-	return closeActors;
+size_t ActorEditDistance::CacheKeyHash::operator()(const CacheKey &key) const {
+	size_t hash = boost::hash_value(key.name);
+	boost::hash_combine(hash, key.entityType.is_null() ? 0 : key.entityType.hash_code());
+	boost::hash_combine(hash, key.threshold);
+	return hash;
 }
 
 void ActorEditDistance::expandNameToEquivalentSet(std::wstring name, EntityType entityType, std::set<std::wstring> & eqNames) {
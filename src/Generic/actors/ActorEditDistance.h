@@ -8,8 +8,11 @@
 #include "Generic/xdoc/EditDistance.h"
 #include "Generic/actors/Identifiers.h"
 #include "Generic/actors/ActorInfo.h"
+#include "Generic/actors/ActorNameIndex.h"
 
 #include <boost/shared_ptr.hpp>
+#include <boost/unordered_map.hpp>
+#include <list>
 #include <vector>
 #include <set>
 
@@ -27,17 +30,41 @@ public:
 
 	ActorEditDistanceMap findCloseActors(const Mention *mention, double threshold, const SentenceTheory *st, const DocTheory *dt);
 
+	/** Return the actors whose patterns (of the given entity type) are
+	  * within the given similarity threshold of name, which should be 
+	  * lowercase.  This does not use the cache. */
+	ActorEditDistanceMap findCloseActors(const std::wstring &name, EntityType entityType, double threshold);
+
 private:
 	EditDistance _editDistance;
 	UTF8OutputStream _debugStream;
 
-	std::vector<ActorPattern *> _gpeActors;
-	std::vector<ActorPattern *> _perActors;
-	std::vector<ActorPattern *> _orgActors;
-	std::vector<ActorPattern *> _locActors;
-	std::vector<ActorPattern *> _facActors;
+	ActorNameIndex _gpeActors;
+	ActorNameIndex _perActors;
+	ActorNameIndex _orgActors;
+	ActorNameIndex _locActors;
+	ActorNameIndex _facActors;
+	std::vector<ActorPattern *> _candidates; // scratch space for findCloseActors()
+
+	ActorNameIndex *getActorIndex(EntityType entityType);
 
-	std::map<std::wstring, ActorEditDistanceMap> _cache;
+	/** A least-recently-used cache of findCloseActors() results, keyed by
+	  * the name, entity type and threshold. */
+	struct CacheKey {
+		std::wstring name;
+		Symbol entityType;
+		double threshold;
+		CacheKey(const std::wstring &name, Symbol entityType, double threshold)
+			: name(name), entityType(entityType), threshold(threshold) {}
+		bool operator==(const CacheKey &other) const {
+			return name == other.name && entityType == other.entityType && threshold == other.threshold; }
+	};
+	struct CacheKeyHash {
+		size_t operator()(const CacheKey &key) const;
+	};
+	typedef std::list<std::pair<CacheKey, ActorEditDistanceMap> > CacheList;
+	CacheList _cache; // most recently used first
+	boost::unordered_map<CacheKey, CacheList::iterator, CacheKeyHash> _cacheIndex;
 	static const size_t AED_MAX_ENTRIES = 1000;
 
 	std::map<std::wstring, std::set<std::wstring> > _nicknames;
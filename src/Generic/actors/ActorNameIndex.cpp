@@ -0,0 +1,133 @@
+// Copyright (c) 2012 by Raytheon BBN Technologies Corp.
+// All Rights Reserved.
+
+#include "Generic/common/leak_detection.h"
+
+#include "Generic/actors/ActorNameIndex.h"
+#include "Generic/actors/ActorPattern.h"
+
+#include <boost/foreach.hpp>
+#include <algorithm>
+#include <cmath>
+
+namespace {
+	// The character used to pad strings before they are split into bigrams.
+	const wchar_t BOUNDARY = L'\0';
+
+	bool shorterLcString(const ActorPattern *a, const ActorPattern *b) {
+		return a->lcString.length() < b->lcString.length();
+	}
+}
+
+void ActorNameIndex::build(const std::vector<ActorPattern *> &patterns) {
+	_patterns = patterns;
+	std::stable_sort(_patterns.begin(), _patterns.end(), shorterLcString);
+
+	_lengthStart.clear();
+	_postings.clear();
+	_exactMatches.clear();
+	boost::unordered_map<Bigram, boost::uint32_t> bigramCounts;
+	for (size_t i = 0; i < _patterns.size(); ++i) {
+		const std::wstring &lcString = _patterns[i]->lcString;
+		while (_lengthStart.size() <= lcString.length())
+			_lengthStart.push_back(i);
+		_exactMatches[lcString].push_back(_patterns[i]);
+		getBigramCounts(lcString, bigramCounts);
+		typedef std::pair<Bigram, boost::uint32_t> BigramCount;
+		BOOST_FOREACH(const BigramCount &bigramCount, bigramCounts)
+			_postings[bigramCount.first].push_back(Posting(static_cast<boost::uint32_t>(i), bigramCount.second));
+	}
+
+	_sharedBigrams.assign(_patterns.size(), 0);
+	_touchedPatterns.clear();
+}
+
+size_t ActorNameIndex::getLengthStart(size_t len) const {
+	return (len < _lengthStart.size()) ? _lengthStart[len] : _patterns.size();
+}
+
+void ActorNameIndex::getBigramCounts(const std::wstring &str, boost::unordered_map<Bigram, boost::uint32_t> &counts) {
+	counts.clear();
+	wchar_t prev = BOUNDARY;
+	for (size_t i = 0; i <= str.length(); ++i) {
+		wchar_t next = (i < str.length()) ? str[i] : BOUNDARY;
+		Bigram bigram = (static_cast<Bigram>(static_cast<boost::uint32_t>(prev)) << 32) | static_cast<boost::uint32_t>(next);
+		++counts[bigram];
+		prev = next;
+	}
+}
+
+void ActorNameIndex::getExactMatches(const std::wstring &name, std::vector<ActorPattern *> &matches) const {
+	boost::unordered_map<std::wstring, std::vector<ActorPattern *> >::const_iterator it = _exactMatches.find(name);
+	if (it != _exactMatches.end())
+		matches.insert(matches.end(), (*it).second.begin(), (*it).second.end());
+}
+
+void ActorNameIndex::getCandidates(const std::wstring &name, double threshold, std::vector<ActorPattern *> &candidates) {
+	candidates.clear();
+	size_t name_len = name.length();
+	if (threshold <= 0 || name_len == 0) {
+		candidates = _patterns;
+		return;
+	}
+
+	// Only patterns whose lengths are within the ratio threshold of the
+	// name's length can pass the length test.  (The bounds are loosened
+	// slightly to allow for rounding in that test.)
+	size_t min_len = static_cast<size_t>(floor(threshold * name_len));
+	size_t max_len = static_cast<size_t>(floor(name_len / threshold)) + 1;
+	size_t start = getLengthStart(min_len);
+	size_t end = getLengthStart(max_len + 1);
+	if (start >= end)
+		return;
+	max_len = std::min(max_len, _lengthStart.size() - 1);
+
+	// Count the bigrams that the name shares with each pattern in range.
+	boost::unordered_map<Bigram, boost::uint32_t> nameBigrams;
+	getBigramCounts(name, nameBigrams);
+	typedef std::pair<Bigram, boost::uint32_t> BigramCount;
+	BOOST_FOREACH(const BigramCount &bigramCount, nameBigrams) {
+		boost::unordered_map<Bigram, std::vector<Posting> >::const_iterator it = _postings.find(bigramCount.first);
+		if (it == _postings.end())
+			continue;
+		const std::vector<Posting> &postings = (*it).second;
+		// Binary search for the first pattern in range.
+		size_t lo = 0, hi = postings.size();
+		while (lo < hi) {
+			size_t mid = lo + (hi - lo) / 2;
+			if (postings[mid].pattern < start)
+				lo = mid + 1;
+			else
+				hi = mid;
+		}
+		for (size_t i = lo; i < postings.size() && postings[i].pattern < end; ++i) {
+			boost::uint32_t pattern = postings[i].pattern;
+			if (_sharedBigrams[pattern] == 0)
+				_touchedPatterns.push_back(pattern);
+			_sharedBigrams[pattern] += std::min(bigramCount.second, postings[i].count);
+		}
+	}
+
+	// A pattern of length m can only have similarity >= threshold if its
+	// edit distance d from the name is at most (1-threshold)*max(n, m),
+	// in which case they share at least max(n, m) + 1 - 2*d bigrams.  If
+	// that bound isn't positive, then every pattern of length m is a
+	// candidate, whether or not it shares any bigrams with the name.
+	std::vector<long> minShared(max_len + 1, 0);
+	for (size_t len = min_len; len <= max_len; ++len) {
+		size_t longest = std::max(name_len, len);
+		long max_distance = static_cast<long>(floor((1.0 - threshold) * longest + 1e-6));
+		minShared[len] = static_cast<long>(longest) + 1 - 2 * max_distance;
+		if (minShared[len] <= 0) {
+			candidates.insert(candidates.end(),
+				_patterns.begin() + getLengthStart(len), _patterns.begin() + getLengthStart(len + 1));
+		}
+	}
+	BOOST_FOREACH(boost::uint32_t pattern, _touchedPatterns) {
+		long required = minShared[_patterns[pattern]->lcString.length()];
+		if (required > 0 && static_cast<long>(_sharedBigrams[pattern]) >= required)
+			candidates.push_back(_patterns[pattern]);
+		_sharedBigrams[pattern] = 0;
+	}
+	_touchedPatterns.clear();
+}
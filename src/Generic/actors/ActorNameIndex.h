@@ -0,0 +1,81 @@
+// Copyright (c) 2012 by Raytheon BBN Technologies Corp.
+// All Rights Reserved.
+
+#ifndef ACTOR_NAME_INDEX_H
+#define ACTOR_NAME_INDEX_H
+
+#include <boost/cstdint.hpp>
+#include <boost/unordered_map.hpp>
+#include <string>
+#include <vector>
+
+class ActorPattern;
+
+/** An index over the lowercased strings (ActorPattern::lcString) of a set
+  * of actor patterns, which is used by ActorEditDistance to find the
+  * patterns that are within a given edit-distance similarity of a name
+  * without comparing the name to every pattern.
+  *
+  * Candidates are found with a character bigram "count filter": each
+  * string is padded with one boundary character on each side, and since
+  * a single edit can destroy at most two bigrams, two strings whose edit
+  * distance is d share at least max(len1, len2) + 1 - 2*d bigrams.  The
+  * patterns are stored in order of length, so only the patterns whose
+  * length could pass ActorEditDistance's length-ratio test are counted.
+  *
+  * The candidates are a superset of the patterns that meet the threshold;
+  * the caller is still responsible for computing the actual similarity.
+  * An ActorNameIndex is not thread-safe, since getCandidates() uses
+  * scratch space that is owned by the index. */
+class ActorNameIndex {
+public:
+	ActorNameIndex() {}
+
+	/** Index the given patterns, discarding any existing contents. */
+	void build(const std::vector<ActorPattern *> &patterns);
+
+	/** Set candidates to the patterns that could have similarity of at
+	  * least threshold with the given (lowercase) name, as computed by
+	  * EditDistance::similarity(), and that pass the length-ratio test
+	  * in ActorEditDistance::findCloseActors().  If threshold is not
+	  * positive, then every pattern is a candidate. */
+	void getCandidates(const std::wstring &name, double threshold, std::vector<ActorPattern *> &candidates);
+
+	/** Append the patterns whose lcString is equal to name to matches. */
+	void getExactMatches(const std::wstring &name, std::vector<ActorPattern *> &matches) const;
+
+	size_t size() const { return _patterns.size(); }
+
+private:
+	typedef boost::uint64_t Bigram;
+
+	struct Posting {
+		boost::uint32_t pattern; // index into _patterns
+		boost::uint32_t count;   // number of times the bigram occurs in the pattern
+		Posting(boost::uint32_t pattern, boost::uint32_t count): pattern(pattern), count(count) {}
+	};
+
+	// The patterns, sorted by the length of their lcString.
+	std::vector<ActorPattern *> _patterns;
+
+	// _lengthStart[len] is the index of the first pattern in _patterns
+	// whose lcString has at least len characters.
+	std::vector<size_t> _lengthStart;
+
+	// A map from each bigram to the patterns that contain it, in the same
+	// order as _patterns.
+	boost::unordered_map<Bigram, std::vector<Posting> > _postings;
+
+	// A map from lcString to the patterns that have it.
+	boost::unordered_map<std::wstring, std::vector<ActorPattern *> > _exactMatches;
+
+	// Scratch space for getCandidates(): the number of bigrams that each
+	// pattern shares with the query, and the patterns whose count is nonzero.
+	std::vector<boost::uint32_t> _sharedBigrams;
+	std::vector<boost::uint32_t> _touchedPatterns;
+
+	static void getBigramCounts(const std::wstring &str, boost::unordered_map<Bigram, boost::uint32_t> &counts);
+	size_t getLengthStart(size_t len) const;
+};
+
+#endif
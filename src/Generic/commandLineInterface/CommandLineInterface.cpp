@@ -145,6 +145,7 @@ int runSerifFromCommandLine(int argc, const char **argv) {
 		int open_file_retries = ParamReader::getOptionalIntParamWithDefaultValue("open_file_retries", 0);
 		if (open_file_retries > 0)
 			UTF8InputStream::setOpenFileRetries(open_file_retries);
+		UTF8InputStream::setUseFileBuffer(ParamReader::getOptionalTrueFalseParamWithDefaultVal("use_utf8_file_buffer", true));
 
 		// Load modules specified in the parameter file.
 		FeatureModule::load();
@@ -5,175 +5,292 @@
 #define CACHE_H
 
 #include "Generic/common/Symbol.h"
-#include "Generic/common/lru_cache.h"
-#if defined(_WIN32) || defined(__APPLE_CC__)
-enum CacheType { None, Simple };
-#else 
-enum CacheType { None,  Lru, Simple };
-#endif
+#include "Generic/common/SessionLogger.h"
+#include <boost/cstdint.hpp>
+#include <boost/noncopyable.hpp>
+#include <boost/thread/mutex.hpp>
+#include <string>
+#include <utility>
+#include <vector>
 
-// Forward declaration
-template<size_t N, typename HashMapClass> class NGramCache;
-template<size_t N> struct CopyCacheNGram;
+/** The kind of cache used by the parser's probability tables (set by the
+  * probs_cache_type parameter).  A Simple cache stops adding entries once
+  * it is full; an Lru cache evicts old entries to make room for new ones
+  * (using the CLOCK approximation to LRU; see NGramCache). */
+enum CacheType { None, Lru, Simple };
 
-/** A template used to provide typedefs for simple and lru caches.
- * The caches themselves are implemented by NGramCache, defined below.
+/** A fixed-size cache from ngrams (fixed-length Symbol arrays) to float
+ * values, used to memoize the parser's probability lookups.
+ *
+ * All of the cache's memory is allocated when it is constructed: each
+ * entry (a copy of the ngram and its value) is stored directly in an
+ * open-addressing hash table with linear probing, whose size is chosen
+ * to keep the load factor at or below 3/4 when the cache holds max_size
+ * entries.  Adding an entry never allocates memory.
+ *
+ * If evict is false, then new entries are dropped once the cache is
+ * full.  Otherwise, an entry is evicted using the CLOCK algorithm: each
+ * entry has a "referenced" bit that is set whenever it is found, and a
+ * clock hand sweeps over the table, clearing referenced bits, until it
+ * finds an entry whose bit is already clear.
  *
- * Note: The decision to use NGramQuickHash rather than NGramHash is
- * justified based on profiling.  In particular, the quick hash runs
- * about 50 times faster than the "better" hash, but only causes about
- * a 50% speed penalty when looking through hash buckets.  Overall,
- * using NGramQuickHash gives about a 30% self-time speedup for the
- * xyzProbs::lookup() methods.
+ * The cache can be split into several shards (selected by the low bits
+ * of the hash value; n_shards is rounded up to a power of two), each with
+ * max_size/n_shards entries and its own lock, so that several threads can
+ * use it at once.  A cache with a single shard does not take any locks,
+ * and is not thread-safe.
+ *
+ * Each shard counts the number of hits, misses, and evictions since the
+ * cache was last cleared.
  */
 template<size_t N>
-struct Cache {
-    typedef Symbol* NGRAM;
-	typedef NGramQuickHash<N> HashKey;
-	typedef NGramEquals<N> EqualKey;
-	typedef size_t sizeType;
-
-#if defined(_WIN32) || defined(__APPLE_CC__)
-    typedef NGramCache<N, serif::hash_map<NGRAM, float, HashKey, EqualKey> > simple;
-#else
-    typedef NGramCache<N, __gnu_cxx::hash_map<NGRAM, float, HashKey, EqualKey> > simple;
-    typedef NGramCache<N, lru_cache<NGRAM, float, HashKey, EqualKey> > lru;
-#endif
-};
-
-/** A hash map from fixed-length Symbol arrays to float values.
- * Symbol arrays are compared and hashed based on the list of Symbol
- * values they contain.  When the cache needs to add a new entry,
- * it makes a private copy of the Symbol array, and it is responsible
- * for deleting that private copy when the SimpleCache is destroyed.
- */
-template<size_t N, typename HashMapClass>
-class NGramCache {
+class NGramCache: boost::noncopyable {
 public:
-	/** Create a new cache with the given maximum size.  */
-	explicit NGramCache(size_t max_size=0) : _max_size(max_size), _cache(max_size) 
+	/** Create a new cache with room for max_size entries. */
+	explicit NGramCache(size_t max_size=0, bool evict=false, size_t n_shards=1)
+		: _n_shards(1), _shard_bits(0), _evict(evict)
 	{
-		// _ngrams contains raw (unintialized) memory.  
-		void *rawMemory = operator new[] (max_size * sizeof(Symbol) * N);
-		_ngrams = static_cast<Symbol*>(rawMemory);
-		// _ngext_ngram points to where the next ngram will go.
-		_next_ngram = _ngrams;
+		while (_n_shards < n_shards) {
+			_n_shards *= 2;
+			++_shard_bits;
+		}
+		_shards = _new Shard[_n_shards];
+		size_t shard_max_size = (max_size + _n_shards - 1) / _n_shards;
+		size_t n_slots = 1;
+		while (shard_max_size > 0 && n_slots * 3 < shard_max_size * 4 + 1)
+			n_slots *= 2;
+		for (size_t i = 0; i < _n_shards; ++i) {
+			_shards[i].max_size = shard_max_size;
+			_shards[i].slots.resize(shard_max_size > 0 ? n_slots : 0);
+		}
+		clear();
 	}
 
 	~NGramCache() {
-		// Destroy any ngrams we have constructed.
-		for(Symbol *p=_ngrams; p!=_next_ngram; ++p)
-			p->~Symbol();
-		// Destroy the raw memory
-		operator delete[](_ngrams);
+		delete[] _shards;
 	}
 
-	#if defined(_WIN32)
-		typedef typename HashMapClass::iterator iterator;
-	#else
-		typedef typename HashMapClass::const_iterator iterator;
-	#endif
-
-	typedef std::pair<Symbol*, float> value_type;
-
-	/** Add a new entry to the cache, if there is room; otherwise, do
-	 * nothing.  Precondition: ngram_key must not already be
-	 * associated with a value in the cache. */
-	void insert(value_type pair) {
-		if (_cache.size() < _max_size) {
-			// Make a local copy of the ngram key in the _ngrams vector.  This
-			// also increments _next_ngram.
-			Symbol *ngram_copy = _next_ngram;
-			CopyCacheNGram<N>()(_next_ngram, pair.first);
-			// Add the pair to the cache.
-			_cache.insert(std::make_pair(ngram_copy, pair.second));
+	/** If the cache contains the given ngram, then set value to its value
+	  * and return true; otherwise, return false. */
+	bool find(const Symbol* ngram, float &value) {
+		size_t hash = hashNGram(ngram);
+		if (_n_shards == 1)
+			return findInShard(_shards[0], hash, ngram, value);
+		Shard &shard = _shards[hash & (_n_shards - 1)];
+		boost::mutex::scoped_lock lock(shard.mutex);
+		return findInShard(shard, hash, ngram, value);
+	}
+
+	/** Associate the given value with the given ngram, evicting another
+	  * entry if necessary (or, if this cache does not evict, doing nothing
+	  * if it is full). */
+	void insert(const Symbol* ngram, float value) {
+		size_t hash = hashNGram(ngram);
+		if (_n_shards == 1) {
+			insertInShard(_shards[0], hash, ngram, value);
+			return;
 		}
+		Shard &shard = _shards[hash & (_n_shards - 1)];
+		boost::mutex::scoped_lock lock(shard.mutex);
+		insertInShard(shard, hash, ngram, value);
 	}
 
-	iterator find(Symbol* ngram_key) {
-		return _cache.find(ngram_key);
+	/** Remove all entries from the cache, and reset its counters. */
+	void clear() {
+		for (size_t s = 0; s < _n_shards; ++s) {
+			Shard &shard = _shards[s];
+			ShardLock lock(shard, _n_shards > 1);
+			for (size_t i = 0; i < shard.slots.size(); ++i) {
+				if (shard.slots[i].used)
+					shard.slots[i] = Slot();
+			}
+			shard.mask = shard.slots.empty() ? 0 : shard.slots.size() - 1;
+			shard.size = shard.hand = 0;
+			shard.hits = shard.misses = shard.evictions = 0;
+		}
 	}
 
-	iterator begin() {
-		return _cache.begin();
+	size_t size() const { return sum(&Shard::size); }
+	size_t getHits() const { return sum(&Shard::hits); }
+	size_t getMisses() const { return sum(&Shard::misses); }
+	size_t getEvictions() const { return sum(&Shard::evictions); }
+
+	/** Log the cache's counters (if it has been used) at the debug level. */
+	void logStats(const std::string& name) const {
+		if (getHits() + getMisses() > 0) {
+			SessionLogger::dbg("probs_cache") << name << " cache: " << size() << " entries, "
+				<< getHits() << " hits, " << getMisses() << " misses, "
+				<< getEvictions() << " evictions";
+		}
 	}
 
-	iterator end() {
-		return _cache.end();
+private:
+	struct Slot {
+		Symbol ngram[N];
+		float value;
+		size_t hash;
+		bool used;
+		bool referenced;
+		Slot(): value(0), hash(0), used(false), referenced(false) {}
+	};
+
+	struct Shard {
+		std::vector<Slot> slots;
+		size_t mask;
+		size_t max_size;
+		size_t size;
+		size_t hand;
+		size_t hits;
+		size_t misses;
+		size_t evictions;
+		boost::mutex mutex;
+	};
+
+	// Locks a shard's mutex (if enabled) until it goes out of scope.
+	class ShardLock {
+	public:
+		ShardLock(Shard &shard, bool enabled): _mutex(enabled ? &shard.mutex : 0) {
+			if (_mutex) _mutex->lock();
+		}
+		~ShardLock() { if (_mutex) _mutex->unlock(); }
+	private:
+		boost::mutex *_mutex;
+	};
+
+	size_t _n_shards;
+	size_t _shard_bits; // log2(_n_shards)
+	bool _evict;
+	Shard *_shards;
+
+	/** NGramQuickHash, scrambled so that both the shard (the low bits) and
+	  * the slot (the high bits) are well distributed. */
+	static size_t hashNGram(const Symbol* ngram) {
+		boost::uint64_t h = static_cast<boost::uint64_t>(NGramQuickHash<N>()(ngram)) * 0x9E3779B97F4A7C15ULL;
+		return static_cast<size_t>(h ^ (h >> 32));
 	}
 
-	size_t size() {
-		return _cache.size();
+	size_t slotFor(const Shard &shard, size_t hash) const {
+		return (hash >> _shard_bits) & shard.mask;
 	}
 
-	void clear() {
-		// Clear the hash table.
-		_cache.clear();
-		// Destroy any ngrams we have constructed.
-		for(Symbol *p=_ngrams; p!=_next_ngram; ++p)
-			p->~Symbol();
-		// Reset the _next_ngram pointer to the start of _ngrams.
-		_next_ngram = _ngrams;
+	/** Look the ngram up in the given shard (which the caller has locked,
+	  * if necessary). */
+	bool findInShard(Shard &shard, size_t hash, const Symbol* ngram, float &value) {
+		if (shard.max_size > 0) {
+			for (size_t i = slotFor(shard, hash); shard.slots[i].used; i = (i+1) & shard.mask) {
+				Slot &slot = shard.slots[i];
+				if (slot.hash == hash && NGramEquals<N>()(slot.ngram, ngram)) {
+					// Only the CLOCK algorithm reads the referenced bit.
+					if (_evict)
+						slot.referenced = true;
+					value = slot.value;
+					++shard.hits;
+					return true;
+				}
+			}
+		}
+		++shard.misses;
+		return false;
 	}
 
-private:
-	const size_t _max_size;
-	Symbol* _ngrams;
-	Symbol* _next_ngram;
-	HashMapClass _cache;
-};
+	/** Add the ngram to the given shard (which the caller has locked, if
+	  * necessary). */
+	void insertInShard(Shard &shard, size_t hash, const Symbol* ngram, float value) {
+		if (shard.max_size == 0)
+			return;
+		size_t i = slotFor(shard, hash);
+		for (; shard.slots[i].used; i = (i+1) & shard.mask) {
+			Slot &slot = shard.slots[i];
+			if (slot.hash == hash && NGramEquals<N>()(slot.ngram, ngram)) {
+				slot.value = value;
+				return;
+			}
+		}
+		if (shard.size == shard.max_size) {
+			if (!_evict)
+				return;
+			evictOne(shard);
+			// Evicting may have moved entries along the probe sequence.
+			for (i = slotFor(shard, hash); shard.slots[i].used; i = (i+1) & shard.mask) {}
+		}
+		Slot &slot = shard.slots[i];
+		for (size_t j = 0; j < N; ++j)
+			slot.ngram[j] = ngram[j];
+		slot.value = value;
+		slot.hash = hash;
+		slot.used = true;
+		slot.referenced = false;
+		++shard.size;
+	}
 
+	/** Evict one entry from a full shard, using the CLOCK algorithm. */
+	void evictOne(Shard &shard) {
+		while (true) {
+			Slot &slot = shard.slots[shard.hand];
+			if (slot.used && !slot.referenced)
+				break;
+			slot.referenced = false;
+			shard.hand = (shard.hand + 1) & shard.mask;
+		}
+		// Remove the entry at the clock hand, shifting later entries in its
+		// probe sequence back so that no lookup will stop short of them.
+		size_t hole = shard.hand;
+		for (size_t i = (hole+1) & shard.mask; shard.slots[i].used; i = (i+1) & shard.mask) {
+			size_t home = slotFor(shard, shard.slots[i].hash);
+			bool stays = (hole <= i) ? (hole < home && home <= i) : (hole < home || home <= i);
+			if (!stays) {
+				shard.slots[hole] = shard.slots[i];
+				hole = i;
+			}
+		}
+		shard.slots[hole] = Slot();
+		--shard.size;
+		++shard.evictions;
+	}
 
-// Copy-construct the ngram at src into to dst.
-template<size_t N>
-struct CopyCacheNGram {
-	void operator()(Symbol* &dst, Symbol* src) {
-		for (size_t i=0; i<N; ++i)
-			new(dst++) Symbol(*src++);
+	size_t sum(size_t Shard::*counter) const {
+		size_t total = 0;
+		for (size_t s = 0; s < _n_shards; ++s) {
+			ShardLock lock(_shards[s], _n_shards > 1);
+			total += _shards[s].*counter;
+		}
+		return total;
 	}
-};
 
-// Loop unrolling for common values of N:
-template<> struct CopyCacheNGram<8> {
-	void operator()(Symbol* &dst, Symbol* src) { 
-		new(dst++) Symbol(*src++); new(dst++) Symbol(*src++); 
-		new(dst++) Symbol(*src++); new(dst++) Symbol(*src++); 
-		new(dst++) Symbol(*src++); new(dst++) Symbol(*src++); 
-		new(dst++) Symbol(*src++); new(dst++) Symbol(*src); 
-	}};
-template<> struct CopyCacheNGram<7> {
-	void operator()(Symbol* &dst, Symbol* src) {
-		new(dst++) Symbol(*src++); new(dst++) Symbol(*src++); 
-		new(dst++) Symbol(*src++); new(dst++) Symbol(*src++); 
-		new(dst++) Symbol(*src++); new(dst++) Symbol(*src++);
-		new(dst++) Symbol(*src);
-	}};
-template<> struct CopyCacheNGram<6> {
-	void operator()(Symbol* &dst, Symbol* src) {
-		new(dst++) Symbol(*src++); new(dst++) Symbol(*src++); 
-		new(dst++) Symbol(*src++); new(dst++) Symbol(*src++); 
-		new(dst++) Symbol(*src++); new(dst++) Symbol(*src);
-	}};
-template<> struct CopyCacheNGram<5> {
-	void operator()(Symbol* &dst, Symbol* src) {
-		new(dst++) Symbol(*src++); new(dst++) Symbol(*src++); 
-		new(dst++) Symbol(*src++); new(dst++) Symbol(*src++);
-		new(dst++) Symbol(*src);
-	}};
-template<> struct CopyCacheNGram<4> {
-	void operator()(Symbol* &dst, Symbol* src) {
-		new(dst++) Symbol(*src++); new(dst++) Symbol(*src++); 
-		new(dst++) Symbol(*src++); new(dst++) Symbol(*src); 
-	}};
-template<> struct CopyCacheNGram<3> {
-	void operator()(Symbol* &dst, Symbol* src) {
-		new(dst++) Symbol(*src++); new(dst++) Symbol(*src++); 
-		new(dst++) Symbol(*src);
-	}};
-template<> struct CopyCacheNGram<2> {
-	void operator()(Symbol* &dst, Symbol* src) {
-		new(dst++) Symbol(*src++); new(dst++) Symbol(*src); 
-	}};
+public:
+	/** Iterates over the cache's entries, as (ngram, value) pairs.  The
+	  * cache must not be modified while an iterator is in use. */
+	class const_iterator {
+	public:
+		std::pair<const Symbol*, float> operator*() const {
+			const Slot &slot = _cache->_shards[_shard].slots[_slot];
+			return std::pair<const Symbol*, float>(slot.ngram, slot.value);
+		}
+		const_iterator& operator++() { ++_slot; skipUnused(); return *this; }
+		bool operator==(const const_iterator &other) const { return _shard == other._shard && _slot == other._slot; }
+		bool operator!=(const const_iterator &other) const { return !(*this == other); }
+	private:
+		friend class NGramCache;
+		const NGramCache *_cache;
+		size_t _shard;
+		size_t _slot;
+		const_iterator(const NGramCache *cache, size_t shard): _cache(cache), _shard(shard), _slot(0) { skipUnused(); }
+		void skipUnused() {
+			while (_shard < _cache->_n_shards) {
+				const std::vector<Slot> &slots = _cache->_shards[_shard].slots;
+				for (; _slot < slots.size(); ++_slot) {
+					if (slots[_slot].used)
+						return;
+				}
+				++_shard;
+				_slot = 0;
+			}
+		}
+	};
+	typedef const_iterator iterator;
 
+	const_iterator begin() const { return const_iterator(this, 0); }
+	const_iterator end() const { return const_iterator(this, _n_shards); }
+};
 
 #endif
@@ -5,6 +5,8 @@
 #define CACHE_STORAGE_H
 
 #include "Generic/common/Cache.h"
+#include "Generic/common/MappedModelImage.h"
+#include "Generic/common/NgramScoreTable.h"
 
 #include "Generic/common/ParamReader.h"
 #include "Generic/common/UTF8Token.h"
@@ -13,73 +15,106 @@
 #include "Generic/common/UTF8InputStream.h"
 #include "Generic/common/UTF8OutputStream.h"
 #include <boost/scoped_ptr.hpp>
+#include <boost/shared_ptr.hpp>
+#include <climits>
+#include <string>
 
 
 template<size_t N>
 struct CacheStorage {
 
-  static void readCache(const char* case_tag, const char* cacheSuffix, typename Cache<N>::simple& table, long max) {
+  static void readCache(const char* case_tag, const char* cacheSuffix, NGramCache<N>& table, long max) {
     readCache(case_tag, cacheSuffix, 0, table, max);
   }
 
-  static void writeCache(const char* case_tag, const char* cacheSuffix, typename Cache<N>::simple& table) {
+  static void writeCache(const char* case_tag, const char* cacheSuffix, NGramCache<N>& table) {
     writeCache(case_tag, cacheSuffix, 0, table);
   }
 
-  static void readCache(const char* case_tag, const char* cacheSuffix, const char* cache_tag, typename Cache<N>::simple& table, long max) {
+  static void readCache(const char* case_tag, const char* cacheSuffix, const char* cache_tag, NGramCache<N>& table, long max) {
+	  readPreloadFile(case_tag, cacheSuffix, cache_tag, table, max);
+  }
+
+  /** Read the entries of the cache pre-load file that readCache() would
+    * read into the given table, without any limit on their number.  Return
+    * false if there is no pre-load file. */
+  static bool readProfile(const char* case_tag, const char* cacheSuffix, const char* cache_tag, NgramScoreTableGen<N>& table) {
+	  return readPreloadFile(case_tag, cacheSuffix, cache_tag, table, LONG_MAX);
+  }
+
+  /** Add the given table to a new section of a cache image, named after
+    * the case tag, suffix, and cache tag (as pre-load files are). */
+  static void writeImage(const char* case_tag, const char* cacheSuffix, const char* cache_tag, NgramScoreTableGen<N>& table, MappedModelImageWriter& writer) {
+	  writer.beginSection(cacheName(case_tag, cacheSuffix, cache_tag).c_str());
+	  table.writeImage(writer);
+  }
+
+  /** Return the table that writeImage() added to the given cache image,
+    * which is used in place from the mapped image; or return 0 if the
+    * image has no table for these tags. */
+  static NgramScoreTableGen<N>* readImage(boost::shared_ptr<const MappedModelImage> image, const char* case_tag, const char* cacheSuffix, const char* cache_tag) {
+	  std::string name = cacheName(case_tag, cacheSuffix, cache_tag);
+	  if (!image->hasSection(name.c_str())) {
+		  SessionLogger::warn("cache") << "Cache image " << image->getFilename() << " has no " << name << " cache" << std::endl;
+		  return 0;
+	  }
+	  MappedModelImage::Section section(image, name.c_str());
+	  NgramScoreTableGen<N>* table = _new NgramScoreTableGen<N>(section);
+	  SessionLogger::info("cache") << "Using " << table->get_size() << " shared " << name << " cache entries from " << image->getFilename() << std::endl;
+	  return table;
+  }
+  
+  static void writeCache(const char* case_tag, const char* cacheSuffix, const char* cache_tag, NGramCache<N>& table) {
+	  std::string temp_buffer = ParamReader::getParam("probs_cache_out_path");
+	  if(!temp_buffer.empty()) {
+		  UTF8OutputStream stream;
+		  std::string buffer = temp_buffer + cacheName(case_tag, cacheSuffix, cache_tag);
+		  stream.open(buffer.c_str());
+		  print_to_open_stream(stream, table);
+		  stream.close();
+	  }
+  }
+
+  private:
+
+  /** The name of the cache for the given tags: [cache_tag-]case_tag-suffix */
+  static std::string cacheName(const char* case_tag, const char* cacheSuffix, const char* cache_tag) {
+	  std::string name = std::string(case_tag) + "-" + cacheSuffix;
+	  if (cache_tag != 0)
+		  name = std::string(cache_tag) + "-" + name;
+	  return name;
+  }
+
+  template<typename Table>
+  static bool readPreloadFile(const char* case_tag, const char* cacheSuffix, const char* cache_tag, Table& table, long max) {
 	  std::string temp_buffer = ParamReader::getParam("probs_cache_in_path");
 	  if(!temp_buffer.empty()) {
 		  boost::scoped_ptr<UTF8InputStream> stream_scoped_ptr(UTF8InputStream::build());
 		  UTF8InputStream& stream(*stream_scoped_ptr);
-		  std::string buffer;
-		  std::string case_tag_str(case_tag);
-		  std::string cache_suffix_str(cacheSuffix);
-		  if (cache_tag == 0) {
-			  buffer = temp_buffer + case_tag_str + "-" + cache_suffix_str;
-		  } else {
-			  std::string cache_tag_str(cache_tag);			  
-			  buffer = temp_buffer + cache_tag_str + "-" + case_tag_str + "-" + cache_suffix_str;
-		  }
+		  std::string buffer = temp_buffer + cacheName(case_tag, cacheSuffix, cache_tag);
 		  try {
 			  stream.open(buffer.c_str());
 			  init_table(stream, table, max);
 			  stream.close();
+			  return true;
 		  } catch (UnexpectedInputException) {
 			  SessionLogger::warn("cache") << "Unable to read cache pre-load file; skipping cache pre-load: " << buffer << std::endl;
-			  return;
-		  }
-	  }
-  }
-  
-  static void writeCache(const char* case_tag, const char* cacheSuffix, const char* cache_tag, typename Cache<N>::simple& table) {
-	  std::string temp_buffer = ParamReader::getParam("probs_cache_out_path");
-	  if(!temp_buffer.empty()) {
-		  UTF8OutputStream stream;
-		  std::string buffer;
-		  std::string case_tag_str(case_tag);
-		  std::string cache_suffix_str(cacheSuffix);
-		  if (cache_tag == 0) {
-			  buffer = temp_buffer + case_tag_str + "-" + cache_suffix_str;
-		  } else {
-			  std::string cache_tag_str(cache_tag);	
-			  buffer = temp_buffer + cache_tag_str + "-" + case_tag_str + "-" + cache_suffix_str;
 		  }
-		  stream.open(buffer.c_str());
-		  print_to_open_stream(stream, table);
-		  stream.close();
 	  }
+	  return false;
   }
 
-  private:
-  
-  static void print_to_open_stream(UTF8OutputStream& out, typename Cache<N>::simple& table) 
+  static void addEntry(NGramCache<N>& table, Symbol* ngram, float score) { table.insert(ngram, score); }
+  static void addEntry(NgramScoreTableGen<N>& table, Symbol* ngram, float score) { table.add(ngram, score); }
+
+  static void print_to_open_stream(UTF8OutputStream& out, NGramCache<N>& table) 
   {
     
-    typename Cache<N>::sizeType table_size = table.size();
+    size_t table_size = table.size();
     out << (unsigned int)table_size;
     out << "\n";
     
-    for (typename Cache<N>::simple::iterator iter = table.begin() ; iter != table.end() ; ++iter) {
+    for (typename NGramCache<N>::const_iterator iter = table.begin() ; iter != table.end() ; ++iter) {
       out << "((";
       for (size_t j = 0; j < N - 1; j++) {
         out << (*iter).first[j].to_string();
@@ -95,7 +130,8 @@ struct CacheStorage {
     
   }
   
-  static void init_table(UTF8InputStream& stream, typename Cache<N>::simple& table, long max)
+  template<typename Table>
+  static void init_table(UTF8InputStream& stream, Table& table, long max)
   {
     
     UTF8Token token;
@@ -110,7 +146,7 @@ struct CacheStorage {
     
     for (int i = 0; i < numEntries; i++) {
       
-      Symbol* ngram = _new Symbol[N];
+      Symbol ngram[N];
       
       stream >> token;
       
@@ -149,7 +185,7 @@ struct CacheStorage {
         throw UnexpectedInputException("CacheStorage::init_table()",c);
       }
       
-      table.insert(std::make_pair(ngram, score));
+      addEntry(table, ngram, score);
       
     }
   }
@@ -7,11 +7,16 @@
 #include "Generic/common/InternalInconsistencyException.h"
 #include "Generic/common/SessionLogger.h"
 #include "Generic/common/DebugStream.h"
+#include <cstdlib>
+#include <fstream>
 #include <string>
 
 #ifndef _WIN32
 #include <unistd.h>
 #endif
+#ifdef __GLIBC__
+#include <malloc.h>
+#endif
 
 bool HeapStatus::_active = true;
 
@@ -46,6 +51,49 @@ size_t HeapStatus::getHeapSize() {
 #endif
 }
 
+size_t HeapStatus::getResidentMemory() {
+#if defined(_WIN32)
+	return 0; // Unknown.
+#else
+	// The second field of statm is the number of resident pages.
+	ifstream proc_status("/proc/self/statm");
+	size_t num_pages = 0, num_resident_pages = 0;
+	if (proc_status >> num_pages >> num_resident_pages)
+		return num_resident_pages * getpagesize();
+	return 0; // Unknown.
+#endif
+}
+
+size_t HeapStatus::getPeakResidentMemory() {
+#if defined(_WIN32)
+	return 0; // Unknown.
+#else
+	ifstream proc_status("/proc/self/status");
+	string line;
+	while (getline(proc_status, line)) {
+		if (line.compare(0, 6, "VmHWM:") == 0)
+			return strtoul(line.c_str() + 6, 0, 10) * 1024; // reported in kB
+	}
+	return 0; // Unknown.
+#endif
+}
+
+void HeapStatus::resetPeakResidentMemory() {
+#if !defined(_WIN32)
+	// Writing 5 to clear_refs resets VmHWM to the current resident set size
+	// (on Linux 4.0 and later; otherwise, this has no effect).
+	ofstream clear_refs("/proc/self/clear_refs");
+	if (clear_refs.good())
+		clear_refs << "5";
+#endif
+}
+
+void HeapStatus::releaseFreeMemory() {
+#ifdef __GLIBC__
+	malloc_trim(0);
+#endif
+}
+
 void HeapStatus::takeReading(std::string s) {
 	takeReading(s.c_str());
 }
@@ -27,6 +27,29 @@ public:
 	 */
 	static size_t getHeapSize();
 
+	/**
+	 * Return the number of bytes of physical memory used by this process
+	 * (its resident set size).  Unlike getHeapSize(), this is cheap, and
+	 * works whether or not this class is active.  Returns 0 if the size is
+	 * not known (it is currently only available on Linux).
+	 */
+	static size_t getResidentMemory();
+
+	/**
+	 * Return the largest resident set size of this process since the last
+	 * call to resetPeakResidentMemory() (or since the process started, if
+	 * the peak can't be reset), or 0 if it is not known.
+	 */
+	static size_t getPeakResidentMemory();
+	static void resetPeakResidentMemory();
+
+	/**
+	 * Ask the heap to return the free memory that it is holding to the
+	 * system, so that the resident set size reflects memory in use (this
+	 * currently only does anything with glibc).
+	 */
+	static void releaseFreeMemory();
+
 	/**
 	 * Perform a getHeapSize and store a corresponding message.
 	 */
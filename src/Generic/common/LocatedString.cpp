@@ -487,15 +487,127 @@ void LocatedString::replace(int pos, int len, const wchar_t *repl) {
  */
 void LocatedString::replace(const wchar_t *find, const wchar_t *repl) {
 	int find_len = static_cast<int>(wcslen(find));
-	int repl_len = static_cast<int>(wcslen(repl));
+	if (find_len == 0) {
+		if (length() > 0)
+			throw InternalInconsistencyException("LocatedString::replace()",
+										   "negative length parameter");
+		return;
+	}
+	// Since the search for the next occurrence always starts after the
+	// replacement text, the occurrences that get replaced are just the
+	// non-overlapping occurrences in the original string; so they can all
+	// be replaced in a single pass.
+	std::vector<Edit> edits;
+	std::wstring repl_str(repl);
 	int start = 0;
 	while (start < length()) {
 		int pos = indexOf(find, start);
 		if (pos == -1)
-			return;
-		replace(pos, find_len, repl);
-		start = pos + repl_len;
+			break;
+		edits.push_back(Edit(pos, find_len, repl_str));
+		start = pos + find_len;
+	}
+	applyEdits(edits);
+}
+
+void LocatedString::applyEdits(const std::vector<Edit> &edits) {
+	if (edits.empty())
+		return;
+	int old_length = length();
+	int prev_end = 0;
+	for (std::vector<Edit>::const_iterator it = edits.begin(); it != edits.end(); ++it) {
+		if (it->len <= 0)
+			throw InternalInconsistencyException("LocatedString::applyEdits()",
+										   "negative length parameter");
+		if (it->pos < prev_end)
+			throw InternalInconsistencyException("LocatedString::applyEdits()",
+										   "edits are out of order or overlap");
+		if (it->pos + it->len > old_length)
+			throw InternalInconsistencyException::arrayIndexException(
+				"LocatedString::applyEdits()", old_length, it->pos + it->len);
+		prev_end = it->pos + it->len;
 	}
+
+	std::wstring new_text;
+	std::vector<OffsetEntry> new_offsets;
+	new_text.reserve(_text.size());
+	new_offsets.reserve(_offsets.size() + edits.size());
+
+	// cur is the part of _offsets[entry_num] that has not been copied or
+	// replaced yet.  Its positions are positions in the original string;
+	// when a previous edit ended inside it, its start has been moved up
+	// exactly as replace() would have done.  The text before copied_to has
+	// already been copied or replaced.
+	size_t entry_num = 0;
+	OffsetEntry cur = _offsets[0];
+	bool has_cur = true;
+	int copied_to = 0;
+	for (std::vector<Edit>::const_iterator it = edits.begin(); it != edits.end(); ++it) {
+		int pos = it->pos;
+		int end = it->pos + it->len;
+
+		// Copy the unchanged text and entries before the edit.
+		int shift = static_cast<int>(new_text.size()) - copied_to;
+		new_text.append(_text, copied_to, pos - copied_to);
+		while (cur.endPos <= pos) {
+			new_offsets.push_back(cur);
+			new_offsets.back().startPos += shift;
+			new_offsets.back().endPos += shift;
+			cur = _offsets[++entry_num];
+		}
+
+		// Truncate the entry that contains the start of the edit.
+		OffsetRange new_offset(startOffsetGroup(cur, pos), OffsetGroup());
+		if (cur.startPos < pos) {
+			new_offsets.push_back(OffsetEntry(cur.startPos+shift, pos+shift, cur.startOffset,
+				endOffsetGroup(cur, pos-1), cur.is_edt_skip_region));
+		}
+
+		// Skip the entries that are replaced entirely, and move up the start
+		// of the entry that contains the end of the edit.
+		while (cur.endPos < end)
+			cur = _offsets[++entry_num];
+		new_offset.end = endOffsetGroup(cur, end-1);
+		if (cur.endPos > end) {
+			cur.startOffset = startOffsetGroup(cur, end);
+			cur.startPos = end;
+		} else if (entry_num+1 < _offsets.size()) {
+			cur = _offsets[++entry_num];
+		} else {
+			has_cur = false;
+		}
+
+		// Add one entry for each replacement character.  As in insert(), they
+		// take their skip-region flag from the character that follows them,
+		// or from the preceding character if they end the string.
+		bool is_edt_skip_region = has_cur ? cur.is_edt_skip_region :
+			(!new_offsets.empty() && new_offsets.back().is_edt_skip_region);
+		int new_pos = static_cast<int>(new_text.size());
+		for (size_t i = 0; i < it->repl.size(); ++i) {
+			new_offsets.push_back(OffsetEntry(new_pos+static_cast<int>(i), new_pos+static_cast<int>(i)+1,
+				new_offset.start, new_offset.end, is_edt_skip_region));
+		}
+		new_text.append(it->repl);
+		copied_to = end;
+	}
+
+	// Copy the unchanged text and entries after the last edit.
+	int shift = static_cast<int>(new_text.size()) - copied_to;
+	new_text.append(_text, copied_to, std::wstring::npos);
+	if (has_cur) {
+		for (;;) {
+			new_offsets.push_back(cur);
+			new_offsets.back().startPos += shift;
+			new_offsets.back().endPos += shift;
+			if (++entry_num == _offsets.size())
+				break;
+			cur = _offsets[entry_num];
+		}
+	}
+
+	_text.swap(new_text);
+	_offsets.swap(new_offsets);
+	assert(checkOffsetInvariants());
 }
 
 void LocatedString::replace(const std::wstring & find, const std::wstring & repl) {
@@ -834,8 +946,11 @@ Symbol LocatedString::substringAsSymbol(int start_index, int end_index) const {
 void LocatedString::replaceNonstandardUnicodeWhitespace(){
 	// this code is a portion of Tokenizer::replaceNonstandardUnicodes
 	// it belongs in a utility directory but is being tested locally where first used
+	// The replacements are collected and then applied in a single pass.
+	// (Index numbers in the log messages are positions in the original string.)
 	int len = static_cast<int>(_text.length());
 	char msg[200];
+	std::vector<Edit> edits;
 	for (int index = 0; index < len; index++) {
 		wchar_t wch = charAt(index);
 		msg[0] = 0;
@@ -854,18 +969,17 @@ void LocatedString::replaceNonstandardUnicodeWhitespace(){
 				// replace with vanilla space
 				sprintf_s(msg, "U+%x with blank at index %d\n",
 				  wch, index);
-				replace(index,1,L" ");
+				edits.push_back(Edit(index, 1, L" "));
 		}else if ((wch == 0x0085) ||  // new Unicode "next line"
 				  (wch == 0x2028))  { // "line separator"	
 			// replace with old-fashioned line feed (Unix new line)
 				sprintf_s(msg, "U+%x with line feed at index %d\n",
 						wch, index);
-				replace(index,1,L"\x0a");
+				edits.push_back(Edit(index, 1, L"\x0a"));
 		}else if (wch == 0x2029){ // "paragraph separator"
 				sprintf_s(msg, "U+%x with double line feed at index %d\n",
 						wch, index);
-				replace(index,1,L"\x0a\x0a"); // two new lines
-				len++;
+				edits.push_back(Edit(index, 1, L"\x0a\x0a")); // two new lines
 		}
 		if (msg[0] != 0){
 			//std::cerr<<msg;
@@ -873,6 +987,7 @@ void LocatedString::replaceNonstandardUnicodeWhitespace(){
 			//std::cerr<<"debug tokenizer: replaceNonstandardUnicodeWhitespace replacing char " <<msg;
 		}
 	}
+	applyEdits(edits);
 }
 
 bool LocatedString::isValidTagName(int pos) const {
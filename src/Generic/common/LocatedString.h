@@ -168,6 +168,26 @@ public: /* ================ non-const (modifying) methods ================= */
 	  * characters are set. */
 	void replace( const std::wstring & find, const std::wstring & repl);
 
+	/** A single edit for applyEdits(): replace the len characters starting
+	  * at position pos with repl (which may be empty). */
+	struct Edit {
+		int pos;
+		int len;
+		std::wstring repl;
+		Edit(int pos, int len, const std::wstring &repl): pos(pos), len(len), repl(repl) {}
+	};
+
+	/** Apply a batch of edits in a single pass over the string.  Positions
+	  * refer to the string before any of the edits are applied; the edits
+	  * must be sorted by position, must not overlap, and must each replace
+	  * at least one character.  The result (including all offsets) is the
+	  * same as calling replace(pos, len, repl) for each edit in turn, from
+	  * first to last, after adjusting each position for the length changes
+	  * made by the edits before it; but it takes time proportional to the
+	  * length of the string plus the number of edits, rather than their
+	  * product. */
+	void applyEdits(const std::vector<Edit> &edits);
+
 		/** Find any occurance of the string 'find' and replace with 'repl'.
 	*	See above description of how the offsets of the replacement characters are set.
 	*	This replace continues to look where it last found an occurance of 'find'
@@ -455,6 +475,11 @@ private: /* ================ helper methods ================= */
 
 	void insert(const wchar_t *str, int pos, const OffsetRange &new_offset);
 
+	// The offset groups of the character at position pos, computed from the
+	// given entry (which must cover pos).
+	OffsetGroup startOffsetGroup(const OffsetEntry &entry, int pos) const;
+	OffsetGroup endOffsetGroup(const OffsetEntry &entry, int pos) const;
+
 public: /* ================ Serialization ================= */
 	// For saving state:
 	void updateObjectIDTable() const;
@@ -521,8 +546,20 @@ private: /* ================ DEPRECATED METHODS ================= */
 	void replaceRight(...);                         // DEPRECATED: use remove() instead.
 
 public:
-	void getStartOffset(int pos, CharOffset& result) const {
-		const OffsetEntry& entry = _offsets[findOffsetEntryBefore(pos)];
+	template<typename OffsetType>
+	void getStartOffset(int pos, OffsetType& result) const {
+		getStartOffset(_offsets[findOffsetEntryBefore(pos)], pos, result);
+	}
+
+	template<typename OffsetType>
+	void getEndOffset(int pos, OffsetType& result) const {
+		getEndOffset(_offsets[findOffsetEntryBefore(pos)], pos, result);
+	}
+
+	// The offsets of the character at position pos, which must be covered by
+	// the given entry.  (The entry need not be one of this string's entries;
+	// see applyEdits().)
+	void getStartOffset(const OffsetEntry& entry, int pos, CharOffset& result) const {
 		assert(pos >= entry.startPos && pos <= (entry.endPos-1));
 		if (pos == entry.startPos)
 			result = entry.startOffset.charOffset;
@@ -530,8 +567,7 @@ public:
 			result = CharOffset(entry.startOffset.charOffset.value() + (pos-entry.startPos));
 	}
 
-	void getEndOffset(int pos, CharOffset& result) const {
-		const OffsetEntry& entry = _offsets[findOffsetEntryBefore(pos)];
+	void getEndOffset(const OffsetEntry& entry, int pos, CharOffset& result) const {
 		assert(pos >= entry.startPos && pos <= (entry.endPos-1));
 		if (pos == (entry.endPos-1))
 			result = entry.endOffset.charOffset;
@@ -539,8 +575,7 @@ public:
 			result = CharOffset(entry.startOffset.charOffset.value() + (pos-entry.startPos));
 	}
 
-	void getStartOffset(int pos, EDTOffset& result) const {
-		const OffsetEntry& entry = _offsets[findOffsetEntryBefore(pos)];
+	void getStartOffset(const OffsetEntry& entry, int pos, EDTOffset& result) const {
 		assert(pos >= entry.startPos && pos <= (entry.endPos-1));
 		if (entry.is_edt_skip_region)
 			#ifdef USE_UNDEFINED_OFFSETS_FOR_SKIP_EDT_REGIONS
@@ -554,8 +589,7 @@ public:
 			result = EDTOffset(entry.startOffset.edtOffset.value() + (pos-entry.startPos));
 	}
 
-	void getEndOffset(int pos, EDTOffset& result) const {
-		const OffsetEntry& entry = _offsets[findOffsetEntryBefore(pos)];
+	void getEndOffset(const OffsetEntry& entry, int pos, EDTOffset& result) const {
 		assert(pos >= entry.startPos && pos <= (entry.endPos-1));
 		if (entry.is_edt_skip_region)
 			#ifdef USE_UNDEFINED_OFFSETS_FOR_SKIP_EDT_REGIONS
@@ -569,8 +603,7 @@ public:
 			result = EDTOffset(entry.startOffset.edtOffset.value() + (pos-entry.startPos));
 	}
 
-	void getStartOffset(int pos, ASRTime& result) const {
-		const OffsetEntry& entry = _offsets[findOffsetEntryBefore(pos)];
+	void getStartOffset(const OffsetEntry& entry, int pos, ASRTime& result) const {
 		assert(pos >= entry.startPos && pos <= (entry.endPos-1));
 		if (pos == entry.startPos)
 			result = entry.startOffset.asrTime;
@@ -578,8 +611,7 @@ public:
 			result = ASRTime();
 	}
 
-	void getEndOffset(int pos, ASRTime& result) const {
-		const OffsetEntry& entry = _offsets[findOffsetEntryBefore(pos)];
+	void getEndOffset(const OffsetEntry& entry, int pos, ASRTime& result) const {
 		assert(pos >= entry.startPos && pos <= (entry.endPos-1));
 		if (pos == (entry.endPos-1))
 			result = entry.startOffset.asrTime;
@@ -587,8 +619,7 @@ public:
 			result = ASRTime();
 	}
 
-	void getStartOffset(int pos, ByteOffset& result) const {
-		const OffsetEntry& entry = _offsets[findOffsetEntryBefore(pos)];
+	void getStartOffset(const OffsetEntry& entry, int pos, ByteOffset& result) const {
 		assert(pos >= entry.startPos && pos <= (entry.endPos-1));
 		int byteOffset = entry.startOffset.byteOffset.value();
 		for (int i=entry.startPos; i<pos; i++)
@@ -596,8 +627,7 @@ public:
 		result = ByteOffset(byteOffset);
 	}
 
-	void getEndOffset(int pos, ByteOffset& result) const {
-		const OffsetEntry& entry = _offsets[findOffsetEntryBefore(pos)];
+	void getEndOffset(const OffsetEntry& entry, int pos, ByteOffset& result) const {
 		assert(pos >= entry.startPos && pos <= (entry.endPos-1));
 		if (pos == (entry.endPos-1))
 			result = entry.endOffset.byteOffset;
@@ -612,12 +642,36 @@ public:
 
 inline OffsetGroup LocatedString::startOffsetGroup(int pos) const {
 	check_bounds(pos, "LocatedString::startOffsetGroupAt");
-	return OffsetGroup(start<ByteOffset>(pos), start<CharOffset>(pos), start<EDTOffset>(pos), start<ASRTime>(pos));
+	return startOffsetGroup(_offsets[findOffsetEntryBefore(pos)], pos);
 }
 
 inline OffsetGroup LocatedString::endOffsetGroup(int pos) const {
 	check_bounds(pos, "LocatedString::endOffsetGroupAt");
-	return OffsetGroup(end<ByteOffset>(pos), end<CharOffset>(pos), end<EDTOffset>(pos), end<ASRTime>(pos));
+	return endOffsetGroup(_offsets[findOffsetEntryBefore(pos)], pos);
+}
+
+inline OffsetGroup LocatedString::startOffsetGroup(const OffsetEntry &entry, int pos) const {
+	ByteOffset byteOffset;
+	CharOffset charOffset;
+	EDTOffset edtOffset;
+	ASRTime asrTime;
+	getStartOffset(entry, pos, byteOffset);
+	getStartOffset(entry, pos, charOffset);
+	getStartOffset(entry, pos, edtOffset);
+	getStartOffset(entry, pos, asrTime);
+	return OffsetGroup(byteOffset, charOffset, edtOffset, asrTime);
+}
+
+inline OffsetGroup LocatedString::endOffsetGroup(const OffsetEntry &entry, int pos) const {
+	ByteOffset byteOffset;
+	CharOffset charOffset;
+	EDTOffset edtOffset;
+	ASRTime asrTime;
+	getEndOffset(entry, pos, byteOffset);
+	getEndOffset(entry, pos, charOffset);
+	getEndOffset(entry, pos, edtOffset);
+	getEndOffset(entry, pos, asrTime);
+	return OffsetGroup(byteOffset, charOffset, edtOffset, asrTime);
 }
 
 template<> CharOffset LocatedString::convertStartOffsetTo<CharOffset,CharOffset>(const CharOffset &src) const;
@@ -627,10 +681,19 @@ template<> CharOffset LocatedString::convertEndOffsetTo<CharOffset,CharOffset>(c
 template<> EDTOffset LocatedString::convertEndOffsetTo<EDTOffset,EDTOffset>(const EDTOffset &src) const;
 
 inline size_t LocatedString::findOffsetEntryBefore(int pos) const {
-	size_t i = 1;
-	while (i<_offsets.size() && _offsets[i].startPos<=pos)
-		++i;
-	return i-1;
+	// Binary search for the first entry that starts after pos.  (The
+	// entries are contiguous, so they are sorted by startPos.)  If pos
+	// comes before every entry, then return 0.
+	size_t lo = 1;
+	size_t hi = _offsets.size();
+	while (lo < hi) {
+		size_t mid = lo + (hi-lo)/2;
+		if (_offsets[mid].startPos <= pos)
+			lo = mid+1;
+		else
+			hi = mid;
+	}
+	return lo-1;
 }
 
 /*
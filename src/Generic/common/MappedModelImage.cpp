@@ -0,0 +1,364 @@
+// Copyright (c) 2012 by Raytheon BBN Technologies Corp.
+// All Rights Reserved.
+
+#include "Generic/common/leak_detection.h" // This must be the first #include
+#include "Generic/common/MappedModelImage.h"
+#include "Generic/common/UnexpectedInputException.h"
+#include "Generic/common/InternalInconsistencyException.h"
+#include "Generic/common/UnicodeUtil.h"
+
+#include <boost/filesystem.hpp>
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/weak_ptr.hpp>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <sstream>
+
+#ifdef _WIN32
+#include <process.h>
+#define getpid _getpid
+#else
+#include <unistd.h>
+#endif
+
+const char MappedModelImage::MAGIC[8] = {'S','E','R','I','F','M','M','I'};
+
+namespace {
+	// The layout of an image file is:
+	//   ImageHeader
+	//   block data (each block padded to a multiple of 8 bytes)
+	//   symbol offsets: (n_symbols+1) uint64 offsets into the symbol data
+	//   symbol data: utf-8 symbol strings, back to back (padded)
+	//   SectionRecord[n_sections]
+	//   block table: (offset, size) uint64 pairs
+	struct ImageHeader {
+		char magic[8];
+		boost::uint32_t version;
+		boost::uint32_t byte_order_mark;
+		boost::uint64_t n_symbols;
+		boost::uint64_t symbol_offsets;
+		boost::uint64_t symbol_data;
+		boost::uint64_t n_sections;
+		boost::uint64_t sections;
+		boost::uint64_t n_blocks;
+		boost::uint64_t blocks;
+	};
+
+	struct SectionRecord {
+		char name[48];
+		boost::uint64_t first_block;
+		boost::uint64_t n_blocks;
+	};
+
+	inline boost::uint64_t align8(boost::uint64_t offset) {
+		return (offset + 7) & ~static_cast<boost::uint64_t>(7);
+	}
+
+	// Images that are currently open in this process, indexed by filename.
+	boost::mutex openImagesLock;
+	std::map<std::string, boost::weak_ptr<const MappedModelImage> > openImages;
+
+	// Return a name for a temporary file in the same directory as the
+	// given file, which is unique to this process and call.
+	std::string getTempFilename(const std::string &filename) {
+		static size_t counter = 0;
+		boost::mutex::scoped_lock lock(openImagesLock);
+		std::stringstream tempFilename;
+		tempFilename << filename << ".tmp-" << getpid() << "-" << (counter++);
+		return tempFilename.str();
+	}
+}
+
+struct MappedModelImage::Mapping {
+	boost::interprocess::file_mapping file;
+	boost::interprocess::mapped_region region;
+	Mapping(const char *filename)
+		: file(filename, boost::interprocess::read_only),
+		  region(file, boost::interprocess::read_only) {}
+};
+
+boost::shared_ptr<const MappedModelImage> MappedModelImage::open(const std::string &filename) {
+	boost::mutex::scoped_lock lock(openImagesLock);
+	boost::shared_ptr<const MappedModelImage> image = openImages[filename].lock();
+	if (!image) {
+		image = boost::shared_ptr<const MappedModelImage>(_new MappedModelImage(filename));
+		openImages[filename] = image;
+	}
+	return image;
+}
+
+MappedModelImage::MappedModelImage(const std::string &filename)
+	: _filename(filename), _data(0), _size(0), _blocks(0), _n_blocks(0)
+{
+	try {
+		_mapping.reset(_new Mapping(filename.c_str()));
+	} catch (boost::interprocess::interprocess_exception &e) {
+		std::stringstream err;
+		err << "Unable to map model image " << filename << ": " << e.what();
+		throw UnexpectedInputException("MappedModelImage::MappedModelImage", err.str().c_str());
+	}
+	_data = static_cast<const char*>(_mapping->region.get_address());
+	_size = _mapping->region.get_size();
+
+	checkRange(0, sizeof(ImageHeader), "header");
+	const ImageHeader *header = reinterpret_cast<const ImageHeader*>(_data);
+	if (memcmp(header->magic, MAGIC, sizeof(MAGIC)) != 0)
+		throw UnexpectedInputException("MappedModelImage::MappedModelImage",
+			"Not a model image file: ", filename.c_str());
+	if (header->byte_order_mark != BYTE_ORDER_MARK)
+		throw UnexpectedInputException("MappedModelImage::MappedModelImage",
+			"Model image was written on a machine with a different byte order: ", filename.c_str());
+	if (header->version != VERSION)
+		throw UnexpectedInputException("MappedModelImage::MappedModelImage",
+			"Unsupported model image version (recompile the model): ", filename.c_str());
+
+	// Block table
+	checkRange(header->blocks, header->n_blocks * 2 * sizeof(boost::uint64_t), "block table");
+	_blocks = reinterpret_cast<const boost::uint64_t*>(_data + header->blocks);
+	_n_blocks = static_cast<size_t>(header->n_blocks);
+	for (size_t i = 0; i < _n_blocks; i++)
+		checkRange(_blocks[2*i], _blocks[2*i+1], "block");
+
+	// Sections
+	checkRange(header->sections, header->n_sections * sizeof(SectionRecord), "section table");
+	const SectionRecord *sections = reinterpret_cast<const SectionRecord*>(_data + header->sections);
+	for (size_t i = 0; i < header->n_sections; i++) {
+		const SectionRecord &record = sections[i];
+		if (record.first_block > header->n_blocks || record.n_blocks > header->n_blocks - record.first_block)
+			throw UnexpectedInputException("MappedModelImage::MappedModelImage",
+				"Corrupt section table in model image: ", filename.c_str());
+		SectionInfo info;
+		info.name = std::string(record.name, strnlen(record.name, MAX_SECTION_NAME));
+		info.first_block = static_cast<size_t>(record.first_block);
+		info.n_blocks = static_cast<size_t>(record.n_blocks);
+		_sections.push_back(info);
+	}
+
+	// Symbol pool.  Symbols are interned once, here; after that, tables
+	// translate between symbols and SymbolIds using _symbols and _symbolIds.
+	size_t n_symbols = static_cast<size_t>(header->n_symbols);
+	checkRange(header->symbol_offsets, (n_symbols+1) * sizeof(boost::uint64_t), "symbol table");
+	const boost::uint64_t *offsets = reinterpret_cast<const boost::uint64_t*>(_data + header->symbol_offsets);
+	checkRange(header->symbol_data, offsets[n_symbols], "symbol data");
+	_symbols.reserve(n_symbols);
+	for (size_t i = 0; i < n_symbols; i++) {
+		if (offsets[i] > offsets[i+1] || offsets[i+1] > offsets[n_symbols])
+			throw UnexpectedInputException("MappedModelImage::MappedModelImage",
+				"Corrupt symbol table in model image: ", filename.c_str());
+		std::string utf8(_data + header->symbol_data + offsets[i],
+		                 static_cast<size_t>(offsets[i+1] - offsets[i]));
+		Symbol sym(UnicodeUtil::toUTF16StdString(utf8).c_str());
+		_symbols.push_back(sym);
+		_symbolIds[sym] = static_cast<SymbolId>(i);
+	}
+}
+
+MappedModelImage::~MappedModelImage() {
+	// _mapping unmaps the file when it is destroyed.
+}
+
+void MappedModelImage::checkRange(boost::uint64_t offset, boost::uint64_t n_bytes, const char *what) const {
+	if (offset > _size || n_bytes > _size - offset) {
+		std::stringstream err;
+		err << "Model image " << _filename << " is truncated or corrupt (bad " << what << ")";
+		throw UnexpectedInputException("MappedModelImage::checkRange", err.str().c_str());
+	}
+}
+
+Symbol MappedModelImage::getSymbol(SymbolId id) const {
+	if (id == NULL_SYMBOL_ID)
+		return Symbol();
+	if (id >= _symbols.size())
+		throw UnexpectedInputException("MappedModelImage::getSymbol",
+			"Bad symbol id in model image: ", _filename.c_str());
+	return _symbols[id];
+}
+
+bool MappedModelImage::hasSection(const char *name) const {
+	for (size_t i = 0; i < _sections.size(); i++) {
+		if (_sections[i].name == name)
+			return true;
+	}
+	return false;
+}
+
+MappedModelImage::Section::Section(boost::shared_ptr<const MappedModelImage> image, const char *name)
+	: _image(image), _name(name), _next_block(0), _end_block(0)
+{
+	for (size_t i = 0; i < image->_sections.size(); i++) {
+		if (image->_sections[i].name == name) {
+			_next_block = image->_sections[i].first_block;
+			_end_block = _next_block + image->_sections[i].n_blocks;
+			return;
+		}
+	}
+	std::stringstream err;
+	err << "Model image " << image->getFilename() << " has no \"" << name << "\" section";
+	throw UnexpectedInputException("MappedModelImage::Section::Section", err.str().c_str());
+}
+
+const char *MappedModelImage::Section::nextRawBlock(size_t &n_bytes, size_t elt_size) {
+	if (_next_block >= _end_block) {
+		std::stringstream err;
+		err << "Unexpected end of section \"" << _name << "\" in model image " << _image->getFilename();
+		throw UnexpectedInputException("MappedModelImage::Section::nextBlock", err.str().c_str());
+	}
+	boost::uint64_t offset = _image->_blocks[2*_next_block];
+	n_bytes = static_cast<size_t>(_image->_blocks[2*_next_block+1]);
+	++_next_block;
+	if (n_bytes % elt_size != 0) {
+		std::stringstream err;
+		err << "Bad block size in section \"" << _name << "\" of model image " << _image->getFilename();
+		throw UnexpectedInputException("MappedModelImage::Section::nextBlock", err.str().c_str());
+	}
+	return _image->_data + offset;
+}
+
+MappedModelImage::WordReader::WordReader(Section& section)
+	: _image(section.getImage()), _sectionName(section.getName()), _words(0), _n_words(0), _pos(0)
+{
+	_words = section.nextBlock<boost::uint32_t>(_n_words);
+}
+
+void MappedModelImage::WordReader::throwEndOfBlock() const {
+	std::stringstream err;
+	err << "Unexpected end of block in section \"" << _sectionName << "\" of model image " << _image->getFilename();
+	throw UnexpectedInputException("MappedModelImage::WordReader::nextWord", err.str().c_str());
+}
+
+MappedModelImage::SymbolId MappedModelImageWriter::getSymbolId(const Symbol &sym) {
+	if (sym.is_null())
+		return MappedModelImage::NULL_SYMBOL_ID;
+	Symbol::HashMap<MappedModelImage::SymbolId>::iterator it = _symbolIds.find(sym);
+	if (it != _symbolIds.end())
+		return (*it).second;
+	MappedModelImage::SymbolId id = static_cast<MappedModelImage::SymbolId>(_symbols.size());
+	if (id >= MappedModelImage::NULL_SYMBOL_ID)
+		throw InternalInconsistencyException("MappedModelImageWriter::getSymbolId",
+			"Too many symbols for a single model image");
+	_symbols.push_back(sym);
+	_symbolIds[sym] = id;
+	return id;
+}
+
+void MappedModelImageWriter::beginSection(const char *name) {
+	if (strlen(name) >= MappedModelImage::MAX_SECTION_NAME)
+		throw InternalInconsistencyException("MappedModelImageWriter::beginSection",
+			"Section name is too long");
+	for (size_t i = 0; i < _sections.size(); i++) {
+		if (_sections[i].name == name)
+			throw InternalInconsistencyException("MappedModelImageWriter::beginSection",
+				"Duplicate section name");
+	}
+	MappedModelImage::SectionInfo info;
+	info.name = name;
+	info.first_block = _blocks.size();
+	info.n_blocks = 0;
+	_sections.push_back(info);
+}
+
+void MappedModelImageWriter::addBlock(const void *data, size_t n_bytes) {
+	if (_sections.empty())
+		throw InternalInconsistencyException("MappedModelImageWriter::addBlock",
+			"beginSection() must be called before addBlock()");
+	_blocks.push_back(n_bytes ? std::string(static_cast<const char*>(data), n_bytes) : std::string());
+	_sections.back().n_blocks++;
+}
+
+namespace {
+	void writePadding(std::ofstream &out, boost::uint64_t &offset) {
+		static const char zeros[8] = {0};
+		boost::uint64_t aligned = align8(offset);
+		out.write(zeros, static_cast<std::streamsize>(aligned - offset));
+		offset = aligned;
+	}
+}
+
+void MappedModelImageWriter::write(const std::string &filename) const {
+	std::vector<std::string> symbolStrings;
+	std::vector<boost::uint64_t> symbolOffsets(1, 0);
+	for (size_t i = 0; i < _symbols.size(); i++) {
+		symbolStrings.push_back(UnicodeUtil::toUTF8StdString(std::wstring(_symbols[i].to_string())));
+		symbolOffsets.push_back(symbolOffsets.back() + symbolStrings.back().size());
+	}
+
+	// Lay out the file.
+	ImageHeader header;
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, MappedModelImage::MAGIC, sizeof(header.magic));
+	header.version = MappedModelImage::VERSION;
+	header.byte_order_mark = MappedModelImage::BYTE_ORDER_MARK;
+	boost::uint64_t offset = align8(sizeof(ImageHeader));
+	std::vector<boost::uint64_t> blockTable;
+	for (size_t i = 0; i < _blocks.size(); i++) {
+		blockTable.push_back(offset);
+		blockTable.push_back(_blocks[i].size());
+		offset = align8(offset + _blocks[i].size());
+	}
+	header.n_symbols = _symbols.size();
+	header.symbol_offsets = offset;
+	offset += symbolOffsets.size() * sizeof(boost::uint64_t);
+	header.symbol_data = offset;
+	offset = align8(offset + symbolOffsets.back());
+	header.n_sections = _sections.size();
+	header.sections = offset;
+	offset += _sections.size() * sizeof(SectionRecord);
+	header.n_blocks = _blocks.size();
+	header.blocks = offset;
+
+	// Write the image to a temporary file in the same directory, and then
+	// rename it over the target.  Truncating a file in place would crash
+	// (with SIGBUS) any process that has the old image mapped; renaming
+	// leaves the old file intact until the last mapping of it is closed.
+	std::string tempFilename = getTempFilename(filename);
+	std::ofstream out(tempFilename.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+	if (!out)
+		throw UnexpectedInputException("MappedModelImageWriter::write",
+			"Unable to open model image for writing: ", tempFilename.c_str());
+	offset = 0;
+	out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+	offset += sizeof(header);
+	writePadding(out, offset);
+	for (size_t i = 0; i < _blocks.size(); i++) {
+		out.write(_blocks[i].data(), static_cast<std::streamsize>(_blocks[i].size()));
+		offset += _blocks[i].size();
+		writePadding(out, offset);
+	}
+	out.write(reinterpret_cast<const char*>(&symbolOffsets[0]),
+		static_cast<std::streamsize>(symbolOffsets.size() * sizeof(boost::uint64_t)));
+	offset += symbolOffsets.size() * sizeof(boost::uint64_t);
+	for (size_t i = 0; i < symbolStrings.size(); i++) {
+		out.write(symbolStrings[i].data(), static_cast<std::streamsize>(symbolStrings[i].size()));
+		offset += symbolStrings[i].size();
+	}
+	writePadding(out, offset);
+	for (size_t i = 0; i < _sections.size(); i++) {
+		SectionRecord record;
+		memset(&record, 0, sizeof(record));
+		strncpy(record.name, _sections[i].name.c_str(), sizeof(record.name) - 1);
+		record.first_block = _sections[i].first_block;
+		record.n_blocks = _sections[i].n_blocks;
+		out.write(reinterpret_cast<const char*>(&record), sizeof(record));
+	}
+	if (!blockTable.empty())
+		out.write(reinterpret_cast<const char*>(&blockTable[0]),
+			static_cast<std::streamsize>(blockTable.size() * sizeof(boost::uint64_t)));
+	out.close();
+	if (out.fail()) {
+		std::remove(tempFilename.c_str());
+		throw UnexpectedInputException("MappedModelImageWriter::write",
+			"Error while writing model image: ", tempFilename.c_str());
+	}
+	try {
+		boost::filesystem::rename(tempFilename, filename);
+	} catch (boost::filesystem::filesystem_error &e) {
+		std::remove(tempFilename.c_str());
+		std::stringstream err;
+		err << "Unable to replace model image " << filename << ": " << e.what();
+		throw UnexpectedInputException("MappedModelImageWriter::write", err.str().c_str());
+	}
+}
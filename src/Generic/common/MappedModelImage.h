@@ -0,0 +1,190 @@
+// Copyright (c) 2012 by Raytheon BBN Technologies Corp.
+// All Rights Reserved.
+
+#ifndef MAPPED_MODEL_IMAGE_H
+#define MAPPED_MODEL_IMAGE_H
+
+#include "Generic/common/Symbol.h"
+#include <boost/cstdint.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/scoped_ptr.hpp>
+#include <string>
+#include <vector>
+
+/** A MappedModelImage is a read-only binary model file that is loaded
+  * by memory-mapping it, rather than by parsing it.  Tables that are
+  * stored in an image (see, e.g., NgramScoreTableGen) can be used
+  * directly from the mapped memory, so loading a model is nearly
+  * instantaneous, and the operating system can share a single physical
+  * copy of the model between all processes that use it.
+  *
+  * An image consists of:
+  *   - A symbol pool, which assigns a SymbolId to each symbol string
+  *     used by the model.  (Symbols themselves are process-specific,
+  *     so tables in the image refer to symbols by SymbolId.)
+  *   - A list of named sections, each of which contains a sequence of
+  *     binary blocks.  Each block starts on an 8-byte boundary.  The
+  *     interpretation of the blocks is up to the table that wrote them.
+  *
+  * Images are written using MappedModelImageWriter, and are read using
+  * MappedModelImage::open() and MappedModelImage::Section.  An image
+  * is immutable once it is opened, so it may be used by any number of
+  * threads at once. */
+class MappedModelImage {
+public:
+	typedef boost::uint32_t SymbolId;
+
+	/** SymbolId used for the null symbol. */
+	static const SymbolId NULL_SYMBOL_ID = 0xfffffffeu;
+
+	/** SymbolId returned by getSymbolId() for symbols that do not occur
+	  * anywhere in the image.  This value never occurs inside an image, so
+	  * tables may also use it to mark empty slots. */
+	static const SymbolId UNKNOWN_SYMBOL_ID = 0xffffffffu;
+
+	/** Return the image stored in the given file.  If the image is
+	  * already open in this process, then the existing image is
+	  * returned.  Throws UnexpectedInputException if the file can not
+	  * be mapped or is not a valid image. */
+	static boost::shared_ptr<const MappedModelImage> open(const std::string &filename);
+
+	~MappedModelImage();
+
+	const std::string &getFilename() const { return _filename; }
+
+	/** Return the SymbolId for the given symbol, or UNKNOWN_SYMBOL_ID if
+	  * it does not occur in this image. */
+	SymbolId getSymbolId(const Symbol &sym) const {
+		if (sym.is_null())
+			return NULL_SYMBOL_ID;
+		Symbol::HashMap<SymbolId>::const_iterator it = _symbolIds.find(sym);
+		if (it == _symbolIds.end())
+			return UNKNOWN_SYMBOL_ID;
+		return (*it).second;
+	}
+
+	/** Return the symbol with the given SymbolId. */
+	Symbol getSymbol(SymbolId id) const;
+
+	bool hasSection(const char *name) const;
+
+	/** A cursor that is used to read the blocks of one section, in the
+	  * order in which they were written.  A section keeps its image open
+	  * for as long as the section (or a copy of its image pointer) exists. */
+	class Section {
+	public:
+		/** Throws UnexpectedInputException if the image has no section
+		  * with the given name. */
+		Section(boost::shared_ptr<const MappedModelImage> image, const char *name);
+
+		/** Return the next block, viewed as an array of T, and set count to
+		  * the number of T values it contains.  Throws
+		  * UnexpectedInputException if there are no blocks left or if the
+		  * block size is not a multiple of sizeof(T). */
+		template<typename T>
+		const T *nextBlock(size_t &count) {
+			size_t n_bytes = 0;
+			const char *data = nextRawBlock(n_bytes, sizeof(T));
+			count = n_bytes / sizeof(T);
+			return reinterpret_cast<const T*>(data);
+		}
+
+		bool atEnd() const { return _next_block == _end_block; }
+		const std::string &getName() const { return _name; }
+		const boost::shared_ptr<const MappedModelImage> &getImage() const { return _image; }
+	private:
+		const char *nextRawBlock(size_t &n_bytes, size_t elt_size);
+		boost::shared_ptr<const MappedModelImage> _image;
+		std::string _name;
+		size_t _next_block;
+		size_t _end_block;
+	};
+
+	/** Reads the next block of a section as a sequence of 32-bit words
+	  * (SymbolIds and small integers), one word at a time.  Throws
+	  * UnexpectedInputException if a read goes past the end of the block. */
+	class WordReader {
+	public:
+		WordReader(Section& section);
+		boost::uint32_t nextWord() {
+			if (_pos == _n_words)
+				throwEndOfBlock();
+			return _words[_pos++];
+		}
+		int nextInt() { return static_cast<boost::int32_t>(nextWord()); }
+		Symbol nextSymbol() { return _image->getSymbol(nextWord()); }
+		bool atEnd() const { return _pos == _n_words; }
+	private:
+		void throwEndOfBlock() const;
+		boost::shared_ptr<const MappedModelImage> _image;
+		std::string _sectionName;
+		const boost::uint32_t *_words;
+		size_t _n_words;
+		size_t _pos;
+	};
+
+private:
+	MappedModelImage(const std::string &filename);
+	void checkRange(boost::uint64_t offset, boost::uint64_t n_bytes, const char *what) const;
+
+	struct Mapping;
+	boost::scoped_ptr<Mapping> _mapping;
+	std::string _filename;
+	const char *_data;
+	size_t _size;
+
+	std::vector<Symbol> _symbols;
+	Symbol::HashMap<SymbolId> _symbolIds;
+
+	struct SectionInfo {
+		std::string name;
+		size_t first_block;
+		size_t n_blocks;
+	};
+	std::vector<SectionInfo> _sections;
+	const boost::uint64_t *_blocks; // (offset, size) pairs
+	size_t _n_blocks;
+
+	friend class MappedModelImageWriter;
+	static const char MAGIC[8];
+	static const boost::uint32_t VERSION = 1;
+	static const boost::uint32_t BYTE_ORDER_MARK = 0x01020304u;
+	static const size_t MAX_SECTION_NAME = 48;
+};
+
+/** Builds a MappedModelImage in memory, and then writes it to disk.
+  * Tables add themselves to the current section by adding one or more
+  * blocks to it; the blocks must be read back in the same order by the
+  * table's image constructor, using a MappedModelImage::Section. */
+class MappedModelImageWriter {
+public:
+	MappedModelImageWriter() {}
+
+	/** Return the SymbolId for the given symbol, adding it to the
+	  * image's symbol pool if necessary. */
+	MappedModelImage::SymbolId getSymbolId(const Symbol &sym);
+
+	/** Start a new section.  All blocks added after this call belong to
+	  * this section, until the next call to beginSection(). */
+	void beginSection(const char *name);
+
+	void addBlock(const void *data, size_t n_bytes);
+
+	template<typename T>
+	void addBlock(const std::vector<T> &values) {
+		addBlock(values.empty() ? 0 : &values[0], values.size() * sizeof(T));
+	}
+
+	/** Write the image to the given file.  The image is written to a
+	  * temporary file, which then replaces the given file, so processes
+	  * that have the old image mapped are not affected. */
+	void write(const std::string &filename) const;
+
+private:
+	std::vector<Symbol> _symbols;
+	Symbol::HashMap<MappedModelImage::SymbolId> _symbolIds;
+	std::vector<MappedModelImage::SectionInfo> _sections;
+	std::vector<std::string> _blocks;
+};
+
+#endif
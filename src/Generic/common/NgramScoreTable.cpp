@@ -2,12 +2,108 @@
 // All Rights Reserved.
 
 #include "Generic/common/leak_detection.h" // This must be the first #include
-#include "Generic/common/UTF8Token.h"
-#include "Generic/common/SymbolConstants.h"
 #include "Generic/common/UnexpectedInputException.h"
+#include "Generic/common/InternalInconsistencyException.h"
 #include "Generic/common/NgramScoreTable.h"
 
 #include <limits>
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <cwchar>
+#include <cwctype>
+#include <string>
+
+namespace {
+    // Longest ngram that can be stored in a model image.
+    const size_t MAX_IMAGE_NGRAM = 16;
+
+    // Hash function for the SymbolId ngrams stored in model images.  This
+    // must not change, since it determines where entries live in the image.
+    inline boost::uint32_t hashSymbolIds(const boost::uint32_t* ids, size_t n) {
+        boost::uint32_t hash = 2166136261u;
+        for (size_t i = 0; i < n; i++) {
+            hash ^= ids[i];
+            hash *= 16777619u;
+        }
+        hash ^= hash >> 16;
+        hash *= 0x85ebca6bu;
+        hash ^= hash >> 13;
+        return hash;
+    }
+
+    /** Reads the tokens of an ngram table from a stream, splitting them the
+      * same way as UTF8Token (at whitespace, with each parenthesis a token
+      * of its own).  Lines are read with UTF8InputStream::getLineView(), so
+      * a token points into the stream's buffer, and is only valid until the
+      * next call to next().  Reading stops at the end of a line, so the rest
+      * of the line holding the last entry is consumed. */
+    class NgramTableTokenizer {
+    public:
+        NgramTableTokenizer(UTF8InputStream& stream)
+          : _stream(stream), _line(0), _length(0), _pos(0) {}
+
+        /** Set token and length to the next token and return true, or return
+          * false if there are no tokens left. */
+        bool next(const wchar_t*& token, size_t& length) {
+            while (true) {
+                while (_pos < _length && iswspace(static_cast<wint_t>(_line[_pos])))
+                    _pos++;
+                if (_pos < _length)
+                    break;
+                if (!_stream.getLineView(_line, _length))
+                    return false;
+                _pos = 0;
+            }
+            token = _line + _pos;
+            size_t start = _pos++;
+            if (*token != L'(' && *token != L')') {
+                while (_pos < _length && !iswspace(static_cast<wint_t>(_line[_pos])) &&
+                       _line[_pos] != L'(' && _line[_pos] != L')')
+                    _pos++;
+            }
+            length = _pos - start;
+            return true;
+        }
+
+        /** Read the next token, and return true if it is the given
+          * parenthesis. */
+        bool nextIs(wchar_t paren) {
+            const wchar_t* token;
+            size_t length;
+            return next(token, length) && length == 1 && *token == paren;
+        }
+
+    private:
+        UTF8InputStream& _stream;
+        const wchar_t* _line;
+        size_t _length;
+        size_t _pos;
+    };
+
+    /** Parse a score the way that reading a float from a stream would.
+      * Return false if the token is not a number that fits in a float
+      * (e.g., "inf"). */
+    bool parseScore(const wchar_t* token, size_t length, float& score) {
+        wchar_t buffer[101];
+        if (length == 0 || length >= sizeof(buffer)/sizeof(buffer[0]))
+            return false;
+        std::copy(token, token + length, buffer);
+        buffer[length] = L'\0';
+        wchar_t* end;
+        double value = wcstod(buffer, &end);
+        if (end != buffer + length || !(value >= -numeric_limits<float>::max() && value <= numeric_limits<float>::max()))
+            return false;
+        score = static_cast<float>(value);
+        return true;
+    }
+
+    void throwIllFormed(int error_code, int entry) {
+        char c[100];
+        sprintf( c, "ERROR %d: ill-formed ngram record at entry: %d", error_code, entry );
+        throw UnexpectedInputException("NgramScoreTableGen::()", c);
+    }
+}
 
 template <size_t N>
 const float NgramScoreTableGen<N>::targetLoadingFactor = static_cast<float>(0.7);
@@ -19,58 +115,61 @@ NgramScoreTableGen<N>::NgramScoreTableGen(UTF8InputStream& stream)
     numEntries(get_num_entries(stream)), 
     numBuckets(get_num_buckets(numEntries)), 
     table(numBuckets, hasher, eqTester), 
-    size(numEntries)
+    size(numEntries),
+    imageSlots(0),
+    imageCapacity(0)
 {
+    readEntries(stream, N, 0);
+}
 
-    UTF8Token token;
 
-    for (int i = 0; i < numEntries; i++) {
-
-        Symbol* ngram = _new Symbol[N];
+// Each entry is "((word_1 ... word_n) score)".  A score that does not
+// fit in a float (e.g., "inf") is read as the largest float.
+template <size_t N>
+void NgramScoreTableGen<N>::readEntries(UTF8InputStream& stream, size_t n, int first_error_code)
+{
+    NgramTableTokenizer tokenizer(stream);
+    const wchar_t* token;
+    size_t length;
+    std::wstring word;
 
-        stream >> token;
+    for (int i = 0; i < numEntries; i++) {
 
-        if (token.symValue() != SymbolConstants::leftParen) {
-          char c[100];
-          sprintf( c, "ERROR 0: ill-formed ngram record at entry: %d", i );
-		  throw UnexpectedInputException("NgramScoreTableGen::()", c);
+        if (!tokenizer.nextIs(L'('))
+            throwIllFormed(first_error_code, i);
+        if (!tokenizer.nextIs(L'('))
+            throwIllFormed(first_error_code + 1, i);
+
+        Symbol* ngram = _new Symbol[n];
+        for (size_t j = 0; j < n; j++) {
+            if (tokenizer.next(token, length)) {
+                word.assign(token, length);
+                ngram[j] = Symbol(word);
+            }
         }
 
-        stream >> token;
-        if (token.symValue() != SymbolConstants::leftParen) {
-          char c[100];
-          sprintf( c, "ERROR 1: ill-formed ngram record at entry: %d", i );
-          throw UnexpectedInputException("NgramScoreTableGen::()",c);
+        if (!tokenizer.nextIs(L')')) {
+            delete [] ngram;
+            throwIllFormed(first_error_code + 2, i);
         }
 
-        for (size_t j = 0; j < N; j++) {
-            stream >> token;
-            ngram[j] = token.symValue();
+        float score;
+        if (!tokenizer.next(token, length) || (length == 1 && *token == L')')) {
+            delete [] ngram;
+            throwIllFormed(first_error_code + 3, i);
         }
-
-        stream >> token;
-        if (token.symValue() != SymbolConstants::rightParen) {
-          char c[100];
-          sprintf( c, "ERROR 2: ill-formed ngram record at entry: %d", i );
-          throw UnexpectedInputException("NgramScoreTableGen::()",c);
+        bool closed = false;
+        if (!parseScore(token, length, score)) {
+            // Skip anything else up to the closing parenthesis.
+            score = numeric_limits<float>::max();
+            while (!closed && tokenizer.next(token, length))
+                closed = (length == 1 && *token == L')');
+        } else {
+            closed = tokenizer.nextIs(L')');
         }
-
-        float score;
-        stream >> score;
-	
-		// check for "inf" score value
-		if (!stream) {
-			stream.clear();
-			stream.ignore(numeric_limits<streamsize>::max(), L')');
-			stream.putBack(L')');
-			score = numeric_limits<float>::max();
-		}
-
-        stream >> token;
-        if (token.symValue() != SymbolConstants::rightParen) {
-          char c[100];
-          sprintf( c, "ERROR 3: ill-formed ngram record at entry: %d", i );
-          throw UnexpectedInputException("NgramScoreTableGen::()",c);
+        if (!closed) {
+            delete [] ngram;
+            throwIllFormed(first_error_code + 3, i);
         }
 
         table[ngram] = score;
@@ -85,7 +184,9 @@ NgramScoreTableGen<N>::NgramScoreTableGen(int init_size)
     numEntries(0), 
     numBuckets(get_num_buckets(init_size)), 
     table(numBuckets, hasher, eqTester), 
-    size(0)
+    size(0),
+    imageSlots(0),
+    imageCapacity(0)
 {
 }
 
@@ -98,76 +199,56 @@ NgramScoreTableGen<N>::NgramScoreTableGen(size_t n, UTF8InputStream& stream)
     numEntries(get_num_entries(stream)), 
     numBuckets(get_num_buckets(numEntries)), 
     table(numBuckets, hasher, eqTester), 
-    size(numEntries)
+    size(numEntries),
+    imageSlots(0),
+    imageCapacity(0)
 {
+    readEntries(stream, N_flexible, 4);
+}
 
-    UTF8Token token;
-
-    for (int i = 0; i < numEntries; i++) {
-
-        Symbol* ngram = _new Symbol[N_flexible];
-
-        stream >> token;
-
-        if (token.symValue() != SymbolConstants::leftParen) {
-          char c[100];
-          sprintf( c, "ERROR 4: ill-formed ngram record at entry: %d", i );
-		  throw UnexpectedInputException("NgramScoreTableGen::()", c);
-        }
-
-        stream >> token;
-        if (token.symValue() != SymbolConstants::leftParen) {
-          char c[100];
-          sprintf( c, "ERROR 5: ill-formed ngram record at entry: %d", i );
-          throw UnexpectedInputException("NgramScoreTableGen::()",c);
-        }
-
-        for (size_t j = 0; j < N_flexible; j++) {
-            stream >> token;
-            ngram[j] = token.symValue();
-        }
-
-        stream >> token;
-        if (token.symValue() != SymbolConstants::rightParen) {
-          char c[100];
-          sprintf( c, "ERROR 6: ill-formed ngram record at entry: %d", i );
-          throw UnexpectedInputException("NgramScoreTableGen::()",c);
-        }
 
-        float score;
-        stream >> score;
-
-		// check for "inf" score value
-		if (!stream) {
-			stream.clear();
-			stream.ignore(numeric_limits<streamsize>::max(), L')');
-			stream.putBack(L')');
-			score = numeric_limits<float>::max();
-		}
-
-        stream >> token;
-        if (token.symValue() != SymbolConstants::rightParen) {
-          char c[100];
-          sprintf( c, "ERROR 7: ill-formed ngram record at entry: %d", i );
-          throw UnexpectedInputException("NgramScoreTableGen::()",c);
-        }
+template <size_t N>
+NgramScoreTableGen<N>::NgramScoreTableGen(size_t n, int init_size)
+  : N_flexible(n), 
+    hasher(HashKey<N>(n)), 
+    eqTester(EqualKey<N>(n)), 
+    numEntries(0), 
+    numBuckets(get_num_buckets(init_size)), 
+    table(numBuckets, hasher, eqTester), 
+    size(0),
+    imageSlots(0),
+    imageCapacity(0)
+{
+}
 
-        table[ngram] = score;
 
-    }
+template <size_t N>
+NgramScoreTableGen<N>::NgramScoreTableGen(MappedModelImage::Section& section)
+  : N_flexible(N), 
+    numEntries(0), 
+    numBuckets(get_num_buckets(0)), 
+    table(numBuckets, hasher, eqTester), 
+    size(0),
+    imageSlots(0),
+    imageCapacity(0)
+{
+    readImage(section);
 }
 
 
 template <size_t N>
-NgramScoreTableGen<N>::NgramScoreTableGen(size_t n, int init_size)
+NgramScoreTableGen<N>::NgramScoreTableGen(size_t n, MappedModelImage::Section& section)
   : N_flexible(n), 
     hasher(HashKey<N>(n)), 
     eqTester(EqualKey<N>(n)), 
     numEntries(0), 
-    numBuckets(get_num_buckets(init_size)), 
+    numBuckets(get_num_buckets(0)), 
     table(numBuckets, hasher, eqTester), 
-    size(0)
+    size(0),
+    imageSlots(0),
+    imageCapacity(0)
 {
+    readImage(section);
 }
 
 
@@ -192,6 +273,7 @@ void NgramScoreTableGen<N>::add(Symbol* ngram)
 template <size_t N>
 void NgramScoreTableGen<N>::add(Symbol* ngram, float value)
 {
+  checkNotImage("NgramScoreTableGen::add");
 
   typename Table::iterator iter = table.find(ngram);
   if (iter == table.end()) {
@@ -219,6 +301,7 @@ void NgramScoreTableGen<N>::add(Symbol* ngram, float value)
 template <size_t N>
 void NgramScoreTableGen<N>::print(const char *filename)
 {
+	checkNotImage("NgramScoreTableGen::print");
 	//ofstream out;
 	UTF8OutputStream out;
 	out.open(filename);
@@ -233,6 +316,7 @@ void NgramScoreTableGen<N>::print(const char *filename)
 template <size_t N>
 void NgramScoreTableGen<N>::print_to_open_stream(UTF8OutputStream& out) 
 {
+  checkNotImage("NgramScoreTableGen::print_to_open_stream");
 
   out << size;
   out << "\n";
@@ -262,6 +346,7 @@ void NgramScoreTableGen<N>::print_to_open_stream(UTF8OutputStream& out)
 template <size_t N>
 NgramScoreTableGen<N>* NgramScoreTableGen<N>::prune(int threshold)
 {
+  checkNotImage("NgramScoreTableGen::prune");
   if (N > 0) {
     NgramScoreTableGen<N>* new_table = _new NgramScoreTableGen<N>(size);
     
@@ -284,6 +369,7 @@ NgramScoreTableGen<N>* NgramScoreTableGen<N>::prune(int threshold)
 template <size_t N>
 void NgramScoreTableGen<N>::reset()
 {
+	checkNotImage("NgramScoreTableGen::reset");
 	typename Table::iterator iter;
 
 	for (iter = table.begin() ; iter != table.end() ; ++iter) {
@@ -292,6 +378,14 @@ void NgramScoreTableGen<N>::reset()
 
 }
 
+template <size_t N>
+void NgramScoreTableGen<N>::checkNotImage(const char* method) const {
+  if (imageSlots != 0) {
+    throw InternalInconsistencyException(method,
+      "Can not modify or list a table that was read from a model image");
+  }
+}
+
 template <size_t N>
 int NgramScoreTableGen<N>::get_num_entries(UTF8InputStream& stream) {
 	int num = 0; 
@@ -315,6 +409,127 @@ int NgramScoreTableGen<N>::get_num_buckets(int init_size) {
   return num;
 }
 
+// An image table consists of two blocks: a header (ngram length, number
+// of slots, number of entries), followed by the slots themselves.  Each
+// slot holds the SymbolIds of one ngram, followed by the bits of its
+// score.  Empty slots have UNKNOWN_SYMBOL_ID as their first SymbolId.
+// The number of slots is a power of two, and at most half the slots are
+// used, so lookups (with linear probing) are short.
+template <size_t N>
+void NgramScoreTableGen<N>::writeImage(MappedModelImageWriter& writer)
+{
+  if (imageSlots != 0) {
+    throw InternalInconsistencyException("NgramScoreTableGen::writeImage",
+      "Can not write a table that was itself read from a model image");
+  }
+  const size_t n = N_flexible;
+  if (n == 0 || n > MAX_IMAGE_NGRAM) {
+    throw InternalInconsistencyException("NgramScoreTableGen::writeImage",
+      "Unsupported ngram length for a model image");
+  }
+
+  size_t capacity = 8;
+  while (capacity < 2 * table.size()) {
+    capacity *= 2;
+  }
+  const size_t mask = capacity - 1;
+  std::vector<boost::uint32_t> slots(capacity * (n + 1), 0);
+  for (size_t slot = 0; slot < capacity; slot++) {
+    slots[slot * (n + 1)] = MappedModelImage::UNKNOWN_SYMBOL_ID;
+  }
+
+  boost::uint32_t ids[MAX_IMAGE_NGRAM];
+  for (typename Table::iterator iter = table.begin() ; iter != table.end() ; ++iter) {
+    for (size_t j = 0; j < n; j++) {
+      ids[j] = writer.getSymbolId((*iter).first[j]);
+    }
+    size_t slot = hashSymbolIds(ids, n) & mask;
+    while (slots[slot * (n + 1)] != MappedModelImage::UNKNOWN_SYMBOL_ID) {
+      slot = (slot + 1) & mask;
+    }
+    std::copy(ids, ids + n, &slots[slot * (n + 1)]);
+    float score = (*iter).second;
+    memcpy(&slots[slot * (n + 1) + n], &score, sizeof(float));
+  }
+
+  std::vector<boost::uint64_t> header;
+  header.push_back(n);
+  header.push_back(capacity);
+  header.push_back(table.size());
+  writer.addBlock(header);
+  writer.addBlock(slots);
+}
+
+template <size_t N>
+void NgramScoreTableGen<N>::readImage(MappedModelImage::Section& section)
+{
+  const size_t n = N_flexible;
+  size_t count = 0;
+  const boost::uint64_t* header = section.nextBlock<boost::uint64_t>(count);
+  if (count != 3 || header[0] != n || n == 0 || n > MAX_IMAGE_NGRAM) {
+    throw UnexpectedInputException("NgramScoreTableGen::readImage",
+      "Bad ngram table header in model image section: ", section.getName().c_str());
+  }
+  boost::uint64_t capacity = header[1];
+  boost::uint64_t entries = header[2];
+  const boost::uint32_t* slots = section.nextBlock<boost::uint32_t>(count);
+  if (capacity == 0 || (capacity & (capacity - 1)) != 0 || entries >= capacity ||
+      count != capacity * (n + 1))
+  {
+    throw UnexpectedInputException("NgramScoreTableGen::readImage",
+      "Bad ngram table in model image section: ", section.getName().c_str());
+  }
+  image = section.getImage();
+  imageSlots = slots;
+  imageCapacity = static_cast<size_t>(capacity);
+  numEntries = size = static_cast<int>(entries);
+}
+
+template <size_t N>
+bool NgramScoreTableGen<N>::find(Symbol* ngram, float& score) const
+{
+  if (imageSlots != 0) {
+    return findInImage(ngram, score);
+  }
+#if defined(_WIN32)
+  typename Table::iterator iter = table.find(ngram);
+#else
+  typename Table::const_iterator iter = table.find(ngram);
+#endif
+  if (iter == table.end()) {
+    return false;
+  }
+  score = (*iter).second;
+  return true;
+}
+
+template <size_t N>
+bool NgramScoreTableGen<N>::findInImage(const Symbol* ngram, float& score) const
+{
+  const size_t n = N_flexible;
+  boost::uint32_t ids[MAX_IMAGE_NGRAM];
+  for (size_t j = 0; j < n; j++) {
+    ids[j] = image->getSymbolId(ngram[j]);
+    // An ngram containing a symbol that the image has never seen can't
+    // be in the table.
+    if (ids[j] == MappedModelImage::UNKNOWN_SYMBOL_ID) {
+      return false;
+    }
+  }
+
+  const size_t mask = imageCapacity - 1;
+  for (size_t slot = hashSymbolIds(ids, n) & mask; ; slot = (slot + 1) & mask) {
+    const boost::uint32_t* entry = imageSlots + slot * (n + 1);
+    if (entry[0] == MappedModelImage::UNKNOWN_SYMBOL_ID) {
+      return false;
+    }
+    if (std::equal(ids, ids + n, entry)) {
+      memcpy(&score, entry + n, sizeof(float));
+      return true;
+    }
+  }
+}
+
 template class NgramScoreTableGen<0>;
 template class NgramScoreTableGen<1>;
 template class NgramScoreTableGen<2>;
@@ -16,6 +16,7 @@
 #include "Generic/common/UTF8OutputStream.h"
 #include "Generic/common/Symbol.h"
 #include "Generic/common/Assert.h"
+#include "Generic/common/MappedModelImage.h"
 
 #include <boost/functional/hash.hpp>
 
@@ -94,17 +95,37 @@ private:
     Table table;
     int size;
 
+    // When a table is read from a MappedModelImage, its entries are kept
+    // in the image (as an open-addressed hash table of SymbolId ngrams),
+    // and "table" is left empty.
+    boost::shared_ptr<const MappedModelImage> image;
+    const boost::uint32_t* imageSlots;
+    size_t imageCapacity;
+
 public:
     NgramScoreTableGen(size_t n, UTF8InputStream& stream);
     NgramScoreTableGen(size_t n, int init_size);
     NgramScoreTableGen(UTF8InputStream& stream);
     NgramScoreTableGen(int init_size);
+    /** Read a table that was written by writeImage() from the next blocks
+      * of the given section.  The returned table uses the entries directly
+      * from the mapped image; it may be used for lookup(), but not for
+      * iteration or modification. */
+    NgramScoreTableGen(size_t n, MappedModelImage::Section& section);
+    NgramScoreTableGen(MappedModelImage::Section& section);
     ~NgramScoreTableGen();
 
+    /** Add this table to the current section of the given image writer. */
+    void writeImage(MappedModelImageWriter& writer);
+
     void print(const char *filename);
     void print_to_open_stream(UTF8OutputStream& out);
 
     inline float lookup(Symbol* ngram) const {
+      if (imageSlots != 0) {
+        float score;
+        return findInImage(ngram, score) ? score : 0;
+      }
 #if defined(_WIN32)
       typename Table::iterator iter = table.find(ngram);
 #else
@@ -116,6 +137,11 @@ public:
       return (*iter).second;
     }
 
+    /** If the table contains the given ngram, then set score to its score
+      * and return true; otherwise, return false.  (lookup() returns 0 for
+      * ngrams that are not in the table.) */
+    bool find(Symbol* ngram, float& score) const;
+
     int get_size() { return size; }
     void add(Symbol* ngram);
     void add(Symbol* ngram, float value);
@@ -127,7 +153,15 @@ public:
     typename Table::iterator get_element (Symbol* ngram) { return table.find(ngram); }
  private:
     int get_num_entries(UTF8InputStream& stream); 
+    /** Read numEntries entries, each with n words, from the given stream.
+      * Errors are numbered starting at first_error_code. */
+    void readEntries(UTF8InputStream& stream, size_t n, int first_error_code);
     int get_num_buckets(int init_size);
+    void readImage(MappedModelImage::Section& section);
+    bool findInImage(const Symbol* ngram, float& score) const;
+    /** Throw an InternalInconsistencyException if this table was read from
+      * a model image (whose entries can not be modified or listed). */
+    void checkNotImage(const char* method) const;
 
 };
 
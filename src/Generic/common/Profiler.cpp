@@ -0,0 +1,437 @@
+// Copyright (c) 2012 by Raytheon BBN Technologies Corp.
+// All Rights Reserved.
+
+#include "Generic/common/leak_detection.h" // This must be the first #include
+
+#include "Generic/common/Profiler.h"
+#include "Generic/common/ParamReader.h"
+#include "Generic/common/SessionLogger.h"
+#include "Generic/common/UnexpectedInputException.h"
+#include "Generic/common/UnicodeUtil.h"
+
+#include <boost/cstdint.hpp>
+#include <boost/date_time/posix_time/posix_time.hpp>
+#include <boost/foreach.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/tss.hpp>
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <iomanip>
+#include <map>
+#include <sstream>
+#include <vector>
+
+bool Profiler::_enabled = false;
+
+namespace {
+	// The maximum number of times kept for each path (for percentiles).
+	const size_t MAX_SAMPLES = 10000;
+
+	/** The profiling data for a single path. */
+	struct Node {
+		size_t count;
+		double total_msec;
+		double max_msec;
+		std::vector<double> samples;
+		std::map<std::string, long> counters;
+		Node(): count(0), total_msec(0), max_msec(0) {}
+	};
+
+	struct DocumentRecord {
+		std::string docid;
+		std::map<std::string, double> msec; // path -> time spent
+	};
+
+	struct TraceEvent {
+		std::string path;
+		boost::int64_t start_usec;
+		boost::int64_t duration_usec;
+		int tid;
+		int doc;
+	};
+
+	/** The scopes that are open in a single thread, and the document that
+	  * they are counted towards (an index into documents, or -1). */
+	struct ThreadState {
+		struct Frame {
+			size_t parent_length; // length of the path before this scope
+			boost::posix_time::ptime start;
+		};
+		ThreadState(): document(-1) {}
+		std::string path;
+		std::vector<Frame> stack;
+		int document;
+		int tid;
+	};
+
+	std::string reportFile;
+	std::string traceFile;
+	size_t maxTraceEvents = 1000000;
+	size_t maxDocuments = 100000;
+
+	// Everything below is guarded by mutex, except threadState.
+	boost::mutex mutex;
+	boost::thread_specific_ptr<ThreadState> threadState;
+	int nThreads = 0;
+	boost::posix_time::ptime sessionStart;
+	std::map<std::string, Node> nodes;
+	std::vector<DocumentRecord> documents;
+	size_t nDroppedDocuments = 0;
+	std::vector<TraceEvent> traceEvents;
+	size_t nDroppedTraceEvents = 0;
+	unsigned long randomState = 12345;
+
+	ThreadState &getThreadState() {
+		if (threadState.get() == 0) {
+			ThreadState *state = _new ThreadState();
+			boost::mutex::scoped_lock lock(mutex);
+			state->tid = ++nThreads;
+			threadState.reset(state);
+		}
+		return *threadState;
+	}
+
+	/** Add a time to the given node's samples, keeping a uniform random
+	  * sample of at most MAX_SAMPLES times (reservoir sampling). */
+	void addSample(Node &node, double msec) {
+		if (node.samples.size() < MAX_SAMPLES) {
+			node.samples.push_back(msec);
+			return;
+		}
+		randomState = randomState * 1103515245 + 12345;
+		size_t i = static_cast<size_t>((randomState >> 8) % node.count);
+		if (i < MAX_SAMPLES)
+			node.samples[i] = msec;
+	}
+
+	double percentile(const std::vector<double> &sorted, double p) {
+		if (sorted.empty())
+			return 0;
+		size_t i = static_cast<size_t>(p * (sorted.size() - 1) + 0.5);
+		return sorted[std::min(i, sorted.size() - 1)];
+	}
+
+	std::string escapeJson(const std::string &s) {
+		std::ostringstream out;
+		BOOST_FOREACH(char c, s) {
+			if (c == '"' || c == '\\')
+				out << '\\' << c;
+			else if (static_cast<unsigned char>(c) < 0x20) {
+				char buf[8];
+				sprintf(buf, "\\u%04x", static_cast<int>(c));
+				out << buf;
+			} else
+				out << c;
+		}
+		return out.str();
+	}
+
+	std::string getName(const std::string &path) {
+		size_t slash = path.rfind('/');
+		return (slash == std::string::npos) ? path : path.substr(slash + 1);
+	}
+
+	/** Return a map from each path to its children (the empty path maps to
+	  * the top-level paths).  Must be called with the mutex locked. */
+	std::map<std::string, std::vector<std::string> > getChildren() {
+		std::map<std::string, std::vector<std::string> > children;
+		typedef std::pair<std::string, Node> NodePair;
+		BOOST_FOREACH(const NodePair &node, nodes) {
+			size_t slash = node.first.rfind('/');
+			std::string parent = (slash == std::string::npos) ? "" : node.first.substr(0, slash);
+			if (nodes.find(parent) == nodes.end())
+				parent = "";
+			children[parent].push_back(node.first);
+		}
+		return children;
+	}
+
+	void writeNode(std::ostream &out, const std::string &path,
+	               std::map<std::string, std::vector<std::string> > &children, const std::string &indent)
+	{
+		const Node &node = nodes[path];
+		std::vector<double> sorted(node.samples);
+		std::sort(sorted.begin(), sorted.end());
+		const std::vector<std::string> &nodeChildren = children[path];
+		double child_msec = 0;
+		BOOST_FOREACH(const std::string &child, nodeChildren)
+			child_msec += nodes[child].total_msec;
+
+		out << indent << "{\"name\": \"" << escapeJson(getName(path)) << "\", "
+			<< "\"path\": \"" << escapeJson(path) << "\",\n"
+			<< indent << " \"count\": " << node.count << ", "
+			<< "\"total_msec\": " << node.total_msec << ", "
+			<< "\"self_msec\": " << std::max(0.0, node.total_msec - child_msec) << ", "
+			<< "\"mean_msec\": " << (node.count ? node.total_msec / node.count : 0) << ", "
+			<< "\"max_msec\": " << node.max_msec << ",\n"
+			<< indent << " \"p50_msec\": " << percentile(sorted, 0.5) << ", "
+			<< "\"p90_msec\": " << percentile(sorted, 0.9) << ", "
+			<< "\"p99_msec\": " << percentile(sorted, 0.99) << ",\n"
+			<< indent << " \"counters\": {";
+		typedef std::pair<std::string, long> CounterPair;
+		bool first = true;
+		BOOST_FOREACH(const CounterPair &counter, node.counters) {
+			out << (first ? "" : ", ") << "\"" << escapeJson(counter.first) << "\": " << counter.second;
+			first = false;
+		}
+		out << "},\n" << indent << " \"children\": [";
+		for (size_t i = 0; i < nodeChildren.size(); ++i) {
+			out << (i == 0 ? "\n" : ",\n");
+			writeNode(out, nodeChildren[i], children, indent + "  ");
+		}
+		out << "]}";
+	}
+
+	void logNode(std::ostream &out, const std::string &path,
+	             std::map<std::string, std::vector<std::string> > &children, const std::string &indent)
+	{
+		const Node &node = nodes[path];
+		std::vector<double> sorted(node.samples);
+		std::sort(sorted.begin(), sorted.end());
+		out << indent << getName(path) << "\t" << node.count << "\t" << node.total_msec << " msec"
+			<< "\t(p50 " << percentile(sorted, 0.5) << ", p90 " << percentile(sorted, 0.9)
+			<< ", p99 " << percentile(sorted, 0.99) << ", max " << node.max_msec << ")";
+		typedef std::pair<std::string, long> CounterPair;
+		BOOST_FOREACH(const CounterPair &counter, node.counters)
+			out << "\t" << counter.first << "=" << counter.second;
+		out << "\n";
+		BOOST_FOREACH(const std::string &child, children[path])
+			logNode(out, child, children, indent + "  ");
+	}
+}
+
+void Profiler::configure() {
+	reportFile = ParamReader::getParam("profiling_report_file");
+	traceFile = ParamReader::getParam("profiling_trace_file");
+	maxTraceEvents = static_cast<size_t>(ParamReader::getOptionalIntParamWithDefaultValue("profiling_max_trace_events", 1000000));
+	maxDocuments = static_cast<size_t>(ParamReader::getOptionalIntParamWithDefaultValue("profiling_max_documents", 100000));
+	_enabled = !reportFile.empty() || !traceFile.empty();
+	boost::mutex::scoped_lock lock(mutex);
+	if (_enabled && sessionStart.is_not_a_date_time())
+		sessionStart = boost::posix_time::microsec_clock::universal_time();
+}
+
+void Profiler::reset() {
+	boost::mutex::scoped_lock lock(mutex);
+	sessionStart = boost::posix_time::microsec_clock::universal_time();
+	nodes.clear();
+	documents.clear();
+	nDroppedDocuments = 0;
+	traceEvents.clear();
+	nDroppedTraceEvents = 0;
+}
+
+void Profiler::writeFiles() {
+	if (!_enabled)
+		return;
+	if (!reportFile.empty()) {
+		std::ofstream out(reportFile.c_str());
+		if (!out)
+			throw UnexpectedInputException("Profiler::writeFiles", "Unable to open profiling_report_file: ", reportFile.c_str());
+		writeReport(out);
+	}
+	if (!traceFile.empty()) {
+		std::ofstream out(traceFile.c_str());
+		if (!out)
+			throw UnexpectedInputException("Profiler::writeFiles", "Unable to open profiling_trace_file: ", traceFile.c_str());
+		writeTrace(out);
+	}
+}
+
+void Profiler::enter(const char *name) {
+	ThreadState &state = getThreadState();
+	ThreadState::Frame frame;
+	frame.parent_length = state.path.size();
+	if (!state.path.empty())
+		state.path += '/';
+	state.path += name;
+	state.stack.push_back(frame);
+	// Read the clock last, so the bookkeeping above isn't timed.
+	state.stack.back().start = boost::posix_time::microsec_clock::universal_time();
+}
+
+void Profiler::leave() {
+	boost::posix_time::ptime end = boost::posix_time::microsec_clock::universal_time();
+	ThreadState &state = getThreadState();
+	if (state.stack.empty())
+		return;
+	ThreadState::Frame frame = state.stack.back();
+	state.stack.pop_back();
+	boost::posix_time::time_duration duration = end - frame.start;
+	double msec = duration.total_microseconds() / 1000.0;
+
+	{
+		boost::mutex::scoped_lock lock(mutex);
+		Node &node = nodes[state.path];
+		++node.count;
+		node.total_msec += msec;
+		node.max_msec = std::max(node.max_msec, msec);
+		addSample(node, msec);
+		if (state.document >= 0)
+			documents[state.document].msec[state.path] += msec;
+		if (!traceFile.empty()) {
+			if (traceEvents.size() < maxTraceEvents) {
+				if (sessionStart.is_not_a_date_time())
+					sessionStart = frame.start;
+				TraceEvent event;
+				event.path = state.path;
+				event.start_usec = (frame.start - sessionStart).total_microseconds();
+				event.duration_usec = duration.total_microseconds();
+				event.tid = state.tid;
+				event.doc = state.document;
+				traceEvents.push_back(event);
+			} else {
+				++nDroppedTraceEvents;
+			}
+		}
+	}
+	state.path.resize(frame.parent_length);
+}
+
+void Profiler::addCount(const char *name, long n) {
+	ThreadState &state = getThreadState();
+	boost::mutex::scoped_lock lock(mutex);
+	nodes[state.path].counters[name] += n;
+}
+
+std::string Profiler::getCurrentPath() {
+	if (threadState.get() == 0)
+		return "";
+	return threadState->path;
+}
+
+Profiler::Context Profiler::getCurrentContext() {
+	Context context;
+	if (threadState.get() != 0) {
+		context.path = threadState->path;
+		context.document = threadState->document;
+	}
+	return context;
+}
+
+size_t Profiler::getCount(const std::string &path) {
+	boost::mutex::scoped_lock lock(mutex);
+	std::map<std::string, Node>::const_iterator it = nodes.find(path);
+	return (it == nodes.end()) ? 0 : it->second.count;
+}
+
+double Profiler::getTotalTime(const std::string &path) {
+	boost::mutex::scoped_lock lock(mutex);
+	std::map<std::string, Node>::const_iterator it = nodes.find(path);
+	return (it == nodes.end()) ? 0 : it->second.total_msec;
+}
+
+long Profiler::getCounter(const std::string &path, const std::string &counter) {
+	boost::mutex::scoped_lock lock(mutex);
+	std::map<std::string, Node>::const_iterator it = nodes.find(path);
+	if (it == nodes.end())
+		return 0;
+	std::map<std::string, long>::const_iterator c = it->second.counters.find(counter);
+	return (c == it->second.counters.end()) ? 0 : c->second;
+}
+
+void Profiler::writeReport(std::ostream &out) {
+	boost::mutex::scoped_lock lock(mutex);
+	std::map<std::string, std::vector<std::string> > children = getChildren();
+	out << std::fixed << std::setprecision(3);
+	out << "{\"stages\": [";
+	const std::vector<std::string> &roots = children[""];
+	for (size_t i = 0; i < roots.size(); ++i) {
+		out << (i == 0 ? "\n" : ",\n");
+		writeNode(out, roots[i], children, "  ");
+	}
+	out << "],\n \"documents\": [";
+	for (size_t i = 0; i < documents.size(); ++i) {
+		out << (i == 0 ? "\n" : ",\n") << "  {\"docid\": \"" << escapeJson(documents[i].docid) << "\", \"msec\": {";
+		typedef std::pair<std::string, double> PathTime;
+		bool first = true;
+		BOOST_FOREACH(const PathTime &pathTime, documents[i].msec) {
+			out << (first ? "" : ", ") << "\"" << escapeJson(pathTime.first) << "\": " << pathTime.second;
+			first = false;
+		}
+		out << "}}";
+	}
+	out << "],\n \"dropped_documents\": " << nDroppedDocuments
+		<< ",\n \"dropped_trace_events\": " << nDroppedTraceEvents << "}\n";
+}
+
+void Profiler::writeTrace(std::ostream &out) {
+	boost::mutex::scoped_lock lock(mutex);
+	out << "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [";
+	for (size_t i = 0; i < traceEvents.size(); ++i) {
+		const TraceEvent &event = traceEvents[i];
+		out << (i == 0 ? "\n" : ",\n")
+			<< "{\"name\": \"" << escapeJson(getName(event.path)) << "\", \"cat\": \"serif\", \"ph\": \"X\", "
+			<< "\"ts\": " << event.start_usec << ", \"dur\": " << event.duration_usec << ", "
+			<< "\"pid\": 1, \"tid\": " << event.tid << ", \"args\": {\"path\": \"" << escapeJson(event.path) << "\"";
+		if (event.doc >= 0)
+			out << ", \"docid\": \"" << escapeJson(documents[event.doc].docid) << "\"";
+		out << "}}";
+	}
+	out << "]}\n";
+}
+
+void Profiler::logReport() {
+	if (!_enabled)
+		return;
+	std::ostringstream out;
+	{
+		boost::mutex::scoped_lock lock(mutex);
+		std::map<std::string, std::vector<std::string> > children = getChildren();
+		out << "Profile (name, count, total time, percentiles, counters):\n";
+		BOOST_FOREACH(const std::string &root, children[""])
+			logNode(out, root, children, "  ");
+		if (nDroppedDocuments > 0)
+			out << "Dropped " << nDroppedDocuments << " document records (see profiling_max_documents)\n";
+		if (nDroppedTraceEvents > 0)
+			out << "Dropped " << nDroppedTraceEvents << " trace events (see profiling_max_trace_events)\n";
+	}
+	SessionLogger::info("profiling") << out.str();
+}
+
+Profiler::DocumentScope::DocumentScope(const std::wstring &docid): _active(_enabled), _oldDocument(-1) {
+	if (!_active)
+		return;
+	ThreadState &state = getThreadState();
+	_oldDocument = state.document;
+	{
+		boost::mutex::scoped_lock lock(mutex);
+		if (documents.size() < maxDocuments) {
+			DocumentRecord record;
+			record.docid = UnicodeUtil::toUTF8StdString(docid);
+			documents.push_back(record);
+			state.document = static_cast<int>(documents.size()) - 1;
+		} else {
+			++nDroppedDocuments;
+			state.document = -1;
+		}
+	}
+	enter("document");
+}
+
+Profiler::DocumentScope::~DocumentScope() {
+	if (!_active)
+		return;
+	leave();
+	getThreadState().document = _oldDocument;
+}
+
+Profiler::ThreadContext::ThreadContext(const Context &context): _active(_enabled) {
+	if (!_active)
+		return;
+	ThreadState &state = getThreadState();
+	_oldContext.path = state.path;
+	_oldContext.document = state.document;
+	state.path = context.path;
+	state.document = context.document;
+}
+
+Profiler::ThreadContext::~ThreadContext() {
+	if (!_active)
+		return;
+	ThreadState &state = getThreadState();
+	state.path = _oldContext.path;
+	state.document = _oldContext.document;
+}
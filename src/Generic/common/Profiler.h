@@ -0,0 +1,135 @@
+// Copyright (c) 2012 by Raytheon BBN Technologies Corp.
+// All Rights Reserved.
+
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <boost/noncopyable.hpp>
+#include <ostream>
+#include <string>
+
+/** Hierarchical profiling of Serif's stages and components.
+  *
+  * Code is instrumented with nested Profiler::Scope objects, which time
+  * the code from their construction to their destruction (in wall-clock
+  * time), and with Profiler::count(), which adds to a named counter of
+  * the innermost open scope.  Each scope is identified by its path, e.g.
+  * "document/parse/chart-fill", and the profiler keeps the number of
+  * times each path was entered, its total time, its maximum time, and a
+  * sample of its times (for percentiles).  It also keeps the time spent
+  * in each path for each document (see DocumentScope).
+  *
+  * Profiling is turned on by the profiling_report_file parameter (a JSON
+  * report) and/or the profiling_trace_file parameter (a Chrome trace
+  * event file, which can be viewed with chrome://tracing).  The files are
+  * written at the end of each batch (see DocumentDriver::endBatch()).
+  * The profiling data is shared by every DocumentDriver in the process,
+  * and is kept until reset() is called, so each report covers all of the
+  * batches so far.  When profiling is off, a Scope or a count() costs a
+  * single test of a static flag.
+  *
+  * Scopes may be opened by several threads at once.  Each thread has its
+  * own stack of open scopes and its own current document; a thread that
+  * does work on behalf of another one should use a ThreadContext so that
+  * its scopes are nested under the other thread's current path, and are
+  * counted towards the other thread's current document. */
+class Profiler {
+public:
+	/** Turn profiling on or off, based on the profiling_report_file and
+	  * profiling_trace_file parameters. */
+	static void configure();
+
+	static bool isEnabled() { return _enabled; }
+
+	/** Discard all profiling data.  This must not be called while any
+	  * thread has an open scope. */
+	static void reset();
+
+	/** Write the report and trace files (if requested). */
+	static void writeFiles();
+
+	/** Write a summary of the profiling data to the session logger. */
+	static void logReport();
+
+	/** Write the profiling data as JSON, or as Chrome trace events. */
+	static void writeReport(std::ostream &out);
+	static void writeTrace(std::ostream &out);
+
+	/** Return the number of times that the given path was entered, the
+	  * total time spent in it (in msec), or the total value of one of its
+	  * counters. */
+	static size_t getCount(const std::string &path);
+	static double getTotalTime(const std::string &path);
+	static long getCounter(const std::string &path, const std::string &counter);
+
+	/** A thread's current path and current document (an index into the
+	  * profiler's document records, or -1 if there is none). */
+	struct Context {
+		Context(): document(-1) {}
+		std::string path;
+		int document;
+	};
+
+	/** Return the calling thread's current path. */
+	static std::string getCurrentPath();
+
+	/** Return the calling thread's current path and document, to be passed
+	  * to a ThreadContext in another thread. */
+	static Context getCurrentContext();
+
+	/** Add n to the given counter of the calling thread's innermost open
+	  * scope. */
+	static void count(const char *name, long n=1) {
+		if (_enabled) addCount(name, n);
+	}
+
+	/** Times the code from its construction until it is destroyed (or
+	  * until stop() is called). */
+	class Scope : private boost::noncopyable {
+	public:
+		explicit Scope(const char *name): _active(_enabled) {
+			if (_active) enter(name);
+		}
+		~Scope() { stop(); }
+		/** End this scope before it is destroyed. */
+		void stop() {
+			if (_active) leave();
+			_active = false;
+		}
+	private:
+		bool _active;
+	};
+
+	/** A "document" scope, which also records the time spent in each path
+	  * while it is open (by the calling thread, or by threads that use its
+	  * context) as the time for the given document.  At most
+	  * profiling_max_documents (default 100000) documents are recorded. */
+	class DocumentScope : private boost::noncopyable {
+	public:
+		explicit DocumentScope(const std::wstring &docid);
+		~DocumentScope();
+	private:
+		bool _active;
+		int _oldDocument;
+	};
+
+	/** Sets the calling thread's current path and document to the given
+	  * context (usually another thread's getCurrentContext()) until it is
+	  * destroyed. */
+	class ThreadContext : private boost::noncopyable {
+	public:
+		explicit ThreadContext(const Context &context);
+		~ThreadContext();
+	private:
+		bool _active;
+		Context _oldContext;
+	};
+
+private:
+	static bool _enabled;
+	static void enter(const char *name);
+	static void leave();
+	static void addCount(const char *name, long n);
+};
+
+#endif
@@ -20,9 +20,20 @@
 #include <boost/lexical_cast.hpp>
 #include <boost/functional/hash.hpp>
 #include <boost/foreach.hpp>
+#include <boost/thread/recursive_mutex.hpp>
 
 using namespace std;
 
+namespace {
+	// Serializes reportMessage() and updateLocalContext(), since the global
+	// logger may be shared by several threads (e.g., with
+	// sentence_level_threads or server_num_worker_threads).
+	boost::recursive_mutex &loggerMutex() {
+		static boost::recursive_mutex mutex;
+		return mutex;
+	}
+}
+
 // Destructors for SessionLogger{Unsetter,Deleter,Restorer}.
 // See header file and http://wiki.d4m.bbn.com/wiki/Serif/SessionLogger.
 SessionLoggerUnsetter::~SessionLoggerUnsetter() {
@@ -247,6 +258,7 @@ void SessionLogger::updateLocalContext(size_t context_level, const wchar_t *cont
 		warn("bad_context_level_0") << "Ignoring attempt to update context level " << context_level
 			<< "; only " << levels_defined << " levels are defined.";
 	} else {
+		boost::recursive_mutex::scoped_lock lock(loggerMutex());
 		_impl->context_info[context_level] = context_info;
 
 		// erase information about all lower context levels
@@ -482,6 +494,7 @@ void SessionLogger::reportMessage(SessionLogger::LogLevel level, const char* ide
 	if (!enabledAtLevel(identifier, level) || msg.empty()) {
 		return;
 	}
+	boost::recursive_mutex::scoped_lock lock(loggerMutex());
 	// increment count of messages at level
 	_impl->n_messages[level]++;
 	wostringstream out;
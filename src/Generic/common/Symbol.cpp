@@ -20,6 +20,7 @@
 #include "Generic/common/ParamReader.h"
 #include "Generic/common/UTF8InputStream.h"
 #include "Generic/common/UTF8Token.h"
+#include "Generic/common/GenericTimer.h"
 
 #include <vector>
 #include <iomanip>
@@ -30,6 +31,9 @@
 #include <limits.h>
 #include <boost/scoped_ptr.hpp>
 #include <boost/math/common_factor_ct.hpp>
+#include <boost/thread.hpp>
+#include <boost/bind.hpp>
+#include <sstream>
 
 /** The maximum number of chars in the debug version of a symbol.  This
  * is just used for a single static character array, so setting it higher
@@ -42,23 +46,30 @@
 //======================================================================
 // Locking & Thread safety
 
+// Each SymbolTable shard has its own spinlock, and each SymbolTable has a
+// spinlock for its memory pools.  The global debugStringLock guards the
+// (global) debug string pool.  When more than one lock is needed, they are
+// always acquired in that order (shard, then pool, then debug string).
+
 namespace {
+	static boost::uint32_t debugStringLock = 0;
 #ifdef SYMBOL_THREADSAFE
-	static boost::uint32_t spinlock = 0;
-	inline void ACQUIRE_SYMBOL_LOCK() {
+	inline boost::uint32_t SYMBOL_ATOMIC_CAS(boost::uint32_t &mem, boost::uint32_t with, boost::uint32_t cmp) {
 #if BOOST_VERSION < 104800
-		while(boost::interprocess::detail::atomic_cas32(&spinlock, 1, 0));
+		return boost::interprocess::detail::atomic_cas32(&mem, with, cmp);
 #else
-		while(boost::interprocess::ipcdetail::atomic_cas32(&spinlock, 1, 0));
+		return boost::interprocess::ipcdetail::atomic_cas32(&mem, with, cmp);
 #endif // BOOST_VERSION < 104800
 	}
-	inline void RELEASE_SYMBOL_LOCK() {
+	inline void ACQUIRE_SYMBOL_LOCK(boost::uint32_t &spinlock) {
+		while(SYMBOL_ATOMIC_CAS(spinlock, 1, 0));
+	}
+	inline void RELEASE_SYMBOL_LOCK(boost::uint32_t &spinlock) {
 		assert(spinlock);
 		spinlock = 0;
 	}
 #elif defined(SYMBOL_TEST_THREADSAFE)
-	static boost::uint32_t spinlock = 0;
-	inline void ACQUIRE_SYMBOL_LOCK() {
+	inline void ACQUIRE_SYMBOL_LOCK(boost::uint32_t &spinlock) {
 		if (spinlock != 0) {
 			throw InternalInconsistencyException(
 				"Symbol::AQUIRE_SYMBOL_LOCK (Symbol.cpp)",
@@ -66,7 +77,7 @@ namespace {
 		}
 		spinlock = 1;
 	}
-	inline void RELEASE_SYMBOL_LOCK() {
+	inline void RELEASE_SYMBOL_LOCK(boost::uint32_t &spinlock) {
 		if (spinlock != 1) {
 			throw InternalInconsistencyException(
 				"Symbol::RELEASE_SYMBOL_LOCK (Symbol.cpp)",
@@ -76,9 +87,25 @@ namespace {
 	}
 
 #else
-	inline void ACQUIRE_SYMBOL_LOCK() {}
-	inline void RELEASE_SYMBOL_LOCK() {}
+	inline void ACQUIRE_SYMBOL_LOCK(boost::uint32_t &) {}
+	inline void RELEASE_SYMBOL_LOCK(boost::uint32_t &) {}
+#endif
+
+	// Set the frozen bit in a SymbolData's reference count.  Other threads 
+	// may be updating the reference count at the same time, so we use 
+	// compare-and-swap when SYMBOL_THREADSAFE is defined.
+	inline void freezeSymbolData(SymbolData *symData) {
+#if defined(SYMBOL_REF_COUNT) && defined(SYMBOL_THREADSAFE)
+		boost::uint32_t old_count = symData->ref_count;
+		while (true) {
+			boost::uint32_t prev = SYMBOL_ATOMIC_CAS(symData->ref_count, old_count | SYMBOL_FROZEN_REF_COUNT, old_count);
+			if (prev == old_count) break;
+			old_count = prev;
+		}
+#elif defined(SYMBOL_REF_COUNT)
+		symData->ref_count |= SYMBOL_FROZEN_REF_COUNT;
 #endif
+	}
 }
 
 //======================================================================
@@ -252,6 +279,15 @@ struct HashSymbolDataPtr {
 		{ return e->hash_value; }};
 typedef hash_set<SymbolData*, HashSymbolDataPtr, EqualSymbolDataPtr> Dictionary;
 
+// One shard of a SymbolTable's dictionary.  Each symbol belongs to the 
+// shard selected by the high bits of its hash value (the low bits are
+// used by the dictionary to select a bucket).
+struct SymbolTableShard: boost::noncopyable {
+	Dictionary dictionary; // Hash-set of pointers into symbolDataPool
+	boost::uint32_t lock;
+	SymbolTableShard(): dictionary(SYMBOL_TABLE_BUCKETS/SYMBOL_TABLE_SHARDS+1), lock(0) {}
+};
+
 // This struct holds all the private members used by a SymbolTable.
 // We keep it separate from the SymbolTable class itself because 
 // otherwise we would need to #include <boost/pool> in the Symbol.h
@@ -263,14 +299,39 @@ class SymbolTableImpl: boost::noncopyable {
 private:
 	FixedBlockSizePool symbolDataPool;
 	StringPool<wchar_t> stringPool;
-	Dictionary dictionary; // Hash-set of pointers into symbolDataPool
+	boost::uint32_t poolLock; // Guards symbolDataPool and stringPool
+	SymbolTableShard shards[SYMBOL_TABLE_SHARDS];
 	std::string tableName; // For debugging purposes only
 
+	// An open-addressing (linear probing) hash table containing the frozen
+	// symbols.  It is never modified once it has been built, so it can be 
+	// searched without taking any lock.  Empty slots are NULL.  The frozen
+	// symbols are also contained in the shard dictionaries.
+	SymbolData **frozenIndex;
+	size_t frozenIndexMask; // (number of slots in frozenIndex) - 1
+
 	SymbolTableImpl(std::string const &tableName): 
 		symbolDataPool(sizeof(SymbolData), SYMBOL_ENTRY_BLOCK_SIZE), 
 		stringPool("Symbol String Pool"),
-		dictionary(SYMBOL_TABLE_BUCKETS),
-		tableName(tableName) {}
+		poolLock(0),
+		tableName(tableName),
+		frozenIndex(0), frozenIndexMask(0) {}
+
+	~SymbolTableImpl() { delete[] frozenIndex; }
+
+	SymbolTableShard &shardFor(size_t hash_value) {
+		return shards[(hash_value >> (sizeof(size_t)*8-8)) % SYMBOL_TABLE_SHARDS];
+	}
+
+	SymbolData *findFrozen(const SymbolData *query) const {
+		if (frozenIndex == 0) return 0;
+		for (size_t i = query->hash_value & frozenIndexMask; frozenIndex[i] != 0; i = (i+1) & frozenIndexMask) {
+			if (frozenIndex[i]->hash_value == query->hash_value && 
+				wcscmp(frozenIndex[i]->str, query->str) == 0)
+				return frozenIndex[i];
+		}
+		return 0;
+	}
 };
 
 SymbolTable::SymbolTable(std::string const &tableName): 
@@ -281,7 +342,9 @@ _impl(_new SymbolTableImpl(tableName)) {
 	_nullSymbol->str = 0;
 	_nullSymbol->hash_value = 0;
 	_nullSymbol->debug_str = 0;
-	_nullSymbol->ref_count = 1;
+#ifdef SYMBOL_REF_COUNT
+	_nullSymbol->ref_count = SYMBOL_FROZEN_REF_COUNT | 1;
+#endif
 	// Always use the en_US.utf8 locale -- this defines the behavior
 	// of functions like iswspace(), isupper() etc.  The main reason we
 	// do this here (rather than somewhere else) is that we can be fairly
@@ -292,13 +355,14 @@ _impl(_new SymbolTableImpl(tableName)) {
 }
 
 SymbolTable::~SymbolTable() { 
-	ACQUIRE_SYMBOL_LOCK();
 	delete _impl; 
-	RELEASE_SYMBOL_LOCK();
 }
 
 size_t SymbolTable::size() {
-	return _impl->dictionary.size()+1; // include the NULL symbol.
+	size_t result = 1; // include the NULL symbol.
+	for (size_t i=0; i<SYMBOL_TABLE_SHARDS; ++i)
+		result += _impl->shards[i].dictionary.size();
+	return result;
 }
 
 SymbolData* SymbolTable::newRef(const wchar_t *str) {
@@ -313,28 +377,38 @@ SymbolData* SymbolTable::newRef(const wchar_t *str) {
 	SymbolData querySymData;
 	querySymData.str = str;
 	querySymData.hash_value = hash_value;
-	ACQUIRE_SYMBOL_LOCK();
-	SymbolData *symData = _impl->dictionary.find_singleton(&querySymData, hash_value);
+
+	// Frozen symbols can be found without taking any lock.
+	if (SymbolData *frozenSymData = _impl->findFrozen(&querySymData)) {
+		SYMBOL_DATA_INCREF(frozenSymData);
+		return frozenSymData;
+	}
+
+	SymbolTableShard &shard = _impl->shardFor(hash_value);
+	ACQUIRE_SYMBOL_LOCK(shard.lock);
+	SymbolData *symData = shard.dictionary.find_singleton(&querySymData, hash_value);
 
 	// If it's not found, then we need to create a new symbol data object for it.  
 	if (symData == NULL) {
+		ACQUIRE_SYMBOL_LOCK(_impl->poolLock);
 		symData = static_cast<SymbolData*>(_impl->symbolDataPool.malloc());
 		symData->str = _impl->stringPool.copy(str);
+		RELEASE_SYMBOL_LOCK(_impl->poolLock);
 		symData->debug_str = 0;
 		symData->hash_value = hash_value;
 #ifdef SYMBOL_REF_COUNT
 		symData->ref_count = 1;
 #endif
-		_impl->dictionary.insertWithoutChecking(symData);
+		shard.dictionary.insertWithoutChecking(symData);
 #ifdef PROFILE_SYMBOL
-		if ((size()%10000) == 0) {
+		if ((shard.dictionary.size()%(10000/SYMBOL_TABLE_SHARDS+1)) == 0) {
 			printDebugInfo();
 		}
 #endif
 	} else {
 		SYMBOL_DATA_INCREF(symData);
 	}
-	RELEASE_SYMBOL_LOCK();
+	RELEASE_SYMBOL_LOCK(shard.lock);
 #ifdef SYMBOL_REF_COUNT
 	assert (symData->ref_count > 0);
 #endif
@@ -352,55 +426,82 @@ SymbolData* SymbolTable::newRef(const wchar_t* str, size_t off, size_t len) {
 }
 
 void SymbolTable::delRef(SymbolData *symData) {
-	ACQUIRE_SYMBOL_LOCK();
-	_impl->dictionary.erase(symData);
+	_impl->shardFor(symData->hash_value).dictionary.erase(symData);
+	ACQUIRE_SYMBOL_LOCK(_impl->poolLock);
 	_impl->stringPool.free(symData->str);
-	if (symData->debug_str) { debugStringPool().free(symData->debug_str); }
+	if (symData->debug_str) { 
+		ACQUIRE_SYMBOL_LOCK(debugStringLock);
+		debugStringPool().free(symData->debug_str); 
+		RELEASE_SYMBOL_LOCK(debugStringLock);
+	}
 	_impl->symbolDataPool.free(symData);
-	RELEASE_SYMBOL_LOCK();
+	RELEASE_SYMBOL_LOCK(_impl->poolLock);
 }
 
 size_t SymbolTable::discardAllSymbols() {
 	size_t num_symbols_discarded = 0;
-	Dictionary::iterator iter = _impl->dictionary.begin();
-	Dictionary::iterator dictEnd = _impl->dictionary.end();
-	while(iter != dictEnd) {
-		SymbolData* symData = *iter;
-		++iter;
-		++num_symbols_discarded;
-		delRef(symData);
+	// Frozen symbols are about to be deleted, so discard the frozen index.
+	delete[] _impl->frozenIndex;
+	_impl->frozenIndex = 0;
+	_impl->frozenIndexMask = 0;
+	for (size_t i=0; i<SYMBOL_TABLE_SHARDS; ++i) {
+		SymbolTableShard &shard = _impl->shards[i];
+		ACQUIRE_SYMBOL_LOCK(shard.lock);
+		Dictionary::iterator iter = shard.dictionary.begin();
+		Dictionary::iterator dictEnd = shard.dictionary.end();
+		while(iter != dictEnd) {
+			SymbolData* symData = *iter;
+			++iter;
+			++num_symbols_discarded;
+			delRef(symData);
+		}
+		RELEASE_SYMBOL_LOCK(shard.lock);
 	}
+	ACQUIRE_SYMBOL_LOCK(debugStringLock);
 	debugStringPool().release_memory();
+	RELEASE_SYMBOL_LOCK(debugStringLock);
 	_impl->stringPool.purge_memory();
 	_impl->symbolDataPool.purge_memory();
 	return num_symbols_discarded;
 }
 
+// This is safe to run while other threads are using the table: a symbol 
+// whose reference count is zero can only be revived by newRef(), which 
+// holds the symbol's shard lock while it looks the symbol up.
 size_t SymbolTable::discardUnusedSymbols(bool verbose) {
 	size_t num_symbols_discarded = 0;
 #ifdef SYMBOL_REF_COUNT
-	Dictionary::iterator iter = _impl->dictionary.begin();
-	Dictionary::iterator dictEnd = _impl->dictionary.end();
-	while(iter != dictEnd) {
-		SymbolData* symData = (*iter);
-		// Increment the iterator now (rather than at the end of the loop); 
-		// otherwise it will become invalid if/when we call delRef().
-		++iter;
-		if (symData->ref_count == 0) {
-			if (verbose) {
-				std::wcerr << "  Discard: [" << symData->str << "]" << std::endl;
-			}
-			assert(symData->str != 0); // NULL symbol should not be in the dictionary.
-			delRef(symData);
-			++num_symbols_discarded;
-		} else {
-			if (verbose) {
-				std::wcerr << "     Keep: [" << symData->str << "] (" << symData->ref_count << ")" << std::endl;
+	for (size_t i=0; i<SYMBOL_TABLE_SHARDS; ++i) {
+		SymbolTableShard &shard = _impl->shards[i];
+		ACQUIRE_SYMBOL_LOCK(shard.lock);
+		Dictionary::iterator iter = shard.dictionary.begin();
+		Dictionary::iterator dictEnd = shard.dictionary.end();
+		while(iter != dictEnd) {
+			SymbolData* symData = (*iter);
+			// Increment the iterator now (rather than at the end of the loop); 
+			// otherwise it will become invalid if/when we call delRef().
+			++iter;
+			if (symData->ref_count == 0) {
+				if (verbose) {
+					std::wcerr << "  Discard: [" << symData->str << "]" << std::endl;
+				}
+				assert(symData->str != 0); // NULL symbol should not be in the dictionary.
+				delRef(symData);
+				++num_symbols_discarded;
+			} else {
+				if (verbose) {
+					std::wcerr << "     Keep: [" << symData->str << "] (" << symData->ref_count << ")" << std::endl;
+				}
 			}
 		}
+		RELEASE_SYMBOL_LOCK(shard.lock);
 	}
+	ACQUIRE_SYMBOL_LOCK(debugStringLock);
 	debugStringPool().release_memory();
+	RELEASE_SYMBOL_LOCK(debugStringLock);
+	ACQUIRE_SYMBOL_LOCK(_impl->poolLock);
 	_impl->stringPool.release_memory();
+	RELEASE_SYMBOL_LOCK(_impl->poolLock);
 	if (verbose) {
 		std::cerr << "Discarded " << num_symbols_discarded << " unused symbols!" << std::endl;
 	}
@@ -415,9 +516,12 @@ bool SymbolTable::contains(const wchar_t* str)
 	SymbolData symData;
 	symData.str = str;
 	symData.hash_value = Symbol::hash_str(str);
-	ACQUIRE_SYMBOL_LOCK();
-    bool result = (_impl->dictionary.find(&symData) != _impl->dictionary.end());
-	RELEASE_SYMBOL_LOCK();
+	if (_impl->findFrozen(&symData))
+		return true;
+	SymbolTableShard &shard = _impl->shardFor(symData.hash_value);
+	ACQUIRE_SYMBOL_LOCK(shard.lock);
+    bool result = (shard.dictionary.find(&symData) != shard.dictionary.end());
+	RELEASE_SYMBOL_LOCK(shard.lock);
 	return result;
 }
 
@@ -435,12 +539,44 @@ void SymbolTable::initializeSymbolsFromFile() {
 				"Symbol initialization file not found -- "
 				"check 'symbol_table_initialization_file' parameter...");
 		}
+		std::vector<SymbolData*> symbols;
 		while (!input.eof()) {
 			UTF8Token token;
 			input >> token;
-			newRef(token.chars());
+			symbols.push_back(newRef(token.chars()));
+		}
+		if (_impl->frozenIndex == 0 &&
+			ParamReader::getOptionalTrueFalseParamWithDefaultVal("freeze_symbol_table_initialization_symbols", true))
+		{
+			freezeSymbols(symbols);
+		}
+	}
+}
+
+void SymbolTable::freezeSymbols(const std::vector<SymbolData*> &symbols) {
+	if (_impl->frozenIndex != 0)
+		throw InternalInconsistencyException("SymbolTable::freezeSymbols",
+			"Symbols have already been frozen for this SymbolTable");
+	// Use a table that is at most half full, so probe sequences stay short.
+	size_t num_slots = 16;
+	while (num_slots < symbols.size()*2)
+		num_slots *= 2;
+	SymbolData **frozenIndex = _new SymbolData*[num_slots];
+	std::fill(frozenIndex, frozenIndex+num_slots, static_cast<SymbolData*>(0));
+	size_t mask = num_slots-1;
+	for (size_t i=0; i<symbols.size(); ++i) {
+		SymbolData *symData = symbols[i];
+		if (symData == _nullSymbol) continue;
+		size_t slot = symData->hash_value & mask;
+		while (frozenIndex[slot] != 0 && frozenIndex[slot] != symData)
+			slot = (slot+1) & mask;
+		if (frozenIndex[slot] == 0) {
+			freezeSymbolData(symData);
+			frozenIndex[slot] = symData;
 		}
 	}
+	_impl->frozenIndexMask = mask;
+	_impl->frozenIndex = frozenIndex;
 }
 
 // This method under-reports the actual memory usage, in a couple different
@@ -453,31 +589,35 @@ void SymbolTable::printDebugInfo() {
 
 	// Memory usage stats:
 	size_t mem_overhead = sizeof(SymbolTable) + sizeof(SymbolTableImpl);
-	size_t mem_dictionary = _impl->dictionary.approximateSizeInBytes();
+	size_t mem_dictionary = (_impl->frozenIndexMask+1)*sizeof(SymbolData*);
 	size_t mem_symdata = 0;
 	size_t mem_strings = 0;
 	size_t mem_debug_strings = 0;
 	size_t mem_zero_refcount = 0;
 	
-	Dictionary::iterator dictEnd = _impl->dictionary.end();
-	for(Dictionary::iterator iter = _impl->dictionary.begin();iter != dictEnd; ++iter) {
-		SymbolData* symData = (*iter);
-		++num_symbols;
-		mem_symdata += sizeof(SymbolData);
-		if (symData->str)
-			mem_strings += (wcslen(symData->str)+1)*sizeof(wchar_t);
-		if (symData->debug_str)
-			mem_debug_strings += (strlen(symData->debug_str)+1)*sizeof(char);
-#ifdef SYMBOL_REF_COUNT
-		if (symData->ref_count == 0) {
-			++num_zero_refcount_symbols;
-			mem_zero_refcount += sizeof(SymbolData);
+	for (size_t i=0; i<SYMBOL_TABLE_SHARDS; ++i) {
+		Dictionary &dictionary = _impl->shards[i].dictionary;
+		mem_dictionary += dictionary.approximateSizeInBytes();
+		Dictionary::iterator dictEnd = dictionary.end();
+		for(Dictionary::iterator iter = dictionary.begin();iter != dictEnd; ++iter) {
+			SymbolData* symData = (*iter);
+			++num_symbols;
+			mem_symdata += sizeof(SymbolData);
 			if (symData->str)
-				mem_zero_refcount += (wcslen(symData->str)+1)*sizeof(wchar_t);
+				mem_strings += (wcslen(symData->str)+1)*sizeof(wchar_t);
 			if (symData->debug_str)
-				mem_zero_refcount += (strlen(symData->debug_str)+1)*sizeof(char);
-		}
+				mem_debug_strings += (strlen(symData->debug_str)+1)*sizeof(char);
+#ifdef SYMBOL_REF_COUNT
+			if (symData->ref_count == 0) {
+				++num_zero_refcount_symbols;
+				mem_zero_refcount += sizeof(SymbolData);
+				if (symData->str)
+					mem_zero_refcount += (wcslen(symData->str)+1)*sizeof(wchar_t);
+				if (symData->debug_str)
+					mem_zero_refcount += (strlen(symData->debug_str)+1)*sizeof(char);
+			}
 #endif
+		}
 	}
 
 	// These are better estimates of the memory usages of the pools:
@@ -515,18 +655,21 @@ void SymbolTable::printDebugInfo() {
 }
 
 void SymbolTable::freeAllDebugStrings() {
-	ACQUIRE_SYMBOL_LOCK();
-	Dictionary::iterator iter = _impl->dictionary.begin();
-	Dictionary::iterator dictEnd = _impl->dictionary.end();
-	while(iter != dictEnd) {
-		SymbolData* symData = *iter;
-		if (symData->debug_str)
-			debugStringPool().free(symData->debug_str);
-		symData->debug_str = 0;
-		++iter;
+	ACQUIRE_SYMBOL_LOCK(debugStringLock);
+	for (size_t i=0; i<SYMBOL_TABLE_SHARDS; ++i) {
+		Dictionary &dictionary = _impl->shards[i].dictionary;
+		Dictionary::iterator iter = dictionary.begin();
+		Dictionary::iterator dictEnd = dictionary.end();
+		while(iter != dictEnd) {
+			SymbolData* symData = *iter;
+			if (symData->debug_str)
+				debugStringPool().free(symData->debug_str);
+			symData->debug_str = 0;
+			++iter;
+		}
 	}
 	debugStringPool().release_memory();
-	RELEASE_SYMBOL_LOCK();
+	RELEASE_SYMBOL_LOCK(debugStringLock);
 }
 
 namespace {
@@ -644,11 +787,14 @@ const Symbol Symbol::operator+ (const Symbol &sym2) const {
 char const * Symbol::to_debug_string() const {
 	if (data == NULL) return 0;
 	if ((data->debug_str == NULL) && (data->str != NULL)) {
-		ACQUIRE_SYMBOL_LOCK();
-	    static char debug_s[MAX_DEBUG_SYMBOL_CHARS+1];
-		StringTransliterator::transliterateToEnglish(debug_s, data->str, MAX_DEBUG_SYMBOL_CHARS);
-		data->debug_str = debugStringPool().copy(debug_s);
-		RELEASE_SYMBOL_LOCK();
+		ACQUIRE_SYMBOL_LOCK(debugStringLock);
+		// Check again, in case another thread got here first.
+		if (data->debug_str == NULL) {
+		    static char debug_s[MAX_DEBUG_SYMBOL_CHARS+1];
+			StringTransliterator::transliterateToEnglish(debug_s, data->str, MAX_DEBUG_SYMBOL_CHARS);
+			data->debug_str = debugStringPool().copy(debug_s);
+		}
+		RELEASE_SYMBOL_LOCK(debugStringLock);
 	}
 	return data->debug_str;
 }
@@ -733,6 +879,77 @@ bool Symbol::unitTest() {
 	table->printDebugInfo();
 	ASSERT(table->contains(L"==hello==") == false);
 	table->printDebugInfo();
+
+	// Frozen symbols are never discarded.
+	Symbol sym_frozen(L"==frozen==", table);
+	SymbolData *frozenData = sym_frozen.data;
+	table->freezeSymbols(std::vector<SymbolData*>(1, frozenData));
+	ASSERT((frozenData->ref_count & SYMBOL_FROZEN_REF_COUNT) != 0);
+	sym_frozen = Symbol();
+	ASSERT(table->discardUnusedSymbols(false) == 0);
+	ASSERT(table->contains(L"==frozen==") == true);
+	ASSERT(Symbol(L"==frozen==", table).data == frozenData);
 #endif
 	return true;
 }
+
+//======================================================================
+// Benchmark
+
+namespace {
+	void internSymbols(SymbolTable *table, const std::vector<std::wstring> *words, size_t repetitions) {
+		for (size_t r=0; r<repetitions; ++r) {
+			for (size_t i=0; i<words->size(); ++i) {
+				Symbol sym((*words)[i].c_str(), table);
+				Symbol copy(sym);
+			}
+		}
+	}
+}
+
+void Symbol::benchmark(size_t max_threads) {
+#ifndef SYMBOL_THREADSAFE
+	if (max_threads > 1) {
+		std::cerr << "Symbol::benchmark: SYMBOL_THREADSAFE is not defined; only using 1 thread." << std::endl;
+		max_threads = 1;
+	}
+#endif
+	// Nine out of ten tokens are drawn from a small set of common words; 
+	// the rest are rare words.
+	const size_t NUM_TOKENS = 100000;
+	const size_t NUM_COMMON_WORDS = 1000;
+	const size_t REPETITIONS = 10;
+	std::vector<std::wstring> words;
+	for (size_t i=0; i<NUM_TOKENS; ++i) {
+		std::wostringstream word;
+		word << L"word" << ((i%10 == 0) ? i : (i % NUM_COMMON_WORDS));
+		words.push_back(word.str());
+	}
+
+	for (int freeze_common_words=0; freeze_common_words<2; ++freeze_common_words) {
+		for (size_t num_threads=1; num_threads<=max_threads; ++num_threads) {
+			SymbolTable table("BenchmarkSymbolTable");
+			std::vector<Symbol> commonWords;
+			if (freeze_common_words) {
+				std::vector<SymbolData*> frozen;
+				for (size_t i=0; i<NUM_COMMON_WORDS; ++i) {
+					commonWords.push_back(Symbol(words[i+1].c_str(), &table));
+					frozen.push_back(commonWords.back().data);
+				}
+				table.freezeSymbols(frozen);
+			}
+			GenericTimer timer;
+			timer.startTimer();
+			boost::thread_group threads;
+			for (size_t t=0; t<num_threads; ++t)
+				threads.create_thread(boost::bind(&internSymbols, &table, &words, REPETITIONS));
+			threads.join_all();
+			timer.stopTimer();
+			double num_interns = static_cast<double>(num_threads*NUM_TOKENS*REPETITIONS);
+			double seconds = (std::max)(timer.getTime(), 1.0)/1000.0;
+			std::cout << "Symbol::benchmark " << (freeze_common_words ? "(frozen common words) " : "")
+				<< std::setw(3) << num_threads << " thread(s): " 
+				<< std::setw(12) << static_cast<size_t>(num_interns/seconds) << " interns/sec" << std::endl;
+		}
+	}
+}
@@ -33,10 +33,19 @@
   * non-static symbol tables).  Reference counting can be turned off by unsetting
   * the preprocessor symbol SYMBOL_REF_COUNT (controlled by cmake).
   *
+  * Symbols that are read by SymbolTable::initializeSymbolsFromFile() can be
+  * "frozen".  Frozen symbols are permanent: they are never discarded, and
+  * copying or destroying a Symbol that wraps a frozen SymbolData does not touch
+  * its reference count (which avoids contention on the reference count when many
+  * threads use the same common words).  The NULL symbol is always frozen.
+  *
   * Basic Symbol operations (including symbol creation, deletion, and comparison)
-  * are thread-safe iff the preprocessor symbol SYMBOL_THREADSAFE is defined.  Some
-  * of the more complex operations, such as Symbol::discardUnusedSymbols(), are 
-  * not thread-safe, and should only be used when you are sure a single thread is
+  * are thread-safe iff the preprocessor symbol SYMBOL_THREADSAFE is defined.  To
+  * keep symbol creation from becoming a bottleneck, the table is split into 
+  * SYMBOL_TABLE_SHARDS shards (selected by hash value), each with its own lock;
+  * and lookups of frozen symbols do not take any lock at all.  Some of the more 
+  * complex operations, such as SymbolTable::discardAllSymbols(), are not 
+  * thread-safe, and should only be used when you are sure a single thread is
   * running.  (SYMBOL_THREADSAFE is controlled by cmake.)
   */
 
@@ -51,6 +60,7 @@
 #include <boost/functional/hash.hpp>
 #include "dynamic_includes/common/SymbolDefinitions.h"
 #include <set>
+#include <vector>
 
 #ifndef SERIF_EXPORTED
 #define SERIF_EXPORTED
@@ -81,20 +91,26 @@ struct SymbolData: boost::noncopyable {
 	const char* debug_str;     // ASCII version of str; only allocated if requested.
 	size_t hash_value;         // Cached value of Symbol::hash_str(this->str).
 #ifdef SYMBOL_REF_COUNT
-	boost::uint32_t ref_count; // Reference count.
+	boost::uint32_t ref_count; // Reference count (see SYMBOL_FROZEN_REF_COUNT).
 #endif
 };
 
+/** Bit that is set in SymbolData::ref_count for frozen symbols.  A frozen
+  * symbol's reference count never drops to zero, so it is never discarded;
+  * and in thread-safe builds, its reference count is not updated at all. */
+#define SYMBOL_FROZEN_REF_COUNT 0x80000000u
+
 #if !defined(SYMBOL_REF_COUNT)
 #define SYMBOL_DATA_INCREF(s)
 #define SYMBOL_DATA_DECREF(s)
 #elif defined(SYMBOL_THREADSAFE)
+#define SYMBOL_DATA_IS_COUNTED(s) (s && !((s)->ref_count & SYMBOL_FROZEN_REF_COUNT))
 #if BOOST_VERSION < 104800
-#define SYMBOL_DATA_INCREF(s) (s ? boost::interprocess::detail::atomic_inc32(&((s)->ref_count)) : 0)
-#define SYMBOL_DATA_DECREF(s) (s ? boost::interprocess::detail::atomic_dec32(&((s)->ref_count)) : 0)
+#define SYMBOL_DATA_INCREF(s) (SYMBOL_DATA_IS_COUNTED(s) ? boost::interprocess::detail::atomic_inc32(&((s)->ref_count)) : 0)
+#define SYMBOL_DATA_DECREF(s) (SYMBOL_DATA_IS_COUNTED(s) ? boost::interprocess::detail::atomic_dec32(&((s)->ref_count)) : 0)
 #else 
-#define SYMBOL_DATA_INCREF(s) (s ? boost::interprocess::ipcdetail::atomic_inc32(&((s)->ref_count)) : 0)
-#define SYMBOL_DATA_DECREF(s) (s ? boost::interprocess::ipcdetail::atomic_dec32(&((s)->ref_count)) : 0)
+#define SYMBOL_DATA_INCREF(s) (SYMBOL_DATA_IS_COUNTED(s) ? boost::interprocess::ipcdetail::atomic_inc32(&((s)->ref_count)) : 0)
+#define SYMBOL_DATA_DECREF(s) (SYMBOL_DATA_IS_COUNTED(s) ? boost::interprocess::ipcdetail::atomic_dec32(&((s)->ref_count)) : 0)
 #endif // BOOST_VERSION < 104800
 #else
 #define SYMBOL_DATA_INCREF(s) (s ? ++((s)->ref_count) : 0)
@@ -119,7 +135,8 @@ public:
 	virtual ~SymbolTable();
 
 	/** Free the memory associated with any SymbolData objects whose reference
-	  * count is zero. */
+	  * count is zero.  When SYMBOL_THREADSAFE is defined, this may be called
+	  * while other threads are using the table. */
 	size_t discardUnusedSymbols(bool verbose=false);
 
 	/** Free the memory associated with all symbols.  It is an error to attempt 
@@ -135,7 +152,9 @@ public:
 	  * ParamReader::getParam("symbol_table_initialization_file").  This will
 	  * permanantly intern all strings contained in that file (i.e., their 
 	  * reference count will never go to zero, so they will not be deleted by 
-	  * discardUnusedSymbols). */
+	  * discardUnusedSymbols).  Unless the parameter 
+	  * "freeze_symbol_table_initialization_symbols" is false, these symbols
+	  * are also frozen (the first time this is called). */
 	void initializeSymbolsFromFile();
 
 	/** Return the number of Symbols interned in this SymbolTable. */
@@ -151,17 +170,23 @@ public:
 	void freeAllDebugStrings();
 
 private:
+	// Freeze the given symbols, and build the lock-free index that is used
+	// to look them up.  This may only be done once per table, and should be
+	// done before other threads start using the table.
+	void freezeSymbols(const std::vector<SymbolData*> &symbols);
 	// Look up a string in the table; add it if necessary.
 	SymbolData* newRef(const wchar_t *str);
 	SymbolData* newRef(const wchar_t* str, size_t off, size_t len);
-	// Delete all memory owned by a given SymbolData.  Requires: data->ref_count==0.
+	// Delete all memory owned by a given SymbolData.  Requires: data->ref_count==0,
+	// and the caller must hold the lock for the shard that contains data.
 	void delRef(SymbolData *data);
 	// Pointer to the implementation: contains the data structures actually used
 	// to implement the SymbolTable.
 	SymbolTableImpl *_impl;
 	// Pointer to the SymbolData for the NULL symbol.  This special
 	// symbol never compares equal to any string-valued symbol, and
-	// its reference count will never drop to zero.  Its str is NULL.
+	// it is frozen, so its reference count will never drop to zero.  
+	// Its str is NULL.
 	SymbolData *_nullSymbol;
 };
 
@@ -222,6 +247,11 @@ public:
 	/** Return a hash code for this Symbol. */
 	size_t hash_code() const             { return data->hash_value; }
 
+	/** Return a value that uniquely identifies this Symbol: two Symbols have
+	  * the same identifier if and only if they are equal.  The identifier is
+	  * only meaningful while the Symbol is interned. */
+	size_t identifier() const            { return reinterpret_cast<size_t>(data); }
+
 	/** Return the string contents of this Symbol. */
 	wchar_t const * to_string() const    { return data->str; }
 
@@ -262,8 +292,7 @@ public:
 		return defaultSymbolTable()->contains(str); }
 
 	/** Remove any symbols whose ref_count is zero from the set of interned strings. 
-	  * Even when SYMBOL_THREADSAFE is declared, this method is still not thread
-	  * safe; only call it if you are the only thread! */
+	  * This is only thread safe if SYMBOL_THREADSAFE is declared. */
 	static size_t discardUnusedSymbols(bool verbose=false) {
 		return defaultSymbolTable()->discardUnusedSymbols(verbose); }
 
@@ -279,6 +308,9 @@ public:
     static size_t hash_str(const wchar_t* s);
 	/** Run unit tests and display the results.  Return true if successful. */
 	static bool unitTest();
+	/** Measure symbol creation throughput (interns/sec) using 1...max_threads 
+	  * threads, and display the results. */
+	static void benchmark(size_t max_threads);
 	// Used for determining whether a Symbol is contained in a predefined set of Symbol objects.
 	// See notes in NewSymbol.cpp.
 	static SymbolGroup makeSymbolGroup(const std::wstring & space_separated_words);
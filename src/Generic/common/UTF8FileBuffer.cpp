@@ -0,0 +1,213 @@
+// Copyright (c) 2012 by Raytheon BBN Technologies Corp.
+// All Rights Reserved.
+
+#include "Generic/common/leak_detection.h" // This must be the first #include
+
+#include "Generic/common/UTF8FileBuffer.h"
+#include <algorithm>
+#include <cstring>
+#include <cwchar>
+#include <ios>
+
+namespace {
+	const size_t BYTE_BUFFER_SIZE = 1 << 16;
+	const size_t CHAR_BUFFER_SIZE = 1 << 16;
+	// Number of characters before gptr() that are kept when the buffer is
+	// refilled, so that they can be put back.
+	const size_t PUTBACK_SIZE = 8;
+
+	// These match the checks in utf8_codecvt_facet.
+	inline bool invalidLeadingOctet(unsigned char c) {
+		return (0x7f < c && c < 0xc0) || (c > 0xfd);
+	}
+	inline bool invalidContinuingOctet(unsigned char c) {
+		return c < 0x80 || c > 0xbf;
+	}
+	inline size_t contOctetCount(unsigned char c) {
+		if (c < 0x80) return 0;
+		if (c < 0xe0) return 1;
+		if (c < 0xf0) return 2;
+		if (c < 0xf8) return 3;
+		if (c < 0xfc) return 4;
+		return 5;
+	}
+	inline size_t utf8Length(wchar_t ch) {
+		unsigned long c = static_cast<unsigned long>(ch);
+		if (c < 0x80) return 1;
+		if (c < 0x800) return 2;
+		if (c < 0x10000) return 3;
+		if (c < 0x200000) return 4;
+		if (c < 0x4000000) return 5;
+		return 6;
+	}
+}
+
+UTF8FileBuffer::UTF8FileBuffer()
+	: _file(0), _file_eof(false), _bytes(BYTE_BUFFER_SIZE), _bytes_start(0), _bytes_end(0),
+	  _chars(CHAR_BUFFER_SIZE), _egptr_offset(0)
+{
+	setg(&_chars[0], &_chars[0], &_chars[0]);
+}
+
+UTF8FileBuffer::~UTF8FileBuffer() {
+	close();
+}
+
+bool UTF8FileBuffer::open(const char *filename) {
+	close();
+	_file = std::fopen(filename, "rb");
+	if (_file == 0)
+		return false;
+	seekTo(0);
+	return true;
+}
+
+bool UTF8FileBuffer::close() {
+	if (_file == 0)
+		return false;
+	std::fclose(_file);
+	_file = 0;
+	setg(&_chars[0], &_chars[0], &_chars[0]);
+	return true;
+}
+
+UTF8FileBuffer::int_type UTF8FileBuffer::underflow() {
+	if (gptr() < egptr())
+		return traits_type::to_int_type(*gptr());
+	size_t n_keep = std::min(static_cast<size_t>(gptr() - eback()), PUTBACK_SIZE);
+	if (!fill(n_keep))
+		return traits_type::eof();
+	return traits_type::to_int_type(*gptr());
+}
+
+bool UTF8FileBuffer::nextLine(const wchar_t *&line, size_t &length, bool &terminated) {
+	size_t n_searched = 0;
+	while (true) {
+		size_t n_available = egptr() - gptr();
+		const wchar_t *newline = std::wmemchr(gptr() + n_searched, L'\n', n_available - n_searched);
+		if (newline != 0) {
+			line = gptr();
+			length = newline - gptr();
+			terminated = true;
+			setg(eback(), gptr() + length + 1, egptr());
+			return true;
+		}
+		n_searched = n_available;
+		if (!fill(std::min(static_cast<size_t>(gptr() - eback()), PUTBACK_SIZE))) {
+			if (n_available == 0)
+				return false;
+			line = gptr();
+			length = n_available;
+			terminated = false;
+			setg(eback(), egptr(), egptr());
+			return true;
+		}
+	}
+}
+
+bool UTF8FileBuffer::fill(size_t n_keep) {
+	if (_file == 0)
+		return false;
+	// Move the characters that we're keeping to the start of the buffer.
+	size_t n_unread = egptr() - gptr();
+	size_t n_kept = n_keep + n_unread;
+	if (n_kept > 0)
+		std::memmove(&_chars[0], gptr() - n_keep, n_kept * sizeof(wchar_t));
+	if (n_kept > _chars.size() / 2)
+		_chars.resize(_chars.size() * 2);
+	setg(&_chars[0], &_chars[0] + n_keep, &_chars[0] + n_kept);
+
+	while (true) {
+		// Decode whatever complete characters we have.
+		const size_t bytes_start = _bytes_start;
+		size_t n_decoded = decode(&_chars[0] + n_kept, &_chars[0] + _chars.size());
+		if (n_decoded > 0) {
+			_egptr_offset += _bytes_start - bytes_start;
+			setg(eback(), gptr(), egptr() + n_decoded);
+			return true;
+		}
+		// Read more of the file, after any partial character.
+		if (_file_eof) {
+			if (_bytes_start < _bytes_end)
+				throw std::ios_base::failure("UTF8FileBuffer: incomplete UTF-8 character at end of file");
+			return false;
+		}
+		size_t n_partial = _bytes_end - _bytes_start;
+		if (n_partial > 0)
+			std::memmove(&_bytes[0], &_bytes[0] + _bytes_start, n_partial);
+		_bytes_start = 0;
+		_bytes_end = n_partial + std::fread(&_bytes[0] + n_partial, 1, _bytes.size() - n_partial, _file);
+		if (_bytes_end < _bytes.size())
+			_file_eof = true;
+	}
+}
+
+size_t UTF8FileBuffer::decode(wchar_t *to, wchar_t *to_end) {
+	const unsigned char *from = reinterpret_cast<const unsigned char*>(&_bytes[0]) + _bytes_start;
+	const unsigned char *from_end = reinterpret_cast<const unsigned char*>(&_bytes[0]) + _bytes_end;
+	wchar_t *to_start = to;
+	while (from != from_end && to != to_end) {
+		// ASCII characters need no further checks.
+		if (*from < 0x80) {
+			*to++ = static_cast<wchar_t>(*from++);
+			continue;
+		}
+		size_t n_cont = contOctetCount(*from);
+		if (static_cast<size_t>(from_end - from) <= n_cont && !invalidLeadingOctet(*from))
+			break; // Incomplete character; wait for more bytes.
+		bool valid = !invalidLeadingOctet(*from);
+		for (size_t i = 1; valid && i <= n_cont; ++i)
+			valid = !invalidContinuingOctet(from[i]);
+		if (!valid) {
+			// Treat the invalid character as the end of the file.
+			_bytes_start = _bytes_end;
+			_file_eof = true;
+			return to - to_start;
+		}
+		static const unsigned long octet1_modifier_table[] = {0x00, 0xc0, 0xe0, 0xf0, 0xf8, 0xfc};
+		unsigned long ucs = *from++ - octet1_modifier_table[n_cont];
+		for (size_t i = 0; i < n_cont; ++i)
+			ucs = (ucs << 6) + (*from++ - 0x80);
+		*to++ = static_cast<wchar_t>(ucs);
+	}
+	_bytes_start = reinterpret_cast<const char*>(from) - &_bytes[0];
+	return to - to_start;
+}
+
+UTF8FileBuffer::pos_type UTF8FileBuffer::seekoff(off_type off, std::ios_base::seekdir dir, std::ios_base::openmode which) {
+	if (_file == 0 || !(which & std::ios_base::in))
+		return pos_type(off_type(-1));
+	if (dir == std::ios_base::beg)
+		return seekTo(off);
+	if (dir == std::ios_base::end) {
+		if (std::fseek(_file, 0, SEEK_END) != 0)
+			return pos_type(off_type(-1));
+		return seekTo(std::ftell(_file) + off);
+	}
+	// Find the current position by working back from the end of the get
+	// area.
+	boost::int64_t offset = _egptr_offset;
+	for (const wchar_t *ch = gptr(); ch != egptr(); ++ch)
+		offset -= utf8Length(*ch);
+	if (off == 0)
+		return pos_type(off_type(offset));
+	return seekTo(offset + off);
+}
+
+UTF8FileBuffer::pos_type UTF8FileBuffer::seekpos(pos_type pos, std::ios_base::openmode which) {
+	if (_file == 0 || !(which & std::ios_base::in))
+		return pos_type(off_type(-1));
+	return seekTo(off_type(pos));
+}
+
+UTF8FileBuffer::pos_type UTF8FileBuffer::seekTo(boost::int64_t offset) {
+	setg(&_chars[0], &_chars[0], &_chars[0]);
+	_bytes_start = _bytes_end = 0;
+	_file_eof = false;
+	if (offset < 0 || std::fseek(_file, static_cast<long>(offset), SEEK_SET) != 0) {
+		_egptr_offset = 0;
+		return pos_type(off_type(-1));
+	}
+	_egptr_offset = offset;
+	return pos_type(off_type(offset));
+}
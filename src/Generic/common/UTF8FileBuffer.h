@@ -0,0 +1,88 @@
+// Copyright (c) 2012 by Raytheon BBN Technologies Corp.
+// All Rights Reserved.
+
+#ifndef UTF8_FILE_BUFFER_H
+#define UTF8_FILE_BUFFER_H
+
+#include <boost/cstdint.hpp>
+#include <boost/noncopyable.hpp>
+#include <cstdio>
+#include <streambuf>
+#include <vector>
+
+/** A read-only stream buffer that decodes a UTF-8 file into wide
+  * characters.  UTF8InputStream uses it in place of a std::wfilebuf with
+  * a UTF-8 codecvt facet: it reads the file in large blocks and decodes
+  * each block in a single pass (with a fast path for ASCII), so reading
+  * characters from it is just a pointer increment.  It also lets callers
+  * find lines directly in its decoded buffer (see nextLine()), without
+  * copying them one character at a time.
+  *
+  * The file is decoded exactly as it is by std::wfilebuf with boost's
+  * utf8_codecvt_facet: an invalid UTF-8 sequence is treated as the end
+  * of the file, and a truncated character at the end of the file causes
+  * underflow() to throw an std::ios_base::failure (which the stream
+  * reports by setting its badbit).
+  *
+  * Stream positions are byte offsets in the file.  The current position
+  * (tellg()) is computed from the decoded characters, so it is only
+  * exact for well-formed (shortest-form) UTF-8. */
+class UTF8FileBuffer : public std::wstreambuf, private boost::noncopyable {
+public:
+	UTF8FileBuffer();
+	~UTF8FileBuffer();
+
+	/** Open the given file, closing any file that is already open.  Return
+	  * false if the file can not be opened. */
+	bool open(const char *filename);
+
+	/** Close the file.  Return false if no file was open. */
+	bool close();
+
+	bool is_open() const { return _file != 0; }
+
+	/** Find the next line, and advance past it and its '\n' terminator.
+	  * Set line and length to the line's characters (not including the
+	  * '\n'), which are stored in this buffer, and so are only valid until
+	  * the next time that characters are read from it.  Set terminated to
+	  * false if the line ended at the end of the file rather than with a
+	  * '\n'.  Return false if there are no characters left. */
+	bool nextLine(const wchar_t *&line, size_t &length, bool &terminated);
+
+protected:
+	virtual int_type underflow();
+	virtual pos_type seekoff(off_type off, std::ios_base::seekdir dir, std::ios_base::openmode which);
+	virtual pos_type seekpos(pos_type pos, std::ios_base::openmode which);
+
+private:
+	std::FILE *_file;
+	bool _file_eof;
+
+	// Bytes read from the file that have not been decoded yet are
+	// _bytes[_bytes_start.._bytes_end).
+	std::vector<char> _bytes;
+	size_t _bytes_start;
+	size_t _bytes_end;
+
+	// Decoded characters (the get area points into this).
+	std::vector<wchar_t> _chars;
+
+	// The byte offset in the file of the end of the get area.
+	boost::int64_t _egptr_offset;
+
+	/** Keep the last n_keep characters before gptr() and everything after
+	  * it, and decode more of the file after them (growing the character
+	  * buffer if it is more than half full).  Return false if no more
+	  * characters could be decoded because the end of the file was
+	  * reached. */
+	bool fill(size_t n_keep);
+
+	/** Decode as many complete characters as possible from the
+	  * undecoded bytes into [to, to_end), and return the number decoded. */
+	size_t decode(wchar_t *to, wchar_t *to_end);
+
+	/** Discard any buffered data, and go to the given byte offset. */
+	pos_type seekTo(boost::int64_t offset);
+};
+
+#endif
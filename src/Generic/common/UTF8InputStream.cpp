@@ -4,6 +4,7 @@
 #include "Generic/common/leak_detection.h" // This must be the first #include
 
 #include "Generic/common/UTF8InputStream.h"
+#include "Generic/common/UTF8FileBuffer.h"
 #include "Generic/common/UnexpectedInputException.h"
 #include "Generic/common/OutputUtil.h"
 #include "Generic/common/UnicodeUtil.h"
@@ -34,6 +35,9 @@
 size_t UTF8InputStream::_openFileRetries = 0;
 void UTF8InputStream::setOpenFileRetries(size_t n) { _openFileRetries = n; }
 
+bool UTF8InputStream::_useFileBuffer = true;
+void UTF8InputStream::setUseFileBuffer(bool use) { _useFileBuffer = use; }
+
 UTF8InputStream::UTF8InputStream() {
 	std::locale old_locale;
 	std::locale utf8_locale( old_locale, new boost::utf8::utf8_codecvt_facet );
@@ -76,6 +80,8 @@ UTF8InputStream::UTF8InputStream( const wchar_t * filename ) {
 	return;
 }	
 
+UTF8InputStream::~UTF8InputStream() {}
+
 class CannotOpenFileException : public UnexpectedInputException {
 public:
 	CannotOpenFileException(const char* loc, const char* msg) :
@@ -90,7 +96,7 @@ void UTF8InputStream::open( const char * file ){
 	if( this->is_open() )
 		this->close();
 
-	std::wifstream::open( file, std::ios::binary );
+	openFile( file );
 	if( (!this->is_open()) || (this->fail()) ){
 		if (_openFileRetries > 0) {
 			unsigned int delay = 1; // one second
@@ -99,7 +105,7 @@ void UTF8InputStream::open( const char * file ){
 				sleep(delay);
 				delay *= 2;
 				this->clear();
-				std::wifstream::open( file, std::ios::binary );
+				openFile( file );
 				if (this->is_open() && (!this->fail()))
 					break;
 			}
@@ -118,6 +124,94 @@ void UTF8InputStream::open( const wchar_t * file ){
 	open(OutputUtil::convertToUTF8BitString(file).c_str());
 }
 
+bool UTF8InputStream::openFile( const char * file ){
+	if (_useFileBuffer) {
+		if (!_fileBuffer)
+			_fileBuffer.reset(_new UTF8FileBuffer());
+		if (!_fileBuffer->open(file)) {
+			this->setstate(std::ios::failbit);
+			return false;
+		}
+		// Note: this also clears the stream's state.
+		std::wios::rdbuf(_fileBuffer.get());
+		return true;
+	} else {
+		if (usingFileBuffer())
+			std::wios::rdbuf(std::wifstream::rdbuf());
+		std::wifstream::open( file, std::ios::binary );
+		return std::wifstream::is_open() && !this->fail();
+	}
+}
+
+bool UTF8InputStream::usingFileBuffer() const {
+	return _fileBuffer && std::wios::rdbuf() == _fileBuffer.get();
+}
+
+void UTF8InputStream::close(){
+	if (usingFileBuffer()) {
+		if (!_fileBuffer->close())
+			this->setstate(std::ios::failbit);
+	} else {
+		std::wifstream::close();
+	}
+}
+
+UTF8InputStream& UTF8InputStream::getLine(std::wstring & str){
+	if (usingFileBuffer()) {
+		const wchar_t *line;
+		size_t length;
+		if (this->good())
+			str.clear();
+		if (getLineView(line, length))
+			str.assign(line, length);
+		return *this;
+	}
+
+	std::getline( *this, str );
+
+	// old getLine interface stripped carriage returns... sigh.
+	if( !str.empty() && str[ str.size() - 1 ] == L'\r' )
+		str.resize( str.size() - 1 );
+
+	return *this;
+}
+
+bool UTF8InputStream::getLineView(const wchar_t *&line, size_t &length){
+	if (!usingFileBuffer()) {
+		getLine(_lineBuffer);
+		if (this->fail())
+			return false;
+		line = _lineBuffer.c_str();
+		length = _lineBuffer.size();
+		return true;
+	}
+
+	// Find the line directly in the file buffer.  Set the stream's state
+	// the same way that std::getline would.
+	if (!this->good()) {
+		this->setstate(std::ios::failbit);
+		return false;
+	}
+	bool found = false;
+	bool terminated = true;
+	try {
+		found = _fileBuffer->nextLine(line, length, terminated);
+	} catch (std::ios_base::failure &) {
+		this->setstate(std::ios::badbit);
+		return false;
+	}
+	if (!found) {
+		this->setstate(std::ios::eofbit | std::ios::failbit);
+		return false;
+	}
+	if (!terminated)
+		this->setstate(std::ios::eofbit);
+
+	if (length > 0 && line[length - 1] == L'\r')
+		--length;
+	return true;
+}
+
 namespace {
 	bool& fileTracking() {
 		static bool _file_tracking = false;
@@ -146,10 +240,12 @@ void UTF8InputStream::registerFileOpen(const wchar_t* filename) {
 }
 
 bool UTF8InputStream::is_open() {
+	if (usingFileBuffer())
+		return _fileBuffer->is_open();
 	return std::wifstream::is_open();
 }
 std::wstreambuf* UTF8InputStream::rdbuf() {
-	return std::wifstream::rdbuf();
+	return std::wios::rdbuf();
 }
 
 //////////////////////////////////////////////////////////////////////
@@ -18,6 +18,7 @@ namespace boost { namespace utf8 {
 // utf8-codec declarations
 #include <boost/detail/utf8_codecvt_facet.hpp>
 #include <boost/shared_ptr.hpp>
+#include <boost/scoped_ptr.hpp>
 
 #include <iostream>
 #include <istream>
@@ -30,9 +31,15 @@ namespace boost { namespace utf8 {
 #define SERIF_EXPORTED
 #endif
 
+class UTF8FileBuffer;
+
 // This class wraps around a basic_ifstream, imbuing it with boost's utf8 functionality
 // via constructor. Additionally, because the old UTF8InputStream was non-standards conforming
 // in a number of aspects, there are various fixups and delegates to mimic the old behavior.
+//
+// By default, files are read through a UTF8FileBuffer, which decodes them in bulk, rather
+// than through the wifstream's own file buffer and the utf8 codecvt facet, since most of
+// our models are loaded through this class.  See setUseFileBuffer().
 class SERIF_EXPORTED UTF8InputStream : public std::wifstream {
 public:
 	struct Factory {
@@ -55,17 +62,20 @@ public:
 	virtual void open( const char * file );
 	virtual void open( const wchar_t * file );
 
+	// Hides std::wifstream::close(), which would not close a UTF8FileBuffer.
+	void close();
+
+	virtual ~UTF8InputStream();
+
 	// delegate methods to support the old UTF8InputStream interface
 	//  ( old interface used capital letters, std methods do not )
-	virtual UTF8InputStream& getLine(std::wstring & str){
-		std::getline( *this, str );
+	virtual UTF8InputStream& getLine(std::wstring & str);
 
-		// old getLine interface stripped carriage returns... sigh.
-		if( !str.empty() && str[ str.size() - 1 ] == L'\r' )
-			str.resize( str.size() - 1 );
-
-		return *this;
-	}
+	/** Read the next line, like getLine(), but rather than copying it into
+	  * a string, set line and length to point at its characters.  These are
+	  * only valid until the next time that this stream is read from.  Return
+	  * false (and set the stream's failbit) if there are no more lines. */
+	bool getLineView(const wchar_t *&line, size_t &length);
 
 	virtual UTF8InputStream& getLine(wchar_t* str, int size){
 		this->getline( str, size );
@@ -98,6 +108,12 @@ public:
 	  * double the delay for each subsequent retry. */
 	static void setOpenFileRetries(size_t n);
 
+	/** Set a static variable that tells UTF8InputStream whether to read files
+	  * that it opens from now on through a UTF8FileBuffer (the default), or
+	  * through std::wifstream's file buffer and the utf8 codecvt facet.
+	  * This is controlled by the use_utf8_file_buffer parameter. */
+	static void setUseFileBuffer(bool use);
+
 	// Make these methods virtual (at least if they're accessed via
 	// UTF8InputStream, and not one of its bases):
 	virtual bool is_open();
@@ -125,6 +141,15 @@ protected:
 private:
 	static boost::shared_ptr<Factory> &_factory();
 	static size_t _openFileRetries;
+	static bool _useFileBuffer;
+
+	boost::scoped_ptr<UTF8FileBuffer> _fileBuffer;
+	std::wstring _lineBuffer;
+
+	// Open the file (using a UTF8FileBuffer if _useFileBuffer is true),
+	// and return true if it was opened successfully.
+	bool openFile(const char * file);
+	bool usingFileBuffer() const;
 };
 
 
@@ -15,60 +15,65 @@ using namespace std;
 const size_t UTF8Token::buffer_size = UTF8_TOKEN_BUFFER_SIZE;
 
 // If you change this function for any reason, please also change Sexp::getNextTokenIncludingComments(), as it does a very similar thing.
+//
+// Most models are loaded with this function, so it reads characters directly from the
+// stream's buffer (rather than with stream.get(), which has to construct a sentry for every
+// character), and sets the stream's state the same way that stream.get() would have.
 std::wistream& operator>>(std::wistream& stream, UTF8Token& token)
         throw(UnexpectedInputException)
 {
     // we are reading a new token so Symbol has to be recreated now.
 	token.symbol_is_valid = false;
+	token.buffer[0] = L'\0';
 
-	wchar_t wch;
-	wch = stream.get();
-	if (stream.eof()) {
-		wchar_t* p = token.buffer;
-		*p = L'\0';
+	std::wistream::sentry ok(stream, true);
+	if (!ok)
 		return stream;
-	}
-	if (wch == 0x00) 
-		throw UnexpectedInputException("UTF8Token::operator>>",
-			"Unexpected NULL (0x00) character in stream");
-	while (iswspace(wch)) {
-		wch = stream.get();
-		if (stream.eof()) {
-			wchar_t* p = token.buffer;
-			*p = L'\0';
-			return stream;    
+	std::wstreambuf* buf = stream.rdbuf();
+	const std::wstreambuf::int_type eof = std::wstreambuf::traits_type::eof();
+	try {
+		std::wstreambuf::int_type wch = buf->sbumpc();
+		while (wch != eof && iswspace(static_cast<wint_t>(wch)))
+			wch = buf->sbumpc();
+		if (wch == eof) {
+			stream.setstate(std::ios::eofbit | std::ios::failbit);
+			return stream;
 		}
 		if (wch == 0x00) 
 			throw UnexpectedInputException("UTF8Token::operator>>",
 				"Unexpected NULL (0x00) character in stream");
-	}
-    wchar_t* p = token.buffer;
-    *p++ = wch;
-    if ((wch == L'(') || (wch == L')')) {
-        *p = L'\0';
-        return stream;
-    }
-    size_t i = 1;	
-	wch = stream.get();
-    while (stream.good() && !iswspace(wch) && wch != L'(' && wch != L')') {
-        if (i < (token.buffer_size - 1)) {
-            *p++ = wch;
-            i++;
-        } else {
-			if (*p != L'\0') {
-				*p = L'\0';
-				cerr << "Token too long ("
-					<< (int) i << "/" << (int) token.buffer_size << "): "
-					<< OutputUtil::convertToChar(token.buffer) << "\n";
+		wchar_t* p = token.buffer;
+		*p++ = static_cast<wchar_t>(wch);
+		if ((wch == L'(') || (wch == L')')) {
+			*p = L'\0';
+			return stream;
+		}
+		size_t i = 1;	
+		wch = buf->sbumpc();
+		while (wch != eof && !iswspace(static_cast<wint_t>(wch)) && wch != L'(' && wch != L')') {
+			if (i < (token.buffer_size - 1)) {
+				*p++ = static_cast<wchar_t>(wch);
+				i++;
+			} else {
+				if (*p != L'\0') {
+					*p = L'\0';
+					cerr << "Token too long ("
+						<< (int) i << "/" << (int) token.buffer_size << "): "
+						<< OutputUtil::convertToChar(token.buffer) << "\n";
+				}
+				//throw UnexpectedInputException("UTF8Token::operator>>()", "token too long");
 			}
-			//throw UnexpectedInputException("UTF8Token::operator>>()", "token too long");
-        }
-		wch = stream.get();
-    }
-    *p = L'\0';
-    if (!stream.eof() && (wch == L'(' || wch == L')')) {
-        stream.putback(wch);
-    }
+			wch = buf->sbumpc();
+		}
+		*p = L'\0';
+		if (wch == eof)
+			stream.setstate(std::ios::eofbit | std::ios::failbit);
+		else if (wch == L'(' || wch == L')')
+			buf->sungetc();
+	} catch (std::ios_base::failure &) {
+		// The stream buffer could not decode the input.
+		stream.setstate(std::ios::badbit);
+	}
     return stream;
 }
 
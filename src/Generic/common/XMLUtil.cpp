@@ -22,11 +22,13 @@
 #include <xercesc/framework/MemBufInputSource.hpp>
 #include <xercesc/framework/MemBufFormatTarget.hpp>
 #include <xercesc/util/BinInputStream.hpp>
+#include <xercesc/util/XMLString.hpp>
 #include <sstream>
 #include <fstream>
 #include <vector>
 #include <boost/foreach.hpp>
 #include <boost/scoped_array.hpp>
+#include <boost/scoped_ptr.hpp>
 
 using namespace xercesc;
 using namespace SerifXML;
@@ -154,9 +156,50 @@ namespace {
 		{ return new WIStreamBinInputStream(_in); }
 	};
 
-	xercesc::DOMDocument* loadXercesDOMFromInputSource(InputSource &src) {
+	/** A DOM parser that discards whitespace-only text nodes from each
+	  * element that also contains child elements, as soon as the element
+	  * has been parsed.  The discarded nodes are released back to the
+	  * DOMDocument, which reuses their memory for the nodes that follow,
+	  * so the indentation in pretty-printed XML never accumulates in the
+	  * DOM. */
+	class CompactDOMParser : public XercesDOMParser {
+	public:
+		void endElement(const XMLElementDecl& elemDecl, const unsigned int urlId,
+						const bool isRoot, const XMLCh* const elemPrefix)
+		{
+			XercesDOMParser::endElement(elemDecl, urlId, isRoot, elemPrefix);
+			// The current node is now the element that just ended.
+			DOMNode *elem = getCurrentNode();
+			if (elem == 0 || elem->getNodeType() != DOMNode::ELEMENT_NODE)
+				return;
+			bool has_child_elements = false;
+			for (DOMNode *child = elem->getFirstChild(); child != 0; child = child->getNextSibling()) {
+				if (child->getNodeType() == DOMNode::ELEMENT_NODE) {
+					has_child_elements = true;
+					break;
+				}
+			}
+			if (!has_child_elements)
+				return;
+			DOMNode *child = elem->getFirstChild();
+			while (child != 0) {
+				DOMNode *next = child->getNextSibling();
+				if (child->getNodeType() == DOMNode::TEXT_NODE && 
+					XMLString::isAllWhiteSpace(child->getNodeValue()))
+				{
+					elem->removeChild(child)->release();
+				}
+				child = next;
+			}
+		}
+	};
+
+	xercesc::DOMDocument* loadXercesDOMFromInputSource(InputSource &src, bool compact=false) {
 		DOMImplementation* impl = DOMImplementationRegistry::getDOMImplementation(X_Core);
-		XercesDOMParser parser;
+		boost::scoped_ptr<XercesDOMParser> parserPtr(compact ? _new CompactDOMParser() : _new XercesDOMParser());
+		XercesDOMParser &parser = *parserPtr;
+		if (compact)
+			parser.setCreateCommentNodes(false);
 		SerifXMLErrorHandler errorHandler;
 		parser.setErrorHandler(&errorHandler);
 
@@ -237,13 +280,13 @@ namespace {
 
 }
 
-xercesc::DOMDocument* XMLUtil::loadXercesDOMFromFilename(const char* filename) {
+xercesc::DOMDocument* XMLUtil::loadXercesDOMFromFilename(const char* filename, bool compact) {
 	if (Decompressor::canDecompress(filename)) {
 		size_t size;
 		boost::scoped_array<unsigned char> mem(
 				Decompressor::decompressIntoMemory(filename, size));
 		try {
-			return loadXercesDOMFromString((const char*)mem.get(), size);
+			return loadXercesDOMFromString((const char*)mem.get(), size, compact);
 		} catch (UnexpectedInputException &exc) {
 			std::ostringstream prefix;
 			prefix << "In " << filename << ": ";
@@ -258,7 +301,7 @@ xercesc::DOMDocument* XMLUtil::loadXercesDOMFromFilename(const char* filename) {
 			throw UnexpectedInputException( "XMLUtil::loadXercesDOMFromFilename()", errmsg.str().c_str() );
 		}
 		try {
-			return loadXercesDOMFromStream(stream);
+			return loadXercesDOMFromStream(stream, compact);
 		} catch (UnexpectedInputException &exc) {
 			std::ostringstream prefix;
 			prefix << "In " << filename << ": ";
@@ -268,9 +311,9 @@ xercesc::DOMDocument* XMLUtil::loadXercesDOMFromFilename(const char* filename) {
 	}
 }
 
-xercesc::DOMDocument* XMLUtil::loadXercesDOMFromStream(std::istream &stream) {
+xercesc::DOMDocument* XMLUtil::loadXercesDOMFromStream(std::istream &stream, bool compact) {
 	IStreamInputSource src(stream);
-	return loadXercesDOMFromInputSource(src);
+	return loadXercesDOMFromInputSource(src, compact);
 }
 
 xercesc::DOMDocument* XMLUtil::loadXercesDOMFromStream(std::wistream &stream) {
@@ -278,16 +321,16 @@ xercesc::DOMDocument* XMLUtil::loadXercesDOMFromStream(std::wistream &stream) {
 	return loadXercesDOMFromInputSource(src);
 }
 
-xercesc::DOMDocument* XMLUtil::loadXercesDOMFromString(const char* xml_string, size_t length) {
+xercesc::DOMDocument* XMLUtil::loadXercesDOMFromString(const char* xml_string, size_t length, bool compact) {
 	if (!length)
 		length = strlen(xml_string);
 	MemBufInputSource src((const XMLByte*)(xml_string), length, "SerifXMLRequest");
-	return loadXercesDOMFromInputSource(src);
+	return loadXercesDOMFromInputSource(src, compact);
 }
 
-xercesc::DOMDocument* XMLUtil::loadXercesDOMFromFilename(const wchar_t* filename) {
+xercesc::DOMDocument* XMLUtil::loadXercesDOMFromFilename(const wchar_t* filename, bool compact) {
 	std::string filename_bytes = UnicodeUtil::toUTF8StdString(filename);
-	return loadXercesDOMFromFilename(filename_bytes.c_str());
+	return loadXercesDOMFromFilename(filename_bytes.c_str(), compact);
 }
 
 xercesc::DOMDocument* XMLUtil::loadXercesDOMFromString(const wchar_t* xml_string) {
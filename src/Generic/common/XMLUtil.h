@@ -22,17 +22,23 @@ public:
 	* the returned DOMDocument, which must be done using 
 	* DOMDocument::release().  If a parsing error is encountered, then
 	* raise an UnexpectedInputException with details about where the 
-	* error occured. */
-	static xercesc::DOMDocument* loadXercesDOMFromFilename(const char* filename); 
-	static xercesc::DOMDocument* loadXercesDOMFromFilename(const wchar_t* filename); 
+	* error occured. 
+	*
+	* If compact is true, then comments and whitespace-only text nodes
+	* in elements that also contain child elements (i.e., indentation)
+	* are discarded as the XML is parsed.  For indented XML, that is
+	* about one text node per element, none of which SerifXML uses;
+	* the elements and their attributes are all still kept. */
+	static xercesc::DOMDocument* loadXercesDOMFromFilename(const char* filename, bool compact=false); 
+	static xercesc::DOMDocument* loadXercesDOMFromFilename(const wchar_t* filename, bool compact=false); 
 
 	/** Parse the XML in the given stream, and return a xerces 
 	* DOMDocument for its contents.  The caller is responsible for 
 	* disposing of the returned DOMDocument, which must be done using 
 	* DOMDocument::release().  If a parsing error is encountered, 
 	* then raise an UnexpectedInputException with details about where 
-	* the error occured. */
-	static xercesc::DOMDocument* loadXercesDOMFromStream(std::istream& stream); 
+	* the error occured.  (See loadXercesDOMFromFilename() for compact.) */
+	static xercesc::DOMDocument* loadXercesDOMFromStream(std::istream& stream, bool compact=false); 
 	static xercesc::DOMDocument* loadXercesDOMFromStream(std::wistream& stream); 
 
 	/** Parse the XML in the given string, and return a xerces 
@@ -43,8 +49,9 @@ public:
 	* error occured.
 	*
 	* If length is not specified, then it will be determined using
-	* strlen (byte-string version only). */
-	static xercesc::DOMDocument* loadXercesDOMFromString(const char* xml_string, size_t length=0);
+	* strlen (byte-string version only).  (See loadXercesDOMFromFilename() 
+	* for compact.) */
+	static xercesc::DOMDocument* loadXercesDOMFromString(const char* xml_string, size_t length=0, bool compact=false);
 	static xercesc::DOMDocument* loadXercesDOMFromString(const wchar_t* xml_string);
     
     /** Convenience method to save the XML contents of the given DOM node to the specified target. */
@@ -9,7 +9,8 @@
 using namespace std;
 
 
-BlockFeatureTable::BlockFeatureTable(DTTagSet *tagSet) : _tagSet(tagSet) {
+BlockFeatureTable::BlockFeatureTable(DTTagSet *tagSet) 
+: _tagSet(tagSet), _n_weights(0), _frozen(false), _keyIndexMask(0) {
 	_table = _new FeatureBlockTable(500009);
 }
 
@@ -17,8 +18,7 @@ BlockFeatureTable::~BlockFeatureTable() {
 	if (_table != 0) {
 		FeatureBlockTable::iterator iter = _table->begin();
 		while (iter != _table->end()) {
-			DTFeatureBlock *block = (*iter).second;
-			delete block;
+			(*iter).second.deleteWeights();
 			++iter;
 		}
 		delete _table;
@@ -26,77 +26,144 @@ BlockFeatureTable::~BlockFeatureTable() {
 }
 
 bool BlockFeatureTable::insert(DTFeature *feature, double weight) {
+	if (_frozen)
+		throw InternalInconsistencyException("BlockFeatureTable::insert()", 
+			"Attempt to insert a weight into a frozen BlockFeatureTable");
+
 	FeatureBlockTable::iterator entryIter = _table->find(feature);
 
 	if (entryIter == _table->end()) {
-		DTFeatureBlock *entry = _new DTFeatureBlock();
-		Symbol tag = feature->getTag();
-		int tag_index = _tagSet->getTagIndex(tag);
-		if (tag_index == -1) {
-			for (int j = 0; j < _tagSet->getNTags(); j++) {	
-				if (tag == _tagSet->getReducedTagSymbol(j) ||
-					tag == _tagSet->getSemiReducedTagSymbol(j))
-				{
-					tag_index = j;
-					entry->set(tag_index, weight);
-				}
-			}
-			if (tag_index == -1) {
-				string msg = "Could not find a corresponding tag index for ";
-				msg.append(tag.to_debug_string());
-				throw InternalInconsistencyException("BlockFeatureTable::insert()", msg.c_str());
-			}
-		}
-		else {
-			entry->set(tag_index, weight);
+		DTFeatureBlock entry;
+		try {
+			setWeight(entry, feature->getTag(), weight);
+		} catch (...) {
+			// Only the new entry is freed; an existing entry keeps its weights.
+			entry.deleteWeights();
+			throw;
 		}
 		(*_table)[feature] = entry;
 		return true;
 	}
 	else {
-		DTFeatureBlock* entry = (*entryIter).second;
-		Symbol tag = feature->getTag();
-		int tag_index = _tagSet->getTagIndex(tag);
-		if (tag_index == -1) {
-			for (int j = 0; j < _tagSet->getNTags(); j++) {	
-				if (tag == _tagSet->getReducedTagSymbol(j) ||
-					tag == _tagSet->getSemiReducedTagSymbol(j))
-				{
-					tag_index = j;
-					entry->set(tag_index, weight);
-				}
-			}
-			if (tag_index == -1) {
-				string msg = "Could not find a corresponding tag index for ";
-				msg.append(tag.to_debug_string());
-				throw InternalInconsistencyException("BlockFeatureTable::insert()", msg.c_str());
+		setWeight((*entryIter).second, feature->getTag(), weight);
+		return false;
+	}
+}
+
+void BlockFeatureTable::setWeight(DTFeatureBlock &entry, Symbol tag, double weight) {
+	int tag_index = _tagSet->getTagIndex(tag);
+	if (tag_index == -1) {
+		for (int j = 0; j < _tagSet->getNTags(); j++) {	
+			if (tag == _tagSet->getReducedTagSymbol(j) ||
+				tag == _tagSet->getSemiReducedTagSymbol(j))
+			{
+				tag_index = j;
+				entry.set(tag_index, weight);
+				++_n_weights;
 			}
 		}
-		else {
-			entry->set(tag_index, weight);
+		if (tag_index == -1) {
+			string msg = "Could not find a corresponding tag index for ";
+			msg.append(tag.to_debug_string());
+			throw InternalInconsistencyException("BlockFeatureTable::insert()", msg.c_str());
 		}
-		return false;
+	}
+	else {
+		entry.set(tag_index, weight);
+		++_n_weights;
 	}
 }
 
-/* Note: parray must be at least _tagSet->getNTags() entries long */
-// void BlockFeatureTable::load(DTFeature *feature, PWeight *parray) {
-// 	for (int i = 0; i < _tagSet->getNTags(); i++) {
-// 	    //parray[i] = PWeight(0);
-// 	    parray[i].resetToZero();
-// 	}
-// 	FeatureBlockTable::iterator entryIter = _table->find(feature);
-// 	if (entryIter != _table->end()) {
-// 		DTFeatureBlock* entry = (*entryIter).second;
-// 		entry->load(parray);
-// 	}
-// }
+void BlockFeatureTable::freeze() {
+	if (_frozen) return;
+	_arena.clear();
+	_arena.reserve(_n_weights);
+	for (FeatureBlockTable::iterator iter = _table->begin(); iter != _table->end(); ++iter) {
+		DTFeatureBlock &entry = (*iter).second;
+		// Keep the entries in the same order as the linked list, so load()
+		// gives the same result even if a (feature, tag) pair was repeated.
+		entry._start = _arena.size();
+		for (WeightBlock *w = entry._weights; w != 0; w = w->next) {
+			WeightEntry e;
+			e.weight = w->weight;
+			e.tag_index = w->tag_index;
+			_arena.push_back(e);
+		}
+		entry._length = _arena.size() - entry._start;
+		entry.deleteWeights();
+	}
+	buildKeyIndex();
+	_frozen = true;
+}
+
+void BlockFeatureTable::buildKeyIndex() {
+	size_t n_slots = 16;
+	while (n_slots < 2 * _table->size())
+		n_slots *= 2;
+	KeySlot emptySlot;
+	emptySlot.featureType = 0;
+	emptySlot.hash = 0;
+	emptySlot.key_start = 0;
+	emptySlot.n_words = 0;
+	_keyIndex.assign(n_slots, emptySlot);
+	_keyIndexMask = n_slots - 1;
+	_keyWords.clear();
+
+	DTFeatureKey key;
+	for (FeatureBlockTable::iterator iter = _table->begin(); iter != _table->end(); ++iter) {
+		// Features that can't be represented by a key are only reachable
+		// through _table.
+		if (!(*iter).first->getKeyWithoutTag(key))
+			continue;
+		size_t hash = key.getHashCode();
+		size_t i = hash & _keyIndexMask;
+		while (_keyIndex[i].featureType != 0)
+			i = (i + 1) & _keyIndexMask;
+		KeySlot &slot = _keyIndex[i];
+		slot.featureType = key.getFeatureType();
+		slot.hash = hash;
+		slot.key_start = _keyWords.size();
+		slot.n_words = key.getNWords();
+		slot.block = (*iter).second;
+		_keyWords.insert(_keyWords.end(), key.getWords(), key.getWords() + key.getNWords());
+	}
+}
+
+const BlockFeatureTable::KeySlot *BlockFeatureTable::findKey(const DTFeatureKey &key) const {
+	size_t hash = key.getHashCode();
+	const size_t *words = key.getWords();
+	for (size_t i = hash & _keyIndexMask; _keyIndex[i].featureType != 0; i = (i + 1) & _keyIndexMask) {
+		const KeySlot &slot = _keyIndex[i];
+		if (slot.hash != hash || slot.featureType != key.getFeatureType() || slot.n_words != key.getNWords())
+			continue;
+		const size_t *slotWords = slot.n_words ? &_keyWords[slot.key_start] : 0;
+		int j = 0;
+		while (j < slot.n_words && slotWords[j] == words[j])
+			++j;
+		if (j == slot.n_words)
+			return &slot;
+	}
+	return 0;
+}
 
 void BlockFeatureTable::load(DTFeature *feature, double *parray) {
 	memset(parray, 0, _tagSet->getNTags()*sizeof(double));
 	FeatureBlockTable::iterator entryIter = _table->find(feature);
 	if (entryIter != _table->end()) {
-		DTFeatureBlock* entry = (*entryIter).second;
-		entry->load(parray);
+		(*entryIter).second.load(parray, _arena.empty() ? 0 : &_arena[0]);
 	}
 }
+
+void BlockFeatureTable::load(const DTFeatureKey &key, double *parray) {
+	if (key.getFeature() != 0) {
+		load(const_cast<DTFeature*>(key.getFeature()), parray);
+		return;
+	}
+	if (!_frozen)
+		throw InternalInconsistencyException("BlockFeatureTable::load()", 
+			"Attempt to look up a feature key in a BlockFeatureTable that is not frozen");
+	memset(parray, 0, _tagSet->getNTags()*sizeof(double));
+	const KeySlot *slot = findKey(key);
+	if (slot != 0)
+		slot->block.load(parray, &_arena[0]);
+}
@@ -8,30 +8,48 @@
 #include "Generic/common/InternalInconsistencyException.h"
 #include "Generic/discTagger/DTTagSet.h"
 #include "Generic/discTagger/DTFeature.h"
-//#include "Generic/discTagger/PWeight.h"
-
+#include "Generic/discTagger/DTFeatureKey.h"
+#include <vector>
+
+/** A table mapping each feature (ignoring its tag) to the weights that
+  * the feature has for each tag.
+  *
+  * While a model is being read, the weights for each feature are kept in
+  * a linked list of WeightBlocks.  Once the model has been read, freeze()
+  * copies all of the weights into a single contiguous array of 
+  * (tag_index, weight) entries, where each feature owns one run of 
+  * consecutive entries; this avoids chasing pointers through the heap 
+  * for every feature lookup during decoding.  No weights may be inserted
+  * after the table is frozen.
+  *
+  * freeze() also builds a flat open-addressing index from DTFeatureKeys
+  * to weight runs, so that decoders can look up weights by key without
+  * building DTFeatures or calling their virtual hash and equality
+  * methods. */
 class BlockFeatureTable {
 private:
-	class DTFeatureBlock {
-	public:
+	struct WeightBlock {
+		double weight;
+		int tag_index;
+		WeightBlock *next;
+	};
 
-		struct WeightBlock {
-			double weight;
-			int tag_index;
-			WeightBlock *next;
-		};
+	struct WeightEntry {
+		double weight;
+		int tag_index;
+	};
 
+	/** The weights for a single feature.  Before the table is frozen, they
+	  * are stored in the linked list _weights; afterwards, they are stored in
+	  * _arena[_start] ... _arena[_start+_length-1], and _weights is NULL. 
+	  * The memory for _weights is owned by the BlockFeatureTable. */
+	class DTFeatureBlock {
+	public:
 		WeightBlock *_weights;
+		size_t _start;
+		size_t _length;
 	
-		DTFeatureBlock() : _weights(0) {}; 
-
-		~DTFeatureBlock() { 
-			while (_weights != 0) {
-				WeightBlock *head = _weights;
-				_weights = head->next;
-				delete head;
-			}
-		}
+		DTFeatureBlock() : _weights(0), _start(0), _length(0) {}; 
 
 		void set(int index, double value) {
 			// let's just assume there won't be any duplicates for now...
@@ -40,21 +58,25 @@ private:
 			w->tag_index = index;
 			w->next = _weights;
 			_weights = w;
+			++_length;
 		}
 
-		// void load(PWeight *parray) {
-		// 	WeightBlock *iter = _weights;
-		// 	while (iter != 0) {
-		// 		parray[iter->tag_index] = *(iter->weight);
-		// 		iter = iter->next;
-		// 	}
-		// }
-
-		void load(double *parray) {
-			WeightBlock *iter = _weights;
-			while (iter != 0) {
-				parray[iter->tag_index] = iter->weight;
-				iter = iter->next;
+		void deleteWeights() {
+			while (_weights != 0) {
+				WeightBlock *head = _weights;
+				_weights = head->next;
+				delete head;
+			}
+		}
+
+		void load(double *parray, const WeightEntry *arena) const {
+			if (_weights == 0) {
+				const WeightEntry *end = arena + _start + _length;
+				for (const WeightEntry *iter = arena + _start; iter != end; ++iter)
+					parray[iter->tag_index] = iter->weight;
+			} else {
+				for (WeightBlock *iter = _weights; iter != 0; iter = iter->next)
+					parray[iter->tag_index] = iter->weight;
 			}
 		}
 	 };
@@ -72,7 +94,7 @@ private:
         }
 	};
 
-	typedef serif::hash_map<DTFeature*, DTFeatureBlock*, FeatureBlockHash, FeatureBlockEquality> FeatureBlockTable;
+	typedef serif::hash_map<DTFeature*, DTFeatureBlock, FeatureBlockHash, FeatureBlockEquality> FeatureBlockTable;
 
 	FeatureBlockTable *_table;
 
@@ -81,11 +103,44 @@ public:
 	~BlockFeatureTable();
 
 	bool insert(DTFeature *feature, double weight);
-	//void load(DTFeature *feature, PWeight *parray);
 	void load(DTFeature *feature, double *parray);
 
+	/** Load the weights for the feature with the given key.  Keys that do
+	  * not hold a DTFeature may only be used once the table is frozen. */
+	void load(const DTFeatureKey &key, double *parray);
+
+	/** Move all weights into a single contiguous array.  This should be 
+	  * called once all weights have been inserted (DTFeature::readWeights()
+	  * does so automatically). */
+	void freeze();
+	bool isFrozen() const { return _frozen; }
+
+	/** Return the total number of (feature, tag) weights in this table. */
+	size_t getNWeights() const { return _n_weights; }
+
 private:
 	DTTagSet *_tagSet;
+	std::vector<WeightEntry> _arena;
+	size_t _n_weights;
+	bool _frozen;
+
+	/** One slot of the key index.  The words of the slot's key are stored
+	  * in _keyWords[key_start] ... _keyWords[key_start+n_words-1]; empty
+	  * slots have a NULL featureType. */
+	struct KeySlot {
+		const DTFeatureType *featureType;
+		size_t hash;
+		size_t key_start;
+		int n_words;
+		DTFeatureBlock block;
+	};
+	std::vector<KeySlot> _keyIndex;
+	std::vector<size_t> _keyWords;
+	size_t _keyIndexMask;
+
+	void setWeight(DTFeatureBlock &entry, Symbol tag, double weight);
+	void buildKeyIndex();
+	const KeySlot *findKey(const DTFeatureKey &key) const;
 };
 
 #endif
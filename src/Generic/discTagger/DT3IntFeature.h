@@ -11,6 +11,7 @@
 #include "Generic/discTagger/DTFeatureType.h"
 
 #include "Generic/discTagger/DTFeature.h"
+#include "Generic/discTagger/DTFeatureKey.h"
 
 #ifdef _WIN32
 #define swprintf _snwprintf
@@ -69,6 +70,11 @@ public:
 		// non-negative)
 	}
 
+	bool getKeyWithoutTag(DTFeatureKey &key) const {
+		key.reset(getFeatureType()).add(_int1).add(_int2).add(_int3);
+		return true;
+	}
+
 	void toString(wstring &str) const {
 		wchar_t buf[100];
 		swprintf(buf, 100, L"%d %d %d", _int1, _int2, _int3);
@@ -12,6 +12,7 @@
 #include "Generic/discTagger/DTFeatureType.h"
 
 #include "Generic/discTagger/DTFeature.h"
+#include "Generic/discTagger/DTFeatureKey.h"
 
 using namespace std;
 
@@ -79,6 +80,16 @@ public:
 			    ^ _symbol4.hash_code() ^ _symbol5.hash_code() ^ _symbol6.hash_code();
 	}
 
+	bool getKeyWithoutTag(DTFeatureKey &key) const {
+		key.reset(getFeatureType())
+		   .add(_symbol2)
+		   .add(_symbol3)
+		   .add(_symbol4)
+		   .add(_symbol5)
+		   .add(_symbol6);
+		return true;
+	}
+
 
 	void toString(wstring &str) const {
 		str = _symbol1.to_string();
@@ -12,6 +12,7 @@
 #include "Generic/discTagger/DTFeatureType.h"
 
 #include "Generic/discTagger/DTFeature.h"
+#include "Generic/discTagger/DTFeatureKey.h"
 
 #ifdef _WIN32
 	#define swprintf _snwprintf
@@ -76,6 +77,11 @@ public:
 			   ^ ((unsigned) _int1 << 3) ^ ((unsigned) _int2 << 3);
 	}
 
+	bool getKeyWithoutTag(DTFeatureKey &key) const {
+		key.reset(getFeatureType()).add(_symbol2).add(_int1).add(_int2);
+		return true;
+	}
+
 	void toString(wstring &str) const {
 		wchar_t buf[100];
 		swprintf(buf, 100, L"%d %d", _int1, _int2);
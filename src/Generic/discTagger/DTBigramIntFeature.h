@@ -13,6 +13,7 @@
 #include "Generic/discTagger/DTFeatureType.h"
 
 #include "Generic/discTagger/DTFeature.h"
+#include "Generic/discTagger/DTFeatureKey.h"
 
 #ifdef _WIN32
 	#define swprintf _snwprintf
@@ -78,6 +79,11 @@ public:
 		// non-negative)
 	}
 
+	bool getKeyWithoutTag(DTFeatureKey &key) const {
+		key.reset(getFeatureType()).add(_symbol2).add(_integer);
+		return true;
+	}
+
 	void toString(wstring &str) const {
 		str = _symbol1.to_string();
 		str += L" ";
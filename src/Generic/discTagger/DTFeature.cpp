@@ -311,6 +311,9 @@ void DTFeature::readWeights(BlockFeatureTable &weightTable,
 	}
 
 	in.close();
+	// Freezing can be turned off to compare against the linked-list tables.
+	if (ParamReader::getOptionalTrueFalseParamWithDefaultVal("freeze_block_feature_tables", true))
+		weightTable.freeze();
 
 	if (nweights == 0) {
 		char message[1000];
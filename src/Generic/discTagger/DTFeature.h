@@ -11,11 +11,18 @@
 #include "Generic/common/UTF8Token.h"
 #include "Generic/discTagger/PWeight.h"
 #include "Generic/discTagger/DTFeatureType.h"
+#include "dynamic_includes/common/SymbolDefinitions.h"
 
 class UTF8OutputStream;
 class BlockFeatureTable;
+class DTFeatureKey;
 
-#define ALLOCATION_POOLING // turn on pooling (for subclasses)
+// Turn on pooling (for subclasses).  The pools are static and unlocked,
+// so pooling is turned off when Serif is built to be thread-safe (names
+// may be decoded in several threads at once).
+#ifndef SYMBOL_THREADSAFE
+#define ALLOCATION_POOLING
+#endif
 
 
 /** DTFeature is an abstract class. Instances of its subclasses represent
@@ -49,6 +56,12 @@ public:
 	virtual bool equalsWithoutTag(const DTFeature &other) const = 0;
 	virtual size_t getHashCodeWithoutTag() const = 0;
 
+	/** Populate key with a compact representation of this feature that
+	  * ignores its tag (see DTFeatureKey), and return true; or return false
+	  * if this feature can not be represented that way.  Two features must
+	  * have equal keys if and only if equalsWithoutTag() is true. */
+	virtual bool getKeyWithoutTag(DTFeatureKey &key) const { return false; }
+
 	virtual void toString(std::wstring &str) const = 0;
 
 	virtual void toStringWithoutTag(std::wstring &str) const = 0;
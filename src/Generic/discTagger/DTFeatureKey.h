@@ -0,0 +1,90 @@
+// Copyright (c) 2012 by Raytheon BBN Technologies Corp.
+// All Rights Reserved.
+
+#ifndef D_T_FEATURE_KEY_H
+#define D_T_FEATURE_KEY_H
+
+#include "Generic/common/Symbol.h"
+#include "Generic/discTagger/DTFeature.h"
+
+/** A DTFeatureKey is a compact, tag-independent representation of a
+  * DTFeature, used to look up feature weights in a BlockFeatureTable
+  * while decoding without allocating a DTFeature.
+  *
+  * A key consists of the feature type plus up to MAX_WORDS machine words,
+  * each holding one of the feature's non-tag values (a Symbol identifier
+  * or an int).  Two keys are equal if and only if the corresponding
+  * features are equal according to DTFeature::equalsWithoutTag(), so
+  * lookups by key give exactly the same weights as lookups by feature.
+  *
+  * Features whose values can not be packed into a key (e.g., features
+  * that contain strings) are represented by a "fallback" key, which just
+  * holds a pointer to the DTFeature itself.  Whoever extracted the key is
+  * responsible for calling releaseFeature() once it is no longer needed.
+  */
+class DTFeatureKey {
+public:
+	static const int MAX_WORDS = 8;
+
+	DTFeatureKey() : _featureType(0), _n_words(0), _feature(0) {}
+
+	/** Clear this key, and set its feature type. */
+	DTFeatureKey &reset(const DTFeatureType *featureType) {
+		_featureType = featureType;
+		_n_words = 0;
+		_feature = 0;
+		return *this;
+	}
+
+	DTFeatureKey &add(const Symbol &sym) {
+		_words[_n_words++] = sym.identifier();
+		return *this;
+	}
+
+	DTFeatureKey &add(int value) {
+		_words[_n_words++] = static_cast<size_t>(value);
+		return *this;
+	}
+
+	/** Turn this into a fallback key for the given feature.  The key
+	  * takes ownership of the feature. */
+	void setFeature(DTFeature *feature) {
+		_featureType = feature->getFeatureType();
+		_n_words = 0;
+		_feature = feature;
+	}
+
+	/** Deallocate this key's feature, if it is a fallback key. */
+	void releaseFeature() {
+		if (_feature != 0) {
+			_feature->deallocate();
+			_feature = 0;
+		}
+	}
+
+	/** Return the feature for a fallback key, or NULL otherwise. */
+	const DTFeature *getFeature() const { return _feature; }
+
+	const DTFeatureType *getFeatureType() const { return _featureType; }
+	int getNWords() const { return _n_words; }
+	const size_t *getWords() const { return _words; }
+
+	size_t getHashCode() const {
+		return getHashCode(_featureType, _words, _n_words);
+	}
+
+	static size_t getHashCode(const DTFeatureType *featureType, const size_t *words, int n_words) {
+		size_t hash = reinterpret_cast<size_t>(featureType);
+		for (int i = 0; i < n_words; i++)
+			hash ^= words[i] + 0x9e3779b9 + (hash << 6) + (hash >> 2);
+		return hash;
+	}
+
+private:
+	const DTFeatureType *_featureType;
+	int _n_words;
+	size_t _words[MAX_WORDS];
+	DTFeature *_feature;
+};
+
+#endif
@@ -4,6 +4,22 @@
 #include "Generic/common/leak_detection.h" // This must be the first #include
 
 #include "Generic/discTagger/DTFeatureType.h"
+#include "Generic/discTagger/DTFeature.h"
+#include "Generic/discTagger/DTFeatureKey.h"
 
 
 DTFeatureType::FeatureTypeMap DTFeatureType::_featureTypes;
+
+int DTFeatureType::extractFeatureKeys(const DTState &state,
+									  DTFeatureKey *resultArray) const
+{
+	DTFeature *featureArray[MAX_FEATURES_PER_EXTRACTION];
+	int n_features = extractFeatures(state, featureArray);
+	for (int i = 0; i < n_features; i++) {
+		if (featureArray[i]->getKeyWithoutTag(resultArray[i]))
+			featureArray[i]->deallocate();
+		else
+			resultArray[i].setFeature(featureArray[i]);
+	}
+	return n_features;
+}
@@ -10,6 +10,7 @@
 
 class DTState;
 class DTFeature;
+class DTFeatureKey;
 
 /** DTFeatureType is an abstract class whose subclasses each represent
   * types of DTFeatures, and are able to extract that feature type, write
@@ -96,6 +97,18 @@ public:
 	virtual int extractFeatures(const DTState &state,
 								DTFeature **resultArray) const = 0;
 
+	/** Extract the keys of the features that extractFeatures() would
+	  * extract from the tagger state, ignoring their tags (see
+	  * DTFeatureKey).  This is used by PDecoder to look up weights without
+	  * building any DTFeatures.  The default implementation just calls
+	  * extractFeatures() and converts each feature to a key; subclasses
+	  * that are used heavily in decoding may override it to fill in the
+	  * keys directly.
+	  *
+	  * The caller must call releaseFeature() on each returned key. */
+	virtual int extractFeatureKeys(const DTState &state,
+								   DTFeatureKey *resultArray) const;
+
 	static void registerFeatureType(Symbol model, DTFeatureType *featureType) {
 		// XXX: Should make sure it's not already there
 		Symbol fullname = getFullName(model, featureType->getName());
@@ -11,6 +11,7 @@
 #include "Generic/discTagger/DTFeatureType.h"
 
 #include "Generic/discTagger/DTFeature.h"
+#include "Generic/discTagger/DTFeatureKey.h"
 
 #ifdef _WIN32
 #define swprintf _snwprintf
@@ -61,6 +62,11 @@ public:
 		// non-negative)
 	}
 
+	bool getKeyWithoutTag(DTFeatureKey &key) const {
+		key.reset(getFeatureType()).add(_integer);
+		return true;
+	}
+
 	void toString(wstring &str) const {
 		wchar_t buf[100];
 		swprintf(buf, 100, L"%d", _integer);
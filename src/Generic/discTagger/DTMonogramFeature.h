@@ -12,6 +12,7 @@
 #include "Generic/discTagger/DTFeatureType.h"
 
 #include "Generic/discTagger/DTFeature.h"
+#include "Generic/discTagger/DTFeatureKey.h"
 
 using namespace std;
 
@@ -62,6 +63,11 @@ public:
 		return featureName.hash_code();
 	}
 
+	bool getKeyWithoutTag(DTFeatureKey &key) const {
+		key.reset(getFeatureType());
+		return true;
+	}
+
 	void toString(wstring &str) const {
 		str = _symbol1.to_string();
 	}
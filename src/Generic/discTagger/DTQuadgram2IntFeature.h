@@ -12,6 +12,7 @@
 #include "Generic/discTagger/DTFeatureType.h"
 
 #include "Generic/discTagger/DTFeature.h"
+#include "Generic/discTagger/DTFeatureKey.h"
 
 #ifdef _WIN32
 	#define swprintf _snwprintf
@@ -87,6 +88,16 @@ public:
 		// non-negative)
 	}
 
+	bool getKeyWithoutTag(DTFeatureKey &key) const {
+		key.reset(getFeatureType())
+		   .add(_symbol2)
+		   .add(_symbol3)
+		   .add(_symbol4)
+		   .add(_integer1)
+		   .add(_integer2);
+		return true;
+	}
+
 	void toString(wstring &str) const {
 		wchar_t buf[100];
 		swprintf(buf, 100, L"%d %d", _integer1, _integer2);
@@ -12,6 +12,7 @@
 #include "Generic/discTagger/DTFeatureType.h"
 
 #include "Generic/discTagger/DTFeature.h"
+#include "Generic/discTagger/DTFeatureKey.h"
 
 using namespace std;
 
@@ -73,6 +74,11 @@ public:
 			    ^ _symbol4.hash_code();
 	}
 
+	bool getKeyWithoutTag(DTFeatureKey &key) const {
+		key.reset(getFeatureType()).add(_symbol2).add(_symbol3).add(_symbol4);
+		return true;
+	}
+
 	void toString(wstring &str) const {
 		str = _symbol1.to_string();
 		str += L" ";
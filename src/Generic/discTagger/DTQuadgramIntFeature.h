@@ -12,6 +12,7 @@
 #include "Generic/discTagger/DTFeatureType.h"
 
 #include "Generic/discTagger/DTFeature.h"
+#include "Generic/discTagger/DTFeatureKey.h"
 
 #ifdef _WIN32
 	#define swprintf _snwprintf
@@ -85,6 +86,15 @@ public:
 		// non-negative)
 	}
 
+	bool getKeyWithoutTag(DTFeatureKey &key) const {
+		key.reset(getFeatureType())
+		   .add(_symbol2)
+		   .add(_symbol3)
+		   .add(_symbol4)
+		   .add(_integer);
+		return true;
+	}
+
 	void toString(wstring &str) const {
 		str = _symbol1.to_string();
 		str += L" ";
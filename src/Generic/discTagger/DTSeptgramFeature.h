@@ -12,6 +12,7 @@
 #include "discTagger/DTFeatureType.h"
 
 #include "discTagger/DTFeature.h"
+#include "discTagger/DTFeatureKey.h"
 
 using namespace std;
 
@@ -81,6 +82,17 @@ public:
 			    ^ _symbol4.hash_code() ^ _symbol5.hash_code() ^ _symbol6.hash_code() ^ _symbol7.hash_code();
 	}
 
+	virtual bool getKeyWithoutTag(DTFeatureKey &key) const {
+		key.reset(getFeatureType())
+		   .add(_symbol2)
+		   .add(_symbol3)
+		   .add(_symbol4)
+		   .add(_symbol5)
+		   .add(_symbol6)
+		   .add(_symbol7);
+		return true;
+	}
+
 	virtual void toString(wstring &str) const {
 		str = _symbol1.to_string();
 		str += L" ";
@@ -12,6 +12,7 @@
 #include "Generic/discTagger/DTFeatureType.h"
 
 #include "Generic/discTagger/DTFeature.h"
+#include "Generic/discTagger/DTFeatureKey.h"
 
 #ifdef _WIN32
 	#define swprintf _snwprintf
@@ -96,6 +97,18 @@ public:
 		// non-negative)
 	}
 
+	virtual bool getKeyWithoutTag(DTFeatureKey &key) const {
+		key.reset(getFeatureType())
+		   .add(_symbol2)
+		   .add(_symbol3)
+		   .add(_symbol4)
+		   .add(_symbol5)
+		   .add(_symbol6)
+		   .add(_symbol7)
+		   .add(_integer);
+		return true;
+	}
+
 	virtual void toString(wstring &str) const {
 		str = _symbol1.to_string();
 		str += L" ";
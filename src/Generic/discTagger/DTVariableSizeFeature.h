@@ -12,6 +12,7 @@
 #include "Generic/discTagger/DTFeatureType.h"
 
 #include "Generic/discTagger/DTFeature.h"
+#include "Generic/discTagger/DTFeatureKey.h"
 
 using namespace std;
 
@@ -99,6 +100,16 @@ public:
 		return hash_code;
 	}
 
+	bool getKeyWithoutTag(DTFeatureKey &key) const {
+		// One word for the symbol count, plus one word per symbol.
+		if (_n_symbols >= DTFeatureKey::MAX_WORDS)
+			return false;
+		key.reset(getFeatureType()).add(_n_symbols);
+		for (int i = 0; i < _n_symbols; i++)
+			key.add(_symbols[i]);
+		return true;
+	}
+
 	void toString(wstring &str) const {
 		str = _symbol1.to_string();
 		str += L" ";
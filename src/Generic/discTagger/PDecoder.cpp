@@ -7,6 +7,7 @@
 #include "Generic/discTagger/DTObservation.h"
 #include "Generic/discTagger/DTState.h"
 #include "Generic/discTagger/DTFeatureType.h"
+#include "Generic/discTagger/DTFeatureKey.h"
 #include "Generic/discTagger/DTFeatureTypeSet.h"
 #include "Generic/discTagger/PWeight.h"
 #include "Generic/discTagger/PDecoder.h"
@@ -16,6 +17,7 @@
 #include "Generic/common/SessionLogger.h"
 
 #include <cfloat>
+#include <limits>
 #include <sstream>
 
 #include <boost/format.hpp>
@@ -30,7 +32,8 @@ PDecoder::PDecoder(DTTagSet *tagSet, DTFeatureTypeSet *featureTypes,
 	  _observationOnlyFeatureTypes(0), _withPrevTagFeatureTypes(0), 
 	  _n_observation_only_feature_types(0), _n_with_prev_tag_feature_types(0), 
 	  _use_lazy_sum(use_lazy_sum), _n_examples(0),
-	  _n_observation_only_buffered_features(0),_n_with_prev_tag_buffered_features(0)
+	  _n_observation_only_buffered_features(0),_n_with_prev_tag_buffered_features(0),
+	  _viterbiOps(false), _use_vector_viterbi(false), _use_float_scores(false)
 
 {
 	// Split feature types to speed up the decoding.
@@ -50,12 +53,20 @@ PDecoder::PDecoder(DTTagSet *tagSet, DTFeatureTypeSet *featureTypes,
 	  _observationOnlyFeatureTypes(0), _withPrevTagFeatureTypes(0), 
 	  _n_observation_only_feature_types(0), _n_with_prev_tag_feature_types(0), 
 	  _use_lazy_sum(use_lazy_sum), _n_examples(0),
-	  _n_observation_only_buffered_features(0),_n_with_prev_tag_buffered_features(0)
+	  _n_observation_only_buffered_features(0),_n_with_prev_tag_buffered_features(0),
+	  _viterbiOps(ParamReader::getOptionalTrueFalseParamWithDefaultVal("pdecoder_use_avx2", true)),
+	  _use_vector_viterbi(ParamReader::getOptionalTrueFalseParamWithDefaultVal("pdecoder_use_vector_viterbi", true)),
+	  _use_float_scores(ParamReader::getOptionalTrueFalseParamWithDefaultVal("pdecoder_use_float_scores", false))
 
 {
 	// Split feature types to speed up the decoding.
 	splitFeatureTypes();
 
+	// Buffered features are looked up by DTFeatureKey if the table is
+	// frozen (DTFeature::readWeights() freezes it unless the
+	// "freeze_block_feature_tables" parameter is false), and by DTFeature
+	// otherwise.
+
 	// Initialize feature buffers
 	_use_buffered_features = true;
 	_max_buffered_features = DTFeatureType::MAX_FEATURES_PER_EXTRACTION * _featureTypes->getNFeaturesTypes();
@@ -754,6 +765,14 @@ void PDecoder::forwardPass(vector<DTObservation *> & observations,
 	int n_regular_tags = _tagSet->getNRegularTags();
 	initFeatureBuffers();
 
+	if (_use_buffered_features && _use_vector_viterbi) {
+		if (_use_float_scores)
+			bufferedForwardPass<float>(observations, traceback, f_score, f_active, constraints);
+		else
+			bufferedForwardPass<double>(observations, traceback, f_score, f_active, constraints);
+		return;
+	}
+
 	for (int i = 0; i < n_obs; i++) {
 		for (int j = 0; j < n_tags; j++) {
 			f_active[n_tags*i + j] = false;
@@ -878,6 +897,14 @@ void PDecoder::backwardPass(std::vector<DTObservation *> & observations,
 	int n_tags = _tagSet->getNTags();
 	initFeatureBuffers();
 
+	if (_use_buffered_features && _use_vector_viterbi) {
+		if (_use_float_scores)
+			bufferedBackwardPass<float>(observations, traceforward, b_score, b_active, constraints);
+		else
+			bufferedBackwardPass<double>(observations, traceforward, b_score, b_active, constraints);
+		return;
+	}
+
 	for (int i = 0; i < n_obs; i++) {
 		for (int j = 0; j < n_tags; j++) {
 			b_active[n_tags*i + j] = false;
@@ -946,6 +973,232 @@ void PDecoder::backwardPass(std::vector<DTObservation *> & observations,
 	}
 }
 
+template<typename ScoreT>
+void PDecoder::getTransitionMask(std::vector<ScoreT> &transitions, bool regular_tags_only) const {
+	int n_tags = _tagSet->getNTags();
+	int n_current_tags = regular_tags_only ? _tagSet->getNRegularTags() : n_tags;
+	transitions.assign(n_tags*n_tags, -std::numeric_limits<ScoreT>::infinity());
+	for (int tag = 0; tag < n_current_tags; tag++) {
+		std::set<int> prev_tags = _tagSet->getPredecessorTags(tag);
+		BOOST_FOREACH(int prev_tag, prev_tags) {
+			transitions[n_tags*prev_tag + tag] = 0;
+		}
+	}
+}
+
+/*
+	Equivalent to the unbuffered forwardPass, but since the buffered features
+	for a state don't depend on its tag, the features for each (position,
+	previous tag) pair are loaded only once, and are used to score every tag
+	at that position with a single vector operation.  Inactive states have a
+	score of -infinity, as do disallowed transitions (see getTransitionMask),
+	so they never win the max.  Previous tags are visited in increasing order
+	and only a strictly greater score replaces the best so far, so ties are
+	broken the same way as in the unbuffered version.
+*/
+template<typename ScoreT>
+void PDecoder::bufferedForwardPass(std::vector<DTObservation *> & observations,
+                                   int *traceback, double* f_score,
+                                   bool* f_active, int* constraints)
+{
+	int n_obs = static_cast<int>(observations.size());
+	int n_tags = _tagSet->getNTags();
+	const ScoreT inactive = -std::numeric_limits<ScoreT>::infinity();
+
+	std::vector<ScoreT> transitions;
+	getTransitionMask(transitions, true);
+	std::vector<bool> has_successor(n_tags, false);
+	for (int prev_tag = 0; prev_tag < n_tags; prev_tag++) {
+		for (int tag = 0; tag < n_tags; tag++) {
+			if (transitions[n_tags*prev_tag + tag] == 0)
+				has_successor[prev_tag] = true;
+		}
+	}
+
+	std::vector<ScoreT> prev_scores(n_tags, inactive);
+	std::vector<ScoreT> scores(n_tags, inactive);
+	std::vector<ScoreT> feature_scores(n_tags);
+	std::vector<ScoreT> allowed(n_tags, 0);
+
+	for (int i = 0; i < n_obs; i++) {
+		for (int j = 0; j < n_tags; j++) {
+			f_active[n_tags*i + j] = false;
+		}
+	}
+
+	int start_tag = _tagSet->getStartTagIndex();
+	f_active[start_tag] = true;
+	f_score[start_tag] = 0;
+	prev_scores[start_tag] = 0;
+
+	// The buffered features don't depend on the tag, so any tag will do
+	// when building the states that they are extracted from.
+	const Symbol &anyTag = _tagSet->getTagSymbol(0);
+	const Symbol &anyRTag = _tagSet->getReducedTagSymbol(0);
+	const Symbol &anySRTag = _tagSet->getSemiReducedTagSymbol(0);
+	Symbol fakePrevTag;
+
+	// Process all but the last (END) observation - do that one separately
+	for (int prev_index = 0; prev_index < n_obs - 2; prev_index++) {
+		int index = prev_index + 1;
+
+		std::fill(scores.begin(), scores.end(), inactive);
+		if (constraints != NULL) {
+			for (int tag = 0; tag < n_tags; tag++)
+				allowed[tag] = isAllowableTag(tag, constraints[index]) ? 0 : inactive;
+		}
+
+		for (int prev_tag = 0; prev_tag < n_tags; prev_tag++) {
+			if (prev_scores[prev_tag] == inactive || !has_successor[prev_tag])
+				continue;
+			if (constraints != NULL && !isAllowableTag(prev_tag, constraints[prev_index])) 
+				continue;
+
+			DTState curState(anyTag, anyRTag, anySRTag,
+							 _tagSet->getTagSymbol(prev_tag), index,
+							 observations);
+			loadWithPrevTagFeatureBuffer(curState, _withPrevTagFeatureTypes, _n_with_prev_tag_feature_types);
+			_viterbiOps.sumRows(_withPrevTagFeatureBuffer, _n_with_prev_tag_buffered_features, n_tags, &feature_scores[0]);
+			if (constraints != NULL)
+				_viterbiOps.add(&feature_scores[0], &allowed[0], n_tags);
+
+			_viterbiOps.maxPlusUpdate(prev_scores[prev_tag], &feature_scores[0], &transitions[n_tags*prev_tag], n_tags,
+			                          &scores[0], traceback + n_tags*index, prev_tag);
+		}
+
+		bool any_active = false;
+		for (int tag = 0; tag < n_tags && !any_active; tag++)
+			any_active = (scores[tag] != inactive);
+
+		if (any_active) {
+			DTState state(anyTag, anyRTag, anySRTag,
+						  fakePrevTag, index,
+						  observations);
+			loadObservationOnlyFeatureBuffer(state, _observationOnlyFeatureTypes, _n_observation_only_feature_types);
+			_viterbiOps.sumRows(_observationOnlyFeatureBuffer, _n_observation_only_buffered_features, n_tags, &feature_scores[0]);
+			_viterbiOps.add(&scores[0], &feature_scores[0], n_tags);
+
+			for (int tag = 0; tag < n_tags; tag++) {
+				if (scores[tag] != inactive) {
+					f_score[n_tags*index + tag] = scores[tag];
+					f_active[n_tags*index + tag] = true;
+				}
+			}
+		}
+
+		prev_scores.swap(scores);
+	}
+
+	// Process the last observation on its own.  The only valid tag is "END",
+	// so we don't need to score, just update the traceback to the highest prev tag
+	int prev_index = n_obs - 2;
+	int index = prev_index + 1;
+	int tag = _tagSet->getEndTagIndex();
+
+	std::set<int> prev_tags = _tagSet->getPredecessorTags(tag);
+
+	BOOST_FOREACH(int prev_tag, prev_tags) {
+		if (f_active[n_tags*prev_index + prev_tag]) {
+			double score = f_score[n_tags*prev_index + prev_tag];
+			if ( !f_active[n_tags*index + tag] ||
+				score > f_score[n_tags*index + tag])
+			{
+				f_score[n_tags*index + tag] = score;
+				traceback[n_tags*index + tag] = prev_tag;
+				f_active[n_tags*index + tag] = true;
+			}
+		}
+	}
+}
+
+/*
+	Equivalent to the unbuffered backwardPass; see bufferedForwardPass.  For
+	each previous tag, the best next tag is the lowest-numbered tag with the
+	highest score, just as in the unbuffered version.
+*/
+template<typename ScoreT>
+void PDecoder::bufferedBackwardPass(std::vector<DTObservation *> & observations,
+                                    int* traceforward, double* b_score,
+                                    bool* b_active, int* constraints)
+{
+	int n_obs = static_cast<int>(observations.size());
+	int n_tags = _tagSet->getNTags();
+	const ScoreT inactive = -std::numeric_limits<ScoreT>::infinity();
+
+	std::vector<ScoreT> transitions;
+	getTransitionMask(transitions, false);
+
+	std::vector<ScoreT> next_scores(n_tags, inactive);
+	std::vector<ScoreT> scores(n_tags, inactive);
+	std::vector<ScoreT> feature_scores(n_tags);
+
+	for (int i = 0; i < n_obs; i++) {
+		for (int j = 0; j < n_tags; j++) {
+			b_active[n_tags*i + j] = false;
+		}
+	}
+
+	int end_tag = _tagSet->getEndTagIndex();
+	b_active[n_tags*(n_obs-1)+end_tag] = true;
+	b_score[n_tags*(n_obs-1)+end_tag] = 0;
+	next_scores[end_tag] = 0;
+
+	const Symbol &anyTag = _tagSet->getTagSymbol(0);
+	const Symbol &anyRTag = _tagSet->getReducedTagSymbol(0);
+	const Symbol &anySRTag = _tagSet->getSemiReducedTagSymbol(0);
+	Symbol fakePrevTag;
+
+	for (int index = n_obs-1; index > 0; index--) {
+		int prev_index = index - 1;
+
+		bool any_active = false;
+		for (int tag = 0; tag < n_tags && !any_active; tag++)
+			any_active = (next_scores[tag] != inactive);
+		std::fill(scores.begin(), scores.end(), inactive);
+		if (!any_active) {
+			next_scores.swap(scores);
+			continue;
+		}
+
+		DTState state(anyTag, anyRTag, anySRTag,
+					  fakePrevTag, index,
+					  observations);
+		loadObservationOnlyFeatureBuffer(state, _observationOnlyFeatureTypes, _n_observation_only_feature_types);
+		_viterbiOps.sumRows(_observationOnlyFeatureBuffer, _n_observation_only_buffered_features, n_tags, &feature_scores[0]);
+		_viterbiOps.add(&next_scores[0], &feature_scores[0], n_tags);
+
+		for (int prev_tag = 0; prev_tag < n_tags; prev_tag++) {
+			if (constraints != NULL && !isAllowableTag(prev_tag, constraints[prev_index]))
+				continue;
+
+			// Skip previous tags that have no active successor.
+			const ScoreT *prev_transitions = &transitions[n_tags*prev_tag];
+			bool has_active_successor = false;
+			for (int tag = 0; tag < n_tags && !has_active_successor; tag++)
+				has_active_successor = (prev_transitions[tag] == 0 && next_scores[tag] != inactive);
+			if (!has_active_successor)
+				continue;
+
+			DTState curState(anyTag, anyRTag, anySRTag,
+			                 _tagSet->getTagSymbol(prev_tag), index,
+			                 observations); 
+			loadWithPrevTagFeatureBuffer(curState, _withPrevTagFeatureTypes, _n_with_prev_tag_feature_types);
+			_viterbiOps.sumRows(_withPrevTagFeatureBuffer, _n_with_prev_tag_buffered_features, n_tags, &feature_scores[0]);
+
+			ScoreT best;
+			int best_tag = _viterbiOps.maxPlusArgmax(&next_scores[0], &feature_scores[0], prev_transitions, n_tags, best);
+			if (best_tag >= 0) {
+				scores[prev_tag] = best;
+				b_score[n_tags*prev_index + prev_tag] = best;
+				b_active[n_tags*prev_index + prev_tag] = true;
+				traceforward[n_tags*prev_index + prev_tag] = best_tag;
+			}
+		}
+
+		next_scores.swap(scores);
+	}
+}
+
 double PDecoder::scoreState(const DTState &state) {
 	double result = 0;
 
@@ -1052,7 +1305,6 @@ double PDecoder::scoreObservationOnlyState(const DTState &state, const DTFeature
 }
 
 void PDecoder::loadWithPrevTagFeatureBuffer(const DTState &state, const DTFeatureType **featureTypes, const int n_feature_types) {
-	DTFeature *featureArray[DTFeatureType::MAX_FEATURES_PER_EXTRACTION];
 	_n_with_prev_tag_buffered_features = 0;
 
 	if (!_use_buffered_features) {
@@ -1060,18 +1312,28 @@ void PDecoder::loadWithPrevTagFeatureBuffer(const DTState &state, const DTFeatur
 				"This method is only compatible with the buffered features setting.");
 	}
 
+	if (!_weightsByBlock->isFrozen()) {
+		DTFeature *featureArray[DTFeatureType::MAX_FEATURES_PER_EXTRACTION];
+		for (int i = 0; i < n_feature_types; i++) {
+			int n_features = featureTypes[i]->extractFeatures(state, featureArray);
+			for (int j = 0; j < n_features; j++) {
+				_weightsByBlock->load(featureArray[j], _withPrevTagFeatureBuffer[_n_with_prev_tag_buffered_features++]);
+				featureArray[j]->deallocate();
+			}
+		}
+		return;
+	}
+
 	for (int i = 0; i < n_feature_types; i++) {
-		int n_features = featureTypes[i]->extractFeatures(state, featureArray);
+		int n_features = featureTypes[i]->extractFeatureKeys(state, _featureKeys);
 		for (int j = 0; j < n_features; j++) {
-			DTFeature *feature = featureArray[j];
-			_weightsByBlock->load(feature, _withPrevTagFeatureBuffer[_n_with_prev_tag_buffered_features++]);
-			feature->deallocate();
+			_weightsByBlock->load(_featureKeys[j], _withPrevTagFeatureBuffer[_n_with_prev_tag_buffered_features++]);
+			_featureKeys[j].releaseFeature();
 		}
 	}
 }
 
 void PDecoder::loadObservationOnlyFeatureBuffer(const DTState &state, const DTFeatureType **featureTypes, const int n_feature_types) {
-	DTFeature *featureArray[DTFeatureType::MAX_FEATURES_PER_EXTRACTION];
 	_n_observation_only_buffered_features = 0;
 
 	if (!_use_buffered_features) {
@@ -1079,12 +1341,23 @@ void PDecoder::loadObservationOnlyFeatureBuffer(const DTState &state, const DTFe
 				"This method is only compatible with the buffered features setting.");
 	}
 
+	if (!_weightsByBlock->isFrozen()) {
+		DTFeature *featureArray[DTFeatureType::MAX_FEATURES_PER_EXTRACTION];
+		for (int i = 0; i < n_feature_types; i++) {
+			int n_features = featureTypes[i]->extractFeatures(state, featureArray);
+			for (int j = 0; j < n_features; j++) {
+				_weightsByBlock->load(featureArray[j], _observationOnlyFeatureBuffer[_n_observation_only_buffered_features++]);
+				featureArray[j]->deallocate();
+			}
+		}
+		return;
+	}
+
 	for (int i = 0; i < n_feature_types; i++) {
-		int n_features = featureTypes[i]->extractFeatures(state, featureArray);
+		int n_features = featureTypes[i]->extractFeatureKeys(state, _featureKeys);
 		for (int j = 0; j < n_features; j++) {
-			DTFeature *feature = featureArray[j];
-			_weightsByBlock->load(feature, _observationOnlyFeatureBuffer[_n_observation_only_buffered_features++]);
-			feature->deallocate();
+			_weightsByBlock->load(_featureKeys[j], _observationOnlyFeatureBuffer[_n_observation_only_buffered_features++]);
+			_featureKeys[j].releaseFeature();
 		}
 	}
 }
@@ -6,6 +6,10 @@
 
 #include "Generic/common/Symbol.h"
 #include "Generic/discTagger/DTFeature.h"
+#include "Generic/discTagger/DTFeatureKey.h"
+#include "Generic/discTagger/DTFeatureType.h"
+#include "Generic/discTagger/ViterbiOps.h"
+#include <vector>
 
 class DTTagSet;
 class DTObservation;
@@ -42,6 +46,28 @@ private:
 	int _n_observation_only_buffered_features;
 	int _n_with_prev_tag_buffered_features;
 
+	/** Reusable buffer for the feature keys that are extracted when loading
+	  * the feature buffers, so that weights can be looked up without
+	  * building DTFeatures.  Keys are only used if the weight table is
+	  * frozen; otherwise, each feature is built and looked up in the
+	  * table's hash map, as before the tables were frozen. */
+	DTFeatureKey _featureKeys[DTFeatureType::MAX_FEATURES_PER_EXTRACTION];
+
+	/** With buffered features, the features extracted for a state depend
+	  * on its previous tag but not on its tag, so forwardPass() and 
+	  * backwardPass() score all the tags at a position at once, using the
+	  * vector operations in _viterbiOps (which use AVX2 where available,
+	  * unless the "pdecoder_use_avx2" parameter is false).  If the
+	  * "pdecoder_use_float_scores" parameter is true, they keep scores as
+	  * floats rather than doubles, which is faster but may change the
+	  * results when two paths have nearly equal scores.  If the
+	  * "pdecoder_use_vector_viterbi" parameter is false, they score one
+	  * (tag, previous tag) pair at a time instead, as the unbuffered
+	  * version does; this is slower, and is kept as a reference. */
+	ViterbiOps _viterbiOps;
+	bool _use_vector_viterbi;
+	bool _use_float_scores;
+
 	/** These are used to improve the decoding speed by separating the feature types
 	  * that do and do not extract features from the previous tag.
 	  */
@@ -130,6 +156,21 @@ private:
 	void backwardPass(std::vector<DTObservation *> & observations, 
 	                  int* traceforward, double* b_score, bool* b_active, int* constraints = 0);
 
+	/** Versions of forwardPass and backwardPass for buffered features; ScoreT 
+	  * is the type (double or float) used to hold scores. */
+	template<typename ScoreT>
+	void bufferedForwardPass(std::vector<DTObservation*> & observations, 
+	                         int* traceback, double* f_score, bool* f_active, int* constraints);
+	template<typename ScoreT>
+	void bufferedBackwardPass(std::vector<DTObservation*> & observations, 
+	                          int* traceforward, double* b_score, bool* b_active, int* constraints);
+
+	/** Set transitions[n_tags*prev_tag + tag] to 0 if prev_tag is a predecessor
+	  * of tag, and to -infinity otherwise.  If regular_tags_only is true, then
+	  * the START and END tags are never allowed as the current tag. */
+	template<typename ScoreT>
+	void getTransitionMask(std::vector<ScoreT> &transitions, bool regular_tags_only) const;
+
 	/** original (non-optimized) score state method **/
 	double scoreState(const DTState &state);
 
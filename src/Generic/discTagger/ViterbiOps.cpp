@@ -0,0 +1,317 @@
+// Copyright (c) 2012 by Raytheon BBN Technologies Corp.
+// All Rights Reserved.
+
+#include "Generic/common/leak_detection.h"
+
+#include "Generic/discTagger/ViterbiOps.h"
+
+#include <limits>
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+	#include <intrin.h>
+	#include <immintrin.h>
+	#define VITERBI_OPS_AVX2
+	#define AVX2_TARGET
+#elif (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+	#include <immintrin.h>
+	#define VITERBI_OPS_AVX2
+	#define AVX2_TARGET __attribute__((target("avx2")))
+#endif
+
+namespace {
+	//======================== Scalar versions ==========================
+	// Each of these starts at index start, so it can also be used to
+	// finish off the elements that are left over by the vectorized versions.
+
+	template<typename ScoreT>
+	void sumRowsScalar(const double * const *rows, int n_rows, int start, int n, ScoreT *result) {
+		for (int t = start; t < n; t++) {
+			ScoreT sum = 0;
+			for (int i = 0; i < n_rows; i++)
+				sum += static_cast<ScoreT>(rows[i][t]);
+			result[t] = sum;
+		}
+	}
+
+	template<typename ScoreT>
+	void addScalar(ScoreT *scores, const ScoreT *delta, int start, int n) {
+		for (int t = start; t < n; t++)
+			scores[t] += delta[t];
+	}
+
+	template<typename ScoreT>
+	void maxPlusUpdateScalar(ScoreT base, const ScoreT *delta, const ScoreT *mask, int start, int n,
+	                         ScoreT *scores, int *backpointers, int backpointer)
+	{
+		for (int t = start; t < n; t++) {
+			ScoreT candidate = (base + delta[t]) + mask[t];
+			if (candidate > scores[t]) {
+				scores[t] = candidate;
+				backpointers[t] = backpointer;
+			}
+		}
+	}
+
+	template<typename ScoreT>
+	void maxPlusArgmaxScalar(const ScoreT *base, const ScoreT *delta, const ScoreT *mask, int start, int n,
+	                         ScoreT &best, int &best_index)
+	{
+		for (int t = start; t < n; t++) {
+			ScoreT candidate = (base[t] + delta[t]) + mask[t];
+			if (candidate > best) {
+				best = candidate;
+				best_index = t;
+			}
+		}
+	}
+
+#ifdef VITERBI_OPS_AVX2
+	//========================= AVX2 versions ===========================
+
+	AVX2_TARGET void sumRowsAVX2(const double * const *rows, int n_rows, int n, double *result) {
+		int t = 0;
+		for (; t + 4 <= n; t += 4) {
+			__m256d sum = _mm256_setzero_pd();
+			for (int i = 0; i < n_rows; i++)
+				sum = _mm256_add_pd(sum, _mm256_loadu_pd(rows[i] + t));
+			_mm256_storeu_pd(result + t, sum);
+		}
+		sumRowsScalar(rows, n_rows, t, n, result);
+	}
+
+	AVX2_TARGET void sumRowsAVX2(const double * const *rows, int n_rows, int n, float *result) {
+		int t = 0;
+		for (; t + 8 <= n; t += 8) {
+			__m256 sum = _mm256_setzero_ps();
+			for (int i = 0; i < n_rows; i++) {
+				__m128 lo = _mm256_cvtpd_ps(_mm256_loadu_pd(rows[i] + t));
+				__m128 hi = _mm256_cvtpd_ps(_mm256_loadu_pd(rows[i] + t + 4));
+				sum = _mm256_add_ps(sum, _mm256_insertf128_ps(_mm256_castps128_ps256(lo), hi, 1));
+			}
+			_mm256_storeu_ps(result + t, sum);
+		}
+		sumRowsScalar(rows, n_rows, t, n, result);
+	}
+
+	AVX2_TARGET void addAVX2(double *scores, const double *delta, int n) {
+		int t = 0;
+		for (; t + 4 <= n; t += 4)
+			_mm256_storeu_pd(scores + t, _mm256_add_pd(_mm256_loadu_pd(scores + t), _mm256_loadu_pd(delta + t)));
+		addScalar(scores, delta, t, n);
+	}
+
+	AVX2_TARGET void addAVX2(float *scores, const float *delta, int n) {
+		int t = 0;
+		for (; t + 8 <= n; t += 8)
+			_mm256_storeu_ps(scores + t, _mm256_add_ps(_mm256_loadu_ps(scores + t), _mm256_loadu_ps(delta + t)));
+		addScalar(scores, delta, t, n);
+	}
+
+	AVX2_TARGET void maxPlusUpdateAVX2(double base, const double *delta, const double *mask, int n,
+	                                   double *scores, int *backpointers, int backpointer)
+	{
+		__m256d base_v = _mm256_set1_pd(base);
+		int t = 0;
+		for (; t + 4 <= n; t += 4) {
+			__m256d candidate = _mm256_add_pd(_mm256_add_pd(base_v, _mm256_loadu_pd(delta + t)),
+			                                  _mm256_loadu_pd(mask + t));
+			__m256d current = _mm256_loadu_pd(scores + t);
+			__m256d greater = _mm256_cmp_pd(candidate, current, _CMP_GT_OQ);
+			int bits = _mm256_movemask_pd(greater);
+			if (bits != 0) {
+				_mm256_storeu_pd(scores + t, _mm256_blendv_pd(current, candidate, greater));
+				for (int k = 0; k < 4; k++) {
+					if (bits & (1 << k))
+						backpointers[t + k] = backpointer;
+				}
+			}
+		}
+		maxPlusUpdateScalar(base, delta, mask, t, n, scores, backpointers, backpointer);
+	}
+
+	AVX2_TARGET void maxPlusUpdateAVX2(float base, const float *delta, const float *mask, int n,
+	                                   float *scores, int *backpointers, int backpointer)
+	{
+		__m256 base_v = _mm256_set1_ps(base);
+		int t = 0;
+		for (; t + 8 <= n; t += 8) {
+			__m256 candidate = _mm256_add_ps(_mm256_add_ps(base_v, _mm256_loadu_ps(delta + t)),
+			                                 _mm256_loadu_ps(mask + t));
+			__m256 current = _mm256_loadu_ps(scores + t);
+			__m256 greater = _mm256_cmp_ps(candidate, current, _CMP_GT_OQ);
+			int bits = _mm256_movemask_ps(greater);
+			if (bits != 0) {
+				_mm256_storeu_ps(scores + t, _mm256_blendv_ps(current, candidate, greater));
+				for (int k = 0; k < 8; k++) {
+					if (bits & (1 << k))
+						backpointers[t + k] = backpointer;
+				}
+			}
+		}
+		maxPlusUpdateScalar(base, delta, mask, t, n, scores, backpointers, backpointer);
+	}
+
+	// The candidates are computed four (or eight) at a time; blocks that
+	// contain a candidate greater than the best so far are then scanned
+	// in order, so ties still go to the lowest index.
+	AVX2_TARGET void maxPlusArgmaxAVX2(const double *base, const double *delta, const double *mask, int n,
+	                                   double &best, int &best_index)
+	{
+		int t = 0;
+		for (; t + 4 <= n; t += 4) {
+			__m256d candidate = _mm256_add_pd(_mm256_add_pd(_mm256_loadu_pd(base + t), _mm256_loadu_pd(delta + t)),
+			                                  _mm256_loadu_pd(mask + t));
+			if (_mm256_movemask_pd(_mm256_cmp_pd(candidate, _mm256_set1_pd(best), _CMP_GT_OQ)) != 0) {
+				double values[4];
+				_mm256_storeu_pd(values, candidate);
+				for (int k = 0; k < 4; k++) {
+					if (values[k] > best) {
+						best = values[k];
+						best_index = t + k;
+					}
+				}
+			}
+		}
+		maxPlusArgmaxScalar(base, delta, mask, t, n, best, best_index);
+	}
+
+	AVX2_TARGET void maxPlusArgmaxAVX2(const float *base, const float *delta, const float *mask, int n,
+	                                   float &best, int &best_index)
+	{
+		int t = 0;
+		for (; t + 8 <= n; t += 8) {
+			__m256 candidate = _mm256_add_ps(_mm256_add_ps(_mm256_loadu_ps(base + t), _mm256_loadu_ps(delta + t)),
+			                                 _mm256_loadu_ps(mask + t));
+			if (_mm256_movemask_ps(_mm256_cmp_ps(candidate, _mm256_set1_ps(best), _CMP_GT_OQ)) != 0) {
+				float values[8];
+				_mm256_storeu_ps(values, candidate);
+				for (int k = 0; k < 8; k++) {
+					if (values[k] > best) {
+						best = values[k];
+						best_index = t + k;
+					}
+				}
+			}
+		}
+		maxPlusArgmaxScalar(base, delta, mask, t, n, best, best_index);
+	}
+#endif
+}
+
+ViterbiOps::ViterbiOps(bool use_avx2): _use_avx2(use_avx2 && avx2Supported()) {}
+
+bool ViterbiOps::avx2Supported() {
+#if defined(VITERBI_OPS_AVX2) && defined(_MSC_VER)
+	int info[4];
+	__cpuid(info, 0);
+	if (info[0] < 7)
+		return false;
+	// AVX2 also requires the operating system to save the YMM registers.
+	__cpuid(info, 1);
+	bool osxsave = (info[2] & (1 << 27)) != 0;
+	bool avx = (info[2] & (1 << 28)) != 0;
+	if (!osxsave || !avx || (_xgetbv(0) & 0x6) != 0x6)
+		return false;
+	__cpuidex(info, 7, 0);
+	return (info[1] & (1 << 5)) != 0;
+#elif defined(VITERBI_OPS_AVX2)
+	__builtin_cpu_init();
+	return __builtin_cpu_supports("avx2") != 0;
+#else
+	return false;
+#endif
+}
+
+void ViterbiOps::sumRows(const double * const *rows, int n_rows, int n, double *result) const {
+#ifdef VITERBI_OPS_AVX2
+	if (_use_avx2) {
+		sumRowsAVX2(rows, n_rows, n, result);
+		return;
+	}
+#endif
+	sumRowsScalar(rows, n_rows, 0, n, result);
+}
+
+void ViterbiOps::sumRows(const double * const *rows, int n_rows, int n, float *result) const {
+#ifdef VITERBI_OPS_AVX2
+	if (_use_avx2) {
+		sumRowsAVX2(rows, n_rows, n, result);
+		return;
+	}
+#endif
+	sumRowsScalar(rows, n_rows, 0, n, result);
+}
+
+void ViterbiOps::add(double *scores, const double *delta, int n) const {
+#ifdef VITERBI_OPS_AVX2
+	if (_use_avx2) {
+		addAVX2(scores, delta, n);
+		return;
+	}
+#endif
+	addScalar(scores, delta, 0, n);
+}
+
+void ViterbiOps::add(float *scores, const float *delta, int n) const {
+#ifdef VITERBI_OPS_AVX2
+	if (_use_avx2) {
+		addAVX2(scores, delta, n);
+		return;
+	}
+#endif
+	addScalar(scores, delta, 0, n);
+}
+
+void ViterbiOps::maxPlusUpdate(double base, const double *delta, const double *mask, int n,
+                               double *scores, int *backpointers, int backpointer) const
+{
+#ifdef VITERBI_OPS_AVX2
+	if (_use_avx2) {
+		maxPlusUpdateAVX2(base, delta, mask, n, scores, backpointers, backpointer);
+		return;
+	}
+#endif
+	maxPlusUpdateScalar(base, delta, mask, 0, n, scores, backpointers, backpointer);
+}
+
+void ViterbiOps::maxPlusUpdate(float base, const float *delta, const float *mask, int n,
+                               float *scores, int *backpointers, int backpointer) const
+{
+#ifdef VITERBI_OPS_AVX2
+	if (_use_avx2) {
+		maxPlusUpdateAVX2(base, delta, mask, n, scores, backpointers, backpointer);
+		return;
+	}
+#endif
+	maxPlusUpdateScalar(base, delta, mask, 0, n, scores, backpointers, backpointer);
+}
+
+int ViterbiOps::maxPlusArgmax(const double *base, const double *delta, const double *mask, int n,
+                              double &best) const
+{
+	int best_index = -1;
+	best = -std::numeric_limits<double>::infinity();
+#ifdef VITERBI_OPS_AVX2
+	if (_use_avx2) {
+		maxPlusArgmaxAVX2(base, delta, mask, n, best, best_index);
+		return best_index;
+	}
+#endif
+	maxPlusArgmaxScalar(base, delta, mask, 0, n, best, best_index);
+	return best_index;
+}
+
+int ViterbiOps::maxPlusArgmax(const float *base, const float *delta, const float *mask, int n,
+                              float &best) const
+{
+	int best_index = -1;
+	best = -std::numeric_limits<float>::infinity();
+#ifdef VITERBI_OPS_AVX2
+	if (_use_avx2) {
+		maxPlusArgmaxAVX2(base, delta, mask, n, best, best_index);
+		return best_index;
+	}
+#endif
+	maxPlusArgmaxScalar(base, delta, mask, 0, n, best, best_index);
+	return best_index;
+}
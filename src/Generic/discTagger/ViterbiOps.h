@@ -0,0 +1,59 @@
+// Copyright (c) 2012 by Raytheon BBN Technologies Corp.
+// All Rights Reserved.
+
+#ifndef VITERBI_OPS_H
+#define VITERBI_OPS_H
+
+/** ViterbiOps provides the vector operations that are used by the inner
+  * loops of PDecoder's Viterbi search.  Each operation works on a
+  * contiguous array of scores (one per tag), and comes in a double and a
+  * float version.
+  *
+  * On x86 processors that support AVX2, the operations are vectorized
+  * using AVX2 instructions; otherwise (or if use_avx2 is false) they fall
+  * back on plain scalar loops.  The choice is made at runtime, so a
+  * single binary may be run on any processor.  The vectorized and scalar
+  * versions perform exactly the same arithmetic operations, in the same
+  * order, for each tag, and so give identical results.
+  *
+  * Scores of -infinity are used to represent inactive states and
+  * disallowed transitions. */
+class ViterbiOps {
+public:
+	ViterbiOps(bool use_avx2 = true);
+
+	/** Return true if the vectorized versions of the operations are used. */
+	bool usesAVX2() const { return _use_avx2; }
+
+	/** Return true if this processor (and operating system) supports AVX2. */
+	static bool avx2Supported();
+
+	/** Set result[t] = rows[0][t] + ... + rows[n_rows-1][t], for 0 <= t < n. */
+	void sumRows(const double * const *rows, int n_rows, int n, double *result) const;
+	void sumRows(const double * const *rows, int n_rows, int n, float *result) const;
+
+	/** Set scores[t] = scores[t] + delta[t], for 0 <= t < n. */
+	void add(double *scores, const double *delta, int n) const;
+	void add(float *scores, const float *delta, int n) const;
+
+	/** For 0 <= t < n, compute the candidate score (base + delta[t]) + mask[t];
+	  * if it is greater than scores[t], then set scores[t] to the candidate
+	  * score and backpointers[t] to backpointer. */
+	void maxPlusUpdate(double base, const double *delta, const double *mask, int n,
+	                   double *scores, int *backpointers, int backpointer) const;
+	void maxPlusUpdate(float base, const float *delta, const float *mask, int n,
+	                   float *scores, int *backpointers, int backpointer) const;
+
+	/** Return the index of the greatest value of (base[t] + delta[t]) + mask[t],
+	  * for 0 <= t < n, and store that value in best.  Ties go to the lowest
+	  * index.  If every value is -infinity, then return -1. */
+	int maxPlusArgmax(const double *base, const double *delta, const double *mask, int n,
+	                  double &best) const;
+	int maxPlusArgmax(const float *base, const float *delta, const float *mask, int n,
+	                  float &best) const;
+
+private:
+	bool _use_avx2;
+};
+
+#endif
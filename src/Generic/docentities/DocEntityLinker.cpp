@@ -5,10 +5,12 @@
 
 #include "Generic/theories/DocTheory.h"
 #include "Generic/theories/EntitySet.h"
+#include "Generic/theories/MentionSet.h"
 #include "Generic/theories/RelMentionSet.h"
 #include "Generic/common/UnexpectedInputException.h"
 #include "Generic/common/Sexp.h"
 #include "Generic/common/ParamReader.h"
+#include "Generic/common/Profiler.h"
 #include "Generic/docentities/DocEntityLinker.h"
 #include "Generic/edt/ReferenceResolver.h"
 #include "Generic/docentities/StrategicEntityLinker.h"
@@ -131,6 +133,8 @@ void DocEntityLinker::doSentenceBySentenceCoref(DocTheory* docTheory) {
 					numSent, docTheory->getDocument()->getName());
 			}
 		} else {
+			Profiler::Scope searchScope("linker-search");
+			Profiler::count("mentions", sTheory->getMentionSet()->getNMentions());
 			_referenceResolver->resetForNewSentence(docTheory, sent);
 			_referenceResolver->addPartOfSpeechTheory(sTheory->getPartOfSpeechSequence());
 			_referenceResolver->getEntityTheories(esets, 1, sTheory->getPrimaryParse(),
@@ -23,12 +23,25 @@
 #include <boost/algorithm/string/predicate.hpp>
 #include <iostream>
 #include <fstream>
+#pragma warning(push, 0)
+#include <boost/date_time/posix_time/posix_time_types.hpp>
+#include <boost/date_time/posix_time/conversion.hpp>
+#pragma warning(pop)
 
 #ifdef _WIN32
 #include <Windows.h>
 #define usleep(x) Sleep((x)/1000)
 #else
 #include <unistd.h>
+#include <sys/stat.h>
+#endif
+
+// inotify is Linux-only; other platforms (including OS X) poll the queue
+// directories.
+#if defined(__linux__)
+#include <poll.h>
+#include <sys/inotify.h>
+#define DISK_QUEUE_USE_INOTIFY
 #endif
 
 namespace {
@@ -55,11 +68,42 @@ namespace {
 		SessionLogger::err("disk_queue") << msg;
 		std::cerr << msg;
 	}
+
+	// Return the (UTC) time when the given file was added to the queue,
+	// or not_a_date_time if it is unknown.
+	boost::posix_time::ptime getQueuedTime(const std::string& path) {
+#ifdef _WIN32
+		try {
+			return boost::posix_time::from_time_t(boost::filesystem::last_write_time(path));
+		} catch (std::exception&) {
+			return boost::posix_time::ptime();
+		}
+#else
+		// Files are added to the queue by renaming them, which updates
+		// their inode change time.
+		struct stat st;
+		if (stat(path.c_str(), &st) != 0)
+			return boost::posix_time::ptime();
+#if defined(__linux__)
+		return boost::posix_time::from_time_t(st.st_ctime) +
+			boost::posix_time::microseconds(st.st_ctim.tv_nsec / 1000);
+#else
+		// Without the nanosecond field, fall back on the (whole-second)
+		// modification time, as on Windows.
+		return boost::posix_time::from_time_t(st.st_mtime);
+#endif
+#endif
+	}
 }
 
-DiskQueueDriver::~DiskQueueDriver() {}
+DiskQueueDriver::~DiskQueueDriver() {
+#ifdef DISK_QUEUE_USE_INOTIFY
+	if (_inotifyFd >= 0)
+		close(_inotifyFd);
+#endif
+}
 
-DiskQueueDriver::DiskQueueDriver(): _retryingFailedDocument(false) {
+DiskQueueDriver::DiskQueueDriver(): _retryingFailedDocument(false), _inotifyFd(-1) {
 	// Source and destination queue directories.  We will read *.READY
 	// files from the source directory, and write them to the dst
 	// directory.
@@ -111,6 +155,14 @@ DiskQueueDriver::DiskQueueDriver(): _retryingFailedDocument(false) {
 		throw UnexpectedInputException("DiskQueueCLIHook::run",
 			"Destination directory is not a directory", _dst.c_str());
 
+	// Ask to be notified when files are added to or removed from the
+	// queue directories, so we don't need to poll them.  In a worker
+	// pool, each worker does this for itself after it is forked (see
+	// setWorkerId()), since the workers can not share an inotify
+	// descriptor: each would consume events that the others need.
+	if (getNumWorkers() <= 1)
+		startWatching();
+
 	std::string expt_dir = ParamReader::getParam("experiment_dir");
 	if (expt_dir.empty()) {
 		SessionLogger::setGlobalLogger(new ConsoleSessionLogger(N_CONTEXTS, CONTEXT_NAMES));
@@ -131,6 +183,59 @@ DiskQueueDriver::DiskQueueDriver(): _retryingFailedDocument(false) {
 
 }
 
+void DiskQueueDriver::startWatching() {
+#ifdef DISK_QUEUE_USE_INOTIFY
+	if (_inotifyFd >= 0)
+		close(_inotifyFd);
+	_inotifyFd = -1;
+	if (ParamReader::getOptionalTrueFalseParamWithDefaultVal("disk_queue_use_inotify", true)) {
+		_inotifyFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+		const unsigned int changes = IN_CREATE | IN_CLOSE_WRITE | IN_MOVED_TO | IN_MOVED_FROM | IN_DELETE;
+		if (_inotifyFd < 0 || (hasSource() && !watchDirectory(_src, changes)) || !watchDirectory(_dst, changes)) {
+			SessionLogger::warn("disk_queue") << "Unable to watch the queue directories with inotify; "
+				<< "polling them instead";
+			if (_inotifyFd >= 0)
+				close(_inotifyFd);
+			_inotifyFd = -1;
+		} else if (!_quitFile.empty()) {
+			std::string quitDir = boost::filesystem::path(_quitFile).parent_path().string();
+			if (!watchDirectory(quitDir.empty() ? "." : quitDir, changes)) {
+				SessionLogger::warn("disk_queue") << "Unable to watch the directory containing " << _quitFile
+					<< "; it will only be checked periodically";
+			}
+		}
+	}
+#endif
+}
+
+bool DiskQueueDriver::watchDirectory(const std::string& dir, unsigned int events) {
+#ifdef DISK_QUEUE_USE_INOTIFY
+	// IN_MASK_ADD, in case the same directory is watched more than once.
+	return inotify_add_watch(_inotifyFd, dir.c_str(), events | IN_MASK_ADD) >= 0;
+#else
+	return false;
+#endif
+}
+
+void DiskQueueDriver::waitForChange(int max_wait_msec) {
+#ifdef DISK_QUEUE_USE_INOTIFY
+	if (_inotifyFd >= 0) {
+		struct pollfd pfd;
+		pfd.fd = _inotifyFd;
+		pfd.events = POLLIN;
+		pfd.revents = 0;
+		if (poll(&pfd, 1, max_wait_msec) > 0) {
+			// We rescan the directories after every wait, so all we need
+			// to know is that something changed; discard the events.
+			char buffer[4096];
+			while (read(_inotifyFd, buffer, sizeof(buffer)) > 0) {}
+		}
+		return;
+	}
+#endif
+	QueueDriver::waitForChange(max_wait_msec);
+}
+
 bool DiskQueueDriver::gotQuitSignal() {
 	try {
 		// If our source directory has a "done" file, and it contains
@@ -208,14 +313,17 @@ bool DiskQueueDriver::dstIsFull() {
 	return false;
 }
 
-void DiskQueueDriver::saveTimers(double workTime, double waitTime, double blockTime, double overheadTime, size_t numDocs) {
+void DiskQueueDriver::saveTimers(double workTime, double waitTime, double blockTime, double overheadTime, size_t numDocs,
+								 double avgQueueLatency, double maxQueueLatency) {
 	if (_timerFile.empty()) return;
 	std::ofstream out((_timerFile+".tmp").c_str());
 	out << "Work\t" << workTime << "\n"
 		<< "Wait\t" << waitTime << "\n"
 		<< "Block\t" << blockTime << "\n"
 		<< "Overhead\t" << overheadTime << "\n"
-		<< "Docs\t" << numDocs << "\n";
+		<< "Docs\t" << numDocs << "\n"
+		<< "QueueLatency\t" << avgQueueLatency << "\n"
+		<< "MaxQueueLatency\t" << maxQueueLatency << "\n";
 	out.close();
 	if (boost::filesystem::exists(_timerFile))
 		boost::filesystem::remove(_timerFile);
@@ -248,6 +356,7 @@ QueueDriver::Element_ptr DiskQueueDriver::next(const std::string& extension) {
 			std::string path = BOOST_FILESYSTEM_DIR_ITERATOR_GET_PATH(itr);
 			std::string basePath = path.substr(0, path.size()-extension.size());
 			std::string baseFilename = filename.substr(0, filename.size()-extension.size());
+			boost::posix_time::ptime queuedTime = getQueuedTime(path);
 
 			// Rename the file to add a special extension that signals 
 			// that we're working on this file.  This prevents any other
@@ -262,9 +371,15 @@ QueueDriver::Element_ptr DiskQueueDriver::next(const std::string& extension) {
 				// first.  Just continue scanning.
 				continue;
 			}
-			bool success = false;
+			// Record the document now, rather than after we read it, in
+			// case the worker dies while reading it.
+			bool retrying = (extension == FAILED_EXTENSION);
+			recordWorkerDocument(baseFilename, retrying);
 			try {
-				return readDocument(baseFilename);
+				Element_ptr elt = readDocument(baseFilename);
+				elt->queuedTime = queuedTime;
+				elt->retrying = retrying;
+				return elt;
 			} catch (UnrecoverableException &e) {
 				logException(path.c_str(), e.getMessage(), e.getSource());
 			} catch (std::exception &e) {
@@ -273,7 +388,7 @@ QueueDriver::Element_ptr DiskQueueDriver::next(const std::string& extension) {
 				logException(path.c_str());
 			}
 			try {
-				_retryingFailedDocument = extension == FAILED_EXTENSION;
+				_retryingFailedDocument = retrying;
 				handleFailure(boost::make_shared<Element>(baseFilename, (Document*)0, (DocTheory*)0));
 			} catch (UnrecoverableException &e) {
 				logException(path.c_str(), e.getMessage(), e.getSource());
@@ -282,6 +397,7 @@ QueueDriver::Element_ptr DiskQueueDriver::next(const std::string& extension) {
 			} catch (...) {
 				logException(path.c_str());
 			}
+			recordWorkerDocument("");
 		}
 	}
 	return QueueDriver::Element_ptr();
@@ -337,6 +453,42 @@ void DiskQueueDriver::writeResults(QueueDriver::Element_ptr elt) {
 	boost::filesystem::remove(_src+SERIF_PATH_SEP+srcFile);
 }
 
+std::string DiskQueueDriver::workerPoolExt(int worker_id) {
+	std::ostringstream ext;
+	ext << ".w" << worker_id;
+	return ext.str();
+}
+
+void DiskQueueDriver::setWorkerId(int worker_id) {
+	// The worker pool id goes before disk_queue_worker_ext, so that the
+	// last extension of a locked file still identifies the worker process
+	// that was started with this parameter file (as serif_queue_manager.py
+	// expects).  Each worker keeps its own timer file; the supervisor's
+	// timer file has the totals.
+	_workerExt = workerPoolExt(worker_id) + _workerExt;
+	if (!_timerFile.empty())
+		_timerFile += workerPoolExt(worker_id);
+	startWatching();
+}
+
+void DiskQueueDriver::handleWorkerCrash(int worker_id, QueueDriver::Element_ptr elt, bool crashed_before) {
+	// Handle the failure as the worker would have: a document that has
+	// already crashed a worker is given up on, rather than retried again.
+	std::string workerExt = _workerExt;
+	bool retryingFailedDocument = _retryingFailedDocument;
+	_workerExt = workerPoolExt(worker_id) + _workerExt;
+	_retryingFailedDocument = crashed_before;
+	try {
+		handleFailure(elt);
+	} catch (...) {
+		_workerExt = workerExt;
+		_retryingFailedDocument = retryingFailedDocument;
+		throw;
+	}
+	_workerExt = workerExt;
+	_retryingFailedDocument = retryingFailedDocument;
+}
+
 void DiskQueueDriver::handleFailure(QueueDriver::Element_ptr elt) {
 	const std::string &docId = elt->uid;
 	// Mark the input file as failed.  (Add a parameter that 
@@ -12,6 +12,11 @@
  * assumed to be atomic.  WARNING: This is true on most UNIX variants,
  * but is not always guaranteed on Windows filesystems!
  *
+ * On Linux, the driver uses inotify to watch the source and destination
+ * directories (and the directory containing the quit file), so that an
+ * idle worker wakes up as soon as a file is renamed into or out of them,
+ * rather than at its next poll.  If inotify is not available (or the
+ * disk_queue_use_inotify parameter is false), it falls back on polling.
  */
 class DiskQueueDriver: public QueueDriver {
 public:
@@ -24,8 +29,12 @@ protected:
 	virtual bool dstIsFull();
 	virtual Element_ptr next();
 	virtual void writeResults(Element_ptr elt);
-	virtual void saveTimers(double workTime, double waitTime, double blockTime, double overheadTime, size_t numDocs);
+	virtual void saveTimers(double workTime, double waitTime, double blockTime, double overheadTime, size_t numDocs,
+		double avgQueueLatency, double maxQueueLatency);
 	virtual void handleFailure(Element_ptr elt);
+	virtual void waitForChange(int max_wait_msec);
+	virtual void setWorkerId(int worker_id);
+	virtual void handleWorkerCrash(int worker_id, Element_ptr elt, bool crashed_before);
 
 	/* This can be used by subclasses (eg ICEWSQueueFeeder) to
 	 * indicate that there is no source directory. */
@@ -37,6 +46,11 @@ protected:
 private:
 	Element_ptr readDocument(const std::string& docId);
 	Element_ptr next(const std::string& extension);
+	/** Start watching the queue directories with inotify (unless
+	 * disk_queue_use_inotify is false), replacing any earlier watch. */
+	void startWatching();
+	bool watchDirectory(const std::string& dir, unsigned int events);
+	static std::string workerPoolExt(int worker_id);
 
 	std::string _sourceFormat;
 	std::string _src;
@@ -50,6 +64,10 @@ private:
 	boost::scoped_ptr<ResultCollector> _resultCollector;
 
 	bool _retryingFailedDocument;
+
+	/** inotify file descriptor for watching the queue directories, or
+	 * -1 if we are polling instead. */
+	int _inotifyFd;
 };
 
 #endif
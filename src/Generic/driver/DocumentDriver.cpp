@@ -17,6 +17,7 @@
 #include "Generic/common/OutputUtil.h"
 #include "Generic/common/HeapStatus.h"
 #include "Generic/common/IStringStream.h"
+#include "Generic/common/Profiler.h"
 
 #include "Generic/commandLineInterface/CommandLineInterface.h"
 #include "Generic/common/FeatureModule.h"
@@ -63,6 +64,7 @@
 #include "Generic/state/StateLoader.h"
 #include "Generic/state/ObjectIDTable.h"
 #include "Generic/state/ObjectPointerTable.h"
+#include "Generic/state/CompactDocTheoryFile.h"
 #include "Generic/wordnet/xx_WordNet.h"
 #include "Generic/results/SerifXMLResultCollector.h"
 #include "Generic/PropTree/PropForestFactory.h"
@@ -114,7 +116,8 @@ DocumentDriver::DocumentDriver(const SessionProgram *sessionProgram,
 	  _docRelationEventProcessor(0), _docValueProcessor(0), _confidenceEstimator(0),
 	  _docActorProcessor(0), _factFinder(0), _xdocClient(0), _propStatusClassifier(0),
 	  _causeEffectRelationFinder(0), _maxSymbolTableSize(0), _num_docs_processed(0), 
-	  _num_docs_per_cleanup(0), _globalSessionLoggerIsLocalSessionLogger(false)
+	  _num_docs_per_cleanup(0), _globalSessionLoggerIsLocalSessionLogger(false),
+	  _streaming_doc_theory(false), _max_document_memory(0), _document_start_memory(0)
 {
 
 	totalBytesProcessed = 0;
@@ -151,6 +154,8 @@ DocumentDriver::DocumentDriver(const SessionProgram *sessionProgram,
 	int open_file_retries = ParamReader::getOptionalIntParamWithDefaultValue("open_file_retries", 0);
 	if (open_file_retries > 0)
 		UTF8InputStream::setOpenFileRetries(open_file_retries);
+	UTF8InputStream::setUseFileBuffer(ParamReader::getOptionalTrueFalseParamWithDefaultVal("use_utf8_file_buffer", true));
+	Profiler::configure();
 
 	Symbol::initializeSymbolsFromFile();
 
@@ -172,6 +177,8 @@ DocumentDriver::DocumentDriver(const SessionProgram *sessionProgram,
 	}
 
 	_max_document_processing_milliseconds = ParamReader::getOptionalIntParamWithDefaultValue("max_document_processing_seconds", 0)*1000.0;
+	_streaming_doc_theory = ParamReader::isParamTrue("streaming_doc_theory");
+	_max_document_memory = static_cast<size_t>(ParamReader::getOptionalIntParamWithDefaultValue("max_document_memory_mb", 0)) * 1024 * 1024;
 
 	// Create timers
 	for (Stage stage=Stage::getStartStage(); stage<Stage::getEndStage(); ++stage) {
@@ -289,6 +296,8 @@ void DocumentDriver::endBatch() {
 	// Let the sentence driver know we're ending this batch.
 	_sentenceDriver->endBatch();
 
+	Profiler::writeFiles();
+
 	if (_localSessionLogger) {
 		delete _localSessionLogger;
 		_localSessionLogger = 0;
@@ -308,6 +317,21 @@ void DocumentDriver::endBatch() {
 
 
 
+void DocumentDriver::checkMultithreadedSettings(const char *paramName) {
+#ifndef SYMBOL_THREADSAFE
+	std::ostringstream err;
+	err << paramName << " > 1 requires a build with SYMBOL_THREADSAFE enabled.";
+	throw UnexpectedInputException("DocumentDriver::checkMultithreadedSettings", err.str().c_str());
+#endif
+	if (!ParamReader::getParam("word_net_dictionary_path").empty()) {
+		if (!ParamReader::isParamTrue("preload_wordnet") || !WordNet::getInstance()->isPreloaded()) {
+			std::ostringstream err;
+			err << paramName << " > 1 requires preload_wordnet to be true.";
+			throw UnexpectedInputException("DocumentDriver::checkMultithreadedSettings", err.str().c_str());
+		}
+	}
+}
+
 bool DocumentDriver::stageModelsAreLoaded(Stage stage) {
 	if (_docTheoryStageHandlers.find(stage) != _docTheoryStageHandlers.end())
 		return (_docTheoryStageHandlers[stage] != 0);
@@ -344,6 +368,8 @@ void DocumentDriver::loadModelsForStage(Stage stage) {
 	try {
 		cout << "Initializing Stage " << stage.getSequenceNumber() 
 			<< " (" << stage.getName() << ")..." << std::endl;
+		Profiler::Scope loadScope("load");
+		Profiler::Scope stageScope(stage.getName());
 		stageLoadTimer[stage].startTimer();
 
 		if (stage == Stage("sent-break")) loadSentenceBreakerModels();
@@ -452,7 +478,10 @@ void DocumentDriver::serifXMLTest() {
 					<< "-" << stage.getSequenceNumber() 
 					<< "-" << stage.getName() << L".xml";
 				std::wstring fname = fn.str();
-				SerifXML::XMLSerializedDocTheory(docTheory).save(fname.c_str());
+				if (CompactDocTheoryFile::isEnabled())
+					CompactDocTheoryFile::save(docTheory, fname.c_str());
+				else
+					SerifXML::XMLSerializedDocTheory(docTheory).save(fname.c_str());
 
 				delete docTheory;
 				delete document;
@@ -749,6 +778,9 @@ void DocumentDriver::runOnDocument(Document *document,
 
 	HeapStatus heapStatus;
 	heapStatus.takeReading("Before document");
+	bool report_memory = (_streaming_doc_theory || _max_document_memory > 0);
+	if (report_memory)
+		HeapStatus::resetPeakResidentMemory();
 
 	// Process the document.  Once we're done, we can delete the DocTheory -- we've
 	// already saved the results (either to a state file if we're doing partial 
@@ -775,14 +807,47 @@ void DocumentDriver::runOnDocument(Document *document,
 			outputSerifXMLResults(results, mergedDocTheory);
 		outputMTResults(results, mergedDocTheory);
 	}
+	std::wstring document_name = document->getName().to_string();
 	delete mergedDocTheory->getDocument();
 	delete mergedDocTheory;
 
+	if (report_memory) {
+		SessionLogger::info("document_memory") << "Peak resident memory for document " << document_name
+			<< ": " << HeapStatus::getPeakResidentMemory() / (1024 * 1024) << " MB";
+	}
+
 	heapStatus.takeReading("After document");
 	heapStatus.displayReadings();
 	heapStatus.flushReadings();
 }
 
+namespace {
+	size_t getMemoryGrowth(size_t start_memory) {
+		size_t resident_memory = HeapStatus::getResidentMemory();
+		return (resident_memory > start_memory) ? (resident_memory - start_memory) : 0;
+	}
+}
+
+void DocumentDriver::checkDocumentMemory(const std::wstring& document_name, const std::string& checkpoint) {
+	// Memory that was freed by earlier documents but kept by the heap is
+	// reused before the resident set grows, so this measures the memory
+	// that the current document actually needs.
+	if (_max_document_memory == 0 || getMemoryGrowth(_document_start_memory) <= _max_document_memory)
+		return;
+	_localSessionLogger->warn("document_memory") << "Document " << document_name << " is over the memory limit after "
+		<< checkpoint << "; freeing sentence-level caches";
+	_sentenceDriver->cleanup();
+	HeapStatus::releaseFreeMemory();
+	size_t memory_growth = getMemoryGrowth(_document_start_memory);
+	if (memory_growth > _max_document_memory) {
+		std::ostringstream err;
+		err << "Document " << document_name << " exceeded the memory limit after " << checkpoint
+			<< " (resident memory grew by " << memory_growth / (1024 * 1024) << " MB; max_document_memory_mb is "
+			<< _max_document_memory / (1024 * 1024) << ")";
+		throw UnrecoverableException("DocumentDriver::checkDocumentMemory", err.str().c_str());
+	}
+}
+
 DocTheory *DocumentDriver::getInitialDocTheory(Document *document) {
 	Stage startStage = _sessionProgram->getStartStage();
 	Stage endStage = _sessionProgram->getEndStage();
@@ -884,10 +949,13 @@ void DocumentDriver::runOnDocTheory(DocTheory *docTheory,
 
 	// Clear the timer each document, since we're not collecting overall profiling for timeouts
 	documentProcessTimer.resetTimer();
+	if (_max_document_memory > 0)
+		_document_start_memory = HeapStatus::getResidentMemory();
 
 	const Document *document = docTheory->getDocument();
 	wstring document_name( document->getName().to_string() );
 	_localSessionLogger->updateContext(DOCUMENT_CONTEXT, document_name.c_str());
+	Profiler::DocumentScope documentScope(document_name);
 
 	// Record number of bytes processed.
 	totalBytesProcessed += document->getOriginalText()->length();
@@ -903,6 +971,7 @@ void DocumentDriver::runOnDocTheory(DocTheory *docTheory,
 		if (!_sessionProgram->includeStage(currentStage))
 			continue;
 		_localSessionLogger->updateContext(STAGE_CONTEXT, currentStage.getName());
+		Profiler::Scope stageScope(currentStage.getName());
 		stageProcessTimer[currentStage].startTimer();
 		documentProcessTimer.startTimer();
 		if (currentStage == Stage ("start")) {
@@ -929,6 +998,7 @@ void DocumentDriver::runOnDocTheory(DocTheory *docTheory,
 	// Sentence Breaking
 	if ((currentStage == Stage("sent-break") && 
 		 _sessionProgram->includeStage(currentStage))) {
+		Profiler::Scope stageScope(currentStage.getName());
 		stageProcessTimer[currentStage].startTimer();
 		documentProcessTimer.startTimer();
 		_sentenceBreaker->resetForNewDocument(document);
@@ -954,7 +1024,24 @@ void DocumentDriver::runOnDocTheory(DocTheory *docTheory,
 	if ((currentStage <= Stage::getLastSentenceLevelStage()) &&
 		(endStage >= Stage("sent-break")))
 	{
+		// The sentence driver profiles each sentence-level stage under this.
+		Profiler::Scope sentencesScope("sentences");
 		_sentenceDriver->beginDocument(docTheory);
+		// If we have worker sentence drivers, then use them to run as many
+		// sentence-level stages as possible in parallel; the sentence loop
+		// below then runs any remaining stages.
+		Stage sentenceStartStage = startStage;
+		if (_sentenceDriver->usesParallelSentences()) {
+			documentProcessTimer.startTimer();
+			sentenceStartStage = _sentenceDriver->runParallel(docTheory, startStage, endStage,
+				_streaming_doc_theory && endStage > Stage::getLastSentenceLevelStage());
+			documentProcessTimer.stopTimer();
+			if (_max_document_processing_milliseconds > 0 && documentProcessTimer.getTime() > _max_document_processing_milliseconds) {
+				std::ostringstream err;
+				err << "Document " << document_name << " timed out after parallel sentence-level stages";
+				throw UnrecoverableException("DocumentDriver::runOnDocTheory", err.str().c_str());
+			}
+		}
 		// main sentence loop -- all sentence-level stages
 		for (int sent_no = 0; sent_no < docTheory->getNSentences(); sent_no++) {\
 			// update session logger with sentence info
@@ -963,15 +1050,24 @@ void DocumentDriver::runOnDocTheory(DocTheory *docTheory,
 			_localSessionLogger->updateContext(SENTENCE_CONTEXT, sent_str);
 			SentenceTheoryBeam *sentenceTheoryBeam;
 			documentProcessTimer.startTimer();
-			sentenceTheoryBeam = _sentenceDriver->run(docTheory, sent_no, startStage, endStage);
+			sentenceTheoryBeam = _sentenceDriver->run(docTheory, sent_no, sentenceStartStage, endStage);
 			//std::cout << document->getName().to_debug_string() << ":" << sent_no << ": " << std::hex << (int) sentenceTheoryBeam << " " << (int) sentenceTheoryBeam->getBestTheory() << std::dec << std::endl;
 			docTheory->setSentenceTheoryBeam(sent_no, sentenceTheoryBeam);
+			// Once the sentence is finished, only its best theory is used by
+			// the document-level stages.
+			if (_streaming_doc_theory && sentenceTheoryBeam != 0 && endStage > Stage::getLastSentenceLevelStage())
+				sentenceTheoryBeam->pruneToBestTheory();
 			documentProcessTimer.stopTimer();
 			if (_max_document_processing_milliseconds > 0 && documentProcessTimer.getTime() > _max_document_processing_milliseconds) {
 				std::ostringstream err;
 				err << "Document " << document_name << " timed out after sentence " << (sent_no + 1) << "/" << docTheory->getNSentences();
 				throw UnrecoverableException("DocumentDriver::runOnDocTheory", err.str().c_str());
 			}
+			if (_max_document_memory > 0) {
+				std::ostringstream checkpoint;
+				checkpoint << "sentence " << (sent_no + 1) << "/" << docTheory->getNSentences();
+				checkDocumentMemory(document_name, checkpoint.str());
+			}
 		}
 
 		// If any sentences provided an entity set, then adopt the last such entity
@@ -997,6 +1093,8 @@ void DocumentDriver::runOnDocTheory(DocTheory *docTheory,
 				dumpDocumentTheory(docTheory, document->getName().to_string());
 			}
 		}
+		if (_streaming_doc_theory && endStage > Stage::getLastSentenceLevelStage())
+			_sentenceDriver->releaseSentenceCaches();
 		_sentenceDriver->endDocument();
 	}
 
@@ -1012,6 +1110,7 @@ void DocumentDriver::runOnDocTheory(DocTheory *docTheory,
 			continue;
 
 		_localSessionLogger->updateContext(STAGE_CONTEXT, stage.getName());
+		Profiler::Scope stageScope(stage.getName());
 
 		stageProcessTimer[stage].startTimer();
 		documentProcessTimer.startTimer();
@@ -1071,6 +1170,8 @@ void DocumentDriver::runOnDocTheory(DocTheory *docTheory,
 			err << "Document " << document_name << " timed out after stage " << stage.getName();
 			throw UnrecoverableException("DocumentDriver::runOnDocTheory", err.str().c_str());
 		}
+		if (_max_document_memory > 0)
+			checkDocumentMemory(document_name, std::string("stage ") + stage.getName());
 	}
 
 	// If the doc_format is SerifXML, then generate output even if we didn't
@@ -1115,7 +1216,7 @@ void DocumentDriver::saveDocTheoryState(DocTheory *docTheory, Stage stage) {
 		wstring dname( docTheory->getDocument()->getName().to_string() );
 		wstring state_file = _sessionProgram->constructSingleDocumentStateFile(dname.c_str(), stage);
 		
-        stateSaver = _new StateSaver(state_file.c_str(), ParamReader::isParamTrue("binary_state_files"));
+        stateSaver = _new StateSaver(state_file.c_str());
 		docTheory->saveSentenceBreaksToStateFile(stateSaver);
 	} else {
 		stateSaver = _sentenceDriver->getStageStateSaver(stage);
@@ -1915,6 +2016,7 @@ void DocumentDriver::logTrace() const {
 	SessionLogger::info("profiling") << endl;
 	if (_docRelationEventProcessor)
 		_docRelationEventProcessor->logTrace();
+	Profiler::logReport();
 }
 
 float DocumentDriver::getThroughput(bool include_load_times) {
@@ -109,6 +109,15 @@ public:
 	/** Return true if the models for the specified stage have been loaded. */
 	bool stageModelsAreLoaded(Stage stage);
 
+	/** Check that the current build and parameters allow Serif to process
+	  * documents or sentences on more than one thread at once, and throw an
+	  * UnexpectedInputException if they do not.  paramName is the parameter
+	  * that asked for more than one thread.  This requires SYMBOL_THREADSAFE
+	  * and (if WordNet is used) preload_wordnet, since the WordNet library
+	  * keeps its state in static buffers.  It also creates the WordNet
+	  * singleton, so that two threads can't both try to create it. */
+	static void checkMultithreadedSettings(const char *paramName);
+
     void addAlternateResultCollectors(std::vector<ResultCollector*> *alternateResultCollectors) { _alternateResultCollectors = alternateResultCollectors; }
 
 	/** Abstract base class for document-level processing stages.  Each 
@@ -199,6 +208,21 @@ protected:
 	/** Optionally time out on a document **/
 	double _max_document_processing_milliseconds;
 
+	/** If true, then once a sentence has been through all sentence-level
+	  * stages, discard every theory in its beam except the best one, so
+	  * that memory use for very long documents does not grow with the beam
+	  * width; and once every sentence is finished, free the sentence-level
+	  * token feature caches (set by the streaming_doc_theory parameter). **/
+	bool _streaming_doc_theory;
+
+	/** Optionally give up on a document if the process's resident memory
+	  * grows by more than this many bytes while processing it (0 for no
+	  * limit; set in megabytes by the max_document_memory_mb parameter). **/
+	size_t _max_document_memory;
+
+	/** The process's resident memory when we started the current document. **/
+	size_t _document_start_memory;
+
 	/** Document-level box that links entities in a second pass
 	 * (often "strategically") */
 	DocEntityLinker *_docEntityLinker;
@@ -310,6 +334,13 @@ protected:
 	void loadDocTheory(DocTheory *docTheory, Stage stage);
 	void saveSentenceBreakState(DocTheory *docTheory);
 
+	/** If the process's resident memory has grown by more than 
+	  * _max_document_memory since the current document started, then free
+	  * the sentence-level caches (and return free heap memory to the
+	  * system); and if that doesn't bring it back under the limit, throw
+	  * an UnrecoverableException. */
+	void checkDocumentMemory(const std::wstring& document_name, const std::string& checkpoint);
+
  protected:
 	void logSessionStart();
 
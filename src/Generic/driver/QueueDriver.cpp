@@ -18,6 +18,10 @@
 #include <boost/foreach.hpp>
 #include <boost/scoped_ptr.hpp>
 #include <boost/algorithm/string/predicate.hpp>
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <vector>
 #pragma warning(push, 0)
 #include <boost/date_time/posix_time/posix_time_types.hpp>
 #pragma warning(pop)
@@ -28,17 +32,25 @@
 #else
 #include <unistd.h>
 #include <ctime>
+#include <cerrno>
+#include <sys/mman.h>
+#include <sys/types.h>
+#include <sys/wait.h>
 #endif
 
 namespace {
 	// When there's nothing in our input queue, or our output queue is
-	// empty, we sleep until something appears.  We start out sleeping
-	// at MIN_SLEEP_TIME, and then sleep progressively longer periods
-	// until we're sleeping MAX_SLEEP_TIME.
+	// full, we wait until that changes.  We start out waiting at most
+	// MIN_SLEEP_TIME, and then wait progressively longer periods until
+	// we're waiting MAX_SLEEP_TIME.  (Queue drivers that are notified
+	// of changes to their queues will stop waiting as soon as they are.)
 	const int MIN_SLEEP_TIME = 10;   // Time in millisecs
 	const int MAX_SLEEP_TIME = 5000; // Time in millisecs
 	const int SLEEP_DELTA = 100; // dt in millisecs
 
+	// How often the supervisor of a worker pool checks on its workers.
+	const int SUPERVISOR_SLEEP_TIME = 500; // Time in millisecs
+
 	void logException(const char* docid=0, const char* what=0, const char* src=0) {
 		std::ostringstream msg;
 		msg << "Exception ";
@@ -52,7 +64,23 @@ namespace {
 	}
 }
 
-QueueDriver::QueueDriver() {
+/** The status of one worker in a worker pool.  Workers update their
+ * status as they go; the supervisor reads it to find the document that
+ * a crashed worker was processing, and to report the totals. */
+struct QueueDriver::WorkerStatus {
+	char uid[1024]; // The document being processed, or "" if none.
+	bool retrying; // True if the document had already failed once.
+	double workTime;
+	double waitTime;
+	double blockTime;
+	double overheadTime;
+	double totalQueueLatency;
+	double maxQueueLatency;
+	size_t numDocs;
+	size_t numLatencies;
+};
+
+QueueDriver::QueueDriver(): _num_workers(1), _workerStatus(0), _workerId(-1) {
 	// Build our document reader.
 	_sourceFormat = ParamReader::getParam("source_format");
 	if (!boost::iequals(_sourceFormat, "serifxml")) {
@@ -63,11 +91,20 @@ QueueDriver::QueueDriver() {
 	_sessionProgram.reset(_new SessionProgram());
 	_docDriver.reset(_new DocumentDriver(_sessionProgram.get(), 0));
 	_docDriver->endBatch();
+
+	_num_workers = ParamReader::getOptionalIntParamWithDefaultValue("queue_driver_workers", 1);
 }
 
 QueueDriver::~QueueDriver() {}
 
-void QueueDriver::processQueue() { 
+void QueueDriver::processQueue() {
+	if (_num_workers > 1)
+		runWorkerPool();
+	else
+		runQueue();
+}
+
+void QueueDriver::runQueue() { 
 	// How much time to we spend waiting for input, waiting for 
 	// space in the output queue, and actually working?
 	double waitTime=0;  // msec
@@ -75,6 +112,10 @@ void QueueDriver::processQueue() {
 	double workTime=0;  // msec
 	double realWorkTime = 0;
 	size_t numDocs=0;
+	// How long did documents wait in the queue before we started them?
+	double totalQueueLatency=0; // msec
+	double maxQueueLatency=0;   // msec
+	size_t numLatencies=0;
 
 	// The longer it's been since we've done something useful, the
 	// longer we sleep when polling to see if we're ready to do some
@@ -85,21 +126,46 @@ void QueueDriver::processQueue() {
 	while (true) {
 		try {
 			saveTimers(realWorkTime, waitTime, blockTime, 
-					   workTime-realWorkTime, numDocs);
+					   workTime-realWorkTime, numDocs,
+					   numLatencies ? totalQueueLatency/numLatencies : 0,
+					   maxQueueLatency);
+			if (_workerStatus) {
+				WorkerStatus &status = _workerStatus[_workerId];
+				status.workTime = realWorkTime;
+				status.waitTime = waitTime;
+				status.blockTime = blockTime;
+				status.overheadTime = workTime-realWorkTime;
+				status.totalQueueLatency = totalQueueLatency;
+				status.maxQueueLatency = maxQueueLatency;
+				status.numDocs = numDocs;
+				status.numLatencies = numLatencies;
+			}
 			if (gotQuitSignal()) return;
 			double *timerDst = 0;
 			if (dstIsFull()) {
 				timerDst = &blockTime;
-				usleep(sleep_time*1000);
+				waitForChange(sleep_time);
 			} else {
 				Element_ptr elt = next();
 				if (elt) {
+					if (!elt->queuedTime.is_not_a_date_time()) {
+						boost::posix_time::time_duration latency =
+							boost::posix_time::microsec_clock::universal_time() - elt->queuedTime;
+						double latency_msec = static_cast<double>(latency.total_milliseconds());
+						if (latency_msec < 0)
+							latency_msec = 0; // clock skew (e.g., on network filesystems)
+						totalQueueLatency += latency_msec;
+						maxQueueLatency = std::max(maxQueueLatency, latency_msec);
+						++numLatencies;
+					}
 					timerDst = &workTime;
+					recordWorkerDocument(elt->uid, elt->retrying);
 					realWorkTime += process(elt);
+					recordWorkerDocument("");
 					++numDocs;
 				} else {
 					timerDst = &waitTime;
-					usleep(sleep_time*1000);
+					waitForChange(sleep_time);
 				}
 			}
 			// Update the timer for whatever action we took.
@@ -161,6 +227,164 @@ double QueueDriver::process(Element_ptr elt)
 	return real_work_time;
 }
 
+void QueueDriver::waitForChange(int max_wait_msec) {
+	usleep(max_wait_msec*1000);
+}
+
+void QueueDriver::handleWorkerCrash(int worker_id, Element_ptr elt, bool crashed_before) {
+	handleFailure(elt);
+}
+
+void QueueDriver::recordWorkerDocument(const std::string &uid, bool retrying) {
+	if (_workerStatus) {
+		WorkerStatus &status = _workerStatus[_workerId];
+		strncpy(status.uid, uid.c_str(), sizeof(WorkerStatus::uid)-1);
+		status.uid[sizeof(WorkerStatus::uid)-1] = '\0';
+		status.retrying = retrying;
+	}
+}
+
+#ifdef _WIN32
+
+void QueueDriver::runWorkerPool() {
+	SessionLogger::warn("queue-driver") << "queue_driver_workers is not supported on Windows; "
+		<< "processing the queue in a single process";
+	runQueue();
+}
+
+int QueueDriver::startWorker(int worker_id) { return -1; }
+void QueueDriver::saveWorkerPoolTimers(const WorkerStatus &retired) {}
+
+#else
+
+void QueueDriver::runWorkerPool() {
+	// Load the models for every stage now, so the workers can share them.
+	for (Stage stage=_sessionProgram->getStartStage(); stage<=_sessionProgram->getEndStage(); ++stage) {
+		if (_sessionProgram->includeStage(stage))
+			_docDriver->loadModelsForStage(stage);
+	}
+
+	size_t status_size = _num_workers * sizeof(WorkerStatus);
+	void *shared = mmap(0, status_size, PROT_READ|PROT_WRITE, MAP_SHARED|MAP_ANONYMOUS, -1, 0);
+	if (shared == MAP_FAILED)
+		throw UnrecoverableException("QueueDriver::runWorkerPool", "Unable to allocate shared memory for the worker pool");
+	_workerStatus = static_cast<WorkerStatus*>(shared);
+	memset(_workerStatus, 0, status_size);
+
+	// The times for workers that have exited (or been restarted).
+	WorkerStatus retired;
+	memset(&retired, 0, sizeof(retired));
+
+	std::vector<pid_t> pids(_num_workers);
+	for (int i = 0; i < _num_workers; ++i)
+		pids[i] = startWorker(i);
+	int num_running = _num_workers;
+
+	while (num_running > 0) {
+		int exit_status = 0;
+		pid_t pid = waitpid(-1, &exit_status, WNOHANG);
+		if (pid < 0 && errno != EINTR) {
+			break; // No children left.
+		} else if (pid <= 0) {
+			saveWorkerPoolTimers(retired);
+			usleep(SUPERVISOR_SLEEP_TIME*1000);
+			continue;
+		}
+		int worker_id = static_cast<int>(std::find(pids.begin(), pids.end(), pid) - pids.begin());
+		if (worker_id == _num_workers)
+			continue; // Not one of our workers.
+		WorkerStatus &worker = _workerStatus[worker_id];
+		retired.workTime += worker.workTime;
+		retired.waitTime += worker.waitTime;
+		retired.blockTime += worker.blockTime;
+		retired.overheadTime += worker.overheadTime;
+		retired.totalQueueLatency += worker.totalQueueLatency;
+		retired.maxQueueLatency = std::max(retired.maxQueueLatency, worker.maxQueueLatency);
+		retired.numDocs += worker.numDocs;
+		retired.numLatencies += worker.numLatencies;
+		std::string uid(worker.uid);
+		bool retrying = worker.retrying;
+		memset(&worker, 0, sizeof(worker));
+
+		if (WIFEXITED(exit_status) && WEXITSTATUS(exit_status) == 0) {
+			// The worker got the quit signal.
+			pids[worker_id] = 0;
+			--num_running;
+			continue;
+		}
+
+		std::ostringstream msg;
+		msg << "Worker " << worker_id << " (pid " << pid << ") ";
+		if (WIFSIGNALED(exit_status))
+			msg << "was killed by signal " << WTERMSIG(exit_status);
+		else
+			msg << "exited with status " << WEXITSTATUS(exit_status);
+		if (!uid.empty())
+			msg << " while processing " << uid;
+		SessionLogger::err("queue-driver") << msg.str();
+		if (!uid.empty()) {
+			bool crashed_before = retrying || (_crashedDocuments.find(uid) != _crashedDocuments.end());
+			_crashedDocuments.insert(uid);
+			try {
+				handleWorkerCrash(worker_id, boost::make_shared<Element>(uid, (Document*)0, (DocTheory*)0), crashed_before);
+			} catch (UnrecoverableException &e) {
+				logException(uid.c_str(), e.getMessage(), e.getSource());
+			} catch (std::exception &e) {
+				logException(uid.c_str(), e.what());
+			} catch (...) {
+				logException(uid.c_str());
+			}
+		}
+		if (gotQuitSignal()) {
+			pids[worker_id] = 0;
+			--num_running;
+		} else {
+			pids[worker_id] = startWorker(worker_id);
+		}
+	}
+	saveWorkerPoolTimers(retired);
+	munmap(_workerStatus, status_size);
+	_workerStatus = 0;
+}
+
+int QueueDriver::startWorker(int worker_id) {
+	// Don't let the worker inherit (and repeat) any buffered output.
+	std::cout.flush();
+	std::cerr.flush();
+	fflush(0);
+	pid_t pid = fork();
+	if (pid < 0)
+		throw UnrecoverableException("QueueDriver::startWorker", "Unable to fork a worker process");
+	if (pid == 0) {
+		_workerId = worker_id;
+		setWorkerId(worker_id);
+		runQueue();
+		exit(0);
+	}
+	SessionLogger::info("queue-driver") << "Started worker " << worker_id << " (pid " << pid << ")";
+	return pid;
+}
+
+void QueueDriver::saveWorkerPoolTimers(const WorkerStatus &retired) {
+	WorkerStatus total = retired;
+	for (int i = 0; i < _num_workers; ++i) {
+		const WorkerStatus &worker = _workerStatus[i];
+		total.workTime += worker.workTime;
+		total.waitTime += worker.waitTime;
+		total.blockTime += worker.blockTime;
+		total.overheadTime += worker.overheadTime;
+		total.totalQueueLatency += worker.totalQueueLatency;
+		total.maxQueueLatency = std::max(total.maxQueueLatency, worker.maxQueueLatency);
+		total.numDocs += worker.numDocs;
+		total.numLatencies += worker.numLatencies;
+	}
+	saveTimers(total.workTime, total.waitTime, total.blockTime, total.overheadTime, total.numDocs,
+			   total.numLatencies ? total.totalQueueLatency/total.numLatencies : 0,
+			   total.maxQueueLatency);
+}
+
+#endif
+
 std::map<std::string, boost::shared_ptr<QueueDriver::Factory> > &QueueDriver::_factory() {
 	static std::map<std::string, boost::shared_ptr<Factory> > factory;
 	if (factory.empty()) {
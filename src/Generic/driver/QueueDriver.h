@@ -4,10 +4,14 @@
 #ifndef QUEUE_DRIVER_H
 #define QUEUE_DRIVER_H
 
+#include <set>
 #include <string>
 #include <boost/scoped_ptr.hpp>
 #include <boost/shared_ptr.hpp>
 #include <boost/make_shared.hpp>
+#pragma warning(push, 0)
+#include <boost/date_time/posix_time/posix_time_types.hpp>
+#pragma warning(pop)
 
 #include "Generic/driver/DocumentDriver.h"
 #include "Generic/driver/SessionProgram.h"
@@ -34,6 +38,15 @@
  * Documents are identified using "document identifier" strings. The
  * content and formatting of these identifiers is left up to the
  * subclasses.
+ *
+ * If the queue_driver_workers parameter is greater than one (and we're
+ * not on Windows), then processQueue() runs a pre-forked pool of worker
+ * processes: the models for every stage are loaded once, and then that
+ * many worker processes are forked, which share the model memory
+ * (copy-on-write), and which all pull documents from the same queue.
+ * The original process supervises the workers: if a worker dies while
+ * it is processing a document, then handleWorkerCrash() is called for
+ * that document, and the worker is restarted.
  */
 class QueueDriver {
 public:
@@ -69,9 +82,16 @@ protected:
 		std::string uid;
 		boost::scoped_ptr<const Document> document;
 		boost::scoped_ptr<DocTheory> docTheory;
+		/** The (UTC) time when this element was added to the queue, or
+		 * not_a_date_time if it is unknown.  Used to measure how long
+		 * documents wait in the queue before we start working on them. */
+		boost::posix_time::ptime queuedTime;
+		/** True if this element has already failed (or crashed a worker)
+		 * once, and is being retried. */
+		bool retrying;
 		/** Takes ownership of document & docTheory. */
 		Element(std::string uid, const Document *document, DocTheory *docTheory)
-			:uid(uid), document(document), docTheory(docTheory) {}
+			:uid(uid), document(document), docTheory(docTheory), retrying(false) {}
 	};
 	typedef boost::shared_ptr<Element> Element_ptr;
 
@@ -81,6 +101,40 @@ protected:
 	 * "locked." */
 	virtual double process(Element_ptr elt);
 
+	/** Wait until the source or destination location may have changed
+	 * (i.e., until a new input document may be available, or the
+	 * destination may no longer be full), or until max_wait_msec have
+	 * elapsed, whichever comes first.  This is called whenever there is
+	 * nothing to do.  The default implementation simply sleeps for
+	 * max_wait_msec; subclasses that can be notified of changes to
+	 * their queues should override it to return as soon as they are. */
+	virtual void waitForChange(int max_wait_msec);
+
+	/** Called in each worker process of a worker pool, before it starts
+	 * processing documents.  Subclasses can override this to keep the
+	 * workers' locks and timer files apart.  worker_id is between zero
+	 * and the number of workers. */
+	virtual void setWorkerId(int worker_id) {}
+
+	/** Called in the supervisor process when the given worker process
+	 * dies while processing a document.  crashed_before is true if
+	 * this document has already crashed a worker, or if the worker was
+	 * retrying it after an earlier failure.  The default
+	 * implementation calls handleFailure(). */
+	virtual void handleWorkerCrash(int worker_id, Element_ptr elt, bool crashed_before);
+
+	/** In a worker process, record the document that the worker is
+	 * working on (or that it is not working on any document, if uid is
+	 * empty), so the supervisor can recover the document if the worker
+	 * dies.  retrying is true if the document has already failed once.
+	 * next() should call this as soon as it has locked a document,
+	 * since a worker may die while it is reading the document.  This
+	 * does nothing if there is no worker pool. */
+	void recordWorkerDocument(const std::string &uid, bool retrying=false);
+
+	/** Return the number of worker processes (see processQueue()). */
+	int getNumWorkers() const { return _num_workers; }
+
 	//======================================================================
 	// Abstract methods that subclasses must implement
 	//======================================================================
@@ -113,8 +167,13 @@ protected:
 
 	/** Record the amount of time spent working, waiting for new input
 	 * files, and blocking because the destination location is
-	 * full. */
-	virtual void saveTimers(double workTime, double waitTime, double blockTime, double overheadTime, size_t numDocs) = 0;
+	 * full; and the average and maximum time that documents spent in
+	 * the source location before we started working on them (for the
+	 * documents whose queuedTime is known).  In a worker pool, each
+	 * worker calls this with its own times (after setWorkerId()), and
+	 * the supervisor calls it with the totals for all workers. */
+	virtual void saveTimers(double workTime, double waitTime, double blockTime, double overheadTime, size_t numDocs,
+		double avgQueueLatency, double maxQueueLatency) = 0;
 
 protected:
 	boost::scoped_ptr<DocumentReader> _docReader;
@@ -123,6 +182,31 @@ protected:
 
 private:
 	std::string _sourceFormat;
+
+	/** Run the queue in this process (see processQueue()). */
+	void runQueue();
+
+	//======================================================================
+	// Worker pool
+	//======================================================================
+	struct WorkerStatus;
+
+	void runWorkerPool();
+	int startWorker(int worker_id);
+	void saveWorkerPoolTimers(const WorkerStatus &retired);
+
+	/** Number of worker processes (from queue_driver_workers). */
+	int _num_workers;
+
+	/** In a worker pool, the status of each worker, in memory that is
+	 * shared by all processes; or NULL if there is no worker pool. */
+	WorkerStatus *_workerStatus;
+
+	/** In a worker process, its id; otherwise, -1. */
+	int _workerId;
+
+	/** The documents that have crashed a worker. */
+	std::set<std::string> _crashedDocuments;
 	
 private:
 	struct Factory { virtual QueueDriver *build() = 0; };
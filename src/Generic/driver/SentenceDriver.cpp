@@ -5,9 +5,13 @@
 
 #include "Generic/common/limits.h"
 #include "Generic/common/SessionLogger.h"
+#include "Generic/common/NullSessionLogger.h"
+#include "Generic/common/UnexpectedInputException.h"
+#include "Generic/common/InternalInconsistencyException.h"
 #include "Generic/common/HeapChecker.h"
 #include "Generic/common/OutputUtil.h"
 #include "Generic/common/ParamReader.h"
+#include "Generic/common/Profiler.h"
 #include "Generic/driver/SentenceDriver.h"
 #include "Generic/driver/DocumentDriver.h"
 #include "Generic/driver/SessionProgram.h"
@@ -60,6 +64,11 @@
 #include "Generic/theories/EventMentionSet.h"
 
 #include "boost/date_time/posix_time/posix_time.hpp"
+#include <boost/bind.hpp>
+#include <boost/foreach.hpp>
+#include <boost/make_shared.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/thread.hpp>
 
 #include "dynamic_includes/common/ProfilingDefinition.h"
 
@@ -138,7 +147,9 @@ SentenceDriver::SentenceDriver()
 	  _use_sentence_level_event_finding(false),
       _use_npchunker_constraints(false),
 	  _do_morph_selection(false),
-	  _use_lexicon_file(false)
+	  _use_lexicon_file(false),
+	  _n_sentence_threads(1),
+	  _is_worker(false)
 
 {
 	initIntentionalFailures();
@@ -169,6 +180,13 @@ SentenceDriver::SentenceDriver()
 	// Perform all stage-specific initializations
 	_use_npchunker_constraints = ParamReader::getOptionalTrueFalseParamWithDefaultVal("use_npchunker_constraints", false);
 
+	_n_sentence_threads = ParamReader::getOptionalIntParamWithDefaultValue("sentence_level_threads", 1);
+	if (_n_sentence_threads < 1)
+		throw UnexpectedInputException("SentenceDriver::SentenceDriver()",
+			"The sentence_level_threads parameter must be at least 1.");
+	if (_n_sentence_threads > 1)
+		DocumentDriver::checkMultithreadedSettings("sentence_level_threads");
+
 	// Create timers
 	for (Stage stage=Stage::getStartStage(); stage<Stage::getEndStage(); ++stage) {
 		stageLoadTimer[stage] = GenericTimer();
@@ -212,6 +230,8 @@ void SentenceDriver::loadModelsForStage(Stage stage)
 	try {
 		cout << "Initializing Stage " << stage.getSequenceNumber() 
 			<< " (" << stage.getName() << ")..." << std::endl;
+		Profiler::Scope loadScope("load");
+		Profiler::Scope stageScope(stage.getName());
 		stageLoadTimer[stage].startTimer();
 
 		if (stage == _tokens_Stage) loadTokenizerModels();
@@ -338,7 +358,9 @@ void SentenceDriver::loadRelationModels() {
 SentenceDriver::~SentenceDriver() {
 	if (_sessionProgram != 0)
 		endBatch();
-	if (_parser != 0) {
+	// Each worker's parser has its own caches, which are discarded; only the
+	// sentence driver that created the workers writes its caches to disk.
+	if (_parser != 0 && !_is_worker) {
         _parser->writeCaches();
 	}
 	delete _tokenizer;
@@ -434,7 +456,8 @@ void SentenceDriver::beginBatch(const SessionProgram *sessionProgram, SessionLog
 		_morphAnalysis = MorphologicalAnalyzer::build();
 
 	// Initialize any state savers we'll be using
-	makeNewStateSavers();
+	if (!_is_worker)
+		makeNewStateSavers();
 
 	// Load any models that we'll need to process this batch.
 	if (!(ParamReader::getOptionalTrueFalseParamWithDefaultVal("use_lazy_model_loading", false))) {
@@ -446,8 +469,26 @@ void SentenceDriver::beginBatch(const SessionProgram *sessionProgram, SessionLog
 		}
 	}
 
+	// Create the workers used to run sentence-level stages in parallel.  
+	// Each one loads its own models, one worker at a time.
+	if (!_is_worker) {
+		for (int i = 1; i < _n_sentence_threads; i++) {
+			SentenceDriver *worker = createWorker();
+			if (worker == 0) {
+				SessionLogger::warn("sentence_level_threads") 
+					<< "This sentence driver can not process sentences in parallel;"
+					<< " ignoring the sentence_level_threads parameter.";
+				break;
+			}
+			worker->_is_worker = true;
+			_workers.push_back(worker);
+			_workerSessionLoggers.push_back(_new NullSessionLogger());
+			worker->beginBatch(sessionProgram, _workerSessionLoggers.back(), 0, false);
+		}
+	}
+
 	//Now read in extra lexical info if needed
-	if ((Stage("tokens") < _sessionProgram->getStartStage())) {
+	if (!_is_worker && (Stage("tokens") < _sessionProgram->getStartStage())) {
         _morphAnalysis->resetDictionary(); // RPB: Distillation can run multiple batches, so we need to start with a clean slate
 		//read in the extra dictionary
 		if (_use_lexicon_file) {
@@ -475,6 +516,13 @@ void SentenceDriver::endBatch() {
 	delete _stateLoader;
 	_stateLoader = 0;
 
+	BOOST_FOREACH(SentenceDriver *worker, _workers)
+		delete worker;
+	_workers.clear();
+	BOOST_FOREACH(SessionLogger *workerSessionLogger, _workerSessionLoggers)
+		delete workerSessionLogger;
+	_workerSessionLoggers.clear();
+
 	clearStageStateSavers();
 
 	//save the new lexicon here,
@@ -524,11 +572,22 @@ void SentenceDriver::beginDocument(DocTheory *docTheory) {
 		_metonymyAdder->resetForNewDocument(docTheory);
 	if (_dummyReferenceResolver != 0)
 		_dummyReferenceResolver->resetForNewDocument(docTheory);
-	if(_mtResultSaver != 0 && _sessionProgram->hasExperimentDir())
+	if(_mtResultSaver != 0 && _sessionProgram->hasExperimentDir() && !_is_worker)
 		_mtResultSaver->resetForNewDocument(docTheory, _sessionProgram->getOutputDir());
+
+	BOOST_FOREACH(SentenceDriver *worker, _workers)
+		worker->beginDocument(docTheory);
 }
 
 void SentenceDriver::endDocument() {
+	BOOST_FOREACH(SentenceDriver *worker, _workers)
+		worker->endDocument();
+	if (_is_worker) {
+		if (_nameRecognizer != 0)
+			_nameRecognizer->cleanUpAfterDocument();
+		return;
+	}
+
 	_n_docs_processed++;
 
 	//mrf -8-04, allow dictionary reset to prevent memory problems
@@ -602,14 +661,7 @@ SentenceTheoryBeam *SentenceDriver::run(DocTheory *docTheory, int sent_no,
 
 	const Sentence* sentence = docTheory->getSentence(sent_no);
 
-	if (_n_docs_processed < MAX_INTENTIONAL_FAILURES &&
-		_intentional_failures[_n_docs_processed])
-	{
-		_n_docs_processed++; // because endDocument() gets no chance to
-		throw UnexpectedInputException(
-			"SentenceDriver::run()",
-			"Skipping prespecified document");
-	}
+	checkIntentionalFailure();
 
 	SentenceTheoryBeam *currentBeam = docTheory->getSentenceTheoryBeam(sent_no);
 
@@ -632,6 +684,7 @@ SentenceTheoryBeam *SentenceDriver::run(DocTheory *docTheory, int sent_no,
 			continue;
 
 		_sessionLogger->updateLocalContext(STAGE_CONTEXT, stage.getName());
+		Profiler::Scope stageScope(stage.getName());
 
 		char source[100];
 		sprintf(source, "SentenceDriver::run(); before stage %s",
@@ -1011,6 +1064,190 @@ SentenceTheoryBeam *SentenceDriver::run(DocTheory *docTheory, int sent_no,
 	return currentBeam;
 }
 
+void SentenceDriver::checkIntentionalFailure() {
+	if (_n_docs_processed < MAX_INTENTIONAL_FAILURES &&
+		_intentional_failures[_n_docs_processed])
+	{
+		_n_docs_processed++; // because endDocument() gets no chance to
+		throw UnexpectedInputException(
+			"SentenceDriver::run()",
+			"Skipping prespecified document");
+	}
+}
+
+SentenceDriver *SentenceDriver::createWorker() {
+	return _new SentenceDriver();
+}
+
+bool SentenceDriver::isParallelStage(Stage stage) {
+	// Tokenization may add words to the session lexicon, which is shared
+	// by all sentence drivers.
+	if (stage == _tokens_Stage)
+		return false;
+	// The stages after parse keep state in unlocked statics:
+	//  - npchunk: EnglishNPChunkFinder fills static tag sets on first use.
+	//  - dependency-parse: DependencyParser changes the process's current
+	//    directory around each call to the external parser.
+	//  - mentions: EnglishNodeInfo and EnglishCompoundMentionFinder read
+	//    their parameters into statics on first use.
+	//  - props: EnglishSemTreeBuilder and EnglishLinearPropositionFinder
+	//    keep their verb lists and settings in statics.
+	// Actor matching, entities, events, and relations also depend on the
+	// results for earlier sentences.  (The parser itself allocates
+	// ParseNodes from a per-thread free list in thread-safe builds.)
+	if (stage > _parse_Stage)
+		return false;
+	// Saved state and MT results must be written one sentence at a time,
+	// in order.
+	if (getStageStateSaver(stage) != 0)
+		return false;
+	if (stage == _parse_Stage && _mtResultSaver != 0)
+		return false;
+	return true;
+}
+
+namespace {
+	/** The sentences of a document that are being processed by 
+	  * SentenceDriver::runParallel().  Each thread repeatedly takes the
+	  * next unprocessed sentence, until there are none left or until some
+	  * sentence fails. */
+	class ParallelSentenceQueue {
+	public:
+		ParallelSentenceQueue(DocTheory *docTheory, Stage startStage, Stage endStage, bool prune_finished_beams)
+			: _docTheory(docTheory), _startStage(startStage), _endStage(endStage),
+			  _prune_finished_beams(prune_finished_beams),
+			  _profilerContext(Profiler::getCurrentContext()), _next_sent_no(0), _failed_sent_no(-1) {}
+
+		/** Process sentences using the given sentence driver. */
+		void run(SentenceDriver *sentenceDriver) {
+			// Profile this thread's stages under the document that we're processing.
+			Profiler::ThreadContext profilerContext(_profilerContext);
+			int sent_no;
+			while ((sent_no = nextSentence()) >= 0) {
+				try {
+					SentenceTheoryBeam *beam = sentenceDriver->run(_docTheory, sent_no, _startStage, _endStage);
+					if (_prune_finished_beams && beam != 0)
+						beam->pruneToBestTheory();
+				} catch (UnexpectedInputException &e) {
+					reportError(sent_no, boost::make_shared<UnexpectedInputException>(e), 
+						boost::shared_ptr<UnrecoverableException>());
+				} catch (UnrecoverableException &e) {
+					reportError(sent_no, boost::shared_ptr<UnexpectedInputException>(),
+						boost::make_shared<UnrecoverableException>(e));
+				} catch (std::exception &e) {
+					reportError(sent_no, boost::shared_ptr<UnexpectedInputException>(),
+						boost::make_shared<UnrecoverableException>("SentenceDriver::runParallel()", e.what()));
+				} catch (...) {
+					reportError(sent_no, boost::shared_ptr<UnexpectedInputException>(),
+						boost::make_shared<UnrecoverableException>("SentenceDriver::runParallel()", "Unknown exception"));
+				}
+			}
+		}
+
+		/** If any sentence failed, then rethrow the exception raised by the 
+		  * first such sentence.  This should only be called once all threads
+		  * are finished. */
+		void rethrowError() {
+			if (_unexpectedInputError)
+				throw *_unexpectedInputError;
+			if (_unrecoverableError)
+				throw *_unrecoverableError;
+		}
+
+	private:
+		DocTheory *_docTheory;
+		Stage _startStage;
+		Stage _endStage;
+		bool _prune_finished_beams;
+		Profiler::Context _profilerContext;
+
+		boost::mutex _mutex;
+		int _next_sent_no;
+		int _failed_sent_no;
+		boost::shared_ptr<UnexpectedInputException> _unexpectedInputError;
+		boost::shared_ptr<UnrecoverableException> _unrecoverableError;
+
+		int nextSentence() {
+			boost::mutex::scoped_lock lock(_mutex);
+			if (_failed_sent_no >= 0 || _next_sent_no >= _docTheory->getNSentences())
+				return -1;
+			return _next_sent_no++;
+		}
+
+		// Sentences are handed out in order, so every sentence before the 
+		// first one to fail has been (or is being) processed; keeping the
+		// error from the lowest-numbered sentence gives the same error that
+		// sequential processing would.
+		void reportError(int sent_no, boost::shared_ptr<UnexpectedInputException> unexpectedInputError,
+		                 boost::shared_ptr<UnrecoverableException> unrecoverableError) 
+		{
+			boost::mutex::scoped_lock lock(_mutex);
+			if (_failed_sent_no < 0 || sent_no < _failed_sent_no) {
+				_failed_sent_no = sent_no;
+				_unexpectedInputError = unexpectedInputError;
+				_unrecoverableError = unrecoverableError;
+			}
+		}
+	};
+}
+
+Stage SentenceDriver::runParallel(DocTheory *docTheory, Stage startStage, Stage endStage, bool prune_finished_beams) {
+	// A sentence can only be finished here if the document goes on past
+	// the sentence-level stages.
+	if (endStage <= Stage::getLastSentenceLevelStage())
+		prune_finished_beams = false;
+	// limit stage range to sentence-level stages
+	if (startStage < _tokens_Stage)
+		startStage = _tokens_Stage;
+	if (Stage::getLastSentenceLevelStage() < endStage)
+		endStage = Stage::getLastSentenceLevelStage();
+	if (_workers.empty() || endStage < startStage)
+		return startStage;
+
+	checkIntentionalFailure();
+
+	// Tokenization can't be run in parallel, but since the stages that 
+	// follow it don't depend on earlier sentences, it's safe to tokenize
+	// every sentence before running them.
+	if (startStage == _tokens_Stage && _sessionProgram->includeStage(_tokens_Stage)) {
+		for (int sent_no = 0; sent_no < docTheory->getNSentences(); sent_no++)
+			run(docTheory, sent_no, _tokens_Stage, _tokens_Stage);
+		++startStage;
+	}
+
+	// Find the stages that we can run in parallel.
+	Stage parallelEndStage = startStage;
+	--parallelEndStage;
+	for (Stage stage = startStage; stage <= endStage; ++stage) {
+		if (_sessionProgram->includeStage(stage) && !isParallelStage(stage))
+			break;
+		parallelEndStage = stage;
+	}
+	if (parallelEndStage < startStage)
+		return startStage;
+
+	// Make sure all models are loaded before starting any threads, since 
+	// model loading is not thread-safe.
+	for (Stage stage = startStage; stage <= parallelEndStage; ++stage) {
+		if (_sessionProgram->includeStage(stage)) {
+			loadModelsForStage(stage);
+			BOOST_FOREACH(SentenceDriver *worker, _workers)
+				worker->loadModelsForStage(stage);
+		}
+	}
+
+	ParallelSentenceQueue queue(docTheory, startStage, parallelEndStage,
+		prune_finished_beams && parallelEndStage == endStage);
+	boost::thread_group threads;
+	BOOST_FOREACH(SentenceDriver *worker, _workers)
+		threads.create_thread(boost::bind(&ParallelSentenceQueue::run, &queue, worker));
+	queue.run(this);
+	threads.join_all();
+	queue.rethrowError();
+
+	return parallelEndStage.getNextStage();
+}
+
 /** This populates nextBeam with new theories based on currentTheory, plus
   * one of the subtheories specified in newSubtheories.
   * subtheoryType gives the type of those subtheories, and n_new_subtheories
@@ -1180,16 +1417,14 @@ void SentenceDriver::resetStateSavers( const wchar_t * document_name ){
 			wstring state_file = _sessionProgram->constructSingleDocumentStateFile(
 											document_name, stage);
 			delete _stageStateSavers[stage];
-			_stageStateSavers[stage] = _new StateSaver(state_file.c_str(), 
-				ParamReader::isParamTrue("binary_state_files"));
+			_stageStateSavers[stage] = _new StateSaver(state_file.c_str());
 			
 		} else {
 			// set only once
 			if(_stageStateSavers[stage]) continue;
 			
 			_stageStateSavers[stage] = _new StateSaver(
-				_sessionProgram->getStateFileForStage(stage),
-				ParamReader::isParamTrue("binary_state_files"));
+				_sessionProgram->getStateFileForStage(stage));
 		}
 	}
 }
@@ -1201,6 +1436,16 @@ void SentenceDriver::cleanup() {
 	if (_relationFinder) {
 		_relationFinder->cleanup();
 	}
+	releaseSentenceCaches();
+}
+
+void SentenceDriver::releaseSentenceCaches() {
+	if (_nameRecognizer)
+		_nameRecognizer->releaseSentenceCaches();
+	if (_valueRecognizer)
+		_valueRecognizer->releaseSentenceCaches();
+	BOOST_FOREACH(SentenceDriver *worker, _workers)
+		worker->releaseSentenceCaches();
 }
 
 void SentenceDriver::logTrace() {
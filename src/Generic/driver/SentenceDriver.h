@@ -10,6 +10,8 @@
 #include "dynamic_includes/common/ProfilingDefinition.h"
 #include "Generic/common/GenericTimer.h"
 
+#include <vector>
+
 class SessionProgram;
 class DocumentDriver;
 class SentenceTheoryBeam;
@@ -49,6 +51,13 @@ class ActorMentionFinder;
   *
   * In principle you can do multiple batches but this is untested.
   *
+  * If the parameter "sentence_level_threads" is greater than one, then
+  * beginBatch() creates that many minus one "worker" sentence drivers,
+  * each with its own copy of the sentence-level models, and runParallel()
+  * can be used to process different sentences of a document at the same
+  * time.  (Note that this multiplies the memory used by sentence-level
+  * models.)  Only the stages up to and including "parse" are run in
+  * parallel; see isParallelStage().
   */
 
 class SentenceDriver {
@@ -81,6 +90,26 @@ public:
 	SentenceTheory *run(DocTheory *docTheory, int sent_no,
 						const Sentence *sentence);
 	virtual SentenceTheoryBeam *run(DocTheory *docTheory, int sent_no, Stage startStage, Stage endStage);
+
+	/** Return true if this sentence driver has worker sentence drivers,
+	  * which can be used by runParallel(). */
+	bool usesParallelSentences() const { return !_workers.empty(); }
+
+	/** Run sentence-level stages for all sentences in the given document,
+	  * starting with startStage, using this sentence driver and its workers
+	  * to process several sentences at once.  Processing stops before the
+	  * first stage that can not be run in parallel (e.g., because its 
+	  * output depends on earlier sentences or because its state is being
+	  * saved), or after endStage.  Return the first stage that still needs
+	  * to be run for each sentence, using run().
+	  *
+	  * The result for each sentence is identical to the result that would
+	  * be produced by running its stages sequentially.
+	  *
+	  * If prune_finished_beams is true, then each sentence that finishes
+	  * every sentence-level stage here has its beam pruned to its best
+	  * theory (see SentenceTheoryBeam::pruneToBestTheory()). */
+	Stage runParallel(DocTheory *docTheory, Stage startStage, Stage endStage, bool prune_finished_beams=false);
 	void setMaxParserSeconds(int maxsecs);
 	StateSaver *getStageStateSaver(Stage stage);
 
@@ -97,6 +126,11 @@ public:
 	void makeNewStateSavers();
 	void cleanup();
 
+	/** Free the per-token feature caches that the name and value
+	  * recognizers (of this driver and its workers) keep from the most
+	  * recent sentence.  This is also done by cleanup(). */
+	void releaseSentenceCaches();
+
 	/** Use state-loader to load a beam state from disk. */
 	SentenceTheoryBeam *loadBeamState(Stage stage,
 									  int sent_no,
@@ -297,6 +331,32 @@ protected:
 
 	void clearStageStateSavers();
 
+	/** Return a new sentence driver of the same type as this one, to be used
+	  * as a worker by runParallel(); or NULL if this type of sentence driver
+	  * can not process sentences in parallel. */
+	virtual SentenceDriver *createWorker();
+
+	/** Return true if the given stage may be run for different sentences
+	  * at the same time. */
+	bool isParallelStage(Stage stage);
+
+	/** Throw an exception if the current document has been selected for an
+	  * intentional failure. */
+	void checkIntentionalFailure();
+
+	// Number of threads used to run sentence-level stages (including the
+	// thread that calls runParallel()).
+	int _n_sentence_threads;
+
+	// Worker sentence drivers and their session loggers.  These are created
+	// by beginBatch() and deleted by endBatch().
+	std::vector<SentenceDriver*> _workers;
+	std::vector<SessionLogger*> _workerSessionLoggers;
+
+	// True if this sentence driver is a worker for some other sentence
+	// driver.  Workers never save state or update the lexicon file.
+	bool _is_worker;
+
 public:
 	mutable Stage::HashMap<GenericTimer> stageLoadTimer;
 	mutable Stage::HashMap<GenericTimer> stageProcessTimer;
@@ -325,6 +325,8 @@ void DTCorefTrainer::train() {
 			_mode = MaxEntModel::GIS;
 		else if (param_mode == "SCGIS")
 			_mode = MaxEntModel::SCGIS;
+		else if (param_mode == "LBFGS" && MaxEntModel::hasGradientOptimizer())
+			_mode = MaxEntModel::LBFGS;
 		else
 			throw UnexpectedInputException("DTCorefTrainer::train()",
 							"Invalid setting for parameter 'maxent_trainer_mode'");
@@ -7,6 +7,7 @@
 #include "Generic/common/UTF8InputStream.h"
 #include "Generic/common/UTF8Token.h"
 #include "Generic/common/ParamReader.h"
+#include "Generic/common/UnexpectedInputException.h"
 #include "Generic/maxent/MaxEntModel.h"
 #include "Generic/maxent/MaxEntEventSet.h"
 #include "Generic/discTagger/DTTagSet.h"
@@ -16,7 +17,10 @@
 #include <math.h>
 #include <time.h>
 #include <set>
+#include <limits>
 #include "boost/algorithm/string/replace.hpp"
+#include <boost/bind.hpp>
+#include <boost/thread.hpp>
 
 #ifndef _LOG_OF_ZERO
 #define _LOG_OF_ZERO -10000
@@ -49,6 +53,15 @@ MaxEntModel::MaxEntModel(DTTagSet *tagSet, DTFeatureTypeSet *featureTypes,
 	_heldOutEvents = _new MaxEntEventSet(tagSet, featureTypes, false, held_out_vector_file);
 
 	_n_events_added = 0;
+
+	_n_threads = ParamReader::getOptionalIntParamWithDefaultValue("maxent_trainer_threads", 1);
+	if (_n_threads < 1)
+		_n_threads = 1;
+}
+
+boost::shared_ptr<MaxEntGradientOptimizer> &MaxEntModel::_gradientOptimizer() {
+	static boost::shared_ptr<MaxEntGradientOptimizer> optimizer;
+	return optimizer;
 }
 
 MaxEntModel::~MaxEntModel() {
@@ -241,6 +254,8 @@ void MaxEntModel::deriveModel(int pruning_threshold, bool const continuous_train
 		deriveModelGIS(pruning_threshold, continuous_training);
 	else if (_trainMode == SCGIS)
 		deriveModelSCGIS(pruning_threshold, continuous_training);
+	else if (_trainMode == LBFGS)
+		deriveModelLBFGS(pruning_threshold, continuous_training);
 }
 
 void MaxEntModel::deriveModelGIS(int pruning_threshold, bool const continuous_training) { 
@@ -263,49 +278,11 @@ void MaxEntModel::deriveModelGIS(int pruning_threshold, bool const continuous_tr
 	}
 
 	// Initialize data structures for training
-	_s = _new double [_tagSet->getNTags()];
-	_matrix = _new MatrixBlock*[_n_observations];
-	_obsCount = _new int[_n_observations];
-	_tagCount = _new int[_n_observations];
 	_observed = _new double[_n_features];
 	_expected = _new double[_n_features];
 	_logAlphas = _new double[_n_features];
-	
-
-	// Store data in sparse matrix for faster lookup:
-	// Each observation o has a linked list of linked lists containing 
-	// features active in o, indexed by their tags (outcomes).
-	ObsIter oIter = _observedEvents->observationIter();
-	for (int i = 0; i < _n_observations; i++) {
-		ObservationInfo *info = oIter.findNext();
-		_obsCount[i] = info->getTotalCount();
-		_tagCount[i] = 0;
-		_matrix[i] = 0;
-
-		for (int j = 0; j < info->getNFeatures(); j++) {
-			DTFeature *feature = info->getFeature(j);
-			int id = _observedEvents->getFeatureID(feature);
-			int tag = _tagSet->getTagIndex(feature->getTag());
-			// if feature exists in table, create a new feature block for id
-			if (id != -1) {
-				//search for this tag
-				MatrixBlock *t_block = _matrix[i];
-				while (t_block != 0 && t_block->id != tag)
-					t_block = t_block->next;
-				// if tag block doesn't exist, create a new tag block
-				if (t_block == 0) {
-					t_block = _new MatrixBlock(tag);
-					t_block->next = _matrix[i];
-					_matrix[i] = t_block;
-					_tagCount[i]++;
-				}
-				// insert feature block id into tag's children
-				MatrixBlock *f_block = _new MatrixBlock(id);
-				f_block->next = t_block->child;
-				t_block->child = f_block;
-			}
-		}
-	}
+	buildObservationMatrix();
+	allocateThreadBuffers();
 	
 	// initialize observed feature probs, log alphas and expectation
 	MaxEntEventSet::FeatureIter fIter = _observedEvents->featureIterBegin();
@@ -332,35 +309,9 @@ void MaxEntModel::deriveModelGIS(int pruning_threshold, bool const continuous_tr
 		//	_expected[a] = 0;
 		//}
 
-	
-		for (int j = 0; j < _n_observations; j++) {
-			// initialize Z with 0 weight for each tag without any features
-			double Z = _tagSet->getNTags() - _tagCount[j]; 
-			// calculate outcome probs
-			MatrixBlock *tag = _matrix[j];
-			while (tag != 0) {
-				_s[tag->id] = 0;
-				MatrixBlock *feat = tag->child;
-				while (feat != 0) {
-					_s[tag->id] += _logAlphas[feat->id];
-					feat = feat->next;
-				}
-				Z += exp(_s[tag->id]);
-				tag = tag->next;
-			}
-			// calculate expected feature probs
-			tag = _matrix[j];
-			while (tag != 0) {
-				MatrixBlock *feat = tag->child;
-				double predicted = exp(_s[tag->id]) / Z;
-				while (feat != 0) {
-					_expected[feat->id] += (double)_obsCount[j] * predicted;
-					feat = feat->next; 
-				}
-				tag = tag->next;
-			}
-			
-		}
+		// calculate expected feature probs
+		forEachPartition(_n_observations, boost::bind(&MaxEntModel::accumulateExpectedGIS, this, _1, _2, _3));
+		reduceThreadExpected();
 
 
 		// update alphas 
@@ -478,6 +429,57 @@ void MaxEntModel::deriveModelGIS(int pruning_threshold, bool const continuous_tr
 	}
 
 	// clean up data structures
+	deleteObservationMatrix();
+	freeThreadBuffers();
+	delete [] _expected;
+	delete [] _logAlphas;
+	delete [] _observed;
+}
+
+void MaxEntModel::buildObservationMatrix() {
+	_matrix = _new MatrixBlock*[_n_observations];
+	_obsCount = _new int[_n_observations];
+	_tagCount = _new int[_n_observations];
+	_observationInfo.resize(_n_observations);
+
+	// Store data in sparse matrix for faster lookup:
+	// Each observation o has a linked list of linked lists containing 
+	// features active in o, indexed by their tags (outcomes).
+	ObsIter oIter = _observedEvents->observationIter();
+	for (int i = 0; i < _n_observations; i++) {
+		ObservationInfo *info = oIter.findNext();
+		_observationInfo[i] = info;
+		_obsCount[i] = info->getTotalCount();
+		_tagCount[i] = 0;
+		_matrix[i] = 0;
+
+		for (int j = 0; j < info->getNFeatures(); j++) {
+			DTFeature *feature = info->getFeature(j);
+			int id = _observedEvents->getFeatureID(feature);
+			int tag = _tagSet->getTagIndex(feature->getTag());
+			// if feature exists in table, create a new feature block for id
+			if (id != -1) {
+				//search for this tag
+				MatrixBlock *t_block = _matrix[i];
+				while (t_block != 0 && t_block->id != tag)
+					t_block = t_block->next;
+				// if tag block doesn't exist, create a new tag block
+				if (t_block == 0) {
+					t_block = _new MatrixBlock(tag);
+					t_block->next = _matrix[i];
+					_matrix[i] = t_block;
+					_tagCount[i]++;
+				}
+				// insert feature block id into tag's children
+				MatrixBlock *f_block = _new MatrixBlock(id);
+				f_block->next = t_block->child;
+				t_block->child = f_block;
+			}
+		}
+	}
+}
+
+void MaxEntModel::deleteObservationMatrix() {
 	for (int k = 0; k < _n_observations; k++) {
 		MatrixBlock *tag_ptr = _matrix[k];
 		MatrixBlock *last_tag;
@@ -494,14 +496,250 @@ void MaxEntModel::deriveModelGIS(int pruning_threshold, bool const continuous_tr
 			delete last_tag;
 		}
 	}
-	
-	delete [] _expected;
-	delete [] _logAlphas;
-	delete [] _observed;
 	delete [] _tagCount;
 	delete [] _obsCount;
 	delete [] _matrix;
-	delete [] _s;
+	std::vector<ObservationInfo*>().swap(_observationInfo);
+}
+
+void MaxEntModel::allocateThreadBuffers() {
+	if (_n_threads > 1)
+		SessionLogger::info("SERIF") << "Using " << _n_threads << " training threads.\n";
+	_threadExpected.assign(_n_threads, std::vector<double>(_n_features, 0));
+	_threadScores.assign(_n_threads, std::vector<double>(_tagSet->getNTags(), 0));
+	_threadLogLikelihood.assign(_n_threads, 0);
+}
+
+void MaxEntModel::freeThreadBuffers() {
+	std::vector<std::vector<double> >().swap(_threadExpected);
+	std::vector<std::vector<double> >().swap(_threadScores);
+	std::vector<double>().swap(_threadLogLikelihood);
+}
+
+// Split the items [0, n_items) into one contiguous range per thread, and call
+// work(thread, start, end) for each range, in parallel.  With one thread, work
+// is called directly.
+void MaxEntModel::forEachPartition(int n_items, const boost::function<void (int, int, int)> &work) {
+	int n_threads = std::min(_n_threads, std::max(n_items, 1));
+	if (n_threads == 1) {
+		work(0, 0, n_items);
+		return;
+	}
+	boost::thread_group threads;
+	for (int t = 0; t < n_threads; t++) {
+		int start = static_cast<int>(static_cast<double>(n_items) * t / n_threads);
+		int end = static_cast<int>(static_cast<double>(n_items) * (t + 1) / n_threads);
+		threads.create_thread(boost::bind(work, t, start, end));
+	}
+	threads.join_all();
+}
+
+// Add the expected feature counts for observations [start, end) under the
+// current model to the given thread's accumulator.
+void MaxEntModel::accumulateExpectedGIS(int thread, int start, int end) {
+	double *s = &_threadScores[thread][0];
+	double *expected = &_threadExpected[thread][0];
+	for (int j = start; j < end; j++) {
+		// initialize Z with 0 weight for each tag without any features
+		double Z = _tagSet->getNTags() - _tagCount[j]; 
+		// calculate outcome probs
+		MatrixBlock *tag = _matrix[j];
+		while (tag != 0) {
+			s[tag->id] = 0;
+			MatrixBlock *feat = tag->child;
+			while (feat != 0) {
+				s[tag->id] += _logAlphas[feat->id];
+				feat = feat->next;
+			}
+			Z += exp(s[tag->id]);
+			tag = tag->next;
+		}
+		// calculate expected feature probs
+		tag = _matrix[j];
+		while (tag != 0) {
+			MatrixBlock *feat = tag->child;
+			double predicted = exp(s[tag->id]) / Z;
+			while (feat != 0) {
+				expected[feat->id] += (double)_obsCount[j] * predicted;
+				feat = feat->next; 
+			}
+			tag = tag->next;
+		}
+	}
+}
+
+// Like accumulateExpectedGIS, but scale scores to avoid overflow (LBFGS does
+// not keep the weights small), and also add the negative log likelihood of
+// observations [start, end) to the thread's total.
+void MaxEntModel::accumulateExpectedLBFGS(int thread, int start, int end) {
+	int n_tags = _tagSet->getNTags();
+	double *s = &_threadScores[thread][0];
+	double *expected = &_threadExpected[thread][0];
+	double neg_log_likelihood = 0;
+	for (int j = start; j < end; j++) {
+		for (int t = 0; t < n_tags; t++)
+			s[t] = 0;
+		MatrixBlock *tag = _matrix[j];
+		while (tag != 0) {
+			MatrixBlock *feat = tag->child;
+			while (feat != 0) {
+				s[tag->id] += _logAlphas[feat->id];
+				feat = feat->next;
+			}
+			tag = tag->next;
+		}
+		double max = -std::numeric_limits<double>::max();
+		for (int t = 0; t < n_tags; t++) {
+			if (s[t] > max)
+				max = s[t];
+		}
+		double Z = 0;
+		for (int t = 0; t < n_tags; t++)
+			Z += exp(s[t] - max);
+		double log_Z = max + log(Z);
+		tag = _matrix[j];
+		while (tag != 0) {
+			MatrixBlock *feat = tag->child;
+			double predicted = exp(s[tag->id] - log_Z);
+			while (feat != 0) {
+				expected[feat->id] += (double)_obsCount[j] * predicted;
+				feat = feat->next; 
+			}
+			tag = tag->next;
+		}
+		ObservationInfo *info = _observationInfo[j];
+		for (int o = 0; o < info->getNOutcomes(); o++)
+			neg_log_likelihood -= info->getOutcomeCount(o) * (s[info->getOutcome(o)] - log_Z);
+	}
+	_threadLogLikelihood[thread] = neg_log_likelihood;
+}
+
+// Set _expected to the sum of the threads' accumulators, and reset them.
+void MaxEntModel::reduceThreadExpected() {
+	for (int f = 0; f < _n_features; f++) {
+		double total = 0;
+		for (int t = 0; t < _n_threads; t++) {
+			total += _threadExpected[t][f];
+			_threadExpected[t][f] = 0;
+		}
+		_expected[f] = total;
+	}
+}
+
+class MaxEntModel::LBFGSObjective: public MaxEntGradientOptimizer::Objective {
+public:
+	LBFGSObjective(MaxEntModel *model): _model(model) {}
+	int nParams() const { return _model->_n_features; }
+	double evaluate(const std::vector<double> &params, std::vector<double> &gradient) {
+		return _model->computeObjectiveLBFGS(params, gradient);
+	}
+private:
+	MaxEntModel *_model;
+};
+
+// Return the negative log likelihood of the training data (plus the Gaussian
+// prior, if any) for the weights in params, and set gradient to its gradient:
+// the expected minus the observed feature counts (plus params / variance).
+double MaxEntModel::computeObjectiveLBFGS(const std::vector<double> &params, std::vector<double> &gradient) {
+	std::copy(params.begin(), params.end(), _logAlphas);
+	for (int t = 0; t < _n_threads; t++)
+		_threadLogLikelihood[t] = 0;
+	forEachPartition(_n_observations, boost::bind(&MaxEntModel::accumulateExpectedLBFGS, this, _1, _2, _3));
+	reduceThreadExpected();
+
+	double objective = 0;
+	for (int t = 0; t < _n_threads; t++)
+		objective += _threadLogLikelihood[t];
+	for (int f = 0; f < _n_features; f++) {
+		gradient[f] = _expected[f] - _observed[f];
+		if (_variance != 0) {
+			objective += params[f] * params[f] / (2 * _variance);
+			gradient[f] += params[f] / _variance;
+		}
+	}
+	return objective;
+}
+
+void MaxEntModel::deriveModelLBFGS(int pruning_threshold, bool const continuous_training) { 
+	if (!hasGradientOptimizer())
+		throw UnexpectedInputException("MaxEntModel::deriveModelLBFGS()",
+			"LBFGS training is not supported by this program");
+
+	// Prune
+	_observedEvents->prune(pruning_threshold, _debugStream);
+
+	// Get Constants
+	_n_observations = _observedEvents->getNObservations();
+	_n_features = _observedEvents->getNFeatures();
+
+	if (DEBUG) {
+		_debugStream << _observedEvents->getNEvents() << " total training instances.\n";
+		_debugStream << _heldOutEvents->getNEvents() << " held out instances.\n";
+		_debugStream << _n_features << " total features after pruning.\n\n";
+	}
+
+	// Initialize data structures for training
+	_observed = _new double[_n_features];
+	_expected = _new double[_n_features];
+	_logAlphas = _new double[_n_features];
+	buildObservationMatrix();
+	allocateThreadBuffers();
+
+	// initialize observed feature counts and weights
+	std::vector<double> params(_n_features);
+	MaxEntEventSet::FeatureIter fIter = _observedEvents->featureIterBegin();
+	for (int f = 0; f < _n_features; f++) {
+		int id = (*fIter).first->getID();
+		_observed[id] = (*fIter).second;
+		params[id] = (continuous_training? *(*_weights)[(*fIter).first->getFeature()]: 0);
+		++fIter;
+	}
+
+	// Get start time
+	time_t start_time;
+	time(&start_time);
+
+	LBFGSObjective objective(this);
+	int iter = _gradientOptimizer()->optimize(objective, params, _max_iterations);
+	std::copy(params.begin(), params.end(), _logAlphas);
+
+	SessionLogger::info("SERIF") << iter << " iterations.\n";		
+	SessionLogger::info("SERIF") << "Done training\n";
+
+	// Report time
+	time_t end_time;
+	time(&end_time);
+	double total_time = difftime(end_time, start_time);
+	SessionLogger::info("SERIF") << "Elapsed time " << total_time << " seconds.\n";
+
+	// Build Weights Table
+	SessionLogger::info("SERIF") << "Building weights table...\n";
+	MaxEntEventSet::FeatureIter it = _observedEvents->featureIterBegin();
+	while (it != _observedEvents->featureIterEnd()) {
+		int id = _observedEvents->getFeatureID((*it).first->getFeature());
+		// gives _weights ownership of feature and sets value
+		*(*_weights)[(*it).first->getFeature()] = _logAlphas[id];
+		++it;
+	}
+
+	if (DEBUG) {
+		_debugStream << "*** After iteration " << iter << " ***\n";
+		double likelihood = findLogLikelihood(_observedEvents);
+		_debugStream << "Log likelihood of training data = " << likelihood << "\n";
+		likelihood = findLogLikelihood(_heldOutEvents);
+		_debugStream << "Log likelihood of held out data = " << likelihood << "\n";
+		double percent = findPercentCorrect(_observedEvents);
+		_debugStream << "Percent correct on training data = " << percent * 100 << "\n";
+		percent = findPercentCorrect(_heldOutEvents);
+		_debugStream << "Percent correct on held out data = " << percent * 100 << "\n";
+	}
+
+	// clean up data structures
+	deleteObservationMatrix();
+	freeThreadBuffers();
+	delete [] _logAlphas;
+	delete [] _expected;
+	delete [] _observed;
 }
 
 void MaxEntModel::deriveModelSCGIS(int pruning_threshold, bool const continuous_training) { 
@@ -833,12 +1071,31 @@ double MaxEntModel::newtonsMethodGaussianSCGIS(int id) {
 
 double MaxEntModel::findLogLikelihood(MaxEntEventSet *observations) {
 
+	std::vector<ObservationInfo*> infos(observations->getNObservations());
+	ObsIter oIter = observations->observationIter();
+	for (size_t i = 0; i < infos.size(); i++)
+		infos[i] = oIter.findNext();
+
+	std::vector<double> partial(_n_threads, 0);
+	forEachPartition(static_cast<int>(infos.size()), 
+		boost::bind(&MaxEntModel::addLogLikelihood, this, &infos, &partial, _1, _2, _3));
+
+	double log_likelihood = 0;
+	for (int t = 0; t < _n_threads; t++)
+		log_likelihood += partial[t];
+	return -log_likelihood;
+}
+
+// Subtract the log likelihood of observations [start, end) from the given
+// thread's partial sum.
+void MaxEntModel::addLogLikelihood(const std::vector<ObservationInfo*> *observations, std::vector<double> *partial, 
+								   int thread, int start, int end) 
+{
 	double log_likelihood = 0;
 	double *scores = _new double[_tagSet->getNTags()];
 
-	ObsIter oIter = observations->observationIter();
-	for (int i = 0; i < observations->getNObservations(); i++) {
-		ObservationInfo *info = oIter.findNext();
+	for (int i = start; i < end; i++) {
+		ObservationInfo *info = (*observations)[i];
 		double max = -1000;
 		for (int j = 0; j < _tagSet->getNTags(); j++) {
 			scores[j] = scoreStateDuringDerivation(info, j);
@@ -861,7 +1118,7 @@ double MaxEntModel::findLogLikelihood(MaxEntEventSet *observations) {
 
 	
 	delete [] scores;
-	return -log_likelihood;
+	(*partial)[thread] = log_likelihood;
 }
 
 double MaxEntModel::findPercentCorrect(MaxEntEventSet *observations) {
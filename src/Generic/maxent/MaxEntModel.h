@@ -5,6 +5,9 @@
 #define MAXENT_MODEL_H
 #include "Generic/common/DebugStream.h"
 #include "Generic/discTagger/DTFeature.h"
+#include <boost/function.hpp>
+#include <boost/shared_ptr.hpp>
+#include <vector>
 
 class DTTagSet;
 class DTFeatureTypeSet;
@@ -12,6 +15,29 @@ class DTObservation;
 class ObservationInfo;
 class DTState;
 class MaxEntEventSet;
+
+/** An unconstrained gradient-based optimizer, used by MaxEntModel's LBFGS
+  * training mode.  Generic does not link against an optimizer library, so
+  * programs that support LBFGS training install one with
+  * MaxEntModel::setGradientOptimizer() (see LBFGS-B/MaxEntLBFGSOptimizer.h). */
+class MaxEntGradientOptimizer {
+public:
+	/** A function to be minimized. */
+	class Objective {
+	public:
+		virtual ~Objective() {}
+		virtual int nParams() const = 0;
+		/** Return the value of the function at params, and set gradient
+		  * (which has nParams() elements) to its gradient there. */
+		virtual double evaluate(const std::vector<double> &params, std::vector<double> &gradient) = 0;
+	};
+
+	virtual ~MaxEntGradientOptimizer() {}
+
+	/** Minimize the given objective, starting from params (and leaving the
+	  * solution there).  Return the number of iterations performed. */
+	virtual int optimize(Objective &objective, std::vector<double> &params, int max_iterations) = 0;
+};
  
 class MatrixBlock {
 	public:
@@ -53,7 +79,12 @@ public:
 	void printDebugInfo(DTObservation *observation, int answer, DebugStream& debug);
 	void printDebugTable(DTObservation *observation, UTF8OutputStream& debug);
 
-	enum { GIS, SCGIS };
+	enum { GIS, SCGIS, LBFGS };
+
+	/** Set the optimizer used to derive models in LBFGS mode. */
+	static void setGradientOptimizer(boost::shared_ptr<MaxEntGradientOptimizer> optimizer) { _gradientOptimizer() = optimizer; }
+	static bool hasGradientOptimizer() { return _gradientOptimizer() != 0; }
+	static boost::shared_ptr<MaxEntGradientOptimizer> getGradientOptimizer() { return _gradientOptimizer(); }
 
 private:
 
@@ -76,6 +107,10 @@ private:
 	const double _min_likelihood_delta;
 	const double _variance;
 
+	// number of threads used to compute expectations during training (set
+	// by the maxent_trainer_threads parameter)
+	int _n_threads;
+
 	int _constantC;
 	double _inverseC;
 	//static const int LOG_OF_ZERO;
@@ -89,9 +124,16 @@ private:
 	MatrixBlock **_matrix;
 	int *_obsCount;
 
-	// GIS
-	double *_s;
+	// GIS and LBFGS
 	int *_tagCount;
+	std::vector<ObservationInfo*> _observationInfo;
+
+	// Per-thread accumulators.  Each thread handles a contiguous range of
+	// observations, and the accumulators are summed in thread order, so the
+	// results depend only on the number of threads.
+	std::vector<std::vector<double> > _threadExpected;
+	std::vector<std::vector<double> > _threadScores;
+	std::vector<double> _threadLogLikelihood;
 	
 	//  SCGIS
 	double **_S;
@@ -101,6 +143,25 @@ private:
 private:
 	void deriveModelGIS(int pruning_threshold, bool const continuous_training = false); 
 	void deriveModelSCGIS(int pruning_threshold, bool const continuous_training = false); 
+	void deriveModelLBFGS(int pruning_threshold, bool const continuous_training = false); 
+
+	// Observation-major sparse matrix, used by GIS and LBFGS
+	void buildObservationMatrix();
+	void deleteObservationMatrix();
+
+	void allocateThreadBuffers();
+	void freeThreadBuffers();
+	void forEachPartition(int n_items, const boost::function<void (int, int, int)> &work);
+	void accumulateExpectedGIS(int thread, int start, int end);
+	void accumulateExpectedLBFGS(int thread, int start, int end);
+	void reduceThreadExpected();
+	double computeObjectiveLBFGS(const std::vector<double> &params, std::vector<double> &gradient);
+	void addLogLikelihood(const std::vector<ObservationInfo*> *observations, std::vector<double> *partial, 
+		int thread, int start, int end);
+	class LBFGSObjective;
+	friend class LBFGSObjective;
+
+	static boost::shared_ptr<MaxEntGradientOptimizer> &_gradientOptimizer();
 
 	// WARNING: these functions should only be called during training
 	double newtonsMethodGaussianSCGIS(int id);
@@ -96,6 +96,12 @@ void DefaultNameRecognizer::resetForNewDocument(class DocTheory *docTheory)
 	}
 }
 
+void DefaultNameRecognizer::releaseSentenceCaches()
+{
+	if (_name_finder == PIDF_NAME_FINDER)
+		_pidfDecoder->releaseObservations();
+}
+
 void DefaultNameRecognizer::cleanUpAfterDocument()
 {
 	// copied from old name recognizer -- SRS
@@ -31,6 +31,7 @@ public:
 	void resetForNewSentence(const Sentence *sentence);
 	void resetForNewDocument(class DocTheory *doctheory);
 	void cleanUpAfterDocument();
+	void releaseSentenceCaches();
 	int getNameTheories(NameTheory **results, int max_theories, 
 								TokenSequence *tokenSequence);
 
@@ -25,6 +25,11 @@ public:
 	virtual void cleanUpAfterDocument() = 0;
 	virtual void resetForNewDocument(class DocTheory *docTheory = 0) = 0;
 
+	// Free any per-token feature caches that are kept from the most
+	// recent sentence.  Called once a document's sentences are finished,
+	// by streaming_doc_theory and when memory is low.
+	virtual void releaseSentenceCaches() {}
+
 	// This does the work. It populates an array of pointers to NameTheorys
 	// specified by results arg with up to max_theories NameTheory pointers,
 	// and returns the number of theories actually created, or 0 if
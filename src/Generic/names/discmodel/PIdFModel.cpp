@@ -5,6 +5,7 @@
 
 #include "Generic/common/limits.h"
 #include "Generic/common/ParamReader.h"
+#include "Generic/common/Profiler.h"
 #include "Generic/common/UnexpectedInputException.h"
 #include "Generic/common/InternalInconsistencyException.h"
 #include "Generic/common/UTF8InputStream.h"
@@ -488,6 +489,14 @@ void PIdFModel::resetForNewDocument(DocTheory *docTheory) {
 	}
 }
 
+void PIdFModel::releaseObservations() {
+	for (vector<DTObservation*>::iterator i = _observations.begin(); i != _observations.end(); ++i) {
+		delete *i;
+	}
+	// Swap with an empty vector to free its storage as well.
+	vector<DTObservation*>().swap(_observations);
+}
+
 /*
 decoding methods
 */
@@ -731,9 +740,16 @@ std::wstring PIdFModel::constrainedDecode(PIdFSentence &constraintSentence, DTTa
 void PIdFModel::decode(PIdFSentence &sentence) {
 	int tags[MAX_SENTENCE_TOKENS+2];
 
-	populateSentence(_observations, &sentence, _decoder == _lowerCaseDecoder);
-	_secondaryDecoders->AddDecoderResultsToObservation(_observations);
-	_decoder->decode(_observations, tags);
+	{
+		Profiler::Scope featureScope("pidf-features");
+		populateSentence(_observations, &sentence, _decoder == _lowerCaseDecoder);
+		_secondaryDecoders->AddDecoderResultsToObservation(_observations);
+	}
+	{
+		Profiler::Scope decodeScope("pidf-decode");
+		Profiler::count("tokens", sentence.getLength());
+		_decoder->decode(_observations, tags);
+	}
 
 	for (int k = 0; k < sentence.getLength(); k++)
 		sentence.setTag(k, tags[k+1]);
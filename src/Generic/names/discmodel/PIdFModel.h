@@ -185,6 +185,10 @@ public:
 						TokenSequence *tokenSequence);
 
 	void resetForNewDocument(DocTheory *docTheory = 0);
+
+	/** Delete the token observations (and their feature caches) that are
+	  * kept from the most recently decoded sentence. */
+	void releaseObservations();
 	
 	//void analyzeTraining(const char* testfile);
 	//Symbol getClusterSymbol(const wchar_t* pref, int c);
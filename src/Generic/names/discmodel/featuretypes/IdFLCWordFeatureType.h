@@ -35,6 +35,20 @@ public:
 		}
 	}
 
+	virtual int extractFeatureKeys(const DTState &state,
+								   DTFeatureKey *resultArray) const
+	{
+		TokenObservation *o = static_cast<TokenObservation*>(
+			state.getObservation(state.getIndex()));
+
+		if (PIdFFeatureType::isVocabWord(o->getSymbol())) {
+			resultArray[0].reset(this).add(o->getLCSymbol());
+			return 1;
+		} else {
+			return 0;
+		}
+	}
+
 };
 
 #endif
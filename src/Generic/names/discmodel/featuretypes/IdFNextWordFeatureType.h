@@ -39,6 +39,23 @@ public:
 		}
 	}
 
+	virtual int extractFeatureKeys(const DTState &state,
+								   DTFeatureKey *resultArray) const
+	{
+		if(state.getIndex()+1 >= state.getNObservations()){
+			return 0;
+		}
+		TokenObservation *o = static_cast<TokenObservation*>(
+			state.getObservation(state.getIndex()+1));
+
+		if (PIdFFeatureType::isVocabWord(o->getSymbol())) {
+			resultArray[0].reset(this).add(o->getSymbol());
+			return 1;
+		} else {
+			return 0;
+		}
+	}
+
 
 };
 
@@ -27,6 +27,13 @@ public:
 		resultArray[0] = _new DTBigramFeature(this, state.getTag(), state.getPrevTag());
 		return 1;
 	}
+
+	virtual int extractFeatureKeys(const DTState &state,
+								   DTFeatureKey *resultArray) const
+	{
+		resultArray[0].reset(this).add(state.getPrevTag());
+		return 1;
+	}
 };
 
 #endif
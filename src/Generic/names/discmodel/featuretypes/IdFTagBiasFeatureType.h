@@ -25,5 +25,11 @@ public:
 		return 1;
 	}
 
+	virtual int extractFeatureKeys(const DTState &state,
+	DTFeatureKey *resultArray) const {
+		resultArray[0].reset(this);
+		return 1;
+	}
+
 };
 #endif
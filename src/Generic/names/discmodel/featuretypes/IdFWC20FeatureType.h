@@ -33,6 +33,19 @@ public:
 		return 1;
 	}
 
+	virtual int extractFeatureKeys(const DTState &state,
+								   DTFeatureKey *resultArray) const
+	{
+		TokenObservation *o = static_cast<TokenObservation*>(
+			state.getObservation(state.getIndex()));
+		if(o->getWordClass().c20() == 0){
+			return 0;
+		}
+
+		resultArray[0].reset(this).add(o->getWordClass().c20());
+		return 1;
+	}
+
 };
 
 #endif
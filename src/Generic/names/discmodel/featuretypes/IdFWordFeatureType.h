@@ -34,6 +34,20 @@ public:
 			return 0;
 		}
 	}
+
+	virtual int extractFeatureKeys(const DTState &state,
+								   DTFeatureKey *resultArray) const
+	{
+		TokenObservation *o = static_cast<TokenObservation*>(
+			state.getObservation(state.getIndex()));
+
+		if (PIdFFeatureType::isVocabWord(o->getSymbol())) {
+			resultArray[0].reset(this).add(o->getSymbol());
+			return 1;
+		} else {
+			return 0;
+		}
+	}
 };
 
 #endif
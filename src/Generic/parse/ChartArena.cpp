@@ -0,0 +1,58 @@
+// Copyright (c) 2012 by Raytheon BBN Technologies Corp.
+// All Rights Reserved.
+
+#include "Generic/common/leak_detection.h"
+
+#include "Generic/parse/ChartArena.h"
+
+ChartArena::ChartArena(size_t block_size)
+	: _block_size(block_size), _current_block(0), _next(0), _end(0)
+{
+	// No memory is allocated until the first call to allocate(), since
+	// ChartDecoder's constructors may construct their members twice.
+	memset(_freeLists, 0, sizeof(_freeLists));
+}
+
+ChartArena::~ChartArena() {
+	releaseMemory();
+}
+
+void *ChartArena::allocateSlow(size_t n_bytes) {
+	if (n_bytes > _block_size / 4) {
+		char *block = _new char[n_bytes];
+		_largeBlocks.push_back(block);
+		return block;
+	}
+	// Move on to the next block, allocating it if necessary.  Whatever was
+	// left at the end of the current block is wasted until reset().
+	if (_next != 0)
+		++_current_block;
+	if (_current_block == _blocks.size())
+		_blocks.push_back(_new char[_block_size]);
+	_next = _blocks[_current_block];
+	_end = _next + _block_size;
+	void *result = _next;
+	_next += n_bytes;
+	return result;
+}
+
+void ChartArena::reset() {
+	for (size_t i = 0; i < _largeBlocks.size(); ++i)
+		delete[] _largeBlocks[i];
+	_largeBlocks.clear();
+	memset(_freeLists, 0, sizeof(_freeLists));
+	_current_block = 0;
+	if (_blocks.empty()) {
+		_next = _end = 0;
+	} else {
+		_next = _blocks[0];
+		_end = _next + _block_size;
+	}
+}
+
+void ChartArena::releaseMemory() {
+	for (size_t i = 0; i < _blocks.size(); ++i)
+		delete[] _blocks[i];
+	_blocks.clear();
+	reset();
+}
@@ -0,0 +1,108 @@
+// Copyright (c) 2012 by Raytheon BBN Technologies Corp.
+// All Rights Reserved.
+
+#ifndef CHART_ARENA_H
+#define CHART_ARENA_H
+
+#include <cstddef>
+#include <cstring>
+#include <vector>
+#include <boost/noncopyable.hpp>
+
+/** A ChartArena is a bump allocator for the scratch data that a
+  * ChartDecoder builds while it decodes a single sentence: the chart
+  * cells, the chart entries, and their significant constituent nodes.
+  * Allocation just advances a pointer into a large block, and reset()
+  * releases everything that was allocated in constant time, keeping the
+  * blocks so the next sentence can reuse them.
+  *
+  * Objects that are discarded in the middle of a sentence can be handed
+  * back with recycle(), so that later allocations of the same size reuse
+  * their memory; this keeps the arena from growing with the number of
+  * candidate entries that the decoder considers and rejects.
+  *
+  * reset() and recycle() do not run destructors.  Whoever allocates an
+  * object with a non-trivial destructor (e.g., a ChartEntry, whose
+  * Symbols are reference counted) must destroy it explicitly.
+  *
+  * Each decoder owns its own arena, so a ChartArena is not thread-safe. */
+class ChartArena: boost::noncopyable {
+public:
+	/** All allocations are aligned to this many bytes. */
+	static const size_t ALIGNMENT = 8;
+
+	ChartArena(size_t block_size = DEFAULT_BLOCK_SIZE);
+	~ChartArena();
+
+	/** Return n_bytes of uninitialized memory from this arena. */
+	void *allocate(size_t n_bytes) {
+		n_bytes = roundUp(n_bytes);
+		if (n_bytes <= MAX_RECYCLED_SIZE) {
+			FreeNode *&head = _freeLists[n_bytes / ALIGNMENT];
+			if (head != 0) {
+				FreeNode *result = head;
+				head = head->next;
+				return result;
+			}
+		}
+		if (n_bytes > static_cast<size_t>(_end - _next))
+			return allocateSlow(n_bytes);
+		void *result = _next;
+		_next += n_bytes;
+		return result;
+	}
+
+	template<typename T>
+	T *allocateArray(size_t n) {
+		return static_cast<T*>(allocate(n * sizeof(T)));
+	}
+
+	/** Let later allocations of n_bytes reuse the given memory, which must
+	  * have been returned by allocate(n_bytes) since the last reset(). */
+	void recycle(void *p, size_t n_bytes) {
+		n_bytes = roundUp(n_bytes);
+		if (n_bytes <= MAX_RECYCLED_SIZE) {
+			FreeNode *node = static_cast<FreeNode*>(p);
+			node->next = _freeLists[n_bytes / ALIGNMENT];
+			_freeLists[n_bytes / ALIGNMENT] = node;
+		}
+	}
+
+	/** Release everything that has been allocated from this arena. */
+	void reset();
+
+	/** Like reset(), but also return the arena's blocks to the heap, so
+	  * that memory used by a very long sentence is not kept for the rest
+	  * of the run. */
+	void releaseMemory();
+
+private:
+	static const size_t DEFAULT_BLOCK_SIZE = 1 << 20;
+	static const size_t MAX_RECYCLED_SIZE = 512;
+
+	struct FreeNode {
+		FreeNode *next;
+	};
+
+	static size_t roundUp(size_t n_bytes) {
+		if (n_bytes < sizeof(FreeNode))
+			n_bytes = sizeof(FreeNode);
+		return (n_bytes + ALIGNMENT - 1) & ~(ALIGNMENT - 1);
+	}
+
+	void *allocateSlow(size_t n_bytes);
+
+	size_t _block_size;
+	std::vector<char*> _blocks;
+	size_t _current_block;
+	char *_next;
+	char *_end;
+
+	// Allocations of more than a quarter of a block get their own memory,
+	// which is freed by reset().
+	std::vector<char*> _largeBlocks;
+
+	FreeNode *_freeLists[MAX_RECYCLED_SIZE / ALIGNMENT + 1];
+};
+
+#endif
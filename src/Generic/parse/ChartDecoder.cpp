@@ -4,7 +4,10 @@
 #include "Generic/common/leak_detection.h"
 
 #include <cstring>
+#include <ctime>
 #include <fstream>
+#include <sstream>
+#include <vector>
 #include "math.h"
 #include <stdlib.h>
 #include "Generic/parse/ChartDecoder.h"
@@ -15,8 +18,11 @@
 #include "Generic/parse/LanguageSpecificFunctions.h"
 #include "Generic/parse/ParserTags.h"
 #include "Generic/common/UTF8InputStream.h"
+#include "Generic/common/MappedModelImage.h"
+#include "Generic/common/UnexpectedInputException.h"
 #include "Generic/common/InternalInconsistencyException.h"
 #include "Generic/common/ParamReader.h"
+#include "Generic/common/Profiler.h"
 #include "Generic/common/SymbolUtilities.h"
 #include "Generic/theories/SynNode.h"
 #include "Generic/theories/Entity.h"
@@ -25,8 +31,10 @@
 #include "Generic/theories/PartOfSpeechSequence.h"
 #include "dynamic_includes/parse/ParserConfig.h"
 #include <algorithm>
+#include <boost/filesystem.hpp>
 #include <boost/foreach.hpp>
 #include <boost/scoped_ptr.hpp>
+#include <boost/shared_ptr.hpp>
 
 const size_t ChartDecoder::maxSentenceLength = MAX_SENTENCE_LENGTH;
 const size_t ChartDecoder::maxTagsPerWord = MAX_TAGS_PER_WORD;
@@ -95,10 +103,7 @@ ChartDecoder::ChartDecoder(const KernelTable* kernelTableArg,
     extensionTable(extensionTableArg),
     priorProbTable(priorProbTableArg), 
     cache_max(cacheMax),
-    simpleCache(cacheMax),
-#if !defined(_WIN32) && !defined(__APPLE_CC__)
-    lruCache(cache_max),
-#endif
+    rankingScoreCache(cacheType == None ? 0 : cacheMax, cacheType == Lru),
     cache_type(cacheType),
     headProbs(headProbsArg),
     premodProbs(premodProbsArg), 
@@ -113,21 +118,17 @@ ChartDecoder::ChartDecoder(const KernelTable* kernelTableArg,
 	wordFeatures(WordFeatures::build()),
 	lambda(lambda),
 	maxEntriesPerCell(maxEntriesPerCell),
+	anytimeMode(false),
+	anytimeBeamStart(1.0),
+	anytimeFinalLambda(lambda),
+	anytimeFinalMaxEntriesPerCell(maxEntriesPerCell),
+	cellLambda(lambda),
+	cellMaxEntries(maxEntriesPerCell),
 	theory_scores(_new float[maxEntriesPerCell]),
 	theory_sc_strings(_new string[maxEntriesPerCell]),
 	theories(_new ChartEntry*[maxEntriesPerCell])
 {
 	wordProbTable = _new NgramScoreTable(1, 500);
-	for (size_t i = 0; i < maxSentenceLength; i++) {
-        chart[i][i] = _new ChartEntry*[maxTagsPerWord + 1];
-		chart[i][i][0] = 0;
-    }
-    for (size_t j = 0; j < maxSentenceLength - 1; j++) {
-		for (size_t k = j + 1; k < maxSentenceLength; k++) {
-            chart[j][k] = _new ChartEntry*[maxEntriesPerCell + 1];
-			chart[j][k][0] = 0;
-        }
-    }
 	auxPartOfSpeechTable = auxPOSTable; // may be empty
 	restrictedPosTags = restrictedPOSTags; // default is empty Symbol array
 	restrictedPosTagsSize = restrictedPOSTagsSize; 
@@ -159,12 +160,7 @@ ChartDecoder::~ChartDecoder() {
 	if (scOracle  != 0)            { delete scOracle ; }
 	if (restrictedPosTags  != 0)   { delete[] restrictedPosTags ; }
 	if (parserShortcuts != 0)      { delete parserShortcuts; }
-    for (size_t j = 0; j < maxSentenceLength - 1; j++) {
-		for (size_t k = j; k < maxSentenceLength; k++) {
-            delete[] chart[j][k];
-        }
-    }
-
+	cleanupChart(static_cast<int>(chart.size()));
 }
 
 ChartDecoder::ChartDecoder(const char* model_prefix, double frag_prob){
@@ -182,17 +178,16 @@ ChartDecoder::ChartDecoder(const char* model_prefix, double frag_prob, const Par
 	std::string buffer = ParamReader::getParam("probs_cache_type");
 	if (buffer == "simple") {
 		cacheType = Simple;
-#if !defined(_WIN32) && !defined(__APPLE_CC__)
-		// Not currently supported for Windows; see note in Generic/common/lru_cache.h
 	} else if (buffer == "lru") {
 		cacheType = Lru;
-#endif
 	}
 	long cacheMax = 1000;
 	buffer = ParamReader::getParam("probs_cache_max_k_entries");
 	if (!buffer.empty()) {
 		cacheMax = atol(buffer.c_str()) * 1000;
 	}
+	// Only useful if the probability tables are shared between threads.
+	size_t cacheShards = static_cast<size_t>(ParamReader::getOptionalIntParamWithDefaultValue("probs_cache_shards", 1));
 
 
 	// wordPropTable gets allocated in the constructor that we call with placement new.
@@ -203,91 +198,138 @@ ChartDecoder::ChartDecoder(const char* model_prefix, double frag_prob, const Par
 
 	std::string model_prefix_str(model_prefix);
 
-	boost::scoped_ptr<UTF8InputStream> kernelStream_scoped_ptr(UTF8InputStream::build());
-	UTF8InputStream& kernelStream(*kernelStream_scoped_ptr);
-	buffer = model_prefix_str + ".kernels";
-	kernelStream.open(buffer.c_str());
-	KernelTable* kernelTable = _new KernelTable(kernelStream);
-	kernelStream.close();
+	KernelTable* kernelTable;
+	ExtensionTable* extensionTable;
+	PriorProbTable* priorProbTable;
+	HeadProbs* headProbs;
+	ModifierProbs* premodProbs;
+	ModifierProbs* postmodProbs;
+	LexicalProbs* leftLexicalProbs;
+	LexicalProbs* rightLexicalProbs;
+	PartOfSpeechTable* partOfSpeechTable;
+	VocabularyTable* vocabularyTable;
+	NgramScoreTable* featTable;
+	if (ParamReader::isParamTrue("use_parser_model_image")) {
+		// Map the binary image written by compileModelImage().  The 
+		// probability tables are used directly from the mapped image, which
+		// is shared by every decoder (and every process) that uses it.
+		buffer = model_prefix_str + ".image";
+		checkModelImageIsCurrent(model_prefix, buffer.c_str());
+		boost::shared_ptr<const MappedModelImage> image = MappedModelImage::open(buffer);
+
+		MappedModelImage::Section kernelSection(image, "kernels");
+		kernelTable = _new KernelTable(kernelSection);
+		MappedModelImage::Section extensionSection(image, "extensions");
+		extensionTable = _new ExtensionTable(extensionSection);
+		MappedModelImage::Section priorProbSection(image, "prior");
+		priorProbTable = _new PriorProbTable(priorProbSection);
+		MappedModelImage::Section headProbSection(image, "head");
+		headProbs = _new HeadProbs(headProbSection, cacheType, cacheMax, cacheShards);
+		MappedModelImage::Section premodProbSection(image, "pre");
+		premodProbs = _new ModifierProbs(premodProbSection, cacheType, cacheMax, "pre", cacheShards);
+		MappedModelImage::Section postmodProbSection(image, "post");
+		postmodProbs = _new ModifierProbs(postmodProbSection, cacheType, cacheMax, "post", cacheShards);
+		MappedModelImage::Section leftLexicalProbSection(image, "left");
+		leftLexicalProbs = _new LexicalProbs(leftLexicalProbSection, cacheType, cacheMax, "left", cacheShards);
+		MappedModelImage::Section rightLexicalProbSection(image, "right");
+		rightLexicalProbs = _new LexicalProbs(rightLexicalProbSection, cacheType, cacheMax, "right", cacheShards);
+		MappedModelImage::Section posSection(image, "pos");
+		partOfSpeechTable = _new PartOfSpeechTable(posSection);
+		MappedModelImage::Section vocabularySection(image, "voc");
+		vocabularyTable = _new VocabularyTable(vocabularySection);
+		if(ParamReader::isParamTrue("feature_adjusted_parse")) {
+			MappedModelImage::Section featSection(image, "feat");
+			featTable = _new NgramScoreTable(1, featSection);
+		}
+		else{
+			featTable = _new NgramScoreTable(1,20);
+		}
+	} else {
+		boost::scoped_ptr<UTF8InputStream> kernelStream_scoped_ptr(UTF8InputStream::build());
+		UTF8InputStream& kernelStream(*kernelStream_scoped_ptr);
+		buffer = model_prefix_str + ".kernels";
+		kernelStream.open(buffer.c_str());
+		kernelTable = _new KernelTable(kernelStream);
+		kernelStream.close();
 	
-	boost::scoped_ptr<UTF8InputStream> extensionStream_scoped_ptr(UTF8InputStream::build());
-	UTF8InputStream& extensionStream(*extensionStream_scoped_ptr);
-	buffer = model_prefix_str + ".extensions";
-	extensionStream.open(buffer.c_str());
-	ExtensionTable* extensionTable = _new ExtensionTable(extensionStream);
-	extensionStream.close();
+		boost::scoped_ptr<UTF8InputStream> extensionStream_scoped_ptr(UTF8InputStream::build());
+		UTF8InputStream& extensionStream(*extensionStream_scoped_ptr);
+		buffer = model_prefix_str + ".extensions";
+		extensionStream.open(buffer.c_str());
+		extensionTable = _new ExtensionTable(extensionStream);
+		extensionStream.close();
 	
-	boost::scoped_ptr<UTF8InputStream> priorProbStream_scoped_ptr(UTF8InputStream::build());
-	UTF8InputStream& priorProbStream(*priorProbStream_scoped_ptr);
-	buffer = model_prefix_str + ".prior";
-	priorProbStream.open(buffer.c_str());
-	PriorProbTable* priorProbTable = _new PriorProbTable(priorProbStream);
-	priorProbStream.close();
+		boost::scoped_ptr<UTF8InputStream> priorProbStream_scoped_ptr(UTF8InputStream::build());
+		UTF8InputStream& priorProbStream(*priorProbStream_scoped_ptr);
+		buffer = model_prefix_str + ".prior";
+		priorProbStream.open(buffer.c_str());
+		priorProbTable = _new PriorProbTable(priorProbStream);
+		priorProbStream.close();
 	
-	boost::scoped_ptr<UTF8InputStream> headProbStream_scoped_ptr(UTF8InputStream::build());
-	UTF8InputStream& headProbStream(*headProbStream_scoped_ptr);
-	buffer = model_prefix_str + ".head";
-	headProbStream.open(buffer.c_str());
-	HeadProbs* headProbs = _new HeadProbs(headProbStream, cacheType, cacheMax);
-	headProbStream.close();
+		boost::scoped_ptr<UTF8InputStream> headProbStream_scoped_ptr(UTF8InputStream::build());
+		UTF8InputStream& headProbStream(*headProbStream_scoped_ptr);
+		buffer = model_prefix_str + ".head";
+		headProbStream.open(buffer.c_str());
+		headProbs = _new HeadProbs(headProbStream, cacheType, cacheMax, cacheShards);
+		headProbStream.close();
 	
-	boost::scoped_ptr<UTF8InputStream> premodProbStream_scoped_ptr(UTF8InputStream::build());
-	UTF8InputStream& premodProbStream(*premodProbStream_scoped_ptr);
-	buffer = model_prefix_str + ".pre";
-	premodProbStream.open(buffer.c_str());
-	ModifierProbs* premodProbs = _new ModifierProbs(premodProbStream, cacheType, cacheMax, "pre");
-	premodProbStream.close();
+		boost::scoped_ptr<UTF8InputStream> premodProbStream_scoped_ptr(UTF8InputStream::build());
+		UTF8InputStream& premodProbStream(*premodProbStream_scoped_ptr);
+		buffer = model_prefix_str + ".pre";
+		premodProbStream.open(buffer.c_str());
+		premodProbs = _new ModifierProbs(premodProbStream, cacheType, cacheMax, "pre", cacheShards);
+		premodProbStream.close();
 	
-	boost::scoped_ptr<UTF8InputStream> postmodProbStream_scoped_ptr(UTF8InputStream::build());
-	UTF8InputStream& postmodProbStream(*postmodProbStream_scoped_ptr);
-	buffer = model_prefix_str + ".post";
-	postmodProbStream.open(buffer.c_str());
-    ModifierProbs* postmodProbs = _new ModifierProbs(postmodProbStream, cacheType, cacheMax, "post");
-    postmodProbStream.close();
+		boost::scoped_ptr<UTF8InputStream> postmodProbStream_scoped_ptr(UTF8InputStream::build());
+		UTF8InputStream& postmodProbStream(*postmodProbStream_scoped_ptr);
+		buffer = model_prefix_str + ".post";
+		postmodProbStream.open(buffer.c_str());
+	    postmodProbs = _new ModifierProbs(postmodProbStream, cacheType, cacheMax, "post", cacheShards);
+	    postmodProbStream.close();
 		
-    boost::scoped_ptr<UTF8InputStream> leftLexicalProbStream_scoped_ptr(UTF8InputStream::build());
-    UTF8InputStream& leftLexicalProbStream(*leftLexicalProbStream_scoped_ptr);
-	buffer = model_prefix_str + ".left";
-	leftLexicalProbStream.open(buffer.c_str());
-    LexicalProbs* leftLexicalProbs = _new LexicalProbs(leftLexicalProbStream, cacheType, cacheMax, "left");
-    leftLexicalProbStream.close();
+	    boost::scoped_ptr<UTF8InputStream> leftLexicalProbStream_scoped_ptr(UTF8InputStream::build());
+	    UTF8InputStream& leftLexicalProbStream(*leftLexicalProbStream_scoped_ptr);
+		buffer = model_prefix_str + ".left";
+		leftLexicalProbStream.open(buffer.c_str());
+	    leftLexicalProbs = _new LexicalProbs(leftLexicalProbStream, cacheType, cacheMax, "left", cacheShards);
+	    leftLexicalProbStream.close();
 		
-    boost::scoped_ptr<UTF8InputStream> rightLexicalProbStream_scoped_ptr(UTF8InputStream::build());
-    UTF8InputStream& rightLexicalProbStream(*rightLexicalProbStream_scoped_ptr);
-	buffer = model_prefix_str + ".right";
-    rightLexicalProbStream.open(buffer.c_str());
-    LexicalProbs* rightLexicalProbs = _new LexicalProbs(rightLexicalProbStream, cacheType, cacheMax, "right");
-    rightLexicalProbStream.close();
+	    boost::scoped_ptr<UTF8InputStream> rightLexicalProbStream_scoped_ptr(UTF8InputStream::build());
+	    UTF8InputStream& rightLexicalProbStream(*rightLexicalProbStream_scoped_ptr);
+		buffer = model_prefix_str + ".right";
+	    rightLexicalProbStream.open(buffer.c_str());
+	    rightLexicalProbs = _new LexicalProbs(rightLexicalProbStream, cacheType, cacheMax, "right", cacheShards);
+	    rightLexicalProbStream.close();
 		
-    boost::scoped_ptr<UTF8InputStream> posStream_scoped_ptr(UTF8InputStream::build());
-    UTF8InputStream& posStream(*posStream_scoped_ptr);
-	buffer = model_prefix_str + ".pos";
-    posStream.open(buffer.c_str());
-    PartOfSpeechTable* partOfSpeechTable = _new PartOfSpeechTable(posStream);
-    posStream.close();
-
-    boost::scoped_ptr<UTF8InputStream> vocabularyStream_scoped_ptr(UTF8InputStream::build());
-    UTF8InputStream& vocabularyStream(*vocabularyStream_scoped_ptr);
-	buffer = model_prefix_str + ".voc";
-    vocabularyStream.open(buffer.c_str());
-    VocabularyTable* vocabularyTable = _new VocabularyTable(vocabularyStream);
-    vocabularyStream.close();
-	//mrf- add featureTable
-	//The featureTable is used to put the log 1/# of different words that had
-	//a given Feature set in training as the initial score for a word entry.
-	//If the feature Table is empty, the scores will be 0 (as they were initially)
-    boost::scoped_ptr<UTF8InputStream> featStream_scoped_ptr(UTF8InputStream::build());
-    UTF8InputStream& featStream(*featStream_scoped_ptr);
-	NgramScoreTable* featTable;
-	if(ParamReader::isParamTrue("feature_adjusted_parse")) {
-		buffer = model_prefix_str + ".feat";
-		featStream.open(buffer.c_str());
-		featTable = _new NgramScoreTable(1, featStream);
-		featStream.close();
+	    boost::scoped_ptr<UTF8InputStream> posStream_scoped_ptr(UTF8InputStream::build());
+	    UTF8InputStream& posStream(*posStream_scoped_ptr);
+		buffer = model_prefix_str + ".pos";
+	    posStream.open(buffer.c_str());
+	    partOfSpeechTable = _new PartOfSpeechTable(posStream);
+	    posStream.close();
+
+	    boost::scoped_ptr<UTF8InputStream> vocabularyStream_scoped_ptr(UTF8InputStream::build());
+	    UTF8InputStream& vocabularyStream(*vocabularyStream_scoped_ptr);
+		buffer = model_prefix_str + ".voc";
+	    vocabularyStream.open(buffer.c_str());
+	    vocabularyTable = _new VocabularyTable(vocabularyStream);
+	    vocabularyStream.close();
+		//mrf- add featureTable
+		//The featureTable is used to put the log 1/# of different words that had
+		//a given Feature set in training as the initial score for a word entry.
+		//If the feature Table is empty, the scores will be 0 (as they were initially)
+	    boost::scoped_ptr<UTF8InputStream> featStream_scoped_ptr(UTF8InputStream::build());
+	    UTF8InputStream& featStream(*featStream_scoped_ptr);
+		if(ParamReader::isParamTrue("feature_adjusted_parse")) {
+			buffer = model_prefix_str + ".feat";
+			featStream.open(buffer.c_str());
+			featTable = _new NgramScoreTable(1, featStream);
+			featStream.close();
 
-	}
-	else{
-		featTable = _new NgramScoreTable(1,20);
+		}
+		else{
+			featTable = _new NgramScoreTable(1,20);
+		}
 	}
 
 	SequentialBigrams* bigrams;	
@@ -345,7 +387,116 @@ ChartDecoder::ChartDecoder(const char* model_prefix, double frag_prob, const Par
 		auxPOSTable, restrictedPOSTags, restrictedPOSTagsSize, 
 	    parserShortcutsArg, useLowerCaseForUnknown, constrainKnownNounsAndVerbsParam,
 		lambda, max_entries_per_cell);
-		
+
+	// Anytime parsing parameters.  (These are set after the placement-new
+	// above, which would otherwise reset them.)
+	anytimeMode = ParamReader::getOptionalTrueFalseParamWithDefaultVal("parser_anytime_mode", false);
+	anytimeBeamStart = ParamReader::getOptionalFloatParamWithDefaultValue("parser_anytime_beam_start", 0.5);
+	anytimeFinalLambda = static_cast<float>(ParamReader::getOptionalFloatParamWithDefaultValue("parser_anytime_final_lambda", -1));
+	anytimeFinalMaxEntriesPerCell = ParamReader::getOptionalIntParamWithDefaultValue("parser_anytime_final_max_entries_per_cell", 5);
+	if (anytimeBeamStart < 0 || anytimeBeamStart > 1)
+		throw UnexpectedInputException("ChartDecoder::ChartDecoder",
+			"parser_anytime_beam_start must be between 0 and 1");
+	if (anytimeFinalMaxEntriesPerCell < 1 || anytimeFinalMaxEntriesPerCell > maxEntriesPerCell)
+		throw UnexpectedInputException("ChartDecoder::ChartDecoder",
+			"parser_anytime_final_max_entries_per_cell must be between 1 and parser_max_entries_per_cell");
+}
+
+namespace {
+	UTF8InputStream* openModelFile(const std::string& model_prefix, const char* suffix) {
+		std::string filename = model_prefix + suffix;
+		UTF8InputStream* stream = UTF8InputStream::build(filename.c_str());
+		if (stream->fail()) {
+			delete stream;
+			throw UnexpectedInputException("ChartDecoder::compileModelImage",
+				"Unable to open parser model file: ", filename.c_str());
+		}
+		return stream;
+	}
+
+	// The text model files that compileModelImage() reads.
+	const char* MODEL_FILE_SUFFIXES[] = {".kernels", ".extensions", ".prior", ".head", ".pre",
+		".post", ".left", ".right", ".pos", ".voc"};
+}
+
+void ChartDecoder::checkModelImageIsCurrent(const char* model_prefix, const char* image_file) {
+	std::vector<std::string> suffixes(MODEL_FILE_SUFFIXES,
+		MODEL_FILE_SUFFIXES + sizeof(MODEL_FILE_SUFFIXES) / sizeof(MODEL_FILE_SUFFIXES[0]));
+	if (ParamReader::isParamTrue("feature_adjusted_parse"))
+		suffixes.push_back(".feat");
+	if (!boost::filesystem::exists(image_file))
+		throw UnexpectedInputException("ChartDecoder::checkModelImageIsCurrent",
+			"Parser model image not found: ", image_file);
+	std::time_t image_time = boost::filesystem::last_write_time(image_file);
+	BOOST_FOREACH(const std::string& suffix, suffixes) {
+		std::string filename = std::string(model_prefix) + suffix;
+		if (boost::filesystem::exists(filename) && boost::filesystem::last_write_time(filename) > image_time) {
+			std::stringstream err;
+			err << "Parser model image " << image_file << " is older than the model file "
+				<< filename << "; recompile it with ParserModelCompiler.";
+			throw UnexpectedInputException("ChartDecoder::checkModelImageIsCurrent", err.str().c_str());
+		}
+	}
+}
+
+void ChartDecoder::compileModelImage(const char* model_prefix, const char* image_file) {
+	// The sections must match the ones that are read by the constructor.
+	// The kernel, extension, part-of-speech, and vocabulary tables are 
+	// copied out of the image when it is loaded, so they are compiled 
+	// directly from the text files (preserving the order of their records).
+	// The probability tables are looked up in place, so they are read and
+	// then written out as hash tables.
+	std::string prefix(model_prefix);
+	MappedModelImageWriter writer;
+	boost::scoped_ptr<UTF8InputStream> in;
+
+	in.reset(openModelFile(prefix, ".kernels"));
+	writer.beginSection("kernels");
+	KernelTable::compileImage(*in, writer);
+
+	in.reset(openModelFile(prefix, ".extensions"));
+	writer.beginSection("extensions");
+	ExtensionTable::compileImage(*in, writer);
+
+	in.reset(openModelFile(prefix, ".prior"));
+	writer.beginSection("prior");
+	PriorProbTable(*in).writeImage(writer);
+
+	in.reset(openModelFile(prefix, ".head"));
+	writer.beginSection("head");
+	HeadProbs(*in, None, 0).writeImage(writer);
+
+	in.reset(openModelFile(prefix, ".pre"));
+	writer.beginSection("pre");
+	ModifierProbs(*in, None, 0, "pre").writeImage(writer);
+
+	in.reset(openModelFile(prefix, ".post"));
+	writer.beginSection("post");
+	ModifierProbs(*in, None, 0, "post").writeImage(writer);
+
+	in.reset(openModelFile(prefix, ".left"));
+	writer.beginSection("left");
+	LexicalProbs(*in, None, 0, "left").writeImage(writer);
+
+	in.reset(openModelFile(prefix, ".right"));
+	writer.beginSection("right");
+	LexicalProbs(*in, None, 0, "right").writeImage(writer);
+
+	in.reset(openModelFile(prefix, ".pos"));
+	writer.beginSection("pos");
+	PartOfSpeechTable::compileImage(*in, writer);
+
+	in.reset(openModelFile(prefix, ".voc"));
+	writer.beginSection("voc");
+	VocabularyTable::compileImage(*in, writer);
+
+	if(ParamReader::isParamTrue("feature_adjusted_parse")) {
+		in.reset(openModelFile(prefix, ".feat"));
+		writer.beginSection("feat");
+		NgramScoreTable(1, *in).writeImage(writer);
+	}
+
+	writer.write(image_file);
 }
 
 /** Does this method ever get called?? */
@@ -378,6 +529,7 @@ ParseNode* ChartDecoder::decode(Symbol* sentence, int length,
 
 ParseNode* ChartDecoder::returnDefaultParse(Symbol* sentence, int length, std::vector<Constraint> & constraints, bool collapseNPlabels)
 {
+	initChartCells(length);
 	ParseNode *defaultParse = getDefaultParse(sentence, length, constraints);
 	highest_scoring_final_theory = 0;
 	theory_scores[0] = 0;
@@ -395,6 +547,8 @@ ParseNode* ChartDecoder::decode(Symbol* sentence, int length,
 {
 	highest_scoring_final_theory = 0; // this needs to be set before we return!!
 
+	initChartCells(length);
+
 	// AZ 4/1/05: There is an obscure bug where if the first sentence of a document 
 	// is one token long, and the token in OOV, the parser sometimes crashes. 
 	// This routine handles one token sentences without trying to parse.
@@ -445,6 +599,8 @@ ParseNode* ChartDecoder::decode(Symbol* sentence, int length,
 	//end punctuation only check
 
 	startClock();
+	cellLambda = lambda;
+	cellMaxEntries = maxEntriesPerCell;
 	
 	bool lastIsPunct = LanguageSpecificFunctions::isSentenceEndingPunctuation(sentence[length - 1]);
 
@@ -492,19 +648,38 @@ ParseNode* ChartDecoder::decode(Symbol* sentence, int length,
 		}
 	}
 
+	Profiler::Scope chartFillScope("chart-fill");
+	Profiler::count("words", length);
 	for (int span = 2; span <= length; span++) {
 		for (int start = 0; start <= (length - span); start++) {
 			if (timedOut(sentence, length)) {
-				ParseNode *defaultParse = getDefaultParse(sentence, length, constraints);
+				Profiler::count("timeouts");
+				// In anytime mode, every span shorter than this one has been 
+				// completed, so we can do much better than the default parse
+				// by stitching together the best fragments in the chart.
+				ParseNode *defaultParse = 0;
+				if (anytimeMode) {
+					float fragmentedScore;
+					defaultParse = getBestFragmentedParse(fragmentedScore, 0, length - 1);
+				}
+				bool usedAnytimeFallback = (defaultParse != 0);
+				if (usedAnytimeFallback)
+					Profiler::count("anytime_fallbacks");
+				if (defaultParse == 0) {
+					defaultParse = getDefaultParse(sentence, length, constraints);
+					theory_scores[0] = 0;
+				}
 				highest_scoring_final_theory = 0;
-				theory_scores[0] = 0;
 				int replacementPosition = 0;
 				replaceWords(defaultParse, replacementPosition, sentence);
 				postprocessParse(defaultParse, constraints, collapseNPlabels);
 				cleanupChart(length);
 				highest_scoring_final_theory = 0;
+				reportParseTime(length, usedAnytimeFallback);
 				return defaultParse;
 			}
+			if (anytimeMode)
+				updateAnytimeBeam();
 			int end = start + span;
 
 
@@ -533,6 +708,7 @@ ParseNode* ChartDecoder::decode(Symbol* sentence, int length,
 			transferTheoriesToChart(start, end);
 		}
 	}
+	chartFillScope.stop();
 	float finalScore;
 
 	ParseNode* returnValue = getBestParse(finalScore, 0, length, false);
@@ -565,6 +741,7 @@ ParseNode* ChartDecoder::decode(Symbol* sentence, int length,
 	}
 
 	cleanupChart(length);
+	reportParseTime(length, false);
 
 	return returnValue;
 		
@@ -584,11 +761,11 @@ void ChartDecoder::addKernelTheories(ChartEntry* leftEntry,
 			bool left = scOracle->isSignificant(leftEntry, kernels[i].headChain);
 			bool right = scOracle->isSignificant(rightEntry, kernels[i].modifierChain);
 			SignificantConstitNode *significantConstitNode = 
-				_new SignificantConstitNode(left, leftEntry->significantConstitNode, 
+				new (chartArena) SignificantConstitNode(chartArena, left, leftEntry->significantConstitNode, 
 				leftEntry->leftToken, leftEntry->rightToken, 
 				right, rightEntry->significantConstitNode, 
 				rightEntry->leftToken, rightEntry->rightToken);
-			ChartEntry* entry = _new ChartEntry(
+			ChartEntry* entry = new (chartArena) ChartEntry(
 			    /*constituentCategory =*/ kernels[i].constituentCategory,
 			    /*headConstituent =*/ kernels[i].headChainFront,
 			    /*headWord =*/ leftEntry->headWord,
@@ -620,11 +797,11 @@ void ChartDecoder::addKernelTheories(ChartEntry* leftEntry,
 			bool left = scOracle->isSignificant(leftEntry, kernels[j].modifierChain);
 			bool right = scOracle->isSignificant(rightEntry, kernels[j].headChain);
 			SignificantConstitNode *significantConstitNode = 
-				_new SignificantConstitNode(left, 
+				new (chartArena) SignificantConstitNode(chartArena, left, 
 				leftEntry->significantConstitNode, leftEntry->leftToken,
 				leftEntry->rightToken, right, rightEntry->significantConstitNode, 
 				rightEntry->leftToken, rightEntry->rightToken);
-			ChartEntry* entry = _new ChartEntry(
+			ChartEntry* entry = new (chartArena) ChartEntry(
 			    /*constituentCategory =*/ kernels[j].constituentCategory,
 			    /*headConstituent =*/ kernels[j].headChainFront,
 			    /*headWord =*/ rightEntry->headWord,
@@ -663,11 +840,11 @@ void ChartDecoder::addExtensionTheories(ChartEntry* leftEntry,
 		for (int i = 0; i < numExtensions; i++) {
 			bool right = scOracle->isSignificant(rightEntry, extensions[i].modifierChain);
 			SignificantConstitNode *significantConstitNode = 
-				_new SignificantConstitNode(false, 
+				new (chartArena) SignificantConstitNode(chartArena, false, 
 				leftEntry->significantConstitNode, 0,0,
 				right, rightEntry->significantConstitNode, 
 				rightEntry->leftToken, rightEntry->rightToken);
-			ChartEntry* entry = _new ChartEntry(
+			ChartEntry* entry = new (chartArena) ChartEntry(
 			    /*constituentCategory =*/ leftEntry->constituentCategory,
 			    /*headConstituent =*/ leftEntry->headConstituent,
 			    /*headWord =*/ leftEntry->headWord,
@@ -702,11 +879,11 @@ void ChartDecoder::addExtensionTheories(ChartEntry* leftEntry,
 		for (int j = 0; j < numExtensions; j++) {
 			bool left = scOracle->isSignificant(leftEntry, extensions[j].modifierChain);
 			SignificantConstitNode *significantConstitNode = 
-				_new SignificantConstitNode(left, 
+				new (chartArena) SignificantConstitNode(chartArena, left, 
 				leftEntry->significantConstitNode, leftEntry->leftToken,
 				leftEntry->rightToken, false, rightEntry->significantConstitNode, 
 				0,0);
-			ChartEntry* entry = _new ChartEntry(
+			ChartEntry* entry = new (chartArena) ChartEntry(
 			    /*constituentCategory =*/ rightEntry->constituentCategory,
 			    /*headConstituent =*/ rightEntry->headConstituent,
 			    /*headWord =*/ rightEntry->headWord,
@@ -746,7 +923,7 @@ void ChartDecoder::addTheory(ChartEntry* chartEntry)
 {
     if (chartEntry->rankingScore <= -10000) {
 			//cout << "deleting " << chartEntry->significantConstitNode << endl;
-			delete chartEntry;
+			chartEntry->release(chartArena);
       return;
     }
 
@@ -763,11 +940,11 @@ void ChartDecoder::addTheory(ChartEntry* chartEntry)
 		  (*match)->rankingScore) > 0) 
 #endif
 	{
-            delete (*match);
+            (*match)->release(chartArena);
             (*match) = chartEntry;
             return;
         } else {
-			delete chartEntry;
+			chartEntry->release(chartArena);
             return;
         }
     }
@@ -793,11 +970,11 @@ void ChartDecoder::addTheory(ChartEntry* chartEntry)
 	       theories[lowestScoring]->rankingScore) > 0)
 #endif
       {            
-        delete theories[lowestScoring];
+        theories[lowestScoring]->release(chartArena);
         theories[lowestScoring] = chartEntry;
         return;
     } else {
-        delete chartEntry;
+        chartEntry->release(chartArena);
         return;
     }
 }
@@ -818,21 +995,21 @@ void ChartDecoder::transferTheoriesToChart(int start, int end)
 #endif
             highestScoring = i;
     }
-    float threshold = theories[highestScoring]->rankingScore + lambda;
+    float threshold = theories[highestScoring]->rankingScore + cellLambda;
     int j = 0;
     for (int k = 0; k < numTheories; k++) {
 		// boundaries should already be checked, but just in case, check
-		// against maxEntriesPerCell
+		// against maxEntriesPerCell (or the narrower anytime beam)
         if (
 #ifdef PARSER_FAST_FLOATING_POINT_COMPARISON
 	    theories[k]->rankingScore > threshold 
 #else
 	    __fcmp (theories[k]->rankingScore, threshold) > 0
 #endif
-	    && j < maxEntriesPerCell) {
+	    && j < cellMaxEntries) {
             chart[start][end - 1][j++] = theories[k];
         } else {
-			delete theories[k];
+			theories[k]->release(chartArena);
         }
     }
     chart[start][end - 1][j] = 0;
@@ -913,7 +1090,7 @@ void ChartDecoder::addConstraintEntry(int left, int right,
 			if (index < maxEntriesPerCell && 
 				LanguageSpecificFunctions::isNPtypePOStag(tag))
 			{
-				entry = _new ChartEntry();
+				entry = new (chartArena) ChartEntry();
 				if (type == ParserTags::HEAD_CONSTRAINT)
 					entry->nameType = ParserTags::nullSymbol;
 				else entry->nameType = type;
@@ -926,7 +1103,7 @@ void ChartDecoder::addConstraintEntry(int left, int right,
 				const Symbol &tag = tags[k];
 				if (index < maxEntriesPerCell)
 				{
-					entry = _new ChartEntry();
+					entry = new (chartArena) ChartEntry();
 					if (type == ParserTags::HEAD_CONSTRAINT)
 						entry->nameType = ParserTags::nullSymbol;
 					else entry->nameType = type;
@@ -941,7 +1118,7 @@ void ChartDecoder::addConstraintEntry(int left, int right,
 		for (int k = 0; k < numTags; k++) {
 			const Symbol &tag = tags[k];
 			if (index < maxEntriesPerCell) {
-				entry = _new ChartEntry();
+				entry = new (chartArena) ChartEntry();
 				entry->nameType = LanguageSpecificFunctions::getDateLabel();
 				fillWordEntry(entry, tag, word, sentence[right], left, right);
 				chart[left][right][index++] = entry;
@@ -972,7 +1149,7 @@ void ChartDecoder::addConstraintEntry(int left, int right,
 			 (!is_unknown_word &&
 			  LanguageSpecificFunctions::isSecondaryNamePOStag(tag, entityType))))
 		{
-			entry = _new ChartEntry();
+			entry = new (chartArena) ChartEntry();
 			entry->nameType = type;
 			fillWordEntry(entry, tag, word, sentence[right], left, right);
 			chart[left][right][index++] = entry;
@@ -991,7 +1168,7 @@ void ChartDecoder::addConstraintEntry(int left, int right,
 			if (index < maxEntriesPerCell &&
 				(LanguageSpecificFunctions::isPrimaryNamePOStag(tag, entityType)))
 			{
-				entry = _new ChartEntry();
+				entry = new (chartArena) ChartEntry();
 				entry->nameType = type;
 				fillWordEntry(entry, tag, word, sentence[right], left, right);
 				chart[left][right][index++] = entry;
@@ -1002,7 +1179,7 @@ void ChartDecoder::addConstraintEntry(int left, int right,
 	// if no default name word or no primary tags fit the default name word, just add this in,
 	// but be aware that this WILL fragment the parse
 	if (index == 0) {
-		entry = _new ChartEntry();
+		entry = new (chartArena) ChartEntry();
 		entry->nameType = type;
 		fillWordEntry(entry, LanguageSpecificFunctions::getDefaultNamePOStag(entityType), word, 
 			sentence[right], left, right);
@@ -1272,7 +1449,7 @@ void ChartDecoder::initChartWord(Symbol word, int chartIndex, bool firstWord,
 			possiblePunctuationOrConjunction[chartIndex] = true;
 		}
 		
-		ChartEntry *entry = _new ChartEntry();
+		ChartEntry *entry = new (chartArena) ChartEntry();
 		entry->nameType = ParserTags::nullSymbol;
 		fillWordEntry(entry, tag, word, originalWord, chartIndex, chartIndex);
 		
@@ -1286,7 +1463,7 @@ void ChartDecoder::initChartWord(Symbol word, int chartIndex, bool firstWord,
 			<< originalWord.to_debug_string()
 			<< ", vector -- "
 			<< word.to_debug_string();
-		ChartEntry *entry = _new ChartEntry();
+		ChartEntry *entry = new (chartArena) ChartEntry();
 		entry->nameType = ParserTags::nullSymbol;
 		// don't actually calculate ranking score (that's what the "false" parameter indicates)
 		fillWordEntry(entry, ParserTags::unknownTag, word, 
@@ -1364,7 +1541,7 @@ void ChartDecoder::fillWordEntry(ChartEntry *entry, const Symbol &cat,
 		entry->headIsSignificant = scOracle->isPossibleDescriptorHeadWord(originalWord);
 	else entry->headIsSignificant = false;
 	
-	entry->significantConstitNode = _new SignificantConstitNode();
+	entry->significantConstitNode = new (chartArena) SignificantConstitNode();
 	
 }
 
@@ -1431,26 +1608,13 @@ void ChartDecoder::scoreKernel(ChartEntry* entry)
     
     else {
       Symbol ngram[] = {entry->constituentCategory, entry->headTag, entry->headWord};
-      if (cache_type == Simple) {
-        Cache<cacheN>::simple::iterator iter = simpleCache.find(ngram);
-        if (iter != simpleCache.end()) {
-          entry->rankingScore = entry->insideScore + (*iter).second;
-        } else {
-          float partial_score = computePartialRankingScore(entry);
-          entry->rankingScore = entry->insideScore + partial_score;
-          simpleCache.insert(std::make_pair(ngram, partial_score));
+      if (cache_type != None) {
+        float partial_score;
+        if (!rankingScoreCache.find(ngram, partial_score)) {
+          partial_score = computePartialRankingScore(entry);
+          rankingScoreCache.insert(ngram, partial_score);
         }
-#if !defined(_WIN32) && !defined(__APPLE_CC__)
-      } else if(cache_type == Lru) {
-        Cache<cacheN>::lru::iterator iter = lruCache.find(ngram);
-        if (iter != lruCache.end()) {
-          entry->rankingScore = entry->insideScore + (*iter).second;
-        } else {
-          float partial_score = computePartialRankingScore(entry);
-          entry->rankingScore = entry->insideScore + partial_score;
-          lruCache.insert(std::make_pair(ngram, partial_score));
-        }
-#endif
+        entry->rankingScore = entry->insideScore + partial_score;
       } else {
         entry->rankingScore = entry->insideScore + computePartialRankingScore(entry);
       }
@@ -1629,7 +1793,7 @@ ParseNode* ChartDecoder::getBestParse(float &score,
     if (chart[start][endChartIndex][0] != 0) {
         numTheories = 0;
         ChartEntry leftEntry;
-		leftEntry.significantConstitNode = _new SignificantConstitNode();
+		leftEntry.significantConstitNode = new (chartArena) SignificantConstitNode();
         leftEntry.constituentCategory = ParserTags::TOPTAG;
         leftEntry.headConstituent = ParserTags::nullSymbol;
         leftEntry.headWord = ParserTags::TOPWORD;
@@ -1674,7 +1838,7 @@ ParseNode* ChartDecoder::getBestParse(float &score,
 
 			// delete theories
 			for (int l = 0; l < numTheories; l++) {
-				delete theories[l];
+				theories[l]->release(chartArena);
 			}
 			
 			return return_tree;
@@ -2022,6 +2186,10 @@ int ChartDecoder::getTreeDepth(ParseNode* node) {
 
 void ChartDecoder::cleanupChart(int length)
 {
+	if (length > static_cast<int>(chart.size()))
+		length = static_cast<int>(chart.size());
+	// The entries' memory is freed all at once by releaseChart(), but their
+	// destructors still need to be run, since they hold Symbols.
     for (int i = 0; i < length; i++) {
         for (int j = i; j < length; j++) {
 			int k = 0;
@@ -2029,11 +2197,34 @@ void ChartDecoder::cleanupChart(int length)
 				if (k >= maxEntriesPerCell && i != j) {
 					continue;
 				}
-				delete *p;
+				(*p)->~ChartEntry();
             }
-			chart[i][j][0] = 0;
         }
     }
+	releaseChart();
+}
+
+void ChartDecoder::initChartCells(int n_tokens)
+{
+	if (chart.size() != 0)
+		cleanupChart(static_cast<int>(chart.size()));
+	size_t n = static_cast<size_t>(n_tokens);
+	chart._cells = chartArena.allocateArray<ChartEntry**>(n * n);
+	chart._size = n;
+	for (size_t i = 0; i < n; i++) {
+		chart[i][i] = chartArena.allocateArray<ChartEntry*>(maxTagsPerWord + 1);
+		chart[i][i][0] = 0;
+		for (size_t j = i + 1; j < n; j++) {
+			chart[i][j] = chartArena.allocateArray<ChartEntry*>(maxEntriesPerCell + 1);
+			chart[i][j][0] = 0;
+		}
+	}
+}
+
+void ChartDecoder::releaseChart()
+{
+	chart = Chart();
+	chartArena.reset();
 }
 
 void ChartDecoder::initPunctuationUpperBound(Symbol* sentence, int length)
@@ -2364,17 +2555,29 @@ bool ChartDecoder::chartHasParticlePOS(int nindex)
 	return false;
 }
 void ChartDecoder::startClock() {
-	_startTime = clock();
+	_startTime = boost::posix_time::microsec_clock::universal_time();
+}
+
+double ChartDecoder::getElapsedSeconds() const {
+	boost::posix_time::time_duration elapsed = boost::posix_time::microsec_clock::universal_time() - _startTime;
+	return elapsed.total_microseconds() / 1000000.0;
 }
 
 bool ChartDecoder::timedOut(Symbol *sentence, int length) {
-	clock_t diff = clock() - _startTime;
-	if (clock() - _startTime > MAX_CLOCKS) {
+	// This uses wall-clock time rather than clock(), which measures the CPU
+	// time used by the whole process (including any other parsing threads).
+	if (getElapsedSeconds() > static_cast<double>(MAX_CLOCKS) / CLOCKS_PER_SEC) {
 		std::wstringstream errMsg;
-		errMsg << "The syntactic parser timed out, and a flat parse is being returned. "
-			<< "The analysis for this sentence will contain named entities but not entity descriptions "
-			<< "(e.g. 'the president') or most pronouns. Most relations and events will also be omitted. "
-			<< "This behavior typically occurs when a sentence is either very long or contains an unusual arrangement "
+		if (anytimeMode) {
+			errMsg << "The syntactic parser timed out, and a parse is being assembled from the constituents "
+				<< "that were found before the time limit. The analysis for this sentence may be missing some "
+				<< "entity descriptions, relations, and events. ";
+		} else {
+			errMsg << "The syntactic parser timed out, and a flat parse is being returned. "
+				<< "The analysis for this sentence will contain named entities but not entity descriptions "
+				<< "(e.g. 'the president') or most pronouns. Most relations and events will also be omitted. ";
+		}
+		errMsg << "This behavior typically occurs when a sentence is either very long or contains an unusual arrangement "
 			<< "of tokens (e.g. excessive punctuation), causing the parser to perform particularly inefficiently. "
 			<< "The (tokenized) text of the timed-out sentence was:";
 		for (int i = 0; i < length; i++) {
@@ -2385,6 +2588,35 @@ bool ChartDecoder::timedOut(Symbol *sentence, int length) {
 	} else return false;
 }
 
+// Narrow the beam in proportion to the fraction of the time limit that has
+// been used past anytimeBeamStart.
+void ChartDecoder::updateAnytimeBeam() {
+	double limit = static_cast<double>(MAX_CLOCKS) / CLOCKS_PER_SEC;
+	double used = (limit > 0) ? getElapsedSeconds() / limit : 1.0;
+	if (used <= anytimeBeamStart) {
+		cellLambda = lambda;
+		cellMaxEntries = maxEntriesPerCell;
+		return;
+	}
+	double t = (anytimeBeamStart < 1.0) ? (used - anytimeBeamStart) / (1.0 - anytimeBeamStart) : 1.0;
+	if (t > 1.0)
+		t = 1.0;
+	cellLambda = static_cast<float>(lambda + t * (anytimeFinalLambda - lambda));
+	cellMaxEntries = maxEntriesPerCell - 
+		static_cast<int>(t * (maxEntriesPerCell - anytimeFinalMaxEntriesPerCell) + 0.5);
+}
+
+void ChartDecoder::reportParseTime(int length, bool usedAnytimeFallback) {
+	double msecs = getElapsedSeconds() * 1000;
+	if (anytimeMode) {
+		SessionLogger::info("parse_time") << "Parsed sentence of " << length << " tokens in " 
+			<< msecs << " msec" << (usedAnytimeFallback ? " (timed out; used anytime fallback)" : "");
+	} else {
+		SessionLogger::dbg("parse_time") << "Parsed sentence of " << length << " tokens in " 
+			<< msecs << " msec";
+	}
+}
+
 ParseNode *ChartDecoder::getDefaultParse(Symbol* sentence, int length, std::vector<Constraint> & constraints) {
 	if (length == 1) {
 		BOOST_FOREACH(Constraint constraint, constraints) {
@@ -2533,6 +2765,15 @@ void ChartDecoder::writeCaches() {
 
 void ChartDecoder::readCaches() {
   const char* case_tag = decoderTypeString();
+  std::string image_file = ParamReader::getParam("probs_cache_image");
+  if (!image_file.empty()) {
+    boost::shared_ptr<const MappedModelImage> image = MappedModelImage::open(image_file);
+    headProbs->readCacheImage(image, case_tag);
+    premodProbs->readCacheImage(image, case_tag);
+    postmodProbs->readCacheImage(image, case_tag);
+    leftLexicalProbs->readCacheImage(image, case_tag);
+    rightLexicalProbs->readCacheImage(image, case_tag);
+  }
   headProbs->readCache(case_tag);
   premodProbs->readCache(case_tag);
   postmodProbs->readCache(case_tag);
@@ -2540,6 +2781,15 @@ void ChartDecoder::readCaches() {
   rightLexicalProbs->readCache(case_tag);
 }
 
+void ChartDecoder::writeCacheImage(MappedModelImageWriter& writer) {
+  const char* case_tag = decoderTypeString();
+  headProbs->writeCacheImage(case_tag, writer);
+  premodProbs->writeCacheImage(case_tag, writer);
+  postmodProbs->writeCacheImage(case_tag, writer);
+  leftLexicalProbs->writeCacheImage(rightLexicalProbs, case_tag, writer);
+  rightLexicalProbs->writeCacheImage(leftLexicalProbs, case_tag, writer);
+}
+
 void ChartDecoder::cleanup() {
 	headProbs->clearCache();
 	premodProbs->clearCache();
@@ -2548,10 +2798,11 @@ void ChartDecoder::cleanup() {
 	rightLexicalProbs->clearCache();
 	for (int i=0; i<maxEntriesPerCell; ++i) 
 		theory_sc_strings[i].clear(); // make sure memory is freed.
-	simpleCache.clear();
-#if !defined(_WIN32) && !defined(__APPLE_CC__)
-	lruCache.clear();
-#endif
+	rankingScoreCache.logStats("ranking");
+	rankingScoreCache.clear();
+	// The chart is released after each sentence, so its arena is empty here.
+	if (chart.size() == 0)
+		chartArena.releaseMemory();
 }
 
 const char* ChartDecoder::decoderTypeString() {
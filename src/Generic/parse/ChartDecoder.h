@@ -4,6 +4,7 @@
 #ifndef CHART_DECODER_H
 #define CHART_DECODER_H
 
+#include "Generic/parse/ChartArena.h"
 #include "Generic/parse/ChartEntry.h"
 #include "Generic/parse/Constraint.h"
 #include "Generic/parse/ExtensionTable.h"
@@ -26,6 +27,7 @@
 
 #include <cstddef>
 #include <time.h>
+#include <boost/date_time/posix_time/posix_time_types.hpp>
 class PartOfSpeechSequence;
 #define MAX_SENTENCE_LENGTH MAX_SENTENCE_TOKENS // SRS
 
@@ -43,16 +45,28 @@ protected:
 	int maxEntriesPerCell;  // set by parser_max_entries_per_cell parameter.
 	float lambda;           // set by parser_lambda parameter.
 
+	// Anytime parsing, enabled by the parser_anytime_mode parameter.  As
+	// the time spent on a sentence approaches the time limit, the beam
+	// used for each chart cell (cellLambda and cellMaxEntries) is narrowed
+	// from (lambda, maxEntriesPerCell) down to (anytimeFinalLambda,
+	// anytimeFinalMaxEntriesPerCell), starting once anytimeBeamStart of
+	// the time limit has been used.  If the sentence still times out, its
+	// parse is assembled from the best fragments in the partial chart,
+	// rather than being a flat default parse.
+	bool anytimeMode;
+	double anytimeBeamStart;
+	float anytimeFinalLambda;
+	int anytimeFinalMaxEntriesPerCell;
+	float cellLambda;
+	int cellMaxEntries;
+
 	const NgramScoreTable* featTable;
 	const NgramScoreTable* wordProbTable;
 	const KernelTable* kernelTable;
 	const ExtensionTable* extensionTable;
 	const PriorProbTable* priorProbTable;
         long cache_max;
-        Cache<cacheN>::simple simpleCache;
-#if !defined(_WIN32) && !defined(__APPLE_CC__)
-        Cache<cacheN>::lru lruCache;
-#endif
+        NGramCache<cacheN> rankingScoreCache;
         CacheType cache_type;
 	HeadProbs* headProbs;
 	ModifierProbs* premodProbs;
@@ -103,6 +117,18 @@ public:
 	ChartDecoder(const char* model_prefix, double frag_prob);
 	ChartDecoder(const char* model_prefix, double frag_prob, const PartOfSpeechTable* auxPOSTable);
 	virtual ~ChartDecoder();
+
+	/** Compile the text model files with the given prefix into a single
+	  * binary model image.  If use_parser_model_image is true, then the
+	  * constructor maps the image <model_prefix>.image instead of reading
+	  * the text files; decoding results are the same either way. */
+	static void compileModelImage(const char* model_prefix, const char* image_file);
+
+	/** Throw an UnexpectedInputException if any of the text model files
+	  * with the given prefix is newer than the given model image (i.e.,
+	  * the image needs to be recompiled).  Text files that do not exist
+	  * are ignored, so an image may be deployed without them. */
+	static void checkModelImageIsCurrent(const char* model_prefix, const char* image_file);
 	virtual ParseNode* decode(Symbol* sentence, int length,
 		std::vector<Constraint> & constraints,
 		bool collapseNPlabels = true, Symbol* pos_constraints = 0 );
@@ -124,13 +150,52 @@ public:
 	void setMaxParserSeconds(int maxsecs) { MAX_CLOCKS = maxsecs * CLOCKS_PER_SEC; }
 
     void writeCaches();
+    /** Preload the probability caches from the cache pre-load files (see
+      * probs_cache_in_path).  If probs_cache_image is specified, then the
+      * probability tables also use the read-only caches in that image
+      * (written by writeCacheImage()), which are mapped into memory and so
+      * shared by every process on the host that uses the same image.
+      * Unlike the preloaded entries, the shared caches are not cleared by
+      * cleanup(). */
     void readCaches();
+    /** Add shared caches for this decoder's case type to the given cache
+      * image, holding the ngrams in the cache pre-load files (typically
+      * written after running on a representative corpus). */
+    void writeCacheImage(MappedModelImageWriter& writer);
 	void cleanup();
 	
 	ParseNode* returnDefaultParse(Symbol* sentence, int length, std::vector<Constraint> & constraints, bool collapseNPlabels);
 
 protected:
-	ChartEntry** chart[MAX_SENTENCE_LENGTH][MAX_SENTENCE_LENGTH];
+	/** The chart for the sentence that is being decoded: chart[i][j] is a
+	  * null-terminated array of the entries that span tokens i through j.
+	  * The chart is sized to fit the sentence, and is allocated in
+	  * chartArena by initChartCells(). */
+	class Chart {
+	public:
+		Chart(): _cells(0), _size(0) {}
+		ChartEntry*** operator[](size_t i) const { return _cells + i * _size; }
+		size_t size() const { return _size; }
+	private:
+		friend class ChartDecoder;
+		ChartEntry*** _cells;
+		size_t _size;
+	};
+	Chart chart;
+
+	/** Holds the chart and all of its entries.  The arena is reset by
+	  * cleanupChart() at the end of each sentence, so the memory used to
+	  * decode one sentence is reused for the next. */
+	ChartArena chartArena;
+
+	/** Clean up the previous sentence's chart (if that has not been done
+	  * yet), and allocate an empty chart with room for n_tokens tokens. */
+	void initChartCells(int n_tokens);
+
+	/** Discard the chart and reset chartArena.  Any entries that are still
+	  * in the chart must already have been destroyed. */
+	void releaseChart();
+
 	size_t punctuationUpperBound[MAX_SENTENCE_LENGTH];
 	bool nonRightClosableToken[MAX_SENTENCE_LENGTH];
 	bool nonLeftClosableToken[MAX_SENTENCE_LENGTH];
@@ -172,6 +237,8 @@ protected:
 	ParseNode* getMultipleParses(ChartEntry **possibleTrees, 
 		int numPossibleTrees, bool only_right_child);
 	
+	/** Destroy the entries in the first length rows and columns of the
+	  * chart, and then release the chart. */
 	void cleanupChart(int length);
 	void capLeft(ChartEntry* entry);
 	void capRight(ChartEntry* entry);
@@ -199,11 +266,14 @@ protected:
 
 	void startClock();
 	bool timedOut(Symbol* sentence, int length);
+	double getElapsedSeconds() const;
+	void updateAnytimeBeam();
+	void reportParseTime(int length, bool usedAnytimeFallback);
 	ParseNode* getDefaultParse(Symbol* sentence, int length, std::vector<Constraint> & constraints);
 	ParseNode* getCompletelyDefaultParse(Symbol* sentence, int length);
 	ParseNode* getBestFragment(int start, int end);
 
-	clock_t _startTime;
+	boost::posix_time::ptime _startTime; // wall-clock time
 	clock_t MAX_CLOCKS;
 
         float computePartialRankingScore(ChartEntry* entry);
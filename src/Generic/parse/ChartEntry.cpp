@@ -11,8 +11,6 @@
 
 
 const int ChartEntry::maxChain = CHART_ENTRY_MAX_CHAIN;
-const size_t ChartEntry::blockSize = CHART_ENTRY_BLOCK_SIZE;
-ChartEntry* ChartEntry::freeList = 0;
 SequentialBigrams *ChartEntry::sequentialBigrams = 0;
 //ParseNode* ChartEntry::name_premods = 0;
 
@@ -191,31 +189,3 @@ ParseNode* ChartEntry::addChain(ParseNode* base, const Symbol &chainSym)
     }
     return p3;
 }
-
-void* ChartEntry::operator new(size_t)
-{
-    ChartEntry* p = freeList;
-    if (p) {
-        freeList = p->next;
-    } else {
-		//std::cerr << "allocating new ChartEntry block" << std::endl;
-        ChartEntry* newBlock = static_cast<ChartEntry*>(::operator new(
-            blockSize * sizeof(ChartEntry)));
-        for (size_t i = 1; i < (blockSize - 1); i++)
-            newBlock[i].next = &newBlock[i + 1];
-        newBlock[blockSize - 1].next = 0;
-        p = newBlock;
-        freeList = &newBlock[1];
-    }
-    return p;
-}
-
-void ChartEntry::operator delete(void* object)
-{
-    ChartEntry* p = static_cast<ChartEntry*>(object);
-    p->next = freeList;
-    freeList = p;
-}
-
-
-
@@ -9,17 +9,22 @@
 #include "Generic/parse/BridgeType.h"
 #include "Generic/parse/BridgeKernel.h"
 #include "Generic/parse/BridgeExtension.h"
+#include "Generic/parse/ChartArena.h"
 #include "Generic/parse/SequentialBigrams.h"
 #include "Generic/parse/SignificantConstitNode.h"
 #include "Generic/parse/ParseNode.h"
 
 #define CHART_ENTRY_MAX_CHAIN 10
-#define CHART_ENTRY_BLOCK_SIZE 10000
 
+/** ChartEntries are allocated in the ChartDecoder's ChartArena, using
+  * new (arena) ChartEntry(...).  An entry owns its significantConstitNode,
+  * which must be allocated in the same arena.  Entries are never deleted:
+  * the decoder calls release() on entries that it discards while decoding
+  * a sentence, and destroys the remaining entries in bulk when it resets
+  * the arena at the end of the sentence. */
 class ChartEntry {
 private:
 	static const int maxChain;
-	static const size_t blockSize;
 	static SequentialBigrams * sequentialBigrams;
 	
 public:
@@ -124,18 +129,22 @@ public:
 		bridgeType(BRIDGE_TYPE_EXTENSION), extensionOp(extensionOp), isPreterminal(isPreterminal),
 		insideScore(0), rankingScore(0), leftCapScore(0), rightCapScore(0) {}
 
-	~ChartEntry()
-	{
-		delete significantConstitNode;
+	/** Destroy this entry, and return its memory (and the memory used by
+	  * its significantConstitNode) to the given arena, which must be the
+	  * arena that it was allocated in. */
+	void release(ChartArena &arena) {
+		SignificantConstitNode::release(significantConstitNode, arena);
+		this->~ChartEntry();
+		arena.recycle(this, sizeof(ChartEntry));
 	}
-	
-	static void* operator new(size_t n, int, char *, int) { return operator new(n); }
-	static void* operator new(size_t);
-	static void operator delete(void* object);
+
+	static void* operator new(size_t n, ChartArena &arena) { return arena.allocate(n); }
+	static void operator delete(void*, ChartArena &) {}
 private:
 	//static ParseNode* name_premods;
-	static ChartEntry* freeList;
-	ChartEntry* next;
+
+	// Entries are never deleted individually; see release().
+	static void operator delete(void* object);
 };
 
 #endif
@@ -20,6 +20,7 @@
 #include "Generic/parse/Constraint.h"
 #include "Generic/parse/ChartDecoder.h"
 #include "Generic/parse/LanguageSpecificFunctions.h"
+#include "Generic/common/MappedModelImage.h"
 #include "Generic/common/ParamReader.h"
 #include "Generic/common/SessionLogger.h"
 #include "Generic/common/UnexpectedInputException.h"
@@ -403,6 +404,20 @@ void DefaultParser::writeCaches() {
     _upperCaseDecoder->writeCaches();
 }
 
+void DefaultParser::writeCacheImage(const char* image_file) {
+  // Caches are named by case type (as pre-load files are), so if the
+  // default decoder has the same case type as one of the others, then
+  // only its caches are written.
+  MappedModelImageWriter writer;
+  if (_defaultDecoder)
+    _defaultDecoder->writeCacheImage(writer);
+  if (_lowerCaseDecoder && !(_defaultDecoder && _defaultDecoder->DECODER_TYPE == ChartDecoder::LOWER))
+    _lowerCaseDecoder->writeCacheImage(writer);
+  if (_upperCaseDecoder && !(_defaultDecoder && _defaultDecoder->DECODER_TYPE == ChartDecoder::UPPER))
+    _upperCaseDecoder->writeCacheImage(writer);
+  writer.write(image_file);
+}
+
 void DefaultParser::cleanup() {
   if (_defaultDecoder)
     _defaultDecoder->cleanup();
@@ -58,6 +58,9 @@ public:
 	ChartDecoder *getDecoder() { return _decoder; }
 
 	void writeCaches();
+	/** Write the shared probability caches for each of this parser's
+	  * decoders to a single cache image file (see probs_cache_image). */
+	void writeCacheImage(const char* image_file);
 	void cleanup();
 
 private:
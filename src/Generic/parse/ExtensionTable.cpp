@@ -42,6 +42,81 @@ ExtensionTable::ExtensionTable(UTF8InputStream& in)
     }
 }
 
+ExtensionTable::ExtensionTable(MappedModelImage::Section& section)
+{
+    MappedModelImage::WordReader in(section);
+    int numRecords = in.nextInt();
+    int numBuckets = static_cast<int>(numRecords / targetLoadingFactor);
+    table = _new Table(numBuckets);
+    for (int i = 0; i < numRecords; i++) {
+        ExtensionKey key;
+        key.branchingDirection = in.nextInt();
+        key.constituentCategory = in.nextSymbol();
+        key.headCategory = in.nextSymbol();
+        key.modifierBaseCategory = in.nextSymbol();
+        key.previousModifierCategory = in.nextSymbol();
+        key.modifierTag = in.nextSymbol();
+        int listLength = in.nextInt();
+        BridgeExtension* extensions = _new BridgeExtension[listLength];
+        for (int j = 0; j < listLength; j++) {
+            BridgeExtension& extension = extensions[j];
+            extension.branchingDirection = in.nextInt();
+            extension.constituentCategory = in.nextSymbol();
+            extension.headCategory = in.nextSymbol();
+            extension.previousModifierCategory = in.nextSymbol();
+            extension.modifierBaseCategory = in.nextSymbol();
+            extension.modifierChain = in.nextSymbol();
+            extension.modifierChainFront = in.nextSymbol();
+            extension.modifierTag = in.nextSymbol();
+        }
+        (*table)[key] = ExtensionList(listLength, extensions);
+    }
+}
+
+void ExtensionTable::compileImage(UTF8InputStream& in, MappedModelImageWriter& writer)
+{
+    int numRecords;
+    ExtensionKey key;
+    int listLength;
+    BridgeExtension extension;
+    UTF8Token token;
+    std::vector<boost::uint32_t> words;
+
+    in >> numRecords;
+    words.push_back(numRecords);
+    for (int i = 0; i < numRecords; i++) {
+        in >> token;
+        if (token.symValue() != ParserTags::leftParen)
+			throw UnexpectedInputException("ExtensionTable::compileImage()", "ERROR: ill-formed extension list");
+
+        in >> key;
+        words.push_back(key.branchingDirection);
+        words.push_back(writer.getSymbolId(key.constituentCategory));
+        words.push_back(writer.getSymbolId(key.headCategory));
+        words.push_back(writer.getSymbolId(key.modifierBaseCategory));
+        words.push_back(writer.getSymbolId(key.previousModifierCategory));
+        words.push_back(writer.getSymbolId(key.modifierTag));
+        in >> listLength;
+        words.push_back(listLength);
+        for (int j = 0; j < listLength; j++) {
+            in >> extension;
+            words.push_back(extension.branchingDirection);
+            words.push_back(writer.getSymbolId(extension.constituentCategory));
+            words.push_back(writer.getSymbolId(extension.headCategory));
+            words.push_back(writer.getSymbolId(extension.previousModifierCategory));
+            words.push_back(writer.getSymbolId(extension.modifierBaseCategory));
+            words.push_back(writer.getSymbolId(extension.modifierChain));
+            words.push_back(writer.getSymbolId(extension.modifierChainFront));
+            words.push_back(writer.getSymbolId(extension.modifierTag));
+        }
+
+        in >> token;
+        if (token.symValue() != ParserTags::rightParen)
+            throw UnexpectedInputException("ExtensionTable::compileImage()", "ERROR: ill-formed extension list");
+    }
+    writer.addBlock(words);
+}
+
 ExtensionTable::~ExtensionTable() {
 	if (table) {
 		Table::iterator iter;
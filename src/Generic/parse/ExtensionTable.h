@@ -11,6 +11,7 @@
 #include "Generic/parse/BridgeExtension.h"
 #include "Generic/parse/ExtensionKey.h"
 #include "Generic/common/Symbol.h"
+#include "Generic/common/MappedModelImage.h"
 
 class ExtensionTable {
 private:
@@ -47,7 +48,14 @@ private:
     };
 public:
     ExtensionTable(UTF8InputStream& in);
+    /** Read a table that was written by compileImage().  Unlike the
+      * probability tables, the extension table is copied out of the image. */
+    ExtensionTable(MappedModelImage::Section& section);
 	~ExtensionTable();
+
+    /** Read an extension table file, and add it to the current section of
+      * the given image writer (preserving the order of its records). */
+    static void compileImage(UTF8InputStream& in, MappedModelImageWriter& writer);
     typedef serif::hash_map<ExtensionKey, ExtensionList, HashKey, EqualKey> Table;
     typedef Table::iterator iterator;
     Table* table;
@@ -12,22 +12,46 @@ const char* HeadProbs::CacheSuffix = "head";
 
 HeadProbs::HeadProbs(UTF8InputStream& stream, 
                      CacheType cacheType, 
-                     long cacheMax)
+                     long cacheMax,
+                     size_t cacheShards)
   : fourGramLambda(_new NgramScoreTableGen<3>(stream)),
     triGramLambda(_new NgramScoreTableGen<2>(stream)),
     fourGramProb(_new NgramScoreTableGen<4>(stream)),
     triGramProb(_new NgramScoreTableGen<3>(stream)),
     biGramProb(_new NgramScoreTableGen<2>(stream)),
     cache_max(cacheMax),
-    simpleCache(cacheMax),
-#if !defined(_WIN32) && !defined(__APPLE_CC__)
-    lruCache(cache_max),
-#endif
-    cache_type(cacheType)
+    cache(cacheType == None ? 0 : cacheMax, cacheType == Lru, cacheShards),
+    cache_type(cacheType),
+    sharedCache(0)
 {
 }
 
+HeadProbs::HeadProbs(MappedModelImage::Section& section, 
+                     CacheType cacheType, 
+                     long cacheMax,
+                     size_t cacheShards)
+  : fourGramLambda(_new NgramScoreTableGen<3>(section)),
+    triGramLambda(_new NgramScoreTableGen<2>(section)),
+    fourGramProb(_new NgramScoreTableGen<4>(section)),
+    triGramProb(_new NgramScoreTableGen<3>(section)),
+    biGramProb(_new NgramScoreTableGen<2>(section)),
+    cache_max(cacheMax),
+    cache(cacheType == None ? 0 : cacheMax, cacheType == Lru, cacheShards),
+    cache_type(cacheType),
+    sharedCache(0)
+{
+}
+
+void HeadProbs::writeImage(MappedModelImageWriter& writer) {
+    fourGramLambda->writeImage(writer);
+    triGramLambda->writeImage(writer);
+    fourGramProb->writeImage(writer);
+    triGramProb->writeImage(writer);
+    biGramProb->writeImage(writer);
+}
+
 HeadProbs::~HeadProbs() {
+	if (sharedCache != 0)     { delete sharedCache; }
 	if (fourGramLambda != 0)  { delete fourGramLambda; }
 	if (triGramLambda != 0)   { delete triGramLambda; }
 	if (fourGramProb != 0)    { delete fourGramProb; }
@@ -37,32 +61,18 @@ HeadProbs::~HeadProbs() {
 
 float HeadProbs::lookup(Symbol *ngram)
 {
-    if (cache_type == Simple) {
-      // Simple cache
-      Cache<N>::simple::iterator iter = simpleCache.find(ngram);
-      if (iter != simpleCache.end()) {
-        return (*iter).second;
-      } else {
-        float value = computeValue(ngram);
-        simpleCache.insert(std::make_pair(ngram, value));
-        return value;
-      }
-#if !defined(_WIN32) && !defined(__APPLE_CC__)
-    } else if (cache_type == Lru) {
-      // LRU cache
-      Cache<N>::lru::iterator iter = lruCache.find(ngram);
-      if (iter != lruCache.end()) {
-        return (*iter).second;
-      } else {
-        float value = computeValue(ngram);
-        lruCache.insert(std::make_pair(ngram, value));
-        return value;
-      }        
-#endif
-    } else {
-      // no cache
+    float value;
+    if (sharedCache != 0 && sharedCache->find(ngram, value)) {
+      return value;
+    }
+    if (cache_type == None) {
       return computeValue(ngram);
     }
+    if (!cache.find(ngram, value)) {
+      value = computeValue(ngram);
+      cache.insert(ngram, value);
+    }
+    return value;
 }
 
 inline
@@ -112,17 +122,30 @@ float HeadProbs::lookupML(const Symbol &H,
 }
 
 void HeadProbs::readCache(const char* case_tag) {
-  CacheStorage<N>::readCache(case_tag, CacheSuffix, simpleCache, cache_max);
+  CacheStorage<N>::readCache(case_tag, CacheSuffix, cache, cache_max);
 }
 
 void HeadProbs::writeCache(const char* case_tag) {
-  CacheStorage<N>::writeCache(case_tag, CacheSuffix, simpleCache);
+  CacheStorage<N>::writeCache(case_tag, CacheSuffix, cache);
+}
+
+void HeadProbs::readCacheImage(boost::shared_ptr<const MappedModelImage> image, const char* case_tag) {
+  delete sharedCache;
+  sharedCache = CacheStorage<N>::readImage(image, case_tag, CacheSuffix, 0);
+}
+
+void HeadProbs::writeCacheImage(const char* case_tag, MappedModelImageWriter& writer) const {
+  NgramScoreTableGen<N> profile(1000);
+  if (!CacheStorage<N>::readProfile(case_tag, CacheSuffix, 0, profile))
+    return;
+  // Store exact values, rather than the rounded values from the pre-load file.
+  for (NgramScoreTableGen<N>::Table::iterator iter = profile.get_start(); iter != profile.get_end(); ++iter)
+    (*iter).second = computeValue((*iter).first);
+  CacheStorage<N>::writeImage(case_tag, CacheSuffix, 0, profile, writer);
 }
 
 void HeadProbs::clearCache() {
-	simpleCache.clear();
-#if !defined(_WIN32) && !defined(__APPLE_CC__)
-	lruCache.clear();
-#endif
+	cache.logStats(CacheSuffix);
+	cache.clear();
 }
 
@@ -42,6 +42,79 @@ KernelTable::KernelTable(UTF8InputStream& in)
     }
 }
 
+KernelTable::KernelTable(MappedModelImage::Section& section)
+{
+    MappedModelImage::WordReader in(section);
+    int numRecords = in.nextInt();
+    int numBuckets = static_cast<int>(numRecords / targetLoadingFactor);
+    table = _new Table(numBuckets);
+    for (int i = 0; i < numRecords; i++) {
+        KernelKey key;
+        key.branchingDirection = in.nextInt();
+        key.headBaseCategory = in.nextSymbol();
+        key.modifierBaseCategory = in.nextSymbol();
+        key.modifierTag = in.nextSymbol();
+        int listLength = in.nextInt();
+        BridgeKernel* kernels = _new BridgeKernel[listLength];
+        for (int j = 0; j < listLength; j++) {
+            BridgeKernel& kernel = kernels[j];
+            kernel.branchingDirection = in.nextInt();
+            kernel.constituentCategory = in.nextSymbol();
+            kernel.headBaseCategory = in.nextSymbol();
+            kernel.modifierBaseCategory = in.nextSymbol();
+            kernel.headChain = in.nextSymbol();
+            kernel.headChainFront = in.nextSymbol();
+            kernel.modifierChain = in.nextSymbol();
+            kernel.modifierChainFront = in.nextSymbol();
+            kernel.modifierTag = in.nextSymbol();
+        }
+        (*table)[key] = KernelList(listLength, kernels);
+    }
+}
+
+void KernelTable::compileImage(UTF8InputStream& in, MappedModelImageWriter& writer)
+{
+    int numRecords;
+    KernelKey key;
+    int listLength;
+    BridgeKernel kernel;
+    UTF8Token token;
+    std::vector<boost::uint32_t> words;
+
+    in >> numRecords;
+    words.push_back(numRecords);
+    for (int i = 0; i < numRecords; i++) {
+        in >> token;
+        if (token.symValue() != ParserTags::leftParen)
+            throw UnexpectedInputException("KernelTable::compileImage()","ERROR: ill-formed kernel list");
+
+        in >> key;
+        words.push_back(key.branchingDirection);
+        words.push_back(writer.getSymbolId(key.headBaseCategory));
+        words.push_back(writer.getSymbolId(key.modifierBaseCategory));
+        words.push_back(writer.getSymbolId(key.modifierTag));
+        in >> listLength;
+        words.push_back(listLength);
+        for (int j = 0; j < listLength; j++) {
+            in >> kernel;
+            words.push_back(kernel.branchingDirection);
+            words.push_back(writer.getSymbolId(kernel.constituentCategory));
+            words.push_back(writer.getSymbolId(kernel.headBaseCategory));
+            words.push_back(writer.getSymbolId(kernel.modifierBaseCategory));
+            words.push_back(writer.getSymbolId(kernel.headChain));
+            words.push_back(writer.getSymbolId(kernel.headChainFront));
+            words.push_back(writer.getSymbolId(kernel.modifierChain));
+            words.push_back(writer.getSymbolId(kernel.modifierChainFront));
+            words.push_back(writer.getSymbolId(kernel.modifierTag));
+        }
+
+        in >> token;
+        if (token.symValue() != ParserTags::rightParen)
+            throw UnexpectedInputException("KernelTable::compileImage()","ERROR: ill-formed kernel list");
+    }
+    writer.addBlock(words);
+}
+
 KernelTable::~KernelTable() {
 	if (table) {
 		Table::iterator iter;
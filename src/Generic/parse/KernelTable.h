@@ -14,6 +14,7 @@
 #include "Generic/parse/BridgeKernel.h"
 #include "Generic/parse/KernelKey.h"
 #include "Generic/common/Symbol.h"
+#include "Generic/common/MappedModelImage.h"
 
 class KernelTable {
 private:
@@ -46,7 +47,14 @@ private:
     };
 public:
     KernelTable(UTF8InputStream& in);
+    /** Read a table that was written by compileImage().  Unlike the
+      * probability tables, the kernel table is copied out of the image. */
+    KernelTable(MappedModelImage::Section& section);
 	~KernelTable();
+
+    /** Read a kernel table file, and add it to the current section of
+      * the given image writer (preserving the order of its records). */
+    static void compileImage(UTF8InputStream& in, MappedModelImageWriter& writer);
 #if defined(_WIN32) || defined(__APPLE_CC__)
     typedef serif::hash_map<KernelKey, KernelList, HashKey, EqualKey> Table;
 #else
@@ -13,7 +13,8 @@ const char* LexicalProbs::CacheSuffix = "lex";
 LexicalProbs::LexicalProbs(UTF8InputStream& stream, 
                            CacheType cacheType, 
                            long cacheMax, 
-                           const char* cacheTag)
+                           const char* cacheTag,
+                           size_t cacheShards)
   :
     sevenGramLambda(_new NgramScoreTableGen<6>(stream)),
     sixGramLambda(_new NgramScoreTableGen<5>(stream)),
@@ -23,16 +24,46 @@ LexicalProbs::LexicalProbs(UTF8InputStream& stream,
     triGramProb(_new NgramScoreTableGen<3>(stream)),
     biGramProb(_new NgramScoreTableGen<2>(stream)),
     cache_max(cacheMax),
-    simpleCache(cacheMax),
-#if !defined(_WIN32) && !defined(__APPLE_CC__)
-    lruCache(cache_max),
-#endif
+    cache(cacheType == None ? 0 : cacheMax, cacheType == Lru, cacheShards),
     cache_type(cacheType),
+    sharedCache(0),
     cache_tag(cacheTag)
 {
 }
 
+LexicalProbs::LexicalProbs(MappedModelImage::Section& section, 
+                           CacheType cacheType, 
+                           long cacheMax, 
+                           const char* cacheTag,
+                           size_t cacheShards)
+  :
+    sevenGramLambda(_new NgramScoreTableGen<6>(section)),
+    sixGramLambda(_new NgramScoreTableGen<5>(section)),
+    triGramLambda(_new NgramScoreTableGen<2>(section)),
+    sevenGramProb(_new NgramScoreTableGen<7>(section)),
+    sixGramProb(_new NgramScoreTableGen<6>(section)),
+    triGramProb(_new NgramScoreTableGen<3>(section)),
+    biGramProb(_new NgramScoreTableGen<2>(section)),
+    cache_max(cacheMax),
+    cache(cacheType == None ? 0 : cacheMax, cacheType == Lru, cacheShards),
+    cache_type(cacheType),
+    sharedCache(0),
+    cache_tag(cacheTag)
+{
+}
+
+void LexicalProbs::writeImage(MappedModelImageWriter& writer) {
+    sevenGramLambda->writeImage(writer);
+    sixGramLambda->writeImage(writer);
+    triGramLambda->writeImage(writer);
+    sevenGramProb->writeImage(writer);
+    sixGramProb->writeImage(writer);
+    triGramProb->writeImage(writer);
+    biGramProb->writeImage(writer);
+}
+
 LexicalProbs::~LexicalProbs() {
+	if (sharedCache != 0)     { delete sharedCache; }
 	if (sevenGramLambda != 0) { delete sevenGramLambda; }
 	if (sixGramLambda != 0)   { delete sixGramLambda; }
 	if (triGramLambda != 0)   { delete triGramLambda; }
@@ -44,32 +75,18 @@ LexicalProbs::~LexicalProbs() {
 
 float LexicalProbs::lookup(const LexicalProbs* altProbs, Symbol* ngram)
 {
-    if (cache_type == Simple) {
-      // Simple cache
-      Cache<N>::simple::iterator iter = simpleCache.find(ngram);
-      if (iter != simpleCache.end()) {
-        return (*iter).second;
-      } else {
-        float value = computeValue(altProbs, ngram);
-        simpleCache.insert(std::make_pair(ngram, value));
-        return value;
-      }
-#if !defined(_WIN32) && !defined(__APPLE_CC__)
-    } else if (cache_type == Lru) {
-      // LRU cache
-      Cache<N>::lru::iterator iter = lruCache.find(ngram);
-      if (iter != lruCache.end()) {
-        return (*iter).second;
-      } else {
-        float value = computeValue(altProbs, ngram);
-        lruCache.insert(std::make_pair(ngram, value));
-        return value;
-      }        
-#endif
-    } else {
-      // no cache
+    float value;
+    if (sharedCache != 0 && sharedCache->find(ngram, value)) {
+      return value;
+    }
+    if (cache_type == None) {
       return computeValue(altProbs, ngram);
     }
+    if (!cache.find(ngram, value)) {
+      value = computeValue(altProbs, ngram);
+      cache.insert(ngram, value);
+    }
+    return value;
 }
 
 inline
@@ -136,16 +153,29 @@ float LexicalProbs::lookupML(const Symbol &mw, const Symbol &mt) const
 }
 
 void LexicalProbs::readCache(const char* case_tag) {
-  CacheStorage<N>::readCache(case_tag, CacheSuffix, cache_tag, simpleCache, cache_max);
+  CacheStorage<N>::readCache(case_tag, CacheSuffix, cache_tag, cache, cache_max);
 }
 
 void LexicalProbs::writeCache(const char* case_tag) {
-  CacheStorage<N>::writeCache(case_tag, CacheSuffix, cache_tag, simpleCache);
+  CacheStorage<N>::writeCache(case_tag, CacheSuffix, cache_tag, cache);
+}
+
+void LexicalProbs::readCacheImage(boost::shared_ptr<const MappedModelImage> image, const char* case_tag) {
+  delete sharedCache;
+  sharedCache = CacheStorage<N>::readImage(image, case_tag, CacheSuffix, cache_tag);
+}
+
+void LexicalProbs::writeCacheImage(const LexicalProbs* altProbs, const char* case_tag, MappedModelImageWriter& writer) const {
+  NgramScoreTableGen<N> profile(1000);
+  if (!CacheStorage<N>::readProfile(case_tag, CacheSuffix, cache_tag, profile))
+    return;
+  // Store exact values, rather than the rounded values from the pre-load file.
+  for (NgramScoreTableGen<N>::Table::iterator iter = profile.get_start(); iter != profile.get_end(); ++iter)
+    (*iter).second = computeValue(altProbs, (*iter).first);
+  CacheStorage<N>::writeImage(case_tag, CacheSuffix, cache_tag, profile, writer);
 }
 
 void LexicalProbs::clearCache() {
-	simpleCache.clear();
-#if !defined(_WIN32) && !defined(__APPLE_CC__)
-	lruCache.clear();
-#endif
+	cache.logStats(std::string(cache_tag) + "-" + CacheSuffix);
+	cache.clear();
 }
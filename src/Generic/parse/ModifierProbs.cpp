@@ -13,23 +13,49 @@ const char* ModifierProbs::CacheSuffix = "mod";
 ModifierProbs::ModifierProbs(UTF8InputStream& stream, 
                              CacheType cacheType, 
                              long cacheMax, 
-                             const char* cacheTag)
+                             const char* cacheTag,
+                             size_t cacheShards)
   : sevenGramLambda(_new NgramScoreTableGen<5>(stream)),
     sixGramLambda(_new NgramScoreTableGen<4>(stream)),
     sevenGramProb(_new NgramScoreTableGen<7>(stream)),
     sixGramProb(_new NgramScoreTableGen<6>(stream)),
     fiveGramProb(_new NgramScoreTableGen<5>(stream)),
     cache_max(cacheMax),
-    simpleCache(cacheMax),
-#if !defined(_WIN32) && !defined(__APPLE_CC__)
-    lruCache(cache_max),
-#endif
+    cache(cacheType == None ? 0 : cacheMax, cacheType == Lru, cacheShards),
     cache_type(cacheType),
+    sharedCache(0),
     cache_tag(cacheTag)
 {
 }
 
+ModifierProbs::ModifierProbs(MappedModelImage::Section& section, 
+                             CacheType cacheType, 
+                             long cacheMax, 
+                             const char* cacheTag,
+                             size_t cacheShards)
+  : sevenGramLambda(_new NgramScoreTableGen<5>(section)),
+    sixGramLambda(_new NgramScoreTableGen<4>(section)),
+    sevenGramProb(_new NgramScoreTableGen<7>(section)),
+    sixGramProb(_new NgramScoreTableGen<6>(section)),
+    fiveGramProb(_new NgramScoreTableGen<5>(section)),
+    cache_max(cacheMax),
+    cache(cacheType == None ? 0 : cacheMax, cacheType == Lru, cacheShards),
+    cache_type(cacheType),
+    sharedCache(0),
+    cache_tag(cacheTag)
+{
+}
+
+void ModifierProbs::writeImage(MappedModelImageWriter& writer) {
+    sevenGramLambda->writeImage(writer);
+    sixGramLambda->writeImage(writer);
+    sevenGramProb->writeImage(writer);
+    sixGramProb->writeImage(writer);
+    fiveGramProb->writeImage(writer);
+}
+
 ModifierProbs::~ModifierProbs() {
+	if (sharedCache != 0)     { delete sharedCache; }
 	if (sevenGramLambda != 0) { delete sevenGramLambda; }
 	if (sixGramLambda != 0)   { delete sixGramLambda; }
 	if (sevenGramProb != 0)   { delete sevenGramProb; }
@@ -39,32 +65,18 @@ ModifierProbs::~ModifierProbs() {
 
 float ModifierProbs::lookup(Symbol* ngram)
 {
-    if (cache_type == Simple) {
-      // Simple cache
-      Cache<N>::simple::iterator iter = simpleCache.find(ngram);
-      if (iter != simpleCache.end()) {
-        return (*iter).second;
-      } else {
-        float value = computeValue(ngram);
-        simpleCache.insert(std::make_pair(ngram, value));
-        return value;
-      }
-#if !defined(_WIN32) && !defined(__APPLE_CC__)
-    } else if (cache_type == Lru) {
-      // LRU cache
-      Cache<N>::lru::iterator iter = lruCache.find(ngram);
-      if (iter != lruCache.end()) {
-        return (*iter).second;
-      } else {
-        float value = computeValue(ngram);
-        lruCache.insert(std::make_pair(ngram, value));
-        return value;
-      }        
-#endif
-    } else {
-      // no cache
+    float value;
+    if (sharedCache != 0 && sharedCache->find(ngram, value)) {
+      return value;
+    }
+    if (cache_type == None) {
       return computeValue(ngram);
     }
+    if (!cache.find(ngram, value)) {
+      value = computeValue(ngram);
+      cache.insert(ngram, value);
+    }
+    return value;
 }
 
 inline
@@ -123,16 +135,29 @@ float ModifierProbs::lookupML(const Symbol &M,
 
 
 void ModifierProbs::readCache(const char* case_tag) {
-  CacheStorage<N>::readCache(case_tag, CacheSuffix, cache_tag, simpleCache, cache_max);
+  CacheStorage<N>::readCache(case_tag, CacheSuffix, cache_tag, cache, cache_max);
 }
 
 void ModifierProbs::writeCache(const char* case_tag) {
-  CacheStorage<N>::writeCache(case_tag, CacheSuffix, cache_tag, simpleCache);
+  CacheStorage<N>::writeCache(case_tag, CacheSuffix, cache_tag, cache);
+}
+
+void ModifierProbs::readCacheImage(boost::shared_ptr<const MappedModelImage> image, const char* case_tag) {
+  delete sharedCache;
+  sharedCache = CacheStorage<N>::readImage(image, case_tag, CacheSuffix, cache_tag);
+}
+
+void ModifierProbs::writeCacheImage(const char* case_tag, MappedModelImageWriter& writer) const {
+  NgramScoreTableGen<N> profile(1000);
+  if (!CacheStorage<N>::readProfile(case_tag, CacheSuffix, cache_tag, profile))
+    return;
+  // Store exact values, rather than the rounded values from the pre-load file.
+  for (NgramScoreTableGen<N>::Table::iterator iter = profile.get_start(); iter != profile.get_end(); ++iter)
+    (*iter).second = computeValue((*iter).first);
+  CacheStorage<N>::writeImage(case_tag, CacheSuffix, cache_tag, profile, writer);
 }
 
 void ModifierProbs::clearCache() {
-	simpleCache.clear();
-#if !defined(_WIN32) && !defined(__APPLE_CC__)
-	lruCache.clear();
-#endif
+	cache.logStats(std::string(cache_tag) + "-" + CacheSuffix);
+	cache.clear();
 }
@@ -20,16 +20,17 @@ private:
     NgramScoreTableGen<6>* sixGramProb;
     NgramScoreTableGen<5>* fiveGramProb;
     long cache_max;
-    Cache<N>::simple simpleCache;
-#if !defined(_WIN32) && !defined(__APPLE_CC__)
-    Cache<N>::lru lruCache;
-#endif
+    NGramCache<N> cache;
     CacheType cache_type;
+    // Read-only cache from a cache image (see readCacheImage()), which is
+    // checked before the cache above.
+    NgramScoreTableGen<N>* sharedCache;
     static const char* CacheSuffix;
     const char* cache_tag;
 public:
-    ModifierProbs(UTF8InputStream& stream, CacheType cacheType, long cacheMax, const char* cache_tag);
-    ModifierProbs() : cache_max(0), cache_type(None), cache_tag("") {}
+    ModifierProbs(UTF8InputStream& stream, CacheType cacheType, long cacheMax, const char* cache_tag, size_t cacheShards=1);
+    ModifierProbs(MappedModelImage::Section& section, CacheType cacheType, long cacheMax, const char* cache_tag, size_t cacheShards=1);
+    ModifierProbs() : cache_max(0), cache_type(None), sharedCache(0), cache_tag("") {}
 	~ModifierProbs();
     float lookup(const Symbol &M, const Symbol &mt, const Symbol &P, const Symbol &H, const Symbol &PR,
 	             const Symbol &w, const Symbol &t) {
@@ -53,8 +54,19 @@ public:
       fiveGramProb = mpd->get_modifierTransitions_PHp();
     }
 
+    /** Add these tables to the current section of the given image writer,
+      * in the order in which the image constructor reads them. */
+    void writeImage(MappedModelImageWriter& writer);
+
     void readCache(const char* case_tag);
     void writeCache(const char* case_tag);
+    /** Look up ngrams in the given cache image's cache for this table
+      * (if it has one) before looking in this table's own cache. */
+    void readCacheImage(boost::shared_ptr<const MappedModelImage> image, const char* case_tag);
+    /** Add a cache for this table to the current cache image, holding the
+      * ngrams in this table's cache pre-load file and their values.  Does
+      * nothing if there is no pre-load file. */
+    void writeCacheImage(const char* case_tag, MappedModelImageWriter& writer) const;
 	void clearCache();
 
 };
@@ -11,7 +11,12 @@
 #include "Generic/parse/ParserTags.h"
 
 #include "Generic/parse/LanguageSpecificFunctions.h"
+#include "dynamic_includes/common/SymbolDefinitions.h"
 
+#ifdef SYMBOL_THREADSAFE
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/tss.hpp>
+#endif
 
 using namespace std;
 
@@ -19,6 +24,50 @@ using namespace std;
 const size_t ParseNode::blockSize = PARSE_NODE_BLOCK_SIZE;
 ParseNode* ParseNode::freeList = 0;
 
+#ifdef SYMBOL_THREADSAFE
+// When Serif is built to be thread-safe, several threads may build parse
+// trees at once (e.g., the SerifHTTPServer's worker threads), so each
+// thread allocates ParseNodes from its own free list, and freeList is not
+// used.  A node that is deleted by a thread other than the one that
+// allocated it simply joins the deleting thread's free list.  When a
+// thread exits, the nodes on its free list are moved to a shared free
+// list, which threads use before they allocate a new block.
+namespace {
+	struct ThreadFreeList {
+		ParseNode *head;
+		ThreadFreeList(): head(0) {}
+		~ThreadFreeList();
+	};
+	boost::mutex sharedFreeListMutex;
+	ParseNode *sharedFreeList = 0;
+	boost::thread_specific_ptr<ThreadFreeList> threadFreeList;
+
+	ThreadFreeList::~ThreadFreeList() {
+		if (head == 0) return;
+		ParseNode *tail = head;
+		while (tail->next)
+			tail = tail->next;
+		boost::mutex::scoped_lock lock(sharedFreeListMutex);
+		tail->next = sharedFreeList;
+		sharedFreeList = head;
+	}
+
+	ParseNode *&getThreadFreeList() {
+		ThreadFreeList *list = threadFreeList.get();
+		if (list == 0) {
+			list = _new ThreadFreeList();
+			threadFreeList.reset(list);
+		}
+		if (list->head == 0) {
+			boost::mutex::scoped_lock lock(sharedFreeListMutex);
+			list->head = sharedFreeList;
+			sharedFreeList = 0;
+		}
+		return list->head;
+	}
+}
+#endif
+
 string ParseNode::toDebugString()
 {	
 if (headNode == 0){
@@ -215,6 +264,9 @@ ParseNode* ParseNode::getHeadPreterm(){
 
 void* ParseNode::operator new(size_t)
 {
+#ifdef SYMBOL_THREADSAFE
+    ParseNode*& freeList = getThreadFreeList();
+#endif
     ParseNode* p = freeList;
     if (p) {
         freeList = p->next;
@@ -234,6 +286,9 @@ void* ParseNode::operator new(size_t)
 void ParseNode::operator delete(void* object)
 {
     ParseNode* p = static_cast<ParseNode*>(object);
+#ifdef SYMBOL_THREADSAFE
+    ParseNode*& freeList = getThreadFreeList();
+#endif
     p->next = freeList;
     freeList = p;
 }
@@ -18,8 +18,8 @@ PartOfSpeechTable::PartOfSpeechTable(UTF8InputStream& in)
     int numBuckets;
     UTF8Token token;
     Symbol word;
-    TableEntry entry;
     int numTags;
+    std::vector<Symbol> tags;
 
 	int max_pos_tags = ParamReader::getOptionalIntParamWithDefaultValue("maximum_pos_tags", 99999);
 	bool prune_pos_tags = ParamReader::isParamTrue("prune_pos_tags");
@@ -36,48 +36,114 @@ PartOfSpeechTable::PartOfSpeechTable(UTF8InputStream& in)
         in >> token;
         word = token.symValue();
         in >> numTags;
-     
-        entry.tags = _new Symbol[numTags];
-
-		int tag_count = 0;
-
-		bool found_noun = false;
-		bool found_verb = false;
-		bool found_adj = false;
 
+        tags.clear();
         for (int j = 0; j < numTags; j++) {
             in >> token;
-            
-			if (LanguageSpecificFunctions::isNoun(token.symValue()) && prune_pos_tags) {
-				if (found_noun) 
-					continue;
-				found_noun = true;
-			}
-
-			if (LanguageSpecificFunctions::isVerbPOSLabel(token.symValue()) && prune_pos_tags) {
-				if (found_verb) 
-					continue;
-				found_verb = true;
-			}
-
-			if (LanguageSpecificFunctions::isAdjective(token.symValue()) && prune_pos_tags) {
-				if (found_adj)
-					continue;
-				found_adj = true;
-			}
-
-			if (tag_count < max_pos_tags)
-				entry.tags[tag_count++] = token.symValue();
+            tags.push_back(token.symValue());
         }
 
-		entry.numTags = tag_count;
         in >> token;
         if (token.symValue() != ParserTags::rightParen)
             throw UnexpectedInputException("PartOfSpeechTable::()",
                 "ERROR: problem reading part-of-speech table");
-        (*table)[word] = entry;
+        addEntry(word, tags, max_pos_tags, prune_pos_tags);
+    }
+
+}
+
+PartOfSpeechTable::PartOfSpeechTable(MappedModelImage::Section& section)
+{
+	int max_pos_tags = ParamReader::getOptionalIntParamWithDefaultValue("maximum_pos_tags", 99999);
+	bool prune_pos_tags = ParamReader::isParamTrue("prune_pos_tags");
+
+    MappedModelImage::WordReader in(section);
+    int numEntries = in.nextInt();
+    int numBuckets = static_cast<int>(numEntries / targetLoadingFactor);
+    table = _new Table(numBuckets);
+    std::vector<Symbol> tags;
+    for (int i = 0; i < numEntries; i++) {
+        Symbol word = in.nextSymbol();
+        int numTags = in.nextInt();
+        tags.clear();
+        for (int j = 0; j < numTags; j++) {
+            tags.push_back(in.nextSymbol());
+        }
+        addEntry(word, tags, max_pos_tags, prune_pos_tags);
+    }
+}
+
+void PartOfSpeechTable::compileImage(UTF8InputStream& in, MappedModelImageWriter& writer)
+{
+    int numEntries;
+    UTF8Token token;
+    int numTags;
+    std::vector<boost::uint32_t> words;
+
+    in >> numEntries;
+    words.push_back(0); // number of entries actually read; filled in below
+    int numRead = 0;
+    for (int i = 0; i < numEntries; i++) {
+        in >> token;
+        if (in.eof()) break;
+        if (token.symValue() != ParserTags::leftParen)
+			throw UnexpectedInputException("PartOfSpeechTable::compileImage()",
+                "ERROR: problem reading part-of-speech table");
+        in >> token;
+        words.push_back(writer.getSymbolId(token.symValue()));
+        in >> numTags;
+        words.push_back(numTags);
+        for (int j = 0; j < numTags; j++) {
+            in >> token;
+            words.push_back(writer.getSymbolId(token.symValue()));
+        }
+        in >> token;
+        if (token.symValue() != ParserTags::rightParen)
+            throw UnexpectedInputException("PartOfSpeechTable::compileImage()",
+                "ERROR: problem reading part-of-speech table");
+        numRead++;
+    }
+    words[0] = numRead;
+    writer.addBlock(words);
+}
+
+void PartOfSpeechTable::addEntry(Symbol word, const std::vector<Symbol>& tags, 
+                                 int max_pos_tags, bool prune_pos_tags)
+{
+    TableEntry entry;
+    entry.tags = _new Symbol[tags.size()];
+
+	int tag_count = 0;
+
+	bool found_noun = false;
+	bool found_verb = false;
+	bool found_adj = false;
+
+    for (size_t j = 0; j < tags.size(); j++) {
+		if (LanguageSpecificFunctions::isNoun(tags[j]) && prune_pos_tags) {
+			if (found_noun) 
+				continue;
+			found_noun = true;
+		}
+
+		if (LanguageSpecificFunctions::isVerbPOSLabel(tags[j]) && prune_pos_tags) {
+			if (found_verb) 
+				continue;
+			found_verb = true;
+		}
+
+		if (LanguageSpecificFunctions::isAdjective(tags[j]) && prune_pos_tags) {
+			if (found_adj)
+				continue;
+			found_adj = true;
+		}
+
+		if (tag_count < max_pos_tags)
+			entry.tags[tag_count++] = tags[j];
     }
 
+	entry.numTags = tag_count;
+    (*table)[word] = entry;
 }
 
 PartOfSpeechTable::~PartOfSpeechTable() {
@@ -8,6 +8,8 @@
 #include "Generic/common/UTF8InputStream.h"
 #include "Generic/common/hash_map.h"
 #include "Generic/common/Symbol.h"
+#include "Generic/common/MappedModelImage.h"
+#include <vector>
 
 
 class PartOfSpeechTable {
@@ -29,12 +31,21 @@ private:
     };
     typedef serif::hash_map<Symbol, TableEntry, HashKey, EqualKey> Table;
     Table* table;
+    void addEntry(Symbol word, const std::vector<Symbol>& tags, int max_pos_tags, bool prune_pos_tags);
 public:
 	PartOfSpeechTable(){
 		table = _new Table(5);
 	}
 	~PartOfSpeechTable();
     PartOfSpeechTable(UTF8InputStream& in);
+    /** Read a table that was written by compileImage().  The image holds
+      * the unpruned tag lists, so the maximum_pos_tags and prune_pos_tags
+      * parameters are applied here, just as they are for text tables. */
+    PartOfSpeechTable(MappedModelImage::Section& section);
+
+    /** Read a part-of-speech table file, and add it to the current
+      * section of the given image writer. */
+    static void compileImage(UTF8InputStream& in, MappedModelImageWriter& writer);
     const Symbol* lookup(Symbol word, int& numTags) const;
 };
 
@@ -10,6 +10,10 @@ PriorProbTable::PriorProbTable(UTF8InputStream& in)
 {
     table =_new NgramScoreTable(2, in);
 }
+PriorProbTable::PriorProbTable(MappedModelImage::Section& section)
+{
+    table =_new NgramScoreTable(2, section);
+}
 PriorProbTable::~PriorProbTable() {
 	delete table;
 }
@@ -14,8 +14,10 @@ private:
     NgramScoreTable* table;
 public:
     PriorProbTable(UTF8InputStream& in);
+    PriorProbTable(MappedModelImage::Section& section);
 	~PriorProbTable();
     float lookup(Symbol category, Symbol tag) const;
+    void writeImage(MappedModelImageWriter& writer) { table->writeImage(writer); }
 };
 
 #endif
@@ -10,9 +10,6 @@
 
 using namespace std;
 
-const size_t SignificantConstitNode::blockSize = SIGCON_NODE_BLOCK_SIZE;
-SignificantConstitNode* SignificantConstitNode::freeList = 0;
-
 string SignificantConstitNode::toString() 
 {
 	if (count == 0)
@@ -36,7 +33,6 @@ string SignificantConstitNode::toString()
 	
 }
 
-void* SignificantConstitNode::operator new(size_t n, int, char *, int) { return operator new(n); }
 
 SignificantConstitNode::SignificantConstitNode () {
 	left = -1;
@@ -46,8 +42,8 @@ SignificantConstitNode::SignificantConstitNode () {
 	count = 0;
 }
 
-SignificantConstitNode::SignificantConstitNode (SignificantConstitNode *n) {
-	copyIn(n);
+SignificantConstitNode::SignificantConstitNode (ChartArena &arena, SignificantConstitNode *n) {
+	copyIn(arena, n);
 }
 
 SignificantConstitNode::SignificantConstitNode (int _left, int _right) {
@@ -59,7 +55,7 @@ SignificantConstitNode::SignificantConstitNode (int _left, int _right) {
 
 }
 
-SignificantConstitNode::SignificantConstitNode(bool left_is_constit, 
+SignificantConstitNode::SignificantConstitNode(ChartArena &arena, bool left_is_constit, 
 	SignificantConstitNode *leftNode, int lltok, int lrtok, bool right_is_constit, 
 	SignificantConstitNode *rightNode, int rltok, int rrtok)
 {
@@ -70,12 +66,12 @@ SignificantConstitNode::SignificantConstitNode(bool left_is_constit,
 	count = 0;
 
 	if (leftNode->count != 0) {
-		copyIn(leftNode);
+		copyIn(arena, leftNode);
 	}
 
 	if (left_is_constit) {
 		if (left >= 0) 
-			addElement(lltok, lrtok);
+			addElement(arena, lltok, lrtok);
 		else {
 			left = lltok;
 			right = lrtok;
@@ -86,13 +82,13 @@ SignificantConstitNode::SignificantConstitNode(bool left_is_constit,
 	
 	if (rightNode->count != 0) {
 		if (left >= 0) 
-			addNode(rightNode);
-		else copyIn(rightNode);
+			addNode(arena, rightNode);
+		else copyIn(arena, rightNode);
 	}
 
 	if (right_is_constit) {
 		if (left >= 0) 
-			addElement(rltok, rrtok);
+			addElement(arena, rltok, rrtok);
 		else {
 			left = rltok;
 			right = rrtok;
@@ -101,54 +97,31 @@ SignificantConstitNode::SignificantConstitNode(bool left_is_constit,
 	}
 }
 
-SignificantConstitNode::~SignificantConstitNode()
-{
-	delete next;
-}
-
-void* SignificantConstitNode::operator new(size_t)
-{
-    SignificantConstitNode* p = freeList;
-    if (p) {
-        freeList = p->next;
-    } else {
-		//cerr << "allocating new SignificantConstitNode block" << endl;
-        SignificantConstitNode* newBlock = 
-			static_cast<SignificantConstitNode*>(::operator new(
-				blockSize * sizeof(SignificantConstitNode)));
-        for (size_t i = 1; i < (blockSize - 1); i++)
-            newBlock[i].next = &newBlock[i + 1];
-        newBlock[blockSize - 1].next = 0;
-        p = newBlock;
-        freeList = &newBlock[1];
-    }
-    return p;
-}
-
-void SignificantConstitNode::operator delete(void* object)
-{
-    SignificantConstitNode* p = static_cast<SignificantConstitNode*>(object);
-    p->next = freeList;
-    freeList = p;
+void SignificantConstitNode::release(SignificantConstitNode *node, ChartArena &arena) {
+	while (node != 0) {
+		SignificantConstitNode *next = node->next;
+		arena.recycle(node, sizeof(SignificantConstitNode));
+		node = next;
+	}
 }
 
-void SignificantConstitNode::addNode(SignificantConstitNode *n) {
-	tail->next = _new SignificantConstitNode(n);
+void SignificantConstitNode::addNode(ChartArena &arena, SignificantConstitNode *n) {
+	tail->next = new (arena) SignificantConstitNode(arena, n);
 	tail = tail->next->tail;
 	count = count + n->count;
 }
 
-void SignificantConstitNode::addElement(int _left, int _right) {
-	tail->next = _new SignificantConstitNode(_left, _right);
+void SignificantConstitNode::addElement(ChartArena &arena, int _left, int _right) {
+	tail->next = new (arena) SignificantConstitNode(_left, _right);
 	tail = tail->next;
 	count++;
 }
 
-void SignificantConstitNode::copyIn(SignificantConstitNode *n) {
+void SignificantConstitNode::copyIn(ChartArena &arena, SignificantConstitNode *n) {
 	left = n->left;
 	right = n->right;
 	if (n->next != 0) {
-		next = _new SignificantConstitNode(n->next);
+		next = new (arena) SignificantConstitNode(arena, n->next);
 		tail = next->tail;
 	} else {
 		next = 0;
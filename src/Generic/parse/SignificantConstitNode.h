@@ -5,12 +5,14 @@
 #define SIGCON_NODE_H
 
 #include "Generic/common/Symbol.h"
+#include "Generic/parse/ChartArena.h"
 #include <cstring>
 #include <string>
 
-#define SIGCON_NODE_BLOCK_SIZE 10000
-
 
+/** SignificantConstitNodes are allocated in the ChartDecoder's ChartArena.
+  * A node owns the rest of its chain, which is allocated in the same arena;
+  * use release() to give a discarded chain's memory back to the arena. */
 class SignificantConstitNode {
 private:
 
@@ -27,7 +29,7 @@ private:
 	
 public:
 
-	SignificantConstitNode(bool left_is_constit, 
+	SignificantConstitNode(ChartArena &arena, bool left_is_constit, 
 		SignificantConstitNode *leftNode, int lltok, int lrtok, 
 		bool right_is_constit, 
 		SignificantConstitNode *rightNode, int rltok, int rrtok);
@@ -35,31 +37,30 @@ public:
 	
 	SignificantConstitNode (int _left, int _right);
 
-	SignificantConstitNode (SignificantConstitNode *n);
+	SignificantConstitNode (ChartArena &arena, SignificantConstitNode *n);
 
 	SignificantConstitNode ();
 
-	void addNode(SignificantConstitNode *n);
+	void addNode(ChartArena &arena, SignificantConstitNode *n);
 
-	void addElement(int _left, int _right);
+	void addElement(ChartArena &arena, int _left, int _right);
 
-	void copyIn(SignificantConstitNode *n);
+	void copyIn(ChartArena &arena, SignificantConstitNode *n);
 
-	
-    ~SignificantConstitNode();
+	/** Return the memory used by the given chain to the arena it was
+	  * allocated in. */
+	static void release(SignificantConstitNode *node, ChartArena &arena);
 
 	bool operator==(const SignificantConstitNode& scNode2);
 
 	std::string toString();
 
-    static void* operator new(size_t);
-    static void operator delete(void* object);
-	static void* operator new(size_t n, int, char *, int);
+	static void* operator new(size_t n, ChartArena &arena) { return arena.allocate(n); }
+	static void operator delete(void*, ChartArena &) {}
 
 private:
-    static SignificantConstitNode* freeList;
-    static const size_t blockSize;
-	
+	// Nodes are never deleted individually; see release().
+	static void operator delete(void* object);
 };
 
 
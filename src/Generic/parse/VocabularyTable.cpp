@@ -57,6 +57,33 @@ VocabularyTable::VocabularyTable(UTF8InputStream& in, int threshold)
     }
 }
 
+VocabularyTable::VocabularyTable(MappedModelImage::Section& section)
+{
+	MappedModelImage::WordReader in(section);
+	int numEntries = in.nextInt();
+	int numBuckets = static_cast<int>(numEntries / targetLoadingFactor);
+	table = _new Symbol::HashSet(numBuckets);
+	for (int i = 0; i < numEntries; i++) {
+		table->insert(in.nextSymbol());
+	}
+	size = numEntries;
+}
+
+void VocabularyTable::compileImage(UTF8InputStream& in, MappedModelImageWriter& writer)
+{
+	int numEntries;
+	UTF8Token token;
+	std::vector<boost::uint32_t> words;
+
+	in >> numEntries;
+	words.push_back(numEntries);
+	for (int i = 0; i < numEntries; i++) {
+		in >> token;
+		words.push_back(writer.getSymbolId(token.symValue()));
+	}
+	writer.addBlock(words);
+}
+
 bool VocabularyTable::find(Symbol word) const
 {
     Symbol::HashSet::iterator iter;
@@ -7,6 +7,7 @@
 #include "Generic/common/UTF8InputStream.h"
 #include "Generic/common/hash_set.h"
 #include "Generic/common/Symbol.h"
+#include "Generic/common/MappedModelImage.h"
 #include "Generic/parse/WordFeatures.h"
 
 #include <cstddef>
@@ -19,12 +20,17 @@ private:
 public:
     VocabularyTable(UTF8InputStream& in);
 	VocabularyTable(UTF8InputStream& in, int threshold);
+	/** Read a table that was written by compileImage(). */
+	VocabularyTable(MappedModelImage::Section& section);
 	VocabularyTable(int init_size) 
 	{ 
 		int numBuckets = static_cast<int>(init_size / targetLoadingFactor);
 		table = _new Symbol::HashSet(numBuckets); 
 	};
 	void print(char* filename);
+	/** Read a vocabulary file (as read by VocabularyTable(in)), and add it 
+	  * to the current section of the given image writer. */
+	static void compileImage(UTF8InputStream& in, MappedModelImageWriter& writer);
     bool find(Symbol word) const;
 };
 
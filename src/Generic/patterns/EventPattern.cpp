@@ -39,6 +39,15 @@ Symbol EventPattern::getPatternTypeSym() {
 	return eventSym;
 }
 
+bool EventPattern::getSentenceTriggers(std::vector<Trigger> &triggers) const {
+	// At the sentence level, we only match the sentence's event mentions.
+	if (_types.empty())
+		return false;
+	BOOST_FOREACH(Symbol type, _types)
+		triggers.push_back(Trigger(EVENT_TYPE_TRIGGER, type));
+	return true;
+}
+
 bool EventPattern::initializeFromSubexpression(Sexp *childSexp, const Symbol::HashSet &entityLabels, const PatternWordSetMap& wordSets) {
 	if (childSexp->getFirstChild()->getValue() == anchorSym) {
 		_anchorPattern = parseSexp(childSexp->getSecondChild(), entityLabels, wordSets);
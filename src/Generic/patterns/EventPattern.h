@@ -35,6 +35,7 @@ public:
 	virtual std::string typeName() const { return "EventPattern"; }
 	virtual Pattern_ptr replaceShortcuts(const SymbolToPatternMap &refPatterns);
 	virtual bool allowFallThroughToChildren() const { return true; }
+	virtual bool getSentenceTriggers(std::vector<Trigger> &triggers) const;
 
 private:
 	/*********************************************************************
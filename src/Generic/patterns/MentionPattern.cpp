@@ -764,6 +764,18 @@ void MentionPattern::dump(std::ostream &out, int indent) const {
 }
 
 
+bool MentionPattern::getSentenceTriggers(std::vector<Trigger> &triggers) const {
+	// At the sentence level, we only match the sentence's own mentions
+	// (without falling through to their children).  If we have entity
+	// types but no subtypes or entity labels, then one of those mentions
+	// must have one of our entity types.
+	if (hasLanguageVariantConstraint() || _aceTypes.empty() || !_aceSubtypes.empty() || !_entityLabels.empty())
+		return false;
+	BOOST_FOREACH(const EntityType &type, _aceTypes)
+		triggers.push_back(Trigger(ENTITY_TYPE_TRIGGER, type.getName()));
+	return true;
+}
+
 Pattern_ptr MentionPattern::replaceShortcuts(const SymbolToPatternMap &refPatterns) {
 	replaceShortcut<RegexPattern>(_regexPattern, refPatterns);
 	replaceShortcut<PropMatchingPattern>(_propDefPattern, refPatterns);
@@ -54,6 +54,7 @@ public:
 	virtual void getReturns(PatternReturnVecSeq & output) const;
 	virtual void dump(std::ostream &out, int indent = 0) const;
 	virtual bool allowFallThroughToChildren() const { return !_block_fall_through; }
+	virtual bool getSentenceTriggers(std::vector<Trigger> &triggers) const;
 	
 private:
 	virtual bool initializeFromAtom(Sexp *childSexp, const Symbol::HashSet &entityLabels, const PatternWordSetMap& wordSets);
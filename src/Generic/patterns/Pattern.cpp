@@ -699,6 +699,12 @@ bool LanguageVariantSwitchingPattern::initializeFromAtom(Sexp *childSexp, const
 	return Pattern::initializeFromAtom(childSexp, entityLabels, wordSets);
 }
 
+bool LanguageVariantSwitchingPattern::hasLanguageVariantConstraint() const {
+	if (!_languageVariant || _languageVariant->getLanguage() == LanguageVariant::languageVariantAnySym)
+		return false;
+	return !(_languageVariant->getLanguage().is_null() && _languageVariant->getVariant().is_null());
+}
+
 bool LanguageVariantSwitchingPattern::initializeFromSubexpression(Sexp *childSexp, const Symbol::HashSet &entityLabels, const PatternWordSetMap& wordSets) {
 	Symbol constraintType = childSexp->getFirstChild()->getValue();
 	if (!_languageVariant)
@@ -125,6 +125,26 @@ public:
 	virtual boost::shared_ptr<Pattern> replaceShortcuts(const SymbolToPatternMap &refPatterns) {
 		return shared_from_this(); }
 
+	/** Kinds of sentence contents that can be used to decide, before a
+	  * top-level pattern is matched against a sentence, that the pattern
+	  * can not possibly match it (see PatternTriggerIndex). */
+	typedef enum { PROP_PREDICATE_TRIGGER,         // a proposition's predicate
+	               STEMMED_PROP_PREDICATE_TRIGGER, // the same, stemmed (see PropPattern::getStemmedPredicate())
+	               EVENT_TYPE_TRIGGER,             // an event mention's type
+	               RELATION_TYPE_TRIGGER,          // a relation mention's type
+	               ENTITY_TYPE_TRIGGER,            // a mention's entity type
+	               N_TRIGGER_TYPES } TriggerType;
+	typedef std::pair<TriggerType, Symbol> Trigger;
+
+	/** If this pattern can only match a sentence that contains at least
+	  * one of a known set of triggers, then add those triggers to the 
+	  * given vector and return true.  Otherwise, return false, and leave
+	  * the vector unchanged.  This should only be called after shortcuts
+	  * have been replaced.  The default implementation returns false, so
+	  * patterns that do not override it are matched against every 
+	  * sentence. */
+	virtual bool getSentenceTriggers(std::vector<Trigger> &triggers) const { return false; }
+
 	/** Cast this pattern to the given type.  If it does not actually have the
 	  * appropriate type, then throw an InternalInconsistencyException.  If you
 	  * are not sure whether the pattern should have the given type, then you
@@ -312,6 +332,12 @@ public:
 
 protected:
 	LanguageVariant_ptr _languageVariant;
+
+	/** Return true if this pattern has a language or variant constraint
+	  * that the active language variant might not satisfy, in which case
+	  * the pattern may be matched against an aligned sentence instead of
+	  * the sentence it is given. */
+	bool hasLanguageVariantConstraint() const;
 };
 
 
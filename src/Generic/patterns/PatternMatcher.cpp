@@ -2,6 +2,7 @@
 // All Rights Reserved.
 
 #include "Generic/common/leak_detection.h" // This must be the first #include
+#include "Generic/common/Profiler.h"
 #include "Generic/common/SessionLogger.h"
 #include "Generic/patterns/ExtractionPattern.h"
 #include "Generic/patterns/RegexPattern.h"
@@ -26,6 +27,7 @@
 #include <boost/noncopyable.hpp>
 #include <boost/enable_shared_from_this.hpp>
 #include <boost/foreach.hpp>
+#include <boost/unordered_map.hpp>
 #include <algorithm>
 
 
@@ -76,7 +78,8 @@ PatternMatcher::PatternMatcher(const DocTheory *docTheory, PatternSet_ptr patter
 : _docSet(boost::make_shared<AlignedDocSet>()), _patternSet(patternSet), 
   _activityDate(activityDate), 
   _snippet_combination_method(snippet_combination_method),
-  _nameDictionary(nameDictionary), _slots(slots)
+  _nameDictionary(nameDictionary), _slots(slots),
+  _n_sentence_patterns_evaluated(0), _n_sentence_patterns_skipped(0)
 {
 	_docSet->loadDocTheory(LanguageVariant::getLanguageVariant(), docTheory);
 	_activeLanguageVariant = LanguageVariant::getLanguageVariant();
@@ -89,13 +92,21 @@ PatternMatcher::PatternMatcher(const AlignedDocSet_ptr docSet, PatternSet_ptr pa
 							   Symbol::HashMap<const AbstractSlot*> slots, const NameDictionary *nameDictionary)
 : _docSet(docSet), _patternSet(patternSet), _activityDate(activityDate), 
   _snippet_combination_method(snippet_combination_method),
-  _nameDictionary(nameDictionary), _slots(slots)
+  _nameDictionary(nameDictionary), _slots(slots),
+  _n_sentence_patterns_evaluated(0), _n_sentence_patterns_skipped(0)
 { 
 	_activeLanguageVariant = docSet->getDefaultLanguageVariant();
 	if (!ParamReader::isParamTrue("pattern_matcher_ignore_dates")) 
 		_documentDate = getDocTheory()->getDocument()->getDocumentDate();
 }
 
+PatternMatcher::~PatternMatcher() {
+	if (_n_sentence_patterns_skipped > 0) {
+		SessionLogger::dbg("pattern_trigger_index") << "Evaluated " << _n_sentence_patterns_evaluated 
+			<< " and skipped " << _n_sentence_patterns_skipped << " sentence-level pattern matches.";
+	}
+}
+
 void PatternMatcher::initializePatternMatcher(bool reset_mention_to_entity_cache) {
 	//TODO: BLL Update slot scoring to be bilingual as well
 	// We can move it into the loop below as long as we move the accessing of 
@@ -477,12 +488,23 @@ std::vector<PatternFeatureSet_ptr> PatternMatcher::getSentenceSnippets(SentenceT
 {	
 	std::vector<PatternFeatureSet_ptr> allMatches;
 
+	// Only try the patterns that the sentence contains triggers for.
+	const PatternTriggerIndex &triggerIndex = _patternSet->getTriggerIndex();
+	bool use_trigger_index = (triggerIndex.getNIndexedPatterns() > 0);
+	std::vector<size_t> candidatePatterns;
+	if (use_trigger_index)
+		triggerIndex.getCandidatePatterns(sTheory, candidatePatterns);
+	size_t n_patterns = use_trigger_index ? candidatePatterns.size() : _patternSet->getNTopLevelPatterns();
+	size_t n_evaluated = 0;
+
 	int sent_no = sTheory->getTokenSequence()->getSentenceNumber();
-	for (size_t i=0; i<_patternSet->getNTopLevelPatterns(); ++i) {
+	for (size_t c=0; c<n_patterns; ++c) {
+		size_t i = use_trigger_index ? candidatePatterns[c] : c;
 		//if (sent_no != 20) { continue; }
 		//if (i != 2) { continue; }
 		Pattern_ptr pattern = _patternSet->getNthTopLevelPattern(i);
 		if (SentenceMatchingPattern_ptr sentMatchPattern = boost::dynamic_pointer_cast<SentenceMatchingPattern>(pattern)) {
+			++n_evaluated;
 			// Just use matchesSentence for now so we can compare with the system - AHZ 6/17/2011 
 			//std::vector<PatternFeatureSet_ptr> patMatches = sentMatchPattern->multiMatchesSentence(shared_from_this(), sTheory, out);
 			
@@ -498,15 +520,8 @@ std::vector<PatternFeatureSet_ptr> PatternMatcher::getSentenceSnippets(SentenceT
 				}		
 			}
 
-			//Eliminate duplicates (TODO: make PatternFeatureSetCollection object to do this as we add feature sets)
-			for (int x=0;x<(int)patMatches.size();x++) {
-				for (int y=x+1;y<(int)patMatches.size();y++) {
-					if (patMatches[x]->equals(patMatches[y])) {
-						patMatches.erase(patMatches.begin()+y);
-						y--;
-					}
-				}
-			}
+			//Eliminate duplicates
+			removeDuplicateFeatureSets(patMatches);
 
 			SessionLogger::dbg("patt_to_sent_0") << "Pattern " << i << " (" << pattern->getDebugID() << ") applied to sentence " 
 				<< sTheory->getTokenSequence()->getSentenceNumber() << ".\n";
@@ -532,6 +547,13 @@ std::vector<PatternFeatureSet_ptr> PatternMatcher::getSentenceSnippets(SentenceT
 		}
 	}
 
+	// Only sentence-matching patterns count as evaluated or skipped.
+	size_t n_skipped = use_trigger_index ? triggerIndex.getNSentencePatterns() - n_evaluated : 0;
+	_n_sentence_patterns_evaluated += n_evaluated;
+	_n_sentence_patterns_skipped += n_skipped;
+	Profiler::count("sentence_patterns_evaluated", static_cast<long>(n_evaluated));
+	Profiler::count("sentence_patterns_skipped", static_cast<long>(n_skipped));
+
 	// now that we know we're keeping all these, go to the trouble of finding snippet spans
 	BOOST_FOREACH(PatternFeatureSet_ptr sfs, allMatches) {
 		sfs->setCoverage(shared_from_this());
@@ -543,6 +565,47 @@ std::vector<PatternFeatureSet_ptr> PatternMatcher::getSentenceSnippets(SentenceT
 	return allMatches;
 }
 
+void PatternMatcher::removeDuplicateFeatureSets(std::vector<PatternFeatureSet_ptr> &featureSets) {
+	if (featureSets.size() < 2)
+		return;
+	// If set y is identical to set x, then they have the same number of
+	// features, and x contains a feature identical to y's first feature;
+	// so we only need to compare y with the earlier sets that are filed
+	// under its size and its first feature's hash value.  (Each kept set is
+	// filed under the hash values of all of its features.)
+	typedef std::pair<size_t, size_t> SizeAndHash;
+	boost::unordered_map<SizeAndHash, std::vector<size_t> > keptSets;
+	std::vector<PatternFeatureSet_ptr> result;
+	std::vector<size_t> hashes;
+	BOOST_FOREACH(PatternFeatureSet_ptr featureSet, featureSets) {
+		size_t n_features = featureSet->getNFeatures();
+		size_t first_hash = (n_features > 0) ? featureSet->getFeature(0)->hashValue() : 0;
+		bool is_duplicate = false;
+		boost::unordered_map<SizeAndHash, std::vector<size_t> >::const_iterator it = keptSets.find(SizeAndHash(n_features, first_hash));
+		if (it != keptSets.end()) {
+			BOOST_FOREACH(size_t kept, (*it).second) {
+				if (result[kept]->equals(featureSet)) {
+					is_duplicate = true;
+					break;
+				}
+			}
+		}
+		if (is_duplicate)
+			continue;
+		hashes.clear();
+		for (size_t f = 0; f < n_features; ++f)
+			hashes.push_back(featureSet->getFeature(f)->hashValue());
+		if (n_features == 0)
+			hashes.push_back(0);
+		std::sort(hashes.begin(), hashes.end());
+		hashes.erase(std::unique(hashes.begin(), hashes.end()), hashes.end());
+		BOOST_FOREACH(size_t hash, hashes)
+			keptSets[SizeAndHash(n_features, hash)].push_back(result.size());
+		result.push_back(featureSet);
+	}
+	featureSets.swap(result);
+}
+
 void PatternMatcher::combineSnippets(std::vector<PatternFeatureSet_ptr> &featureSets, bool keep_all_features) {	
 	if (_snippet_combination_method == DO_NOT_COMBINE_SNIPPETS) 
 		return;
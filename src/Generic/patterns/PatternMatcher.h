@@ -95,7 +95,7 @@ public:
 	static PatternMatcher_ptr makePatternMatcher(const DocTheory* docTheory, Pattern_ptr pattern, bool reset_mention_to_entity_cache = true);
 	static PatternMatcher_ptr makePatternMatcher(const AlignedDocSet_ptr docSet, Pattern_ptr pattern, bool reset_mention_to_entity_cache = true);
 
-	virtual ~PatternMatcher() {}
+	virtual ~PatternMatcher();
 
 	/** Return the document that this PatternMatcher is matching
 	  * its PatternSet against. */
@@ -148,6 +148,15 @@ public:
 	  */
 	std::vector<PatternFeatureSet_ptr> getSentenceSnippets(SentenceTheory* sTheory, UTF8OutputStream *out = 0, bool force_multimatches = false);
 
+	/** Return the number of times that getSentenceSnippets() has matched a
+	  * top-level SentenceMatchingPattern against a sentence, and the number
+	  * of times that it has skipped one because the sentence did not contain
+	  * any of the pattern's triggers (see PatternTriggerIndex).  Each call
+	  * also adds these to the sentence_patterns_evaluated and
+	  * sentence_patterns_skipped counters of the current Profiler scope. */
+	size_t getNSentencePatternsEvaluated() const { return _n_sentence_patterns_evaluated; }
+	size_t getNSentencePatternsSkipped() const { return _n_sentence_patterns_skipped; }
+
 	/*********************************************************************
 	 * Pattern Match Information
 	 *********************************************************************/
@@ -274,6 +283,10 @@ protected:
 	/** Current Language Variant, gets switched by patterns during matching */
 	LanguageVariant_ptr _activeLanguageVariant; 
 
+	/** Counts of top-level patterns evaluated and skipped by getSentenceSnippets(). */
+	size_t _n_sentence_patterns_evaluated;
+	size_t _n_sentence_patterns_skipped;
+
 	/*********************************************************************
 	 * Private Helper Methods
 	 *********************************************************************/
@@ -302,6 +315,10 @@ protected:
 
 	void combineSnippets(std::vector<PatternFeatureSet_ptr> &featureSets, bool keep_all_features=false);
 
+	/** Remove any feature set that is identical (according to 
+	  * PatternFeatureSet::equals()) to an earlier feature set. */
+	static void removeDuplicateFeatureSets(std::vector<PatternFeatureSet_ptr> &featureSets);
+
 	/*********************************************************************
 	 * proptree stuff
 	 *********************************************************************/
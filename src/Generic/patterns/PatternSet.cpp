@@ -37,6 +37,7 @@ PatternSet::PatternSet(Pattern_ptr pattern) : _keep_all_features(false), _entity
 {
     _single_match_for_ment_prop = ParamReader::getOptionalTrueFalseParamWithDefaultVal("independent_props_ments_sentence_snippets", false);
     _topLevelPatterns.push_back(pattern);
+	buildTriggerIndex();
 }
 
 PatternSet::PatternSet(const char* filename, bool encrypted): _keep_all_features(false), _entityLabels(4), _do_not_block_patterns(false)
@@ -172,6 +173,7 @@ void PatternSet::initializeFromSexp(Sexp *callers_sexp) {
 	// Create the top-level patterns.
 	BOOST_FOREACH(Sexp *topLevelSexp, toplevelSexps)
 		loadPatterns(topLevelSexp, _topLevelPatterns);
+	buildTriggerIndex();
 
 	// Create the document patterns.
 	BOOST_FOREACH(Sexp *docPatternsSexp, doclevelSexps)
@@ -241,6 +243,15 @@ void PatternSet::loadPatterns(Sexp *sexp, std::vector<Pattern_ptr> &patterns) {
 	}
 }
 
+void PatternSet::buildTriggerIndex() {
+	if (!ParamReader::getOptionalTrueFalseParamWithDefaultVal("use_pattern_trigger_index", true))
+		return;
+	_triggerIndex.build(_topLevelPatterns);
+	SessionLogger::dbg("pattern_trigger_index") << "Pattern set " << _patternSetName.to_debug_string() << ": " 
+		<< _triggerIndex.getNIndexedPatterns() << " of " << _topLevelPatterns.size() 
+		<< " top-level patterns are indexed by their sentence triggers.";
+}
+
 void PatternSet::throwParseError(const Sexp *sexp, const char *reason) {
 	std::stringstream error;
 	error << "Parser Error: " << reason << ": " << sexp->to_debug_string();
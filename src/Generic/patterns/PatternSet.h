@@ -10,6 +10,7 @@
 #include "Generic/patterns/Pattern.h"
 #include "Generic/patterns/PatternReturn.h"
 #include "Generic/patterns/EntityLabelPattern.h"
+#include "Generic/patterns/PatternTriggerIndex.h"
 #include <boost/shared_ptr.hpp>
 #include <boost/noncopyable.hpp>
 
@@ -93,6 +94,11 @@ public:
 	// Top-level Patterns
 	size_t getNTopLevelPatterns() const;
 	Pattern_ptr getNthTopLevelPattern(size_t n) const;
+
+	// An index that is used to find the top-level patterns that might match
+	// a given sentence.  It is empty (i.e., it has no indexed patterns) if 
+	// the use_pattern_trigger_index parameter is false.
+	const PatternTriggerIndex &getTriggerIndex() const { return _triggerIndex; }
 	
 	// Entity label patterns
 	size_t getNEntityLabelPatterns() const;
@@ -134,6 +140,9 @@ private:
 	std::vector<Pattern_ptr> _docPatterns;
 	std::vector<EntityLabelPattern_ptr> _entityLabelPatterns;
 
+	// Index of the top-level patterns' sentence triggers.
+	PatternTriggerIndex _triggerIndex;
+
 	// The backoff levels (what are these?)
 	std::vector<Symbol> _backoffLevels;
 
@@ -170,6 +179,10 @@ private:
 	/** Helper for constructors */
 	void initializeFromSexp(Sexp *sexp);
 
+	/** Build _triggerIndex for the top-level patterns (unless it has been
+	  * disabled). */
+	void buildTriggerIndex();
+
 	/** Parse each pattern in the given sexp, and use them to populate the given
 	  * vector 'patterns'.  It is assumed that the first element of the sexp 
 	  * should be ignored, and all subsequent elements are patterns. */
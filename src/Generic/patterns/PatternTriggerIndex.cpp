@@ -0,0 +1,92 @@
+// Copyright (c) 2012 by Raytheon BBN Technologies Corp.
+// All Rights Reserved.
+
+#include "Generic/common/leak_detection.h" // This must be the first #include
+#include "Generic/patterns/PatternTriggerIndex.h"
+#include "Generic/patterns/PatternTypes.h"
+#include "Generic/patterns/PropPattern.h"
+#include "Generic/theories/SentenceTheory.h"
+#include "Generic/theories/PropositionSet.h"
+#include "Generic/theories/Proposition.h"
+#include "Generic/theories/EventMentionSet.h"
+#include "Generic/theories/EventMention.h"
+#include "Generic/theories/RelMentionSet.h"
+#include "Generic/theories/RelMention.h"
+#include "Generic/theories/MentionSet.h"
+#include "Generic/theories/Mention.h"
+#include <algorithm>
+
+void PatternTriggerIndex::build(const std::vector<Pattern_ptr> &patterns) {
+	_n_indexed_patterns = 0;
+	_n_sentence_patterns = 0;
+	_unindexedPatterns.clear();
+	for (int type = 0; type < Pattern::N_TRIGGER_TYPES; ++type)
+		_patternsByTrigger[type].clear();
+
+	std::vector<Pattern::Trigger> triggers;
+	for (size_t i = 0; i < patterns.size(); ++i) {
+		if (boost::dynamic_pointer_cast<SentenceMatchingPattern>(patterns[i]))
+			++_n_sentence_patterns;
+		triggers.clear();
+		if (!patterns[i]->getSentenceTriggers(triggers)) {
+			_unindexedPatterns.push_back(i);
+			continue;
+		}
+		++_n_indexed_patterns;
+		for (size_t t = 0; t < triggers.size(); ++t) {
+			std::vector<size_t> &triggeredPatterns = _patternsByTrigger[triggers[t].first][triggers[t].second];
+			// A pattern may list the same trigger more than once.
+			if (triggeredPatterns.empty() || triggeredPatterns.back() != i)
+				triggeredPatterns.push_back(i);
+		}
+	}
+}
+
+void PatternTriggerIndex::addCandidates(Pattern::TriggerType type, Symbol trigger, std::vector<size_t> &candidates) const {
+	Symbol::HashMap<std::vector<size_t> >::const_iterator it = _patternsByTrigger[type].find(trigger);
+	if (it != _patternsByTrigger[type].end())
+		candidates.insert(candidates.end(), (*it).second.begin(), (*it).second.end());
+}
+
+void PatternTriggerIndex::getCandidatePatterns(const SentenceTheory *sTheory, std::vector<size_t> &candidates) const {
+	candidates = _unindexedPatterns;
+	if (_n_indexed_patterns == 0)
+		return;
+
+	// Only look at the parts of the sentence that some pattern cares about;
+	// in particular, we don't stem predicates unless we have to.
+	const PropositionSet *propSet = sTheory->getPropositionSet();
+	if (propSet != 0 && (hasTriggers(Pattern::PROP_PREDICATE_TRIGGER) || hasTriggers(Pattern::STEMMED_PROP_PREDICATE_TRIGGER))) {
+		for (int i = 0; i < propSet->getNPropositions(); ++i) {
+			const Proposition *prop = propSet->getProposition(i);
+			if (prop->getPredSymbol().is_null())
+				continue;
+			if (hasTriggers(Pattern::PROP_PREDICATE_TRIGGER))
+				addCandidates(Pattern::PROP_PREDICATE_TRIGGER, prop->getPredSymbol(), candidates);
+			if (hasTriggers(Pattern::STEMMED_PROP_PREDICATE_TRIGGER))
+				addCandidates(Pattern::STEMMED_PROP_PREDICATE_TRIGGER, PropPattern::getStemmedPredicate(prop), candidates);
+		}
+	}
+
+	const EventMentionSet *eventMentionSet = sTheory->getEventMentionSet();
+	if (eventMentionSet != 0 && hasTriggers(Pattern::EVENT_TYPE_TRIGGER)) {
+		for (int i = 0; i < eventMentionSet->getNEventMentions(); ++i)
+			addCandidates(Pattern::EVENT_TYPE_TRIGGER, eventMentionSet->getEventMention(i)->getEventType(), candidates);
+	}
+
+	const RelMentionSet *relMentionSet = sTheory->getRelMentionSet();
+	if (relMentionSet != 0 && hasTriggers(Pattern::RELATION_TYPE_TRIGGER)) {
+		for (int i = 0; i < relMentionSet->getNRelMentions(); ++i)
+			addCandidates(Pattern::RELATION_TYPE_TRIGGER, relMentionSet->getRelMention(i)->getType(), candidates);
+	}
+
+	const MentionSet *mentionSet = sTheory->getMentionSet();
+	if (mentionSet != 0 && hasTriggers(Pattern::ENTITY_TYPE_TRIGGER)) {
+		for (int i = 0; i < mentionSet->getNMentions(); ++i)
+			addCandidates(Pattern::ENTITY_TYPE_TRIGGER, mentionSet->getMention(i)->getEntityType().getName(), candidates);
+	}
+
+	// Patterns must be tried in their original order.
+	std::sort(candidates.begin(), candidates.end());
+	candidates.erase(std::unique(candidates.begin(), candidates.end()), candidates.end());
+}
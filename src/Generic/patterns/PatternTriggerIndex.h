@@ -0,0 +1,57 @@
+// Copyright (c) 2012 by Raytheon BBN Technologies Corp.
+// All Rights Reserved.
+
+#ifndef PATTERN_TRIGGER_INDEX_H
+#define PATTERN_TRIGGER_INDEX_H
+
+#include "Generic/common/Symbol.h"
+#include "Generic/patterns/Pattern.h"
+#include <vector>
+
+class SentenceTheory;
+
+/** An index from sentence "triggers" (proposition predicates, event and
+  * relation types, and entity types) to the top-level patterns of a
+  * PatternSet that require them, which is used to avoid trying patterns
+  * against sentences that they can not possibly match.  Each pattern
+  * reports its triggers with Pattern::getSentenceTriggers(); patterns that
+  * have none are tried against every sentence.
+  *
+  * The index is built once, when the PatternSet is loaded, and is not
+  * modified afterwards, so it may be shared by several threads. */
+class PatternTriggerIndex {
+public:
+	PatternTriggerIndex(): _n_indexed_patterns(0), _n_sentence_patterns(0) {}
+
+	/** Index the given patterns.  Any existing contents are discarded. */
+	void build(const std::vector<Pattern_ptr> &patterns);
+
+	/** Set candidates to the indices of the patterns that might match the
+	  * given sentence, in increasing order. */
+	void getCandidatePatterns(const SentenceTheory *sTheory, std::vector<size_t> &candidates) const;
+
+	/** Return the number of patterns that are only tried against sentences
+	  * that contain one of their triggers. */
+	size_t getNIndexedPatterns() const { return _n_indexed_patterns; }
+
+	/** Return the number of indexed or unindexed patterns that are
+	  * SentenceMatchingPatterns (the only ones that are tried against
+	  * sentences). */
+	size_t getNSentencePatterns() const { return _n_sentence_patterns; }
+
+private:
+	size_t _n_indexed_patterns;
+	size_t _n_sentence_patterns;
+
+	// The patterns that must be tried against every sentence.
+	std::vector<size_t> _unindexedPatterns;
+
+	// For each trigger type, a map from triggers to the patterns that they
+	// can fire.
+	Symbol::HashMap<std::vector<size_t> > _patternsByTrigger[Pattern::N_TRIGGER_TYPES];
+
+	bool hasTriggers(Pattern::TriggerType type) const { return _patternsByTrigger[type].size() > 0; }
+	void addCandidates(Pattern::TriggerType type, Symbol trigger, std::vector<size_t> &candidates) const;
+};
+
+#endif
@@ -241,6 +241,33 @@ Pattern_ptr PropPattern::replaceShortcuts(const SymbolToPatternMap &refPatterns)
 	return shared_from_this();
 }
 
+Symbol PropPattern::getStemmedPredicate(const Proposition *prop) {
+	Symbol predSym = prop->getPredSymbol();
+	if (!predSym.is_null()) {
+		if (prop->getPredType() == Proposition::VERB_PRED) {
+			predSym = WordNet::getInstance()->stem_verb(prop->getPredSymbol());
+		} else if (prop->getPredType() == Proposition::NOUN_PRED) {
+			predSym = WordNet::getInstance()->stem_noun(prop->getPredSymbol());
+		} else if (prop->getPredType() == Proposition::MODIFIER_PRED) {
+			predSym = WordNet::getInstance()->stem_verb(prop->getPredSymbol());
+		}
+	}
+	return predSym;
+}
+
+bool PropPattern::getSentenceTriggers(std::vector<Trigger> &triggers) const {
+	// At the sentence level, we only match the sentence's own propositions
+	// (without falling through to their children), and each of them must 
+	// have one of our predicates.  Prefixes can't be looked up, so patterns
+	// that use them are not indexed.
+	if (hasLanguageVariantConstraint() || _predicates.empty() || !_predicatePrefixes.empty())
+		return false;
+	TriggerType type = _stem_predicate ? STEMMED_PROP_PREDICATE_TRIGGER : PROP_PREDICATE_TRIGGER;
+	BOOST_FOREACH(Symbol predicate, _predicates)
+		triggers.push_back(Trigger(type, predicate));
+	return true;
+}
+
 // returns all proposition matches in the sentence
 PatternFeatureSet_ptr PropPattern::matchesSentence(PatternMatcher_ptr patternMatcher, SentenceTheory *sTheory, UTF8OutputStream *debug) {
 	if (_languageVariant && !patternMatcher->getActiveLanguageVariant()->matchesConstraint(*_languageVariant)) {
@@ -435,16 +462,7 @@ PatternFeatureSet_ptr  PropPattern::matchesProp(PatternMatcher_ptr patternMatche
 		}
 	}	
 
-	Symbol predSym = prop->getPredSymbol();
-	if (_stem_predicate && !predSym.is_null()) {
-		if (prop->getPredType() == Proposition::VERB_PRED) {
-			predSym = WordNet::getInstance()->stem_verb(prop->getPredSymbol());
-		} else if (prop->getPredType() == Proposition::NOUN_PRED) {
-			predSym = WordNet::getInstance()->stem_noun(prop->getPredSymbol());
-		} else if (prop->getPredType() == Proposition::MODIFIER_PRED) {
-			predSym = WordNet::getInstance()->stem_verb(prop->getPredSymbol());
-		}
-	}
+	Symbol predSym = _stem_predicate ? getStemmedPredicate(prop) : prop->getPredSymbol();
 
 	if (!wordMatchesWithPrefix(predSym, _predicates, _predicatePrefixes, true)) {
 		SessionLogger::dbg("BRANDY") << getDebugID() << " Returning empty set because invalid predicate\n";
@@ -34,6 +34,11 @@ public:
 	virtual void getReturns(PatternReturnVecSeq & output) const;
 	virtual void dump(std::ostream &out, int indent = 0) const;
 	virtual bool allowFallThroughToChildren() const { return true; }
+	virtual bool getSentenceTriggers(std::vector<Trigger> &triggers) const;
+
+	/** Return the given proposition's predicate, stemmed the way that it
+	  * is for prop patterns that use stemmed predicates. */
+	static Symbol getStemmedPredicate(const Proposition *prop);
 
 private:
 	virtual bool initializeFromAtom(Sexp *childSexp, const Symbol::HashSet &entityLabels, const PatternWordSetMap& wordSets);
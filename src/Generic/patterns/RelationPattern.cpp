@@ -36,6 +36,15 @@ Symbol RelationPattern::getPatternTypeSym() {
 	return relationSym;
 }
 
+bool RelationPattern::getSentenceTriggers(std::vector<Trigger> &triggers) const {
+	// At the sentence level, we only match the sentence's relation mentions.
+	if (_types.empty())
+		return false;
+	BOOST_FOREACH(Symbol type, _types)
+		triggers.push_back(Trigger(RELATION_TYPE_TRIGGER, type));
+	return true;
+}
+
 PatternFeatureSet_ptr RelationPattern::matchesSentence(PatternMatcher_ptr patternMatcher, SentenceTheory *sTheory, UTF8OutputStream *debug) {
 	int sent_no = sTheory->getTokenSequence()->getSentenceNumber();
 	std::vector<float> scores;
@@ -31,6 +31,7 @@ public:
 
 	// Overridden virtual methods
 	virtual std::string typeName() const { return "RelationPattern"; }
+	virtual bool getSentenceTriggers(std::vector<Trigger> &triggers) const;
 private:
 	/*********************************************************************
 	 * Construction Helper Methods
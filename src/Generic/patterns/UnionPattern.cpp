@@ -119,6 +119,20 @@ Pattern_ptr UnionPattern::replaceShortcuts(const SymbolToPatternMap &refPatterns
 	return shared_from_this();
 }
 
+bool UnionPattern::getSentenceTriggers(std::vector<Trigger> &triggers) const {
+	// We can only match a sentence if one of our subpatterns does; so if
+	// every subpattern has triggers, then ours are all of theirs.
+	if (hasLanguageVariantConstraint() || _patternList.empty())
+		return false;
+	std::vector<Trigger> subpatternTriggers;
+	for (size_t i = 0; i < _patternList.size(); ++i) {
+		if (!_patternList[i]->getSentenceTriggers(subpatternTriggers))
+			return false;
+	}
+	triggers.insert(triggers.end(), subpatternTriggers.begin(), subpatternTriggers.end());
+	return true;
+}
+
 void UnionPattern::dump(std::ostream &out, int indent) const {
 	for (int i = 0; i < indent; i++) out << " ";
 	out << "UnionPattern: ";
@@ -34,6 +34,7 @@ public:
 		boost::shared_ptr<EventMentionPFeature> f = boost::dynamic_pointer_cast<EventMentionPFeature>(other);
 		return f && f->getEventMention() == getEventMention();
 	}
+	virtual size_t hashValue() const { return boost::hash_value(_eventMention); }
 	virtual void setCoverage(const DocTheory * docTheory);	
 	virtual void setCoverage(const PatternMatcher_ptr patternMatcher);
 	virtual void printFeatureFocus(const PatternMatcher_ptr patternMatcher, UTF8OutputStream &out) const;
@@ -21,6 +21,7 @@ public:
 	virtual int getStartToken() const;
 	virtual int getEndToken() const;
 	virtual bool equals(PatternFeature_ptr other);
+	virtual size_t hashValue() const { return boost::hash_value(getPattern().get()); }
 	virtual void printFeatureFocus(const PatternMatcher_ptr patternMatcher, UTF8OutputStream &out) const; /* do nothing */
 	virtual void setCoverage(const DocTheory * docTheory); /* do nothing */
 	virtual void setCoverage(const PatternMatcher_ptr patternMatcher); /* do nothing */
@@ -72,6 +72,7 @@ public:
 		boost::shared_ptr<MentionPFeature> f = boost::dynamic_pointer_cast<MentionPFeature>(other);
 		return f && f->getMention() == getMention();
 	}
+	virtual size_t hashValue() const { return boost::hash_value(_mention); }
 	virtual void printFeatureFocus(const PatternMatcher_ptr patternMatcher, UTF8OutputStream &out) const;
 	virtual void saveXML(SerifXML::XMLElement elem, const SerifXML::XMLIdMap* idMap) const;
 	MentionPFeature(SerifXML::XMLElement elem, const SerifXML::XMLIdMap* idMap);
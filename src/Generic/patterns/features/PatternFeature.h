@@ -7,6 +7,7 @@
 #include <boost/shared_ptr.hpp>
 #include <boost/noncopyable.hpp>
 #include <boost/enable_shared_from_this.hpp>
+#include <boost/functional/hash.hpp>
 #include "Generic/common/InternalInconsistencyException.h"
 #include "Generic/common/OutputUtil.h"
 #include "Generic/state/XMLElement.h"
@@ -93,6 +94,11 @@ public:
 	/** Return whether two Pattern Features are identical */
 	virtual bool equals(PatternFeature_ptr other) = 0;
 
+	/** Return a hash value for this feature.  Any two features that are
+	  * identical according to equals() must have the same hash value.  The
+	  * default implementation always returns zero. */
+	virtual size_t hashValue() const { return 0; }
+
 	/** Typically (but not always) called by a subclass as part of its equality function */
 	bool simpleEquals(PatternFeature_ptr other);
 
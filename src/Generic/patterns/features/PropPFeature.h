@@ -41,6 +41,7 @@ public:
 		boost::shared_ptr<PropPFeature> f = boost::dynamic_pointer_cast<PropPFeature>(other);
 		return f && f->getProp() == getProp();
 	}
+	size_t hashValue() const { return boost::hash_value(_proposition); }
 	virtual void setCoverage(const DocTheory * docTheory);
 	virtual void setCoverage(const PatternMatcher_ptr patternMatcher);
 	virtual void printFeatureFocus(const PatternMatcher_ptr patternMatcher, UTF8OutputStream &out) const;
@@ -41,6 +41,7 @@ public:
 		boost::shared_ptr<RelMentionPFeature> f = boost::dynamic_pointer_cast<RelMentionPFeature>(other);
 		return f && f->getRelMention() == getRelMention();
 	}
+	size_t hashValue() const { return boost::hash_value(_relMention); }
 	void printFeatureFocus(const PatternMatcher_ptr patternMatcher, UTF8OutputStream &out) const;
 	virtual void setCoverage(const DocTheory * docTheory);	
 	virtual void setCoverage(const PatternMatcher_ptr patternMatcher);
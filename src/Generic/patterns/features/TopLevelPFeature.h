@@ -39,6 +39,7 @@ public:
 		boost::shared_ptr<TopLevelPFeature> f = boost::dynamic_pointer_cast<TopLevelPFeature>(other);
 		return f && f->getPatternLabel() == getPatternLabel();
 	}
+	size_t hashValue() const { return _pattern_label.is_null() ? 0 : _pattern_label.hash_code(); }
 	virtual void setCoverage(const DocTheory * docTheory) { /* nothing to do */ }
 	virtual void setCoverage(const PatternMatcher_ptr patternMatcher) { /* nothing to do */ }
 	virtual void printFeatureFocus(const PatternMatcher_ptr patternMatcher, UTF8OutputStream &out) const;
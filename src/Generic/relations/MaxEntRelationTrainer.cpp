@@ -100,6 +100,8 @@ MaxEntRelationTrainer::MaxEntRelationTrainer()
 			_mode = MaxEntModel::GIS;
 		else if (param_mode == "SCGIS")
 			_mode = MaxEntModel::SCGIS;
+		else if (param_mode == "LBFGS" && MaxEntModel::hasGradientOptimizer())
+			_mode = MaxEntModel::LBFGS;
 		else
 			throw UnexpectedInputException("MaxEntRelationTrainer::MaxEntRelationTrainer()",
 							"Invalid setting for parameter 'maxent_trainer_mode'");
@@ -129,8 +129,7 @@ RelationObservation::~RelationObservation() {
 	for (int i = 0; i < 10; i++) {
 		delete _propLinks[i];
 	}
-	delete m1Name; m1Name = 0;
-	delete m2Name; m2Name = 0;
+	clearMentionFeatures();
 }
 
 
@@ -151,12 +150,9 @@ void RelationObservation::resetForNewSentence(DTRelSentenceInfo *sentenceInfo)
 	_m1 = 0;
 	_m2 = 0;
 
-	// moved to populate since m1Name and m2Name get changed once for every mention
-	// pair, not once for every sentence. -AZ 8/21/08
-	//delete m1Name;
-	//delete m2Name;
-	//m1Name = 0;
-	//m2Name = 0;
+	// The per-mention features (including m1Name and m2Name) are only good
+	// for one sentence.
+	clearMentionFeatures();
 
 	_sentenceInfo->parses[0]->getRoot()->getTerminalSymbols(_tokens, MAX_SENTENCE_TOKENS);
 	_sentenceInfo->parses[0]->getRoot()->getPOSSymbols(_pos, MAX_SENTENCE_TOKENS);
@@ -233,11 +229,6 @@ void RelationObservation::populate(int mention1ID, int mention2ID) {
 		findPropLink(i);
 	}
 	
-	delete m1Name;
-	delete m2Name;
-	m1Name = 0;
-	m2Name = 0;
-	
 	findMentionNames();
 	findWordsBetween();
 	_n_predictions = 0;
@@ -255,8 +246,8 @@ void RelationObservation::populate(int mention1ID, int mention2ID) {
 
 	//added for relation models based on NP chunk output
 	if (_npchunkFeatures) {
-		_stemmedHeadofm1 = WordNet::getInstance()->stem_noun(_m1->getNode()->getHeadWord());
-		_stemmedHeadofm2 = WordNet::getInstance()->stem_noun(_m2->getNode()->getHeadWord());
+		_stemmedHeadofm1 = getStemmedHead(_m1_id, _m1);
+		_stemmedHeadofm2 = getStemmedHead(_m2_id, _m2);
 
 		_hasPossessiveRel = false;
 		findPossessiveRel();
@@ -882,17 +873,41 @@ void RelationObservation::findverbProp(){
 }
 
 void RelationObservation::findMentionNames() {
-	int n_symbols;
-	Symbol name_symbols[16];
+	m1Name = getMentionName(_m1_id, _m1);
+	m2Name = getMentionName(_m2_id, _m2);
+}
+
+RelationObservation::MentionFeatures &RelationObservation::getMentionFeatures(int mention_id) {
+	if (static_cast<size_t>(mention_id) >= _mentionFeatures.size())
+		_mentionFeatures.resize(mention_id + 1);
+	return _mentionFeatures[mention_id];
+}
 
-	delete m1Name;
-	n_symbols = getMentionNameSymbols(_m1, name_symbols, 16);
-	m1Name = _new SymbolArray(name_symbols, n_symbols);
+SymbolArray *RelationObservation::getMentionName(int mention_id, const Mention *ment) {
+	MentionFeatures &features = getMentionFeatures(mention_id);
+	if (features.name == 0) {
+		Symbol name_symbols[16];
+		int n_symbols = getMentionNameSymbols(ment, name_symbols, 16);
+		features.name = _new SymbolArray(name_symbols, n_symbols);
+	}
+	return features.name;
+}
 
-	delete m2Name;
-	n_symbols = getMentionNameSymbols(_m2, name_symbols, 16);
-	m2Name = _new SymbolArray(name_symbols, n_symbols);
+Symbol RelationObservation::getStemmedHead(int mention_id, const Mention *ment) {
+	MentionFeatures &features = getMentionFeatures(mention_id);
+	if (!features.has_stemmed_head) {
+		features.stemmedHead = WordNet::getInstance()->stem_noun(ment->getNode()->getHeadWord());
+		features.has_stemmed_head = true;
+	}
+	return features.stemmedHead;
+}
 
+void RelationObservation::clearMentionFeatures() {
+	for (size_t i = 0; i < _mentionFeatures.size(); i++)
+		delete _mentionFeatures[i].name;
+	_mentionFeatures.clear();
+	m1Name = 0;
+	m2Name = 0;
 }
 
 int RelationObservation::getMentionNameSymbols(const Mention *ment, Symbol *array_, int max_length) {
@@ -19,6 +19,8 @@
 #include "Generic/relations/PotentialRelationInstance.h"
 #include "Generic/common/ParamReader.h"
 
+#include <vector>
+
 #define REL_MAX_WN_OFFSETS 20
 
 class Parse;
@@ -193,11 +195,28 @@ private:
 	int _m1_id;
 	int _m2_id;
 
+	// m1Name and m2Name point into _mentionFeatures, which owns them.
 	SymbolArray *m1Name;
 	SymbolArray *m2Name;
 	void findMentionNames();
 	int getMentionNameSymbols(const Mention *ment, Symbol *array_, int max_length);
 
+	/** Features that depend on only one mention.  A mention is usually in
+	  * many pairs, so these are computed the first time the mention is seen
+	  * in a sentence, and reused for the rest of its pairs.  (Indexed by
+	  * mention index; cleared by resetForNewSentence().) */
+	struct MentionFeatures {
+		SymbolArray *name;
+		Symbol stemmedHead;
+		bool has_stemmed_head;
+		MentionFeatures(): name(0), has_stemmed_head(false) {}
+	};
+	std::vector<MentionFeatures> _mentionFeatures;
+	MentionFeatures &getMentionFeatures(int mention_id);
+	SymbolArray *getMentionName(int mention_id, const Mention *ment);
+	Symbol getStemmedHead(int mention_id, const Mention *ment);
+	void clearMentionFeatures();
+
 	Symbol isMentionOrValue(int start, int end, int& skipto);
 	Symbol isReducedGroup(int start, int end, int& skipto);
 
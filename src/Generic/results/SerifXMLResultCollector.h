@@ -5,6 +5,7 @@
 #define SERIF_XML_RESULT_COLLECTOR_H
 
 #include "Generic/results/ResultCollector.h"
+#include "Generic/state/CompactDocTheoryFile.h"
 #include "Generic/state/XMLSerializedDocTheory.h"
 #include <boost/algorithm/string/predicate.hpp>
 
@@ -27,7 +28,10 @@ public:
 		std::wstring filename = std::wstring(output_dir) + LSERIF_PATH_SEP + std::wstring(document_filename);
 		if (!boost::algorithm::ends_with(filename, L".xml"))
 			filename += L".xml";
-		SerifXML::XMLSerializedDocTheory(_docTheory).save(filename);
+		if (CompactDocTheoryFile::isEnabled())
+			CompactDocTheoryFile::save(_docTheory, filename.c_str());
+		else
+			SerifXML::XMLSerializedDocTheory(_docTheory).save(filename);
 	}
 	virtual void produceOutput(std::wstring *results) {
 		std::stringstream result_stream;
@@ -63,6 +63,10 @@ public:
 	//Offset checker
 	bool isBufferAtEnd(size_t end_offset) { return ((_currentBuffer + end_offset) >= (_buffer + _bufferSize)); }
 
+	//Direct access to the bytes at the current location, for readers that decode in place
+	unsigned char* getCurrentPosition(void) { return _currentBuffer; }
+	size_t getRemaining(void) { return _bufferSize - (_currentBuffer - _buffer); }
+
 	//Stream printer
 	friend std::ostream & operator<<(std::ostream & out, ByteBuffer & buffer);
 
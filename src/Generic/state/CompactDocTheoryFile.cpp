@@ -0,0 +1,85 @@
+// Copyright (c) 2012 by Raytheon BBN Technologies Corp.
+// All Rights Reserved.
+
+#include "Generic/common/leak_detection.h"
+
+#include "Generic/state/CompactDocTheoryFile.h"
+#include "Generic/state/ObjectIDTable.h"
+#include "Generic/state/StateLoader.h"
+#include "Generic/state/StateSaver.h"
+#include "Generic/state/XMLSerializedDocTheory.h"
+#include "Generic/common/OutputUtil.h"
+#include "Generic/common/ParamReader.h"
+#include "Generic/common/UnicodeUtil.h"
+#include "Generic/common/XMLUtil.h"
+#include "Generic/theories/Document.h"
+#include "Generic/theories/DocTheory.h"
+
+#include <sstream>
+#include <string>
+
+namespace {
+	const wchar_t *DOCUMENT_TREE = L"Compact DocTheory: Document";
+	const wchar_t *DOC_THEORY_TREE = L"Compact DocTheory: DocTheory";
+}
+
+bool CompactDocTheoryFile::isEnabled() {
+	return ParamReader::isParamTrue("compact_serifxml");
+}
+
+bool CompactDocTheoryFile::isCompactFile(const char* filename) {
+	return StateLoader::isCompactStateFile(filename);
+}
+
+void CompactDocTheoryFile::save(DocTheory* docTheory, const wchar_t* filename) {
+	save(docTheory, OutputUtil::convertToUTF8BitString(filename).c_str());
+}
+
+void CompactDocTheoryFile::save(DocTheory* docTheory, const char* filename) {
+	// The DocTheory we serialize for the Document does not own it.
+	DocTheory documentOnly(docTheory->getDocument());
+	std::ostringstream documentXML;
+	SerifXML::XMLSerializedDocTheory(&documentOnly).save(documentXML);
+
+	StateSaver stateSaver(filename, true, true);
+	stateSaver.beginStateTree(DOCUMENT_TREE);
+	stateSaver.saveString(UnicodeUtil::toUTF16StdString(documentXML.str()).c_str());
+	stateSaver.endStateTree();
+
+	docTheory->saveSentenceBreaksToStateFile(&stateSaver);
+
+	ObjectIDTable::initialize();
+	docTheory->updateObjectIDTable();
+	stateSaver.beginStateTree(DOC_THEORY_TREE);
+	stateSaver.saveInteger(docTheory->getNSentences());
+	docTheory->saveState(&stateSaver);
+	stateSaver.endStateTree();
+	ObjectIDTable::finalize();
+}
+
+std::pair<Document*, DocTheory*> CompactDocTheoryFile::load(const char* filename) {
+	StateLoader stateLoader(filename);
+
+	stateLoader.beginStateTree(DOCUMENT_TREE);
+	std::wstring documentXML = stateLoader.loadString();
+	stateLoader.endStateTree();
+	std::pair<Document*, DocTheory*> documentOnly =
+		SerifXML::XMLSerializedDocTheory(XMLUtil::loadXercesDOMFromString(documentXML.c_str())).generateDocTheory();
+	delete documentOnly.second;
+	Document *document = documentOnly.first;
+
+	DocTheory *docTheory = _new DocTheory(document);
+	try {
+		docTheory->loadSentenceBreaksFromStateFile(&stateLoader);
+		stateLoader.beginStateTree(DOC_THEORY_TREE);
+		stateLoader.loadInteger();
+		docTheory->loadDocTheory(&stateLoader);
+		stateLoader.endStateTree();
+		docTheory->resolvePointers(&stateLoader);
+	} catch (...) {
+		delete docTheory;
+		delete document;
+		throw;
+	}
+	return std::make_pair(document, docTheory);
+}
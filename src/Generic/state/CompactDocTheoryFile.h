@@ -0,0 +1,47 @@
+// Copyright (c) 2012 by Raytheon BBN Technologies Corp.
+// All Rights Reserved.
+
+#ifndef COMPACT_DOC_THEORY_FILE_H
+#define COMPACT_DOC_THEORY_FILE_H
+
+#include <utility>
+
+class Document;
+class DocTheory;
+
+/** A compact binary alternative to SerifXML files, for documents whose
+  * theories can be saved in state files (i.e., those produced by the
+  * standard stages through doc-values).  It is selected by setting the
+  * compact_serifxml parameter: wherever Serif writes a SerifXML file,
+  * it writes a compact DocTheory file (with the same name) instead.
+  * XMLSerializedDocTheory recognizes compact DocTheory files by their
+  * header, so they can be read wherever SerifXML files are read,
+  * whatever the parameter says.  (SerifXML that is returned as a string,
+  * e.g. by the SerifHTTPServer, is not affected.)
+  *
+  * A compact DocTheory file is a compact state file (see
+  * CompactStateFormat.h) with three state trees:
+  *   - The Document, stored as the SerifXML of a DocTheory that has no
+  *     sentences (so it holds the original text, regions, zones and
+  *     metadata, but none of the theories).
+  *   - The sentence breaks.
+  *   - The DocTheory, as it is saved in state files. */
+class CompactDocTheoryFile {
+public:
+	/** Return true if the compact_serifxml parameter is set. */
+	static bool isEnabled();
+
+	/** Return true if the given file is a compact DocTheory file (or any
+	  * other compact state file). */
+	static bool isCompactFile(const char* filename);
+
+	/** Save the given DocTheory and its Document to the given file. */
+	static void save(DocTheory* docTheory, const char* filename);
+	static void save(DocTheory* docTheory, const wchar_t* filename);
+
+	/** Load a Document and DocTheory from the given compact DocTheory
+	  * file.  The caller takes ownership of both. */
+	static std::pair<Document*, DocTheory*> load(const char* filename);
+};
+
+#endif
@@ -0,0 +1,226 @@
+// Copyright (c) 2012 by Raytheon BBN Technologies Corp.
+// All Rights Reserved.
+
+#include "Generic/common/leak_detection.h"
+
+#include "Generic/state/CompactStateFormat.h"
+#include "Generic/state/ByteBuffer.h"
+#include "Generic/state/StateLoader.h"
+#include "Generic/common/UnexpectedInputException.h"
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <sstream>
+#include <wchar.h>
+
+const char CompactStateFormat::MAGIC[8] = {'S','E','R','I','F','C','S','T'};
+
+namespace {
+	const wchar_t *NULL_SYMBOL_STRING = L"<null-symbol>";
+
+	void putFixed(std::ostream &out, boost::uint64_t value, int n_bytes) {
+		char bytes[8];
+		for (int i = 0; i < n_bytes; ++i)
+			bytes[i] = static_cast<char>((value >> (8*i)) & 0xff);
+		out.write(bytes, n_bytes);
+	}
+
+	boost::uint64_t getFixed(const unsigned char *bytes, int n_bytes) {
+		boost::uint64_t value = 0;
+		for (int i = 0; i < n_bytes; ++i)
+			value |= static_cast<boost::uint64_t>(bytes[i]) << (8*i);
+		return value;
+	}
+}
+
+bool CompactStateFormat::hasHeader(const unsigned char *data, size_t n_bytes) {
+	return (n_bytes >= sizeof(MAGIC)) && (memcmp(data, MAGIC, sizeof(MAGIC)) == 0);
+}
+
+void CompactStateFormat::checkHeader(const unsigned char *data, size_t n_bytes) {
+	if (n_bytes < HEADER_SIZE || !hasHeader(data, n_bytes))
+		throw UnexpectedInputException("CompactStateFormat::checkHeader",
+			"Not a compact state file");
+	boost::uint32_t version = static_cast<boost::uint32_t>(getFixed(data+sizeof(MAGIC), 4));
+	if (version > VERSION) {
+		std::ostringstream err;
+		err << "Compact state file has format version " << version
+			<< ", but only versions up to " << VERSION << " are supported";
+		throw UnexpectedInputException("CompactStateFormat::checkHeader", err.str().c_str());
+	}
+}
+
+bool CompactStateFormat::getCompressedListName(const wchar_t *name, wchar_t (&result)[16]) {
+	size_t replacement = (size_t) name;
+	if (replacement < StateLoader::IntegerCompressionStart ||
+		replacement >= StateLoader::IntegerCompressionStart + StateLoader::IntegerCompressionTokenCount)
+		return false;
+	result[0] = L'#';
+	size_t offset = replacement - StateLoader::IntegerCompressionStart;
+	size_t i = 1;
+	do {
+		result[i++] = static_cast<wchar_t>(L'0' + offset % 10);
+		offset /= 10;
+	} while (offset > 0 && i < 15);
+	result[i] = L'\0';
+	std::reverse(result + 1, result + i);
+	return true;
+}
+
+//////////////////////////////////////////////////////////////////////////
+// CompactStateWriter
+//////////////////////////////////////////////////////////////////////////
+
+void CompactStateWriter::writeHeader(std::ostream &out) {
+	out.write(CompactStateFormat::MAGIC, sizeof(CompactStateFormat::MAGIC));
+	putFixed(out, CompactStateFormat::VERSION, 4);
+}
+
+void CompactStateWriter::beginTree() {
+	_payload.clear();
+	_stringIds.clear();
+	_symbolIds.clear();
+}
+
+void CompactStateWriter::endTree(std::ostream &out) {
+	putFixed(out, _payload.size(), 8);
+	out.write(_payload.data(), static_cast<std::streamsize>(_payload.size()));
+}
+
+void CompactStateWriter::writeReal(float value) {
+	boost::uint32_t bits;
+	memcpy(&bits, &value, sizeof(bits));
+	for (int i = 0; i < 4; ++i)
+		_payload.push_back(static_cast<char>((bits >> (8*i)) & 0xff));
+}
+
+void CompactStateWriter::writeString(const wchar_t *str) {
+	// Strings are referred to by their index plus one; zero means that
+	// the string is new, and its contents follow.
+	std::pair<boost::unordered_map<std::wstring, boost::uint32_t>::iterator, bool> inserted =
+		_stringIds.insert(std::make_pair(std::wstring(str), static_cast<boost::uint32_t>(_stringIds.size())));
+	if (!inserted.second) {
+		writeUnsigned((*inserted.first).second + 1);
+		return;
+	}
+	writeUnsigned(0);
+	const std::wstring &s = (*inserted.first).first;
+	writeUnsigned(s.size());
+	for (size_t i = 0; i < s.size(); ++i)
+		writeUnsigned(static_cast<boost::uint32_t>(s[i]));
+}
+
+void CompactStateWriter::writeSymbol(Symbol sym) {
+	// Symbols are cached separately, so that a symbol's string only needs
+	// to be hashed the first time that it is written in each tree.
+	if (sym.is_null()) {
+		writeString(NULL_SYMBOL_STRING);
+		return;
+	}
+	Symbol::HashMap<boost::uint32_t>::iterator it = _symbolIds.find(sym);
+	if (it != _symbolIds.end()) {
+		writeUnsigned((*it).second + 1);
+		return;
+	}
+	writeString(sym.to_string());
+	_symbolIds[sym] = _stringIds[sym.to_string()];
+}
+
+//////////////////////////////////////////////////////////////////////////
+// CompactStateReader
+//////////////////////////////////////////////////////////////////////////
+
+void CompactStateReader::beginTree(ByteBuffer *buffer) {
+	if (buffer->getRemaining() < 8)
+		throw UnexpectedInputException("CompactStateReader::beginTree",
+			"Unexpected end of compact state data");
+	size_t n_bytes = static_cast<size_t>(getFixed(buffer->getCurrentPosition(), 8));
+	*buffer += 8;
+	if (buffer->getRemaining() < n_bytes)
+		throw UnexpectedInputException("CompactStateReader::beginTree",
+			"Compact state tree extends past the end of the data");
+	_byteBuffer = buffer;
+	startPayload(buffer->getCurrentPosition(), n_bytes);
+}
+
+void CompactStateReader::beginTree(std::istream &in) {
+	unsigned char size_bytes[8];
+	in.read(reinterpret_cast<char*>(size_bytes), 8);
+	if (in.gcount() != 8)
+		throw UnexpectedInputException("CompactStateReader::beginTree",
+			"Unexpected end of compact state file");
+	size_t n_bytes = static_cast<size_t>(getFixed(size_bytes, 8));
+	_payload.resize(n_bytes);
+	if (n_bytes > 0)
+		in.read(reinterpret_cast<char*>(&_payload[0]), static_cast<std::streamsize>(n_bytes));
+	if (static_cast<size_t>(in.gcount()) != n_bytes)
+		throw UnexpectedInputException("CompactStateReader::beginTree",
+			"Compact state tree extends past the end of the file");
+	_byteBuffer = 0;
+	startPayload(n_bytes ? &_payload[0] : 0, n_bytes);
+}
+
+void CompactStateReader::startPayload(const unsigned char *data, size_t n_bytes) {
+	_pos = data;
+	_end = data + n_bytes;
+	_tree_size = n_bytes;
+	_strings.clear();
+	_symbols.clear();
+	_hasSymbol.clear();
+}
+
+void CompactStateReader::endTree() {
+	if (_pos != _end)
+		throwBadData("state tree was not completely read");
+	if (_byteBuffer != 0)
+		*_byteBuffer += _tree_size;
+	_byteBuffer = 0;
+	_pos = _end = 0;
+}
+
+float CompactStateReader::readReal() {
+	if (_end - _pos < 4)
+		throwBadData("truncated real value");
+	boost::uint32_t bits = static_cast<boost::uint32_t>(getFixed(_pos, 4));
+	_pos += 4;
+	float value;
+	memcpy(&value, &bits, sizeof(value));
+	return value;
+}
+
+size_t CompactStateReader::readStringId() {
+	boost::uint64_t ref = readUnsigned();
+	if (ref > 0) {
+		if (ref > _strings.size())
+			throwBadData("reference to an undefined string");
+		return static_cast<size_t>(ref - 1);
+	}
+	boost::uint64_t length = readUnsigned();
+	if (length > static_cast<boost::uint64_t>(_end - _pos))
+		throwBadData("truncated string");
+	_strings.push_back(std::wstring());
+	std::wstring &str = _strings.back();
+	str.resize(static_cast<size_t>(length));
+	for (size_t i = 0; i < length; ++i)
+		str[i] = static_cast<wchar_t>(readUnsigned());
+	_symbols.push_back(Symbol());
+	_hasSymbol.push_back(false);
+	return _strings.size() - 1;
+}
+
+Symbol CompactStateReader::readSymbol() {
+	// Each distinct string is converted to a Symbol at most once per tree.
+	size_t id = readStringId();
+	if (!_hasSymbol[id]) {
+		if (_strings[id] != NULL_SYMBOL_STRING)
+			_symbols[id] = Symbol(_strings[id].c_str());
+		_hasSymbol[id] = true;
+	}
+	return _symbols[id];
+}
+
+void CompactStateReader::throwBadData(const char *what) const {
+	std::ostringstream err;
+	err << "Bad compact state data: " << what;
+	throw UnexpectedInputException("CompactStateReader", err.str().c_str());
+}
@@ -0,0 +1,150 @@
+// Copyright (c) 2012 by Raytheon BBN Technologies Corp.
+// All Rights Reserved.
+
+#ifndef COMPACT_STATE_FORMAT_H
+#define COMPACT_STATE_FORMAT_H
+
+#include "Generic/common/Symbol.h"
+#include <boost/cstdint.hpp>
+#include <boost/unordered_map.hpp>
+#include <deque>
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+class ByteBuffer;
+
+/** The compact state-file format is a versioned binary encoding of the
+  * values that StateSaver writes, which is much smaller and faster to
+  * read than either the text or the older binary state-file formats.  It
+  * is selected by setting the compact_state_files parameter; StateLoader
+  * recognizes compact state files automatically.
+  *
+  * A compact state file starts with an 8-byte magic string and a 4-byte
+  * format version, followed by the state trees.  Each state tree is
+  * stored as an 8-byte payload length followed by the payload, so a
+  * reader can load (or skip) one tree at a time.  Within a payload:
+  *   - Integers and object ids are zigzag-encoded varints, and unsigned
+  *     values are plain varints (7 bits per byte, low bits first).
+  *   - Reals are 4-byte IEEE floats.
+  *   - Strings (including symbols and list names) are references to a
+  *     per-tree string table.  A reference is a varint r: if r is zero,
+  *     then a new string follows (its length and then its characters, all
+  *     as varints), and it is given the next index in the table; otherwise
+  *     it refers to the string with index r-1.
+  *   - Anonymous lists take no space, and named lists take a string
+  *     reference for the name plus the list's object id (-1 if none).
+  * All multi-byte fixed-width values are little-endian. */
+class CompactStateFormat {
+public:
+	static const char MAGIC[8];
+	static const boost::uint32_t VERSION = 1;
+	static const size_t HEADER_SIZE = 12;
+
+	/** Return true if the given data starts with a compact state file
+	  * header.  n_bytes may be smaller than HEADER_SIZE. */
+	static bool hasHeader(const unsigned char *data, size_t n_bytes);
+
+	/** Throw UnexpectedInputException if the given header is not a
+	  * compact state file header with a supported version. */
+	static void checkHeader(const unsigned char *data, size_t n_bytes);
+
+	/** List names that are replaced by integers when state-file integer
+	  * compression is enabled (see StateLoader::IntegerCompressionOffset)
+	  * are not real strings, so they are stored as "#<offset>".  If name is
+	  * one of these, then return true and set result to its stored form. */
+	static bool getCompressedListName(const wchar_t *name, wchar_t (&result)[16]);
+};
+
+/** Encodes state trees in the compact state-file format.  Each tree is
+  * accumulated in memory, and is written out by endTree(). */
+class CompactStateWriter {
+public:
+	CompactStateWriter() {}
+
+	static void writeHeader(std::ostream &out);
+
+	void beginTree();
+	void endTree(std::ostream &out);
+
+	void writeUnsigned(boost::uint64_t value) {
+		while (value >= 0x80) {
+			_payload.push_back(static_cast<char>((value & 0x7f) | 0x80));
+			value >>= 7;
+		}
+		_payload.push_back(static_cast<char>(value));
+	}
+	void writeInteger(boost::int64_t value) {
+		writeUnsigned((static_cast<boost::uint64_t>(value) << 1) ^ static_cast<boost::uint64_t>(value >> 63));
+	}
+	void writeReal(float value);
+	void writeString(const wchar_t *str);
+	void writeSymbol(Symbol sym);
+	void writeListName(const wchar_t *name) {
+		wchar_t compressed_name[16];
+		if (CompactStateFormat::getCompressedListName(name, compressed_name))
+			writeString(compressed_name);
+		else
+			writeString(name);
+	}
+
+private:
+	std::string _payload;
+	boost::unordered_map<std::wstring, boost::uint32_t> _stringIds;
+	Symbol::HashMap<boost::uint32_t> _symbolIds;
+};
+
+/** Decodes state trees in the compact state-file format.  Trees may be
+  * read directly from memory (e.g. from a ByteBuffer that holds a whole
+  * state file), in which case nothing but the string table is copied, or
+  * from a stream, in which case each tree is read into an internal buffer
+  * when it is begun. */
+class CompactStateReader {
+public:
+	CompactStateReader(): _pos(0), _end(0), _byteBuffer(0), _tree_size(0) {}
+
+	/** Begin reading the next tree from the given buffer.  The buffer is
+	  * advanced past the tree when it ends. */
+	void beginTree(ByteBuffer *buffer);
+	/** Begin reading the next tree from the given stream. */
+	void beginTree(std::istream &in);
+	/** Throws UnexpectedInputException if any of the tree is unread. */
+	void endTree();
+
+	boost::uint64_t readUnsigned() {
+		boost::uint64_t value = 0;
+		for (int shift = 0; ; shift += 7) {
+			if (_pos == _end || shift > 63)
+				throwBadData("truncated or malformed varint");
+			unsigned char byte = *_pos++;
+			value |= static_cast<boost::uint64_t>(byte & 0x7f) << shift;
+			if ((byte & 0x80) == 0)
+				return value;
+		}
+	}
+	boost::int64_t readInteger() {
+		boost::uint64_t value = readUnsigned();
+		return static_cast<boost::int64_t>(value >> 1) ^ -static_cast<boost::int64_t>(value & 1);
+	}
+	float readReal();
+
+	/** The returned string is valid until the end of the current tree. */
+	const std::wstring &readString() { return _strings[readStringId()]; }
+	Symbol readSymbol();
+
+private:
+	const unsigned char *_pos;
+	const unsigned char *_end;
+	ByteBuffer *_byteBuffer;
+	size_t _tree_size;
+	std::vector<unsigned char> _payload;
+	std::deque<std::wstring> _strings;
+	std::vector<Symbol> _symbols;
+	std::vector<bool> _hasSymbol;
+
+	void startPayload(const unsigned char *data, size_t n_bytes);
+	size_t readStringId();
+	void throwBadData(const char *what) const;
+};
+
+#endif
@@ -6,6 +6,7 @@
 #include "Generic/state/StateLoader.h"
 #include "Generic/state/StateSaver.h"
 #include "Generic/state/ObjectPointerTable.h"
+#include "Generic/state/CompactStateFormat.h"
 #include "Generic/common/OutputUtil.h"
 #include "Generic/common/HeapChecker.h"
 #include "Generic/common/UnexpectedInputException.h"
@@ -17,6 +18,7 @@
 #include <string.h>
 #include <stdio.h>
 #include <iostream>
+#include <algorithm>
 
 unsigned int StateLoader::IntegerCompressionStart = 79879; //Initial token integer replacement
 unsigned int StateLoader::IntegerCompressionTokenCount = 8; //How many of the most common tokens to replace
@@ -39,8 +41,19 @@ StateLoader::StateLoader(const wchar_t *file_name) {
 	initialize(file_name_as_string.c_str(), ParamReader::isParamTrue("binary_state_files"));
 }
 
+bool StateLoader::isCompactStateFile(const char *file_name) {
+	std::ifstream in(file_name, std::ios::binary);
+	unsigned char header[CompactStateFormat::HEADER_SIZE];
+	in.read((char*)header, sizeof(header));
+	return CompactStateFormat::hasHeader(header, static_cast<size_t>(in.gcount()));
+}
+
 void StateLoader::initialize(const char *file_name, bool binary) {
 	_lineno = 0;
+	if (isCompactStateFile(file_name)) {
+		_compact.reset(_new CompactStateReader());
+		binary = true;
+	}
     _binary = binary;
 	_use_compressed_state = _binary && ParamReader::isParamTrue("use_state_file_integer_compression");
     _this_object_opened_the_input_stream = true;
@@ -53,6 +66,11 @@ void StateLoader::initialize(const char *file_name, bool binary) {
 			err << "Unable to load state file: " << file_name;
 			throw UnexpectedInputException("StateLoader::initialize", err.str().c_str());
 		}
+		if (_compact) {
+			unsigned char header[CompactStateFormat::HEADER_SIZE];
+			_bin_in->read((char*)header, sizeof(header));
+			CompactStateFormat::checkHeader(header, static_cast<size_t>(_bin_in->gcount()));
+		}
     } else {
 		//std::cerr << "StateLoader from file name text: " << file_name << std::endl;
 		_text_in = UTF8InputStream::build(file_name);
@@ -84,6 +102,27 @@ StateLoader::StateLoader(std::istream& in) {
     _this_object_opened_the_input_stream = false;
     _bin_in = &in;
 	_stateByteBuffer = NULL;
+	// Look for a compact state-file header.  If there is none, then put
+	// back what we read (if the stream can not seek, then we only read
+	// past its first byte if that byte could start the header).
+	std::streampos start = in.tellg();
+	if (start == std::streampos(-1) && in.peek() != CompactStateFormat::MAGIC[0])
+		return;
+	unsigned char header[CompactStateFormat::HEADER_SIZE];
+	in.read((char*)header, sizeof(header));
+	size_t n_read = static_cast<size_t>(in.gcount());
+	if (CompactStateFormat::hasHeader(header, n_read)) {
+		CompactStateFormat::checkHeader(header, n_read);
+		_compact.reset(_new CompactStateReader());
+	} else {
+		in.clear();
+		if (start != std::streampos(-1)) {
+			in.seekg(start);
+		} else {
+			for (size_t i = n_read; i > 0; --i)
+				in.putback(static_cast<char>(header[i-1]));
+		}
+	}
 }
 
 StateLoader::StateLoader(ByteBuffer* byteBuffer) {
@@ -93,6 +132,12 @@ StateLoader::StateLoader(ByteBuffer* byteBuffer) {
 	_use_compressed_state = ParamReader::isParamTrue("use_state_file_integer_compression");
     _this_object_opened_the_input_stream = false;
 	_stateByteBuffer = byteBuffer;
+	if (CompactStateFormat::hasHeader(byteBuffer->getCurrentPosition(), byteBuffer->getRemaining())) {
+		// Compact state trees are decoded in place, directly from the buffer.
+		CompactStateFormat::checkHeader(byteBuffer->getCurrentPosition(), byteBuffer->getRemaining());
+		*byteBuffer += CompactStateFormat::HEADER_SIZE;
+		_compact.reset(_new CompactStateReader());
+	}
 }
 
 StateLoader::~StateLoader() {
@@ -120,6 +165,12 @@ void StateLoader::_parse_version(const std::wstring &version_str) {
 }
 
 void StateLoader::beginStateTree(const wchar_t *state_description) {
+	if (_compact) {
+		if (STATE_LOADER_USE_BYTE_BUFFER)
+			_compact->beginTree(_stateByteBuffer);
+		else
+			_compact->beginTree(*_bin_in);
+	}
     if (_binary){
         ensureToken(L"Serif-state");
     } else {
@@ -143,13 +194,21 @@ void StateLoader::beginStateTree(const wchar_t *state_description) {
 }
 
 void StateLoader::endStateTree() {
-    if (!_binary) {
+	if (_compact) {
+		_compact->endTree();
+	} else if (!_binary) {
         ensureToken(L")");
     }
 }
 
 wchar_t *StateLoader::loadString() {
-    if (_binary) {
+	if (_compact) {
+		const std::wstring &str = _compact->readString();
+		size_t length = std::min(str.size(), static_cast<size_t>(MAX_SERIF_TOKEN_LENGTH));
+		wmemcpy(token_string, str.data(), length);
+		token_string[length] = 0;
+		return token_string;
+	} else if (_binary) {
         unsigned short int length;
 
 		if (STATE_LOADER_USE_BYTE_BUFFER) {
@@ -174,7 +233,9 @@ void StateLoader::loadSpecificString(const wchar_t *str, const char *message) {
 }
 
 Symbol StateLoader::loadSymbol() {
-    if (_binary) {
+	if (_compact) {
+		return _compact->readSymbol();
+	} else if (_binary) {
         wchar_t* string = loadString();
         if (wcscmp(string, L"<null-symbol>")) {
             return Symbol(string);
@@ -192,7 +253,9 @@ Symbol StateLoader::loadSymbol() {
 }
 
 int StateLoader::loadInteger() {
-    if (_binary) {
+	if (_compact) {
+		return static_cast<int>(_compact->readInteger());
+	} else if (_binary) {
         int i;
 
 		if (STATE_LOADER_USE_BYTE_BUFFER) {
@@ -207,7 +270,9 @@ int StateLoader::loadInteger() {
     }
 }
 unsigned StateLoader::loadUnsigned() {
-    if (_binary) {
+	if (_compact) {
+		return static_cast<unsigned>(_compact->readUnsigned());
+	} else if (_binary) {
         unsigned u;
 
 		if (STATE_LOADER_USE_BYTE_BUFFER) {
@@ -225,7 +290,9 @@ unsigned StateLoader::loadUnsigned() {
 }
 
 float StateLoader::loadReal() {
-    if (_binary) {
+	if (_compact) {
+		return _compact->readReal();
+	} else if (_binary) {
         float f;
 
 		if (STATE_LOADER_USE_BYTE_BUFFER) {
@@ -262,7 +329,21 @@ void *StateLoader::loadPointer() {
 
 int StateLoader::beginList(const wchar_t *name) {
 	int id = -1;
-    if (_binary) {
+	if (_compact) {
+		if (name != 0) {
+			// check that the name matches and get the object id
+			wchar_t compressed_name[16];
+			const wchar_t *expected = CompactStateFormat::getCompressedListName(name, compressed_name) ? compressed_name : name;
+			const std::wstring &found = _compact->readString();
+			if (found != expected) {
+				std::ostringstream err;
+				err << "Expected object " << OutputUtil::convertToChar(expected)
+					<< " but got: " << OutputUtil::convertToChar(found.c_str());
+				throw UnexpectedInputException("CompactStateLoader::beginList()", err.str().c_str());
+			}
+			id = static_cast<int>(_compact->readInteger());
+		}
+	} else if (_binary) {
         if (name != 0) {
 			// Do for binary only because FullQuery loads from text!
 			size_t replacement = (size_t) name;
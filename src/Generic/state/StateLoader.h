@@ -9,6 +9,7 @@
 #include "Generic/common/UnexpectedInputException.h"
 #include "Generic/state/ObjectPointerTable.h"
 #include "Generic/state/ByteBuffer.h"
+#include <boost/scoped_ptr.hpp>
 #include <memory>
 #include <vector>
 
@@ -20,13 +21,17 @@
 
 class Parse;
 class SynNode;
+class CompactStateReader;
 
 class SERIF_EXPORTED StateLoader {
 public:
 	// Make a single StateLoader object per input file. You may,
 	// however, use it to load multiple state trees.
 	// If the file is not found, you'll get an
-	// UnexpectedInputException.
+	// UnexpectedInputException.  Compact state files (see
+	// CompactStateFormat.h) are recognized automatically by the
+	// file name, binary stream and ByteBuffer constructors,
+	// regardless of the binary flag.
 	explicit StateLoader(const char* file_name);
 	StateLoader(const char* file_name, bool binary);
 	explicit StateLoader(const wchar_t* file_name);
@@ -45,6 +50,9 @@ public:
 	static unsigned int IntegerCompressionStart; //Initial token integer replacement
 	static unsigned int IntegerCompressionTokenCount; //How many of the most common tokens to replace
 
+	// Return true if the given file starts with a compact state-file header.
+	static bool isCompactStateFile(const char* file_name);
+
 	// This order has to match that set in DocConvert
 	enum IntegerCompressionOffset {
 		EntitySetOffset,
@@ -132,6 +140,9 @@ private:
 	std::wistream* _text_in;                    // Test stream
     std::istream* _bin_in;                     // Binary stream	
 
+	// Set if we are reading a compact state file; _binary is also set.
+	boost::scoped_ptr<CompactStateReader> _compact;
+
 	/** The version string for the state file that we're currently loading.  This
 	  * gets set by beginStateTree(), and cleared by endStateTree(). */
 	std::pair<int,int> _version;
@@ -4,6 +4,7 @@
 #include "Generic/common/leak_detection.h"
 
 #include "Generic/state/StateSaver.h"
+#include "Generic/state/CompactStateFormat.h"
 #include "dynamic_includes/common/SerifRestrictions.h"
 #include "Generic/state/ObjectIDTable.h"
 #include "Generic/common/InternalInconsistencyException.h"
@@ -33,28 +34,41 @@ StateSaver::StateSaver(const wchar_t *file_name, bool binary) {
 	initialize(file_name_as_string.c_str(), binary);
 }
 
+StateSaver::StateSaver(const char *file_name, bool binary, bool compact) {
+	initialize(file_name, binary, compact);
+}
+
 /* Binary defaults to false, unless binary-state-files param is set. */
 StateSaver::StateSaver(const char *file_name) {
-	initialize(file_name, ParamReader::isParamTrue("binary_state_files"));
+	initializeFromParams(file_name);
 }
 
 /* Binary defaults to false, unless binary-state-files param is set. */
 StateSaver::StateSaver(const wchar_t *file_name) {
 	std::string file_name_as_string = OutputUtil::convertToUTF8BitString(file_name);
-	initialize(file_name_as_string.c_str(), ParamReader::isParamTrue("binary_state_files"));
+	initializeFromParams(file_name_as_string.c_str());
 }
 
 StateSaver::StateSaver(OutputStream& text_out)
 	: _binary(false), _depth(0), _text_out(&text_out),
 	  _this_object_created_text_out(false) {}
 
-void StateSaver::initialize(const char *file_name, bool binary) {
-    _binary = binary;
+void StateSaver::initializeFromParams(const char *file_name) {
+	bool compact = ParamReader::isParamTrue("compact_state_files");
+	initialize(file_name, compact || ParamReader::isParamTrue("binary_state_files"), compact);
+}
+
+void StateSaver::initialize(const char *file_name, bool binary, bool compact) {
+    _binary = binary || compact;
 	_depth = 0;
     if (_binary) {
         _bin_out.open(file_name, std::ios::binary);
 		_text_out = 0;
 		_this_object_created_text_out = false;
+		if (compact) {
+			_compact.reset(_new CompactStateWriter());
+			CompactStateWriter::writeHeader(_bin_out);
+		}
     } else {
         _text_out = _new UTF8OutputStream(file_name);
 		_this_object_created_text_out = true;
@@ -83,7 +97,9 @@ void StateSaver::beginStateTree(const wchar_t *state_description) {
 	#endif
 
 	_depth++;
-    if (!_binary) {
+	if (_compact) {
+		_compact->beginTree();
+	} else if (!_binary) {
         (*_text_out) << L"(";
         _current_list_empty_so_far = true;
         _current_list_multiline = false;
@@ -103,14 +119,19 @@ void StateSaver::endStateTree() {
 			"Attempt to end state tree at depth other than 1");
 	}
 	_depth--;
-    if (!_binary) {
+	if (_compact) {
+		_compact->endTree(_bin_out);
+		_bin_out.flush();
+	} else if (!_binary) {
         (*_text_out) << L"\n)\n";
         _text_out->flush();
     }
 }
 
 void StateSaver::saveWord(const wchar_t *str) {
-    if (_binary) {
+	if (_compact) {
+		_compact->writeString(str);
+	} else if (_binary) {
         size_t length = wcslen(str) * 2; // Each wide char is two bytes
         _bin_out.write((char*) &length, sizeof(unsigned short int));
         _bin_out.write((char*) str, (std::streamsize) length);  // Note that we do not write out the null terminator
@@ -130,7 +151,9 @@ void StateSaver::saveWord(const wchar_t *str) {
 }
 
 void StateSaver::saveString(const wchar_t *str) {
-    if (_binary) {
+	if (_compact) {
+		_compact->writeString(str);
+	} else if (_binary) {
         size_t length = wcslen(str) * 2; // Each wide char is two bytes
         _bin_out.write((char*) &length, sizeof(unsigned short int));
         _bin_out.write((char*) str, (std::streamsize) length);  // Note that we do not write out the null terminator
@@ -164,7 +187,9 @@ void StateSaver::saveString(const wchar_t *str) {
 }
 
 void StateSaver::saveSymbol(Symbol symbol) {
-    if (symbol.is_null()) {
+	if (_compact) {
+		_compact->writeSymbol(symbol);
+	} else if (symbol.is_null()) {
         saveString(L"<null-symbol>");
     } else {
 		saveString(symbol.to_string());
@@ -172,7 +197,9 @@ void StateSaver::saveSymbol(Symbol symbol) {
 }
 
 void StateSaver::saveInteger(int integer) {
-    if (_binary) {
+	if (_compact) {
+		_compact->writeInteger(integer);
+	} else if (_binary) {
         _bin_out.write((char*) &integer, sizeof(int));
     } else {
         wchar_t buf[12];
@@ -182,7 +209,9 @@ void StateSaver::saveInteger(int integer) {
 }
 
 void StateSaver::saveUnsigned(unsigned x) {
-    if (_binary) {
+	if (_compact) {
+		_compact->writeUnsigned(x);
+	} else if (_binary) {
         _bin_out.write((char*) &x, sizeof(unsigned));
     } else {	
         wchar_t buf[12];
@@ -192,7 +221,9 @@ void StateSaver::saveUnsigned(unsigned x) {
 }
 
 void StateSaver::saveReal(float real) {
-    if (_binary) {
+	if (_compact) {
+		_compact->writeReal(real);
+	} else if (_binary) {
         _bin_out.write((char*) &real, sizeof(float));
     } else {
         wchar_t buf[100];
@@ -222,7 +253,12 @@ void StateSaver::savePointer(const void *pointer) {
 }
 
 void StateSaver::beginList(const wchar_t *name, const void *pointer) {
-    if (_binary) {
+	if (_compact) {
+		if (name != 0) {
+			_compact->writeListName(name);
+			_compact->writeInteger(pointer != 0 ? ObjectIDTable::getID(pointer) : -1);
+		}
+	} else if (_binary) {
         if (name != 0) {
             saveString(name);
             if (pointer != 0) {
@@ -6,17 +6,25 @@
 
 #include "Generic/common/Symbol.h"
 #include "Generic/common/OutputStream.h"
+#include <boost/scoped_ptr.hpp>
 #include <fstream>
 
+class CompactStateWriter;
+
 
 class StateSaver {
 public:
 	// Make a single StateSaver object per output file. You may,
 	// however, use it to save multiple state trees.
+	// The constructors that do not take a binary flag write compact
+	// state files if the compact_state_files parameter is true (see
+	// CompactStateFormat.h), binary files if binary_state_files is
+	// true, and text files otherwise.
 	explicit StateSaver(const char *file_name);
 	explicit StateSaver(const wchar_t *file_name);
 	StateSaver(const char *file_name, bool binary);
 	StateSaver(const wchar_t *file_name, bool binary);
+	StateSaver(const char *file_name, bool binary, bool compact);
 	StateSaver(OutputStream& text_out);  // text output
 	~StateSaver();
 
@@ -74,8 +82,12 @@ private:
 	bool _current_list_multiline;
 	static const std::pair<int, int> _version;
 
+	// Used instead of the binary stream encoding for compact state files.
+	boost::scoped_ptr<CompactStateWriter> _compact;
+
 	void advanceToNextLine();
-	void initialize(const char* file_name, bool binary);
+	void initialize(const char* file_name, bool binary, bool compact = false);
+	void initializeFromParams(const char* file_name);
 };
 
 #endif
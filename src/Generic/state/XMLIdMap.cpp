@@ -28,20 +28,22 @@ bool XMLIdMap::hasId(const xstring &id) const {
 }
 
 xstring XMLIdMap::getId(const Theory* theory) const {
-	if (!hasId(theory))
+	TheoryToIdMap::const_iterator it = _theory2id.find(theory);
+	if (it == _theory2id.end())
 		throw InternalInconsistencyException(
 			"SerifXMLDocument::IdMap::getId", "no id assigned!");
-	return _theory2id.find(theory)->second;
+	return it->second;
 }
 
 const Theory* XMLIdMap::getTheory(const xstring &id) const {
-	if (_id2theory.find(id) == _id2theory.end()) {
+	IdToTheoryMap::const_iterator it = _id2theory.find(id);
+	if (it == _id2theory.end()) {
 		std::wstringstream message;
 		message << L"id (" << transcodeToStdWString(id.c_str()) << L") not found!";
 		throw UnexpectedInputException(
 			"SerifXMLDocument::IdMap::getItem", message);
 	}
-	return _id2theory.find(id)->second;
+	return it->second;
 }
 
 void XMLIdMap::registerId(const XMLCh* idString, const Theory *theory) {
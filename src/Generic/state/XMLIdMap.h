@@ -9,6 +9,7 @@
 #include <string>
 #include <vector>
 #include <map>
+#include <boost/unordered_map.hpp>
 #include "Generic/state/XMLStrings.h"
 class Theory;
 
@@ -28,13 +29,19 @@ namespace SerifXML {
 class XMLIdMap {
 private:
 	// String identifiers: these are used in the XML.  Note that if we're 
-	// reading in XML from the user, these might be anything.
-	std::map<SerifXML::xstring, const Theory*> _id2theory;
-	std::map<const Theory*, SerifXML::xstring> _theory2id;
+	// reading in XML from the user, these might be anything.  (_id2theory
+	// is a hash map because loading resolves every pointer attribute through
+	// it, and with hundreds of thousands of ids, comparing id strings is
+	// slow.  _theory2id is not: theories are usually added in the order they
+	// were allocated, and a std::map is faster for that.)
+	typedef boost::unordered_map<SerifXML::xstring, const Theory*> IdToTheoryMap;
+	typedef std::map<const Theory*, SerifXML::xstring> TheoryToIdMap;
+	IdToTheoryMap _id2theory;
+	TheoryToIdMap _theory2id;
 
 	/** Map used to generate new XML identifiers.  It maps from 
 	  * each prefix to the next unused id number. */
-	std::map<SerifXML::xstring, size_t> _nextXMLId;
+	boost::unordered_map<SerifXML::xstring, size_t> _nextXMLId;
 
 	/** If true, then number identifier starting at 1.  Otherwise,
 	  * number identifiers starting at zero. */
@@ -4,6 +4,7 @@
 #include "Generic/common/leak_detection.h"
 
 #include "Generic/state/XMLSerializedDocTheory.h"
+#include "Generic/state/CompactDocTheoryFile.h"
 #include "Generic/state/XMLTheoryElement.h"
 #include "Generic/state/XMLIdMap.h"
 #include "Generic/state/XMLStrings.h"
@@ -103,7 +104,12 @@ void XMLSerializedDocTheory::load(const char* filename) {
 		throw InternalInconsistencyException("XMLSerializedDocTheory::load",
 			"load should not be called twice with the same XMLSerializedDocTheory object");
 	_originalText = 0;
-	_xercesDOMDocument = XMLUtil::loadXercesDOMFromFilename(filename);
+	if (CompactDocTheoryFile::isCompactFile(filename)) {
+		_compactFilename = filename;
+		return;
+	}
+	// We don't need the comments or indentation, so leave them out of the DOM.
+	_xercesDOMDocument = XMLUtil::loadXercesDOMFromFilename(filename, true);
 	// Should we check the SerifXML version of the document?
 }
 
@@ -118,11 +124,16 @@ XMLSerializedDocTheory::XMLSerializedDocTheory(xercesc::DOMDocument *domDocument
 }
 
 std::pair<Document*, DocTheory*> XMLSerializedDocTheory::generateDocTheory() {
+	if (!_compactFilename.empty())
+		return CompactDocTheoryFile::load(_compactFilename.c_str());
 	DocTheory *docTheory = _new DocTheory(getDocumentElement());
 	return std::make_pair(docTheory->getDocument(), docTheory);
 }
 
 XMLTheoryElement XMLSerializedDocTheory::getDocumentElement() {
+	if (!_compactFilename.empty())
+		throw InternalInconsistencyException("XMLSerializedDocTheory::getDocumentElement",
+			"A compact DocTheory file has no XML document element; use generateDocTheory()");
 	XMLTheoryElement rootElem(this, _xercesDOMDocument->getDocumentElement());
     if (rootElem.hasTag(X_Document))
         return rootElem;
@@ -88,7 +88,18 @@ public:
 	/** Load a serialized document from disk.  If the file does not contain
 	  * well-formed XML, then throw an UnexpectedInputException.  The
 	  * contents of the XML document are *not* read, nor converted to a
-	  * DocTheory object, util generateDocTheory() is called. */
+	  * DocTheory object, util generateDocTheory() is called.  If the file
+	  * is a compact DocTheory file (see CompactDocTheoryFile.h), then it
+	  * is not parsed at all: generateDocTheory() loads it instead, and
+	  * there is no DOMDocument.
+	  *
+	  * Otherwise, the file is parsed into a compact DOM (see
+	  * XMLUtil::loadXercesDOMFromFilename), so the whole document is still
+	  * held in memory until the XMLSerializedDocTheory is deleted.  A
+	  * streaming loader, which built theory objects directly from SAX
+	  * events, would avoid that; but every theory's deserialization
+	  * constructor reads from an XMLTheoryElement, so that would mean
+	  * rewriting all of them.  It has not been done yet. */
 	XMLSerializedDocTheory(const char* filename);
 	XMLSerializedDocTheory(const wchar_t* filename);
 
@@ -204,6 +215,9 @@ private:
 
 	// The set of lexical entries used in this document.
 	LexicalEntry::LexicalEntrySet _lexicalEntries;
+
+	// If we were constructed from a compact DocTheory file, then its name.
+	std::string _compactFilename;
 };
 
 } // namespace SerifXML
@@ -129,6 +129,16 @@ SentenceTheory *SentenceTheoryBeam::extractBestTheory() {
 	return _theories[0];
 }
 
+void SentenceTheoryBeam::pruneToBestTheory() {
+	for (int i = 1; i < _n_theories; i++) {
+		delete _theories[i];
+		_theories[i] = 0;
+	}
+	if (_n_theories > 1)
+		_n_theories = 1;
+	_unique_subtheories_up_to_date = false;
+}
+
 
 void SentenceTheoryBeam::ensureUniqueSubtheoriesUpToDate() const {
 	/* Sometimes subtheories change behind our back -- E.g., entity finding can change
@@ -61,6 +61,10 @@ public:
 	  */
 	SentenceTheory *extractBestTheory();
 
+	/** Delete every theory in the beam except for the highest-scoring
+	  * one, which stays in the beam. */
+	void pruneToBestTheory();
+
 
 	// For saving state:
 	void updateObjectIDTable() const;
@@ -80,6 +80,12 @@ void DefaultValueRecognizer::resetForNewDocument(DocTheory* docTheory)
 
 }
 
+void DefaultValueRecognizer::releaseSentenceCaches()
+{
+	if (DO_VALUES && _value_finder == PIDF_VALUE_FINDER)
+		_pidfDecoder->releaseObservations();
+}
+
 int DefaultValueRecognizer::getValueTheories(ValueMentionSet **results, int max_theories,
 											 TokenSequence *tokenSequence)
 {
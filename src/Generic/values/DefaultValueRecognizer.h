@@ -26,6 +26,7 @@ public:
 
 	void resetForNewSentence();
 	void resetForNewDocument(DocTheory* docTheory);
+	void releaseSentenceCaches();
 	int getValueTheories(ValueMentionSet **vms, int i, TokenSequence* ts);
 
 private:
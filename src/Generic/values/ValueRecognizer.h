@@ -27,6 +27,10 @@ public:
 	virtual void resetForNewSentence() = 0;
 	virtual void resetForNewDocument(DocTheory *docTheory = 0) = 0;
 
+	// Free any per-token feature caches that are kept from the most
+	// recent sentence (see NameRecognizer::releaseSentenceCaches()).
+	virtual void releaseSentenceCaches() {}
+
 	// This does the work. It populates an array of pointers to ValueMentionSets
 	// specified by results arg with up to max_theories ValueMentionSet pointers,
 	// and returns the number of theories actually created, or 0 if
@@ -0,0 +1,626 @@
+// Copyright (c) 2012 by Raytheon BBN Technologies Corp.
+// All Rights Reserved.
+
+#include "Generic/common/leak_detection.h"
+
+#include "Generic/wordnet/WordNetDatabase.h"
+#include "Generic/common/UnexpectedInputException.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+
+namespace {
+	// Suffix rules for morphword(); see morph.c.
+	const char *SUFFIXES[] = {
+		/* Noun suffixes */
+		"s","ses","xes","zes","ches","shes",
+		/* Verb suffixes */
+		"s","ies","es","es","ed","ed","ing","ing",
+		/* Adjective suffixes */
+		"er","est","er", "est"
+	};
+	const char *ENDINGS[] = {
+		/* Noun endings */
+		"", "s", "x", "z", "ch", "sh",
+		/* Verb endings */
+		"", "y", "e", "", "e", "", "e", "",
+		/* Adjective endings */
+		"", "", "e", "e"
+	};
+	const int SUFFIX_OFFSETS[NUMPARTS] = { 0, 0, 6, 14 };
+	const int SUFFIX_COUNTS[NUMPARTS] = { 0, 6, 8, 4 };
+
+	const char *PREPOSITIONS[] = { "to", "at", "of", "on", "off", "in", "out", "up",
+		"down", "from", "with", "into", "for", "about", "between" };
+	const size_t NUM_PREPOSITIONS = sizeof(PREPOSITIONS) / sizeof(PREPOSITIONS[0]);
+
+	/** Equivalent to strtolower() in wnutil.c: lowercase ASCII letters, and
+	  * strip any "(...)" adjective marker. */
+	std::string toLower(const std::string &str) {
+		std::string result(str);
+		for (size_t i = 0; i < result.size(); ++i) {
+			if (result[i] >= 'A' && result[i] <= 'Z') {
+				result[i] += 32;
+			} else if (result[i] == '(') {
+				result.resize(i);
+				break;
+			}
+		}
+		return result;
+	}
+
+	std::string substitute(const std::string &str, char from, char to) {
+		std::string result(str);
+		for (size_t i = 0; i < result.size(); ++i) {
+			if (result[i] == from)
+				result[i] = to;
+		}
+		return result;
+	}
+
+	std::string removeChars(const std::string &str, const char *chars) {
+		std::string result;
+		for (size_t i = 0; i < str.size(); ++i) {
+			if (strchr(chars, str[i]) == 0)
+				result += str[i];
+		}
+		return result;
+	}
+
+	/** Equivalent to cntwords() in wnutil.c. */
+	int countWords(const std::string &str, char separator) {
+		int wdcnt = 0;
+		size_t i = 0;
+		while (i < str.size()) {
+			char c = str[i];
+			if (c == separator || c == ' ' || c == '_') {
+				wdcnt++;
+				while (i < str.size() && (str[i] == separator || str[i] == ' ' || str[i] == '_'))
+					i++;
+			} else {
+				i++;
+			}
+		}
+		return wdcnt + 1;
+	}
+
+	bool strend(const std::string &str, const char *suffix) {
+		size_t len = strlen(suffix);
+		return len < str.size() && str.compare(str.size() - len, len, suffix) == 0;
+	}
+
+	std::string wordbase(const std::string &word, int ender) {
+		if (strend(word, SUFFIXES[ender]))
+			return word.substr(0, word.size() - strlen(SUFFIXES[ender])) + ENDINGS[ender];
+		return word;
+	}
+
+	void tokenize(const std::string &line, std::vector<std::string> &tokens) {
+		tokens.clear();
+		std::istringstream in(line);
+		std::string token;
+		while (in >> token)
+			tokens.push_back(token);
+	}
+
+	char *copyString(const std::string &str) {
+		char *result = static_cast<char *>(malloc(str.size() + 1));
+		strcpy(result, str.c_str());
+		return result;
+	}
+
+	template<typename T> T *allocArray(size_t n) {
+		return static_cast<T *>(calloc(n > 0 ? n : 1, sizeof(T)));
+	}
+
+	bool isSatellite(const std::string &pos) {
+		return !pos.empty() && pos[0] == 's';
+	}
+
+	bool isValidPos(int pos) {
+		return pos >= 1 && pos <= NUMPARTS;
+	}
+}
+
+WordNetDatabase::WordNetDatabase(const char *searchdir) {
+	char filename[256];
+	for (int i = 1; i <= NUMPARTS; i++) {
+		sprintf(filename, INDEXFILE, searchdir, partnames[i]);
+		loadIndexFile(filename, i);
+		sprintf(filename, DATAFILE, searchdir, partnames[i]);
+		loadDataFile(filename, i);
+		sprintf(filename, EXCFILE, searchdir, partnames[i]);
+		loadExceptionFile(filename, i);
+	}
+}
+
+size_t WordNetDatabase::getNSynsets() const {
+	size_t n = 0;
+	for (int i = 1; i <= NUMPARTS; i++)
+		n += _synsets[i].size();
+	return n;
+}
+
+void WordNetDatabase::readLines(const std::string &filename, std::vector<std::string> &lines, std::vector<long> *offsets) {
+	std::ifstream in(filename.c_str(), std::ios::binary);
+	if (!in.is_open())
+		throw UnexpectedInputException("WordNetDatabase::readLines", "Can't open WordNet file ", filename.c_str());
+	std::string line;
+	long offset = 0;
+	while (std::getline(in, line)) {
+		long next_offset = offset + static_cast<long>(line.size()) + 1;
+		if (!line.empty() && line[line.size() - 1] == '\r')
+			line.resize(line.size() - 1);
+		// Lines that start with a space are part of the license header.
+		if (!line.empty() && line[0] != ' ') {
+			lines.push_back(line);
+			if (offsets)
+				offsets->push_back(offset);
+		}
+		offset = next_offset;
+	}
+}
+
+// Index lines have the form:
+//   lemma pos synset_cnt p_cnt [ptr_symbol...] sense_cnt [tagsense_cnt] synset_offset...
+// (see index_lookup() in search.c).
+void WordNetDatabase::loadIndexFile(const std::string &filename, int dbase) {
+	std::vector<std::string> lines;
+	readLines(filename, lines);
+	bool has_tagged_cnt = (strcmp(wnrelease, "1.6") == 0);
+	std::vector<std::string> tokens;
+	for (size_t i = 0; i < lines.size(); ++i) {
+		tokenize(lines[i], tokens);
+		if (tokens.size() < 5)
+			continue;
+		IndexEntry entry;
+		size_t t = 0;
+		entry.wd = tokens[t++];
+		entry.pos = tokens[t++];
+		entry.sense_cnt = atoi(tokens[t++].c_str());
+		int ptruse_cnt = atoi(tokens[t++].c_str());
+		for (int j = 0; j < ptruse_cnt && t < tokens.size(); j++)
+			entry.ptruse.push_back(getptrtype(tokens[t++].c_str()));
+		int off_cnt = (t < tokens.size()) ? atoi(tokens[t++].c_str()) : 0;
+		entry.tagged_cnt = -1;
+		if (has_tagged_cnt && t < tokens.size())
+			entry.tagged_cnt = atoi(tokens[t++].c_str());
+		for (int j = 0; j < off_cnt && t < tokens.size(); j++)
+			entry.offsets.push_back(atol(tokens[t++].c_str()));
+		_index[dbase][entry.wd] = entry;
+	}
+}
+
+// Data lines have the form:
+//   synset_offset lex_filenum ss_type w_cnt word lex_id [word lex_id...] p_cnt
+//   [ptr...] [frames...] | gloss
+// (see parse_synset() in search.c).  Synsets are keyed by the byte offset
+// of their line, which must match the line's first field.
+void WordNetDatabase::loadDataFile(const std::string &filename, int dbase) {
+	std::vector<std::string> lines;
+	std::vector<long> offsets;
+	readLines(filename, lines, &offsets);
+	std::vector<std::string> tokens;
+	for (size_t i = 0; i < lines.size(); ++i) {
+		std::string line = lines[i];
+		size_t gloss = line.find(" | ");
+		if (gloss != std::string::npos)
+			line.resize(gloss);
+		tokenize(line, tokens);
+		if (tokens.size() < 4 || atol(tokens[0].c_str()) != offsets[i])
+			continue;
+		SynsetEntry &entry = _synsets[dbase][offsets[i]];
+		size_t t = 1;
+		entry.fnum = atoi(tokens[t++].c_str());
+		entry.pos = tokens[t++];
+		int wcount = strtol(tokens[t++].c_str(), NULL, 16);
+		for (int j = 0; j < wcount && t + 1 < tokens.size(); j++) {
+			entry.words.push_back(tokens[t++]);
+			entry.lexids.push_back(strtol(tokens[t++].c_str(), NULL, 16));
+		}
+		int ptrcount = (t < tokens.size()) ? atoi(tokens[t++].c_str()) : 0;
+		for (int j = 0; j < ptrcount && t + 3 < tokens.size(); j++) {
+			Pointer ptr;
+			ptr.ptrtyp = getptrtype(tokens[t++].c_str());
+			ptr.ptroff = atol(tokens[t++].c_str());
+			ptr.ppos = getpos(tokens[t++].c_str());
+			const std::string &frmto = tokens[t++];
+			ptr.pfrm = strtol(frmto.substr(0, 2).c_str(), NULL, 16);
+			ptr.pto = strtol(frmto.substr(2, 2).c_str(), NULL, 16);
+			entry.pointers.push_back(ptr);
+		}
+		if (dbase == VERB && t < tokens.size()) {
+			int fcount = atoi(tokens[t++].c_str());
+			for (int j = 0; j < fcount && t + 2 < tokens.size(); j++) {
+				t++; // skip the frame pointer (+)
+				int frmid = atoi(tokens[t++].c_str());
+				int frmto = atoi(tokens[t++].c_str());
+				entry.frames.push_back(std::make_pair(frmid, frmto));
+			}
+		}
+	}
+}
+
+// Exception lines have the form "inflected_form base_form [base_form...]".
+void WordNetDatabase::loadExceptionFile(const std::string &filename, int dbase) {
+	std::vector<std::string> lines;
+	readLines(filename, lines);
+	std::vector<std::string> tokens;
+	for (size_t i = 0; i < lines.size(); ++i) {
+		tokenize(lines[i], tokens);
+		if (tokens.size() < 2 || _exceptions[dbase].find(tokens[0]) != _exceptions[dbase].end())
+			continue;
+		_exceptions[dbase][tokens[0]].assign(tokens.begin() + 1, tokens.end());
+	}
+}
+
+const WordNetDatabase::IndexEntry *WordNetDatabase::index_lookup(const std::string &word, int dbase) const {
+	if (!isValidPos(dbase))
+		return 0;
+	IndexMap::const_iterator it = _index[dbase].find(word);
+	return (it == _index[dbase].end()) ? 0 : &(*it).second;
+}
+
+// 'Smart' search of the index: find the word, trying different techniques -
+// replace hyphens with underscores, replace underscores with hyphens, strip
+// hyphens and underscores, strip periods.
+void WordNetDatabase::getindex(const char *searchstr, int dbase, std::vector<const IndexEntry*> &entries) const {
+	entries.clear();
+	std::string strings[MAX_FORMS];
+	strings[0] = toLower(searchstr);
+	strings[1] = substitute(strings[0], '_', '-');
+	strings[2] = substitute(strings[0], '-', '_');
+	strings[3] = removeChars(strings[0], "_-");
+	strings[4] = removeChars(strings[0], ".");
+	for (int i = 0; i < MAX_FORMS; i++) {
+		if (i == 0 || strings[i] != strings[0]) {
+			if (const IndexEntry *entry = index_lookup(strings[i], dbase))
+				entries.push_back(entry);
+		}
+	}
+}
+
+bool WordNetDatabase::is_defined(const char *searchstr, int dbase) const {
+	std::vector<const IndexEntry*> entries;
+	getindex(searchstr, dbase, entries);
+	return !entries.empty();
+}
+
+int WordNetDatabase::get_sense_count(const char *searchstr, int dbase) const {
+	std::vector<const IndexEntry*> entries;
+	getindex(searchstr, dbase, entries);
+	return entries.empty() ? 0 : static_cast<int>(entries[0]->offsets.size());
+}
+
+SynsetPtr WordNetDatabase::read_synset(int dbase, long boffset, const char *word) const {
+	if (!isValidPos(dbase))
+		return 0;
+	SynsetMap::const_iterator it = _synsets[dbase].find(boffset);
+	if (it == _synsets[dbase].end())
+		return 0;
+	const SynsetEntry &entry = (*it).second;
+
+	SynsetPtr synptr = static_cast<SynsetPtr>(calloc(1, sizeof(Synset)));
+	synptr->hereiam = boffset;
+	synptr->sstype = isSatellite(entry.pos) ? INDIRECT_ANT : DONT_KNOW;
+	synptr->fnum = entry.fnum;
+	synptr->pos = copyString(entry.pos);
+	synptr->searchtype = -1;
+
+	synptr->wcount = static_cast<int>(entry.words.size());
+	synptr->words = allocArray<char *>(synptr->wcount);
+	synptr->wnsns = allocArray<int>(synptr->wcount);
+	synptr->lexid = allocArray<int>(synptr->wcount);
+	for (int i = 0; i < synptr->wcount; i++) {
+		synptr->words[i] = copyString(entry.words[i]);
+		synptr->lexid[i] = entry.lexids[i];
+		if (word && toLower(entry.words[i]) == word)
+			synptr->whichword = i + 1;
+	}
+
+	synptr->ptrcount = static_cast<int>(entry.pointers.size());
+	if (synptr->ptrcount) {
+		synptr->ptrtyp = allocArray<int>(synptr->ptrcount);
+		synptr->ptroff = allocArray<long>(synptr->ptrcount);
+		synptr->ppos = allocArray<int>(synptr->ptrcount);
+		synptr->pto = allocArray<int>(synptr->ptrcount);
+		synptr->pfrm = allocArray<int>(synptr->ptrcount);
+		bool foundpert = false;
+		for (int i = 0; i < synptr->ptrcount; i++) {
+			const Pointer &ptr = entry.pointers[i];
+			synptr->ptrtyp[i] = ptr.ptrtyp;
+			synptr->ptroff[i] = ptr.ptroff;
+			synptr->ppos[i] = ptr.ppos;
+			synptr->pto[i] = ptr.pto;
+			synptr->pfrm[i] = ptr.pfrm;
+			// For adjectives, set the synset type if it has a direct antonym
+			if (dbase == ADJ && synptr->sstype == DONT_KNOW) {
+				if (ptr.ptrtyp == ANTPTR)
+					synptr->sstype = DIRECT_ANT;
+				else if (ptr.ptrtyp == PERTPTR)
+					foundpert = true;
+			}
+		}
+		if (dbase == ADJ && synptr->sstype == DONT_KNOW && foundpert)
+			synptr->sstype = PERTAINYM;
+	}
+
+	synptr->fcount = static_cast<int>(entry.frames.size());
+	if (synptr->fcount) {
+		synptr->frmid = allocArray<int>(synptr->fcount);
+		synptr->frmto = allocArray<int>(synptr->fcount);
+		for (int i = 0; i < synptr->fcount; i++) {
+			synptr->frmid[i] = entry.frames[i].first;
+			synptr->frmto[i] = entry.frames[i].second;
+		}
+	}
+	return synptr;
+}
+
+SynsetPtr WordNetDatabase::findtheinfo_ds(const char *searchstr, int dbase, int ptrtyp, int whichsense) const {
+	SynsetPtr synlist = NULL, lastsyn = NULL;
+	int depth = 0;
+
+	std::vector<const IndexEntry*> entries;
+	getindex(searchstr, dbase, entries);
+	for (size_t e = 0; e < entries.size(); ++e) {
+		const IndexEntry *idx = entries[e];
+		bool newsense = true;
+
+		if (ptrtyp < 0) {
+			ptrtyp = -ptrtyp;
+			depth = 1;
+		}
+
+		// Go through all of the searchword's senses in the database and
+		// perform the search requested.
+		for (size_t sense = 0; sense < idx->offsets.size(); sense++) {
+			if (whichsense == ALLSENSES || whichsense == static_cast<int>(sense) + 1) {
+				SynsetPtr cursyn = read_synset(dbase, idx->offsets[sense], idx->wd.c_str());
+				if (cursyn == NULL)
+					continue;
+				if (lastsyn) {
+					if (newsense)
+						lastsyn->nextform = cursyn;
+					else
+						lastsyn->nextss = cursyn;
+				}
+				if (!synlist)
+					synlist = cursyn;
+				newsense = false;
+
+				cursyn->searchtype = ptrtyp;
+				cursyn->ptrlist = traceptrs_ds(cursyn, ptrtyp, getpos(cursyn->pos), depth);
+
+				lastsyn = cursyn;
+
+				if (whichsense == static_cast<int>(sense) + 1)
+					break;
+			}
+		}
+	}
+	return synlist;
+}
+
+// Recursively trace a pointer tree, and return the results in a linked
+// list of synsets.
+SynsetPtr WordNetDatabase::traceptrs_ds(SynsetPtr synptr, int ptrtyp, int dbase, int depth) const {
+	SynsetPtr synlist = NULL, lastsyn = NULL;
+
+	// If the synset is a satellite, find the head word of its head synset
+	// and the head word's sense number.
+	if (isSatellite(synptr->pos)) {
+		for (int i = 0; i < synptr->ptrcount; i++) {
+			if (synptr->ptrtyp[i] == SIMPTR) {
+				SynsetPtr cursyn = read_synset(synptr->ppos[i], synptr->ptroff[i], "");
+				if (cursyn != NULL) {
+					if (cursyn->wcount > 0) {
+						synptr->headword = copyString(cursyn->words[0]);
+						synptr->headsense = static_cast<short>(cursyn->lexid[0]);
+					}
+					free_synset(cursyn);
+				}
+				break;
+			}
+		}
+	}
+
+	for (int i = 0; i < synptr->ptrcount; i++) {
+		if ((synptr->ptrtyp[i] == ptrtyp) &&
+			((synptr->pfrm[i] == 0) || (synptr->pfrm[i] == synptr->whichword)))
+		{
+			SynsetPtr cursyn = read_synset(synptr->ppos[i], synptr->ptroff[i], "");
+			if (cursyn == NULL)
+				continue;
+			cursyn->searchtype = ptrtyp;
+
+			for (int j = 0; j < cursyn->wcount; j++)
+				cursyn->wnsns[j] = getsearchsense(cursyn, j + 1);
+
+			if (lastsyn)
+				lastsyn->nextss = cursyn;
+			if (!synlist)
+				synlist = cursyn;
+			lastsyn = cursyn;
+
+			if (depth) {
+				// Cycle check: allow one more level of tracing, then quit.
+				if (depth >= MAXDEPTH)
+					depth = -1;
+				cursyn->ptrlist = traceptrs_ds(cursyn, ptrtyp, getpos(cursyn->pos), depth + 1);
+			}
+		}
+	}
+	return synlist;
+}
+
+int WordNetDatabase::getsearchsense(SynsetPtr synptr, int whichword) const {
+	std::string word = toLower(substitute(synptr->words[whichword - 1], ' ', '_'));
+	if (const IndexEntry *idx = index_lookup(word, getpos(synptr->pos))) {
+		for (size_t i = 0; i < idx->offsets.size(); i++) {
+			if (idx->offsets[i] == synptr->hereiam)
+				return static_cast<int>(i) + 1;
+		}
+	}
+	return 0;
+}
+
+const std::string *WordNetDatabase::exc_lookup(const std::string &word, int pos) const {
+	if (!isValidPos(pos))
+		return 0;
+	ExceptionMap::const_iterator it = _exceptions[pos].find(word);
+	return (it == _exceptions[pos].end()) ? 0 : &(*it).second[0];
+}
+
+bool WordNetDatabase::morphstr(const char *origstr, int pos, std::string &result) const {
+	if (pos == SATELLITE)
+		pos = ADJ;
+
+	// Assume the string hasn't had spaces substituted with '_'
+	std::string str = toLower(substitute(origstr, ' ', '_'));
+	int cnt = countWords(str, '_');
+
+	// First try the exception list
+	const std::string *exc = exc_lookup(str, pos);
+	if (exc && *exc != str) {
+		result = *exc;
+		return true;
+	}
+
+	// Then try simple morphology on the original string
+	std::string tmp;
+	if (pos != VERB && morphword(str, pos, tmp) && tmp != str) {
+		result = tmp;
+		return true;
+	}
+
+	if (pos == VERB && cnt > 1) {
+		// If the string is a verb followed by a preposition, then only
+		// the verb is inflected.
+		size_t p = 0;
+		for (int wdnum = 2; wdnum <= cnt; wdnum++) {
+			p = str.find('_', p);
+			if (p == std::string::npos)
+				break;
+			p++;
+			for (size_t i = 0; i < NUM_PREPOSITIONS; i++) {
+				size_t len = strlen(PREPOSITIONS[i]);
+				if (str.compare(p, len, PREPOSITIONS[i]) == 0 &&
+					(p + len == str.size() || str[p + len] == '_'))
+				{
+					return morphprep(str, result);
+				}
+			}
+		}
+	}
+
+	// Otherwise, morph each word of the collocation separately.
+	std::string searchstr;
+	size_t st_idx = 0;
+	cnt = countWords(str, '-');
+	while (--cnt) {
+		size_t end_idx = str.find_first_of("_-", st_idx);
+		if (end_idx == std::string::npos)
+			return false;
+		std::string word = str.substr(st_idx, end_idx - st_idx);
+		searchstr += morphword(word, pos, tmp) ? tmp : word;
+		searchstr += str[end_idx];
+		st_idx = end_idx + 1;
+	}
+	std::string word = str.substr(std::min(st_idx, str.size()));
+	searchstr += morphword(word, pos, tmp) ? tmp : word;
+	if (searchstr != str && is_defined(searchstr.c_str(), pos)) {
+		result = searchstr;
+		return true;
+	}
+	return false;
+}
+
+// Try to find the base form (lemma) of an individual word.
+bool WordNetDatabase::morphword(const std::string &word, int pos, std::string &result) const {
+	// First look for the word on the exception list
+	if (const std::string *exc = exc_lookup(word, pos)) {
+		result = *exc;
+		return true;
+	}
+
+	// Only use the exception list for adverbs
+	if (pos == ADV || !isValidPos(pos))
+		return false;
+
+	std::string base = word;
+	const char *end = "";
+	if (pos == NOUN) {
+		if (strend(word, "ful")) {
+			base = word.substr(0, word.rfind('f'));
+			end = "ful";
+		} else if (strend(word, "ss") || word.size() <= 2) {
+			// check for nouns ending with 'ss' or short words
+			return false;
+		}
+	}
+
+	// If the word isn't in the exception list, try applying the rules
+	for (int i = 0; i < SUFFIX_COUNTS[pos]; i++) {
+		std::string retval = wordbase(base, i + SUFFIX_OFFSETS[pos]);
+		if (retval != base && is_defined(retval.c_str(), pos)) {
+			result = retval + end;
+			return true;
+		}
+	}
+	return false;
+}
+
+// Assume that the verb is the first word in the phrase.  Strip it off,
+// check for validity, then try various morphs with the rest of the phrase
+// tacked on, trying to find a match.
+bool WordNetDatabase::morphprep(const std::string &s, std::string &result) const {
+	size_t rest = s.find('_');
+	size_t last = s.rfind('_');
+	std::string end;
+	bool has_lastwd = false;
+	if (rest != last) { // more than 2 words
+		std::string lastwd;
+		if (morphword(s.substr(last + 1), NOUN, lastwd)) {
+			end = s.substr(rest, last - rest + 1) + lastwd;
+			has_lastwd = true;
+		}
+	}
+
+	std::string word = s.substr(0, rest);
+	for (size_t i = 0; i < word.size(); i++) {
+		if (!isalnum(static_cast<unsigned char>(word[i])))
+			return false;
+	}
+	std::string restStr = s.substr(rest);
+
+	// First try to find the verb in the exception list, then try the rules
+	std::vector<std::string> bases;
+	if (const std::string *exc = exc_lookup(word, VERB))
+		bases.push_back(*exc);
+	for (int i = 0; i < SUFFIX_COUNTS[VERB]; i++)
+		bases.push_back(wordbase(word, i + SUFFIX_OFFSETS[VERB]));
+	for (size_t i = 0; i < bases.size(); i++) {
+		if (bases[i] == word)
+			continue;
+		result = bases[i] + restStr;
+		if (is_defined(result.c_str(), VERB))
+			return true;
+		if (has_lastwd) {
+			result = bases[i] + end;
+			if (is_defined(result.c_str(), VERB))
+				return true;
+		}
+	}
+
+	if (has_lastwd && word + end != s) {
+		result = word + end;
+		return true;
+	}
+	return false;
+}
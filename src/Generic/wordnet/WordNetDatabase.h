@@ -0,0 +1,105 @@
+// Copyright (c) 2012 by Raytheon BBN Technologies Corp.
+// All Rights Reserved.
+
+#ifndef WORDNET_DATABASE_H
+#define WORDNET_DATABASE_H
+
+#include "Generic/wordnet/xx_wordnet_externc.h"
+#include <boost/unordered_map.hpp>
+#include <string>
+#include <vector>
+
+/** An in-memory copy of the WordNet database (the index, data, and
+  * morphological exception files for each part of speech), which can be
+  * used in place of the WordNet C library's file-based lookups.
+  *
+  * The database is read once, when it is constructed, and is never
+  * modified afterwards.  Unlike the C library (which does a binary search
+  * through the files on disk for every lookup, and keeps its results in
+  * static buffers), all of its methods are therefore safe to call from
+  * multiple threads at once.
+  *
+  * The lookup methods are modeled on the C library functions with the
+  * same names, and give the same results, except that synset glosses are
+  * not loaded (so Synset::defn is always NULL).  SynsetPtrs returned by
+  * findtheinfo_ds() are allocated in the same way as the C library's, and
+  * should be freed with free_syns(). */
+class WordNetDatabase {
+public:
+	/** Load the database files from the given directory.  Throws an
+	  * UnexpectedInputException if any of the files can't be read. */
+	WordNetDatabase(const char *searchdir);
+
+	/** Equivalent to findtheinfo_ds(): return the senses of searchstr
+	  * (or of one of its alternate spellings), and the synsets reachable
+	  * from them by following pointers of type ptrtyp (recursively, if
+	  * ptrtyp is negative). */
+	SynsetPtr findtheinfo_ds(const char *searchstr, int dbase, int ptrtyp, int whichsense) const;
+
+	/** Equivalent to the first call to morphstr(): set result to the base
+	  * form of the given word or collocation and return true; or return
+	  * false if it has no base form other than itself. */
+	bool morphstr(const char *origstr, int pos, std::string &result) const;
+
+	/** Equivalent to get_sense_count(). */
+	int get_sense_count(const char *searchstr, int dbase) const;
+
+	/** Equivalent to is_defined() != 0. */
+	bool is_defined(const char *searchstr, int dbase) const;
+
+	size_t getNSynsets() const;
+
+private:
+	struct Pointer {
+		int ptrtyp;
+		long ptroff;
+		int ppos;
+		int pfrm;
+		int pto;
+	};
+
+	struct SynsetEntry {
+		int fnum;
+		std::string pos;
+		std::vector<std::string> words;
+		std::vector<int> lexids;
+		std::vector<Pointer> pointers;
+		std::vector<std::pair<int, int> > frames; // (frame id, frame 'to' field)
+	};
+
+	struct IndexEntry {
+		std::string wd;
+		std::string pos;
+		int sense_cnt;
+		int tagged_cnt;
+		std::vector<int> ptruse;
+		std::vector<long> offsets;
+	};
+
+	typedef boost::unordered_map<std::string, IndexEntry> IndexMap;
+	typedef boost::unordered_map<long, SynsetEntry> SynsetMap;
+	typedef boost::unordered_map<std::string, std::vector<std::string> > ExceptionMap;
+
+	// Indexed by part of speech (NOUN, VERB, ADJ or ADV).
+	IndexMap _index[NUMPARTS + 1];
+	SynsetMap _synsets[NUMPARTS + 1];
+	ExceptionMap _exceptions[NUMPARTS + 1];
+
+	void loadIndexFile(const std::string &filename, int dbase);
+	void loadDataFile(const std::string &filename, int dbase);
+	void loadExceptionFile(const std::string &filename, int dbase);
+	static void readLines(const std::string &filename, std::vector<std::string> &lines, std::vector<long> *offsets=0);
+
+	const IndexEntry *index_lookup(const std::string &word, int dbase) const;
+	void getindex(const char *searchstr, int dbase, std::vector<const IndexEntry*> &entries) const;
+	SynsetPtr read_synset(int dbase, long boffset, const char *word) const;
+	SynsetPtr traceptrs_ds(SynsetPtr synptr, int ptrtyp, int dbase, int depth) const;
+	int getsearchsense(SynsetPtr synptr, int whichword) const;
+
+	// Morphology (see morph.c)
+	const std::string *exc_lookup(const std::string &word, int pos) const;
+	bool morphword(const std::string &word, int pos, std::string &result) const;
+	bool morphprep(const std::string &s, std::string &result) const;
+};
+
+#endif
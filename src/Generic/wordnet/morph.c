@@ -12,16 +12,6 @@
 #include "linuxPort/serif_port.h"
 #include "Generic/wordnet/wn.h"
 
-#ifdef UNIX
-#define EXCFILE	"%s/%s.exc"
-#endif
-#ifdef PC
-#define EXCFILE	"%s\\%s.exc"
-#endif
-#ifdef MAC
-#define EXCFILE	"%s:%s.exc"
-#endif
-
 static char *Id = "$Id: morph.c,v 1.54 1997/09/02 16:31:18 wn Exp $";
 
 static char *sufx[] ={ 
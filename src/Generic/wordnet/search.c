@@ -21,13 +21,6 @@
 
 static char *Id = "$Id: search.c,v 1.134 1997/11/07 16:27:36 wn Exp $";
 
-/* For adjectives, indicates synset type */
-
-#define DONT_KNOW	0
-#define DIRECT_ANT	1	/* direct antonyms (cluster head) */
-#define INDIRECT_ANT	2	/* indrect antonyms (similar) */
-#define PERTAINYM	3	/* no antonyms or similars (pertainyms) */
-
 #define ALLWORDS	0	/* print all words */
 #define SKIP_ANTS	0	/* skip printing antonyms in printsynset() */
 #define PRINT_ANTS	1	/* print antonyms in printsynset() */
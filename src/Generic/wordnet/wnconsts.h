@@ -20,6 +20,7 @@
 #define DEFAULTBIN      "/usr/local/wordnet1.6/bin"
 #define DATAFILE	"%s/%s.dat"
 #define INDEXFILE	"%s/%s.index"
+#define EXCFILE		"%s/%s.exc"
 #define SENSEIDXFILE	"%s/sense.idx"
 #define COUSINFILE	"%s/cousin.tps"
 #define COUSINEXCFILE	"%s/cousin.exc"
@@ -32,6 +33,7 @@
 #define DEFAULTBIN      "c:\\wn16\\bin"
 #define DATAFILE	"%s\\%s.dat"
 #define INDEXFILE	"%s\\%s.idx"
+#define EXCFILE		"%s\\%s.exc"
 #define SENSEIDXFILE	"%s\\sense.idx"
 #define COUSINFILE	"%s\\cousin.tps"
 #define COUSINEXCFILE	"%s\\cousin.exc"
@@ -44,6 +46,7 @@
 #define DEFAULTBIN      ":"
 #define DATAFILE	"%s:data.%s"
 #define INDEXFILE	"%s:index.%s"
+#define EXCFILE		"%s:%s.exc"
 #define SENSEIDXFILE	"%s:index.sense"
 #define COUSINFILE	"%s:cousin.tops"
 #define COUSINEXCFILE	"%s:cousin.exc"
@@ -51,6 +54,13 @@
 #define VRBIDXFILE 	"%s:sentidx.vrb"
 #endif
 
+/* For adjectives, indicates synset type */
+
+#define DONT_KNOW	0
+#define DIRECT_ANT	1	/* direct antonyms (cluster head) */
+#define INDIRECT_ANT	2	/* indrect antonyms (similar) */
+#define PERTAINYM	3	/* no antonyms or similars (pertainyms) */
+
 /* Various buffer sizes */
 
 /* Search output buffer */
@@ -7,8 +7,10 @@
 #include <string>
 #include <fstream>
 #include <vector>
+#include <algorithm>
 
 #include "Generic/wordnet/xx_WordNet.h"
+#include "Generic/wordnet/WordNetDatabase.h"
 #include "Generic/common/ParamReader.h"
 #include "Generic/parse/xx_STags.h"
 #include <boost/foreach.hpp>
@@ -90,6 +92,7 @@ void WordNet::init() {
 	_nlookup = 0;
 	_nfirst = 0;
 	_nmult = 0;
+	_database = 0;
 	
 	std::string data_path = ParamReader::getRequiredParam("word_net_dictionary_path");
 	if(wninit(data_path.c_str()) != 0){
@@ -131,6 +134,11 @@ void WordNet::init() {
 		throw UnexpectedInputException("WordNet::WordNet()",
 			"Error in WordNet initialization: morphinit");
 	}
+	if (ParamReader::isParamTrue("preload_wordnet")) {
+		_database = _new WordNetDatabase(data_path.c_str());
+		SessionLogger::info("preload_wordnet") << "Loaded " << _database->getNSynsets()
+			<< " WordNet synsets from " << data_path << std::endl;
+	}
 	personWords_firstSense = _new SymbolBoolHash();
 	personWords_allSenses = _new SymbolBoolHash();
 	locationWords = _new SymbolBoolHash();
@@ -239,6 +247,7 @@ WordNet::~WordNet() {
 	delete nthVerbHypernymClassHash;
 	delete nthOtherHypernymClassHash;
 	delete wordnetWords;
+	delete _database;
 
 	// for debug purpose
 	/*cerr << "keeping track of hyponym Hashtables !!\n";
@@ -279,6 +288,9 @@ WordNet::~WordNet() {
 
 Symbol WordNet::stem_noun(Symbol word) const
 {
+	if (_database)
+		return stem(word, getpos("n"));
+
 #ifdef DO_WORDNET_PROFILING
 	hashCheckinginNounStemTimer.startTimer();
 	hashCheckinginNounStemTimer.increaseCount();
@@ -322,6 +334,9 @@ Symbol WordNet::stem_noun(Symbol word) const
 
 Symbol WordNet::stem_verb(Symbol word) const
 {
+	if (_database)
+		return stem(word, getpos("v"));
+
 	SymbolSymbolHash::iterator iter;
 	iter = verbStems->find(word);
 	if (iter != verbStems->end()){
@@ -390,17 +405,18 @@ Symbol WordNet::stem(Symbol word, int POS) const
 	morphTimer.startTimer();
 #endif
 
-	char *morph = morphstr(cstr, POS);
+	std::string morph;
+	bool found_stem = wn_morphstr(cstr, POS, morph);
 
 #ifdef DO_WORDNET_PROFILING
 	morphTimer.stopTimer();
 #endif
 
-	if (morph == 0)
+	if (!found_stem)
 		return word;
 
 	wchar_t wbuffer[WORDBUF];
-	length = strlen(morph);
+	length = std::min(morph.size(), static_cast<size_t>(WORDBUF - 1));
 	for (size_t j = 0; j < length; j++) {
 		wbuffer[j] = wchar_t(morph[j]);
 	}
@@ -414,6 +430,8 @@ Symbol WordNet::stem(Symbol word, int POS) const
 }
 
 bool WordNet::isPerson(Symbol word, bool use_all_senses) {
+	if (_database)
+		return isHyponymOf(word, "person", use_all_senses);
 	
 	SymbolBoolHash::iterator iter;
 	
@@ -442,6 +460,8 @@ bool WordNet::isPerson(Symbol word, bool use_all_senses) {
 }
 
 bool WordNet::isLocation(Symbol word) {
+	if (_database)
+		return !isHyponymOf(word, "end") && isHyponymOf(word, "region");
 	
 	SymbolBoolHash::iterator iter;
 	
@@ -481,6 +501,11 @@ bool WordNet::isPartitive(ChartEntry *entry)
 		(entry->bridgeType == BRIDGE_TYPE_EXTENSION &&
 		entry->extensionOp->branchingDirection == BRANCH_DIRECTION_RIGHT)) {
 
+		if (_database) {
+			return partitiveWordList().count(entry->headWord) > 0 ||
+				isHyponymOf(entry->headWord, "digit") || isHyponymOf(entry->headWord, "large integer");
+		}
+
 		SymbolBoolHash::iterator iter;
 		
 		iter = partitiveWords->find(entry->headWord);
@@ -634,6 +659,13 @@ int WordNet::getNthHypernymClass(Symbol word, Symbol POS, int n) {
 		return 0;
 	}
 
+	if (_database) {
+#ifdef DO_WORDNET_PROFILING
+		getNthHypernymTimer.stopTimer();
+#endif	 	
+		return lookupNthHypernymClass(word, pos_int, n);
+	}
+
 	std::pair< Symbol, int > entry( stem, n );
 	//if((_nlookup % 100) == 0){
 	//	std::cout <<"lookups: "<<_nlookup<<" new: "<<_nfirst<<" repeat: "<<_nmult<<" ";
@@ -656,14 +688,18 @@ int WordNet::getNthHypernymClass(Symbol word, Symbol POS, int n) {
 	}
 	_nfirst++;
 
-	SynsetPtr syn = getFirstSynSet(word,pos_int);	
-	if (syn == 0) {
-		(*hashedHyps)[entry] = 0; 
+	int offset = lookupNthHypernymClass(word, pos_int, n);
+	(*hashedHyps)[entry] = offset; 
 #ifdef DO_WORDNET_PROFILING
-		getNthHypernymTimer.stopTimer();
+	getNthHypernymTimer.stopTimer();
 #endif	 	
+	return offset;
+}
+
+int WordNet::lookupNthHypernymClass(Symbol word, int pos, int n) {
+	SynsetPtr syn = getFirstSynSet(word,pos);	
+	if (syn == 0)
 		return 0;
-	}
 
 	int level = 0;
 	SynsetPtr hyper = syn;
@@ -674,10 +710,6 @@ int WordNet::getNthHypernymClass(Symbol word, Symbol POS, int n) {
 
 	if (level < n || hyper == 0) {
 		free_syns(syn);
-		(*hashedHyps)[entry] = 0; 
-#ifdef DO_WORDNET_PROFILING
-		getNthHypernymTimer.stopTimer();
-#endif	 	
 		return 0;
 	}
 
@@ -686,19 +718,11 @@ int WordNet::getNthHypernymClass(Symbol word, Symbol POS, int n) {
 		// words (among them "find" and "exceed"). Rather than try to track it down
 		// in the archaic WordNet code, we'll just return 0 if this occurs.
 		free_syns(syn);
-		(*hashedHyps)[entry] = 0; 
-#ifdef DO_WORDNET_PROFILING
-		getNthHypernymTimer.stopTimer();
-#endif	 	
 		return 0;
 	}
 	
 	int offset = hyper->ptroff[0];
 	free_syns(syn);
-	(*hashedHyps)[entry] = offset; 
-#ifdef DO_WORDNET_PROFILING
-	getNthHypernymTimer.stopTimer();
-#endif	 	
 	return offset;
 }
 
@@ -757,6 +781,13 @@ int WordNet::getHypernyms(Symbol word, Symbol *results, int MAX_RESULTS) {
 	SymbolToSymbolArrayIntHash *hypernymClassHash = hypernymClassHash_firstSense;
 
 	if (MAX_RESULTS > Max_Hypernym_Cached) MAX_RESULTS = Max_Hypernym_Cached;
+	if (_database) {
+#ifdef DO_WORDNET_PROFILING
+		getHypernymTimer.stopTimer();
+#endif
+		return lookupHypernyms(word, results, MAX_RESULTS);
+	}
+
 	int n = 0;
 	Symbol stem = stem_noun(word);
 	SymbolToSymbolArrayIntHash::iterator iter;
@@ -775,56 +806,41 @@ int WordNet::getHypernyms(Symbol word, Symbol *results, int MAX_RESULTS) {
 
 		return n;
 	} else {
-		SynsetPtr syn = getFirstSynSet(word, getpos("n"));
-		if (syn == 0){
-			(* hypernymClassHash)[stem].num=0;
+		// this is a potential bug !!!
+		// correct one should read Max_Hypernym_Cached hypernyms and return an array with length of MAX_RESULTS  
+		n = lookupHypernyms(word, results, MAX_RESULTS);
+		SymbolArrayInt &entry = (* hypernymClassHash)[stem];
+		for (int i = 0; i < n; i++)
+			entry.words[i] = results[i];
+		entry.num = n;
 	
 #ifdef DO_WORDNET_PROFILING
-			getHypernymTimer.stopTimer();
+		getHypernymTimer.stopTimer();
 #endif
 
-			return 0;
-		}
-		
-		SynsetPtr hyper = syn;
-		int n = 0; 
-		//loop through hyper/syn, store symbols in hyper->words[i] in results
-		while (hyper != 0) {
-			for (int i = 0; i < hyper->wcount; i++) {
-				// this is a potential bug !!!
-				// correct one should read Max_Hypernym_Cached hypernyms and return an array with length of MAX_RESULTS  
-				
-				if (n < MAX_RESULTS) {
-					char *cstr = hyper->words[i];
-					wchar_t wcstr[1000];
-					copychar_towchar(cstr, wcstr, 1000);
-					results[n] = Symbol(wcstr);
-					(* hypernymClassHash)[stem].words[n]=Symbol(wcstr); 
-					n++;
-				}else{
-					(* hypernymClassHash)[stem].num=n; 
-					free_syns(syn);
-				
-#ifdef DO_WORDNET_PROFILING
-					getHypernymTimer.stopTimer();
-#endif
+		return n;
+	}
+}
 
-					return n;
-				}
-			}
+int WordNet::lookupHypernyms(Symbol word, Symbol *results, int MAX_RESULTS) {
+	SynsetPtr syn = getFirstSynSet(word, getpos("n"));
+	if (syn == 0)
+		return 0;
 		
-			//fill HypernymHash with all results
-			hyper = hyper->ptrlist;
+	SynsetPtr hyper = syn;
+	int n = 0; 
+	//loop through hyper/syn, store symbols in hyper->words[i] in results
+	while (hyper != 0 && n < MAX_RESULTS) {
+		for (int i = 0; i < hyper->wcount && n < MAX_RESULTS; i++) {
+			char *cstr = hyper->words[i];
+			wchar_t wcstr[1000];
+			copychar_towchar(cstr, wcstr, 1000);
+			results[n++] = Symbol(wcstr);
 		}
-		(* hypernymClassHash)[stem].num=n; 
-		free_syns(syn);
-	
-#ifdef DO_WORDNET_PROFILING
-		getHypernymTimer.stopTimer();
-#endif
-
-		return n;
+		hyper = hyper->ptrlist;
 	}
+	free_syns(syn);
+	return n;
 }
 
 // the implementation of this function is for simulating the original function
@@ -860,6 +876,9 @@ int WordNet::getHypernymOffsets(Symbol word, Symbol POS, int *results, int MAX_R
 		return 0;
 	}
 
+	if (_database)
+		return lookupHypernymOffsets(word, pos_int, results, MAX_RESULTS);
+
 	int n = 0;
 	SymbolToIntArrayIntHash::iterator iter;
 	iter = hashedHyps->find(stem);
@@ -873,35 +892,45 @@ int WordNet::getHypernymOffsets(Symbol word, Symbol POS, int *results, int MAX_R
 		}
 		return n;
 	} else {
-		SynsetPtr syn = getFirstSynSet(word, pos_int);
-		if (syn == 0){
-			(* hashedHyps)[stem].num=0;
-			return 0;
-		}
-	
-		int numOfCached = 0;
-		SynsetPtr hyper = syn;
-		while (numOfCached < Max_Hypernym_perPOS_Cached && hyper != 0) {
-			if (hyper->ptroff != 0) {
-				int offset = hyper->ptroff[0];
-				(*hashedHyps)[stem].offsets[numOfCached]=offset; 
-				if (n < MAX_RESULTS){
-					results[n++]=offset;
-				}
-			} else {
-				(* hashedHyps)[stem].num=numOfCached; 
-				free_syns(syn);
-				return n;
-			}
-			hyper = hyper->ptrlist;
-			numOfCached++;
-		}
-		(* hashedHyps)[stem].num=numOfCached; 
-		free_syns(syn);
+		IntArrayInt &entry = (* hashedHyps)[stem];
+		entry.num = lookupHypernymOffsets(word, pos_int, entry.offsets, Max_Hypernym_perPOS_Cached);
+		for (int i = 0; i < entry.num && n < MAX_RESULTS; i++)
+			results[n++] = entry.offsets[i];
 		return n;
 	}
 }
 
+int WordNet::lookupHypernymOffsets(Symbol word, int pos, int *results, int MAX_RESULTS) {
+	SynsetPtr syn = getFirstSynSet(word, pos);
+	if (syn == 0)
+		return 0;
+	
+	int n = 0;
+	SynsetPtr hyper = syn;
+	while (n < MAX_RESULTS && hyper != 0 && hyper->ptroff != 0) {
+		results[n++] = hyper->ptroff[0];
+		hyper = hyper->ptrlist;
+	}
+	free_syns(syn);
+	return n;
+}
+
+bool WordNet::wn_morphstr(const char *str, int pos, std::string &result) const {
+	if (_database)
+		return _database->morphstr(str, pos, result);
+	char *morph = morphstr(const_cast<char*>(str), pos);
+	if (morph == 0)
+		return false;
+	result = morph;
+	return true;
+}
+
+SynsetPtr WordNet::wn_findtheinfo_ds(char *searchstr, int pos, int ptrtyp, int whichsense) const {
+	if (_database)
+		return _database->findtheinfo_ds(searchstr, pos, ptrtyp, whichsense);
+	return findtheinfo_ds(searchstr, pos, ptrtyp, whichsense);
+}
+
 SynsetPtr WordNet::getSynSet(Symbol word, int POS, int whichsense) {
 #ifdef DO_WORDNET_PROFILING
 	getSynsetTimer.startTimer();
@@ -909,16 +938,13 @@ SynsetPtr WordNet::getSynSet(Symbol word, int POS, int whichsense) {
 #endif
 
 	Symbol stem = Symbol();
-	char *morph1;
 	char cstr[WORDBUF];
 	if (POS == getpos("n")) {
 		stem = stem_noun(word);
 		copywchar_tochar(stem.to_string(), cstr, WORDBUF);
-		morph1 = cstr;
 	} else if (POS == getpos("v")) {
 		stem = stem_verb(word);
 		copywchar_tochar(stem.to_string(), cstr, WORDBUF);
-		morph1 = cstr;
 	} else {
 		copywchar_tochar(word.to_string(), cstr, WORDBUF);
 
@@ -926,17 +952,17 @@ SynsetPtr WordNet::getSynSet(Symbol word, int POS, int whichsense) {
 		morphTimer.startTimer();
 #endif
 
-		morph1 = morphstr(cstr, POS);
+		std::string morph;
+		if (wn_morphstr(cstr, POS, morph)) {
+			strncpy(cstr, morph.c_str(), WORDBUF - 1);
+			cstr[WORDBUF - 1] = '\0';
+		}
 
 #ifdef DO_WORDNET_PROFILING
 		morphTimer.stopTimer();
 #endif
-
-		if (morph1 == 0)
-			morph1 = cstr;
 	}
-	int level = 0;
-	SynsetPtr syn = findtheinfo_ds(morph1,POS,-1 * getptrtype("@"),whichsense);
+	SynsetPtr syn = wn_findtheinfo_ds(cstr,POS,-1 * getptrtype("@"),whichsense);
 
 #ifdef DO_WORDNET_PROFILING
 	getSynsetTimer.stopTimer();
@@ -1002,6 +1028,9 @@ bool WordNet::isHyponymOf(Symbol word, const char* proposed_hypernym, bool use_a
 		large integer
 	*/
 
+	if (_database)
+		return lookupHyponymOf(word, proposed_hypernym, use_all_senses);
+
 	SymbolSymbolToBoolHash * hyponymClassHash = hyponymClassHash_firstSense;
 	SymbolToSymbolArrayIntHash * hypernymClassHash = hypernymClassHash_firstSense;
 	if (use_all_senses) {
@@ -1042,15 +1071,19 @@ bool WordNet::isHyponymOf(Symbol word, const char* proposed_hypernym, bool use_a
 		}
 	}
 	
+	bool result = lookupHyponymOf(word, proposed_hypernym, use_all_senses);
+	(* hyponymClassHash)[entry]=result;
+	return result;
+}
+
+bool WordNet::lookupHyponymOf(Symbol word, const char* proposed_hypernym, bool use_all_senses) {
 	SynsetPtr syn = 0;
 	if (use_all_senses)
 		syn = getAllSynSets(word,getpos("n"));
 	else syn = getFirstSynSet(word, getpos("n"));
 	SynsetPtr hyper;
-	if (syn == 0) {
-		(* hyponymClassHash)[entry]=false;
+	if (syn == 0)
 		return false;
-	}
 	
 	SynsetPtr syn_iter = syn;
 	while (syn_iter != 0) {
@@ -1058,7 +1091,6 @@ bool WordNet::isHyponymOf(Symbol word, const char* proposed_hypernym, bool use_a
 		// check this synset's base word list
 		if (matches_wordlist_base(syn_iter, proposed_hypernym)) {
 			free_syns(syn);
-			(* hyponymClassHash)[entry]=true;
 			return true;
 		}
 
@@ -1068,7 +1100,6 @@ bool WordNet::isHyponymOf(Symbol word, const char* proposed_hypernym, bool use_a
 			int retval = matches_wordlist(hyper, proposed_hypernym, 100);
 			if (retval >= 0) {
 				free_syns(syn);
-				(* hyponymClassHash)[entry]=true;
 				return true;
 			}
 			hyper = hyper->nextss;
@@ -1079,9 +1110,7 @@ bool WordNet::isHyponymOf(Symbol word, const char* proposed_hypernym, bool use_a
 	}
 	
 	free_syns(syn);
-	(* hyponymClassHash)[entry]=false;
 	return false;
-	
 }
 
 Symbol WordNet::lowercase_symbol(Symbol s) const
@@ -1157,6 +1186,8 @@ void WordNet::copychar_towchar(const char* cstr, wchar_t* wcstr, int max_len){
 int WordNet::getSenseCount(Symbol word, int pos) {
 	char cstr[WORDBUF];
 	copywchar_tochar(word.to_string(), cstr, WORDBUF);
+	if (_database)
+		return _database->get_sense_count(cstr, pos);
 	return get_sense_count(cstr, pos);
 }
 
@@ -1179,9 +1210,13 @@ int WordNet::getSynonyms(const Symbol& word, WordNet::CollectedSynonyms& results
 	Symbol stem = WordNet::stem(word, pos);	
 	
 	synset_cache_key_type cache_key( stem, pos, ptrType );
-	// first check the cache
-	synset_cache_type::iterator cit = synset_cache.find( cache_key );
-	if( cit != synset_cache.end() ){
+	// first check the cache (which isn't used with the preloaded database)
+	synset_cache_type::iterator cit = synset_cache.end();
+	if (_database) {
+		char cstr[WORDBUF];
+		copywchar_tochar(stem.to_string(), cstr, WORDBUF);
+		syn = _database->findtheinfo_ds(cstr, pos, ptrType, sense);
+	} else if( (cit = synset_cache.find( cache_key )) != synset_cache.end() ){
 		
 		pair< synset_cache_key_type, SynsetPtr > entry = (*(*cit).second);
 		
@@ -1222,6 +1257,9 @@ int WordNet::getSynonyms(const Symbol& word, WordNet::CollectedSynonyms& results
 		n += collectNextLevel(synnext, level, results);
 		synnext = synnext->nextss;
 	} while ( synnext != 0 );
+
+	if (_database)
+		free_syns(syn);
 	
 	return n;
 }
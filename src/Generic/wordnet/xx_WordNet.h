@@ -27,6 +27,9 @@
 // this line is added for debug purpose
 //#include "Generic/common/UTF8OutputStream.h"
 #include <list>
+#include <string>
+
+class WordNetDatabase;
 
 struct synset_cache_key_type {
 	Symbol word; int pos; int wnptr;
@@ -65,6 +68,9 @@ public:
 	static WordNet* getInstance();
 	static void deleteInstance();
 	void cleanup();
+	// Return true if the in-memory WordNet database was loaded (see
+	// _database below).
+	bool isPreloaded() const { return _database != 0; }
 protected:
 	WordNet();
 	~WordNet();
@@ -75,6 +81,24 @@ private:
 	char* dictionary_path;
 	char* bin_path;
 
+	// An in-memory copy of the WordNet database, which is loaded if the
+	// parameter "preload_wordnet" is true.  When it is used, lookups do not
+	// go through the WordNet library (which keeps its state in static
+	// buffers), and none of the caches below are used, so the WordNet
+	// methods may be called from multiple threads at once.
+	WordNetDatabase *_database;
+
+	// Wrappers for the WordNet library functions, which use the in-memory
+	// database if it is loaded.
+	bool wn_morphstr(const char *str, int pos, std::string &result) const;
+	SynsetPtr wn_findtheinfo_ds(char *searchstr, int pos, int ptrtyp, int whichsense) const;
+
+	// Uncached versions of the lookups of the same names.
+	int lookupNthHypernymClass(Symbol word, int pos, int n);
+	int lookupHypernyms(Symbol word, Symbol *results, int MAX_RESULTS);
+	int lookupHypernymOffsets(Symbol word, int pos, int *results, int MAX_RESULTS);
+	bool lookupHyponymOf(Symbol word, const char* proposed_hypernym, bool use_all_senses);
+
 	int _nlookup;
 	int _nfirst;
 	int _nmult;
@@ -0,0 +1,62 @@
+#include "Generic/common/leak_detection.h"
+#include "MaxEntLBFGSOptimizer.h"
+#include "LBFGS.h"
+
+#include <vector>
+#include <boost/make_shared.hpp>
+#include "Generic/common/SessionLogger.h"
+
+namespace {
+	// Adapts a MaxEntGradientOptimizer::Objective to the LBFGS-B interface.
+	class ObjectiveFunction : public LBFGS::LBFGSOptimizableFunction {
+	public:
+		ObjectiveFunction(MaxEntGradientOptimizer::Objective &objective, const std::vector<double> &params)
+			: _objective(objective), _params(params), _initialParams(params), 
+			_gradient(params.size(), 0.0), _value(0), _n_evaluations(0), _n_iterations(0)
+		{ }
+
+		double recompute() {
+			++_n_evaluations;
+			_value = _objective.evaluate(_params, _gradient);
+			return _value;
+		}
+
+		void reset() { _params = _initialParams; }
+		size_t nParams() const { return _params.size(); }
+		std::vector<double>& gradient() { return _gradient; }
+		std::vector<double>& params() { return _params; }
+		void dumpGradientAndParameters() const {}
+		void dumpParameters() const {}
+
+		void postIteration(unsigned int iteration) const {
+			_n_iterations = iteration;
+			SessionLogger::dbg("maxent_lbfgs") << "Iteration " << iteration << ": objective = " 
+				<< _value << " (" << _n_evaluations << " evaluations)";
+		}
+
+		double getValue() const { return _value; }
+		int getNIterations() const { return _n_iterations; }
+		int getNEvaluations() const { return _n_evaluations; }
+
+	private:
+		MaxEntGradientOptimizer::Objective &_objective;
+		std::vector<double> _params;
+		std::vector<double> _initialParams;
+		std::vector<double> _gradient;
+		double _value;
+		int _n_evaluations;
+		mutable int _n_iterations;
+	};
+}
+
+int MaxEntLBFGSOptimizer::optimize(Objective &objective, std::vector<double> &params, int max_iterations) {
+	boost::shared_ptr<ObjectiveFunction> func = boost::make_shared<ObjectiveFunction>(boost::ref(objective), params);
+	LBFGS::BoundedLBFGSOptimizer optimizer(func, LBFGS::Unbounded(),
+		_objective_tolerance, 1.0e-5, _memory);
+	optimizer.optimize(max_iterations, false);
+	params = func->params();
+	SessionLogger::info("maxent_lbfgs") << "LBFGS finished after " << func->getNEvaluations() 
+		<< " function evaluations; objective = " << func->getValue();
+	// postIteration is not called for the final iteration
+	return func->getNIterations() + 1;
+}
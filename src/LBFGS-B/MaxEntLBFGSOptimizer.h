@@ -0,0 +1,30 @@
+#ifndef _MAXENT_LBFGS_OPTIMIZER_H_
+#define _MAXENT_LBFGS_OPTIMIZER_H_
+
+#include <vector>
+#include "Generic/maxent/MaxEntModel.h"
+
+/** Optimizer for MaxEntModel's LBFGS training mode, using the (unbounded)
+  * LBFGS-B optimizer.  Programs that support LBFGS training install it
+  * with:
+  *
+  *   MaxEntModel::setGradientOptimizer(
+  *       boost::shared_ptr<MaxEntGradientOptimizer>(_new MaxEntLBFGSOptimizer()));
+  *
+  * and link against LBFGS-B and LBFGS_LIBRARY. */
+class MaxEntLBFGSOptimizer : public MaxEntGradientOptimizer {
+public:
+	/** objective_tolerance is LBFGS-B's factr (see BoundedLBFGSOptimizer);
+	  * memory is the number of corrections used to approximate the
+	  * Hessian. */
+	MaxEntLBFGSOptimizer(double objective_tolerance = 1e+7, int memory = 5)
+		: _objective_tolerance(objective_tolerance), _memory(memory) {}
+
+	int optimize(Objective &objective, std::vector<double> &params, int max_iterations);
+
+private:
+	double _objective_tolerance;
+	int _memory;
+};
+
+#endif
@@ -8,6 +8,7 @@
 #include "Generic/common/HeapChecker.h"
 #include "Generic/common/FileSessionLogger.h"
 #include "Generic/relations/MaxEntRelationTrainer.h"
+#include "LBFGS-B/MaxEntLBFGSOptimizer.h"
 
 #include <time.h>
 
@@ -22,6 +23,7 @@ int main(int argc, char **argv) {
 
 	try {
 		ParamReader::readParamFile(argv[1]);
+		MaxEntModel::setGradientOptimizer(boost::shared_ptr<MaxEntGradientOptimizer>(_new MaxEntLBFGSOptimizer()));
 
 		std::string log_file = ParamReader::getRequiredParam("maxent_trainer_log_file");
 		std::wstring log_file_as_wstring(log_file.begin(), log_file.end());
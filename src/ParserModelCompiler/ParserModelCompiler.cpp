@@ -0,0 +1,87 @@
+// Copyright (c) 2012 by Raytheon BBN Technologies Corp.
+// All Rights Reserved.
+
+// ParserModelCompiler.cpp : Compiles parser models into binary model
+// images, which the parser can memory-map (see use_parser_model_image)
+// instead of reading the text model files.  Also compiles the parser's
+// cache pre-load files into a shared cache image (see probs_cache_image).
+
+#include "Generic/common/leak_detection.h"
+
+#include <stdio.h>
+#include <iostream>
+#include <string>
+
+#include "Generic/common/UnrecoverableException.h"
+#include "Generic/common/ParamReader.h"
+#include "Generic/common/GenericTimer.h"
+#include "Generic/parse/ChartDecoder.h"
+#include "Generic/parse/DefaultParser.h"
+
+using namespace std;
+
+namespace {
+	void compileModel(const std::string& model_prefix, const std::string& image_file) {
+		GenericTimer timer;
+		timer.startTimer();
+		cout << "Compiling " << model_prefix << " to " << image_file << "..." << endl;
+		ChartDecoder::compileModelImage(model_prefix.c_str(), image_file.c_str());
+		timer.stopTimer();
+		cout << "  done (" << timer.getTime() / 1000.0 << " seconds)" << endl;
+	}
+
+	void compileCacheImage(const std::string& image_file) {
+		GenericTimer timer;
+		timer.startTimer();
+		cout << "Compiling parser caches from " << ParamReader::getRequiredParam("probs_cache_in_path")
+			<< " to " << image_file << "..." << endl;
+		// Otherwise, the parser would try to map the image we're writing.
+		ParamReader::setParam("probs_cache_image", "");
+		DefaultParser parser;
+		parser.writeCacheImage(image_file.c_str());
+		timer.stopTimer();
+		cout << "  done (" << timer.getTime() / 1000.0 << " seconds)" << endl;
+	}
+}
+
+int main(int argc, char **argv) {
+	if (argc != 2 && argc != 3 && argc != 4) {
+		cerr << "ParserModelCompiler should be invoked as:\n"
+			<< "    ParserModelCompiler param_file [model_prefix [image_file]]\n"
+			<< "or:\n"
+			<< "    ParserModelCompiler param_file --cache-image [image_file]\n"
+			<< "If no model prefix is given, then each of the parser_model,\n"
+			<< "lowercase_parser_model, and uppercase_parser_model parameters that\n"
+			<< "is defined in the parameter file is compiled.  The image file\n"
+			<< "defaults to <model_prefix>.image, which is where the parser looks\n"
+			<< "for it when use_parser_model_image is true.\n"
+			<< "With --cache-image, the parser's cache pre-load files (see\n"
+			<< "probs_cache_in_path) are compiled into a cache image, which\n"
+			<< "defaults to the probs_cache_image parameter.\n";
+		return -1;
+	}
+
+	try {
+		ParamReader::readParamFile(argv[1]);
+
+		if (argc >= 3 && std::string(argv[2]) == "--cache-image") {
+			compileCacheImage((argc == 4) ? std::string(argv[3]) : ParamReader::getRequiredParam("probs_cache_image"));
+		} else if (argc >= 3) {
+			std::string model_prefix(argv[2]);
+			compileModel(model_prefix, (argc == 4) ? std::string(argv[3]) : model_prefix + ".image");
+		} else {
+			const char* model_params[] = {"parser_model", "lowercase_parser_model", "uppercase_parser_model"};
+			for (size_t i = 0; i < sizeof(model_params)/sizeof(model_params[0]); i++) {
+				std::string model_prefix = ParamReader::getParam(model_params[i]);
+				if (!model_prefix.empty())
+					compileModel(model_prefix, model_prefix + ".image");
+			}
+		}
+	}
+	catch (UnrecoverableException &e) {
+		cerr << "\n" << e.getSource() << ": " << e.getMessage() << "\n";
+		return -1;
+	}
+
+	return 0;
+}
@@ -36,16 +36,25 @@ SerifWorkQueue *SerifWorkQueue::getSingletonWorkQueue() {
 
 // Constructor -- this should only be called by getSingletonWorkQueue().
 SerifWorkQueue::SerifWorkQueue()
-: _num_tasks_processed(0), _num_tasks_failed(0),
-  _documentDriver(0), _patternSets(0), _waiting_for_task(false),
+: _num_tasks_processed(0), _num_tasks_failed(0), _num_worker_threads(1),
+  _documentDrivers(1, static_cast<DocumentDriver*>(0)), _num_drivers_loaded(0),
+  _patternSets(0), _num_busy_workers(0),
   _port_from_param_file(-1), _server_info_file_from_param_file(""), _throughput_including_load_time(-1),
-  _throughput_excluding_load_time(-1), _initialization_complete(false),
+  _throughput_excluding_load_time(-1), _worker_throughput(1, std::make_pair(-1.0f, -1.0f)), _initialization_complete(false),
   _status("Initializing Serif"),
   _memory_usage_history(MEMORY_USAGE_HISTORY_SIZE),
-  _fatalErrorCallback(0), _shutdown(false)
+  _fatalErrorCallback(0), _shutdown(false), _num_running_workers(0)
 {
-	// Start the main thread.
-	_thread = _new boost::thread(boost::bind(&SerifWorkQueue::run, this)); 
+	// Start the first worker thread.  Any additional workers are started
+	// by initialize(), once we know how many the parameter file asks for.
+	startWorkerThread(0);
+}
+
+// The caller is responsible for holding _mutex (or for calling this
+// before any other worker thread has been started).
+void SerifWorkQueue::startWorkerThread(size_t worker) {
+	++_num_running_workers;
+	_threads.create_thread(boost::bind(&SerifWorkQueue::run, this, worker));
 }
 
 void SerifWorkQueue::setAssignedPort(int assigned_port) {
@@ -58,17 +67,26 @@ void SerifWorkQueue::setShutdownCallback(SerifWorkQueue::FatalErrorCallback *fat
 }
 
 SerifWorkQueue::~SerifWorkQueue() {
-	delete _thread;
-	delete _documentDriver;
+	BOOST_FOREACH(DocumentDriver *documentDriver, _documentDrivers)
+		delete documentDriver;
 	delete _patternSets;
 }
 
 void SerifWorkQueue::initialize() {
 	boost::mutex::scoped_lock lock(_mutex);
-	if (_documentDriver != 0)
+	if (_initialization_complete)
 		throw InternalInconsistencyException("SerifWorkQueue::initialize",
 			"Already initialized.");
 	_port_from_param_file = ParamReader::getOptionalIntParamWithDefaultValue("server_port", 8000);
+	int num_worker_threads = ParamReader::getOptionalIntParamWithDefaultValue("server_num_worker_threads", 1);
+	if (num_worker_threads < 1)
+		throw UnexpectedInputException("SerifWorkQueue::initialize",
+			"The server_num_worker_threads parameter must be at least 1.");
+	// Workers share static state (the symbol table, WordNet, free lists,
+	// and the session logger), which is only safe to use from several
+	// threads at once in a thread-safe build with a preloaded WordNet.
+	if (num_worker_threads > 1)
+		DocumentDriver::checkMultithreadedSettings("server_num_worker_threads");
 	_server_info_file_from_param_file = ParamReader::getParam("server_info_file");
 	_server_docs_root_from_param_file = ParamReader::getParam("server_docs_root");
 
@@ -97,22 +115,38 @@ void SerifWorkQueue::initialize() {
 		std::string session_logfile = expt_dir + SERIF_PATH_SEP + "session-log.txt";
 		SessionLogger::setGlobalLogger(new FileSessionLogger(session_logfile.c_str(), N_CONTEXTS, CONTEXT_NAMES));
 	}
+
+	// Start any additional worker threads.  They will wait for the first
+	// worker's document driver to load before loading their own.
+	_num_worker_threads = static_cast<size_t>(num_worker_threads);
+	_documentDrivers.resize(_num_worker_threads, 0);
+	_worker_throughput.resize(_num_worker_threads, std::make_pair(-1.0f, -1.0f));
+	for (size_t worker = 1; worker < _num_worker_threads; ++worker)
+		startWorkerThread(worker);
+
 	_initialization_complete = true;
-	_initialized.notify_one();
+	_initialized.notify_all();
 }
 
-bool SerifWorkQueue::loadDocumentDriver() {
+bool SerifWorkQueue::loadDocumentDriver(size_t worker) {
 	{
 		boost::mutex::scoped_lock lock(_mutex);
-		while (!_initialization_complete)
+		while (!_initialization_complete && !_shutdown)
 			_initialized.wait(lock);
+		// Load drivers one at a time, in worker order: model loading reads
+		// the parameter file and fills shared static tables, neither of 
+		// which is safe to do from several threads at once.
+		while (_num_drivers_loaded < worker && !_shutdown)
+			_driver_loaded.wait(lock);
+		if (_shutdown)
+			return false;
 	}
 
 	DocumentDriver *documentDriver = 0;
 	try {
 	//SessionLogger::logger = new ConsoleSessionLogger(N_CONTEXTS, CONTEXT_NAMES);
 
-		std::cerr << "[WorkQueue] Loading document driver..." << std::endl;
+		std::cerr << "[WorkQueue] Loading document driver for worker " << worker << "..." << std::endl;
 		documentDriver = _new DocumentDriver();
 		if (!(ParamReader::getOptionalTrueFalseParamWithDefaultVal("use_lazy_model_loading", false))) {
 			Stage startStage = Stage(ParamReader::getParam("start_stage").c_str());
@@ -126,17 +160,18 @@ bool SerifWorkQueue::loadDocumentDriver() {
 				int progress = (cur_model*100+50)/num_models;
 				std::ostringstream status;
 				status << "Initializing Serif (" << cur_model << "/"
-					<< num_models << " stages initialized)";
-				_status = status.str();
+					<< num_models << " stages initialized";
+				if (_num_worker_threads > 1)
+					status << " for worker " << (worker+1) << "/" << _num_worker_threads;
+				status << ")";
+				{
+					boost::mutex::scoped_lock lock(_mutex);
+					_status = status.str();
+				}
 				documentDriver->loadModelsForStage(stage);
 			}
 		}
-		std::cerr << "[WorkQueue] Done loading document driver." << std::endl;
-
-		// If we have a server_info_file, write our hostname and port to it
-		if (_server_info_file_from_param_file.size() > 0) {
-			writeToServerInfoFile();
-		}
+		std::cerr << "[WorkQueue] Done loading document driver for worker " << worker << "." << std::endl;
 
 		//delete SessionLogger::logger;
 		//SessionLogger::logger = 0;
@@ -155,12 +190,32 @@ bool SerifWorkQueue::loadDocumentDriver() {
 
 	{
 		boost::mutex::scoped_lock lock(_mutex);
-		_documentDriver = documentDriver;
+		_documentDrivers[worker] = documentDriver;
 		_baseline_memory_usage.check();
 	}
 	return true;
 }
 
+// Called by each worker once it is ready to accept tasks.  This lets the
+// next worker start loading its document driver; and once the last 
+// worker is ready, advertises the server in the server_info_file.
+void SerifWorkQueue::markDocumentDriverLoaded() {
+	bool all_loaded = false;
+	{
+		boost::mutex::scoped_lock lock(_mutex);
+		++_num_drivers_loaded;
+		all_loaded = (_num_drivers_loaded == _num_worker_threads);
+		if (all_loaded)
+			updateStatus();
+		_driver_loaded.notify_all();
+	}
+
+	// If we have a server_info_file, write our hostname and port to it
+	if (all_loaded && _server_info_file_from_param_file.size() > 0) {
+		writeToServerInfoFile();
+	}
+}
+
 bool SerifWorkQueue::loadPatternSets() {
 	{
 		boost::mutex::scoped_lock lock(_mutex);
@@ -228,14 +283,7 @@ std::string SerifWorkQueue::getServerDocsRootFromParamFile() const {
 
 size_t SerifWorkQueue::numTasksRemaining() const {
 	boost::mutex::scoped_lock lock(_mutex);
-	if (_waiting_for_task)
-		return 0;
-	else {
-		if (_documentDriver == 0)
-			return _tasks.size();
-		else
-			return 1 + _tasks.size(); // include the current task
-	}
+	return _num_busy_workers + _tasks.size(); // include the current tasks
 }
 
 size_t SerifWorkQueue::numTasksProcessed() const {
@@ -248,6 +296,11 @@ size_t SerifWorkQueue::numTasksFailed() const {
 	return _num_tasks_failed;
 }
 
+size_t SerifWorkQueue::numWorkerThreads() const {
+	boost::mutex::scoped_lock lock(_mutex);
+	return _num_worker_threads;
+}
+
 float SerifWorkQueue::getThroughputIncludingLoadTime() const {
 	boost::mutex::scoped_lock lock(_mutex);
 	return _throughput_including_load_time;
@@ -273,63 +326,117 @@ SerifWorkQueue::Task_ptr SerifWorkQueue::getNextTask() {
 	boost::mutex::scoped_lock lock(_mutex);
 	if (_shutdown) return Task_ptr();
 	while (_tasks.empty()) {
-		_waiting_for_task = true;
 		_tasks_ready.wait(lock);
-		_waiting_for_task = false;
 		if (_shutdown) return Task_ptr();
 	}
 	Task_ptr task = _tasks.front();
 	_tasks.pop_front();
+	++_num_busy_workers;
+	updateStatus();
 	return task;
 }
 
-// This is what the SerifWorkQueue's thread runs:
-void SerifWorkQueue::run() {
-	if (!loadDocumentDriver() || !loadPatternSets()) {
-		return;
+// Record the outcome of a task that was returned by getNextTask().  
+// Each worker reports the throughput of its own document driver (it is
+// not safe to read another worker's timers while it is running), and 
+// the reported throughput is the sum over all workers.
+void SerifWorkQueue::finishTask(size_t worker, bool success, 
+								float throughput_including_load_time,
+								float throughput_excluding_load_time) 
+{
+	boost::mutex::scoped_lock lock(_mutex);
+	--_num_busy_workers;
+	if (success)
+		++_num_tasks_processed;
+	else
+		++_num_tasks_failed;
+	_worker_throughput[worker] = std::make_pair(throughput_including_load_time, throughput_excluding_load_time);
+	_throughput_including_load_time = -1;
+	_throughput_excluding_load_time = -1;
+	typedef std::pair<float, float> FloatPair;
+	BOOST_FOREACH(const FloatPair &throughput, _worker_throughput) {
+		// Throughput is -1 (undefined) for workers that haven't processed anything yet.
+		if (throughput.first >= 0)
+			_throughput_including_load_time = std::max(_throughput_including_load_time, 0.0f) + throughput.first;
+		if (throughput.second >= 0)
+			_throughput_excluding_load_time = std::max(_throughput_excluding_load_time, 0.0f) + throughput.second;
 	}
+	recordMemoryUsage();
+	updateStatus();
+}
 
-	while (true) {
-		std::cerr << "[WorkQueue] Waiting for a task." << std::endl;
+// The caller is responsible for holding _mutex.
+void SerifWorkQueue::updateStatus() {
+	if (_num_busy_workers == 0) {
 		_status = "Waiting for a task.";
-		Task_ptr task = getNextTask();
-		if (!task) break; // Shutdown was requested.
-		std::cerr << "[WorkQueue] Performing a task..." << std::endl;
+	} else if (_num_worker_threads == 1) {
 		_status = "Performing a task";
-		if (PatternSetTask_ptr psTask = boost::dynamic_pointer_cast<PatternSetTask>(task)) {
-			if (psTask->run(_patternSets))
-				++_num_tasks_processed;
-			else
-				++_num_tasks_failed;
-		} else {
-			if (task->run(_documentDriver))
-				++_num_tasks_processed;
-			else
-				++_num_tasks_failed;
+	} else {
+		std::ostringstream status;
+		status << "Performing " << _num_busy_workers << " task(s) on " 
+			<< _num_worker_threads << " worker threads";
+		_status = status.str();
+	}
+}
+
+// This is what each of the SerifWorkQueue's worker threads runs:
+void SerifWorkQueue::run(size_t worker) {
+	// The first worker is also responsible for loading the pattern sets,
+	// which are shared (read-only) by all workers.
+	if (loadDocumentDriver(worker) && (worker != 0 || loadPatternSets())) {
+		markDocumentDriverLoaded();
+		DocumentDriver *documentDriver = 0;
+		Symbol::HashMap<PatternSet_ptr> *patternSets = 0;
+		{
+			boost::mutex::scoped_lock lock(_mutex);
+			documentDriver = _documentDrivers[worker];
+			patternSets = _patternSets;
+		}
+
+		while (true) {
+			std::cerr << "[WorkQueue] Worker " << worker << " waiting for a task." << std::endl;
+			Task_ptr task = getNextTask();
+			if (!task) break; // Shutdown was requested.
+			std::cerr << "[WorkQueue] Worker " << worker << " performing a task..." << std::endl;
+			bool success = false;
+			if (PatternSetTask_ptr psTask = boost::dynamic_pointer_cast<PatternSetTask>(task)) {
+				success = psTask->run(patternSets);
+			} else {
+				success = task->run(documentDriver);
+			}
+			finishTask(worker, success, documentDriver->getThroughput(true), 
+				documentDriver->getThroughput(false));
 		}
-		_throughput_including_load_time = _documentDriver->getThroughput(true);
-		_throughput_excluding_load_time = _documentDriver->getThroughput(false);
-		recordMemoryUsage();
 	}
+
+	boost::mutex::scoped_lock lock(_mutex);
+	--_num_running_workers;
     // Make sure no condition variables are blocking threads -- otherwise, 
     // destroying them will have undefined effects.
-	_tasks_ready.notify_one();
-    _initialized.notify_one();
+	_tasks_ready.notify_all();
+	_initialized.notify_all();
+	_driver_loaded.notify_all();
     // Record the fact that we've shut down (in case the user wants to call
     // shutdown(true)).
-	_shutdown_complete.notify_one();
+	if (_num_running_workers == 0)
+		_shutdown_complete.notify_all();
 }
 
-// This should *not* be called from the queue's thread; only from 
+// This should *not* be called from a worker thread; only from 
 // the server's thread.
 void SerifWorkQueue::shutdown(bool wait) {
     boost::mutex::scoped_lock lock(_mutex);
     _shutdown = true;
-	_tasks_ready.notify_one();
-    if (wait)
-        _shutdown_complete.wait(lock);
+	_tasks_ready.notify_all();
+	_initialized.notify_all();
+	_driver_loaded.notify_all();
+    if (wait) {
+		while (_num_running_workers > 0)
+	        _shutdown_complete.wait(lock);
+	}
 }
 
+// The caller is responsible for holding _mutex.
 void SerifWorkQueue::recordMemoryUsage() {
 	MemoryUsageRecord mem_record;
 	mem_record.check();
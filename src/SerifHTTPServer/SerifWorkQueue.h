@@ -12,6 +12,7 @@
 #include <boost/asio.hpp>
 #include <list>
 #include <deque>
+#include <vector>
 
 #include "Generic/patterns/PatternSet.h"
 
@@ -26,10 +27,22 @@ typedef boost::shared_ptr<IncomingHTTPConnection> IncomingHTTPConnection_ptr;
 
 /** The SerifWorkQueue is a singleton class used to manage tasks 
   * that require SERIF.  When the SerifWorkQueue is created, it 
-  * starts a new thread.  All tasks are executed in this thread.  
-  * Since SERIF is not thread-safe, the work queue executes a single
-  * task at a time, waiting for each task to complete before 
-  * beginning the next task.  
+  * starts a new worker thread.  All tasks are executed in worker 
+  * threads.  By default, there is a single worker thread, so the 
+  * work queue executes a single task at a time, waiting for each 
+  * task to complete before beginning the next task.
+  *
+  * If the "server_num_worker_threads" parameter is greater than one,
+  * then initialize() starts additional worker threads.  Each worker 
+  * owns its own DocumentDriver (and therefore its own SessionProgram
+  * and per-document state), while models that are loaded into shared
+  * static tables are loaded once (by the first worker) and then only
+  * read.  Pattern sets are loaded once and shared by all workers.
+  * Running with more than one worker requires a build with 
+  * SYMBOL_THREADSAFE enabled (which also gives each thread its own
+  * ParseNode free list, and turns off the discTagger feature pools), and
+  * requires preload_wordnet if WordNet is used; see
+  * DocumentDriver::checkMultithreadedSettings().
   *
   * If you use SerifWorkQueue, then you should *never* run SERIF 
   * from the main thread, since the work queue might be running
@@ -93,8 +106,8 @@ public:
 	typedef boost::shared_ptr<PatternSetTask> PatternSetTask_ptr;
 
 	/** Register a new task, and return immediately.  The task will be 
-	  * performed by the SerifWorkQueue's thread once all other tasks
-	  * have been completed. */
+	  * performed by the first available worker thread once all tasks
+	  * that were added before it have been started. */
 	void addTask(boost::shared_ptr<Task> task);
 
 	/** Return the value of the "server_port" parameter from the parameter
@@ -111,6 +124,7 @@ public:
 	size_t numTasksRemaining() const;
 	size_t numTasksProcessed() const;
 	size_t numTasksFailed() const;
+	size_t numWorkerThreads() const;
 	float getThroughputIncludingLoadTime() const;
 	float getThroughputExcludingLoadTime() const;
 
@@ -128,7 +142,7 @@ public:
 	void setAssignedPort(int assigned_port);
 
 	/** Set a callback that should be called if we encounter a fatal 
-	  * error.  This callback will be called in the serif thread, so
+	  * error.  This callback will be called in a worker thread, so
 	  * if it needs to communicate w/ the server thread, then it should
 	  * do so using asyncio. */
 	void setShutdownCallback(FatalErrorCallback *fatalErrorCallback);
@@ -137,8 +151,13 @@ public:
 
 private: // ============ Member Variables ============
 
-	// The thread used by the work queue to perform tasks.
-	boost::thread *_thread;
+	// The worker threads used by the work queue to perform tasks.  The
+	// first worker is started by the constructor; any others are started
+	// by initialize().
+	boost::thread_group _threads;
+
+	// The number of worker threads requested by the parameter file.
+	size_t _num_worker_threads;
 
 	// A mutex used to guard access to all member variables.  
 	mutable boost::mutex _mutex;
@@ -156,10 +175,15 @@ private: // ============ Member Variables ============
 	bool _initialization_complete;
 	boost::condition_variable _initialized;
 
-	// The document driver used to run SERIF.  We use a single document
-	// driver for all process document tasks, to avoid having to reload 
-	// models.
-	DocumentDriver *_documentDriver;
+	// The document drivers used to run SERIF, indexed by worker number.
+	// Each worker uses a single document driver for all of its tasks, to
+	// avoid having to reload models.  Drivers are loaded one at a time,
+	// in worker order (_num_drivers_loaded counts the workers that are
+	// ready), so any models that are shared through static tables are 
+	// only loaded once, by the first worker.
+	std::vector<DocumentDriver*> _documentDrivers;
+	size_t _num_drivers_loaded;
+	boost::condition_variable _driver_loaded;
 
 	// The pattern sets used for pattern matching during pattern match
 	// tasks.
@@ -172,10 +196,12 @@ private: // ============ Member Variables ============
 	float _throughput_including_load_time;
 	float _throughput_excluding_load_time;
 
-	// A boolean that can be used to check whether the queue is currently
-	// waiting for a new task.  If false, then it's currently working on
-	// a task.
-	bool _waiting_for_task;
+	// The most recent (including, excluding load time) throughput reported
+	// by each worker.  _throughput_* hold the sum over all workers.
+	std::vector<std::pair<float, float> > _worker_throughput;
+
+	// The number of workers that are currently performing a task.
+	size_t _num_busy_workers;
 
 	// Values read from the parameter file.  We record a copy of these
 	// values when we read the parameter file, because it may not be
@@ -193,8 +219,9 @@ private: // ============ Member Variables ============
 	FatalErrorCallback *_fatalErrorCallback;
 
 	// Set this to true when you want to shut down.  (Shut down will
-	// occur after the current task completes)
+	// occur after the current tasks complete)
 	bool _shutdown;
+	size_t _num_running_workers;
 	boost::condition_variable _shutdown_complete;
 
 	// If ENABLE_LEAK_DETECTION is defined, then we keep track of how much
@@ -214,10 +241,15 @@ private: // ============ Member Variables ============
 
 private:  // ============ Helper Methods ============
 
-	bool loadDocumentDriver(); // return false for failure.
+	bool loadDocumentDriver(size_t worker); // return false for failure.
 	bool loadPatternSets(); // return false for failure.
-	void run();
+	void run(size_t worker);
+	void markDocumentDriverLoaded();
 	Task_ptr getNextTask();
+	void finishTask(size_t worker, bool success, float throughput_including_load_time,
+		float throughput_excluding_load_time);
+	void updateStatus();
+	void startWorkerThread(size_t worker);
 
 	// The constructor and destructor are both private, because this is
 	// a singleton class -- the only instance should be created by the